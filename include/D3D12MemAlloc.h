@@ -52,7 +52,10 @@ Documentation of all members: D3D12MemAlloc.h
 - \subpage defragmentation
 - \subpage statistics
 - \subpage resource_aliasing
+- \subpage buffer_suballocation
 - \subpage linear_algorithm
+- \subpage buddy_algorithm
+- \subpage slab_algorithm
 - \subpage virtual_allocator
 - \subpage configuration
   - [Custom CPU memory allocator](@ref custom_memory_allocator)
@@ -204,6 +207,8 @@ public:
     ULONG STDMETHODCALLTYPE Release() override;
 protected:
     virtual void ReleaseThis() { delete this; }
+    // Like Release(), but doesn't call ReleaseThis() - returns new reference count and leaves destruction to the caller.
+    uint32_t ReleaseRef() { return --m_RefCount; }
 private:
     D3D12MA_ATOMIC_UINT32 m_RefCount = {1};
 };
@@ -223,6 +228,8 @@ class BlockVector;
 class CommittedAllocationList;
 class JsonWriter;
 class VirtualBlockPimpl;
+class SnapshotPimpl;
+class SharedBuffer;
 /// \endcond
 
 class Pool;
@@ -254,6 +261,24 @@ struct ALLOCATION_CALLBACKS
     void* pPrivateData;
 };
 
+/// Encoding of the JSON string written by Allocator::WriteStatsString() and VirtualBlock::WriteStatsString().
+enum STATS_STRING_ENCODING
+{
+    /// UTF-16 little-endian, same as returned by Allocator::BuildStatsString().
+    STATS_STRING_ENCODING_UTF16 = 0,
+    /// UTF-8, about half the size for the characters used in the statistics.
+    STATS_STRING_ENCODING_UTF8 = 1,
+};
+
+/**
+\brief Pointer to custom callback function that receives consecutive parts of a statistics string.
+
+`pData` points to `ByteCount` bytes of the string in the requested encoding, valid only during the call.
+The parts are not null-terminated and they may end in the middle of a JSON value.
+The same callback receives parts of the binary dump written by Allocator::WriteStatsBinary().
+*/
+using WRITE_STATS_STRING_FUNC_PTR = void (*)(const void* pData, size_t ByteCount, void* pPrivateData);
+
 
 /// \brief Bit flags to be used with ALLOCATION_DESC::Flags.
 enum ALLOCATION_FLAGS
@@ -497,12 +522,97 @@ struct Budget
     UINT64 BudgetBytes;
 };
 
+/** \brief %Statistics of the cache of resource allocation info.
+
+See function D3D12MA::Allocator::GetResourceAllocationInfoCacheStatistics()
+and flag D3D12MA::ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO.
+*/
+struct ResourceAllocationInfoCacheStatistics
+{
+    /// Number of queries answered from the cache, without calling the driver.
+    UINT64 HitCount;
+    /// Number of queries not found in the cache, which called the driver.
+    UINT64 MissCount;
+    /// Number of resource descriptions currently stored in the cache.
+    UINT EntryCount;
+};
+
+/// Operation measured with D3D12MA::ALLOCATOR_FLAG_PERFORMANCE_COUNTERS, see PerformanceCounters::Operations.
+enum PERFORMANCE_COUNTER_OPERATION
+{
+    /// Allocator::CreateResource(), Allocator::CreateResource2(), Allocator::CreateResource3() as a whole.
+    PERFORMANCE_COUNTER_OPERATION_CREATE_RESOURCE,
+    /// Allocator::AllocateMemory() as a whole.
+    PERFORMANCE_COUNTER_OPERATION_ALLOCATE_MEMORY,
+    /// Allocation::Release() destroying the allocation.
+    PERFORMANCE_COUNTER_OPERATION_FREE,
+    /// Calls to `ID3D12Device::CreateHeap*`.
+    PERFORMANCE_COUNTER_OPERATION_CREATE_HEAP,
+    /// Calls to `ID3D12Device::CreatePlacedResource*`.
+    PERFORMANCE_COUNTER_OPERATION_CREATE_PLACED_RESOURCE,
+    /// Calls to `ID3D12Device::CreateCommittedResource*`.
+    PERFORMANCE_COUNTER_OPERATION_CREATE_COMMITTED_RESOURCE,
+    /// Waiting for the lock of a memory pool to allocate or free memory in its blocks.
+    PERFORMANCE_COUNTER_OPERATION_BLOCK_VECTOR_LOCK_WAIT,
+
+    PERFORMANCE_COUNTER_OPERATION_COUNT
+};
+
+/// Where a new allocation was made and why, see PerformanceCounters::PlacementDecisions.
+enum PLACEMENT_DECISION
+{
+    /// Placed in a memory block of a pool.
+    PLACEMENT_DECISION_PLACED,
+    /** \brief Committed without trying a pool, e.g. because of #ALLOCATION_FLAG_COMMITTED,
+    a size bigger than the block size, or an MSAA texture with heaps that don't allow them.
+    */
+    PLACEMENT_DECISION_COMMITTED_REQUIRED,
+    /// Committed before trying a pool, because the library found it better, e.g. for a size bigger than half of the block size.
+    PLACEMENT_DECISION_COMMITTED_PREFERRED,
+    /// Committed after failing to allocate from a pool.
+    PLACEMENT_DECISION_COMMITTED_FALLBACK,
+
+    PLACEMENT_DECISION_COUNT
+};
+
+/// Number of buckets in LatencyHistogram.
+static const UINT LATENCY_HISTOGRAM_BUCKET_COUNT = 32;
+
+/// Durations of an operation, in buckets of exponentially growing size.
+struct LatencyHistogram
+{
+    /// Number of measured operations.
+    UINT64 Count;
+    /// Sum of all measured durations, in nanoseconds.
+    UINT64 TotalNanoseconds;
+    /// Longest measured duration, in nanoseconds.
+    UINT64 MaxNanoseconds;
+    /** \brief Number of operations that took from `2^i` (or 0 for `i = 0`) up to `2^(i+1)` nanoseconds.
+
+    The last bucket also counts all the longer ones.
+    */
+    UINT64 Buckets[LATENCY_HISTOGRAM_BUCKET_COUNT];
+};
+
+/** \brief Counters collected with D3D12MA::ALLOCATOR_FLAG_PERFORMANCE_COUNTERS.
+
+See function D3D12MA::Allocator::GetPerformanceCounters().
+Second index of each array is the type of heap, the same as in TotalStatistics::HeapType.
+*/
+struct PerformanceCounters
+{
+    /// Durations of operations, indexed by #PERFORMANCE_COUNTER_OPERATION.
+    LatencyHistogram Operations[PERFORMANCE_COUNTER_OPERATION_COUNT][5];
+    /// Numbers of allocations created by Allocator::CreateResource*() and Allocator::AllocateMemory(), indexed by #PLACEMENT_DECISION.
+    UINT64 PlacementDecisions[PLACEMENT_DECISION_COUNT][5];
+};
+
 
 /// \brief Represents single memory allocation done inside VirtualBlock.
 struct D3D12MA_API VirtualAllocation
 {
     /// \brief Unique idenitfier of current allocation. 0 means null/invalid.
-    AllocHandle AllocHandle;
+    D3D12MA::AllocHandle AllocHandle;
 };
 
 /** \brief Represents single memory allocation.
@@ -548,9 +658,26 @@ public:
     /** \brief Returns D3D12 resource associated with this object.
 
     Calling this method doesn't increment resource's reference counter.
+
+    For allocations created with D3D12MA::Allocator::CreateBufferSubAllocation, this is a buffer shared
+    with other allocations, and the range of this allocation starts at GetBufferOffset().
     */
     ID3D12Resource* GetResource() const { return m_Resource; }
 
+    /** \brief Returns offset in bytes of this allocation from the beginning of the buffer returned by GetResource().
+
+    Returns 0 unless the allocation was created with D3D12MA::Allocator::CreateBufferSubAllocation.
+    */
+    UINT64 GetBufferOffset() const;
+
+    /** \brief Returns GPU virtual address of the beginning of this allocation in its buffer.
+
+    It is `GetResource()->GetGPUVirtualAddress() + GetBufferOffset()`, ready to be used e.g. in
+    `D3D12_CONSTANT_BUFFER_VIEW_DESC::BufferLocation` or `D3D12_VERTEX_BUFFER_VIEW::BufferLocation`.
+    Returns 0 if there is no resource. For textures, `ID3D12Resource::GetGPUVirtualAddress()` returns 0 as well.
+    */
+    D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const;
+
     /** \brief Releases the resource currently pointed by the allocation (if not null), sets it to new one, incrementing its reference counter (if not null).
     
     \warning
@@ -597,8 +724,11 @@ private:
     friend class BlockVector;
     friend class CommittedAllocationList;
     friend class JsonWriter;
+    friend class BinaryStatsWriter;
+    friend class SnapshotPimpl;
     friend class BlockMetadata_Linear;
     friend class DefragmentationContextPimpl;
+    friend class BufferSubAllocator;
     friend struct CommittedAllocationListItemTraits;
     template<typename T> friend void D3D12MA_DELETE(const ALLOCATION_CALLBACKS&, T*);
     template<typename T> friend class PoolAllocator;
@@ -608,6 +738,7 @@ private:
         TYPE_COMMITTED,
         TYPE_PLACED,
         TYPE_HEAP,
+        TYPE_BUFFER_RANGE,
         TYPE_COUNT
     };
 
@@ -641,29 +772,41 @@ private:
             Allocation* next;
             ID3D12Heap* heap;
         } m_Heap;
+
+        struct
+        {
+            AllocHandle allocHandle;
+            SharedBuffer* buffer;
+        } m_BufferRange;
     };
 
     struct PackedData
     {
     public:
         PackedData() :
-            m_Type(0), m_ResourceDimension(0), m_ResourceFlags(0), m_TextureLayout(0) { }
+            m_Type(0), m_Immovable(0), m_ResourceDimension(0), m_ResourceFlags(0), m_TextureLayout(0), m_CreationEpoch(0) { }
 
         Type GetType() const { return (Type)m_Type; }
         D3D12_RESOURCE_DIMENSION GetResourceDimension() const { return (D3D12_RESOURCE_DIMENSION)m_ResourceDimension; }
         D3D12_RESOURCE_FLAGS GetResourceFlags() const { return (D3D12_RESOURCE_FLAGS)m_ResourceFlags; }
         D3D12_TEXTURE_LAYOUT GetTextureLayout() const { return (D3D12_TEXTURE_LAYOUT)m_TextureLayout; }
+        UINT GetCreationEpoch() const { return m_CreationEpoch; }
+        bool IsImmovable() const { return m_Immovable != 0; }
 
         void SetType(Type type);
         void SetResourceDimension(D3D12_RESOURCE_DIMENSION resourceDimension);
         void SetResourceFlags(D3D12_RESOURCE_FLAGS resourceFlags);
         void SetTextureLayout(D3D12_TEXTURE_LAYOUT textureLayout);
+        void SetCreationEpoch(UINT creationEpoch) { m_CreationEpoch = creationEpoch & 0xFFFF; }
+        void SetImmovable() { m_Immovable = 1; }
 
     private:
-        UINT m_Type : 2;               // enum Type
+        UINT m_Type : 3;               // enum Type
+        UINT m_Immovable : 1;          // never moved by defragmentation
         UINT m_ResourceDimension : 3;  // enum D3D12_RESOURCE_DIMENSION
         UINT m_ResourceFlags : 24;     // flags D3D12_RESOURCE_FLAGS
         UINT m_TextureLayout : 9;      // enum D3D12_TEXTURE_LAYOUT
+        UINT m_CreationEpoch : 16;     // number of snapshots taken before creation, wrapping
     } m_PackedData;
 
     Allocation(AllocatorPimpl* allocator, UINT64 size, UINT64 alignment);
@@ -673,6 +816,7 @@ private:
     void InitCommitted(CommittedAllocationList* list);
     void InitPlaced(AllocHandle allocHandle, NormalBlock* block);
     void InitHeap(CommittedAllocationList* list, ID3D12Heap* heap);
+    void InitBufferRange(AllocHandle allocHandle, SharedBuffer* buffer);
     void SwapBlockAllocation(Allocation* allocation);
     // If the Allocation represents committed resource with implicit heap, returns UINT64_MAX.
     AllocHandle GetAllocHandle() const;
@@ -901,8 +1045,33 @@ enum POOL_FLAGS
     */
     POOL_FLAG_DONT_USE_TIGHT_ALIGNMENT = 0x8,
 
+    /** Enables alternative, buddy allocation algorithm in this pool.
+
+    Every allocation takes a whole node of power-of-2 size, aligned to its size,
+    which is found and freed in time proportional to the logarithm of the block size,
+    and freed nodes are merged back with their neighbors immediately. It has less
+    metadata than the default algorithm, but wastes the space between the size of
+    an allocation and the next power of 2, so it is best suited for allocations
+    of power-of-2 sizes.
+
+    Only the largest power of 2 not greater than the size of each block is used.
+    For details, see documentation chapter \ref buddy_algorithm.
+    */
+    POOL_FLAG_ALGORITHM_BUDDY = 0x10,
+
+    /** Enables alternative, slab allocation algorithm in this pool.
+
+    Every block is divided into slots of equal size given by D3D12MA::POOL_DESC::SlotSize,
+    and every allocation takes one slot, found and freed in constant time using bitmaps
+    of free slots. It has the least metadata of all the algorithms, but it is only suitable
+    for allocations of the same or similar size, not larger than the slot.
+
+    For details, see documentation chapter \ref slab_algorithm.
+    */
+    POOL_FLAG_ALGORITHM_SLAB = 0x20,
+
     // Bit mask to extract only `ALGORITHM` bits from entire set of flags.
-    POOL_FLAG_ALGORITHM_MASK = POOL_FLAG_ALGORITHM_LINEAR
+    POOL_FLAG_ALGORITHM_MASK = POOL_FLAG_ALGORITHM_LINEAR | POOL_FLAG_ALGORITHM_BUDDY | POOL_FLAG_ALGORITHM_SLAB
 };
 
 /// \brief Parameters of created D3D12MA::Pool object. To be used with D3D12MA::Allocator::CreatePool.
@@ -985,6 +1154,13 @@ struct POOL_DESC
     `ID3D12Device1::SetResidencyPriority`, passing `allocation->GetResource()`.
     */
     D3D12_RESIDENCY_PRIORITY ResidencyPriority;
+    /** \brief Size of a single slot of pools created with #POOL_FLAG_ALGORITHM_SLAB, in bytes.
+
+    Required, must be greater than 0 with #POOL_FLAG_ALGORITHM_SLAB and not greater than
+    D3D12MA::POOL_DESC::BlockSize, or the default block size of 64 MiB if `BlockSize` is 0.
+    Ignored with other algorithms.
+    */
+    UINT64 SlotSize;
 };
 
 /** \brief Custom memory pool
@@ -1033,6 +1209,12 @@ public:
     */
     LPCWSTR GetName() const;
 
+    /** \brief Returns identifier of the pool, unique among all pools created from the same allocator.
+
+    Used as SNAPSHOT_CHANGE::PoolId.
+    */
+    UINT GetId() const;
+
     /** \brief Begins defragmentation process of the current pool.
 
     \param pDesc Structure filled with parameters of defragmentation.
@@ -1133,6 +1315,67 @@ enum ALLOCATOR_FLAGS
     Support can be checked by D3D12MA::Allocator::IsTightAlignmentSupported() regardless of using this flag.
     */
     ALLOCATOR_FLAG_DONT_USE_TIGHT_ALIGNMENT = 0x20,
+    /** \brief Enables caching of results of `ID3D12Device::GetResourceAllocationInfo`.
+
+    Creating a texture requires querying its size and alignment from the driver, sometimes twice,
+    when small alignment is tried first. With this flag, the results are remembered in a bounded cache
+    keyed by the resource description and castable formats, so creating another resource with the same
+    description doesn't call the driver again. It is beneficial when a program creates resources
+    of a limited set of shapes over and over, e.g. in texture streaming.
+
+    Maximum number of cached descriptions is configured by macro `D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE_CAPACITY`.
+    Effectiveness of the cache can be checked using D3D12MA::Allocator::GetResourceAllocationInfoCacheStatistics().
+    */
+    ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO = 0x40,
+    /** \brief Stops the allocator from querying memory budget from DXGI during allocation and deallocation.
+
+    By default, the current usage and budget are fetched using `IDXGIAdapter3::QueryVideoMemoryInfo`
+    every 30 allocations or deallocations, on the thread that makes them, as a part of the budget check.
+    With this flag, the budget is refreshed only by Allocator::SetCurrentFrameIndex(), Allocator::UpdateBudget()
+    and the background thread enabled by #ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE, so the driver call
+    never lands on the allocation path. Between the refreshes, the usage is estimated by adding
+    the size of memory blocks allocated since the last one.
+    */
+    ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE = 0x80,
+    /** \brief Creates a thread owned by the allocator that periodically refreshes the memory budget.
+
+    Implies #ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE. The period is specified by ALLOCATOR_DESC::BudgetUpdatePeriodMilliseconds.
+    On Windows, the thread is also woken up by the budget change notification event registered using
+    `IDXGIAdapter3::RegisterVideoMemoryBudgetChangeNotificationEvent`, so it catches changes of the budget
+    made by the operating system immediately. The thread is stopped when the allocator is destroyed.
+    */
+    ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE = 0x100,
+    /** \brief Maintains statistics incrementally, so they can be read without locking memory pools.
+
+    With this flag, Allocator::CalculateStatistics(), Pool::GetStatistics(), Pool::CalculateStatistics()
+    and Allocator::BuildStatsString() with `DetailedMap = FALSE` read a consistent snapshot of the statistics
+    updated on every allocation and deallocation, instead of traversing all memory blocks under a lock
+    that would block other threads allocating at the same time. It is useful when statistics are
+    collected often, e.g. by a telemetry thread, at the cost of slightly slower allocation and deallocation.
+
+    Sizes are tracked in power-of-2 buckets, so `AllocationSizeMin`, `AllocationSizeMax`, `UnusedRangeSizeMin`
+    and `UnusedRangeSizeMax` of DetailedStatistics are rounded down to a power of 2.
+    Custom pools created with #POOL_FLAG_ALGORITHM_LINEAR are still traversed under their lock.
+    */
+    ALLOCATOR_FLAG_LOCK_FREE_STATISTICS = 0x200,
+    /** \brief Records allocation events in a ring buffer, to be read using Allocator::GetTraceEvents().
+
+    Every allocation, deallocation, creation and destruction of a memory block, move made by defragmentation
+    and refresh of the budget is recorded as TRACE_EVENT without taking any lock. Only the most recent
+    ALLOCATOR_DESC::TraceEventCapacity events are kept. An event is dropped if the thread recording it
+    was overtaken by the whole ring meanwhile; the number of such events is included in the JSON dump
+    as `Trace.DroppedEventCount`. For more information, see [Event trace](@ref statistics_trace).
+    */
+    ALLOCATOR_FLAG_TRACE_EVENTS = 0x400,
+    /** \brief Measures time spent in the library and in the driver, to be read using Allocator::GetPerformanceCounters().
+
+    Durations of creating resources, allocating and freeing memory, calls to `ID3D12Device` creating heaps and resources,
+    and waiting for the lock of a memory pool are collected in histograms per heap type, together with counts
+    of decisions between placed and committed allocations. They are also included in the JSON dump.
+    Every measurement reads the system clock twice, so use it for profiling only.
+    For more information, see [Performance counters](@ref statistics_performance_counters).
+    */
+    ALLOCATOR_FLAG_PERFORMANCE_COUNTERS = 0x800,
 };
 
 /// \brief Parameters of created Allocator object. To be used with CreateAllocator().
@@ -1167,6 +1410,182 @@ struct ALLOCATOR_DESC
     Allocator is doing `AddRef`/`Release` on this object.
     */
     IDXGIAdapter* pAdapter;
+
+    /** \brief Maximum time between refreshes of the memory budget made by the background thread.
+
+    Used only with #ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE. Set to 0 to use default, which is currently 100 ms.
+    */
+    UINT BudgetUpdatePeriodMilliseconds;
+
+    /** \brief Number of the most recent events kept by #ALLOCATOR_FLAG_TRACE_EVENTS.
+
+    Used only with #ALLOCATOR_FLAG_TRACE_EVENTS. Rounded up to a power of 2. Every event takes 64 bytes.
+    Set to 0 to use default, which is currently 65536.
+    */
+    UINT TraceEventCapacity;
+};
+
+/// Type of a change between two snapshots, see SNAPSHOT_CHANGE::Type.
+enum SNAPSHOT_CHANGE_TYPE
+{
+    /// Memory block was created.
+    SNAPSHOT_CHANGE_TYPE_BLOCK_CREATED,
+    /// Memory block was freed.
+    SNAPSHOT_CHANGE_TYPE_BLOCK_FREED,
+    /// Allocation was created.
+    SNAPSHOT_CHANGE_TYPE_ALLOCATION_CREATED,
+    /// Allocation was freed.
+    SNAPSHOT_CHANGE_TYPE_ALLOCATION_FREED,
+    /// Allocation was moved to another place in the same pool, e.g. by defragmentation.
+    SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED,
+};
+
+/// Describes a single change between two snapshots, passed to SNAPSHOT_CHANGE_FUNC_PTR.
+struct SNAPSHOT_CHANGE
+{
+    /// Type of the change.
+    SNAPSHOT_CHANGE_TYPE Type;
+    /// Type of the heap of the memory block or allocation.
+    D3D12_HEAP_TYPE HeapType;
+    /** \brief Identifier of the memory pool.
+
+    Equal to Pool::GetId() for custom pools. Each default pool has its own identifier, different from all custom pools,
+    but committed allocations made in default pools have 0.
+    */
+    UINT PoolId;
+    /// Identifier of the memory block within the pool, or `UINT_MAX` for committed allocations.
+    UINT BlockId;
+    /// Offset of the allocation in its memory block, 0 for memory blocks and committed allocations.
+    UINT64 Offset;
+    /// Size of the memory block or allocation, in bytes.
+    UINT64 Size;
+    /** \brief Identifier of the allocation, 0 for memory blocks.
+
+    Its lowest 48 bits are equal to the address of the Allocation object, while the highest bits
+    distinguish allocation objects created at the same address at different times.
+    */
+    UINT64 AllocationId;
+    /// Only for #SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED: identifier of the memory block the allocation was moved from.
+    UINT PreviousBlockId;
+    /// Only for #SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED: offset the allocation was moved from.
+    UINT64 PreviousOffset;
+};
+
+/// Pointer to custom callback function called by Snapshot::EnumerateChanges() for each change.
+using SNAPSHOT_CHANGE_FUNC_PTR = void (*)(const SNAPSHOT_CHANGE* pChange, void* pPrivateData);
+
+/**
+\brief Compact record of all memory blocks and allocations of an allocator at some moment.
+
+Create it using Allocator::CreateSnapshot(), destroy using `Release()`.
+Two snapshots taken at different moments can be compared to find memory blocks and allocations
+created, freed or moved in between, e.g. when investigating a spike of memory usage
+or to send only changes of the memory state to telemetry.
+
+A snapshot doesn't reference the allocator, so it can be kept after the allocator is destroyed.
+It takes about 40 bytes per allocation and doesn't contain names of allocations.
+*/
+class D3D12MA_API Snapshot : public IUnknownImpl
+{
+public:
+    /// Returns number of memory blocks recorded in the snapshot.
+    UINT64 GetBlockCount() const;
+    /// Returns number of allocations recorded in the snapshot, including committed ones.
+    UINT64 GetAllocationCount() const;
+
+    /** \brief Calls a callback for every change between the previous snapshot and this one.
+
+    \param pPrevious Snapshot of the same allocator taken earlier. Can be null - then all memory blocks
+        and allocations of this snapshot are reported as created.
+    \param pChangeFunc Function called for every change. Memory blocks are reported first, then allocations.
+    \param pPrivateData Custom data passed to `pChangeFunc`.
+    */
+    void EnumerateChanges(
+        const Snapshot* pPrevious,
+        SNAPSHOT_CHANGE_FUNC_PTR pChangeFunc,
+        void* pPrivateData) const;
+
+    /** \brief Writes the same changes as EnumerateChanges() in a compact binary format, passing it to a callback in parts.
+
+    The format is described in "tools/GpuMemDumpBin2Json/README.md" and the script from that directory can convert it to JSON.
+    */
+    void WriteChanges(
+        const Snapshot* pPrevious,
+        WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+        void* pPrivateData) const;
+
+protected:
+    void ReleaseThis() override;
+
+private:
+    friend class Allocator;
+    template<typename T> friend void D3D12MA_DELETE(const ALLOCATION_CALLBACKS&, T*);
+
+    SnapshotPimpl* m_Pimpl;
+
+    Snapshot(const ALLOCATION_CALLBACKS& allocationCallbacks);
+    ~Snapshot();
+
+    D3D12MA_CLASS_NO_COPY(Snapshot)
+};
+
+/// Type of an event recorded with #ALLOCATOR_FLAG_TRACE_EVENTS, see TRACE_EVENT::Type.
+enum TRACE_EVENT_TYPE
+{
+    /// Allocation was created.
+    TRACE_EVENT_TYPE_ALLOCATE,
+    /// Allocation was freed.
+    TRACE_EVENT_TYPE_FREE,
+    /// Memory block was created.
+    TRACE_EVENT_TYPE_CREATE_BLOCK,
+    /// Memory block was destroyed.
+    TRACE_EVENT_TYPE_DESTROY_BLOCK,
+    /** \brief Defragmentation moved an allocation.
+
+    The destination was reserved before by a temporary allocation, TRACE_EVENT::TemporaryAllocationId.
+    Both swap their places, then the temporary allocation is freed from the previous place of the moved one.
+    */
+    TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE,
+    /// Memory budget was fetched from DXGI.
+    TRACE_EVENT_TYPE_BUDGET_UPDATE,
+};
+
+/// Single event returned by Allocator::GetTraceEvents().
+struct TRACE_EVENT
+{
+    /// Type of the event.
+    TRACE_EVENT_TYPE Type;
+    /** \brief Number of the event, incremented for every event recorded by the allocator.
+
+    A gap between numbers of consecutive events means events overwritten before they were read.
+    */
+    UINT64 SequenceNumber;
+    /// Time of the event in nanoseconds, measured from creation of the allocator.
+    UINT64 Timestamp;
+    /// Small number identifying the thread that caused the event, unique within the process.
+    UINT ThreadId;
+    /// Type of the heap of the allocation or memory block.
+    D3D12_HEAP_TYPE HeapType;
+    /// Identifier of the memory pool, like SNAPSHOT_CHANGE::PoolId.
+    UINT PoolId;
+    /// Identifier of the memory block, `UINT_MAX` for committed allocations.
+    UINT BlockId;
+    /// Identifier of the allocation, like SNAPSHOT_CHANGE::AllocationId. 0 for events of memory blocks.
+    UINT64 AllocationId;
+    /// Offset of the allocation in its memory block, 0 for memory blocks and committed allocations.
+    UINT64 Offset;
+    /// Size of the allocation or memory block, in bytes.
+    UINT64 Size;
+    /// Only for #TRACE_EVENT_TYPE_ALLOCATE: alignment requested for the allocation.
+    UINT64 Alignment;
+    /// Only for #TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE: identifier of the temporary allocation that reserved the destination.
+    UINT64 TemporaryAllocationId;
+    /// Only for #TRACE_EVENT_TYPE_BUDGET_UPDATE: memory segment group of the budget, as `DXGI_MEMORY_SEGMENT_GROUP`.
+    UINT MemorySegmentGroup;
+    /// Only for #TRACE_EVENT_TYPE_BUDGET_UPDATE: `CurrentUsage` returned by DXGI.
+    UINT64 UsageBytes;
+    /// Only for #TRACE_EVENT_TYPE_BUDGET_UPDATE: `Budget` returned by DXGI.
+    UINT64 BudgetBytes;
 };
 
 /**
@@ -1330,6 +1749,92 @@ public:
         const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfo,
         Allocation** ppAllocation);
 
+    /** \brief Allocates multiple blocks of memory at once, like calling Allocator::AllocateMemory for each of them.
+
+    \param AllocationCount   Number of elements in `pAllocDescs`, `pAllocInfos`, `ppAllocations`.
+    \param pAllocDescs   Array of parameters of the allocations.
+    \param pAllocInfos   Array of sizes and alignments of the allocations, with the same requirements as in Allocator::AllocateMemory.
+    \param[out] ppAllocations   Array filled with pointers to new allocation objects created.
+
+    Requests that go to the same heap type or custom pool are grouped together, so that the internal
+    lock of each memory pool is taken only once and the current budget is fetched only once per call,
+    which is significantly faster than allocating the same memory one by one.
+
+    The operation is all-or-nothing: if any of the allocations fails, all the allocations already made
+    by this call are freed, the whole `ppAllocations` array is filled with null and the error is returned.
+    Each of the returned allocations must be released separately.
+    */
+    HRESULT AllocateMemoryBatch(
+        UINT AllocationCount,
+        const ALLOCATION_DESC* pAllocDescs,
+        const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfos,
+        Allocation** ppAllocations);
+
+    /** \brief Allocates memory and creates multiple resources at once, like calling Allocator::CreateResource for each of them.
+
+    \param ResourceCount   Number of elements in all the arrays.
+    \param pAllocDescs   Array of parameters of the allocations.
+    \param pResourceDescs   Array of descriptions of created resources.
+    \param pInitialResourceStates   Array of initial resource states.
+    \param ppOptimizedClearValues   Optional. Either null or array of pointers to optimized clear values, each of which can be null.
+    \param[out] ppAllocations   Array filled with pointers to new allocation objects created.
+        Created resources can be fetched using D3D12MA::Allocation::GetResource().
+
+    Memory is allocated the same way as in Allocator::AllocateMemoryBatch, with one lock per memory pool
+    and one budget query per call. Resources are created after all the memory is allocated,
+    outside of the internal locks.
+
+    The operation is all-or-nothing: if any of the allocations or resources fails to be created,
+    everything already created by this call is released, the whole `ppAllocations` array is filled with null
+    and the error is returned.
+    */
+    HRESULT CreateResourceBatch(
+        UINT ResourceCount,
+        const ALLOCATION_DESC* pAllocDescs,
+        const D3D12_RESOURCE_DESC* pResourceDescs,
+        const D3D12_RESOURCE_STATES* pInitialResourceStates,
+        const D3D12_CLEAR_VALUE* const* ppOptimizedClearValues,
+        Allocation** ppAllocations);
+
+    /** \brief Releases multiple allocations at once, like calling `Release()` on each of them.
+
+    \param AllocationCount   Number of elements in `ppAllocations`.
+    \param ppAllocations   Array of allocations to release. Null elements are ignored.
+
+    Allocations whose reference count drops to zero are destroyed together with their resources.
+    Those placed in the same memory pool are freed under a single lock of this pool, with its blocks
+    sorted once at the end, and allocation objects are returned to the internal allocator in one batch.
+    This is significantly faster than releasing many allocations one by one, e.g. when unloading a level.
+    */
+    void FreeAllocations(
+        UINT AllocationCount,
+        Allocation* const* ppAllocations);
+
+    /** \brief Allocates a range of a buffer shared with other allocations, without creating a new resource.
+
+    \param pAllocDesc   Parameters of the allocation. `HeapType` must be one of the standard heap types
+        and `CustomPool` must be null. Of the flags, only #ALLOCATION_FLAG_WITHIN_BUDGET and #ALLOCATION_FLAG_NEVER_ALLOCATE
+        are used, when a new shared buffer needs to be created.
+    \param Size   Size of the range in bytes. Must be greater than 0.
+    \param Alignment   Required alignment of the offset of the range in bytes. Must be 0 (meaning 1) or a power of 2 not greater than 64 KB.
+    \param[out] ppAllocation   Returns pointer to the new allocation object.
+
+    The returned allocation refers to a buffer shared with other allocations, returned by D3D12MA::Allocation::GetResource(),
+    at offset D3D12MA::Allocation::GetBufferOffset() and GPU virtual address D3D12MA::Allocation::GetGPUVirtualAddress().
+    When no allocations use the buffer any more, it is released, except one empty buffer kept for reuse
+    for every heap type and size class, which is released together with the allocator.
+    It is created in state `D3D12_RESOURCE_STATE_COMMON` for `D3D12_HEAP_TYPE_DEFAULT`,
+    `D3D12_RESOURCE_STATE_GENERIC_READ` for `D3D12_HEAP_TYPE_UPLOAD` and `D3D12_HEAP_TYPE_GPU_UPLOAD`,
+    and `D3D12_RESOURCE_STATE_COPY_DEST` for `D3D12_HEAP_TYPE_READBACK`.
+
+    For more information, see chapter \ref buffer_suballocation.
+    */
+    HRESULT CreateBufferSubAllocation(
+        const ALLOCATION_DESC* pAllocDesc,
+        UINT64 Size,
+        UINT64 Alignment,
+        Allocation** ppAllocation);
+
     /** \brief Creates a new resource in place of an existing allocation. This is useful for memory aliasing.
 
     \param pAllocation Existing allocation indicating the memory where the new resource should be created.
@@ -1406,9 +1911,34 @@ public:
     /** \brief Sets the index of the current frame.
 
     This function is used to set the frame index in the allocator when a new game frame begins.
+
+    All allocations passed to Allocator::ReleaseDeferred with `FrameIndex` earlier than `frameIndex`
+    are released by this call, in one batch as in Allocator::FreeAllocations.
     */
     void SetCurrentFrameIndex(UINT frameIndex);
 
+    /** \brief Releases the allocation once the GPU has finished using it, as signaled by the frame index.
+
+    \param pAllocation   Allocation to release. Null is ignored.
+    \param FrameIndex   Last frame in which the allocation may still be used by the GPU.
+
+    The allocation is queued and released by the first call to Allocator::SetCurrentFrameIndex
+    with a frame index later than `FrameIndex`, which is equivalent to calling `Release()` on it at that point.
+    Frame indices are compared modulo 2^32, so wrap-around of the frame counter is handled.
+    This saves the application from keeping its own queue of pending releases and moves the cost
+    of freeing memory out of the code that drops the allocation, e.g. the render thread.
+
+    The allocation must not be used by the application after this call.
+    */
+    void ReleaseDeferred(Allocation* pAllocation, UINT FrameIndex);
+
+    /** \brief Immediately releases all allocations queued by Allocator::ReleaseDeferred, regardless of their frame index.
+
+    Call it when the GPU is known to be idle, e.g. before releasing a custom pool that contains such allocations.
+    Allocations still queued when the allocator is destroyed are released automatically.
+    */
+    void ReleaseAllDeferred();
+
     /** \brief Retrieves information about current memory usage and budget.
 
     \param[out] pLocalBudget Optional, can be null.
@@ -1430,6 +1960,30 @@ public:
     */
     void GetBudget(Budget* pLocalBudget, Budget* pNonLocalBudget);
 
+    /** \brief Fetches current memory usage and budget from DXGI, to be returned by GetBudget().
+
+    Calls `IDXGIAdapter3::QueryVideoMemoryInfo`. Can be called from any thread, also concurrently
+    with allocations, which keep using the previous values until the new ones are stored.
+    Use it with #ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE to refresh the budget from your own thread,
+    e.g. after waiting for an event registered using `IDXGIAdapter3::RegisterVideoMemoryBudgetChangeNotificationEvent`.
+
+    Returns `S_OK` without doing anything if the adapter doesn't support `IDXGIAdapter3`.
+    */
+    HRESULT UpdateBudget();
+
+    /** \brief Retrieves statistics of the cache of resource allocation info.
+
+    Returns zeros if the allocator was not created with D3D12MA::ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO.
+    */
+    void GetResourceAllocationInfoCacheStatistics(ResourceAllocationInfoCacheStatistics* pStats) const;
+
+    /** \brief Retrieves durations of operations and counts of placement decisions since the allocator was created.
+
+    Returns zeros if the allocator was not created with D3D12MA::ALLOCATOR_FLAG_PERFORMANCE_COUNTERS.
+    It doesn't take any lock. Operations in progress in other threads may be missing or counted only partially.
+    */
+    void GetPerformanceCounters(PerformanceCounters* pCounters) const;
+
     /** \brief Retrieves statistics from current state of the allocator.
 
     This function is called "calculate" not "get" because it has to traverse all
@@ -1452,6 +2006,73 @@ public:
     /// Frees memory of a string returned from Allocator::BuildStatsString.
     void FreeStatsString(WCHAR* pStatsString) const;
 
+    /** \brief Writes the same statistics as BuildStatsString() in JSON format, passing it to a callback in parts.
+
+    Unlike BuildStatsString(), it doesn't build the whole string in memory, so it can be used to dump
+    the detailed map of an allocator with many allocations directly to a file or a network stream.
+    The callback is called with internal locks held, so it must not call functions of this allocator.
+
+    @param pWriteFunc Function called with consecutive parts of the string.
+    @param pPrivateData Custom data passed to `pWriteFunc`.
+    @param Encoding Encoding of the string. #STATS_STRING_ENCODING_UTF16 starts with a byte order mark.
+    @param DetailedMap `TRUE` to include full list of allocations, `FALSE` to only write statistics.
+    */
+    void WriteStatsString(
+        WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+        void* pPrivateData,
+        STATS_STRING_ENCODING Encoding,
+        BOOL DetailedMap) const;
+
+    /** \brief Writes the same information as WriteStatsString() in a compact binary format, passing it to a callback in parts.
+
+    The binary dump is many times smaller and faster to write than the JSON string, so it is better suited
+    for capturing the state of an allocator with many allocations, e.g. periodically or on a crash.
+    It can be converted to the JSON format using tools/GpuMemDumpBin2Json/GpuMemDumpBin2Json.py.
+    The callback is called with internal locks held, so it must not call functions of this allocator.
+
+    @param pWriteFunc Function called with consecutive parts of the dump.
+    @param pPrivateData Custom data passed to `pWriteFunc`.
+    @param DetailedMap `TRUE` to include full list of allocations, `FALSE` to only write statistics.
+    */
+    void WriteStatsBinary(
+        WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+        void* pPrivateData,
+        BOOL DetailedMap) const;
+
+    /** \brief Records all memory blocks and allocations of the allocator, to be compared with another snapshot later.
+
+    It is much faster and more compact than a JSON dump with detailed map. For more information, see
+    [Snapshots](@ref statistics_snapshots).
+
+    \param[out] ppSnapshot Created snapshot. Must be released using `Release()`.
+    */
+    HRESULT CreateSnapshot(Snapshot** ppSnapshot);
+
+    /** \brief Copies events recorded with #ALLOCATOR_FLAG_TRACE_EVENTS.
+
+    \param[in,out] pNextSequenceNumber Sequence number of the first event to read, 0 to start from the oldest one kept.
+        Updated to the number following the last event returned, so that the next call continues from there.
+        If events following it were already overwritten, reading starts from the oldest event still kept.
+    \param[out] pEvents Array to be filled with events.
+    \param MaxEventCount Number of elements of `pEvents`.
+    \return Number of events written to `pEvents`. 0 if the allocator was created without #ALLOCATOR_FLAG_TRACE_EVENTS.
+
+    It doesn't take any lock and can be called from any thread, also while other threads allocate.
+    Events still being recorded by other threads are left for the next call.
+    */
+    UINT GetTraceEvents(UINT64* pNextSequenceNumber, TRACE_EVENT* pEvents, UINT MaxEventCount) const;
+
+    /** \brief Writes events recorded with #ALLOCATOR_FLAG_TRACE_EVENTS in a compact binary format.
+
+    Writes the same events as GetTraceEvents() would return, all of them, using the same `pNextSequenceNumber`.
+    The output of consecutive calls can be appended to a single file, to be replayed using tool "D3D12MA_TraceReplay".
+    The format is described in "tools/GpuMemDumpBin2Json/README.md".
+    */
+    void WriteTraceEvents(
+        UINT64* pNextSequenceNumber,
+        WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+        void* pPrivateData) const;
+
     /** \brief Begins defragmentation process of the default pools.
 
     \param pDesc Structure filled with parameters of defragmentation.
@@ -1499,6 +2120,36 @@ enum VIRTUAL_BLOCK_FLAGS
     */
     VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR = POOL_FLAG_ALGORITHM_LINEAR,
 
+    /** \brief Makes the virtual block safe to be used from multiple threads simultaneously.
+
+    With the default TLSF algorithm, the block is split into `D3D12MA_VIRTUAL_BLOCK_SHARD_COUNT`
+    equal, independent address ranges (shards), each with its own lock. Each thread allocates from
+    its own shard first and takes space from the other shards only when its own one is exhausted,
+    so threads don't serialize on a single lock. As a consequence, a single allocation cannot be
+    larger than the size of one shard, and allocations with large alignment can be placed only
+    in shards whose beginning is aligned accordingly.
+
+    With #VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR, #VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY and
+    #VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB, the block is guarded by a single lock to keep
+    the behavior of these algorithms.
+    */
+    VIRTUAL_BLOCK_FLAG_THREAD_SAFE = 0x2,
+
+    /** \brief Enables alternative, buddy allocation algorithm in this virtual block.
+
+    Every allocation takes a whole node of power-of-2 size, aligned to its size.
+    Only the largest power of 2 not greater than `VIRTUAL_BLOCK_DESC::Size` is used.
+    For details, see documentation chapter \ref buddy_algorithm.
+    */
+    VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY = POOL_FLAG_ALGORITHM_BUDDY,
+
+    /** \brief Enables alternative, slab allocation algorithm in this virtual block.
+
+    The block is divided into slots of size `VIRTUAL_BLOCK_DESC::SlotSize`, and every
+    allocation takes one slot. For details, see documentation chapter \ref slab_algorithm.
+    */
+    VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB = POOL_FLAG_ALGORITHM_SLAB,
+
     // Bit mask to extract only `ALGORITHM` bits from entire set of flags.
     VIRTUAL_BLOCK_FLAG_ALGORITHM_MASK = POOL_FLAG_ALGORITHM_MASK
 };
@@ -1519,6 +2170,12 @@ struct VIRTUAL_BLOCK_DESC
     Optional, can be null. When specified, will be used for all CPU-side memory allocations.
     */
     const ALLOCATION_CALLBACKS* pAllocationCallbacks;
+    /** \brief Size of a single slot of a block created with #VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB.
+
+    Required, must be greater than 0 and not greater than `Size` with #VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB.
+    Ignored with other algorithms.
+    */
+    UINT64 SlotSize;
 };
 
 /// \brief Bit flags to be used with VIRTUAL_ALLOCATION_DESC::Flags.
@@ -1596,7 +2253,8 @@ To create this object, fill in D3D12MA::VIRTUAL_BLOCK_DESC and call CreateVirtua
 To destroy it, call its method `VirtualBlock::Release()`.
 You need to free all the allocations within this block or call Clear() before destroying it.
 
-This object is not thread-safe - should not be used from multiple threads simultaneously, must be synchronized externally.
+This object is not thread-safe - should not be used from multiple threads simultaneously, must be synchronized externally,
+unless it's created with D3D12MA::VIRTUAL_BLOCK_FLAG_THREAD_SAFE.
 */
 class D3D12MA_API VirtualBlock : public IUnknownImpl
 {
@@ -1647,6 +2305,17 @@ public:
     /** \brief Frees memory of a string returned from VirtualBlock::BuildStatsString.
     */
     void FreeStatsString(WCHAR* pStatsString) const;
+
+    /** \brief Writes the same string as BuildStatsString(), passing it to a callback in parts.
+
+    @param pWriteFunc Function called with consecutive parts of the string.
+    @param pPrivateData Custom data passed to `pWriteFunc`.
+    @param Encoding Encoding of the string.
+    */
+    void WriteStatsString(
+        WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+        void* pPrivateData,
+        STATS_STRING_ENCODING Encoding) const;
    
 protected:
     void ReleaseThis() override;
@@ -1744,6 +2413,7 @@ struct CPOOL_DESC : public POOL_DESC
         MinAllocationAlignment = 0;
         pProtectedSession = NULL;
         ResidencyPriority = residencyPriority;
+        SlotSize = 0;
     }
     /// Constructor initializing description of a custom pool created with custom `D3D12_HEAP_PROPERTIES`.
     explicit CPOOL_DESC(const D3D12_HEAP_PROPERTIES heapProperties,
@@ -1763,6 +2433,7 @@ struct CPOOL_DESC : public POOL_DESC
         MinAllocationAlignment = 0;
         pProtectedSession = NULL;
         ResidencyPriority = residencyPriority;
+        SlotSize = 0;
     }
 };
 
@@ -1785,6 +2456,7 @@ struct CVIRTUAL_BLOCK_DESC : public VIRTUAL_BLOCK_DESC
         Flags = flags;
         Size = size;
         pAllocationCallbacks = allocationCallbacks;
+        SlotSize = 0;
     }
 };
 
@@ -2487,6 +3159,12 @@ This library automatically makes use of it when available (when you use recent e
 If not, it falls back to estimating the usage and budget based on the total amount of the allocated memory
 and 80% of the full memory capacity, respectively.
 
+\par Implementation detail
+By default, the budget is fetched from DXGI every 30 allocations or deallocations, on the thread that makes them.
+To keep this call off the allocation path, use D3D12MA::ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE and refresh the budget
+by calling D3D12MA::Allocator::UpdateBudget from your own thread, or use D3D12MA::ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE
+to let the allocator do it on a thread it owns.
+
 \par Implementation detail
 Allocating large heaps and creating placed resources in them is one of the main features of this library.
 However, if allocating new such block would exceed the budget, it will automatically prefer creating the resource as committed
@@ -3092,6 +3770,9 @@ including minimum and maximum allocation size and unused range size,
 by calling function D3D12MA::Allocator::CalculateStatistics() and inspecting structure D3D12MA::TotalStatistics.
 This function is slower though, as it has to traverse all the internal data structures,
 so it should be used only for debugging purposes.
+If you need to call it often, e.g. from a telemetry thread, create the allocator with
+D3D12MA::ALLOCATOR_FLAG_LOCK_FREE_STATISTICS, so the statistics are maintained incrementally
+and reading them doesn't block other threads allocating memory.
 
 You can query for statistics of a custom pool using function D3D12MA::Pool::GetStatistics()
 or D3D12MA::Pool::CalculateStatistics().
@@ -3108,6 +3789,21 @@ Any strings provided by user (see D3D12MA::Allocation::SetName())
 are copied as-is and properly escaped for JSON.
 It must be freed using function D3D12MA::Allocator::FreeStatsString().
 
+With many allocations, the detailed map can take hundreds of megabytes. To avoid building it in memory,
+use function D3D12MA::Allocator::WriteStatsString() instead, which passes the same JSON to your callback
+in parts, e.g. to write them to a file, optionally in UTF-8 encoding:
+
+\code
+static void WriteToFile(const void* pData, size_t byteCount, void* pPrivateData)
+{
+    fwrite(pData, 1, byteCount, (FILE*)pPrivateData);
+}
+
+FILE* file = fopen("GpuMemDump.json", "wb");
+allocator->WriteStatsString(WriteToFile, file, D3D12MA::STATS_STRING_ENCODING_UTF8, TRUE);
+fclose(file);
+\endcode
+
 The format of this JSON string is not part of official documentation of the library,
 but it will not change in backward-incompatible way without increasing library major version number
 and appropriate mention in changelog.
@@ -3117,6 +3813,103 @@ It can also contain detailed map of allocated memory blocks and their regions -
 free and occupied by allocations.
 This allows e.g. to visualize the memory or assess fragmentation.
 
+Function D3D12MA::Allocator::WriteStatsBinary() writes the same information in a compact binary format,
+with numbers encoded as varints and offsets of allocations stored as distances from the end of the previous one.
+It is about 10 times smaller and faster to write, which makes it better suited e.g. for taking dumps periodically.
+Python script "tools/GpuMemDumpBin2Json/GpuMemDumpBin2Json.py" converts it to the JSON format,
+so it can be visualized using "tools/GpuMemDumpVis/GpuMemDumpVis.py".
+The binary format starts with a version number, which is increased with every change of the format.
+
+\section statistics_snapshots Snapshots
+
+To find out what changed in the memory between two moments, e.g. during a spike of memory usage,
+call D3D12MA::Allocator::CreateSnapshot() at both of them. A D3D12MA::Snapshot records all memory blocks and allocations
+without their names, so it is cheap to create and keep. Then call D3D12MA::Snapshot::EnumerateChanges()
+on the later snapshot, passing the earlier one, to get a list of memory blocks and allocations created, freed or moved in between.
+Function D3D12MA::Snapshot::WriteChanges() writes the same list in a compact binary format,
+which makes it possible e.g. to send only changes to telemetry:
+
+\code
+D3D12MA::Snapshot* prevSnapshot = NULL; // Null for the first time - everything is reported as created.
+...
+D3D12MA::Snapshot* snapshot;
+allocator->CreateSnapshot(&snapshot);
+snapshot->WriteChanges(prevSnapshot, SendToTelemetry, telemetryConnection);
+if(prevSnapshot)
+    prevSnapshot->Release();
+prevSnapshot = snapshot;
+\endcode
+
+\section statistics_trace Event trace
+
+To see how the memory got into its current state, create the allocator with D3D12MA::ALLOCATOR_FLAG_TRACE_EVENTS.
+Then every allocation, deallocation, creation and destruction of a memory block, move made by defragmentation
+and refresh of the budget is recorded as D3D12MA::TRACE_EVENT in a ring buffer of fixed size,
+D3D12MA::ALLOCATOR_DESC::TraceEventCapacity. Recording doesn't take any lock, so it has little impact
+on the allocation path even with many threads.
+
+Call D3D12MA::Allocator::GetTraceEvents() periodically to read the events recorded since the previous call,
+or D3D12MA::Allocator::WriteTraceEvents() to save them in a binary format:
+
+\code
+UINT64 nextSequenceNumber = 0;
+...
+// Every frame, or when the trace is needed:
+allocator->WriteTraceEvents(&nextSequenceNumber, AppendToFile, traceFile);
+\endcode
+
+A trace saved this way can be replayed offline, also on Linux, by program "D3D12MA_TraceReplay"
+built from "src/TraceReplay.cpp". It feeds the allocations through D3D12MA::VirtualBlock objects
+with different algorithms and strategies, and through an allocator created on a mock device when available,
+to compare the resulting memory usage and fragmentation. Run it with `--help` to see its options.
+
+
+\section statistics_performance_counters Performance counters
+
+To see where the time of creating resources goes, create the allocator with D3D12MA::ALLOCATOR_FLAG_PERFORMANCE_COUNTERS
+and call D3D12MA::Allocator::GetPerformanceCounters(). For each type of heap, it returns histograms of durations
+of whole calls to D3D12MA::Allocator::CreateResource() and D3D12MA::Allocator::AllocateMemory(),
+of releasing allocations, of the calls to `ID3D12Device` made inside them, and of the time spent waiting for
+the lock of a memory pool - a sign of contention between threads. Every histogram has buckets of exponentially
+growing size, from a nanosecond to seconds, so percentiles can be estimated with a factor of 2 precision.
+
+\code
+D3D12MA::PerformanceCounters counters;
+allocator->GetPerformanceCounters(&counters);
+const D3D12MA::LatencyHistogram& createHeap =
+    counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_CREATE_HEAP][0]; // D3D12_HEAP_TYPE_DEFAULT
+if(createHeap.Count > 0)
+    printf("CreateHeap: %llu calls, %.1f us average\n",
+        createHeap.Count, createHeap.TotalNanoseconds / (createHeap.Count * 1000.0));
+\endcode
+
+D3D12MA::PerformanceCounters::PlacementDecisions tells how many allocations were placed in memory blocks
+and how many were committed, and why. Many allocations committed because a pool couldn't fit them
+may suggest that a bigger block size would help.
+
+The same counters are written to the [JSON dump](@ref statistics_json_dump) as object "PerformanceCounters",
+with only non-empty histograms and buckets up to the last non-empty one.
+
+Counters are updated atomically by threads in separate cache lines, so they don't serialize the threads,
+but each measurement reads the system clock, which may take tens of nanoseconds.
+
+\section statistics_lock_profiles Lock profiling
+
+To find out which of the internal locks of the library threads wait for most, compile it with macro
+`D3D12MA_PROFILE_LOCKS` defined to 1 (CMake option `D3D12MA_PROFILE_LOCKS`). The mutex classes
+`D3D12MA_MUTEX`, `D3D12MA_RW_MUTEX` - the default or your own ones - are then wrapped with classes that count
+how many times each lock was acquired, how many of these acquisitions were contended (another thread held
+the lock or waited for it in a conflicting mode), and how long the contended ones waited, in a histogram
+with power-of-2 buckets in nanoseconds.
+
+Results are summed per kind of lock: `Pools`, `BlockVector` (memory blocks of a default or custom pool),
+`CommittedAllocationList`, `AllocationObjectAllocator`, `Budget`, `ResourceAllocationInfoCache`, `DeferredReleases`,
+`BufferSubAllocator`,
+and written to the [JSON dump](@ref statistics_json_dump) as object "LockProfiles". Locks of virtual blocks are not profiled.
+Note that building the dump takes some of these locks itself.
+
+This mode is meant for profiling only, as it adds atomic operations to every lock and unlock.
+
 
 \page resource_aliasing Resource aliasing (overlap)
 
@@ -3232,6 +4025,48 @@ Additional considerations:
   Otherwise they must be placed in different memory heap types, and thus aliasing them is not possible.
 
 
+\page buffer_suballocation Buffer suballocation
+
+Every resource created with D3D12MA::Allocator::CreateResource is a separate `ID3D12Resource`.
+Placed buffers take at least 64 KB of memory, because this is their required alignment,
+and committed ones take an implicit heap each. Creating thousands of tiny constant or vertex buffers
+this way wastes memory and spends a lot of time in the driver.
+
+Such small data can instead be allocated as ranges of bigger buffers shared with other allocations,
+using function D3D12MA::Allocator::CreateBufferSubAllocation. No resource is created for the range itself:
+
+\code
+D3D12MA::ALLOCATION_DESC allocDesc = {};
+allocDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+
+D3D12MA::Allocation* alloc;
+HRESULT hr = allocator->CreateBufferSubAllocation(&allocDesc,
+    sizeof(MyConstants), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, &alloc);
+
+D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
+cbvDesc.BufferLocation = alloc->GetGPUVirtualAddress();
+cbvDesc.SizeInBytes = 256;
+\endcode
+
+The ranges are grouped into size classes of 256 B, 4 KB, and 64 KB. Each range takes a whole slot
+of the smallest size class that is not smaller than its size and alignment. For every standard heap type and size class,
+the library keeps a list of shared buffers divided into such slots, managed by the \ref slab_algorithm.
+Larger ranges are allocated from shared buffers of 8 MB managed by the default TLSF algorithm,
+or from a buffer created just for the range if it is even larger.
+These buffers are created as normal allocations in the default pools, so they are visible in the
+\ref statistics and the JSON dump as allocations of the buffers, while the ranges are not.
+A shared buffer is released when the last range in it is freed, except one empty buffer kept for each size class.
+
+Things to remember:
+
+- All the ranges of a shared buffer are in the same resource state. You cannot transition one of them
+  to a different state without affecting the others.
+- Writing to a range of a buffer in the `UPLOAD` heap while GPU may still read other ranges of it is fine,
+  as long as you don't overwrite the ranges that GPU is using.
+- The returned D3D12MA::Allocation must not be passed to D3D12MA::Allocation::SetResource or defragmented.
+  It can be released as usual, also using D3D12MA::Allocator::FreeAllocations and D3D12MA::Allocator::ReleaseDeferred.
+
+
 \page linear_algorithm Linear allocation algorithm
 
 Each D3D12 memory block managed by this library has accompanying metadata that
@@ -3319,6 +4154,82 @@ Linear algorithm can also be used with \ref virtual_allocator.
 See flag D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR.
 
 
+\page buddy_algorithm Buddy allocation algorithm
+
+There is another allocation algorithm that can be used with custom pools, called
+"buddy". Its internal data structure is based on a binary tree of blocks, each having
+size that is a power of two and a half of its parent's size. When you want to
+allocate memory of certain size, a free node in the tree is located. If it is too
+large, it is recursively split into two halves (called "buddies"). However, if
+requested allocation size is not a power of two, the size of the allocation is
+aligned up to the nearest power of two and the remaining space is wasted. When
+two buddy nodes become free, they are merged back into one larger node.
+
+To use buddy allocation algorithm with a custom pool, add flag
+D3D12MA::POOL_FLAG_ALGORITHM_BUDDY to D3D12MA::POOL_DESC::Flags while creating
+D3D12MA::Pool object.
+
+The advantage of buddy allocation algorithm over default algorithm is faster
+allocation and deallocation with no search through free lists, as well as smaller
+external fragmentation. The disadvantage is more wasted space (internal
+fragmentation), so it works best when sizes of all the allocations are powers of two,
+like pages of a virtual texture or tables of descriptors.
+
+There are following limitations of this algorithm:
+
+- Only the largest power of two not greater than the size of each memory block is used.
+  For best results, set D3D12MA::POOL_DESC::BlockSize to a power of two.
+- Nodes of memory blocks are never smaller than 256 B, which is
+  `D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT`.
+- D3D12MA::ALLOCATION_FLAG_UPPER_ADDRESS is not supported.
+
+Buddy algorithm can also be used with \ref virtual_allocator.
+See flag D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY. There, nodes can be as small as 1 unit.
+
+
+\page slab_algorithm Slab allocation algorithm
+
+When a custom pool holds many allocations of the same size, like thousands of constant
+or structured buffers of 64 KB each, you can use slab allocation algorithm by adding flag
+D3D12MA::POOL_FLAG_ALGORITHM_SLAB to D3D12MA::POOL_DESC::Flags and setting
+D3D12MA::POOL_DESC::SlotSize to the size of these allocations.
+
+\code
+D3D12MA::POOL_DESC poolDesc = {};
+poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+poolDesc.Flags = D3D12MA::POOL_FLAG_ALGORITHM_SLAB;
+poolDesc.SlotSize = 64ull * 1024;
+
+D3D12MA::Pool* pool;
+HRESULT hr = allocator->CreatePool(&poolDesc, &pool);
+\endcode
+
+Every memory block of such pool is divided into slots of this size, and every allocation
+takes one whole slot. Free slots are tracked in bitmaps, so finding and freeing a slot
+takes constant time, with no splitting and merging of free regions, and metadata takes
+a few bytes per slot.
+
+There are following limitations of this algorithm:
+
+- Allocations larger than the slot fail to allocate in the pool. Allocations smaller than
+  the slot waste the rest of it.
+- Offsets of allocations are multiples of the slot size. If its alignment is smaller than
+  the alignment required by an allocation, only suitably aligned slots can be used, and
+  they are searched one by one. For placed resources, a multiple of 64 KB is recommended
+  (`D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT`).
+- Space at the end of a memory block smaller than the slot is never used.
+- D3D12MA::ALLOCATION_FLAG_UPPER_ADDRESS is not supported, and allocation strategy flags
+  have no effect - the free slot with the lowest offset is always taken.
+
+Occupancy of the whole pool can be inspected using D3D12MA::Pool::CalculateStatistics,
+and of each memory block in the detailed map of the JSON dump, where pools of this
+algorithm also report their "SlotSize".
+
+Slab algorithm can also be used with \ref virtual_allocator.
+See flag D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB and member D3D12MA::VIRTUAL_BLOCK_DESC::SlotSize.
+
+
 \page virtual_allocator Virtual allocator
 
 As an extra feature, the core allocation algorithm of the library is exposed through a simple and convenient API of "virtual allocator".
@@ -3474,6 +4385,10 @@ The format of this string may differ from the one returned by the main D3D12 all
 Alternative, linear algorithm can be used with virtual allocator - see flag
 D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR and documentation: \ref linear_algorithm.
 
+If a virtual block needs to be used from many threads, e.g. to sub-allocate a descriptor heap or
+an upload buffer, create it with flag D3D12MA::VIRTUAL_BLOCK_FLAG_THREAD_SAFE rather than guarding it with your own mutex.
+The block is then split into shards locked separately, which lets threads allocate in parallel.
+
 Note that the "virtual allocator" functionality is implemented on a level of individual memory blocks.
 Keeping track of a whole collection of blocks, allocating new ones when out of free space,
 deleting empty ones, and deciding which one to try first for a new allocation must be implemented by the user.
@@ -3570,7 +4485,8 @@ Margins do not apply to \ref virtual_allocator.
 - When the allocator is created with D3D12MA::ALLOCATOR_FLAG_SINGLETHREADED,
   calls to methods of D3D12MA::Allocator class must be made from a single thread or synchronized by the user.
   Using this flag may improve performance.
-- D3D12MA::VirtualBlock is not safe to be used from multiple threads simultaneously.
+- D3D12MA::VirtualBlock is not safe to be used from multiple threads simultaneously,
+  unless it's created with D3D12MA::VIRTUAL_BLOCK_FLAG_THREAD_SAFE.
 
 \section general_considerations_versioning_and_compatibility Versioning and compatibility
 
@@ -0,0 +1,1995 @@
+//
+// Copyright (c) 2019-2026 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/*
+Standalone benchmarks of D3D12MA, independent of the D3D12 sample application.
+
+Results are printed to stdout or written to a file in text, CSV or JSON format,
+to be compared between versions of the library. Run with --help to see options.
+*/
+
+#include "D3D12MemAlloc.h"
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+    #include "MockD3D12.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
+
+#define STRINGIZE(x) STRINGIZE2(x)
+#define STRINGIZE2(x) #x
+#define LINE_STRING STRINGIZE(__LINE__)
+#define CHECK_BOOL(expr)  do { if(!(expr)) { \
+        fprintf(stderr, "%s\n", __FILE__ "(" LINE_STRING "): ( " #expr " ) == false"); \
+        exit(1); \
+    } } while(false)
+#define CHECK_HR(expr)  do { if(FAILED(expr)) { \
+        fprintf(stderr, "%s\n", __FILE__ "(" LINE_STRING "): FAILED( " #expr " )"); \
+        exit(1); \
+    } } while(false)
+
+typedef std::chrono::steady_clock::time_point time_point;
+
+static inline time_point Now() { return std::chrono::steady_clock::now(); }
+static inline UINT64 ElapsedNs(time_point beg, time_point end)
+{
+    return (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count();
+}
+
+class RandomNumberGenerator
+{
+public:
+    RandomNumberGenerator(uint32_t seed) : m_Value{seed} { }
+    uint32_t Generate() { return GenerateFast() ^ (GenerateFast() >> 7); }
+    // Uniform in [0, 1).
+    double GenerateDouble() { return (double)Generate() / 4294967296.0; }
+
+private:
+    uint32_t m_Value;
+    uint32_t GenerateFast() { return m_Value = (m_Value * 196314165 + 907633515); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Results
+
+struct BenchmarkParameter
+{
+    std::string Name;
+    std::string Value;
+};
+
+struct BenchmarkMetric
+{
+    std::string Name;
+    double Value;
+    std::string Unit;
+};
+
+struct BenchmarkResult
+{
+    std::string Benchmark;
+    std::vector<BenchmarkParameter> Parameters;
+    std::vector<BenchmarkMetric> Metrics;
+
+    void AddParameter(const char* name, const char* value) { Parameters.push_back({ name, value }); }
+    void AddParameter(const char* name, UINT64 value) { Parameters.push_back({ name, std::to_string(value) }); }
+    void AddMetric(const char* name, double value, const char* unit) { Metrics.push_back({ name, value, unit }); }
+};
+
+enum class OUTPUT_FORMAT { TEXT, CSV, JSON };
+
+struct BenchmarkConfig
+{
+    OUTPUT_FORMAT Format = OUTPUT_FORMAT::TEXT;
+    const char* OutputPath = NULL;
+    const char* Filter = NULL;
+    // Smaller iteration counts, for a smoke test.
+    bool Quick = false;
+    UINT MaxThreads = 16;
+};
+
+static BenchmarkConfig g_Config;
+static std::vector<BenchmarkResult> g_Results;
+
+// Progress messages go to stderr so stdout can carry CSV or JSON.
+static void Log(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+static void PrintJsonString(FILE* file, const std::string& str)
+{
+    fputc('"', file);
+    for(char ch : str)
+    {
+        switch(ch)
+        {
+        case '"': fputs("\\\"", file); break;
+        case '\\': fputs("\\\\", file); break;
+        case '\n': fputs("\\n", file); break;
+        default:
+            if((unsigned char)ch < 0x20)
+                fprintf(file, "\\u%04X", (unsigned)ch);
+            else
+                fputc(ch, file);
+        }
+    }
+    fputc('"', file);
+}
+
+static void WriteResults(FILE* file)
+{
+    switch(g_Config.Format)
+    {
+    case OUTPUT_FORMAT::TEXT:
+        for(const BenchmarkResult& result : g_Results)
+        {
+            fprintf(file, "%s", result.Benchmark.c_str());
+            for(const BenchmarkParameter& param : result.Parameters)
+                fprintf(file, " %s=%s", param.Name.c_str(), param.Value.c_str());
+            fprintf(file, "\n");
+            for(const BenchmarkMetric& metric : result.Metrics)
+                fprintf(file, "    %-28s %14.6g %s\n", metric.Name.c_str(), metric.Value, metric.Unit.c_str());
+        }
+        break;
+    case OUTPUT_FORMAT::CSV:
+        // Long format: one row per metric, so benchmarks with different parameters share the columns.
+        fprintf(file, "Benchmark,Parameters,Metric,Value,Unit\n");
+        for(const BenchmarkResult& result : g_Results)
+        {
+            std::string params;
+            for(const BenchmarkParameter& param : result.Parameters)
+            {
+                if(!params.empty())
+                    params += ';';
+                params += param.Name + '=' + param.Value;
+            }
+            for(const BenchmarkMetric& metric : result.Metrics)
+            {
+                fprintf(file, "%s,%s,%s,%.9g,%s\n", result.Benchmark.c_str(), params.c_str(),
+                    metric.Name.c_str(), metric.Value, metric.Unit.c_str());
+            }
+        }
+        break;
+    case OUTPUT_FORMAT::JSON:
+        fprintf(file, "{\n  \"Quick\": %s,\n  \"Results\": [", g_Config.Quick ? "true" : "false");
+        for(size_t resultIndex = 0; resultIndex < g_Results.size(); ++resultIndex)
+        {
+            const BenchmarkResult& result = g_Results[resultIndex];
+            fprintf(file, "%s\n    {\n      \"Benchmark\": ", resultIndex ? "," : "");
+            PrintJsonString(file, result.Benchmark);
+            fprintf(file, ",\n      \"Parameters\": {");
+            for(size_t i = 0; i < result.Parameters.size(); ++i)
+            {
+                fprintf(file, "%s", i ? ", " : "");
+                PrintJsonString(file, result.Parameters[i].Name);
+                fprintf(file, ": ");
+                PrintJsonString(file, result.Parameters[i].Value);
+            }
+            fprintf(file, "},\n      \"Metrics\": {");
+            for(size_t i = 0; i < result.Metrics.size(); ++i)
+            {
+                fprintf(file, "%s\n        ", i ? "," : "");
+                PrintJsonString(file, result.Metrics[i].Name);
+                fprintf(file, ": { \"Value\": %.9g, \"Unit\": ", result.Metrics[i].Value);
+                PrintJsonString(file, result.Metrics[i].Unit);
+                fprintf(file, " }");
+            }
+            fprintf(file, "\n      }\n    }");
+        }
+        fprintf(file, "\n  ]\n}\n");
+        break;
+    }
+}
+
+static bool ShouldRun(const char* benchmarkName)
+{
+    return g_Config.Filter == NULL || strstr(benchmarkName, g_Config.Filter) != NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+// Latencies of individual operations, in nanoseconds.
+class LatencyRecorder
+{
+public:
+    void Reserve(size_t count) { m_Samples.reserve(count); }
+    void Add(UINT64 ns) { m_Samples.push_back(ns); }
+    void Append(const LatencyRecorder& src) { m_Samples.insert(m_Samples.end(), src.m_Samples.begin(), src.m_Samples.end()); }
+    size_t GetCount() const { return m_Samples.size(); }
+
+    // Adds <prefix>_p50, _p99, _p999 metrics. Sorts the samples.
+    void AddPercentileMetrics(BenchmarkResult& result, const char* prefix)
+    {
+        std::sort(m_Samples.begin(), m_Samples.end());
+        const char* const suffixes[] = { "_p50", "_p99", "_p999" };
+        const double percentiles[] = { 0.5, 0.99, 0.999 };
+        for(size_t i = 0; i < 3; ++i)
+        {
+            const std::string name = std::string(prefix) + suffixes[i];
+            result.AddMetric(name.c_str(), (double)GetPercentile(percentiles[i]), "ns");
+        }
+    }
+
+private:
+    std::vector<UINT64> m_Samples;
+
+    UINT64 GetPercentile(double p) const
+    {
+        if(m_Samples.empty())
+            return 0;
+        const size_t index = std::min(m_Samples.size() - 1, (size_t)(p * (double)m_Samples.size()));
+        return m_Samples[index];
+    }
+};
+
+/*
+ALLOCATION_CALLBACKS that count CPU memory currently allocated by the library,
+used to measure metadata overhead, and its peak since the last ResetPeakBytes.
+*/
+class CountingAllocationCallbacks
+{
+public:
+    CountingAllocationCallbacks()
+    {
+        m_Callbacks.pAllocate = Allocate;
+        m_Callbacks.pFree = Free;
+        m_Callbacks.pPrivateData = this;
+    }
+    const D3D12MA::ALLOCATION_CALLBACKS* Get() const { return &m_Callbacks; }
+    UINT64 GetCurrentBytes() const { return m_CurrentBytes.load(); }
+    UINT64 GetPeakBytes() const { return m_PeakBytes.load(); }
+    void ResetPeakBytes() { m_PeakBytes = m_CurrentBytes.load(); }
+
+private:
+    // Size of the allocation is stored in front of it.
+    static const size_t HEADER_SIZE = 16;
+
+    D3D12MA::ALLOCATION_CALLBACKS m_Callbacks;
+    std::atomic<UINT64> m_CurrentBytes{ 0 };
+    std::atomic<UINT64> m_PeakBytes{ 0 };
+
+    static void* Allocate(size_t size, size_t alignment, void* privateData)
+    {
+        const size_t headerSize = alignment > HEADER_SIZE ? alignment : HEADER_SIZE;
+        // aligned_alloc requires the size to be a multiple of the alignment.
+        const size_t totalSize = (headerSize + size + headerSize - 1) / headerSize * headerSize;
+#ifdef _WIN32
+        char* const base = (char*)_aligned_malloc(totalSize, headerSize);
+#else
+        char* const base = (char*)aligned_alloc(headerSize, totalSize);
+#endif
+        if(base == NULL)
+            return NULL;
+        char* const ptr = base + headerSize;
+        ((size_t*)ptr)[-1] = size;
+        ((size_t*)ptr)[-2] = headerSize;
+        CountingAllocationCallbacks* const self = (CountingAllocationCallbacks*)privateData;
+        const UINT64 currentBytes = self->m_CurrentBytes += size;
+        UINT64 peakBytes = self->m_PeakBytes.load();
+        while(currentBytes > peakBytes && !self->m_PeakBytes.compare_exchange_weak(peakBytes, currentBytes)) { }
+        return ptr;
+    }
+    static void Free(void* memory, void* privateData)
+    {
+        if(memory == NULL)
+            return;
+        char* const ptr = (char*)memory;
+        ((CountingAllocationCallbacks*)privateData)->m_CurrentBytes -= ((size_t*)ptr)[-1];
+#ifdef _WIN32
+        _aligned_free(ptr - ((size_t*)ptr)[-2]);
+#else
+        free(ptr - ((size_t*)ptr)[-2]);
+#endif
+    }
+};
+
+static const char* VirtualAlgorithmToStr(D3D12MA::VIRTUAL_BLOCK_FLAGS algorithm)
+{
+    switch(algorithm)
+    {
+    case D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR:
+        return "Linear";
+    case D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY:
+        return "Buddy";
+    case D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB:
+        return "Slab";
+    case 0:
+        return "TLSF";
+    default:
+        return "Unknown";
+    }
+}
+
+static const char* StrategyToStr(D3D12MA::VIRTUAL_ALLOCATION_FLAGS strategy)
+{
+    switch(strategy)
+    {
+    case D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_MEMORY:
+        return "MIN_MEMORY";
+    case D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_TIME:
+        return "MIN_TIME";
+    case D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_OFFSET:
+        return "MIN_OFFSET";
+    default:
+        return "Unknown";
+    }
+}
+
+static const D3D12MA::VIRTUAL_BLOCK_FLAGS VIRTUAL_ALGORITHMS[] = {
+    D3D12MA::VIRTUAL_BLOCK_FLAG_NONE,
+    D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR,
+    D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY,
+};
+
+static const D3D12MA::VIRTUAL_ALLOCATION_FLAGS STRATEGIES[] = {
+    D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_MEMORY,
+    D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_TIME,
+    D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_OFFSET,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Virtual block workloads
+
+enum class WORKLOAD { FIXED, POWER_LAW, MIXED_ALIGNMENT, RING_BUFFER, POWER_OF_2, COUNT };
+static const char* WORKLOAD_NAMES[] = { "fixed", "power_law", "mixed_alignment", "ring_buffer", "power_of_2" };
+static_assert(sizeof(WORKLOAD_NAMES) / sizeof(WORKLOAD_NAMES[0]) == (size_t)WORKLOAD::COUNT, "");
+
+struct AllocationRequest
+{
+    UINT64 Size;
+    UINT64 Alignment;
+};
+
+static AllocationRequest GenerateRequest(WORKLOAD workload, RandomNumberGenerator& rand)
+{
+    switch(workload)
+    {
+    case WORKLOAD::FIXED:
+        return { 4096, 1 };
+    case WORKLOAD::POWER_LAW:
+    {
+        // Pareto distribution with alpha = 1.2: mostly small allocations with a heavy tail, clamped to 1 MiB.
+        const double minSize = 64.0;
+        const double size = minSize * pow(1.0 - rand.GenerateDouble(), -1.0 / 1.2);
+        return { (UINT64)std::min(size, 1024.0 * 1024.0), 1 };
+    }
+    case WORKLOAD::MIXED_ALIGNMENT:
+    {
+        static const UINT64 alignments[] = { 1, 16, 256, 4096, 65536 };
+        return { 256 + rand.Generate() % (64 * 1024), alignments[rand.Generate() % 5] };
+    }
+    case WORKLOAD::RING_BUFFER:
+        return { 256 + (rand.Generate() % 64) * 256, 256 };
+    case WORKLOAD::POWER_OF_2:
+    {
+        // Like pages of a virtual texture or descriptor tables: 4 KiB to 64 KiB, aligned to their size.
+        const UINT64 size = 4096ull << (rand.Generate() % 5);
+        return { size, size };
+    }
+    default:
+        CHECK_BOOL(0);
+        return {};
+    }
+}
+
+// Fraction of free space that is not in the largest free range: 0 = one contiguous free range.
+static double CalcFragmentation(D3D12MA::VirtualBlock* block, UINT64 blockSize)
+{
+    D3D12MA::DetailedStatistics stats;
+    block->CalculateStatistics(&stats);
+    const UINT64 freeBytes = blockSize - stats.Stats.AllocationBytes;
+    if(freeBytes == 0 || stats.UnusedRangeCount == 0)
+        return 0.0;
+    return 1.0 - (double)stats.UnusedRangeSizeMax / (double)freeBytes;
+}
+
+/*
+Runs a single workload on a new virtual block:
+
+1. Fill - allocate until the expected occupancy of the block is reached.
+2. Churn - free one allocation and make a new one, repeatedly. Random allocation is freed,
+   or the oldest one for the ring-buffer workload. Fragmentation is sampled periodically.
+3. Drain - free all remaining allocations.
+*/
+static void BenchmarkVirtualBlockWorkload(WORKLOAD workload,
+    D3D12MA::VIRTUAL_BLOCK_FLAGS algorithm,
+    D3D12MA::VIRTUAL_ALLOCATION_FLAGS strategy)
+{
+    const UINT64 blockSize = g_Config.Quick ? 16ull * 1024 * 1024 : 256ull * 1024 * 1024;
+    const double targetOccupancy = 0.6;
+    const size_t churnCount = g_Config.Quick ? 2000 : 200000;
+    const size_t fragmentationSampleCount = 16;
+
+    // Pre-generate requests so generation is not measured.
+    RandomNumberGenerator rand{ 20092010 + (uint32_t)workload };
+    std::vector<AllocationRequest> fillRequests;
+    UINT64 fillBytes = 0;
+    while(fillBytes < (UINT64)((double)blockSize * targetOccupancy))
+    {
+        fillRequests.push_back(GenerateRequest(workload, rand));
+        fillBytes += fillRequests.back().Size;
+    }
+    std::vector<AllocationRequest> churnRequests(churnCount);
+    std::vector<uint32_t> churnVictims(churnCount);
+    for(size_t i = 0; i < churnCount; ++i)
+    {
+        churnRequests[i] = GenerateRequest(workload, rand);
+        churnVictims[i] = rand.Generate();
+    }
+
+    CountingAllocationCallbacks callbacks;
+    D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+    blockDesc.Flags = algorithm;
+    blockDesc.Size = blockSize;
+    blockDesc.pAllocationCallbacks = callbacks.Get();
+    D3D12MA::VirtualBlock* block = NULL;
+    CHECK_HR(D3D12MA::CreateVirtualBlock(&blockDesc, &block));
+    const UINT64 emptyBlockCpuBytes = callbacks.GetCurrentBytes();
+
+    // Live allocations. For the ring buffer it is a FIFO starting at liveBegin.
+    std::vector<D3D12MA::VirtualAllocation> live;
+    live.reserve(fillRequests.size() + churnCount);
+    size_t liveBegin = 0;
+
+    LatencyRecorder allocLatencies, freeLatencies;
+    allocLatencies.Reserve(fillRequests.size() + churnCount);
+    freeLatencies.Reserve(fillRequests.size() + churnCount);
+    UINT64 totalOpNs = 0;
+    UINT64 failedAllocCount = 0;
+    UINT64 peakLiveCount = 0;
+    UINT64 peakMetadataBytes = 0;
+
+    auto doAllocate = [&](const AllocationRequest& req)
+    {
+        D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+        allocDesc.Size = req.Size;
+        allocDesc.Alignment = req.Alignment;
+        allocDesc.Flags = strategy;
+        D3D12MA::VirtualAllocation alloc;
+        const time_point beg = Now();
+        const HRESULT hr = block->Allocate(&allocDesc, &alloc, NULL);
+        const UINT64 ns = ElapsedNs(beg, Now());
+        allocLatencies.Add(ns);
+        totalOpNs += ns;
+        if(SUCCEEDED(hr))
+            live.push_back(alloc);
+        else
+            ++failedAllocCount;
+    };
+    auto doFree = [&](size_t index)
+    {
+        const time_point beg = Now();
+        block->FreeAllocation(live[index]);
+        const UINT64 ns = ElapsedNs(beg, Now());
+        freeLatencies.Add(ns);
+        totalOpNs += ns;
+    };
+    auto updatePeaks = [&]()
+    {
+        const UINT64 liveCount = live.size() - liveBegin;
+        if(liveCount > peakLiveCount)
+        {
+            peakLiveCount = liveCount;
+            peakMetadataBytes = callbacks.GetCurrentBytes() - emptyBlockCpuBytes;
+        }
+    };
+
+    // Fill
+    for(const AllocationRequest& req : fillRequests)
+        doAllocate(req);
+    updatePeaks();
+    const double fragmentationAfterFill = CalcFragmentation(block, blockSize);
+
+    // Churn
+    double fragmentationSum = 0.0;
+    double fragmentationMax = 0.0;
+    size_t fragmentationSamples = 0;
+    for(size_t i = 0; i < churnCount; ++i)
+    {
+        if(live.size() > liveBegin)
+        {
+            if(workload == WORKLOAD::RING_BUFFER)
+            {
+                doFree(liveBegin++);
+            }
+            else
+            {
+                const size_t index = liveBegin + churnVictims[i] % (live.size() - liveBegin);
+                doFree(index);
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+        doAllocate(churnRequests[i]);
+
+        if((i + 1) % (churnCount / fragmentationSampleCount) == 0)
+        {
+            updatePeaks();
+            const double fragmentation = CalcFragmentation(block, blockSize);
+            fragmentationSum += fragmentation;
+            fragmentationMax = std::max(fragmentationMax, fragmentation);
+            ++fragmentationSamples;
+        }
+    }
+    const double fragmentationFinal = CalcFragmentation(block, blockSize);
+
+    // Drain
+    for(size_t i = liveBegin; i < live.size(); ++i)
+        doFree(i);
+    CHECK_BOOL(block->IsEmpty());
+    block->Release();
+
+    const UINT64 opCount = allocLatencies.GetCount() + freeLatencies.GetCount();
+
+    BenchmarkResult result;
+    result.Benchmark = "VirtualBlockWorkload";
+    result.AddParameter("Algorithm", VirtualAlgorithmToStr(algorithm));
+    result.AddParameter("Strategy", StrategyToStr(strategy));
+    result.AddParameter("Workload", WORKLOAD_NAMES[(size_t)workload]);
+    result.AddMetric("Throughput", totalOpNs ? (double)opCount * 1e9 / (double)totalOpNs : 0.0, "ops/s");
+    allocLatencies.AddPercentileMetrics(result, "AllocLatency");
+    freeLatencies.AddPercentileMetrics(result, "FreeLatency");
+    result.AddMetric("FailedAllocations", (double)failedAllocCount, "count");
+    result.AddMetric("PeakLiveAllocations", (double)peakLiveCount, "count");
+    result.AddMetric("MetadataBytesPerAllocation",
+        peakLiveCount ? (double)peakMetadataBytes / (double)peakLiveCount : 0.0, "B");
+    result.AddMetric("FragmentationAfterFill", fragmentationAfterFill, "ratio");
+    result.AddMetric("FragmentationMean",
+        fragmentationSamples ? fragmentationSum / (double)fragmentationSamples : 0.0, "ratio");
+    result.AddMetric("FragmentationMax", fragmentationMax, "ratio");
+    result.AddMetric("FragmentationFinal", fragmentationFinal, "ratio");
+    g_Results.push_back(std::move(result));
+
+    Log("    Workload=%s Algorithm=%s Strategy=%s: %.3g Mops/s, failed %llu\n",
+        WORKLOAD_NAMES[(size_t)workload], VirtualAlgorithmToStr(algorithm), StrategyToStr(strategy),
+        totalOpNs ? (double)opCount * 1e3 / (double)totalOpNs : 0.0, (unsigned long long)failedAllocCount);
+}
+
+static void BenchmarkVirtualBlockWorkloads()
+{
+    if(!ShouldRun("VirtualBlockWorkload"))
+        return;
+    Log("Benchmark virtual block workloads\n");
+
+    for(size_t workloadIndex = 0; workloadIndex < (size_t)WORKLOAD::COUNT; ++workloadIndex)
+    {
+        for(D3D12MA::VIRTUAL_BLOCK_FLAGS algorithm : VIRTUAL_ALGORITHMS)
+        {
+            for(D3D12MA::VIRTUAL_ALLOCATION_FLAGS strategy : STRATEGIES)
+                BenchmarkVirtualBlockWorkload((WORKLOAD)workloadIndex, algorithm, strategy);
+        }
+    }
+}
+
+/*
+Many live allocations of the same size, freed in random order. Cost of internal
+bookkeeping of TLSF nodes grows with the number of live allocations here, not with
+the size distribution. Buddy algorithm is measured for comparison, on a block rounded
+up to a power of 2 as it uses only such part of it, and slab algorithm with slots of
+the allocation size.
+*/
+static void BenchmarkVirtualBlockManyAllocations()
+{
+    if(!ShouldRun("VirtualBlockManyAllocations"))
+        return;
+    Log("Benchmark virtual block many allocations\n");
+
+    const UINT64 allocSize = 256;
+    std::vector<size_t> liveCounts = { 1000, 10000, 100000 };
+    if(!g_Config.Quick)
+        liveCounts.push_back(1000000);
+
+    for(size_t liveCount : liveCounts)
+    {
+        for(D3D12MA::VIRTUAL_BLOCK_FLAGS algorithm : { D3D12MA::VIRTUAL_BLOCK_FLAG_NONE,
+            D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY, D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB })
+        {
+            RandomNumberGenerator rand{ 7310 };
+            std::vector<size_t> freeOrder(liveCount);
+            for(size_t i = 0; i < liveCount; ++i)
+                freeOrder[i] = i;
+            for(size_t i = liveCount - 1; i > 0; --i)
+                std::swap(freeOrder[i], freeOrder[rand.Generate() % (i + 1)]);
+
+            D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+            blockDesc.Flags = algorithm;
+            blockDesc.Size = allocSize * liveCount;
+            if(algorithm == D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY)
+            {
+                UINT64 pow2Size = 1;
+                while(pow2Size < blockDesc.Size)
+                    pow2Size *= 2;
+                blockDesc.Size = pow2Size;
+            }
+            else if(algorithm == D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB)
+                blockDesc.SlotSize = allocSize;
+            D3D12MA::VirtualBlock* block = NULL;
+            CHECK_HR(D3D12MA::CreateVirtualBlock(&blockDesc, &block));
+
+            D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+            allocDesc.Size = allocSize;
+            std::vector<D3D12MA::VirtualAllocation> allocs(liveCount);
+
+            // Two rounds: the first one also grows internal pools.
+            UINT64 allocNs[2] = {}, freeNs[2] = {};
+            for(UINT round = 0; round < 2; ++round)
+            {
+                time_point beg = Now();
+                for(size_t i = 0; i < liveCount; ++i)
+                    CHECK_HR(block->Allocate(&allocDesc, &allocs[i], NULL));
+                allocNs[round] = ElapsedNs(beg, Now());
+
+                beg = Now();
+                for(size_t i = 0; i < liveCount; ++i)
+                    block->FreeAllocation(allocs[freeOrder[i]]);
+                freeNs[round] = ElapsedNs(beg, Now());
+            }
+            block->Release();
+
+            BenchmarkResult result;
+            result.Benchmark = "VirtualBlockManyAllocations";
+            result.AddParameter("Algorithm", VirtualAlgorithmToStr(algorithm));
+            result.AddParameter("LiveAllocations", (UINT64)liveCount);
+            result.AddMetric("AllocFirstRound", (double)allocNs[0] / (double)liveCount, "ns/op");
+            result.AddMetric("FreeFirstRound", (double)freeNs[0] / (double)liveCount, "ns/op");
+            result.AddMetric("Alloc", (double)allocNs[1] / (double)liveCount, "ns/op");
+            result.AddMetric("Free", (double)freeNs[1] / (double)liveCount, "ns/op");
+            g_Results.push_back(std::move(result));
+
+            Log("    Algorithm=%s LiveAllocations=%zu: alloc %.1f ns/op, free %.1f ns/op\n",
+                VirtualAlgorithmToStr(algorithm), liveCount, (double)allocNs[1] / (double)liveCount, (double)freeNs[1] / (double)liveCount);
+        }
+    }
+}
+
+/*
+Requests of mixed alignments in a TLSF block with many small free ranges at offsets
+never aligned to 4 KB, like left by freed allocations of odd sizes, and only few large
+free ranges. Requests with large alignment fit only in the large ranges, so searching
+free lists by size alone visits all the unaligned small ones first.
+*/
+static void BenchmarkVirtualBlockMixedAlignment()
+{
+    if(!ShouldRun("VirtualBlockMixedAlignment"))
+        return;
+    Log("Benchmark virtual block mixed alignment\n");
+
+    // Every small free range is in its own 4 KB page, at offset 64 in it.
+    const UINT64 pageSize = 4096;
+    const UINT64 holeOffset = 64;
+    const UINT64 holeSize = 320;
+    const UINT64 largeRangeSize = 256 * 1024;
+    const size_t largeRangeCount = 4;
+    const size_t requestCount = g_Config.Quick ? 2000 : 100000;
+    std::vector<size_t> holeCounts = { 1000, 10000 };
+    if(g_Config.Quick)
+        holeCounts.pop_back();
+
+    for(size_t holeCount : holeCounts)
+    {
+        RandomNumberGenerator rand{ 4021 };
+        static const UINT64 alignments[] = { 1, 256, 4096, 65536 };
+        std::vector<AllocationRequest> requests(requestCount);
+        for(AllocationRequest& request : requests)
+            request = { 64 + rand.Generate() % 192, alignments[rand.Generate() % 4] };
+
+        for(D3D12MA::VIRTUAL_ALLOCATION_FLAGS strategy : { (D3D12MA::VIRTUAL_ALLOCATION_FLAGS)0,
+            D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_MEMORY, D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_TIME,
+            D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_OFFSET })
+        {
+            D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+            blockDesc.Size = holeCount * pageSize + largeRangeCount * (largeRangeSize + pageSize) + pageSize;
+            D3D12MA::VirtualBlock* block = NULL;
+            CHECK_HR(D3D12MA::CreateVirtualBlock(&blockDesc, &block));
+
+            // Fill the whole block with separators and ranges that are then freed.
+            D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+            std::vector<D3D12MA::VirtualAllocation> ranges;
+            D3D12MA::VirtualAllocation alloc;
+            for(size_t i = 0; i < holeCount + largeRangeCount; ++i)
+            {
+                const bool large = i >= holeCount;
+                allocDesc.Size = large ? pageSize : holeOffset;
+                CHECK_HR(block->Allocate(&allocDesc, &alloc, NULL));
+                allocDesc.Size = large ? largeRangeSize : holeSize;
+                CHECK_HR(block->Allocate(&allocDesc, &alloc, NULL));
+                ranges.push_back(alloc);
+                if(!large)
+                {
+                    allocDesc.Size = pageSize - holeOffset - holeSize;
+                    CHECK_HR(block->Allocate(&allocDesc, &alloc, NULL));
+                }
+            }
+            // No free space is left at the end, which would be found first.
+            allocDesc.Size = pageSize;
+            CHECK_HR(block->Allocate(&allocDesc, &alloc, NULL));
+            for(D3D12MA::VirtualAllocation range : ranges)
+                block->FreeAllocation(range);
+
+            UINT64 failedCount = 0;
+            const time_point beg = Now();
+            for(const AllocationRequest& request : requests)
+            {
+                allocDesc.Size = request.Size;
+                allocDesc.Alignment = request.Alignment;
+                allocDesc.Flags = strategy;
+                if(SUCCEEDED(block->Allocate(&allocDesc, &alloc, NULL)))
+                    block->FreeAllocation(alloc);
+                else
+                    ++failedCount;
+            }
+            const UINT64 totalNs = ElapsedNs(beg, Now());
+            block->Clear();
+            block->Release();
+
+            const char* const strategyName = strategy ? StrategyToStr(strategy) : "default";
+            BenchmarkResult result;
+            result.Benchmark = "VirtualBlockMixedAlignment";
+            result.AddParameter("Strategy", strategyName);
+            result.AddParameter("FreeRanges", (UINT64)(holeCount + largeRangeCount));
+            result.AddMetric("TimePerAllocFree", (double)totalNs / (double)requestCount, "ns");
+            result.AddMetric("Failed", (double)failedCount, "allocs");
+            g_Results.push_back(std::move(result));
+
+            Log("    Strategy=%s FreeRanges=%zu: %.1f ns/alloc+free, failed %llu\n", strategyName,
+                holeCount + largeRangeCount, (double)totalNs / (double)requestCount, (unsigned long long)failedCount);
+        }
+    }
+}
+
+// Thread counts 1, 2, 4... up to g_Config.MaxThreads.
+static std::vector<UINT> GetThreadCounts()
+{
+    std::vector<UINT> result;
+    for(UINT threadCount = 1; threadCount < g_Config.MaxThreads; threadCount *= 2)
+        result.push_back(threadCount);
+    result.push_back(g_Config.MaxThreads);
+    return result;
+}
+
+/*
+Every thread allocates and frees a batch of small allocations in a virtual block
+shared by all threads: either with VIRTUAL_BLOCK_FLAG_THREAD_SAFE or without it,
+guarded by a single external mutex.
+*/
+static void BenchmarkVirtualBlockMultithreaded()
+{
+    if(!ShouldRun("VirtualBlockMultithreaded"))
+        return;
+    Log("Benchmark virtual block multithreaded\n");
+
+    const UINT batchSize = 64;
+    const UINT iterationCount = g_Config.Quick ? 50 : 5000;
+
+    for(UINT threadCount : GetThreadCounts())
+    {
+        for(bool threadSafe : { false, true })
+        {
+            D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+            blockDesc.Size = 256ull * 1024 * 1024;
+            blockDesc.Flags = threadSafe ? D3D12MA::VIRTUAL_BLOCK_FLAG_THREAD_SAFE : D3D12MA::VIRTUAL_BLOCK_FLAG_NONE;
+            D3D12MA::VirtualBlock* block = NULL;
+            CHECK_HR(D3D12MA::CreateVirtualBlock(&blockDesc, &block));
+            std::mutex externalMutex;
+
+            std::atomic<UINT> readyCount{ 0 };
+            std::atomic<bool> start{ false };
+            std::vector<UINT64> threadNs(threadCount);
+            std::vector<std::thread> threads;
+            for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+            {
+                threads.emplace_back([&, threadIndex]()
+                {
+                    RandomNumberGenerator rand{ 4120 + threadIndex };
+                    D3D12MA::VirtualAllocation allocs[batchSize];
+
+                    ++readyCount;
+                    while(!start.load())
+                        std::this_thread::yield();
+
+                    const time_point beg = Now();
+                    for(UINT iter = 0; iter < iterationCount; ++iter)
+                    {
+                        for(UINT i = 0; i < batchSize; ++i)
+                        {
+                            D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+                            allocDesc.Size = 256 + rand.Generate() % 4096;
+                            if(threadSafe)
+                                CHECK_HR(block->Allocate(&allocDesc, &allocs[i], NULL));
+                            else
+                            {
+                                std::lock_guard<std::mutex> lock(externalMutex);
+                                CHECK_HR(block->Allocate(&allocDesc, &allocs[i], NULL));
+                            }
+                        }
+                        for(UINT i = 0; i < batchSize; ++i)
+                        {
+                            if(threadSafe)
+                                block->FreeAllocation(allocs[i]);
+                            else
+                            {
+                                std::lock_guard<std::mutex> lock(externalMutex);
+                                block->FreeAllocation(allocs[i]);
+                            }
+                        }
+                    }
+                    threadNs[threadIndex] = ElapsedNs(beg, Now());
+                });
+            }
+            while(readyCount.load() < threadCount)
+                std::this_thread::yield();
+            start = true;
+            for(std::thread& thread : threads)
+                thread.join();
+            block->Release();
+
+            const UINT64 maxThreadNs = *std::max_element(threadNs.begin(), threadNs.end());
+            const double opCount = (double)threadCount * iterationCount * batchSize * 2; // Allocate + free.
+            const double throughput = maxThreadNs ? opCount * 1e9 / (double)maxThreadNs : 0.0;
+
+            BenchmarkResult result;
+            result.Benchmark = "VirtualBlockMultithreaded";
+            result.AddParameter("Locking", threadSafe ? "THREAD_SAFE" : "external_mutex");
+            result.AddParameter("Threads", threadCount);
+            result.AddMetric("Throughput", throughput, "ops/s");
+            g_Results.push_back(std::move(result));
+
+            Log("    Locking=%s Threads=%u: %.3g Mops/s\n", threadSafe ? "THREAD_SAFE" : "external_mutex",
+                threadCount, throughput * 1e-6);
+        }
+    }
+}
+
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocator benchmarks on the mock device
+
+struct MockAllocatorContext
+{
+    MockDevice* Device = NULL;
+    MockAdapter* Adapter = NULL;
+    D3D12MA::Allocator* Allocator = NULL;
+
+    MockAllocatorContext(D3D12MA::ALLOCATOR_FLAGS flags = D3D12MA::ALLOCATOR_FLAG_NONE,
+        const D3D12MA::ALLOCATION_CALLBACKS* allocationCallbacks = NULL)
+    {
+        CHECK_HR(CreateMockDevice(NULL, &Device, &Adapter));
+        D3D12MA::ALLOCATOR_DESC allocatorDesc = {};
+        allocatorDesc.Flags = flags;
+        allocatorDesc.pAllocationCallbacks = allocationCallbacks;
+        allocatorDesc.pDevice = Device;
+        allocatorDesc.pAdapter = Adapter;
+        CHECK_HR(D3D12MA::CreateAllocator(&allocatorDesc, &Allocator));
+    }
+    ~MockAllocatorContext()
+    {
+        Allocator->Release();
+        Device->Release();
+        Adapter->Release();
+    }
+};
+
+/*
+Every thread repeatedly allocates and frees a batch of small allocations in its own
+custom pool, so threads don't share a block vector and what is shared is mostly
+creation and destruction of Allocation objects.
+*/
+static void BenchmarkAllocationObjectsMultithreaded()
+{
+    if(!ShouldRun("AllocationObjectsMultithreaded"))
+        return;
+    Log("Benchmark Allocation objects multithreaded\n");
+
+    const UINT batchSize = 64;
+    const UINT iterationCount = g_Config.Quick ? 50 : 5000;
+    double singleThreadThroughput = 0.0;
+
+    for(UINT threadCount : GetThreadCounts())
+    {
+        MockAllocatorContext ctx;
+
+        std::vector<D3D12MA::Pool*> pools(threadCount);
+        for(UINT i = 0; i < threadCount; ++i)
+        {
+            D3D12MA::POOL_DESC poolDesc = {};
+            poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+            poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            poolDesc.BlockSize = 16ull * 1024 * 1024;
+            poolDesc.MinBlockCount = 1;
+            CHECK_HR(ctx.Allocator->CreatePool(&poolDesc, &pools[i]));
+        }
+
+        std::atomic<UINT> readyCount{ 0 };
+        std::atomic<bool> start{ false };
+        std::vector<UINT64> threadNs(threadCount);
+        std::vector<LatencyRecorder> threadLatencies(threadCount);
+        std::vector<std::thread> threads;
+        for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        {
+            threads.emplace_back([&, threadIndex]()
+            {
+                D3D12MA::ALLOCATION_DESC allocDesc = {};
+                allocDesc.CustomPool = pools[threadIndex];
+                const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 256, 256 };
+                D3D12MA::Allocation* allocs[batchSize];
+                LatencyRecorder& latencies = threadLatencies[threadIndex];
+                latencies.Reserve((size_t)iterationCount * batchSize);
+
+                ++readyCount;
+                while(!start.load())
+                    std::this_thread::yield();
+
+                const time_point beg = Now();
+                for(UINT iter = 0; iter < iterationCount; ++iter)
+                {
+                    for(UINT i = 0; i < batchSize; ++i)
+                    {
+                        const time_point allocBeg = Now();
+                        CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]));
+                        latencies.Add(ElapsedNs(allocBeg, Now()));
+                    }
+                    for(UINT i = 0; i < batchSize; ++i)
+                        allocs[i]->Release();
+                }
+                threadNs[threadIndex] = ElapsedNs(beg, Now());
+            });
+        }
+        while(readyCount.load() < threadCount)
+            std::this_thread::yield();
+        start = true;
+        for(std::thread& thread : threads)
+            thread.join();
+
+        for(D3D12MA::Pool* pool : pools)
+            pool->Release();
+
+        UINT64 maxThreadNs = 0;
+        LatencyRecorder allLatencies;
+        for(UINT i = 0; i < threadCount; ++i)
+        {
+            maxThreadNs = std::max(maxThreadNs, threadNs[i]);
+            allLatencies.Append(threadLatencies[i]);
+        }
+        const double opCount = (double)threadCount * iterationCount * batchSize * 2; // Allocate + free.
+        const double throughput = maxThreadNs ? opCount * 1e9 / (double)maxThreadNs : 0.0;
+        if(threadCount == 1)
+            singleThreadThroughput = throughput;
+
+        BenchmarkResult result;
+        result.Benchmark = "AllocationObjectsMultithreaded";
+        result.AddParameter("Threads", threadCount);
+        result.AddMetric("Throughput", throughput, "ops/s");
+        result.AddMetric("ScalingEfficiency",
+            singleThreadThroughput > 0.0 ? throughput / (singleThreadThroughput * threadCount) : 0.0, "ratio");
+        allLatencies.AddPercentileMetrics(result, "AllocLatency");
+        g_Results.push_back(std::move(result));
+
+        Log("    Threads=%u: %.3g Mops/s\n", threadCount, throughput * 1e-6);
+    }
+}
+
+/*
+Every thread allocates and frees a single allocation at a time in its own pool, so that
+the only state shared between threads is the allocator's budget counters, updated on
+every call and read by every allocation, and by GetBudget called now and then.
+*/
+static void BenchmarkBudgetCountersMultithreaded()
+{
+    if(!ShouldRun("BudgetCountersMultithreaded"))
+        return;
+    Log("Benchmark budget counters multithreaded\n");
+
+    const UINT iterationCount = g_Config.Quick ? 5000 : 500000;
+    const UINT budgetQueryPeriod = 64;
+    double singleThreadThroughput = 0.0;
+
+    for(UINT threadCount : GetThreadCounts())
+    {
+        MockAllocatorContext ctx;
+
+        std::vector<D3D12MA::Pool*> pools(threadCount);
+        for(UINT i = 0; i < threadCount; ++i)
+        {
+            D3D12MA::POOL_DESC poolDesc = {};
+            poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+            poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            poolDesc.BlockSize = 16ull * 1024 * 1024;
+            poolDesc.MinBlockCount = 1;
+            CHECK_HR(ctx.Allocator->CreatePool(&poolDesc, &pools[i]));
+        }
+
+        std::atomic<UINT> readyCount{ 0 };
+        std::atomic<bool> start{ false };
+        std::vector<UINT64> threadNs(threadCount);
+        std::vector<std::thread> threads;
+        for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        {
+            threads.emplace_back([&, threadIndex]()
+            {
+                D3D12MA::ALLOCATION_DESC allocDesc = {};
+                allocDesc.CustomPool = pools[threadIndex];
+                const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 256, 256 };
+
+                ++readyCount;
+                while(!start.load())
+                    std::this_thread::yield();
+
+                const time_point beg = Now();
+                for(UINT iter = 0; iter < iterationCount; ++iter)
+                {
+                    D3D12MA::Allocation* alloc = NULL;
+                    CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc));
+                    alloc->Release();
+                    if(iter % budgetQueryPeriod == 0)
+                    {
+                        D3D12MA::Budget localBudget = {};
+                        ctx.Allocator->GetBudget(&localBudget, NULL);
+                    }
+                }
+                threadNs[threadIndex] = ElapsedNs(beg, Now());
+            });
+        }
+        while(readyCount.load() < threadCount)
+            std::this_thread::yield();
+        start = true;
+        for(std::thread& thread : threads)
+            thread.join();
+
+        D3D12MA::Budget localBudget = {};
+        ctx.Allocator->GetBudget(&localBudget, NULL);
+        CHECK_BOOL(localBudget.Stats.AllocationCount == 0);
+        CHECK_BOOL(localBudget.Stats.BlockCount == threadCount);
+
+        for(D3D12MA::Pool* pool : pools)
+            pool->Release();
+
+        UINT64 maxThreadNs = 0;
+        for(UINT i = 0; i < threadCount; ++i)
+            maxThreadNs = std::max(maxThreadNs, threadNs[i]);
+        const double opCount = (double)threadCount * iterationCount * 2; // Allocate + free.
+        const double throughput = maxThreadNs ? opCount * 1e9 / (double)maxThreadNs : 0.0;
+        if(threadCount == 1)
+            singleThreadThroughput = throughput;
+
+        BenchmarkResult result;
+        result.Benchmark = "BudgetCountersMultithreaded";
+        result.AddParameter("Threads", threadCount);
+        result.AddMetric("Throughput", throughput, "ops/s");
+        result.AddMetric("ScalingEfficiency",
+            singleThreadThroughput > 0.0 ? throughput / (singleThreadThroughput * threadCount) : 0.0, "ratio");
+        g_Results.push_back(std::move(result));
+
+        Log("    Threads=%u: %.3g Mops/s\n", threadCount, throughput * 1e-6);
+    }
+}
+
+/*
+Latency of allocating and freeing when QueryVideoMemoryInfo is slow, with the budget
+refreshed on the allocating thread (default), only explicitly, or by the library thread.
+*/
+static void BenchmarkBudgetUpdate()
+{
+    if(!ShouldRun("BudgetUpdate"))
+        return;
+    Log("Benchmark budget update\n");
+
+    const UINT64 queryLatencyNs = 20000;
+    const UINT iterationCount = g_Config.Quick ? 3000 : 300000;
+    const struct
+    {
+        const char* Name;
+        D3D12MA::ALLOCATOR_FLAGS Flags;
+    } modes[] = {
+        { "OnAllocation", D3D12MA::ALLOCATOR_FLAG_NONE },
+        { "Manual", D3D12MA::ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE },
+        { "Background", D3D12MA::ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE },
+    };
+
+    for(const auto& mode : modes)
+    {
+        MockAllocatorContext ctx(mode.Flags);
+        MOCK_OPERATION_DESC opDesc = {};
+        opDesc.LatencyNanoseconds = queryLatencyNs;
+        ctx.Adapter->SetOperationDesc(MOCK_OPERATION_QUERY_VIDEO_MEMORY_INFO, opDesc);
+
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+        LatencyRecorder latencies;
+        latencies.Reserve(iterationCount);
+        for(UINT iter = 0; iter < iterationCount; ++iter)
+        {
+            D3D12MA::Allocation* alloc = NULL;
+            const time_point beg = Now();
+            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc));
+            alloc->Release();
+            latencies.Add(ElapsedNs(beg, Now()));
+        }
+
+        BenchmarkResult result;
+        result.Benchmark = "BudgetUpdate";
+        result.AddParameter("Mode", mode.Name);
+        latencies.AddPercentileMetrics(result, "AllocFreeLatency");
+        Log("    Mode=%s: p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns\n", mode.Name,
+            result.Metrics[0].Value, result.Metrics[1].Value, result.Metrics[2].Value);
+        g_Results.push_back(std::move(result));
+    }
+}
+
+static void BenchmarkLockFreeStatistics()
+{
+    if(!ShouldRun("LockFreeStatistics"))
+        return;
+    Log("Benchmark lock-free statistics\n");
+
+    const UINT liveAllocationCount = g_Config.Quick ? 2000 : 100000;
+    const UINT readCount = g_Config.Quick ? 100 : 1000;
+    const UINT iterationCount = g_Config.Quick ? 5000 : 200000;
+    const struct
+    {
+        const char* Name;
+        D3D12MA::ALLOCATOR_FLAGS Flags;
+    } modes[] = {
+        { "Locked", D3D12MA::ALLOCATOR_FLAG_NONE },
+        { "LockFree", D3D12MA::ALLOCATOR_FLAG_LOCK_FREE_STATISTICS },
+    };
+
+    for(const auto& mode : modes)
+    {
+        MockAllocatorContext ctx(mode.Flags);
+
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        std::vector<D3D12MA::Allocation*> allocs(liveAllocationCount);
+        for(UINT i = 0; i < liveAllocationCount; ++i)
+        {
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 4096ull << (i % 5), 4096 };
+            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]));
+        }
+        // Free every third allocation to leave unused ranges between them.
+        for(UINT i = 0; i < liveAllocationCount; i += 3)
+        {
+            allocs[i]->Release();
+            allocs[i] = NULL;
+        }
+
+        LatencyRecorder readLatencies;
+        readLatencies.Reserve(readCount);
+        for(UINT i = 0; i < readCount; ++i)
+        {
+            D3D12MA::TotalStatistics stats;
+            const time_point beg = Now();
+            ctx.Allocator->CalculateStatistics(&stats);
+            readLatencies.Add(ElapsedNs(beg, Now()));
+        }
+
+        // Allocation latency while a telemetry thread reads statistics continuously.
+        std::atomic<bool> stop{ false };
+        std::atomic<UINT64> telemetryReadCount{ 0 };
+        std::thread telemetry([&]()
+        {
+            while(!stop)
+            {
+                D3D12MA::TotalStatistics stats;
+                ctx.Allocator->CalculateStatistics(&stats);
+                ++telemetryReadCount;
+            }
+        });
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+        LatencyRecorder allocLatencies;
+        allocLatencies.Reserve(iterationCount);
+        const time_point allocBeg = Now();
+        for(UINT iter = 0; iter < iterationCount; ++iter)
+        {
+            D3D12MA::Allocation* alloc = NULL;
+            const time_point beg = Now();
+            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc));
+            alloc->Release();
+            allocLatencies.Add(ElapsedNs(beg, Now()));
+        }
+        const double allocSeconds = ElapsedNs(allocBeg, Now()) * 1e-9;
+        stop = true;
+        telemetry.join();
+
+        for(D3D12MA::Allocation* alloc : allocs)
+        {
+            if(alloc != NULL)
+                alloc->Release();
+        }
+
+        BenchmarkResult result;
+        result.Benchmark = "LockFreeStatistics";
+        result.AddParameter("Mode", mode.Name);
+        result.AddParameter("LiveAllocations", liveAllocationCount);
+        readLatencies.AddPercentileMetrics(result, "CalculateStatisticsLatency");
+        allocLatencies.AddPercentileMetrics(result, "AllocFreeLatencyWithTelemetry");
+        result.AddMetric("TelemetryReadsPerSecond", telemetryReadCount / allocSeconds, "1/s");
+        Log("    Mode=%s: CalculateStatistics p50 %.0f ns, alloc+free with telemetry p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns\n",
+            mode.Name, result.Metrics[0].Value, result.Metrics[3].Value, result.Metrics[4].Value, result.Metrics[5].Value);
+        g_Results.push_back(std::move(result));
+    }
+}
+
+/*
+Dumps the detailed map of an allocator with many named allocations, either built
+in memory by BuildStatsString or streamed by WriteStatsString to a callback
+that only counts the bytes, measuring time and peak CPU memory used by the library.
+*/
+static void BenchmarkStatsString()
+{
+    if(!ShouldRun("StatsString"))
+        return;
+    Log("Benchmark stats string\n");
+
+    const UINT allocationCount = g_Config.Quick ? 2000 : 200000;
+    CountingAllocationCallbacks callbacks;
+    MockAllocatorContext ctx(D3D12MA::ALLOCATOR_FLAG_NONE, callbacks.Get());
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 4096, 4096 };
+    std::vector<D3D12MA::Allocation*> allocs(allocationCount);
+    for(UINT i = 0; i < allocationCount; ++i)
+    {
+        CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]));
+        allocs[i]->SetName(L"Streaming texture");
+    }
+
+    const struct
+    {
+        const char* Name;
+        bool Stream;
+        bool Binary;
+        D3D12MA::STATS_STRING_ENCODING Encoding;
+    } modes[] = {
+        { "BuildStatsString", false, false, D3D12MA::STATS_STRING_ENCODING_UTF16 },
+        { "WriteStatsStringUTF16", true, false, D3D12MA::STATS_STRING_ENCODING_UTF16 },
+        { "WriteStatsStringUTF8", true, false, D3D12MA::STATS_STRING_ENCODING_UTF8 },
+        { "WriteStatsBinary", true, true, D3D12MA::STATS_STRING_ENCODING_UTF8 },
+    };
+    for(const auto& mode : modes)
+    {
+        UINT64 outputBytes = 0;
+        callbacks.ResetPeakBytes();
+        const UINT64 baseBytes = callbacks.GetCurrentBytes();
+        const time_point beg = Now();
+        const D3D12MA::WRITE_STATS_STRING_FUNC_PTR countBytes = [](const void*, size_t byteCount, void* privateData)
+        {
+            *(UINT64*)privateData += byteCount;
+        };
+        if(mode.Binary)
+            ctx.Allocator->WriteStatsBinary(countBytes, &outputBytes, TRUE);
+        else if(mode.Stream)
+            ctx.Allocator->WriteStatsString(countBytes, &outputBytes, mode.Encoding, TRUE);
+        else
+        {
+            WCHAR* str = NULL;
+            ctx.Allocator->BuildStatsString(&str, TRUE);
+            outputBytes = wcslen(str) * 2; // As UTF-16.
+            ctx.Allocator->FreeStatsString(str);
+        }
+        const double seconds = ElapsedNs(beg, Now()) * 1e-9;
+
+        BenchmarkResult result;
+        result.Benchmark = "StatsString";
+        result.AddParameter("Mode", mode.Name);
+        result.AddParameter("AllocationCount", allocationCount);
+        result.AddMetric("Time", seconds * 1e3, "ms");
+        result.AddMetric("OutputBytes", (double)outputBytes, "B");
+        result.AddMetric("PeakCpuBytes", (double)(callbacks.GetPeakBytes() - baseBytes), "B");
+        Log("    Mode=%s: %.1f ms, output %.1f MB, peak CPU memory %.1f MB\n", mode.Name,
+            result.Metrics[0].Value, result.Metrics[1].Value / 1048576.0, result.Metrics[2].Value / 1048576.0);
+        g_Results.push_back(std::move(result));
+    }
+
+    for(D3D12MA::Allocation* alloc : allocs)
+        alloc->Release();
+}
+
+static void BenchmarkSnapshotDelta()
+{
+    if(!ShouldRun("SnapshotDelta"))
+        return;
+    Log("Benchmark snapshot delta\n");
+
+    const UINT allocationCount = g_Config.Quick ? 2000 : 200000;
+    // Every changeInterval-th allocation is freed and replaced between the snapshots.
+    const UINT changeInterval = 100;
+    MockAllocatorContext ctx(D3D12MA::ALLOCATOR_FLAG_NONE, NULL);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 4096, 4096 };
+    std::vector<D3D12MA::Allocation*> allocs(allocationCount);
+    for(UINT i = 0; i < allocationCount; ++i)
+    {
+        CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]));
+        allocs[i]->SetName(L"Streaming texture");
+    }
+
+    D3D12MA::Snapshot* prevSnapshot = NULL;
+    CHECK_HR(ctx.Allocator->CreateSnapshot(&prevSnapshot));
+    for(UINT i = 0; i < allocationCount; i += changeInterval)
+    {
+        allocs[i]->Release();
+        CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]));
+    }
+
+    const D3D12MA::WRITE_STATS_STRING_FUNC_PTR countBytes = [](const void*, size_t byteCount, void* privateData)
+    {
+        *(UINT64*)privateData += byteCount;
+    };
+    const auto addResult = [&](const char* mode, double seconds, UINT64 outputBytes)
+    {
+        BenchmarkResult result;
+        result.Benchmark = "SnapshotDelta";
+        result.AddParameter("Mode", mode);
+        result.AddParameter("AllocationCount", allocationCount);
+        result.AddParameter("ChangedAllocationCount", (allocationCount + changeInterval - 1) / changeInterval);
+        result.AddMetric("Time", seconds * 1e3, "ms");
+        result.AddMetric("OutputBytes", (double)outputBytes, "B");
+        Log("    Mode=%s: %.2f ms, output %.1f KB\n", mode, result.Metrics[0].Value, result.Metrics[1].Value / 1024.0);
+        g_Results.push_back(std::move(result));
+    };
+
+    UINT64 dumpBytes = 0;
+    time_point beg = Now();
+    ctx.Allocator->WriteStatsBinary(countBytes, &dumpBytes, TRUE);
+    addResult("WriteStatsBinary", ElapsedNs(beg, Now()) * 1e-9, dumpBytes);
+
+    D3D12MA::Snapshot* snapshot = NULL;
+    beg = Now();
+    CHECK_HR(ctx.Allocator->CreateSnapshot(&snapshot));
+    addResult("CreateSnapshot", ElapsedNs(beg, Now()) * 1e-9, 0);
+
+    UINT64 deltaBytes = 0;
+    beg = Now();
+    snapshot->WriteChanges(prevSnapshot, countBytes, &deltaBytes);
+    addResult("WriteChanges", ElapsedNs(beg, Now()) * 1e-9, deltaBytes);
+
+    snapshot->Release();
+    prevSnapshot->Release();
+    for(D3D12MA::Allocation* alloc : allocs)
+        alloc->Release();
+}
+
+/*
+Cost of ALLOCATOR_FLAG_TRACE_EVENTS: every thread allocates and frees in its own
+custom pool, so what threads share with the flag is mostly the trace ring.
+*/
+// Measures the cost of allocation and free on private pools with and without an instrumenting allocator flag.
+static void BenchmarkInstrumentationOverhead(const char* benchmarkName, const char* parameterName, D3D12MA::ALLOCATOR_FLAGS flag)
+{
+    const UINT batchSize = 64;
+    const UINT iterationCount = g_Config.Quick ? 50 : 5000;
+
+    for(UINT threadCount : GetThreadCounts())
+    {
+        for(UINT enabled = 0; enabled < 2; ++enabled)
+        {
+            MockAllocatorContext ctx(enabled ? flag : D3D12MA::ALLOCATOR_FLAG_NONE);
+
+            std::vector<D3D12MA::Pool*> pools(threadCount);
+            for(UINT i = 0; i < threadCount; ++i)
+            {
+                D3D12MA::POOL_DESC poolDesc = {};
+                poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+                poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+                poolDesc.BlockSize = 16ull * 1024 * 1024;
+                poolDesc.MinBlockCount = 1;
+                CHECK_HR(ctx.Allocator->CreatePool(&poolDesc, &pools[i]));
+            }
+
+            std::atomic<UINT> readyCount{ 0 };
+            std::atomic<bool> start{ false };
+            std::vector<UINT64> threadNs(threadCount);
+            std::vector<std::thread> threads;
+            for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+            {
+                threads.emplace_back([&, threadIndex]()
+                {
+                    D3D12MA::ALLOCATION_DESC allocDesc = {};
+                    allocDesc.CustomPool = pools[threadIndex];
+                    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 256, 256 };
+                    D3D12MA::Allocation* allocs[batchSize];
+
+                    ++readyCount;
+                    while(!start.load())
+                        std::this_thread::yield();
+
+                    const time_point beg = Now();
+                    for(UINT iter = 0; iter < iterationCount; ++iter)
+                    {
+                        for(UINT i = 0; i < batchSize; ++i)
+                            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]));
+                        for(UINT i = 0; i < batchSize; ++i)
+                            allocs[i]->Release();
+                    }
+                    threadNs[threadIndex] = ElapsedNs(beg, Now());
+                });
+            }
+            while(readyCount.load() < threadCount)
+                std::this_thread::yield();
+            start = true;
+            for(std::thread& thread : threads)
+                thread.join();
+
+            for(D3D12MA::Pool* pool : pools)
+                pool->Release();
+
+            UINT64 totalNs = 0;
+            for(UINT64 ns : threadNs)
+                totalNs += ns;
+            const double nsPerPair = (double)totalNs / ((double)threadCount * iterationCount * batchSize);
+
+            BenchmarkResult result;
+            result.Benchmark = benchmarkName;
+            result.AddParameter(parameterName, enabled ? "On" : "Off");
+            result.AddParameter("Threads", threadCount);
+            result.AddMetric("AllocFreeLatency", nsPerPair, "ns");
+            g_Results.push_back(std::move(result));
+
+            Log("    %s=%s Threads=%u: %.1f ns per allocation and free\n", parameterName, enabled ? "On" : "Off", threadCount, nsPerPair);
+        }
+    }
+}
+
+static void BenchmarkTraceEvents()
+{
+    if(!ShouldRun("TraceEvents"))
+        return;
+    Log("Benchmark trace events\n");
+    BenchmarkInstrumentationOverhead("TraceEvents", "Trace", D3D12MA::ALLOCATOR_FLAG_TRACE_EVENTS);
+}
+
+static void BenchmarkPerformanceCounters()
+{
+    if(!ShouldRun("PerformanceCounters"))
+        return;
+    Log("Benchmark performance counters\n");
+    BenchmarkInstrumentationOverhead("PerformanceCounters", "Counters", D3D12MA::ALLOCATOR_FLAG_PERFORMANCE_COUNTERS);
+}
+
+static void BenchmarkBatchAllocation()
+{
+    if(!ShouldRun("BatchAllocation"))
+        return;
+    Log("Benchmark batch allocation\n");
+
+    const UINT BATCH_SIZES[] = { 16, 256, 4096 };
+    const UINT64 totalAllocationCount = g_Config.Quick ? 4096 : 262144;
+
+    for(UINT createResources = 0; createResources < 2; ++createResources)
+    {
+        const char* const operation = createResources ? "CreateResource" : "AllocateMemory";
+        for(UINT batchSize : BATCH_SIZES)
+        {
+            std::vector<D3D12MA::ALLOCATION_DESC> allocDescs(batchSize);
+            std::vector<D3D12_RESOURCE_ALLOCATION_INFO> allocInfos(batchSize);
+            std::vector<D3D12_RESOURCE_DESC> resDescs(batchSize);
+            std::vector<D3D12_RESOURCE_STATES> states(batchSize, D3D12_RESOURCE_STATE_COMMON);
+            std::vector<D3D12MA::Allocation*> allocs(batchSize);
+            for(UINT i = 0; i < batchSize; ++i)
+            {
+                const UINT64 size = 4096ull << (i % 4);
+                allocDescs[i] = {};
+                allocDescs[i].HeapType = (i % 8 == 7) ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+                allocDescs[i].ExtraHeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+                allocInfos[i] = { size, 4096 };
+
+                D3D12_RESOURCE_DESC& resDesc = resDescs[i];
+                resDesc = {};
+                resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+                resDesc.Width = size;
+                resDesc.Height = 1;
+                resDesc.DepthOrArraySize = 1;
+                resDesc.MipLevels = 1;
+                resDesc.Format = DXGI_FORMAT_UNKNOWN;
+                resDesc.SampleDesc.Count = 1;
+                resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            }
+            const UINT iterationCount = (UINT)std::max<UINT64>(totalAllocationCount / batchSize, 1);
+
+            for(UINT useBatch = 0; useBatch < 2; ++useBatch)
+            {
+                MockAllocatorContext ctx;
+                UINT64 allocNs = 0;
+                UINT64 freeNs = 0;
+                for(UINT iter = 0; iter < iterationCount; ++iter)
+                {
+                    const time_point beg = Now();
+                    if(useBatch && createResources)
+                    {
+                        CHECK_HR(ctx.Allocator->CreateResourceBatch(batchSize, allocDescs.data(), resDescs.data(),
+                            states.data(), NULL, allocs.data()));
+                    }
+                    else if(useBatch)
+                    {
+                        CHECK_HR(ctx.Allocator->AllocateMemoryBatch(batchSize, allocDescs.data(), allocInfos.data(),
+                            allocs.data()));
+                    }
+                    else
+                    {
+                        for(UINT i = 0; i < batchSize; ++i)
+                        {
+                            if(createResources)
+                            {
+                                CHECK_HR(ctx.Allocator->CreateResource(&allocDescs[i], &resDescs[i], states[i],
+                                    NULL, &allocs[i], IID_NULL, NULL));
+                            }
+                            else
+                                CHECK_HR(ctx.Allocator->AllocateMemory(&allocDescs[i], &allocInfos[i], &allocs[i]));
+                        }
+                    }
+                    const time_point freeBeg = Now();
+                    allocNs += ElapsedNs(beg, freeBeg);
+                    if(useBatch)
+                        ctx.Allocator->FreeAllocations(batchSize, allocs.data());
+                    else
+                    {
+                        for(UINT i = 0; i < batchSize; ++i)
+                            allocs[i]->Release();
+                    }
+                    freeNs += ElapsedNs(freeBeg, Now());
+                }
+
+                const double allocCount = (double)iterationCount * batchSize;
+                BenchmarkResult result;
+                result.Benchmark = "BatchAllocation";
+                result.AddParameter("Operation", operation);
+                result.AddParameter("BatchSize", batchSize);
+                result.AddParameter("Mode", useBatch ? "batch" : "single");
+                result.AddMetric("TimePerAllocation", (double)allocNs / allocCount, "ns");
+                result.AddMetric("Throughput", allocNs ? allocCount * 1e9 / (double)allocNs : 0.0, "allocs/s");
+                result.AddMetric("TimePerFree", (double)freeNs / allocCount, "ns");
+                g_Results.push_back(std::move(result));
+
+                Log("    Operation=%s BatchSize=%u Mode=%s: %.1f ns/allocation, %.1f ns/free\n", operation, batchSize,
+                    useBatch ? "batch" : "single", (double)allocNs / allocCount, (double)freeNs / allocCount);
+            }
+        }
+    }
+}
+
+/*
+Textures of a limited set of shapes are created and released over and over, like in
+texture streaming, with and without ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO.
+GetResourceAllocationInfo of the mock device is given a latency simulating the driver.
+*/
+static void BenchmarkResourceAllocationInfoCache()
+{
+    if(!ShouldRun("ResourceAllocationInfoCache"))
+        return;
+    Log("Benchmark resource allocation info cache\n");
+
+    const UINT shapeCount = 64;
+    const UINT createCount = g_Config.Quick ? 4096 : 65536;
+    const UINT64 driverLatencyNs = 1000;
+
+    std::vector<D3D12_RESOURCE_DESC> resDescs(shapeCount);
+    for(UINT i = 0; i < shapeCount; ++i)
+    {
+        D3D12_RESOURCE_DESC& resDesc = resDescs[i];
+        resDesc = {};
+        resDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        resDesc.Width = 64u << (i % 4);
+        resDesc.Height = 64u << (i / 4 % 4);
+        resDesc.DepthOrArraySize = 1;
+        resDesc.MipLevels = 1;
+        resDesc.Format = (i / 16 % 2) ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+        resDesc.SampleDesc.Count = 1;
+        resDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        resDesc.Flags = (i / 32 % 2) ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+    }
+
+    for(UINT useCache = 0; useCache < 2; ++useCache)
+    {
+        MockAllocatorContext ctx(useCache ?
+            D3D12MA::ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO : D3D12MA::ALLOCATOR_FLAG_NONE);
+        MOCK_OPERATION_DESC opDesc = {};
+        opDesc.LatencyNanoseconds = driverLatencyNs;
+        ctx.Device->SetOperationDesc(MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO, opDesc);
+        ctx.Device->ResetCallCounts();
+
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        UINT64 createNs = 0;
+        for(UINT i = 0; i < createCount; ++i)
+        {
+            D3D12MA::Allocation* alloc = NULL;
+            const time_point beg = Now();
+            CHECK_HR(ctx.Allocator->CreateResource(&allocDesc, &resDescs[i % shapeCount], D3D12_RESOURCE_STATE_COMMON,
+                NULL, &alloc, IID_NULL, NULL));
+            createNs += ElapsedNs(beg, Now());
+            alloc->Release();
+        }
+        const double driverCallsPerCreate =
+            (double)ctx.Device->GetCallCount(MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO) / createCount;
+
+        BenchmarkResult result;
+        result.Benchmark = "ResourceAllocationInfoCache";
+        result.AddParameter("Cache", useCache ? "on" : "off");
+        result.AddParameter("Shapes", shapeCount);
+        result.AddParameter("DriverLatency", driverLatencyNs);
+        result.AddMetric("TimePerCreate", (double)createNs / createCount, "ns");
+        result.AddMetric("DriverCallsPerCreate", driverCallsPerCreate, "calls");
+        g_Results.push_back(std::move(result));
+
+        Log("    Cache=%s: %.1f ns/create, %.3f driver calls/create\n", useCache ? "on" : "off",
+            (double)createNs / createCount, driverCallsPerCreate);
+    }
+}
+
+/*
+A custom pool with hundreds of blocks, each with only a small free gap except one.
+Allocations that fit only in that one block measure how long it takes to find it.
+*/
+static void BenchmarkPoolManyBlocks()
+{
+    if(!ShouldRun("PoolManyBlocks"))
+        return;
+    Log("Benchmark pool with many blocks\n");
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 smallSize = 64 * 1024;
+    const UINT64 largeSize = 256 * 1024;
+    const UINT smallPerBlock = (UINT)(blockSize / smallSize);
+    const UINT iterationCount = g_Config.Quick ? 1000 : 100000;
+    std::vector<UINT> blockCounts = { 64, 512 };
+    if(!g_Config.Quick)
+        blockCounts.push_back(2048);
+
+    for(UINT blockCount : blockCounts)
+    {
+        MockAllocatorContext ctx;
+        D3D12MA::POOL_DESC poolDesc = {};
+        poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        poolDesc.BlockSize = blockSize;
+        D3D12MA::Pool* pool = NULL;
+        CHECK_HR(ctx.Allocator->CreatePool(&poolDesc, &pool));
+
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.CustomPool = pool;
+        const D3D12_RESOURCE_ALLOCATION_INFO smallInfo = { smallSize, smallSize };
+        std::vector<D3D12MA::Allocation*> allocs((size_t)blockCount * smallPerBlock);
+        for(D3D12MA::Allocation*& alloc : allocs)
+            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &smallInfo, &alloc));
+        // One small gap per block, except for a single block with half of it free.
+        const size_t roomyBlock = blockCount / 2;
+        for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+        {
+            const UINT freeCount = blockIndex == roomyBlock ? smallPerBlock / 2 : 1;
+            for(UINT i = 0; i < freeCount; ++i)
+            {
+                D3D12MA::Allocation*& alloc = allocs[blockIndex * smallPerBlock + i];
+                alloc->Release();
+                alloc = NULL;
+            }
+        }
+
+        const D3D12_RESOURCE_ALLOCATION_INFO largeInfo = { largeSize, smallSize };
+        UINT64 allocNs = 0;
+        for(UINT iter = 0; iter < iterationCount; ++iter)
+        {
+            D3D12MA::Allocation* alloc = NULL;
+            const time_point beg = Now();
+            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &largeInfo, &alloc));
+            allocNs += ElapsedNs(beg, Now());
+            alloc->Release();
+        }
+        D3D12MA::Statistics stats = {};
+        pool->GetStatistics(&stats);
+        CHECK_BOOL(stats.BlockCount == blockCount);
+
+        for(D3D12MA::Allocation* alloc : allocs)
+        {
+            if(alloc != NULL)
+                alloc->Release();
+        }
+        pool->Release();
+
+        BenchmarkResult result;
+        result.Benchmark = "PoolManyBlocks";
+        result.AddParameter("Blocks", blockCount);
+        result.AddMetric("AllocLatency", (double)allocNs / iterationCount, "ns");
+        g_Results.push_back(std::move(result));
+
+        Log("    Blocks=%u: %.1f ns/allocation\n", blockCount, (double)allocNs / iterationCount);
+    }
+}
+
+static void BenchmarkPoolFragmentedBlocks()
+{
+    if(!ShouldRun("PoolFragmentedBlocks"))
+        return;
+    Log("Benchmark pool with fragmented blocks\n");
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 smallSize = 64 * 1024;
+    const UINT64 largeSize = 256 * 1024;
+    const UINT smallPerBlock = (UINT)(blockSize / smallSize);
+    const UINT largePerSmall = (UINT)(largeSize / smallSize);
+    const UINT iterationCount = g_Config.Quick ? 1000 : 100000;
+    std::vector<UINT> blockCounts = { 64, 512 };
+    if(!g_Config.Quick)
+        blockCounts.push_back(2048);
+
+    for(UINT blockCount : blockCounts)
+    {
+        MockAllocatorContext ctx;
+        D3D12MA::POOL_DESC poolDesc = {};
+        poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        poolDesc.BlockSize = blockSize;
+        D3D12MA::Pool* pool = NULL;
+        CHECK_HR(ctx.Allocator->CreatePool(&poolDesc, &pool));
+
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.CustomPool = pool;
+        const D3D12_RESOURCE_ALLOCATION_INFO smallInfo = { smallSize, smallSize };
+        std::vector<D3D12MA::Allocation*> allocs((size_t)blockCount * smallPerBlock);
+        for(D3D12MA::Allocation*& alloc : allocs)
+            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &smallInfo, &alloc));
+        // Every block is half free, in holes too small for the large allocation,
+        // except for a single block that also has a large enough region at its end.
+        const size_t roomyBlock = blockCount / 2;
+        for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+        {
+            for(UINT i = 0; i < smallPerBlock; ++i)
+            {
+                const bool roomyRegion = blockIndex == roomyBlock && i >= smallPerBlock - largePerSmall;
+                if(i % 2 == 0 || roomyRegion)
+                {
+                    D3D12MA::Allocation*& alloc = allocs[blockIndex * smallPerBlock + i];
+                    alloc->Release();
+                    alloc = NULL;
+                }
+            }
+        }
+
+        const D3D12_RESOURCE_ALLOCATION_INFO largeInfo = { largeSize, smallSize };
+        UINT64 allocNs = 0;
+        for(UINT iter = 0; iter < iterationCount; ++iter)
+        {
+            D3D12MA::Allocation* alloc = NULL;
+            const time_point beg = Now();
+            CHECK_HR(ctx.Allocator->AllocateMemory(&allocDesc, &largeInfo, &alloc));
+            allocNs += ElapsedNs(beg, Now());
+            alloc->Release();
+        }
+        D3D12MA::Statistics stats = {};
+        pool->GetStatistics(&stats);
+        CHECK_BOOL(stats.BlockCount == blockCount);
+
+        for(D3D12MA::Allocation* alloc : allocs)
+        {
+            if(alloc != NULL)
+                alloc->Release();
+        }
+        pool->Release();
+
+        BenchmarkResult result;
+        result.Benchmark = "PoolFragmentedBlocks";
+        result.AddParameter("Blocks", blockCount);
+        result.AddMetric("AllocLatency", (double)allocNs / iterationCount, "ns");
+        g_Results.push_back(std::move(result));
+
+        Log("    Blocks=%u: %.1f ns/allocation\n", blockCount, (double)allocNs / iterationCount);
+    }
+}
+
+#endif // #if D3D12MA_BENCHMARK_MOCK_DEVICE
+
+/*
+Many small buffers, like constant buffers, are created as resources of their own or as
+ranges of shared buffers with Allocator::CreateBufferSubAllocation. CreatePlacedResource and
+CreateCommittedResource of the mock device are given a latency simulating the driver.
+*/
+static void BenchmarkBufferSubAllocation()
+{
+    if(!ShouldRun("BufferSubAllocation"))
+        return;
+    Log("Benchmark buffer suballocation\n");
+
+    const UINT64 SIZES[] = { 256, 4096, 100000 };
+    const UINT allocCount = g_Config.Quick ? 1024 : 16384;
+    const UINT64 driverLatencyNs = 1000;
+
+    for(UINT64 size : SIZES)
+    {
+        D3D12_RESOURCE_DESC resDesc = {};
+        resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        resDesc.Width = size;
+        resDesc.Height = 1;
+        resDesc.DepthOrArraySize = 1;
+        resDesc.MipLevels = 1;
+        resDesc.Format = DXGI_FORMAT_UNKNOWN;
+        resDesc.SampleDesc.Count = 1;
+        resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+        for(UINT subAllocate = 0; subAllocate < 2; ++subAllocate)
+        {
+            const char* const mode = subAllocate ? "CreateBufferSubAllocation" : "CreateResource";
+            MockAllocatorContext ctx;
+            MOCK_OPERATION_DESC opDesc = {};
+            opDesc.LatencyNanoseconds = driverLatencyNs;
+            ctx.Device->SetOperationDesc(MOCK_OPERATION_CREATE_PLACED_RESOURCE, opDesc);
+            ctx.Device->SetOperationDesc(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE, opDesc);
+            ctx.Device->ResetCallCounts();
+
+            D3D12MA::ALLOCATION_DESC allocDesc = {};
+            allocDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+            std::vector<D3D12MA::Allocation*> allocs(allocCount);
+            const time_point beg = Now();
+            for(UINT i = 0; i < allocCount; ++i)
+            {
+                if(subAllocate)
+                    CHECK_HR(ctx.Allocator->CreateBufferSubAllocation(&allocDesc, size, 0, &allocs[i]));
+                else
+                {
+                    CHECK_HR(ctx.Allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_GENERIC_READ,
+                        NULL, &allocs[i], IID_NULL, NULL));
+                }
+            }
+            const UINT64 createNs = ElapsedNs(beg, Now());
+
+            D3D12MA::TotalStatistics stats = {};
+            ctx.Allocator->CalculateStatistics(&stats);
+            const UINT64 driverCalls = ctx.Device->GetCallCount(MOCK_OPERATION_CREATE_PLACED_RESOURCE) +
+                ctx.Device->GetCallCount(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE);
+
+            const time_point freeBeg = Now();
+            ctx.Allocator->FreeAllocations(allocCount, allocs.data());
+            const UINT64 freeNs = ElapsedNs(freeBeg, Now());
+
+            BenchmarkResult result;
+            result.Benchmark = "BufferSubAllocation";
+            result.AddParameter("Mode", mode);
+            result.AddParameter("Size", size);
+            result.AddParameter("DriverLatency", driverLatencyNs);
+            result.AddMetric("TimePerCreate", (double)createNs / allocCount, "ns");
+            result.AddMetric("TimePerFree", (double)freeNs / allocCount, "ns");
+            result.AddMetric("BlockBytes", (double)stats.Total.Stats.BlockBytes, "B");
+            result.AddMetric("DriverCalls", (double)driverCalls, "calls");
+            g_Results.push_back(std::move(result));
+
+            Log("    Mode=%s Size=%llu: %.1f ns/create, %.1f ns/free, %llu B in blocks, %llu driver calls\n", mode,
+                (unsigned long long)size, (double)createNs / allocCount, (double)freeNs / allocCount,
+                (unsigned long long)stats.Total.Stats.BlockBytes, (unsigned long long)driverCalls);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Main
+
+static void PrintHelp()
+{
+    printf(
+        "Usage: D3D12MA_Benchmarks [options]\n"
+        "  --format text|csv|json  Output format. Default: text.\n"
+        "  --output <path>         Write results to a file instead of stdout.\n"
+        "  --filter <substring>    Run only benchmarks whose name contains the substring.\n"
+        "  --threads <count>       Maximum number of threads for multithreaded benchmarks. Default: 16.\n"
+        "  --quick                 Small iteration counts, for a smoke test.\n");
+}
+
+static bool ParseCommandLine(int argc, char** argv)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(arg, "--format") == 0 && hasValue)
+        {
+            const char* const value = argv[++i];
+            if(strcmp(value, "text") == 0)
+                g_Config.Format = OUTPUT_FORMAT::TEXT;
+            else if(strcmp(value, "csv") == 0)
+                g_Config.Format = OUTPUT_FORMAT::CSV;
+            else if(strcmp(value, "json") == 0)
+                g_Config.Format = OUTPUT_FORMAT::JSON;
+            else
+                return false;
+        }
+        else if(strcmp(arg, "--output") == 0 && hasValue)
+            g_Config.OutputPath = argv[++i];
+        else if(strcmp(arg, "--filter") == 0 && hasValue)
+            g_Config.Filter = argv[++i];
+        else if(strcmp(arg, "--threads") == 0 && hasValue)
+        {
+            g_Config.MaxThreads = (UINT)atoi(argv[++i]);
+            if(g_Config.MaxThreads == 0)
+                return false;
+        }
+        else if(strcmp(arg, "--quick") == 0)
+            g_Config.Quick = true;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if(!ParseCommandLine(argc, argv))
+    {
+        PrintHelp();
+        return 1;
+    }
+
+    BenchmarkVirtualBlockWorkloads();
+    BenchmarkVirtualBlockManyAllocations();
+    BenchmarkVirtualBlockMixedAlignment();
+    BenchmarkVirtualBlockMultithreaded();
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+    BenchmarkAllocationObjectsMultithreaded();
+    BenchmarkBudgetCountersMultithreaded();
+    BenchmarkBudgetUpdate();
+    BenchmarkLockFreeStatistics();
+    BenchmarkStatsString();
+    BenchmarkSnapshotDelta();
+    BenchmarkTraceEvents();
+    BenchmarkPerformanceCounters();
+    BenchmarkBatchAllocation();
+    BenchmarkResourceAllocationInfoCache();
+    BenchmarkPoolManyBlocks();
+    BenchmarkPoolFragmentedBlocks();
+    BenchmarkBufferSubAllocation();
+#endif
+
+    FILE* file = stdout;
+    if(g_Config.OutputPath != NULL)
+    {
+        file = fopen(g_Config.OutputPath, "w");
+        if(file == NULL)
+        {
+            fprintf(stderr, "Cannot open output file \"%s\".\n", g_Config.OutputPath);
+            return 1;
+        }
+    }
+    WriteResults(file);
+    if(file != stdout)
+        fclose(file);
+    return 0;
+}
@@ -22,15 +22,20 @@
 
 #include "D3D12MemAlloc.h"
 
-#include <combaseapi.h>
+#ifdef _WIN32
+    #include <combaseapi.h>
+#endif
 #include <mutex>
+#include <thread>
 #include <algorithm>
 #include <utility>
 #include <cstdlib>
 #include <cstdint>
+#include <chrono>
 #include <malloc.h> // for _aligned_malloc, _aligned_free
 #ifndef _WIN32
     #include <shared_mutex>
+    #include <condition_variable>
 #endif
 
 // On older mingw versions, using the Agility SDK will cause linker errors unless dxguids.h is included.
@@ -136,6 +141,78 @@
     #define D3D12MA_DEBUG_GLOBAL_MUTEX (0)
 #endif
 
+#ifndef D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT
+    /*
+    Number of caches of free Allocation objects owned by every allocator. When the
+    allocator is used from multiple threads, a thread takes Allocation objects from cache
+    number `thread index % D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT` instead of a pool
+    protected by a single mutex. These are stripes, not true per-thread caches: threads
+    with colliding indices share a cache, and a thread that finds its cache in use by
+    another one falls back to the mutex-protected pool rather than waiting.
+    A fixed number keeps the memory of every allocator bounded and needs no cleanup
+    when threads exit. Set to 0 to disable the caches.
+    */
+    #define D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT (16)
+#endif
+
+#ifndef D3D12MA_ALLOCATION_OBJECT_CACHE_CAPACITY
+    /*
+    Maximum number of free Allocation objects in a single cache. Half of it is moved
+    from or to the shared pool at once when the cache gets empty or full.
+    */
+    #define D3D12MA_ALLOCATION_OBJECT_CACHE_CAPACITY (64)
+#endif
+
+#ifndef D3D12MA_VIRTUAL_BLOCK_SHARD_COUNT
+    /*
+    Number of independently locked address ranges a virtual block created with
+    VIRTUAL_BLOCK_FLAG_THREAD_SAFE is split into, when using the TLSF algorithm.
+    More shards let more threads allocate in parallel, but limit the maximum size
+    of a single allocation to 1/N of the block. Must be between 1 and 8.
+    */
+    #define D3D12MA_VIRTUAL_BLOCK_SHARD_COUNT (4)
+#endif
+
+#ifndef D3D12MA_TLSF_SECOND_LEVEL_INDEX
+    /*
+    Number of bits of the second level index of the TLSF algorithm: each power-of-2
+    range of sizes is divided into 2^N free lists. More lists make sizes of free blocks
+    in each of them closer to each other, so fewer of them are visited before finding
+    one that fits, at the cost of bigger metadata. Must be between 1 and 6.
+    With 6, bitmaps of non-empty lists are 64-bit.
+    */
+    #define D3D12MA_TLSF_SECOND_LEVEL_INDEX (5)
+#endif
+
+#ifndef D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE_CAPACITY
+    /*
+    Maximum number of resource descriptions whose allocation info is remembered
+    by an allocator created with ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO.
+    */
+    #define D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE_CAPACITY (256)
+#endif
+
+#ifndef D3D12MA_BUDGET_COUNTER_STRIPE_COUNT
+    /*
+    Number of separate copies, each on its own cache line, of the allocation counters
+    that every allocator maintains for GetBudget. Each thread updates the copy chosen by
+    its thread index, and the copies are summed when read, so that threads allocating in
+    parallel don't contend on the same cache line. Block counters, read by the budget
+    check of every allocation, are kept in a single copy.
+    */
+    #define D3D12MA_BUDGET_COUNTER_STRIPE_COUNT (8)
+#endif
+
+#ifndef D3D12MA_PROFILE_LOCKS
+    /*
+    Set this to 1 for profiling purposes only, to wrap D3D12MA_MUTEX and D3D12MA_RW_MUTEX
+    with classes that count acquisitions, contended acquisitions and time spent waiting
+    for every lock owned by an allocator. Results are summed per kind of lock and written
+    to the JSON dump as "LockProfiles". It adds atomic operations to every lock and unlock.
+    */
+    #define D3D12MA_PROFILE_LOCKS (0)
+#endif
+
 /*
 Define this macro for debugging purposes only to force specific D3D12_RESOURCE_HEAP_TIER,
 especially to test compatibility with D3D12_RESOURCE_HEAP_TIER_1 on modern GPUs.
@@ -147,6 +224,16 @@ especially to test compatibility with D3D12_RESOURCE_HEAP_TIER_1 on modern GPUs.
    #define D3D12MA_DEFAULT_BLOCK_SIZE (64ull * 1024 * 1024)
 #endif
 
+#ifndef D3D12MA_DEFAULT_BUDGET_UPDATE_PERIOD_MILLISECONDS
+   /// Default period of the thread enabled by ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE.
+   #define D3D12MA_DEFAULT_BUDGET_UPDATE_PERIOD_MILLISECONDS (100)
+#endif
+
+#ifndef D3D12MA_DEFAULT_TRACE_EVENT_CAPACITY
+   /// Default number of events kept by ALLOCATOR_FLAG_TRACE_EVENTS.
+   #define D3D12MA_DEFAULT_TRACE_EVENT_CAPACITY (65536)
+#endif
+
 #ifndef D3D12MA_TIGHT_ALIGNMENT_SUPPORTED
     #if D3D12_SDK_VERSION >= 618
         #define D3D12MA_TIGHT_ALIGNMENT_SUPPORTED 1
@@ -196,6 +283,8 @@ namespace D3D12MA
 {
 static constexpr UINT HEAP_TYPE_COUNT = 5;
 static constexpr UINT STANDARD_HEAP_TYPE_COUNT = 4; // Only DEFAULT, UPLOAD, READBACK, GPU_UPLOAD.
+// Used to keep data modified by different threads in separate cache lines.
+static constexpr size_t CACHE_LINE_SIZE = 64;
 static constexpr UINT DEFAULT_POOL_MAX_COUNT = STANDARD_HEAP_TYPE_COUNT * 3;
 static const UINT NEW_BLOCK_SIZE_SHIFT_MAX = 3;
 // Minimum size of a free suballocation to register it in the free suballocation collection.
@@ -216,6 +305,30 @@ static const WCHAR* const StandardHeapTypeNames[] =
     L"READBACK",
     L"GPU_UPLOAD",
 };
+// Names of allocation algorithms in the stats, indexed by GetAlgorithmIndex().
+static const WCHAR* const AlgorithmNames[] =
+{
+    L"TLSF",
+    L"Linear",
+    L"Buddy",
+    L"Slab",
+};
+// Returns the index of one of the POOL_FLAG_ALGORITHM_* flags, or 0 for the default one.
+static UINT GetAlgorithmIndex(UINT32 algorithm)
+{
+    switch (algorithm)
+    {
+    case POOL_FLAG_ALGORITHM_LINEAR:
+        return 1;
+    case POOL_FLAG_ALGORITHM_BUDDY:
+        return 2;
+    case POOL_FLAG_ALGORITHM_SLAB:
+        return 3;
+    default:
+        D3D12MA_ASSERT(algorithm == 0);
+        return 0;
+    }
+}
 
 static const D3D12_HEAP_FLAGS RESOURCE_CLASS_HEAP_FLAGS =
     D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES | D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES;
@@ -246,6 +359,20 @@ enum SuballocationType
     SUBALLOCATION_TYPE_ALLOCATION = 1,
 };
 
+// Kinds of locks owned by an allocator, profiled separately when D3D12MA_PROFILE_LOCKS is enabled.
+enum LockName
+{
+    LOCK_NAME_POOLS,
+    LOCK_NAME_BLOCK_VECTOR,
+    LOCK_NAME_COMMITTED_ALLOCATION_LIST,
+    LOCK_NAME_ALLOCATION_OBJECT_ALLOCATOR,
+    LOCK_NAME_BUDGET,
+    LOCK_NAME_RESOURCE_ALLOCATION_INFO_CACHE,
+    LOCK_NAME_DEFERRED_RELEASES,
+    LOCK_NAME_BUFFER_SUBALLOCATOR,
+    LOCK_NAME_COUNT
+};
+
 #endif // _D3D12MA_ENUM_DECLARATIONS
 
 
@@ -457,6 +584,9 @@ For 0 returns true.
 template <typename T>
 static bool IsPow2(T x) { return (x & (x - 1)) == 0; }
 
+// Returns the smallest power of two greater or equal to given number. For example: NextPow2(17) = 32.
+static UINT64 NextPow2(UINT64 x) { return x <= 1 ? 1 : 1ull << (BitScanMSB(x - 1) + 1); }
+
 // Aligns given value up to nearest multiply of align value. For example: AlignUp(11, 8) = 16.
 // Use types like UINT, uint64_t as T.
 template <typename T>
@@ -488,6 +618,31 @@ static WCHAR HexDigitToChar(UINT8 digit)
         return L'A' + (digit - 10);
 }
 
+// Writes codePoint in UTF-8 to dst and advances it by 1 to 4 bytes.
+static void EncodeUtf8(UINT codePoint, BYTE*& dst)
+{
+    if (codePoint < 0x80)
+        *dst++ = (BYTE)codePoint;
+    else if (codePoint < 0x800)
+    {
+        *dst++ = (BYTE)(0xC0 | (codePoint >> 6));
+        *dst++ = (BYTE)(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000)
+    {
+        *dst++ = (BYTE)(0xE0 | (codePoint >> 12));
+        *dst++ = (BYTE)(0x80 | ((codePoint >> 6) & 0x3F));
+        *dst++ = (BYTE)(0x80 | (codePoint & 0x3F));
+    }
+    else
+    {
+        *dst++ = (BYTE)(0xF0 | (codePoint >> 18));
+        *dst++ = (BYTE)(0x80 | ((codePoint >> 12) & 0x3F));
+        *dst++ = (BYTE)(0x80 | ((codePoint >> 6) & 0x3F));
+        *dst++ = (BYTE)(0x80 | (codePoint & 0x3F));
+    }
+}
+
 /*
 Performs binary search and returns iterator to first element that is greater or
 equal to `key`, according to comparison `cmp`.
@@ -956,6 +1111,14 @@ static bool CanUseSmallAlignment(const D3D12_RESOURCE_DESC_T& resourceDesc)
     return tileCount <= (isMsaa ? 64 : 16);
 }
     
+// Returns a small number unique to the calling thread, assigned on its first call.
+static UINT GetCurrentThreadIndex()
+{
+    static D3D12MA_ATOMIC_UINT32 nextThreadIndex = {0};
+    thread_local const UINT threadIndex = nextThreadIndex++;
+    return threadIndex;
+}
+
 static bool ValidateAllocateMemoryParameters(
     const ALLOCATION_DESC* pAllocDesc,
     const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfo,
@@ -969,6 +1132,17 @@ static bool ValidateAllocateMemoryParameters(
         pAllocInfo->SizeInBytes % 4 == 0;
 }
 
+static bool ValidateCreateResourceParameters(
+    const ALLOCATION_DESC* pAllocDesc,
+    const D3D12_RESOURCE_DESC* pResourceDesc,
+    Allocation** ppAllocation)
+{
+    return pAllocDesc &&
+        pResourceDesc &&
+        ppAllocation &&
+        (pResourceDesc->Alignment == 0 || IsPow2(pResourceDesc->Alignment));
+}
+
 #endif // _D3D12MA_FUNCTIONS
     
 #ifndef _D3D12MA_STATISTICS_FUNCTIONS
@@ -1073,6 +1247,200 @@ static void AddDetailedStatisticsUnusedRange(DetailedStatistics& inoutStats, UIN
     #define D3D12MA_RW_MUTEX RWMutex
 #endif // #ifndef D3D12MA_RW_MUTEX
 
+#if D3D12MA_PROFILE_LOCKS
+// Counters of all locks of one kind owned by an allocator.
+class LockProfile
+{
+public:
+    static const UINT WAIT_HISTOGRAM_BUCKET_COUNT = 32;
+
+    struct Stats
+    {
+        UINT64 Acquisitions;
+        UINT64 ContendedAcquisitions;
+        UINT64 TotalWaitNanoseconds;
+        UINT64 MaxWaitNanoseconds;
+        // Bucket i counts contended acquisitions that waited [2^i, 2^(i+1)) ns, the last one also longer.
+        UINT64 WaitBuckets[WAIT_HISTOGRAM_BUCKET_COUNT];
+    };
+
+    static UINT64 Now()
+    {
+        return (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void RecordAcquisition() { GetCurrentStripe().Acquisitions.fetch_add(1, std::memory_order_relaxed); }
+    void RecordContendedAcquisition(UINT64 waitNanoseconds);
+    void GetStats(Stats& outStats) const;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Stripe
+    {
+        D3D12MA_ATOMIC_UINT64 Acquisitions = {0};
+        D3D12MA_ATOMIC_UINT64 ContendedAcquisitions = {0};
+        D3D12MA_ATOMIC_UINT64 TotalWaitNanoseconds = {0};
+        D3D12MA_ATOMIC_UINT64 MaxWaitNanoseconds = {0};
+        D3D12MA_ATOMIC_UINT64 WaitBuckets[WAIT_HISTOGRAM_BUCKET_COUNT] = {};
+    };
+
+    Stripe m_Stripes[D3D12MA_BUDGET_COUNTER_STRIPE_COUNT];
+
+    Stripe& GetCurrentStripe() { return m_Stripes[GetCurrentThreadIndex() % D3D12MA_BUDGET_COUNTER_STRIPE_COUNT]; }
+};
+
+void LockProfile::RecordContendedAcquisition(UINT64 waitNanoseconds)
+{
+    Stripe& stripe = GetCurrentStripe();
+    stripe.Acquisitions.fetch_add(1, std::memory_order_relaxed);
+    stripe.ContendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+    stripe.TotalWaitNanoseconds.fetch_add(waitNanoseconds, std::memory_order_relaxed);
+    UINT64 prevMax = stripe.MaxWaitNanoseconds.load(std::memory_order_relaxed);
+    while (waitNanoseconds > prevMax &&
+        !stripe.MaxWaitNanoseconds.compare_exchange_weak(prevMax, waitNanoseconds, std::memory_order_relaxed)) {}
+    const UINT bucket = waitNanoseconds != 0 ?
+        D3D12MA_MIN((UINT)BitScanMSB(waitNanoseconds), WAIT_HISTOGRAM_BUCKET_COUNT - 1) : 0;
+    stripe.WaitBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockProfile::GetStats(Stats& outStats) const
+{
+    ZeroMemory(&outStats, sizeof(outStats));
+    for (UINT i = 0; i < D3D12MA_BUDGET_COUNTER_STRIPE_COUNT; ++i)
+    {
+        const Stripe& stripe = m_Stripes[i];
+        outStats.Acquisitions += stripe.Acquisitions.load(std::memory_order_relaxed);
+        outStats.ContendedAcquisitions += stripe.ContendedAcquisitions.load(std::memory_order_relaxed);
+        outStats.TotalWaitNanoseconds += stripe.TotalWaitNanoseconds.load(std::memory_order_relaxed);
+        outStats.MaxWaitNanoseconds = D3D12MA_MAX(outStats.MaxWaitNanoseconds,
+            stripe.MaxWaitNanoseconds.load(std::memory_order_relaxed));
+        for (UINT bucket = 0; bucket < WAIT_HISTOGRAM_BUCKET_COUNT; ++bucket)
+            outStats.WaitBuckets[bucket] += stripe.WaitBuckets[bucket].load(std::memory_order_relaxed);
+    }
+}
+
+/*
+Wrappers of D3D12MA_MUTEX and D3D12MA_RW_MUTEX counting acquisitions in the LockProfile they are bound to.
+An acquisition is contended if another thread held or was waiting for the lock in a conflicting mode
+when it started. Only contended acquisitions are timed.
+*/
+typedef D3D12MA_MUTEX ProfiledMutexBase;
+class ProfiledMutex : public ProfiledMutexBase
+{
+public:
+    void SetProfile(LockProfile* profile) { m_Profile = profile; }
+
+    void Lock()
+    {
+        if (m_Profile == NULL)
+        {
+            ProfiledMutexBase::Lock();
+            return;
+        }
+        if (m_Pending.fetch_add(1, std::memory_order_relaxed) == 0)
+        {
+            ProfiledMutexBase::Lock();
+            m_Profile->RecordAcquisition();
+        }
+        else
+        {
+            const UINT64 begin = LockProfile::Now();
+            ProfiledMutexBase::Lock();
+            m_Profile->RecordContendedAcquisition(LockProfile::Now() - begin);
+        }
+    }
+    void Unlock()
+    {
+        if (m_Profile != NULL)
+            m_Pending.fetch_sub(1, std::memory_order_relaxed);
+        ProfiledMutexBase::Unlock();
+    }
+
+private:
+    LockProfile* m_Profile = NULL;
+    // Threads holding or waiting for the lock.
+    D3D12MA_ATOMIC_UINT32 m_Pending = {0};
+};
+
+typedef D3D12MA_RW_MUTEX ProfiledRWMutexBase;
+class ProfiledRWMutex : public ProfiledRWMutexBase
+{
+public:
+    void SetProfile(LockProfile* profile) { m_Profile = profile; }
+
+    void LockRead()
+    {
+        if (m_Profile == NULL)
+        {
+            ProfiledRWMutexBase::LockRead();
+            return;
+        }
+        m_Readers.fetch_add(1, std::memory_order_relaxed);
+        if (m_Writers.load(std::memory_order_relaxed) == 0)
+        {
+            ProfiledRWMutexBase::LockRead();
+            m_Profile->RecordAcquisition();
+        }
+        else
+        {
+            const UINT64 begin = LockProfile::Now();
+            ProfiledRWMutexBase::LockRead();
+            m_Profile->RecordContendedAcquisition(LockProfile::Now() - begin);
+        }
+    }
+    void UnlockRead()
+    {
+        if (m_Profile != NULL)
+            m_Readers.fetch_sub(1, std::memory_order_relaxed);
+        ProfiledRWMutexBase::UnlockRead();
+    }
+    void LockWrite()
+    {
+        if (m_Profile == NULL)
+        {
+            ProfiledRWMutexBase::LockWrite();
+            return;
+        }
+        if (m_Writers.fetch_add(1, std::memory_order_relaxed) == 0 &&
+            m_Readers.load(std::memory_order_relaxed) == 0)
+        {
+            ProfiledRWMutexBase::LockWrite();
+            m_Profile->RecordAcquisition();
+        }
+        else
+        {
+            const UINT64 begin = LockProfile::Now();
+            ProfiledRWMutexBase::LockWrite();
+            m_Profile->RecordContendedAcquisition(LockProfile::Now() - begin);
+        }
+    }
+    void UnlockWrite()
+    {
+        if (m_Profile != NULL)
+            m_Writers.fetch_sub(1, std::memory_order_relaxed);
+        ProfiledRWMutexBase::UnlockWrite();
+    }
+
+private:
+    LockProfile* m_Profile = NULL;
+    // Threads holding or waiting for the lock in each mode.
+    D3D12MA_ATOMIC_UINT32 m_Readers = {0};
+    D3D12MA_ATOMIC_UINT32 m_Writers = {0};
+};
+
+#undef D3D12MA_MUTEX
+#define D3D12MA_MUTEX ProfiledMutex
+#undef D3D12MA_RW_MUTEX
+#define D3D12MA_RW_MUTEX ProfiledRWMutex
+
+static void BindLockProfile(D3D12MA_MUTEX& mutex, LockProfile* profile) { mutex.SetProfile(profile); }
+static void BindLockProfile(D3D12MA_RW_MUTEX& mutex, LockProfile* profile) { mutex.SetProfile(profile); }
+#else
+class LockProfile;
+static void BindLockProfile(D3D12MA_MUTEX&, LockProfile*) {}
+static void BindLockProfile(D3D12MA_RW_MUTEX&, LockProfile*) {}
+#endif // #if D3D12MA_PROFILE_LOCKS
+
 // Helper RAII class to lock a mutex in constructor and unlock it in destructor (at the end of scope).
 struct MutexLock
 {
@@ -1418,26 +1786,65 @@ const T& Vector<T>::operator[](size_t index) const
 #endif // _D3D12MA_VECTOR
 
 #ifndef _D3D12MA_STRING_BUILDER
+/*
+Builds a string in memory, or streams it to a callback in chunks when created
+with WRITE_STATS_STRING_FUNC_PTR - then only the last chunk is kept in memory and
+converted to the requested encoding when full.
+*/
 class StringBuilder
 {
 public:
-    StringBuilder(const ALLOCATION_CALLBACKS& allocationCallbacks) : m_Data(allocationCallbacks) {}
+    StringBuilder(const ALLOCATION_CALLBACKS& allocationCallbacks)
+        : m_Data(allocationCallbacks), m_EncodedData(allocationCallbacks) {}
+    StringBuilder(const ALLOCATION_CALLBACKS& allocationCallbacks,
+        WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData, STATS_STRING_ENCODING encoding);
+    ~StringBuilder() { Flush(); }
 
-    size_t GetLength() const { return m_Data.size(); }
-    LPCWSTR GetData() const { return m_Data.data(); }
+    // Not available when streaming.
+    size_t GetLength() const { D3D12MA_ASSERT(m_WriteFunc == NULL); return m_Data.size(); }
+    LPCWSTR GetData() const { D3D12MA_ASSERT(m_WriteFunc == NULL); return m_Data.data(); }
 
-    void Add(WCHAR ch) { m_Data.push_back(ch); }
+    void Add(WCHAR ch) { m_Data.push_back(ch); if (m_Data.size() >= m_FlushThreshold) Flush(); }
     void Add(LPCWSTR str);
     void AddNewLine() { Add(L'\n'); }
     void AddNumber(UINT num);
     void AddNumber(UINT64 num);
     void AddPointer(const void* ptr);
 
+    // Passes characters added so far to the callback. No-op when not streaming.
+    void Flush();
+
 private:
+    // Number of characters buffered before they are passed to the callback.
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
     Vector<WCHAR> m_Data;
+    // Chunk converted to the requested encoding, when it differs from WCHAR.
+    Vector<BYTE> m_EncodedData;
+    WRITE_STATS_STRING_FUNC_PTR m_WriteFunc = NULL;
+    void* m_WritePrivateData = NULL;
+    STATS_STRING_ENCODING m_Encoding = STATS_STRING_ENCODING_UTF16;
+    size_t m_FlushThreshold = SIZE_MAX;
+
+    // Writes codePoint in m_Encoding to dst and advances it by up to 4 bytes.
+    void EncodeCodePoint(UINT codePoint, BYTE*& dst) const;
 };
 
 #ifndef _D3D12MA_STRING_BUILDER_FUNCTIONS
+StringBuilder::StringBuilder(const ALLOCATION_CALLBACKS& allocationCallbacks,
+    WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData, STATS_STRING_ENCODING encoding)
+    : m_Data(allocationCallbacks),
+    m_EncodedData(allocationCallbacks),
+    m_WriteFunc(writeFunc),
+    m_WritePrivateData(pPrivateData),
+    m_Encoding(encoding),
+    m_FlushThreshold(CHUNK_SIZE)
+{
+    D3D12MA_ASSERT(writeFunc != NULL);
+    D3D12MA_ASSERT(encoding == STATS_STRING_ENCODING_UTF16 || encoding == STATS_STRING_ENCODING_UTF8);
+    m_Data.reserve(CHUNK_SIZE);
+}
+
 void StringBuilder::Add(LPCWSTR str)
 {
     const size_t len = wcslen(str);
@@ -1446,6 +1853,8 @@ void StringBuilder::Add(LPCWSTR str)
         const size_t oldCount = m_Data.size();
         m_Data.resize(oldCount + len);
         memcpy(m_Data.data() + oldCount, str, len * sizeof(WCHAR));
+        if (m_Data.size() >= m_FlushThreshold)
+            Flush();
     }
 }
 
@@ -1492,6 +1901,69 @@ void StringBuilder::AddPointer(const void* ptr)
     Add(p);
 }
 
+void StringBuilder::Flush()
+{
+    if (m_WriteFunc == NULL || m_Data.empty())
+        return;
+
+    size_t count = m_Data.size();
+    if (m_Encoding == STATS_STRING_ENCODING_UTF16 && sizeof(WCHAR) == sizeof(UINT16))
+    {
+        m_WriteFunc(m_Data.data(), count * sizeof(WCHAR), m_WritePrivateData);
+        m_Data.clear();
+        return;
+    }
+
+    // When the chunk is full, keep a high surrogate for the next one, where its pair will follow.
+    const UINT last = (UINT)m_Data[count - 1];
+    const bool keepLast = count >= m_FlushThreshold && sizeof(WCHAR) == sizeof(UINT16) &&
+        last >= 0xD800 && last <= 0xDBFF;
+    if (keepLast)
+        --count;
+
+    // Every character takes at most 4 bytes in both encodings.
+    m_EncodedData.resize(count * 4);
+    BYTE* const begin = m_EncodedData.data();
+    BYTE* dst = begin;
+    for (size_t i = 0; i < count; ++i)
+    {
+        UINT codePoint = (UINT)m_Data[i];
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 1 < count &&
+            (UINT)m_Data[i + 1] >= 0xDC00 && (UINT)m_Data[i + 1] <= 0xDFFF)
+        {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + ((UINT)m_Data[++i] - 0xDC00);
+        }
+        EncodeCodePoint(codePoint, dst);
+    }
+    if (dst != begin)
+        m_WriteFunc(begin, dst - begin, m_WritePrivateData);
+
+    m_Data.clear();
+    if (keepLast)
+        m_Data.push_back((WCHAR)last);
+}
+
+void StringBuilder::EncodeCodePoint(UINT codePoint, BYTE*& dst) const
+{
+    // Unpaired surrogates can't be encoded.
+    if ((codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF)
+        codePoint = 0xFFFD;
+
+    if (m_Encoding == STATS_STRING_ENCODING_UTF16)
+    {
+        if (codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            EncodeCodePoint(0xD800 + (codePoint >> 10), dst);
+            EncodeCodePoint(0xDC00 + (codePoint & 0x3FF), dst);
+            return;
+        }
+        *dst++ = (BYTE)(codePoint & 0xFF);
+        *dst++ = (BYTE)(codePoint >> 8);
+    }
+    else
+        EncodeUtf8(codePoint, dst);
+}
 #endif // _D3D12MA_STRING_BUILDER_FUNCTIONS
 #endif // _D3D12MA_STRING_BUILDER
 
@@ -1698,10 +2170,7 @@ void JsonWriter::ContinueString(LPCWSTR pStr)
                 {
                     UINT hexDigit = (val & 0xF000) >> 12;
                     val <<= 4;
-                    if (hexDigit < 10)
-                        m_SB.Add(L'0' + (WCHAR)hexDigit);
-                    else
-                        m_SB.Add(L'A' + (WCHAR)hexDigit);
+                    m_SB.Add(HexDigitToChar((UINT8)hexDigit));
                 }
             }
             break;
@@ -1896,634 +2365,1322 @@ void JsonWriter::WriteIndent(bool oneLess)
 #endif // _D3D12MA_JSON_WRITER_FUNCTIONS
 #endif // _D3D12MA_JSON_WRITER
 
-#ifndef _D3D12MA_POOL_ALLOCATOR
+#ifndef _D3D12MA_BINARY_STATS_WRITER
 /*
-Allocator for objects of type T using a list of arrays (pools) to speed up
-allocation. Number of elements that can be allocated is not bounded because
-allocator can create multiple blocks.
-T should be POD because constructor and destructor is not called in Alloc or
-Free.
+Writes the compact binary dump of Allocator::WriteStatsBinary(), streaming it to
+the callback in chunks. Numbers are written as unsigned LEB128 varints and strings
+as their UTF-8 byte length + 1 (0 for null) followed by the bytes. The format is
+described in detail in tools/GpuMemDumpBin2Json/README.md.
 */
-template<typename T>
-class PoolAllocator
+class BinaryStatsWriter
 {
-    D3D12MA_CLASS_NO_COPY(PoolAllocator)
 public:
-    // allocationCallbacks externally owned, must outlive this object.
-    PoolAllocator(const ALLOCATION_CALLBACKS& allocationCallbacks, UINT firstBlockCapacity);
-    ~PoolAllocator() { Clear(); }
-
-    void Clear();
-    template<typename... Types>
-    T* Alloc(Types... args);
-    void Free(T* ptr);
+    // Increased with every change of the format.
+    static const UINT VERSION = 3;
+
+    // Bits of the flags written after the general information about the device.
+    enum GENERAL_FLAGS
+    {
+        GENERAL_FLAG_TILE_BASED_RENDERER = 0x1,
+        GENERAL_FLAG_UMA = 0x2,
+        GENERAL_FLAG_CACHE_COHERENT_UMA = 0x4,
+        GENERAL_FLAG_GPU_UPLOAD_HEAP_SUPPORTED = 0x8,
+        GENERAL_FLAG_TIGHT_ALIGNMENT_SUPPORTED = 0x10,
+        GENERAL_FLAG_DETAILED_MAP = 0x20,
+        // Heap flags CREATE_NOT_RESIDENT and CREATE_NOT_ZEROED are known to the library.
+        GENERAL_FLAG_DEVICE8_HEAP_FLAGS = 0x40,
+    };
 
-private:
-    union Item
+    // Kind of the document, distinguished by its magic bytes.
+    enum FORMAT
     {
-        UINT NextFreeIndex; // UINT32_MAX means end of list.
-        alignas(T) char Value[sizeof(T)];
+        // Allocator::WriteStatsBinary().
+        FORMAT_DUMP,
+        // Snapshot::WriteChanges().
+        FORMAT_DELTA,
+        // Allocator::WriteTraceEvents().
+        FORMAT_TRACE,
     };
 
-    struct ItemBlock
-    {
-        Item* pItems;
-        UINT Capacity;
-        UINT FirstFreeIndex;
+    BinaryStatsWriter(const ALLOCATION_CALLBACKS& allocationCallbacks,
+        WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData);
+    ~BinaryStatsWriter() { Flush(); }
+
+    void WriteHeader(FORMAT format);
+    void WriteNumber(UINT64 num);
+    // Zig-zag encoding keeps small negative numbers short.
+    void WriteSignedNumber(int64_t num) { WriteNumber(((UINT64)num << 1) ^ (UINT64)(num >> 63)); }
+    void WriteString(LPCWSTR str);
+    void WriteDetailedStatistics(const DetailedStatistics& stats);
+
+    // Must be called before the entries of every block and list of committed allocations.
+    void BeginEntryList() { m_PrevName = NULL; }
+    // offsetDelta - distance from the end of the previous entry in the block, 0 for committed allocations.
+    void WriteAllocation(const Allocation& alloc, int64_t offsetDelta);
+    void WriteUnusedRange(UINT64 size, int64_t offsetDelta);
+
+    // Passes bytes written so far to the callback.
+    void Flush();
+
+private:
+    // Number of bytes buffered before they are passed to the callback.
+    static const size_t CHUNK_SIZE = 64 * 1024;
+    // Maximum number of bytes taken by a varint.
+    static const size_t MAX_NUMBER_SIZE = 10;
+
+    /*
+    Every entry starts with a byte containing the type in the lowest 3 bits:
+    0 for an unused range, 1 + D3D12_RESOURCE_DIMENSION for an allocation,
+    and these flags telling which optional fields follow.
+    */
+    enum ENTRY_FLAGS
+    {
+        ENTRY_FLAG_OFFSET_DELTA = 0x08,
+        ENTRY_FLAG_CUSTOM_DATA = 0x10,
+        ENTRY_FLAG_NAME = 0x20,
+        // Same name as the previous allocation with a name in the list.
+        ENTRY_FLAG_SAME_NAME = 0x40,
+        ENTRY_FLAG_LAYOUT = 0x80,
     };
 
-    const ALLOCATION_CALLBACKS& m_AllocationCallbacks;
-    const UINT m_FirstBlockCapacity;
-    Vector<ItemBlock> m_ItemBlocks;
+    Vector<BYTE> m_Data;
+    size_t m_Size = 0;
+    WRITE_STATS_STRING_FUNC_PTR m_WriteFunc;
+    void* m_WritePrivateData;
+    LPCWSTR m_PrevName = NULL;
 
-    ItemBlock& CreateNewBlock();
+    void Reserve(size_t size) { if (m_Size + size > CHUNK_SIZE) Flush(); }
+    void WriteByte(BYTE b) { Reserve(1); m_Data[m_Size++] = b; }
+
+    // Returns the code point starting at str and advances it past its surrogate pair if needed.
+    static UINT NextCodePoint(LPCWSTR& str);
 };
 
-#ifndef _D3D12MA_POOL_ALLOCATOR_FUNCTIONS
-template<typename T>
-PoolAllocator<T>::PoolAllocator(const ALLOCATION_CALLBACKS& allocationCallbacks, UINT firstBlockCapacity)
-    : m_AllocationCallbacks(allocationCallbacks),
-    m_FirstBlockCapacity(firstBlockCapacity),
-    m_ItemBlocks(allocationCallbacks)
+#ifndef _D3D12MA_BINARY_STATS_WRITER_FUNCTIONS
+BinaryStatsWriter::BinaryStatsWriter(const ALLOCATION_CALLBACKS& allocationCallbacks,
+    WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData)
+    : m_Data(allocationCallbacks),
+    m_WriteFunc(writeFunc),
+    m_WritePrivateData(pPrivateData)
 {
-    D3D12MA_ASSERT(m_FirstBlockCapacity > 1);
+    D3D12MA_ASSERT(writeFunc != NULL);
+    m_Data.resize(CHUNK_SIZE);
 }
 
-template<typename T>
-void PoolAllocator<T>::Clear()
+void BinaryStatsWriter::WriteHeader(FORMAT format)
 {
-    for(size_t i = m_ItemBlocks.size(); i--; )
-    {
-        D3D12MA_DELETE_ARRAY(m_AllocationCallbacks, m_ItemBlocks[i].pItems, m_ItemBlocks[i].Capacity);
-    }
-    m_ItemBlocks.clear(true);
+    static const BYTE magic[] = { 'D', 'M', 'A' };
+    // Last byte of the magic, indexed by FORMAT.
+    static const BYTE formatMagic[] = { 'B', 'D', 'T' };
+    for (size_t i = 0; i < sizeof(magic); ++i)
+        WriteByte(magic[i]);
+    WriteByte(formatMagic[format]);
+    WriteNumber(VERSION);
 }
 
-template<typename T> template<typename... Types>
-T* PoolAllocator<T>::Alloc(Types... args)
+void BinaryStatsWriter::WriteNumber(UINT64 num)
 {
-    for(size_t i = m_ItemBlocks.size(); i--; )
+    Reserve(MAX_NUMBER_SIZE);
+    BYTE* const begin = m_Data.data() + m_Size;
+    BYTE* dst = begin;
+    while (num >= 0x80)
     {
-        ItemBlock& block = m_ItemBlocks[i];
-        // This block has some free items: Use first one.
-        if(block.FirstFreeIndex != UINT32_MAX)
-        {
-            Item* const pItem = &block.pItems[block.FirstFreeIndex];
-            block.FirstFreeIndex = pItem->NextFreeIndex;
-            T* result = (T*)&pItem->Value;
-            new(result)T(std::forward<Types>(args)...); // Explicit constructor call.
-            return result;
-        }
+        *dst++ = (BYTE)(num | 0x80);
+        num >>= 7;
     }
-
-    // No block has free item: Create new one and use it.
-    ItemBlock& newBlock = CreateNewBlock();
-    Item* const pItem = &newBlock.pItems[0];
-    newBlock.FirstFreeIndex = pItem->NextFreeIndex;
-    T* result = (T*)pItem->Value;
-    new(result)T(std::forward<Types>(args)...); // Explicit constructor call.
-    return result;
+    *dst++ = (BYTE)num;
+    m_Size += dst - begin;
 }
 
-template<typename T>
-void PoolAllocator<T>::Free(T* ptr)
+void BinaryStatsWriter::WriteString(LPCWSTR str)
 {
-    // Search all memory blocks to find ptr.
-    for(size_t i = m_ItemBlocks.size(); i--; )
+    if (str == NULL)
     {
-        ItemBlock& block = m_ItemBlocks[i];
+        WriteNumber(0);
+        return;
+    }
 
-        Item* pItemPtr;
-        memcpy(&pItemPtr, &ptr, sizeof(pItemPtr));
+    size_t length = 0;
+    for (LPCWSTR s = str; *s != L'\0'; )
+    {
+        BYTE buf[4];
+        BYTE* dst = buf;
+        EncodeUtf8(NextCodePoint(s), dst);
+        length += dst - buf;
+    }
+    WriteNumber(length + 1);
 
-        // Check if pItemPtr is in address range of this block.
-        if((pItemPtr >= block.pItems) && (pItemPtr < block.pItems + block.Capacity))
-        {
-            ptr->~T(); // Explicit destructor call.
-            const UINT index = static_cast<UINT>(pItemPtr - block.pItems);
-            pItemPtr->NextFreeIndex = block.FirstFreeIndex;
-            block.FirstFreeIndex = index;
-            return;
-        }
+    for (LPCWSTR s = str; *s != L'\0'; )
+    {
+        Reserve(4);
+        BYTE* const begin = m_Data.data() + m_Size;
+        BYTE* dst = begin;
+        EncodeUtf8(NextCodePoint(s), dst);
+        m_Size += dst - begin;
     }
-    D3D12MA_ASSERT(0 && "Pointer doesn't belong to this memory pool.");
 }
 
-template<typename T>
-typename PoolAllocator<T>::ItemBlock& PoolAllocator<T>::CreateNewBlock()
+void BinaryStatsWriter::WriteDetailedStatistics(const DetailedStatistics& stats)
 {
-    const UINT newBlockCapacity = m_ItemBlocks.empty() ?
-        m_FirstBlockCapacity : m_ItemBlocks.back().Capacity * 3 / 2;
-
-    const ItemBlock newBlock = {
-        D3D12MA_NEW_ARRAY(m_AllocationCallbacks, Item, newBlockCapacity),
-        newBlockCapacity,
-        0 };
-
-    m_ItemBlocks.push_back(newBlock);
-
-    // Setup singly-linked list of all free items in this block.
-    for(UINT i = 0; i < newBlockCapacity - 1; ++i)
+    WriteNumber(stats.Stats.BlockCount);
+    WriteNumber(stats.Stats.BlockBytes);
+    WriteNumber(stats.Stats.AllocationCount);
+    WriteNumber(stats.Stats.AllocationBytes);
+    WriteNumber(stats.UnusedRangeCount);
+    // Like in JSON, minimum and maximum are written only when they differ from the sum.
+    if (stats.Stats.AllocationCount > 1)
     {
-        newBlock.pItems[i].NextFreeIndex = i + 1;
+        WriteNumber(stats.AllocationSizeMin);
+        WriteNumber(stats.AllocationSizeMax);
+    }
+    if (stats.UnusedRangeCount > 1)
+    {
+        WriteNumber(stats.UnusedRangeSizeMin);
+        WriteNumber(stats.UnusedRangeSizeMax);
     }
-    newBlock.pItems[newBlockCapacity - 1].NextFreeIndex = UINT32_MAX;
-    return m_ItemBlocks.back();
 }
-#endif // _D3D12MA_POOL_ALLOCATOR_FUNCTIONS
-#endif // _D3D12MA_POOL_ALLOCATOR
 
-#ifndef _D3D12MA_LIST
-/*
-Doubly linked list, with elements allocated out of PoolAllocator.
-Has custom interface, as well as STL-style interface, including iterator and
-const_iterator.
-*/
-template<typename T>
-class List
+void BinaryStatsWriter::WriteAllocation(const Allocation& alloc, int64_t offsetDelta)
 {
-    D3D12MA_CLASS_NO_COPY(List)
-public:
-    struct Item
+    void* const privateData = alloc.GetPrivateData();
+    LPCWSTR const name = alloc.GetName();
+    const UINT layout = (UINT)alloc.m_PackedData.GetTextureLayout();
+    const bool sameName = name != NULL && m_PrevName != NULL && wcscmp(name, m_PrevName) == 0;
+
+    BYTE header = (BYTE)(1 + alloc.m_PackedData.GetResourceDimension());
+    if (offsetDelta != 0)
+        header |= ENTRY_FLAG_OFFSET_DELTA;
+    if (privateData != NULL)
+        header |= ENTRY_FLAG_CUSTOM_DATA;
+    if (name != NULL)
+        header |= sameName ? ENTRY_FLAG_SAME_NAME : ENTRY_FLAG_NAME;
+    if (layout != 0)
+        header |= ENTRY_FLAG_LAYOUT;
+    WriteByte(header);
+
+    if (offsetDelta != 0)
+        WriteSignedNumber(offsetDelta);
+    WriteNumber(alloc.GetSize());
+    WriteNumber((UINT)alloc.m_PackedData.GetResourceFlags());
+    if (privateData != NULL)
+        WriteNumber((uintptr_t)privateData);
+    if (name != NULL)
     {
-        Item* pPrev;
-        Item* pNext;
-        T Value;
-    };
+        if (!sameName)
+            WriteString(name);
+        m_PrevName = name;
+    }
+    if (layout != 0)
+        WriteNumber(layout);
+}
 
-    class reverse_iterator;
-    class const_reverse_iterator;
-    class iterator
+void BinaryStatsWriter::WriteUnusedRange(UINT64 size, int64_t offsetDelta)
+{
+    if (offsetDelta != 0)
     {
-        friend class List<T>;
-        friend class const_iterator;
+        WriteByte(ENTRY_FLAG_OFFSET_DELTA);
+        WriteSignedNumber(offsetDelta);
+    }
+    else
+        WriteByte(0);
+    WriteNumber(size);
+}
 
-    public:
-        iterator() = default;
-        iterator(const reverse_iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+void BinaryStatsWriter::Flush()
+{
+    if (m_Size > 0)
+    {
+        m_WriteFunc(m_Data.data(), m_Size, m_WritePrivateData);
+        m_Size = 0;
+    }
+}
 
-        T& operator*() const;
-        T* operator->() const;
+UINT BinaryStatsWriter::NextCodePoint(LPCWSTR& str)
+{
+    const UINT codePoint = (UINT)*str++;
+    if (codePoint >= 0xD800 && codePoint <= 0xDBFF &&
+        (UINT)*str >= 0xDC00 && (UINT)*str <= 0xDFFF)
+    {
+        return 0x10000 + ((codePoint - 0xD800) << 10) + ((UINT)*str++ - 0xDC00);
+    }
+    // Unpaired surrogates can't be encoded.
+    if ((codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF)
+        return 0xFFFD;
+    return codePoint;
+}
+#endif // _D3D12MA_BINARY_STATS_WRITER_FUNCTIONS
+#endif // _D3D12MA_BINARY_STATS_WRITER
 
-        iterator& operator++();
-        iterator& operator--();
-        iterator operator++(int);
-        iterator operator--(int);
+#ifndef _D3D12MA_DETAILED_MAP_WRITER
+/*
+Receives allocations and unused ranges of a single block from
+BlockMetadata::WriteDetailedMap(), in the order of increasing offsets.
+*/
+class DetailedMapWriter
+{
+public:
+    virtual ~DetailedMapWriter() = default;
+
+    virtual void Begin(UINT64 totalBytes, UINT64 unusedBytes,
+        size_t allocationCount, size_t unusedRangeCount) = 0;
+    // privateData is the Allocation object unless the block is virtual.
+    virtual void AddAllocation(UINT64 offset, UINT64 size, void* privateData) = 0;
+    virtual void AddUnusedRange(UINT64 offset, UINT64 size) = 0;
+    virtual void End() = 0;
+};
 
-        bool operator==(const iterator& rhs) const;
-        bool operator!=(const iterator& rhs) const;
+// Writes the members of a block object in the JSON dump.
+class JsonDetailedMapWriter : public DetailedMapWriter
+{
+public:
+    JsonDetailedMapWriter(JsonWriter& json, bool isVirtual) : m_Json(json), m_IsVirtual(isVirtual) {}
 
-    private:
-        List<T>* m_pList = NULL;
-        Item* m_pItem = NULL;
+    void Begin(UINT64 totalBytes, UINT64 unusedBytes,
+        size_t allocationCount, size_t unusedRangeCount) override;
+    void AddAllocation(UINT64 offset, UINT64 size, void* privateData) override;
+    void AddUnusedRange(UINT64 offset, UINT64 size) override;
+    void End() override { m_Json.EndArray(); }
 
-        iterator(List<T>* pList, Item* pItem) : m_pList(pList), m_pItem(pItem) {}
-    };
+private:
+    JsonWriter& m_Json;
+    const bool m_IsVirtual;
+};
 
-    class reverse_iterator
-    {
-        friend class List<T>;
-        friend class const_reverse_iterator;
+// Writes a block in the binary dump, with offsets encoded as the distance from the end of the previous entry.
+class BinaryDetailedMapWriter : public DetailedMapWriter
+{
+public:
+    BinaryDetailedMapWriter(BinaryStatsWriter& writer) : m_Writer(writer) {}
 
-    public:
-        reverse_iterator() = default;
-        reverse_iterator(const iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+    void Begin(UINT64 totalBytes, UINT64 unusedBytes,
+        size_t allocationCount, size_t unusedRangeCount) override;
+    void AddAllocation(UINT64 offset, UINT64 size, void* privateData) override;
+    void AddUnusedRange(UINT64 offset, UINT64 size) override;
+    void End() override {}
 
-        T& operator*() const;
-        T* operator->() const;
+private:
+    BinaryStatsWriter& m_Writer;
+    UINT64 m_NextOffset = 0;
+};
 
-        reverse_iterator& operator++();
-        reverse_iterator& operator--();
-        reverse_iterator operator++(int);
-        reverse_iterator operator--(int);
+#ifndef _D3D12MA_DETAILED_MAP_WRITER_FUNCTIONS
+void JsonDetailedMapWriter::Begin(UINT64 totalBytes, UINT64 unusedBytes,
+    size_t allocationCount, size_t unusedRangeCount)
+{
+    m_Json.WriteString(L"TotalBytes");
+    m_Json.WriteNumber(totalBytes);
 
-        bool operator==(const reverse_iterator& rhs) const;
-        bool operator!=(const reverse_iterator& rhs) const;
+    m_Json.WriteString(L"UnusedBytes");
+    m_Json.WriteNumber(unusedBytes);
 
-    private:
-        List<T>* m_pList = NULL;
-        Item* m_pItem = NULL;
+    m_Json.WriteString(L"Allocations");
+    m_Json.WriteNumber((UINT64)allocationCount);
 
-        reverse_iterator(List<T>* pList, Item* pItem)
-            : m_pList(pList), m_pItem(pItem) {}
-    };
+    m_Json.WriteString(L"UnusedRanges");
+    m_Json.WriteNumber((UINT64)unusedRangeCount);
 
-    class const_iterator
-    {
-        friend class List<T>;
+    m_Json.WriteString(L"Suballocations");
+    m_Json.BeginArray();
+}
 
-    public:
-        const_iterator() = default;
-        const_iterator(const iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
-        const_iterator(const reverse_iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
-        const_iterator(const const_reverse_iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+void JsonDetailedMapWriter::AddAllocation(UINT64 offset, UINT64 size, void* privateData)
+{
+    m_Json.BeginObject(true);
 
-        iterator dropConst() const;
-        const T& operator*() const;
-        const T* operator->() const;
+    m_Json.WriteString(L"Offset");
+    m_Json.WriteNumber(offset);
 
-        const_iterator& operator++();
-        const_iterator& operator--();
-        const_iterator operator++(int);
-        const_iterator operator--(int);
+    if (m_IsVirtual)
+    {
+        m_Json.WriteString(L"Size");
+        m_Json.WriteNumber(size);
+        if (privateData)
+        {
+            m_Json.WriteString(L"CustomData");
+            m_Json.WriteNumber((uintptr_t)privateData);
+        }
+    }
+    else
+    {
+        const Allocation* const alloc = (const Allocation*)privateData;
+        D3D12MA_ASSERT(alloc);
+        m_Json.AddAllocationToObject(*alloc);
+    }
+    m_Json.EndObject();
+}
 
-        bool operator==(const const_iterator& rhs) const;
-        bool operator!=(const const_iterator& rhs) const;
+void JsonDetailedMapWriter::AddUnusedRange(UINT64 offset, UINT64 size)
+{
+    m_Json.BeginObject(true);
 
-    private:
-        const List<T>* m_pList = NULL;
-        const Item* m_pItem = NULL;
+    m_Json.WriteString(L"Offset");
+    m_Json.WriteNumber(offset);
 
-        const_iterator(const List<T>* pList, const Item* pItem)
-            : m_pList(pList), m_pItem(pItem) {}
-    };
+    m_Json.WriteString(L"Type");
+    m_Json.WriteString(L"FREE");
 
-    class const_reverse_iterator
-    {
-        friend class List<T>;
+    m_Json.WriteString(L"Size");
+    m_Json.WriteNumber(size);
 
-    public:
-        const_reverse_iterator() = default;
-        const_reverse_iterator(const iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
-        const_reverse_iterator(const reverse_iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
-        const_reverse_iterator(const const_iterator& src)
-            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+    m_Json.EndObject();
+}
 
-        reverse_iterator dropConst() const;
-        const T& operator*() const;
-        const T* operator->() const;
+void BinaryDetailedMapWriter::Begin(UINT64 totalBytes, UINT64 unusedBytes,
+    size_t allocationCount, size_t unusedRangeCount)
+{
+    m_Writer.WriteNumber(totalBytes);
+    m_Writer.WriteNumber(unusedBytes);
+    m_Writer.WriteNumber(allocationCount);
+    m_Writer.WriteNumber(unusedRangeCount);
+    m_Writer.BeginEntryList();
+    m_NextOffset = 0;
+}
 
-        const_reverse_iterator& operator++();
-        const_reverse_iterator& operator--();
-        const_reverse_iterator operator++(int);
-        const_reverse_iterator operator--(int);
+void BinaryDetailedMapWriter::AddAllocation(UINT64 offset, UINT64 size, void* privateData)
+{
+    const Allocation* const alloc = (const Allocation*)privateData;
+    D3D12MA_ASSERT(alloc);
+    m_Writer.WriteAllocation(*alloc, (int64_t)(offset - m_NextOffset));
+    // Size of the allocation is written, which can be smaller than size of its suballocation.
+    m_NextOffset = offset + alloc->GetSize();
+}
 
-        bool operator==(const const_reverse_iterator& rhs) const;
-        bool operator!=(const const_reverse_iterator& rhs) const;
+void BinaryDetailedMapWriter::AddUnusedRange(UINT64 offset, UINT64 size)
+{
+    m_Writer.WriteUnusedRange(size, (int64_t)(offset - m_NextOffset));
+    m_NextOffset = offset + size;
+}
+#endif // _D3D12MA_DETAILED_MAP_WRITER_FUNCTIONS
+#endif // _D3D12MA_DETAILED_MAP_WRITER
 
-    private:
-        const List<T>* m_pList = NULL;
-        const Item* m_pItem = NULL;
+#ifndef _D3D12MA_SNAPSHOT_PIMPL
+/*
+Memory blocks and allocations recorded by Allocator::CreateSnapshot(), without
+their names. Both lists are sorted once the snapshot is complete, so that two
+snapshots can be compared by merging them in linear time.
+*/
+class SnapshotPimpl
+{
+public:
+    const ALLOCATION_CALLBACKS m_AllocationCallbacks;
 
-        const_reverse_iterator(const List<T>* pList, const Item* pItem)
-            : m_pList(pList), m_pItem(pItem) {}
-    };
+    SnapshotPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks);
 
-    // allocationCallbacks externally owned, must outlive this object.
-    List(const ALLOCATION_CALLBACKS& allocationCallbacks);
-    // Intentionally not calling Clear, because that would be unnecessary
-    // computations to return all items to m_ItemAllocator as free.
-    ~List() = default;
-    
-    size_t GetCount() const { return m_Count; }
-    bool IsEmpty() const { return m_Count == 0; }
+    size_t GetBlockCount() const { return m_Blocks.size(); }
+    size_t GetAllocationCount() const { return m_Allocations.size(); }
 
-    Item* Front() { return m_pFront; }
-    const Item* Front() const { return m_pFront; }
-    Item* Back() { return m_pBack; }
-    const Item* Back() const { return m_pBack; }
+    void AddBlock(D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId, UINT64 size);
+    // blockId is UINT_MAX and offset is 0 for committed allocations.
+    void AddAllocation(const Allocation& alloc, D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId, UINT64 offset);
+    // To be called after all blocks and allocations are added.
+    void Finish();
 
-    bool empty() const { return IsEmpty(); }
-    size_t size() const { return GetCount(); }
-    void push_back(const T& value) { PushBack(value); }
-    iterator insert(iterator it, const T& value) { return iterator(this, InsertBefore(it.m_pItem, value)); }
-    void clear() { Clear(); }
-    void erase(iterator it) { Remove(it.m_pItem); }
+    // Address of the Allocation object in the lower 48 bits, its creation epoch in the upper 16 bits.
+    static UINT64 GetAllocationId(const Allocation& alloc);
 
-    iterator begin() { return iterator(this, Front()); }
-    iterator end() { return iterator(this, NULL); }
-    reverse_iterator rbegin() { return reverse_iterator(this, Back()); }
-    reverse_iterator rend() { return reverse_iterator(this, NULL); }
+    void EnumerateChanges(const SnapshotPimpl* pPrevious, SNAPSHOT_CHANGE_FUNC_PTR changeFunc, void* pPrivateData) const;
+    void WriteChanges(const SnapshotPimpl* pPrevious, WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData) const;
 
-    const_iterator cbegin() const { return const_iterator(this, Front()); }
-    const_iterator cend() const { return const_iterator(this, NULL); }
-    const_iterator begin() const { return cbegin(); }
-    const_iterator end() const { return cend(); }
+private:
+    struct BlockItem
+    {
+        UINT PoolId;
+        UINT BlockId;
+        D3D12_HEAP_TYPE HeapType;
+        UINT64 Size;
+    };
+    struct AllocationItem
+    {
+        UINT64 AllocationId;
+        UINT64 Offset;
+        UINT64 Size;
+        UINT PoolId;
+        UINT BlockId;
+        D3D12_HEAP_TYPE HeapType;
+    };
 
-    const_reverse_iterator crbegin() const { return const_reverse_iterator(this, Back()); }
-    const_reverse_iterator crend() const { return const_reverse_iterator(this, NULL); }
-    const_reverse_iterator rbegin() const { return crbegin(); }
-    const_reverse_iterator rend() const { return crend(); }
+    Vector<BlockItem> m_Blocks;
+    Vector<AllocationItem> m_Allocations;
 
-    Item* PushBack();
-    Item* PushFront();
-    Item* PushBack(const T& value);
-    Item* PushFront(const T& value);
-    void PopBack();
-    void PopFront();
+    static void ReportBlock(const BlockItem& block, SNAPSHOT_CHANGE_TYPE type,
+        SNAPSHOT_CHANGE_FUNC_PTR changeFunc, void* pPrivateData);
+    static void ReportAllocation(const AllocationItem& alloc, SNAPSHOT_CHANGE_TYPE type,
+        SNAPSHOT_CHANGE_FUNC_PTR changeFunc, void* pPrivateData);
+    // SNAPSHOT_CHANGE_FUNC_PTR passing the changes to a BinaryStatsWriter.
+    static void WriteChange(const SNAPSHOT_CHANGE* pChange, void* pPrivateData);
+};
 
-    // Item can be null - it means PushBack.
-    Item* InsertBefore(Item* pItem);
-    // Item can be null - it means PushFront.
-    Item* InsertAfter(Item* pItem);
-    Item* InsertBefore(Item* pItem, const T& value);
-    Item* InsertAfter(Item* pItem, const T& value);
+// Adds allocations of a single block to a snapshot.
+class SnapshotDetailedMapWriter : public DetailedMapWriter
+{
+public:
+    SnapshotDetailedMapWriter(SnapshotPimpl& snapshot, D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId)
+        : m_Snapshot(snapshot), m_HeapType(heapType), m_PoolId(poolId), m_BlockId(blockId) {}
 
-    void Clear();
-    void Remove(Item* pItem);
+    void Begin(UINT64 totalBytes, UINT64 unusedBytes,
+        size_t allocationCount, size_t unusedRangeCount) override;
+    void AddAllocation(UINT64 offset, UINT64 size, void* privateData) override;
+    void AddUnusedRange(UINT64 offset, UINT64 size) override {}
+    void End() override {}
 
 private:
-    const ALLOCATION_CALLBACKS& m_AllocationCallbacks;
-    PoolAllocator<Item> m_ItemAllocator;
-    Item* m_pFront;
-    Item* m_pBack;
-    size_t m_Count;
+    SnapshotPimpl& m_Snapshot;
+    const D3D12_HEAP_TYPE m_HeapType;
+    const UINT m_PoolId;
+    const UINT m_BlockId;
 };
 
-#ifndef _D3D12MA_LIST_ITERATOR_FUNCTIONS
-template<typename T>
-T& List<T>::iterator::operator*() const
+#ifndef _D3D12MA_SNAPSHOT_PIMPL_FUNCTIONS
+SnapshotPimpl::SnapshotPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks)
+    : m_AllocationCallbacks(allocationCallbacks),
+    // Own copy of the callbacks, as the snapshot can outlive the allocator.
+    m_Blocks(m_AllocationCallbacks),
+    m_Allocations(m_AllocationCallbacks) {}
+
+void SnapshotPimpl::AddBlock(D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId, UINT64 size)
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return m_pItem->Value;
+    const BlockItem item = { poolId, blockId, heapType, size };
+    m_Blocks.push_back(item);
 }
 
-template<typename T>
-T* List<T>::iterator::operator->() const
+void SnapshotPimpl::AddAllocation(const Allocation& alloc, D3D12_HEAP_TYPE heapType,
+    UINT poolId, UINT blockId, UINT64 offset)
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return &m_pItem->Value;
+    AllocationItem item = {};
+    item.AllocationId = GetAllocationId(alloc);
+    item.Offset = offset;
+    item.Size = alloc.GetSize();
+    item.PoolId = poolId;
+    item.BlockId = blockId;
+    item.HeapType = heapType;
+    m_Allocations.push_back(item);
 }
 
-template<typename T>
-typename List<T>::iterator& List<T>::iterator::operator++()
+UINT64 SnapshotPimpl::GetAllocationId(const Allocation& alloc)
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    m_pItem = m_pItem->pNext;
-    return *this;
+    const UINT64 address = (UINT64)(uintptr_t)&alloc;
+    D3D12MA_ASSERT((address >> 48) == 0);
+    return address | ((UINT64)alloc.m_PackedData.GetCreationEpoch() << 48);
 }
 
-template<typename T>
-typename List<T>::iterator& List<T>::iterator::operator--()
+void SnapshotPimpl::Finish()
 {
-    if (m_pItem != NULL)
-    {
-        m_pItem = m_pItem->pPrev;
-    }
-    else
-    {
-        D3D12MA_HEAVY_ASSERT(!m_pList->IsEmpty());
-        m_pItem = m_pList->Back();
-    }
-    return *this;
+    D3D12MA_SORT(m_Blocks.begin(), m_Blocks.end(),
+        [](const BlockItem& lhs, const BlockItem& rhs)
+        {
+            return lhs.PoolId != rhs.PoolId ? lhs.PoolId < rhs.PoolId : lhs.BlockId < rhs.BlockId;
+        });
+    D3D12MA_SORT(m_Allocations.begin(), m_Allocations.end(),
+        [](const AllocationItem& lhs, const AllocationItem& rhs)
+        {
+            return lhs.AllocationId < rhs.AllocationId;
+        });
 }
 
-template<typename T>
-typename List<T>::iterator List<T>::iterator::operator++(int)
+void SnapshotPimpl::EnumerateChanges(const SnapshotPimpl* pPrevious,
+    SNAPSHOT_CHANGE_FUNC_PTR changeFunc, void* pPrivateData) const
 {
-    iterator result = *this;
-    ++* this;
-    return result;
-}
+    D3D12MA_ASSERT(changeFunc);
 
-template<typename T>
-typename List<T>::iterator List<T>::iterator::operator--(int)
-{
-    iterator result = *this;
-    --* this;
-    return result;
-}
+    const size_t prevBlockCount = pPrevious ? pPrevious->m_Blocks.size() : 0;
+    size_t prevIndex = 0, currIndex = 0;
+    while (prevIndex < prevBlockCount || currIndex < m_Blocks.size())
+    {
+        if (currIndex == m_Blocks.size())
+        {
+            ReportBlock(pPrevious->m_Blocks[prevIndex++], SNAPSHOT_CHANGE_TYPE_BLOCK_FREED, changeFunc, pPrivateData);
+            continue;
+        }
+        if (prevIndex == prevBlockCount)
+        {
+            ReportBlock(m_Blocks[currIndex++], SNAPSHOT_CHANGE_TYPE_BLOCK_CREATED, changeFunc, pPrivateData);
+            continue;
+        }
 
-template<typename T>
-bool List<T>::iterator::operator==(const iterator& rhs) const
-{
-    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
-    return m_pItem == rhs.m_pItem;
-}
+        const BlockItem& prev = pPrevious->m_Blocks[prevIndex];
+        const BlockItem& curr = m_Blocks[currIndex];
+        if (prev.PoolId == curr.PoolId && prev.BlockId == curr.BlockId)
+        {
+            ++prevIndex;
+            ++currIndex;
+        }
+        else if (prev.PoolId < curr.PoolId || (prev.PoolId == curr.PoolId && prev.BlockId < curr.BlockId))
+        {
+            ReportBlock(prev, SNAPSHOT_CHANGE_TYPE_BLOCK_FREED, changeFunc, pPrivateData);
+            ++prevIndex;
+        }
+        else
+        {
+            ReportBlock(curr, SNAPSHOT_CHANGE_TYPE_BLOCK_CREATED, changeFunc, pPrivateData);
+            ++currIndex;
+        }
+    }
 
-template<typename T>
-bool List<T>::iterator::operator!=(const iterator& rhs) const
-{
-    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
-    return m_pItem != rhs.m_pItem;
+    const size_t prevAllocationCount = pPrevious ? pPrevious->m_Allocations.size() : 0;
+    prevIndex = 0;
+    currIndex = 0;
+    while (prevIndex < prevAllocationCount || currIndex < m_Allocations.size())
+    {
+        if (currIndex == m_Allocations.size())
+        {
+            ReportAllocation(pPrevious->m_Allocations[prevIndex++], SNAPSHOT_CHANGE_TYPE_ALLOCATION_FREED, changeFunc, pPrivateData);
+            continue;
+        }
+        if (prevIndex == prevAllocationCount)
+        {
+            ReportAllocation(m_Allocations[currIndex++], SNAPSHOT_CHANGE_TYPE_ALLOCATION_CREATED, changeFunc, pPrivateData);
+            continue;
+        }
+
+        const AllocationItem& prev = pPrevious->m_Allocations[prevIndex];
+        const AllocationItem& curr = m_Allocations[currIndex];
+        if (prev.AllocationId == curr.AllocationId)
+        {
+            // Defragmentation keeps the Allocation object, so the same identifier in another place means it was moved.
+            if (prev.BlockId != curr.BlockId || prev.Offset != curr.Offset)
+            {
+                SNAPSHOT_CHANGE change = {};
+                change.Type = SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED;
+                change.HeapType = curr.HeapType;
+                change.PoolId = curr.PoolId;
+                change.BlockId = curr.BlockId;
+                change.Offset = curr.Offset;
+                change.Size = curr.Size;
+                change.AllocationId = curr.AllocationId;
+                change.PreviousBlockId = prev.BlockId;
+                change.PreviousOffset = prev.Offset;
+                changeFunc(&change, pPrivateData);
+            }
+            ++prevIndex;
+            ++currIndex;
+        }
+        else if (prev.AllocationId < curr.AllocationId)
+        {
+            ReportAllocation(prev, SNAPSHOT_CHANGE_TYPE_ALLOCATION_FREED, changeFunc, pPrivateData);
+            ++prevIndex;
+        }
+        else
+        {
+            ReportAllocation(curr, SNAPSHOT_CHANGE_TYPE_ALLOCATION_CREATED, changeFunc, pPrivateData);
+            ++currIndex;
+        }
+    }
 }
-#endif // _D3D12MA_LIST_ITERATOR_FUNCTIONS
 
-#ifndef _D3D12MA_LIST_REVERSE_ITERATOR_FUNCTIONS
-template<typename T>
-T& List<T>::reverse_iterator::operator*() const
+void SnapshotPimpl::WriteChanges(const SnapshotPimpl* pPrevious,
+    WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData) const
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return m_pItem->Value;
+    BinaryStatsWriter writer(m_AllocationCallbacks, writeFunc, pPrivateData);
+    writer.WriteHeader(BinaryStatsWriter::FORMAT_DELTA);
+    EnumerateChanges(pPrevious, WriteChange, &writer);
+    // Terminates the list of changes.
+    writer.WriteNumber(0);
 }
 
-template<typename T>
-T* List<T>::reverse_iterator::operator->() const
+void SnapshotPimpl::ReportBlock(const BlockItem& block, SNAPSHOT_CHANGE_TYPE type,
+    SNAPSHOT_CHANGE_FUNC_PTR changeFunc, void* pPrivateData)
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return &m_pItem->Value;
+    SNAPSHOT_CHANGE change = {};
+    change.Type = type;
+    change.HeapType = block.HeapType;
+    change.PoolId = block.PoolId;
+    change.BlockId = block.BlockId;
+    change.Size = block.Size;
+    changeFunc(&change, pPrivateData);
 }
 
-template<typename T>
-typename List<T>::reverse_iterator& List<T>::reverse_iterator::operator++()
+void SnapshotPimpl::ReportAllocation(const AllocationItem& alloc, SNAPSHOT_CHANGE_TYPE type,
+    SNAPSHOT_CHANGE_FUNC_PTR changeFunc, void* pPrivateData)
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    m_pItem = m_pItem->pPrev;
-    return *this;
+    SNAPSHOT_CHANGE change = {};
+    change.Type = type;
+    change.HeapType = alloc.HeapType;
+    change.PoolId = alloc.PoolId;
+    change.BlockId = alloc.BlockId;
+    change.Offset = alloc.Offset;
+    change.Size = alloc.Size;
+    change.AllocationId = alloc.AllocationId;
+    changeFunc(&change, pPrivateData);
 }
 
-template<typename T>
-typename List<T>::reverse_iterator& List<T>::reverse_iterator::operator--()
+void SnapshotPimpl::WriteChange(const SNAPSHOT_CHANGE* pChange, void* pPrivateData)
 {
-    if (m_pItem != NULL)
-    {
-        m_pItem = m_pItem->pNext;
-    }
-    else
+    BinaryStatsWriter& writer = *(BinaryStatsWriter*)pPrivateData;
+
+    // 0 is reserved for the end of the list, UINT_MAX of committed allocations becomes 0.
+    writer.WriteNumber((UINT)pChange->Type + 1);
+    writer.WriteNumber((UINT)pChange->HeapType);
+    writer.WriteNumber(pChange->PoolId);
+    writer.WriteNumber((UINT)(pChange->BlockId + 1));
+    writer.WriteNumber(pChange->Size);
+    if (pChange->Type >= SNAPSHOT_CHANGE_TYPE_ALLOCATION_CREATED)
     {
-        D3D12MA_HEAVY_ASSERT(!m_pList->IsEmpty());
-        m_pItem = m_pList->Front();
+        writer.WriteNumber(pChange->AllocationId);
+        writer.WriteNumber(pChange->Offset);
+        if (pChange->Type == SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED)
+        {
+            writer.WriteNumber((UINT)(pChange->PreviousBlockId + 1));
+            writer.WriteNumber(pChange->PreviousOffset);
+        }
     }
-    return *this;
 }
 
-template<typename T>
-typename List<T>::reverse_iterator List<T>::reverse_iterator::operator++(int)
+void SnapshotDetailedMapWriter::Begin(UINT64 totalBytes, UINT64 unusedBytes,
+    size_t allocationCount, size_t unusedRangeCount)
 {
-    reverse_iterator result = *this;
-    ++* this;
-    return result;
+    m_Snapshot.AddBlock(m_HeapType, m_PoolId, m_BlockId, totalBytes);
 }
 
-template<typename T>
-typename List<T>::reverse_iterator List<T>::reverse_iterator::operator--(int)
+void SnapshotDetailedMapWriter::AddAllocation(UINT64 offset, UINT64 size, void* privateData)
 {
-    reverse_iterator result = *this;
-    --* this;
-    return result;
+    const Allocation* const alloc = (const Allocation*)privateData;
+    D3D12MA_ASSERT(alloc);
+    m_Snapshot.AddAllocation(*alloc, m_HeapType, m_PoolId, m_BlockId, offset);
 }
+#endif // _D3D12MA_SNAPSHOT_PIMPL_FUNCTIONS
+#endif // _D3D12MA_SNAPSHOT_PIMPL
 
-template<typename T>
-bool List<T>::reverse_iterator::operator==(const reverse_iterator& rhs) const
-{
-    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
-    return m_pItem == rhs.m_pItem;
-}
+#ifndef _D3D12MA_POOL_ALLOCATOR
+/*
+Allocator for objects of type T using a list of arrays (pools) to speed up
+allocation. Number of elements that can be allocated is not bounded because
+allocator can create multiple blocks.
+T should be POD because constructor and destructor is not called in Alloc or
+Free.
 
+Free items of all blocks form a single intrusive singly-linked list, so both Alloc
+and Free are O(1) regardless of the number of blocks. Blocks are released only
+in Clear.
+*/
 template<typename T>
-bool List<T>::reverse_iterator::operator!=(const reverse_iterator& rhs) const
+class PoolAllocator
 {
-    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
-    return m_pItem != rhs.m_pItem;
-}
-#endif // _D3D12MA_LIST_REVERSE_ITERATOR_FUNCTIONS
+    D3D12MA_CLASS_NO_COPY(PoolAllocator)
+public:
+    // allocationCallbacks externally owned, must outlive this object.
+    PoolAllocator(const ALLOCATION_CALLBACKS& allocationCallbacks, UINT firstBlockCapacity);
+    ~PoolAllocator() { Clear(); }
 
-#ifndef _D3D12MA_LIST_CONST_ITERATOR_FUNCTIONS
-template<typename T>
-typename List<T>::iterator List<T>::const_iterator::dropConst() const
-{
-    return iterator(const_cast<List<T>*>(m_pList), const_cast<Item*>(m_pItem));
-}
+    void Clear();
+    template<typename... Types>
+    T* Alloc(Types... args);
+    void Free(T* ptr);
 
-template<typename T>
-const T& List<T>::const_iterator::operator*() const
-{
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return m_pItem->Value;
-}
+    // Versions of Alloc and Free that don't call constructor and destructor,
+    // for callers that keep free items on their own.
+    T* AllocUninitialized();
+    void FreeUninitialized(T* ptr);
+    template<typename... Types>
+    static T* Construct(T* ptr, Types... args) { return new(ptr)T(std::forward<Types>(args)...); }
+    static void Destruct(T* ptr) { ptr->~T(); }
 
-template<typename T>
-const T* List<T>::const_iterator::operator->() const
-{
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return &m_pItem->Value;
-}
+private:
+    union Item
+    {
+        Item* pNextFree; // Null means end of list.
+        alignas(T) char Value[sizeof(T)];
+    };
+
+    struct ItemBlock
+    {
+        Item* pItems;
+        UINT Capacity;
+    };
 
+    const ALLOCATION_CALLBACKS& m_AllocationCallbacks;
+    const UINT m_FirstBlockCapacity;
+    Vector<ItemBlock> m_ItemBlocks;
+    Item* m_FirstFree;
+
+    void CreateNewBlock();
+    // Linear search through blocks, for validation only.
+    bool IsOwned(const Item* item) const;
+};
+
+#ifndef _D3D12MA_POOL_ALLOCATOR_FUNCTIONS
 template<typename T>
-typename List<T>::const_iterator& List<T>::const_iterator::operator++()
+PoolAllocator<T>::PoolAllocator(const ALLOCATION_CALLBACKS& allocationCallbacks, UINT firstBlockCapacity)
+    : m_AllocationCallbacks(allocationCallbacks),
+    m_FirstBlockCapacity(firstBlockCapacity),
+    m_ItemBlocks(allocationCallbacks),
+    m_FirstFree(NULL)
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    m_pItem = m_pItem->pNext;
-    return *this;
+    D3D12MA_ASSERT(m_FirstBlockCapacity > 1);
 }
 
 template<typename T>
-typename List<T>::const_iterator& List<T>::const_iterator::operator--()
+void PoolAllocator<T>::Clear()
 {
-    if (m_pItem != NULL)
-    {
-        m_pItem = m_pItem->pPrev;
-    }
-    else
+    for(size_t i = m_ItemBlocks.size(); i--; )
     {
-        D3D12MA_HEAVY_ASSERT(!m_pList->IsEmpty());
-        m_pItem = m_pList->Back();
+        D3D12MA_DELETE_ARRAY(m_AllocationCallbacks, m_ItemBlocks[i].pItems, m_ItemBlocks[i].Capacity);
     }
-    return *this;
+    m_ItemBlocks.clear(true);
+    m_FirstFree = NULL;
 }
 
-template<typename T>
-typename List<T>::const_iterator List<T>::const_iterator::operator++(int)
+template<typename T> template<typename... Types>
+T* PoolAllocator<T>::Alloc(Types... args)
 {
-    const_iterator result = *this;
-    ++* this;
-    return result;
+    return Construct(AllocUninitialized(), std::forward<Types>(args)...); // Explicit constructor call.
 }
 
 template<typename T>
-typename List<T>::const_iterator List<T>::const_iterator::operator--(int)
+void PoolAllocator<T>::Free(T* ptr)
 {
-    const_iterator result = *this;
-    --* this;
-    return result;
+    Destruct(ptr); // Explicit destructor call.
+    FreeUninitialized(ptr);
 }
 
 template<typename T>
-bool List<T>::const_iterator::operator==(const const_iterator& rhs) const
+T* PoolAllocator<T>::AllocUninitialized()
 {
-    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
-    return m_pItem == rhs.m_pItem;
-}
+    // No block has free item: Create new one.
+    if(m_FirstFree == NULL)
+        CreateNewBlock();
 
-template<typename T>
-bool List<T>::const_iterator::operator!=(const const_iterator& rhs) const
-{
-    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
-    return m_pItem != rhs.m_pItem;
+    Item* const pItem = m_FirstFree;
+    m_FirstFree = pItem->pNextFree;
+    return (T*)pItem->Value;
 }
-#endif // _D3D12MA_LIST_CONST_ITERATOR_FUNCTIONS
 
-#ifndef _D3D12MA_LIST_CONST_REVERSE_ITERATOR_FUNCTIONS
 template<typename T>
-typename List<T>::reverse_iterator List<T>::const_reverse_iterator::dropConst() const
+void PoolAllocator<T>::FreeUninitialized(T* ptr)
 {
-    return reverse_iterator(const_cast<List<T>*>(m_pList), const_cast<Item*>(m_pItem));
-}
+    Item* pItemPtr;
+    memcpy(&pItemPtr, &ptr, sizeof(pItemPtr));
+    D3D12MA_HEAVY_ASSERT(IsOwned(pItemPtr) && "Pointer doesn't belong to this memory pool.");
 
-template<typename T>
-const T& List<T>::const_reverse_iterator::operator*() const
-{
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return m_pItem->Value;
+    pItemPtr->pNextFree = m_FirstFree;
+    m_FirstFree = pItemPtr;
 }
 
 template<typename T>
-const T* List<T>::const_reverse_iterator::operator->() const
+void PoolAllocator<T>::CreateNewBlock()
 {
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    return &m_pItem->Value;
-}
+    const UINT newBlockCapacity = m_ItemBlocks.empty() ?
+        m_FirstBlockCapacity : m_ItemBlocks.back().Capacity * 3 / 2;
 
-template<typename T>
-typename List<T>::const_reverse_iterator& List<T>::const_reverse_iterator::operator++()
-{
-    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
-    m_pItem = m_pItem->pPrev;
-    return *this;
+    const ItemBlock newBlock = {
+        D3D12MA_NEW_ARRAY(m_AllocationCallbacks, Item, newBlockCapacity),
+        newBlockCapacity };
+
+    m_ItemBlocks.push_back(newBlock);
+
+    // Put all items of this block in front of the free list, in order of addresses.
+    for(UINT i = 0; i < newBlockCapacity - 1; ++i)
+    {
+        newBlock.pItems[i].pNextFree = &newBlock.pItems[i + 1];
+    }
+    newBlock.pItems[newBlockCapacity - 1].pNextFree = m_FirstFree;
+    m_FirstFree = newBlock.pItems;
 }
 
 template<typename T>
-typename List<T>::const_reverse_iterator& List<T>::const_reverse_iterator::operator--()
+bool PoolAllocator<T>::IsOwned(const Item* item) const
+{
+    for(size_t i = m_ItemBlocks.size(); i--; )
+    {
+        const ItemBlock& block = m_ItemBlocks[i];
+        if((item >= block.pItems) && (item < block.pItems + block.Capacity))
+            return true;
+    }
+    return false;
+}
+#endif // _D3D12MA_POOL_ALLOCATOR_FUNCTIONS
+#endif // _D3D12MA_POOL_ALLOCATOR
+
+#ifndef _D3D12MA_LIST
+/*
+Doubly linked list, with elements allocated out of PoolAllocator.
+Has custom interface, as well as STL-style interface, including iterator and
+const_iterator.
+*/
+template<typename T>
+class List
+{
+    D3D12MA_CLASS_NO_COPY(List)
+public:
+    struct Item
+    {
+        Item* pPrev;
+        Item* pNext;
+        T Value;
+    };
+
+    class reverse_iterator;
+    class const_reverse_iterator;
+    class iterator
+    {
+        friend class List<T>;
+        friend class const_iterator;
+
+    public:
+        iterator() = default;
+        iterator(const reverse_iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+
+        T& operator*() const;
+        T* operator->() const;
+
+        iterator& operator++();
+        iterator& operator--();
+        iterator operator++(int);
+        iterator operator--(int);
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+    private:
+        List<T>* m_pList = NULL;
+        Item* m_pItem = NULL;
+
+        iterator(List<T>* pList, Item* pItem) : m_pList(pList), m_pItem(pItem) {}
+    };
+
+    class reverse_iterator
+    {
+        friend class List<T>;
+        friend class const_reverse_iterator;
+
+    public:
+        reverse_iterator() = default;
+        reverse_iterator(const iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+
+        T& operator*() const;
+        T* operator->() const;
+
+        reverse_iterator& operator++();
+        reverse_iterator& operator--();
+        reverse_iterator operator++(int);
+        reverse_iterator operator--(int);
+
+        bool operator==(const reverse_iterator& rhs) const;
+        bool operator!=(const reverse_iterator& rhs) const;
+
+    private:
+        List<T>* m_pList = NULL;
+        Item* m_pItem = NULL;
+
+        reverse_iterator(List<T>* pList, Item* pItem)
+            : m_pList(pList), m_pItem(pItem) {}
+    };
+
+    class const_iterator
+    {
+        friend class List<T>;
+
+    public:
+        const_iterator() = default;
+        const_iterator(const iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+        const_iterator(const reverse_iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+        const_iterator(const const_reverse_iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+
+        iterator dropConst() const;
+        const T& operator*() const;
+        const T* operator->() const;
+
+        const_iterator& operator++();
+        const_iterator& operator--();
+        const_iterator operator++(int);
+        const_iterator operator--(int);
+
+        bool operator==(const const_iterator& rhs) const;
+        bool operator!=(const const_iterator& rhs) const;
+
+    private:
+        const List<T>* m_pList = NULL;
+        const Item* m_pItem = NULL;
+
+        const_iterator(const List<T>* pList, const Item* pItem)
+            : m_pList(pList), m_pItem(pItem) {}
+    };
+
+    class const_reverse_iterator
+    {
+        friend class List<T>;
+
+    public:
+        const_reverse_iterator() = default;
+        const_reverse_iterator(const iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+        const_reverse_iterator(const reverse_iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+        const_reverse_iterator(const const_iterator& src)
+            : m_pList(src.m_pList), m_pItem(src.m_pItem) {}
+
+        reverse_iterator dropConst() const;
+        const T& operator*() const;
+        const T* operator->() const;
+
+        const_reverse_iterator& operator++();
+        const_reverse_iterator& operator--();
+        const_reverse_iterator operator++(int);
+        const_reverse_iterator operator--(int);
+
+        bool operator==(const const_reverse_iterator& rhs) const;
+        bool operator!=(const const_reverse_iterator& rhs) const;
+
+    private:
+        const List<T>* m_pList = NULL;
+        const Item* m_pItem = NULL;
+
+        const_reverse_iterator(const List<T>* pList, const Item* pItem)
+            : m_pList(pList), m_pItem(pItem) {}
+    };
+
+    // allocationCallbacks externally owned, must outlive this object.
+    List(const ALLOCATION_CALLBACKS& allocationCallbacks);
+    // Intentionally not calling Clear, because that would be unnecessary
+    // computations to return all items to m_ItemAllocator as free.
+    ~List() = default;
+    
+    size_t GetCount() const { return m_Count; }
+    bool IsEmpty() const { return m_Count == 0; }
+
+    Item* Front() { return m_pFront; }
+    const Item* Front() const { return m_pFront; }
+    Item* Back() { return m_pBack; }
+    const Item* Back() const { return m_pBack; }
+
+    bool empty() const { return IsEmpty(); }
+    size_t size() const { return GetCount(); }
+    void push_back(const T& value) { PushBack(value); }
+    iterator insert(iterator it, const T& value) { return iterator(this, InsertBefore(it.m_pItem, value)); }
+    void clear() { Clear(); }
+    void erase(iterator it) { Remove(it.m_pItem); }
+
+    iterator begin() { return iterator(this, Front()); }
+    iterator end() { return iterator(this, NULL); }
+    reverse_iterator rbegin() { return reverse_iterator(this, Back()); }
+    reverse_iterator rend() { return reverse_iterator(this, NULL); }
+
+    const_iterator cbegin() const { return const_iterator(this, Front()); }
+    const_iterator cend() const { return const_iterator(this, NULL); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator end() const { return cend(); }
+
+    const_reverse_iterator crbegin() const { return const_reverse_iterator(this, Back()); }
+    const_reverse_iterator crend() const { return const_reverse_iterator(this, NULL); }
+    const_reverse_iterator rbegin() const { return crbegin(); }
+    const_reverse_iterator rend() const { return crend(); }
+
+    Item* PushBack();
+    Item* PushFront();
+    Item* PushBack(const T& value);
+    Item* PushFront(const T& value);
+    void PopBack();
+    void PopFront();
+
+    // Item can be null - it means PushBack.
+    Item* InsertBefore(Item* pItem);
+    // Item can be null - it means PushFront.
+    Item* InsertAfter(Item* pItem);
+    Item* InsertBefore(Item* pItem, const T& value);
+    Item* InsertAfter(Item* pItem, const T& value);
+
+    void Clear();
+    void Remove(Item* pItem);
+
+private:
+    const ALLOCATION_CALLBACKS& m_AllocationCallbacks;
+    PoolAllocator<Item> m_ItemAllocator;
+    Item* m_pFront;
+    Item* m_pBack;
+    size_t m_Count;
+};
+
+#ifndef _D3D12MA_LIST_ITERATOR_FUNCTIONS
+template<typename T>
+T& List<T>::iterator::operator*() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return m_pItem->Value;
+}
+
+template<typename T>
+T* List<T>::iterator::operator->() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return &m_pItem->Value;
+}
+
+template<typename T>
+typename List<T>::iterator& List<T>::iterator::operator++()
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    m_pItem = m_pItem->pNext;
+    return *this;
+}
+
+template<typename T>
+typename List<T>::iterator& List<T>::iterator::operator--()
 {
     if (m_pItem != NULL)
     {
-        m_pItem = m_pItem->pNext;
+        m_pItem = m_pItem->pPrev;
     }
     else
     {
         D3D12MA_HEAVY_ASSERT(!m_pList->IsEmpty());
-        m_pItem = m_pList->Front();
+        m_pItem = m_pList->Back();
     }
     return *this;
 }
 
 template<typename T>
-typename List<T>::const_reverse_iterator List<T>::const_reverse_iterator::operator++(int)
+typename List<T>::iterator List<T>::iterator::operator++(int)
 {
-    const_reverse_iterator result = *this;
+    iterator result = *this;
     ++* this;
     return result;
 }
 
 template<typename T>
-typename List<T>::const_reverse_iterator List<T>::const_reverse_iterator::operator--(int)
+typename List<T>::iterator List<T>::iterator::operator--(int)
 {
-    const_reverse_iterator result = *this;
+    iterator result = *this;
     --* this;
     return result;
 }
 
 template<typename T>
-bool List<T>::const_reverse_iterator::operator==(const const_reverse_iterator& rhs) const
+bool List<T>::iterator::operator==(const iterator& rhs) const
 {
     D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
     return m_pItem == rhs.m_pItem;
 }
 
 template<typename T>
-bool List<T>::const_reverse_iterator::operator!=(const const_reverse_iterator& rhs) const
+bool List<T>::iterator::operator!=(const iterator& rhs) const
 {
     D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
     return m_pItem != rhs.m_pItem;
 }
-#endif // _D3D12MA_LIST_CONST_REVERSE_ITERATOR_FUNCTIONS
+#endif // _D3D12MA_LIST_ITERATOR_FUNCTIONS
+
+#ifndef _D3D12MA_LIST_REVERSE_ITERATOR_FUNCTIONS
+template<typename T>
+T& List<T>::reverse_iterator::operator*() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return m_pItem->Value;
+}
+
+template<typename T>
+T* List<T>::reverse_iterator::operator->() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return &m_pItem->Value;
+}
+
+template<typename T>
+typename List<T>::reverse_iterator& List<T>::reverse_iterator::operator++()
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    m_pItem = m_pItem->pPrev;
+    return *this;
+}
+
+template<typename T>
+typename List<T>::reverse_iterator& List<T>::reverse_iterator::operator--()
+{
+    if (m_pItem != NULL)
+    {
+        m_pItem = m_pItem->pNext;
+    }
+    else
+    {
+        D3D12MA_HEAVY_ASSERT(!m_pList->IsEmpty());
+        m_pItem = m_pList->Front();
+    }
+    return *this;
+}
+
+template<typename T>
+typename List<T>::reverse_iterator List<T>::reverse_iterator::operator++(int)
+{
+    reverse_iterator result = *this;
+    ++* this;
+    return result;
+}
+
+template<typename T>
+typename List<T>::reverse_iterator List<T>::reverse_iterator::operator--(int)
+{
+    reverse_iterator result = *this;
+    --* this;
+    return result;
+}
+
+template<typename T>
+bool List<T>::reverse_iterator::operator==(const reverse_iterator& rhs) const
+{
+    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
+    return m_pItem == rhs.m_pItem;
+}
+
+template<typename T>
+bool List<T>::reverse_iterator::operator!=(const reverse_iterator& rhs) const
+{
+    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
+    return m_pItem != rhs.m_pItem;
+}
+#endif // _D3D12MA_LIST_REVERSE_ITERATOR_FUNCTIONS
+
+#ifndef _D3D12MA_LIST_CONST_ITERATOR_FUNCTIONS
+template<typename T>
+typename List<T>::iterator List<T>::const_iterator::dropConst() const
+{
+    return iterator(const_cast<List<T>*>(m_pList), const_cast<Item*>(m_pItem));
+}
+
+template<typename T>
+const T& List<T>::const_iterator::operator*() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return m_pItem->Value;
+}
+
+template<typename T>
+const T* List<T>::const_iterator::operator->() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return &m_pItem->Value;
+}
+
+template<typename T>
+typename List<T>::const_iterator& List<T>::const_iterator::operator++()
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    m_pItem = m_pItem->pNext;
+    return *this;
+}
+
+template<typename T>
+typename List<T>::const_iterator& List<T>::const_iterator::operator--()
+{
+    if (m_pItem != NULL)
+    {
+        m_pItem = m_pItem->pPrev;
+    }
+    else
+    {
+        D3D12MA_HEAVY_ASSERT(!m_pList->IsEmpty());
+        m_pItem = m_pList->Back();
+    }
+    return *this;
+}
+
+template<typename T>
+typename List<T>::const_iterator List<T>::const_iterator::operator++(int)
+{
+    const_iterator result = *this;
+    ++* this;
+    return result;
+}
+
+template<typename T>
+typename List<T>::const_iterator List<T>::const_iterator::operator--(int)
+{
+    const_iterator result = *this;
+    --* this;
+    return result;
+}
+
+template<typename T>
+bool List<T>::const_iterator::operator==(const const_iterator& rhs) const
+{
+    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
+    return m_pItem == rhs.m_pItem;
+}
+
+template<typename T>
+bool List<T>::const_iterator::operator!=(const const_iterator& rhs) const
+{
+    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
+    return m_pItem != rhs.m_pItem;
+}
+#endif // _D3D12MA_LIST_CONST_ITERATOR_FUNCTIONS
+
+#ifndef _D3D12MA_LIST_CONST_REVERSE_ITERATOR_FUNCTIONS
+template<typename T>
+typename List<T>::reverse_iterator List<T>::const_reverse_iterator::dropConst() const
+{
+    return reverse_iterator(const_cast<List<T>*>(m_pList), const_cast<Item*>(m_pItem));
+}
+
+template<typename T>
+const T& List<T>::const_reverse_iterator::operator*() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return m_pItem->Value;
+}
+
+template<typename T>
+const T* List<T>::const_reverse_iterator::operator->() const
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    return &m_pItem->Value;
+}
+
+template<typename T>
+typename List<T>::const_reverse_iterator& List<T>::const_reverse_iterator::operator++()
+{
+    D3D12MA_HEAVY_ASSERT(m_pItem != NULL);
+    m_pItem = m_pItem->pPrev;
+    return *this;
+}
+
+template<typename T>
+typename List<T>::const_reverse_iterator& List<T>::const_reverse_iterator::operator--()
+{
+    if (m_pItem != NULL)
+    {
+        m_pItem = m_pItem->pNext;
+    }
+    else
+    {
+        D3D12MA_HEAVY_ASSERT(!m_pList->IsEmpty());
+        m_pItem = m_pList->Front();
+    }
+    return *this;
+}
+
+template<typename T>
+typename List<T>::const_reverse_iterator List<T>::const_reverse_iterator::operator++(int)
+{
+    const_reverse_iterator result = *this;
+    ++* this;
+    return result;
+}
+
+template<typename T>
+typename List<T>::const_reverse_iterator List<T>::const_reverse_iterator::operator--(int)
+{
+    const_reverse_iterator result = *this;
+    --* this;
+    return result;
+}
+
+template<typename T>
+bool List<T>::const_reverse_iterator::operator==(const const_reverse_iterator& rhs) const
+{
+    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
+    return m_pItem == rhs.m_pItem;
+}
+
+template<typename T>
+bool List<T>::const_reverse_iterator::operator!=(const const_reverse_iterator& rhs) const
+{
+    D3D12MA_HEAVY_ASSERT(m_pList == rhs.m_pList);
+    return m_pItem != rhs.m_pItem;
+}
+#endif // _D3D12MA_LIST_CONST_REVERSE_ITERATOR_FUNCTIONS
 
 #ifndef _D3D12MA_LIST_FUNCTIONS
 template<typename T>
@@ -2997,6 +4154,11 @@ void IntrusiveLinkedList<ItemTypeTraits>::RemoveAll()
 #ifndef _D3D12MA_ALLOCATION_OBJECT_ALLOCATOR
 /*
 Thread-safe wrapper over PoolAllocator free list, for allocation of Allocation objects.
+
+When used from multiple threads, free Allocation objects are kept in a fixed number of
+caches selected by thread index (see D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT), each guarded
+by a try-lock flag instead of a mutex. The shared pool and its mutex are touched only to
+move half of a cache at once, or when the cache is being used by another thread.
 */
 class AllocationObjectAllocator
 {
@@ -3008,10 +4170,28 @@ public:
     template<typename... Types>
     Allocation* Allocate(Types... args);
     void Free(Allocation* alloc);
+    // Frees multiple objects under a single lock, bypassing the caches.
+    void FreeBatch(size_t count, Allocation* const* pAllocs);
+    void SetLockProfile(LockProfile* profile) { BindLockProfile(m_Mutex, profile); }
 
 private:
+#if D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT > 0
+    struct alignas(CACHE_LINE_SIZE) Cache
+    {
+        D3D12MA_ATOMIC_UINT32 Locked = {0};
+        UINT Count = 0;
+        Allocation* Items[D3D12MA_ALLOCATION_OBJECT_CACHE_CAPACITY];
+    };
+    Cache m_Caches[D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT];
+
+    // Returns the cache selected for the current thread locked, or null if it's locked by another thread.
+    Cache* TryLockCache();
+    static void UnlockCache(Cache* cache) { cache->Locked = 0; }
+#endif
+
     D3D12MA_MUTEX m_Mutex;
     bool m_UseMutex;
+    // Items in caches remain allocated from this pool, so they are released together with it.
     PoolAllocator<Allocation> m_Allocator;
 };
 
@@ -3019,15 +4199,68 @@ private:
 template<typename... Types>
 Allocation* AllocationObjectAllocator::Allocate(Types... args)
 {
+#if D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT > 0
+    if (m_UseMutex)
+    {
+        if (Cache* const cache = TryLockCache())
+        {
+            if (cache->Count == 0)
+            {
+                MutexLock mutexLock(m_Mutex);
+                for (; cache->Count < D3D12MA_ALLOCATION_OBJECT_CACHE_CAPACITY / 2; ++cache->Count)
+                    cache->Items[cache->Count] = m_Allocator.AllocUninitialized();
+            }
+            Allocation* const alloc = cache->Items[--cache->Count];
+            UnlockCache(cache);
+            return PoolAllocator<Allocation>::Construct(alloc, std::forward<Types>(args)...);
+        }
+    }
+#endif
     MutexLock mutexLock(m_Mutex, m_UseMutex);
     return m_Allocator.Alloc(std::forward<Types>(args)...);
 }
 
 void AllocationObjectAllocator::Free(Allocation* alloc)
 {
+#if D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT > 0
+    if (m_UseMutex)
+    {
+        if (Cache* const cache = TryLockCache())
+        {
+            PoolAllocator<Allocation>::Destruct(alloc);
+            if (cache->Count == D3D12MA_ALLOCATION_OBJECT_CACHE_CAPACITY)
+            {
+                MutexLock mutexLock(m_Mutex);
+                for (; cache->Count > D3D12MA_ALLOCATION_OBJECT_CACHE_CAPACITY / 2; )
+                    m_Allocator.FreeUninitialized(cache->Items[--cache->Count]);
+            }
+            cache->Items[cache->Count++] = alloc;
+            UnlockCache(cache);
+            return;
+        }
+    }
+#endif
     MutexLock mutexLock(m_Mutex, m_UseMutex);
     m_Allocator.Free(alloc);
 }
+
+void AllocationObjectAllocator::FreeBatch(size_t count, Allocation* const* pAllocs)
+{
+    for (size_t i = 0; i < count; ++i)
+        PoolAllocator<Allocation>::Destruct(pAllocs[i]);
+
+    MutexLock mutexLock(m_Mutex, m_UseMutex);
+    for (size_t i = 0; i < count; ++i)
+        m_Allocator.FreeUninitialized(pAllocs[i]);
+}
+
+#if D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT > 0
+AllocationObjectAllocator::Cache* AllocationObjectAllocator::TryLockCache()
+{
+    Cache* const cache = &m_Caches[GetCurrentThreadIndex() % D3D12MA_ALLOCATION_OBJECT_CACHE_COUNT];
+    return cache->Locked.exchange(1) == 0 ? cache : NULL;
+}
+#endif
 #endif // _D3D12MA_ALLOCATION_OBJECT_ALLOCATOR_FUNCTIONS
 #endif // _D3D12MA_ALLOCATION_OBJECT_ALLOCATOR
 
@@ -3090,12 +4323,142 @@ struct AllocationRequest
 };
 #endif // _D3D12MA_ALLOCATION_REQUEST
 
-#ifndef _D3D12MA_BLOCK_METADATA
+#ifndef _D3D12MA_STATISTICS_SNAPSHOT
 /*
-Data structure used for bookkeeping of allocations and unused ranges of memory
-in a single ID3D12Heap memory block.
+DetailedStatistics of a BlockVector or CommittedAllocationList maintained incrementally,
+when ALLOCATOR_FLAG_LOCK_FREE_STATISTICS is used, so they can be read without locking it.
+
+Modified by a single writer holding the lock of the owner, inside an update marked by
+StatisticsSnapshotUpdate. The sequence number is odd while an update is in progress,
+so Read retries until it copies all values between two updates.
+
+Sizes of allocations and unused ranges are only counted in power-of-2 buckets,
+so minimum and maximum sizes are returned rounded down to a power of 2.
 */
-class BlockMetadata
+class StatisticsSnapshot
+{
+    D3D12MA_CLASS_NO_COPY(StatisticsSnapshot);
+public:
+    StatisticsSnapshot() = default;
+
+    void BeginUpdate() { ++m_Sequence; }
+    void EndUpdate() { ++m_Sequence; }
+
+    void AddBlock(UINT64 size);
+    void RemoveBlock(UINT64 size);
+    void AddAllocation(UINT64 size);
+    void RemoveAllocation(UINT64 size);
+    void AddUnusedRange(UINT64 size) { ++m_UnusedRangeCounts[BitScanMSB(size)]; }
+    void RemoveUnusedRange(UINT64 size) { --m_UnusedRangeCounts[BitScanMSB(size)]; }
+
+    // Adds values of a consistent snapshot to inoutStats.
+    void Read(DetailedStatistics& inoutStats) const;
+
+private:
+    static const UINT BUCKET_COUNT = 64;
+
+    D3D12MA_ATOMIC_UINT32 m_Sequence = {0};
+    D3D12MA_ATOMIC_UINT32 m_BlockCount = {0};
+    D3D12MA_ATOMIC_UINT64 m_BlockBytes = {0};
+    D3D12MA_ATOMIC_UINT64 m_AllocationBytes = {0};
+    // Numbers of allocations and unused ranges, indexed by the highest set bit of their size.
+    D3D12MA_ATOMIC_UINT32 m_AllocationCounts[BUCKET_COUNT] = {};
+    D3D12MA_ATOMIC_UINT32 m_UnusedRangeCounts[BUCKET_COUNT] = {};
+};
+
+// RAII marking an update of StatisticsSnapshot, which may be null.
+struct StatisticsSnapshotUpdate
+{
+    StatisticsSnapshotUpdate(StatisticsSnapshot* snapshot) : m_Snapshot(snapshot) { if (m_Snapshot) m_Snapshot->BeginUpdate(); }
+    ~StatisticsSnapshotUpdate() { if (m_Snapshot) m_Snapshot->EndUpdate(); }
+
+    D3D12MA_CLASS_NO_COPY(StatisticsSnapshotUpdate);
+private:
+    StatisticsSnapshot* const m_Snapshot;
+};
+
+#ifndef _D3D12MA_STATISTICS_SNAPSHOT_FUNCTIONS
+void StatisticsSnapshot::AddBlock(UINT64 size)
+{
+    ++m_BlockCount;
+    m_BlockBytes += size;
+}
+
+void StatisticsSnapshot::RemoveBlock(UINT64 size)
+{
+    D3D12MA_ASSERT(m_BlockCount > 0 && m_BlockBytes >= size);
+    --m_BlockCount;
+    m_BlockBytes -= size;
+}
+
+void StatisticsSnapshot::AddAllocation(UINT64 size)
+{
+    ++m_AllocationCounts[BitScanMSB(size)];
+    m_AllocationBytes += size;
+}
+
+void StatisticsSnapshot::RemoveAllocation(UINT64 size)
+{
+    D3D12MA_ASSERT(m_AllocationBytes >= size);
+    --m_AllocationCounts[BitScanMSB(size)];
+    m_AllocationBytes -= size;
+}
+
+void StatisticsSnapshot::Read(DetailedStatistics& inoutStats) const
+{
+    UINT blockCount;
+    UINT64 blockBytes, allocationBytes;
+    UINT allocationCounts[BUCKET_COUNT];
+    UINT unusedRangeCounts[BUCKET_COUNT];
+    for (;;)
+    {
+        const UINT32 sequence = m_Sequence;
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        blockCount = m_BlockCount;
+        blockBytes = m_BlockBytes;
+        allocationBytes = m_AllocationBytes;
+        for (UINT i = 0; i < BUCKET_COUNT; ++i)
+        {
+            allocationCounts[i] = m_AllocationCounts[i];
+            unusedRangeCounts[i] = m_UnusedRangeCounts[i];
+        }
+        if (m_Sequence == sequence)
+            break;
+    }
+
+    inoutStats.Stats.BlockCount += blockCount;
+    inoutStats.Stats.BlockBytes += blockBytes;
+    inoutStats.Stats.AllocationBytes += allocationBytes;
+    for (UINT i = 0; i < BUCKET_COUNT; ++i)
+    {
+        const UINT64 bucketMinSize = 1ULL << i;
+        if (allocationCounts[i] > 0)
+        {
+            inoutStats.Stats.AllocationCount += allocationCounts[i];
+            inoutStats.AllocationSizeMin = D3D12MA_MIN(inoutStats.AllocationSizeMin, bucketMinSize);
+            inoutStats.AllocationSizeMax = D3D12MA_MAX(inoutStats.AllocationSizeMax, bucketMinSize);
+        }
+        if (unusedRangeCounts[i] > 0)
+        {
+            inoutStats.UnusedRangeCount += unusedRangeCounts[i];
+            inoutStats.UnusedRangeSizeMin = D3D12MA_MIN(inoutStats.UnusedRangeSizeMin, bucketMinSize);
+            inoutStats.UnusedRangeSizeMax = D3D12MA_MAX(inoutStats.UnusedRangeSizeMax, bucketMinSize);
+        }
+    }
+}
+#endif // _D3D12MA_STATISTICS_SNAPSHOT_FUNCTIONS
+#endif // _D3D12MA_STATISTICS_SNAPSHOT
+
+#ifndef _D3D12MA_BLOCK_METADATA
+/*
+Data structure used for bookkeeping of allocations and unused ranges of memory
+in a single ID3D12Heap memory block.
+*/
+class BlockMetadata
 {
 public:
     BlockMetadata(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual);
@@ -3109,6 +4472,9 @@ public:
     virtual size_t GetAllocationCount() const = 0;
     virtual size_t GetFreeRegionsCount() const = 0;
     virtual UINT64 GetSumFreeSize() const = 0;
+    // Returns an upper bound of the size of the largest free region, cheap to calculate.
+    // CreateAllocationRequest fails for any allocation larger than that.
+    virtual UINT64 GetLargestFreeRegionSizeBound() const = 0;
     virtual UINT64 GetAllocationOffset(AllocHandle allocHandle) const = 0;
     // Returns true if this block is empty - contains only single free suballocation.
     virtual bool IsEmpty() const = 0;
@@ -3144,7 +4510,13 @@ public:
 
     virtual void AddStatistics(Statistics& inoutStats) const = 0;
     virtual void AddDetailedStatistics(DetailedStatistics& inoutStats) const = 0;
-    virtual void WriteAllocationInfoToJson(JsonWriter& json) const = 0;
+    // Starts reporting all current and future allocations and unused ranges to the snapshot,
+    // or stops it and removes them from the previous snapshot when null.
+    virtual void SetStatisticsSnapshot(StatisticsSnapshot* snapshot) = 0;
+    // Passes all allocations and unused ranges to the writer in the order of increasing offsets.
+    virtual void WriteDetailedMap(DetailedMapWriter& writer) const = 0;
+    void WriteAllocationInfoToJson(JsonWriter& json) const;
+    void WriteAllocationInfoToBinary(BinaryStatsWriter& writer) const;
     virtual void DebugLogAllAllocations() const = 0;
 
 protected:
@@ -3152,15 +4524,6 @@ protected:
     UINT64 GetDebugMargin() const { return IsVirtual() ? 0 : D3D12MA_DEBUG_MARGIN; }
 
     void DebugLogAllocation(UINT64 offset, UINT64 size, void* privateData) const;
-    void PrintDetailedMap_Begin(JsonWriter& json,
-        UINT64 unusedBytes,
-        size_t allocationCount,
-        size_t unusedRangeCount) const;
-    void PrintDetailedMap_Allocation(JsonWriter& json,
-        UINT64 offset, UINT64 size, void* privateData) const;
-    void PrintDetailedMap_UnusedRange(JsonWriter& json,
-        UINT64 offset, UINT64 size) const;
-    void PrintDetailedMap_End(JsonWriter& json) const;
 
 private:
     UINT64 m_Size;
@@ -3198,72 +4561,17 @@ void BlockMetadata::DebugLogAllocation(UINT64 offset, UINT64 size, void* private
     }
 }
 
-void BlockMetadata::PrintDetailedMap_Begin(JsonWriter& json,
-    UINT64 unusedBytes, size_t allocationCount, size_t unusedRangeCount) const
-{
-    json.WriteString(L"TotalBytes");
-    json.WriteNumber(GetSize());
-
-    json.WriteString(L"UnusedBytes");
-    json.WriteNumber(unusedBytes);
-
-    json.WriteString(L"Allocations");
-    json.WriteNumber((UINT64)allocationCount);
-
-    json.WriteString(L"UnusedRanges");
-    json.WriteNumber((UINT64)unusedRangeCount);
-
-    json.WriteString(L"Suballocations");
-    json.BeginArray();
-}
-
-void BlockMetadata::PrintDetailedMap_Allocation(JsonWriter& json,
-    UINT64 offset, UINT64 size, void* privateData) const
-{
-    json.BeginObject(true);
-
-    json.WriteString(L"Offset");
-    json.WriteNumber(offset);
-
-    if (IsVirtual())
-    {
-        json.WriteString(L"Size");
-        json.WriteNumber(size);
-        if (privateData)
-        {
-            json.WriteString(L"CustomData");
-            json.WriteNumber((uintptr_t)privateData);
-        }
-    }
-    else
-    {
-        const Allocation* const alloc = (const Allocation*)privateData;
-        D3D12MA_ASSERT(alloc);
-        json.AddAllocationToObject(*alloc);
-    }
-    json.EndObject();
-}
-
-void BlockMetadata::PrintDetailedMap_UnusedRange(JsonWriter& json,
-    UINT64 offset, UINT64 size) const
+void BlockMetadata::WriteAllocationInfoToJson(JsonWriter& json) const
 {
-    json.BeginObject(true);
-
-    json.WriteString(L"Offset");
-    json.WriteNumber(offset);
-
-    json.WriteString(L"Type");
-    json.WriteString(L"FREE");
-
-    json.WriteString(L"Size");
-    json.WriteNumber(size);
-
-    json.EndObject();
+    JsonDetailedMapWriter writer(json, IsVirtual());
+    WriteDetailedMap(writer);
 }
 
-void BlockMetadata::PrintDetailedMap_End(JsonWriter& json) const
+void BlockMetadata::WriteAllocationInfoToBinary(BinaryStatsWriter& writer) const
 {
-    json.EndArray();
+    D3D12MA_ASSERT(!IsVirtual());
+    BinaryDetailedMapWriter mapWriter(writer);
+    WriteDetailedMap(mapWriter);
 }
 #endif // _D3D12MA_BLOCK_METADATA_FUNCTIONS
 #endif // _D3D12MA_BLOCK_METADATA
@@ -3276,6 +4584,7 @@ public:
     virtual ~BlockMetadata_Linear() = default;
 
     UINT64 GetSumFreeSize() const override { return m_SumFreeSize; }
+    UINT64 GetLargestFreeRegionSizeBound() const override;
     bool IsEmpty() const override { return GetAllocationCount() == 0; }
     UINT64 GetAllocationOffset(AllocHandle allocHandle) const override { return (UINT64)allocHandle - 1; };
 
@@ -3308,7 +4617,9 @@ public:
 
     void AddStatistics(Statistics& inoutStats) const override;
     void AddDetailedStatistics(DetailedStatistics& inoutStats) const override;
-    void WriteAllocationInfoToJson(JsonWriter& json) const override;
+    // Not supported - unused ranges of this algorithm are not tracked incrementally.
+    void SetStatisticsSnapshot(StatisticsSnapshot* snapshot) override { D3D12MA_ASSERT(snapshot == NULL); }
+    void WriteDetailedMap(DetailedMapWriter& writer) const override;
     void DebugLogAllAllocations() const override;
 
 private:
@@ -3567,6 +4878,36 @@ void BlockMetadata_Linear::GetAllocationInfo(AllocHandle allocHandle, VIRTUAL_AL
     outInfo.pPrivateData = suballoc.privateData;
 }
 
+UINT64 BlockMetadata_Linear::GetLargestFreeRegionSizeBound() const
+{
+    // Only the free spaces that CreateAllocationRequest considers count, not holes
+    // left between allocations in the middle of the vectors.
+    const UINT64 blockSize = GetSize();
+    const SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    const SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+
+    const UINT64 endOf1st = !suballocations1st.empty() ?
+        suballocations1st.back().offset + suballocations1st.back().size : 0;
+    UINT64 result = 0;
+    if (m_2ndVectorMode == SECOND_VECTOR_EMPTY || m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK)
+    {
+        // End of 1st vector or, for upper address, below the top of 2nd vector.
+        const UINT64 freeSpaceEnd = !suballocations2nd.empty() ? suballocations2nd.back().offset : blockSize;
+        result = freeSpaceEnd - endOf1st;
+    }
+    if ((m_2ndVectorMode == SECOND_VECTOR_EMPTY || m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER) &&
+        !suballocations1st.empty())
+    {
+        // End of 2nd vector, up to the first used item of 1st vector.
+        const UINT64 freeSpaceBegin = !suballocations2nd.empty() ?
+            suballocations2nd.back().offset + suballocations2nd.back().size : 0;
+        const UINT64 freeSpaceEnd = m_1stNullItemsBeginCount < suballocations1st.size() ?
+            suballocations1st[m_1stNullItemsBeginCount].offset : blockSize;
+        result = D3D12MA_MAX(result, freeSpaceEnd - freeSpaceBegin);
+    }
+    return result;
+}
+
 bool BlockMetadata_Linear::CreateAllocationRequest(
     UINT64 allocSize,
     UINT64 allocAlignment,
@@ -3956,7 +5297,7 @@ void BlockMetadata_Linear::AddDetailedStatistics(DetailedStatistics& inoutStats)
     }
 }
 
-void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
+void BlockMetadata_Linear::WriteDetailedMap(DetailedMapWriter& writer) const
 {
     const UINT64 size = GetSize();
     const SuballocationVectorType& suballocations1st = AccessSuballocations1st();
@@ -4118,7 +5459,7 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
     }
 
     const UINT64 unusedBytes = size - usedBytes;
-    PrintDetailedMap_Begin(json, unusedBytes, alloc1stCount + alloc2ndCount, unusedRangeCount);
+    writer.Begin(size, unusedBytes, alloc1stCount + alloc2ndCount, unusedRangeCount);
 
     // SECOND PASS
     lastOffset = 0;
@@ -4145,12 +5486,12 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
                 {
                     // There is free space from lastOffset to suballoc.offset.
                     const UINT64 unusedRangeSize = suballoc.offset - lastOffset;
-                    PrintDetailedMap_UnusedRange(json, lastOffset, unusedRangeSize);
+                    writer.AddUnusedRange(lastOffset, unusedRangeSize);
                 }
 
                 // 2. Process this allocation.
                 // There is allocation with suballoc.offset, suballoc.size.
-                PrintDetailedMap_Allocation(json, suballoc.offset, suballoc.size, suballoc.privateData);
+                writer.AddAllocation(suballoc.offset, suballoc.size, suballoc.privateData);
 
                 // 3. Prepare for next iteration.
                 lastOffset = suballoc.offset + suballoc.size;
@@ -4163,7 +5504,7 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
                 {
                     // There is free space from lastOffset to freeSpace2ndTo1stEnd.
                     const UINT64 unusedRangeSize = freeSpace2ndTo1stEnd - lastOffset;
-                    PrintDetailedMap_UnusedRange(json, lastOffset, unusedRangeSize);
+                    writer.AddUnusedRange(lastOffset, unusedRangeSize);
                 }
 
                 // End of loop.
@@ -4192,12 +5533,12 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
             {
                 // There is free space from lastOffset to suballoc.offset.
                 const UINT64 unusedRangeSize = suballoc.offset - lastOffset;
-                PrintDetailedMap_UnusedRange(json, lastOffset, unusedRangeSize);
+                writer.AddUnusedRange(lastOffset, unusedRangeSize);
             }
 
             // 2. Process this allocation.
             // There is allocation with suballoc.offset, suballoc.size.
-            PrintDetailedMap_Allocation(json, suballoc.offset, suballoc.size, suballoc.privateData);
+            writer.AddAllocation(suballoc.offset, suballoc.size, suballoc.privateData);
 
             // 3. Prepare for next iteration.
             lastOffset = suballoc.offset + suballoc.size;
@@ -4210,7 +5551,7 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
             {
                 // There is free space from lastOffset to freeSpace1stTo2ndEnd.
                 const UINT64 unusedRangeSize = freeSpace1stTo2ndEnd - lastOffset;
-                PrintDetailedMap_UnusedRange(json, lastOffset, unusedRangeSize);
+                writer.AddUnusedRange(lastOffset, unusedRangeSize);
             }
 
             // End of loop.
@@ -4240,12 +5581,12 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
                 {
                     // There is free space from lastOffset to suballoc.offset.
                     const UINT64 unusedRangeSize = suballoc.offset - lastOffset;
-                    PrintDetailedMap_UnusedRange(json, lastOffset, unusedRangeSize);
+                    writer.AddUnusedRange(lastOffset, unusedRangeSize);
                 }
 
                 // 2. Process this allocation.
                 // There is allocation with suballoc.offset, suballoc.size.
-                PrintDetailedMap_Allocation(json, suballoc.offset, suballoc.size, suballoc.privateData);
+                writer.AddAllocation(suballoc.offset, suballoc.size, suballoc.privateData);
 
                 // 3. Prepare for next iteration.
                 lastOffset = suballoc.offset + suballoc.size;
@@ -4258,7 +5599,7 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
                 {
                     // There is free space from lastOffset to size.
                     const UINT64 unusedRangeSize = size - lastOffset;
-                    PrintDetailedMap_UnusedRange(json, lastOffset, unusedRangeSize);
+                    writer.AddUnusedRange(lastOffset, unusedRangeSize);
                 }
 
                 // End of loop.
@@ -4267,7 +5608,7 @@ void BlockMetadata_Linear::WriteAllocationInfoToJson(JsonWriter& json) const
         }
     }
 
-    PrintDetailedMap_End(json);
+    writer.End();
 }
 
 void BlockMetadata_Linear::DebugLogAllAllocations() const
@@ -4430,156 +5771,1161 @@ void BlockMetadata_Linear::CleanupAfterFree()
         }
     }
 
-    D3D12MA_HEAVY_ASSERT(Validate());
+    D3D12MA_HEAVY_ASSERT(Validate());
+}
+
+bool BlockMetadata_Linear::CreateAllocationRequest_LowerAddress(
+    UINT64 allocSize,
+    UINT64 allocAlignment,
+    AllocationRequest* pAllocationRequest)
+{
+    const UINT64 blockSize = GetSize();
+    SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+
+    if (m_2ndVectorMode == SECOND_VECTOR_EMPTY || m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK)
+    {
+        // Try to allocate at the end of 1st vector.
+
+        UINT64 resultBaseOffset = 0;
+        if (!suballocations1st.empty())
+        {
+            const Suballocation& lastSuballoc = suballocations1st.back();
+            resultBaseOffset = lastSuballoc.offset + lastSuballoc.size + GetDebugMargin();
+        }
+
+        // Start from offset equal to beginning of free space.
+        UINT64 resultOffset = resultBaseOffset;
+        // Apply alignment.
+        resultOffset = AlignUp(resultOffset, allocAlignment);
+
+        const UINT64 freeSpaceEnd = m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK ?
+            suballocations2nd.back().offset : blockSize;
+
+        // There is enough free space at the end after alignment.
+        if (resultOffset + allocSize + GetDebugMargin() <= freeSpaceEnd)
+        {
+            // All tests passed: Success.
+            pAllocationRequest->allocHandle = (AllocHandle)(resultOffset + 1);
+            // pAllocationRequest->item, customData unused.
+            pAllocationRequest->algorithmData = ALLOC_REQUEST_END_OF_1ST;
+            return true;
+        }
+    }
+
+    // Wrap-around to end of 2nd vector. Try to allocate there, watching for the
+    // beginning of 1st vector as the end of free space.
+    if (m_2ndVectorMode == SECOND_VECTOR_EMPTY || m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER)
+    {
+        D3D12MA_ASSERT(!suballocations1st.empty());
+
+        UINT64 resultBaseOffset = 0;
+        if (!suballocations2nd.empty())
+        {
+            const Suballocation& lastSuballoc = suballocations2nd.back();
+            resultBaseOffset = lastSuballoc.offset + lastSuballoc.size + GetDebugMargin();
+        }
+
+        // Start from offset equal to beginning of free space.
+        UINT64 resultOffset = resultBaseOffset;
+
+        // Apply alignment.
+        resultOffset = AlignUp(resultOffset, allocAlignment);
+
+        size_t index1st = m_1stNullItemsBeginCount;
+        // There is enough free space at the end after alignment.
+        if ((index1st == suballocations1st.size() && resultOffset + allocSize + GetDebugMargin() <= blockSize) ||
+            (index1st < suballocations1st.size() && resultOffset + allocSize + GetDebugMargin() <= suballocations1st[index1st].offset))
+        {
+            // All tests passed: Success.
+            pAllocationRequest->allocHandle = (AllocHandle)(resultOffset + 1);
+            pAllocationRequest->algorithmData = ALLOC_REQUEST_END_OF_2ND;
+            // pAllocationRequest->item, customData unused.
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BlockMetadata_Linear::CreateAllocationRequest_UpperAddress(
+    UINT64 allocSize,
+    UINT64 allocAlignment,
+    AllocationRequest* pAllocationRequest)
+{
+    const UINT64 blockSize = GetSize();
+    SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+
+    if (m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER)
+    {
+        D3D12MA_ASSERT(0 && "Trying to use pool with linear algorithm as double stack, while it is already being used as ring buffer.");
+        return false;
+    }
+
+    // Try to allocate before 2nd.back(), or end of block if 2nd.empty().
+    if (allocSize > blockSize)
+    {
+        return false;
+    }
+    UINT64 resultBaseOffset = blockSize - allocSize;
+    if (!suballocations2nd.empty())
+    {
+        const Suballocation& lastSuballoc = suballocations2nd.back();
+        resultBaseOffset = lastSuballoc.offset - allocSize;
+        if (allocSize > lastSuballoc.offset)
+        {
+            return false;
+        }
+    }
+
+    // Start from offset equal to end of free space.
+    UINT64 resultOffset = resultBaseOffset;
+    // Apply debugMargin at the end.
+    if (GetDebugMargin() > 0)
+    {
+        if (resultOffset < GetDebugMargin())
+        {
+            return false;
+        }
+        resultOffset -= GetDebugMargin();
+    }
+
+    // Apply alignment.
+    resultOffset = AlignDown(resultOffset, allocAlignment);
+    // There is enough free space.
+    const UINT64 endOf1st = !suballocations1st.empty() ?
+        suballocations1st.back().offset + suballocations1st.back().size : 0;
+
+    if (endOf1st + GetDebugMargin() <= resultOffset)
+    {
+        // All tests passed: Success.
+        pAllocationRequest->allocHandle = (AllocHandle)(resultOffset + 1);
+        // pAllocationRequest->item unused.
+        pAllocationRequest->algorithmData = ALLOC_REQUEST_UPPER_ADDRESS;
+        return true;
+    }
+    return false;
+}
+#endif // _D3D12MA_BLOCK_METADATA_LINEAR_FUNCTIONS
+#endif // _D3D12MA_BLOCK_METADATA_LINEAR
+
+#ifndef _D3D12MA_BLOCK_METADATA_TLSF
+class BlockMetadata_TLSF : public BlockMetadata
+{
+public:
+    BlockMetadata_TLSF(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual);
+    virtual ~BlockMetadata_TLSF();
+
+    size_t GetAllocationCount() const override { return m_AllocCount; }
+    size_t GetFreeRegionsCount() const override { return m_BlocksFreeCount + 1; }
+    UINT64 GetSumFreeSize() const override { return m_BlocksFreeSize + m_NullBlock->size; }
+    UINT64 GetLargestFreeRegionSizeBound() const override;
+    bool IsEmpty() const override { return m_NullBlock->offset == 0; }
+    UINT64 GetAllocationOffset(AllocHandle allocHandle) const override { return ((Block*)allocHandle)->offset; };
+
+    void Init(UINT64 size) override;
+    bool Validate() const override;
+    void GetAllocationInfo(AllocHandle allocHandle, VIRTUAL_ALLOCATION_INFO& outInfo) const override;
+
+    bool CreateAllocationRequest(
+        UINT64 allocSize,
+        UINT64 allocAlignment,
+        bool upperAddress,
+        UINT32 strategy,
+        AllocationRequest* pAllocationRequest) override;
+
+    void Alloc(
+        const AllocationRequest& request,
+        UINT64 allocSize,
+        void* privateData) override;
+
+    void Free(AllocHandle allocHandle) override;
+    void Clear() override;
+
+    AllocHandle GetAllocationListBegin() const override;
+    AllocHandle GetNextAllocation(AllocHandle prevAlloc) const override;
+    UINT64 GetNextFreeRegionSize(AllocHandle alloc) const override;
+    void* GetAllocationPrivateData(AllocHandle allocHandle) const override;
+    void SetAllocationPrivateData(AllocHandle allocHandle, void* privateData) override;
+
+    void AddStatistics(Statistics& inoutStats) const override;
+    void AddDetailedStatistics(DetailedStatistics& inoutStats) const override;
+    void SetStatisticsSnapshot(StatisticsSnapshot* snapshot) override;
+    void WriteDetailedMap(DetailedMapWriter& writer) const override;
+    void DebugLogAllAllocations() const override;
+
+private:
+    // According to original paper it should be preferable 4 or 5:
+    // M. Masmano, I. Ripoll, A. Crespo, and J. Real "TLSF: a New Dynamic Memory Allocator for Real-Time Systems"
+    // http://www.gii.upv.es/tlsf/files/ecrts04_tlsf.pdf
+    static const UINT8 SECOND_LEVEL_INDEX = D3D12MA_TLSF_SECOND_LEVEL_INDEX;
+    static_assert(SECOND_LEVEL_INDEX >= 1 && SECOND_LEVEL_INDEX <= 6,
+        "D3D12MA_TLSF_SECOND_LEVEL_INDEX must be between 1 and 6.");
+#if D3D12MA_TLSF_SECOND_LEVEL_INDEX > 5
+    using InnerBitmap = UINT64;
+#else
+    using InnerBitmap = UINT32;
+#endif
+    static const UINT16 SMALL_BUFFER_SIZE = 256;
+    static const UINT INITIAL_BLOCK_ALLOC_COUNT = 16;
+    static const UINT8 MEMORY_CLASS_SHIFT = 7;
+    static const UINT8 MAX_MEMORY_CLASSES = 65 - MEMORY_CLASS_SHIFT;
+
+    class Block
+    {
+    public:
+        UINT64 offset;
+        UINT64 size;
+        Block* prevPhysical;
+        Block* nextPhysical;
+
+        void MarkFree() { prevFree = NULL; }
+        void MarkTaken() { prevFree = this; }
+        bool IsFree() const { return prevFree != this; }
+        void*& PrivateData() { D3D12MA_HEAVY_ASSERT(!IsFree()); return privateData; }
+        Block*& PrevFree() { return prevFree; }
+        Block*& NextFree() { D3D12MA_HEAVY_ASSERT(IsFree()); return nextFree; }
+
+    private:
+        Block* prevFree; // Address of the same block here indicates that block is taken
+        union
+        {
+            Block* nextFree;
+            void* privateData;
+        };
+    };
+    
+    size_t m_AllocCount = 0;
+    // Total number of free blocks besides null block
+    size_t m_BlocksFreeCount = 0;
+    // Total size of free blocks excluding null block
+    UINT64 m_BlocksFreeSize = 0;
+    UINT32 m_IsFreeBitmap = 0;
+    UINT8 m_MemoryClasses = 0;
+    InnerBitmap m_InnerIsFreeBitmap[MAX_MEMORY_CLASSES];
+    UINT32 m_ListsCount = 0;
+    /*
+    * 0: 0-3 lists for small buffers
+    * 1+: 0-(2^SLI-1) lists for normal buffers
+    */
+    Block** m_FreeList = NULL;
+    PoolAllocator<Block> m_BlockAllocator;
+    Block* m_NullBlock = NULL;
+    StatisticsSnapshot* m_pStatisticsSnapshot = NULL;
+
+    // Free lists of memory class 0 have granularity of 8 B in virtual blocks, 64 B otherwise.
+    UINT16 GetSmallSizeStep() const { return IsVirtual() ? 8 : 64; }
+    UINT32 GetSmallListCount() const { return SMALL_BUFFER_SIZE / GetSmallSizeStep(); }
+    UINT8 SizeToMemoryClass(UINT64 size) const;
+    UINT16 SizeToSecondIndex(UINT64 size, UINT8 memoryClass) const;
+    UINT32 GetListIndex(UINT8 memoryClass, UINT16 secondIndex) const;
+    UINT32 GetListIndex(UINT64 size) const;
+
+    void RemoveFreeBlock(Block* block);
+    void InsertFreeBlock(Block* block);
+    void MergeBlock(Block* block, Block* prev);
+
+    // Returns size from which FindFreeBlock finds only blocks not smaller than the given one.
+    UINT64 RoundUpToNextList(UINT64 size) const;
+    Block* FindFreeBlock(UINT64 size, UINT32& listIndex) const;
+    // With alignment, the first block of a list can still be too small for the allocation after aligning
+    // its offset, and walking a long list of such blocks is slow. Checks only the first block of the lowest
+    // list whose blocks fit the allocation at any offset.
+    bool CheckAnyOffsetBlock(UINT64 allocSize, UINT64 allocAlignment, AllocationRequest* pAllocationRequest);
+    bool CheckBlock(
+        Block& block,
+        UINT32 listIndex,
+        UINT64 allocSize,
+        UINT64 allocAlignment,
+        AllocationRequest* pAllocationRequest);
+
+    D3D12MA_CLASS_NO_COPY(BlockMetadata_TLSF)
+};
+
+#ifndef _D3D12MA_BLOCK_METADATA_TLSF_FUNCTIONS
+BlockMetadata_TLSF::BlockMetadata_TLSF(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual)
+    : BlockMetadata(allocationCallbacks, isVirtual),
+    m_BlockAllocator(*allocationCallbacks, INITIAL_BLOCK_ALLOC_COUNT)
+{
+    D3D12MA_ASSERT(allocationCallbacks);
+}
+
+BlockMetadata_TLSF::~BlockMetadata_TLSF()
+{
+    D3D12MA_DELETE_ARRAY(*GetAllocs(), m_FreeList, m_ListsCount);
+}
+
+void BlockMetadata_TLSF::Init(UINT64 size)
+{
+    BlockMetadata::Init(size);
+
+    m_NullBlock = m_BlockAllocator.Alloc();
+    m_NullBlock->size = size;
+    m_NullBlock->offset = 0;
+    m_NullBlock->prevPhysical = NULL;
+    m_NullBlock->nextPhysical = NULL;
+    m_NullBlock->MarkFree();
+    m_NullBlock->NextFree() = NULL;
+    m_NullBlock->PrevFree() = NULL;
+    UINT8 memoryClass = SizeToMemoryClass(size);
+    UINT16 sli = SizeToSecondIndex(size, memoryClass);
+    m_ListsCount = (memoryClass == 0 ? 0 : (memoryClass - 1) * (1UL << SECOND_LEVEL_INDEX) + sli) + 1;
+    m_ListsCount += GetSmallListCount();
+
+    m_MemoryClasses = memoryClass + 2;
+    memset(m_InnerIsFreeBitmap, 0, sizeof(m_InnerIsFreeBitmap));
+
+    m_FreeList = D3D12MA_NEW_ARRAY(*GetAllocs(), Block*, m_ListsCount);
+    memset(m_FreeList, 0, m_ListsCount * sizeof(Block*));
+}
+
+bool BlockMetadata_TLSF::Validate() const
+{
+    D3D12MA_VALIDATE(GetSumFreeSize() <= GetSize());
+
+    UINT64 calculatedSize = m_NullBlock->size;
+    UINT64 calculatedFreeSize = m_NullBlock->size;
+    size_t allocCount = 0;
+    size_t freeCount = 0;
+
+    // Check integrity of free lists
+    for (UINT32 list = 0; list < m_ListsCount; ++list)
+    {
+        Block* block = m_FreeList[list];
+        if (block != NULL)
+        {
+            D3D12MA_VALIDATE(block->IsFree());
+            D3D12MA_VALIDATE(block->PrevFree() == NULL);
+            while (block->NextFree())
+            {
+                D3D12MA_VALIDATE(block->NextFree()->IsFree());
+                D3D12MA_VALIDATE(block->NextFree()->PrevFree() == block);
+                block = block->NextFree();
+            }
+        }
+    }
+
+    D3D12MA_VALIDATE(m_NullBlock->nextPhysical == NULL);
+    if (m_NullBlock->prevPhysical)
+    {
+        D3D12MA_VALIDATE(m_NullBlock->prevPhysical->nextPhysical == m_NullBlock);
+    }
+
+    // Check all blocks
+    UINT64 nextOffset = m_NullBlock->offset;
+    for (Block* prev = m_NullBlock->prevPhysical; prev != NULL; prev = prev->prevPhysical)
+    {
+        D3D12MA_VALIDATE(prev->offset + prev->size == nextOffset);
+        nextOffset = prev->offset;
+        calculatedSize += prev->size;
+
+        UINT32 listIndex = GetListIndex(prev->size);
+        if (prev->IsFree())
+        {
+            ++freeCount;
+            // Check if free block belongs to free list
+            Block* freeBlock = m_FreeList[listIndex];
+            D3D12MA_VALIDATE(freeBlock != NULL);
+
+            bool found = false;
+            do
+            {
+                if (freeBlock == prev)
+                    found = true;
+
+                freeBlock = freeBlock->NextFree();
+            } while (!found && freeBlock != NULL);
+
+            D3D12MA_VALIDATE(found);
+            calculatedFreeSize += prev->size;
+        }
+        else
+        {
+            ++allocCount;
+            // Check if taken block is not on a free list
+            Block* freeBlock = m_FreeList[listIndex];
+            while (freeBlock)
+            {
+                D3D12MA_VALIDATE(freeBlock != prev);
+                freeBlock = freeBlock->NextFree();
+            }
+        }
+
+        if (prev->prevPhysical)
+        {
+            D3D12MA_VALIDATE(prev->prevPhysical->nextPhysical == prev);
+        }
+    }
+
+    D3D12MA_VALIDATE(nextOffset == 0);
+    D3D12MA_VALIDATE(calculatedSize == GetSize());
+    D3D12MA_VALIDATE(calculatedFreeSize == GetSumFreeSize());
+    D3D12MA_VALIDATE(allocCount == m_AllocCount);
+    D3D12MA_VALIDATE(freeCount == m_BlocksFreeCount);
+
+    return true;
+}
+
+void BlockMetadata_TLSF::GetAllocationInfo(AllocHandle allocHandle, VIRTUAL_ALLOCATION_INFO& outInfo) const
+{
+    Block* block = (Block*)allocHandle;
+    D3D12MA_ASSERT(!block->IsFree() && "Cannot get allocation info for free block!");
+    outInfo.Offset = block->offset;
+    outInfo.Size = block->size;
+    outInfo.pPrivateData = block->PrivateData();
+}
+
+UINT64 BlockMetadata_TLSF::GetLargestFreeRegionSizeBound() const
+{
+    if (m_IsFreeBitmap == 0)
+        return m_NullBlock->size;
+
+    // The highest non-empty free list limits the size of free blocks from above.
+    const UINT8 memoryClass = BitScanMSB(m_IsFreeBitmap);
+    const UINT16 secondIndex = BitScanMSB(m_InnerIsFreeBitmap[memoryClass]);
+    UINT64 listMaxSize;
+    if (memoryClass == 0)
+        listMaxSize = (secondIndex + 1ULL) * GetSmallSizeStep();
+    else
+    {
+        const UINT8 shift = memoryClass + MEMORY_CLASS_SHIFT - SECOND_LEVEL_INDEX;
+        listMaxSize = ((((1ULL << SECOND_LEVEL_INDEX) | secondIndex) + 1) << shift) - 1;
+    }
+    return D3D12MA_MIN(D3D12MA_MAX(listMaxSize, m_NullBlock->size), GetSumFreeSize());
+}
+
+bool BlockMetadata_TLSF::CreateAllocationRequest(
+    UINT64 allocSize,
+    UINT64 allocAlignment,
+    bool upperAddress,
+    UINT32 strategy,
+    AllocationRequest* pAllocationRequest)
+{
+    D3D12MA_ASSERT(allocSize > 0 && "Cannot allocate empty block!");
+    D3D12MA_ASSERT(!upperAddress && "ALLOCATION_FLAG_UPPER_ADDRESS can be used only with linear algorithm.");
+    D3D12MA_ASSERT(pAllocationRequest != NULL);
+    D3D12MA_HEAVY_ASSERT(Validate());
+
+    allocSize += GetDebugMargin();
+    // Quick check for too small pool
+    if (allocSize > GetLargestFreeRegionSizeBound())
+        return false;
+
+    // If no free blocks in pool then check only null block
+    if (m_BlocksFreeCount == 0)
+        return CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest);
+
+    // Round up to the next block
+    const UINT64 sizeForNextList = RoundUpToNextList(allocSize);
+
+    UINT32 nextListIndex = 0;
+    UINT32 prevListIndex = 0;
+    Block* nextListBlock = NULL;
+    Block* prevListBlock = NULL;
+
+    // Check blocks according to strategies
+    if (strategy & ALLOCATION_FLAG_STRATEGY_MIN_TIME)
+    {
+        // Quick check for larger block first
+        nextListBlock = FindFreeBlock(sizeForNextList, nextListIndex);
+        if (nextListBlock != NULL && CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
+            return true;
+
+        // Not fitted because of alignment, check block large enough for any offset
+        if (nextListBlock != NULL && CheckAnyOffsetBlock(allocSize, allocAlignment, pAllocationRequest))
+            return true;
+
+        // If not fitted then null block
+        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
+            return true;
+
+        // Null block failed, search larger bucket
+        while (nextListBlock)
+        {
+            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            nextListBlock = nextListBlock->NextFree();
+        }
+
+        // Failed again, check best fit bucket
+        prevListBlock = FindFreeBlock(allocSize, prevListIndex);
+        while (prevListBlock)
+        {
+            if (CheckBlock(*prevListBlock, prevListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            prevListBlock = prevListBlock->NextFree();
+        }
+    }
+    else if (strategy & ALLOCATION_FLAG_STRATEGY_MIN_MEMORY)
+    {
+        // Check best fit bucket
+        prevListBlock = FindFreeBlock(allocSize, prevListIndex);
+        while (prevListBlock)
+        {
+            if (CheckBlock(*prevListBlock, prevListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            prevListBlock = prevListBlock->NextFree();
+        }
+
+        // If failed check null block
+        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
+            return true;
+
+        // Check larger bucket, unless it is the best fit one, already checked
+        nextListBlock = FindFreeBlock(sizeForNextList, nextListIndex);
+        if (nextListIndex == prevListIndex)
+            nextListBlock = NULL;
+        while (nextListBlock)
+        {
+            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            nextListBlock = nextListBlock->NextFree();
+        }
+    }
+    else if (strategy & ALLOCATION_FLAG_STRATEGY_MIN_OFFSET)
+    {
+        // Find fitting block with the lowest offset among free lists that can contain it,
+        // skipping empty lists and smaller memory classes using the bitmaps
+        Block* lowestBlock = NULL;
+        UINT32 lowestListIndex = 0;
+        const UINT8 firstMemoryClass = SizeToMemoryClass(allocSize);
+        UINT32 freeMap = m_IsFreeBitmap & (~0UL << firstMemoryClass);
+        while (freeMap != 0)
+        {
+            const UINT8 memoryClass = BitScanLSB(freeMap);
+            freeMap &= freeMap - 1;
+            InnerBitmap innerFreeMap = m_InnerIsFreeBitmap[memoryClass];
+            if (memoryClass == firstMemoryClass)
+                innerFreeMap &= ~(InnerBitmap)0 << SizeToSecondIndex(allocSize, memoryClass);
+            while (innerFreeMap != 0)
+            {
+                const UINT32 listIndex = GetListIndex(memoryClass, BitScanLSB(innerFreeMap));
+                innerFreeMap &= innerFreeMap - 1;
+                for (Block* block = m_FreeList[listIndex]; block != NULL; block = block->NextFree())
+                {
+                    if ((lowestBlock == NULL || block->offset < lowestBlock->offset) &&
+                        block->size >= allocSize + AlignUp(block->offset, allocAlignment) - block->offset)
+                    {
+                        lowestBlock = block;
+                        lowestListIndex = listIndex;
+                    }
+                }
+            }
+        }
+        if (lowestBlock != NULL)
+            return CheckBlock(*lowestBlock, lowestListIndex, allocSize, allocAlignment, pAllocationRequest);
+
+        // If failed check null block
+        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
+            return true;
+
+        // Whole range searched, no more memory
+        return false;
+    }
+    else
+    {
+        // Check larger bucket
+        nextListBlock = FindFreeBlock(sizeForNextList, nextListIndex);
+        if (nextListBlock != NULL)
+        {
+            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            // Not fitted because of alignment, check block large enough for any offset before walking the list
+            if (CheckAnyOffsetBlock(allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            nextListBlock = nextListBlock->NextFree();
+        }
+        while (nextListBlock)
+        {
+            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            nextListBlock = nextListBlock->NextFree();
+        }
+
+        // If failed check null block
+        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
+            return true;
+
+        // Check best fit bucket
+        prevListBlock = FindFreeBlock(allocSize, prevListIndex);
+        while (prevListBlock)
+        {
+            if (CheckBlock(*prevListBlock, prevListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            prevListBlock = prevListBlock->NextFree();
+        }
+    }
+
+    // Worst case, full search has to be done
+    while (++nextListIndex < m_ListsCount)
+    {
+        nextListBlock = m_FreeList[nextListIndex];
+        while (nextListBlock)
+        {
+            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
+                return true;
+            nextListBlock = nextListBlock->NextFree();
+        }
+    }
+
+    // No more memory sadly
+    return false;
+}
+
+void BlockMetadata_TLSF::Alloc(
+    const AllocationRequest& request,
+    UINT64 allocSize,
+    void* privateData)
+{
+    // Get block and pop it from the free list
+    Block* currentBlock = (Block*)request.allocHandle;
+    UINT64 offset = request.algorithmData;
+    D3D12MA_ASSERT(currentBlock != NULL);
+    D3D12MA_ASSERT(currentBlock->offset <= offset);
+
+    StatisticsSnapshotUpdate snapshotUpdate(m_pStatisticsSnapshot);
+    const UINT64 oldNullBlockSize = m_NullBlock->size;
+
+    if (currentBlock != m_NullBlock)
+        RemoveFreeBlock(currentBlock);
+
+    // Append missing alignment to prev block or create new one
+    UINT64 misssingAlignment = offset - currentBlock->offset;
+    if (misssingAlignment)
+    {
+        Block* prevBlock = currentBlock->prevPhysical;
+        D3D12MA_ASSERT(prevBlock != NULL && "There should be no missing alignment at offset 0!");
+
+        if (prevBlock->IsFree() && prevBlock->size != GetDebugMargin())
+        {
+            UINT32 oldList = GetListIndex(prevBlock->size);
+            prevBlock->size += misssingAlignment;
+            // Check if new size crosses list bucket
+            if (oldList != GetListIndex(prevBlock->size))
+            {
+                prevBlock->size -= misssingAlignment;
+                RemoveFreeBlock(prevBlock);
+                prevBlock->size += misssingAlignment;
+                InsertFreeBlock(prevBlock);
+            }
+            else
+            {
+                m_BlocksFreeSize += misssingAlignment;
+                if (m_pStatisticsSnapshot)
+                {
+                    m_pStatisticsSnapshot->RemoveUnusedRange(prevBlock->size - misssingAlignment);
+                    m_pStatisticsSnapshot->AddUnusedRange(prevBlock->size);
+                }
+            }
+        }
+        else
+        {
+            Block* newBlock = m_BlockAllocator.Alloc();
+            currentBlock->prevPhysical = newBlock;
+            prevBlock->nextPhysical = newBlock;
+            newBlock->prevPhysical = prevBlock;
+            newBlock->nextPhysical = currentBlock;
+            newBlock->size = misssingAlignment;
+            newBlock->offset = currentBlock->offset;
+            newBlock->MarkTaken();
+
+            InsertFreeBlock(newBlock);
+        }
+
+        currentBlock->size -= misssingAlignment;
+        currentBlock->offset += misssingAlignment;
+    }
+
+    UINT64 size = request.size + GetDebugMargin();
+    if (currentBlock->size == size)
+    {
+        if (currentBlock == m_NullBlock)
+        {
+            // Setup new null block
+            m_NullBlock = m_BlockAllocator.Alloc();
+            m_NullBlock->size = 0;
+            m_NullBlock->offset = currentBlock->offset + size;
+            m_NullBlock->prevPhysical = currentBlock;
+            m_NullBlock->nextPhysical = NULL;
+            m_NullBlock->MarkFree();
+            m_NullBlock->PrevFree() = NULL;
+            m_NullBlock->NextFree() = NULL;
+            currentBlock->nextPhysical = m_NullBlock;
+            currentBlock->MarkTaken();
+        }
+    }
+    else
+    {
+        D3D12MA_ASSERT(currentBlock->size > size && "Proper block already found, shouldn't find smaller one!");
+
+        // Create new free block
+        Block* newBlock = m_BlockAllocator.Alloc();
+        newBlock->size = currentBlock->size - size;
+        newBlock->offset = currentBlock->offset + size;
+        newBlock->prevPhysical = currentBlock;
+        newBlock->nextPhysical = currentBlock->nextPhysical;
+        currentBlock->nextPhysical = newBlock;
+        currentBlock->size = size;
+
+        if (currentBlock == m_NullBlock)
+        {
+            m_NullBlock = newBlock;
+            m_NullBlock->MarkFree();
+            m_NullBlock->NextFree() = NULL;
+            m_NullBlock->PrevFree() = NULL;
+            currentBlock->MarkTaken();
+        }
+        else
+        {
+            newBlock->nextPhysical->prevPhysical = newBlock;
+            newBlock->MarkTaken();
+            InsertFreeBlock(newBlock);
+        }
+    }
+    currentBlock->PrivateData() = privateData;
+
+    if (GetDebugMargin() > 0)
+    {
+        currentBlock->size -= GetDebugMargin();
+        Block* newBlock = m_BlockAllocator.Alloc();
+        newBlock->size = GetDebugMargin();
+        newBlock->offset = currentBlock->offset + currentBlock->size;
+        newBlock->prevPhysical = currentBlock;
+        newBlock->nextPhysical = currentBlock->nextPhysical;
+        newBlock->MarkTaken();
+        currentBlock->nextPhysical->prevPhysical = newBlock;
+        currentBlock->nextPhysical = newBlock;
+        InsertFreeBlock(newBlock);
+    }
+    ++m_AllocCount;
+
+    if (m_pStatisticsSnapshot)
+    {
+        m_pStatisticsSnapshot->AddAllocation(currentBlock->size);
+        if (oldNullBlockSize > 0)
+            m_pStatisticsSnapshot->RemoveUnusedRange(oldNullBlockSize);
+        if (m_NullBlock->size > 0)
+            m_pStatisticsSnapshot->AddUnusedRange(m_NullBlock->size);
+    }
+}
+
+void BlockMetadata_TLSF::Free(AllocHandle allocHandle)
+{
+    Block* block = (Block*)allocHandle;
+    Block* next = block->nextPhysical;
+    D3D12MA_ASSERT(!block->IsFree() && "Block is already free!");
+
+    StatisticsSnapshotUpdate snapshotUpdate(m_pStatisticsSnapshot);
+    const UINT64 oldNullBlockSize = m_NullBlock->size;
+    if (m_pStatisticsSnapshot)
+        m_pStatisticsSnapshot->RemoveAllocation(block->size);
+
+    --m_AllocCount;
+    if (GetDebugMargin() > 0)
+    {
+        RemoveFreeBlock(next);
+        MergeBlock(next, block);
+        block = next;
+        next = next->nextPhysical;
+    }
+
+    // Try merging
+    Block* prev = block->prevPhysical;
+    if (prev != NULL && prev->IsFree() && prev->size != GetDebugMargin())
+    {
+        RemoveFreeBlock(prev);
+        MergeBlock(block, prev);
+    }
+
+    if (!next->IsFree())
+        InsertFreeBlock(block);
+    else if (next == m_NullBlock)
+        MergeBlock(m_NullBlock, block);
+    else
+    {
+        RemoveFreeBlock(next);
+        MergeBlock(next, block);
+        InsertFreeBlock(next);
+    }
+
+    if (m_pStatisticsSnapshot && m_NullBlock->size != oldNullBlockSize)
+    {
+        if (oldNullBlockSize > 0)
+            m_pStatisticsSnapshot->RemoveUnusedRange(oldNullBlockSize);
+        m_pStatisticsSnapshot->AddUnusedRange(m_NullBlock->size);
+    }
+}
+
+void BlockMetadata_TLSF::Clear()
+{
+    D3D12MA_ASSERT(m_pStatisticsSnapshot == NULL);
+
+    m_AllocCount = 0;
+    m_BlocksFreeCount = 0;
+    m_BlocksFreeSize = 0;
+    m_IsFreeBitmap = 0;
+    m_NullBlock->offset = 0;
+    m_NullBlock->size = GetSize();
+    Block* block = m_NullBlock->prevPhysical;
+    m_NullBlock->prevPhysical = NULL;
+    while (block)
+    {
+        Block* prev = block->prevPhysical;
+        m_BlockAllocator.Free(block);
+        block = prev;
+    }
+    memset(m_FreeList, 0, m_ListsCount * sizeof(Block*));
+    memset(m_InnerIsFreeBitmap, 0, m_MemoryClasses * sizeof(UINT32));
+}
+
+AllocHandle BlockMetadata_TLSF::GetAllocationListBegin() const
+{
+    if (m_AllocCount == 0)
+        return (AllocHandle)0;
+
+    for (Block* block = m_NullBlock->prevPhysical; block; block = block->prevPhysical)
+    {
+        if (!block->IsFree())
+            return (AllocHandle)block;
+    }
+    D3D12MA_ASSERT(false && "If m_AllocCount > 0 then should find any allocation!");
+    return (AllocHandle)0;
+}
+
+AllocHandle BlockMetadata_TLSF::GetNextAllocation(AllocHandle prevAlloc) const
+{
+    Block* startBlock = (Block*)prevAlloc;
+    D3D12MA_ASSERT(!startBlock->IsFree() && "Incorrect block!");
+
+    for (Block* block = startBlock->prevPhysical; block; block = block->prevPhysical)
+    {
+        if (!block->IsFree())
+            return (AllocHandle)block;
+    }
+    return (AllocHandle)0;
+}
+
+UINT64 BlockMetadata_TLSF::GetNextFreeRegionSize(AllocHandle alloc) const
+{
+    Block* block = (Block*)alloc;
+    D3D12MA_ASSERT(!block->IsFree() && "Incorrect block!");
+
+    if (block->prevPhysical)
+        return block->prevPhysical->IsFree() ? block->prevPhysical->size : 0;
+    return 0;
+}
+
+void* BlockMetadata_TLSF::GetAllocationPrivateData(AllocHandle allocHandle) const
+{
+    Block* block = (Block*)allocHandle;
+    D3D12MA_ASSERT(!block->IsFree() && "Cannot get user data for free block!");
+    return block->PrivateData();
+}
+
+void BlockMetadata_TLSF::SetAllocationPrivateData(AllocHandle allocHandle, void* privateData)
+{
+    Block* block = (Block*)allocHandle;
+    D3D12MA_ASSERT(!block->IsFree() && "Trying to set user data for not allocated block!");
+    block->PrivateData() = privateData;
+}
+
+void BlockMetadata_TLSF::AddStatistics(Statistics& inoutStats) const
+{
+    inoutStats.BlockCount++;
+    inoutStats.AllocationCount += static_cast<UINT>(m_AllocCount);
+    inoutStats.BlockBytes += GetSize();
+    inoutStats.AllocationBytes += GetSize() - GetSumFreeSize();
+}
+
+void BlockMetadata_TLSF::AddDetailedStatistics(DetailedStatistics& inoutStats) const
+{
+    inoutStats.Stats.BlockCount++;
+    inoutStats.Stats.BlockBytes += GetSize();
+
+    for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
+    {
+        if (block->IsFree())
+            AddDetailedStatisticsUnusedRange(inoutStats, block->size);
+        else
+            AddDetailedStatisticsAllocation(inoutStats, block->size);
+    }
+
+    if (m_NullBlock->size > 0)
+        AddDetailedStatisticsUnusedRange(inoutStats, m_NullBlock->size);
 }
 
-bool BlockMetadata_Linear::CreateAllocationRequest_LowerAddress(
-    UINT64 allocSize,
-    UINT64 allocAlignment,
-    AllocationRequest* pAllocationRequest)
+void BlockMetadata_TLSF::SetStatisticsSnapshot(StatisticsSnapshot* snapshot)
 {
-    const UINT64 blockSize = GetSize();
-    SuballocationVectorType& suballocations1st = AccessSuballocations1st();
-    SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+    StatisticsSnapshot* const reported = snapshot ? snapshot : m_pStatisticsSnapshot;
+    D3D12MA_ASSERT((snapshot == NULL) != (m_pStatisticsSnapshot == NULL));
 
-    if (m_2ndVectorMode == SECOND_VECTOR_EMPTY || m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK)
+    for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
     {
-        // Try to allocate at the end of 1st vector.
-
-        UINT64 resultBaseOffset = 0;
-        if (!suballocations1st.empty())
+        if (block->IsFree())
         {
-            const Suballocation& lastSuballoc = suballocations1st.back();
-            resultBaseOffset = lastSuballoc.offset + lastSuballoc.size + GetDebugMargin();
+            if (snapshot)
+                reported->AddUnusedRange(block->size);
+            else
+                reported->RemoveUnusedRange(block->size);
         }
+        else if (snapshot)
+            reported->AddAllocation(block->size);
+        else
+            reported->RemoveAllocation(block->size);
+    }
+    if (m_NullBlock->size > 0)
+    {
+        if (snapshot)
+            reported->AddUnusedRange(m_NullBlock->size);
+        else
+            reported->RemoveUnusedRange(m_NullBlock->size);
+    }
+    m_pStatisticsSnapshot = snapshot;
+}
 
-        // Start from offset equal to beginning of free space.
-        UINT64 resultOffset = resultBaseOffset;
-        // Apply alignment.
-        resultOffset = AlignUp(resultOffset, allocAlignment);
-
-        const UINT64 freeSpaceEnd = m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK ?
-            suballocations2nd.back().offset : blockSize;
+void BlockMetadata_TLSF::WriteDetailedMap(DetailedMapWriter& writer) const
+{
+    size_t blockCount = m_AllocCount + m_BlocksFreeCount;
+    Vector<Block*> blockList(blockCount, *GetAllocs());
 
-        // There is enough free space at the end after alignment.
-        if (resultOffset + allocSize + GetDebugMargin() <= freeSpaceEnd)
-        {
-            // All tests passed: Success.
-            pAllocationRequest->allocHandle = (AllocHandle)(resultOffset + 1);
-            // pAllocationRequest->item, customData unused.
-            pAllocationRequest->algorithmData = ALLOC_REQUEST_END_OF_1ST;
-            return true;
-        }
+    size_t i = blockCount;
+    if (m_NullBlock->size > 0)
+    {
+        ++blockCount;
+        blockList.push_back(m_NullBlock);
+    }
+    for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
+    {
+        blockList[--i] = block;
     }
+    D3D12MA_ASSERT(i == 0);
 
-    // Wrap-around to end of 2nd vector. Try to allocate there, watching for the
-    // beginning of 1st vector as the end of free space.
-    if (m_2ndVectorMode == SECOND_VECTOR_EMPTY || m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER)
+    writer.Begin(GetSize(), GetSumFreeSize(), GetAllocationCount(), m_BlocksFreeCount +
+        (m_NullBlock->size > 0 ? 1 : 0));
+    for (; i < blockCount; ++i)
     {
-        D3D12MA_ASSERT(!suballocations1st.empty());
+        Block* block = blockList[i];
+        if (block->IsFree())
+            writer.AddUnusedRange(block->offset, block->size);
+        else
+            writer.AddAllocation(block->offset, block->size, block->PrivateData());
+    }
+    writer.End();
+}
 
-        UINT64 resultBaseOffset = 0;
-        if (!suballocations2nd.empty())
+void BlockMetadata_TLSF::DebugLogAllAllocations() const
+{
+    for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
+    {
+        if (!block->IsFree())
         {
-            const Suballocation& lastSuballoc = suballocations2nd.back();
-            resultBaseOffset = lastSuballoc.offset + lastSuballoc.size + GetDebugMargin();
+            DebugLogAllocation(block->offset, block->size, block->PrivateData());
         }
+    }
+}
 
-        // Start from offset equal to beginning of free space.
-        UINT64 resultOffset = resultBaseOffset;
+UINT8 BlockMetadata_TLSF::SizeToMemoryClass(UINT64 size) const
+{
+    if (size > SMALL_BUFFER_SIZE)
+        return BitScanMSB(size) - MEMORY_CLASS_SHIFT;
+    return 0;
+}
 
-        // Apply alignment.
-        resultOffset = AlignUp(resultOffset, allocAlignment);
+UINT16 BlockMetadata_TLSF::SizeToSecondIndex(UINT64 size, UINT8 memoryClass) const
+{
+    if (memoryClass == 0)
+        return static_cast<UINT16>((size - 1) / GetSmallSizeStep());
+    return static_cast<UINT16>((size >> (memoryClass + MEMORY_CLASS_SHIFT - SECOND_LEVEL_INDEX)) ^ (1U << SECOND_LEVEL_INDEX));
+}
 
-        size_t index1st = m_1stNullItemsBeginCount;
-        // There is enough free space at the end after alignment.
-        if ((index1st == suballocations1st.size() && resultOffset + allocSize + GetDebugMargin() <= blockSize) ||
-            (index1st < suballocations1st.size() && resultOffset + allocSize + GetDebugMargin() <= suballocations1st[index1st].offset))
+UINT32 BlockMetadata_TLSF::GetListIndex(UINT8 memoryClass, UINT16 secondIndex) const
+{
+    if (memoryClass == 0)
+        return secondIndex;
+
+    const UINT32 index = static_cast<UINT32>(memoryClass - 1) * (1 << SECOND_LEVEL_INDEX) + secondIndex;
+    return index + GetSmallListCount();
+}
+
+UINT32 BlockMetadata_TLSF::GetListIndex(UINT64 size) const
+{
+    UINT8 memoryClass = SizeToMemoryClass(size);
+    return GetListIndex(memoryClass, SizeToSecondIndex(size, memoryClass));
+}
+
+void BlockMetadata_TLSF::RemoveFreeBlock(Block* block)
+{
+    D3D12MA_ASSERT(block != m_NullBlock);
+    D3D12MA_ASSERT(block->IsFree());
+
+    if (block->NextFree() != NULL)
+        block->NextFree()->PrevFree() = block->PrevFree();
+    if (block->PrevFree() != NULL)
+        block->PrevFree()->NextFree() = block->NextFree();
+    else
+    {
+        UINT8 memClass = SizeToMemoryClass(block->size);
+        UINT16 secondIndex = SizeToSecondIndex(block->size, memClass);
+        UINT32 index = GetListIndex(memClass, secondIndex);
+        m_FreeList[index] = block->NextFree();
+        if (block->NextFree() == NULL)
         {
-            // All tests passed: Success.
-            pAllocationRequest->allocHandle = (AllocHandle)(resultOffset + 1);
-            pAllocationRequest->algorithmData = ALLOC_REQUEST_END_OF_2ND;
-            // pAllocationRequest->item, customData unused.
-            return true;
+            m_InnerIsFreeBitmap[memClass] &= ~((InnerBitmap)1 << secondIndex);
+            if (m_InnerIsFreeBitmap[memClass] == 0)
+                m_IsFreeBitmap &= ~(1UL << memClass);
         }
     }
-    return false;
+    block->MarkTaken();
+    block->PrivateData() = NULL;
+    --m_BlocksFreeCount;
+    m_BlocksFreeSize -= block->size;
+    if (m_pStatisticsSnapshot)
+        m_pStatisticsSnapshot->RemoveUnusedRange(block->size);
 }
 
-bool BlockMetadata_Linear::CreateAllocationRequest_UpperAddress(
-    UINT64 allocSize,
-    UINT64 allocAlignment,
-    AllocationRequest* pAllocationRequest)
+void BlockMetadata_TLSF::InsertFreeBlock(Block* block)
 {
-    const UINT64 blockSize = GetSize();
-    SuballocationVectorType& suballocations1st = AccessSuballocations1st();
-    SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+    D3D12MA_ASSERT(block != m_NullBlock);
+    D3D12MA_ASSERT(!block->IsFree() && "Cannot insert block twice!");
 
-    if (m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER)
+    UINT8 memClass = SizeToMemoryClass(block->size);
+    UINT16 secondIndex = SizeToSecondIndex(block->size, memClass);
+    UINT32 index = GetListIndex(memClass, secondIndex);
+    block->PrevFree() = NULL;
+    block->NextFree() = m_FreeList[index];
+    m_FreeList[index] = block;
+    if (block->NextFree() != NULL)
+        block->NextFree()->PrevFree() = block;
+    else
     {
-        D3D12MA_ASSERT(0 && "Trying to use pool with linear algorithm as double stack, while it is already being used as ring buffer.");
-        return false;
+        m_InnerIsFreeBitmap[memClass] |= (InnerBitmap)1 << secondIndex;
+        m_IsFreeBitmap |= 1UL << memClass;
     }
+    ++m_BlocksFreeCount;
+    m_BlocksFreeSize += block->size;
+    if (m_pStatisticsSnapshot)
+        m_pStatisticsSnapshot->AddUnusedRange(block->size);
+}
 
-    // Try to allocate before 2nd.back(), or end of block if 2nd.empty().
-    if (allocSize > blockSize)
-    {
-        return false;
-    }
-    UINT64 resultBaseOffset = blockSize - allocSize;
-    if (!suballocations2nd.empty())
-    {
-        const Suballocation& lastSuballoc = suballocations2nd.back();
-        resultBaseOffset = lastSuballoc.offset - allocSize;
-        if (allocSize > lastSuballoc.offset)
-        {
-            return false;
-        }
-    }
+void BlockMetadata_TLSF::MergeBlock(Block* block, Block* prev)
+{
+    D3D12MA_ASSERT(block->prevPhysical == prev && "Cannot merge seperate physical regions!");
+    D3D12MA_ASSERT(!prev->IsFree() && "Cannot merge block that belongs to free list!");
 
-    // Start from offset equal to end of free space.
-    UINT64 resultOffset = resultBaseOffset;
-    // Apply debugMargin at the end.
-    if (GetDebugMargin() > 0)
+    block->offset = prev->offset;
+    block->size += prev->size;
+    block->prevPhysical = prev->prevPhysical;
+    if (block->prevPhysical)
+        block->prevPhysical->nextPhysical = block;
+    m_BlockAllocator.Free(prev);
+}
+
+UINT64 BlockMetadata_TLSF::RoundUpToNextList(UINT64 size) const
+{
+    const UINT16 smallSizeStep = GetSmallSizeStep();
+    if (size > SMALL_BUFFER_SIZE)
+        return size + (1ULL << (BitScanMSB(size) - SECOND_LEVEL_INDEX));
+    if (size > SMALL_BUFFER_SIZE - smallSizeStep)
+        return SMALL_BUFFER_SIZE + 1;
+    return size + smallSizeStep;
+}
+
+BlockMetadata_TLSF::Block* BlockMetadata_TLSF::FindFreeBlock(UINT64 size, UINT32& listIndex) const
+{
+    UINT8 memoryClass = SizeToMemoryClass(size);
+    InnerBitmap innerFreeMap = m_InnerIsFreeBitmap[memoryClass] & (~(InnerBitmap)0 << SizeToSecondIndex(size, memoryClass));
+    if (!innerFreeMap)
     {
-        if (resultOffset < GetDebugMargin())
-        {
-            return false;
-        }
-        resultOffset -= GetDebugMargin();
+        // Check higher levels for avaiable blocks
+        UINT32 freeMap = m_IsFreeBitmap & (~0UL << (memoryClass + 1));
+        if (!freeMap)
+            return NULL; // No more memory avaible
+
+        // Find lowest free region
+        memoryClass = BitScanLSB(freeMap);
+        innerFreeMap = m_InnerIsFreeBitmap[memoryClass];
+        D3D12MA_ASSERT(innerFreeMap != 0);
     }
+    // Find lowest free subregion
+    listIndex = GetListIndex(memoryClass, BitScanLSB(innerFreeMap));
+    return m_FreeList[listIndex];
+}
+
+bool BlockMetadata_TLSF::CheckAnyOffsetBlock(UINT64 allocSize, UINT64 allocAlignment, AllocationRequest* pAllocationRequest)
+{
+    if (allocAlignment <= 1)
+        return false;
+    const UINT64 sizeForAnyOffset = RoundUpToNextList(allocSize + allocAlignment - 1);
+    if (sizeForAnyOffset > GetLargestFreeRegionSizeBound())
+        return false;
+
+    UINT32 listIndex = 0;
+    Block* block = FindFreeBlock(sizeForAnyOffset, listIndex);
+    return block != NULL && CheckBlock(*block, listIndex, allocSize, allocAlignment, pAllocationRequest);
+}
+
+bool BlockMetadata_TLSF::CheckBlock(
+    Block& block,
+    UINT32 listIndex,
+    UINT64 allocSize,
+    UINT64 allocAlignment,
+    AllocationRequest* pAllocationRequest)
+{
+    D3D12MA_ASSERT(block.IsFree() && "Block is already taken!");
+
+    UINT64 alignedOffset = AlignUp(block.offset, allocAlignment);
+    if (block.size < allocSize + alignedOffset - block.offset)
+        return false;
 
-    // Apply alignment.
-    resultOffset = AlignDown(resultOffset, allocAlignment);
-    // There is enough free space.
-    const UINT64 endOf1st = !suballocations1st.empty() ?
-        suballocations1st.back().offset + suballocations1st.back().size : 0;
+    // Alloc successful
+    pAllocationRequest->allocHandle = (AllocHandle)&block;
+    pAllocationRequest->size = allocSize - GetDebugMargin();
+    pAllocationRequest->algorithmData = alignedOffset;
 
-    if (endOf1st + GetDebugMargin() <= resultOffset)
+    // Place block at the start of list if it's normal block
+    if (listIndex != m_ListsCount && block.PrevFree())
     {
-        // All tests passed: Success.
-        pAllocationRequest->allocHandle = (AllocHandle)(resultOffset + 1);
-        // pAllocationRequest->item unused.
-        pAllocationRequest->algorithmData = ALLOC_REQUEST_UPPER_ADDRESS;
-        return true;
+        block.PrevFree()->NextFree() = block.NextFree();
+        if (block.NextFree())
+            block.NextFree()->PrevFree() = block.PrevFree();
+        block.PrevFree() = NULL;
+        block.NextFree() = m_FreeList[listIndex];
+        m_FreeList[listIndex] = &block;
+        if (block.NextFree())
+            block.NextFree()->PrevFree() = &block;
     }
-    return false;
+
+    return true;
 }
-#endif // _D3D12MA_BLOCK_METADATA_LINEAR_FUNCTIONS
-#endif // _D3D12MA_BLOCK_METADATA_LINEAR
+#endif // _D3D12MA_BLOCK_METADATA_TLSF_FUNCTIONS
+#endif // _D3D12MA_BLOCK_METADATA_TLSF
 
-#ifndef _D3D12MA_BLOCK_METADATA_TLSF
-class BlockMetadata_TLSF : public BlockMetadata
+#ifndef _D3D12MA_BLOCK_METADATA_BUDDY
+/*
+Buddy allocation algorithm, used with POOL_FLAG_ALGORITHM_BUDDY.
+
+The largest power of 2 not greater than the block size is managed as a binary tree of nodes,
+each of them either free, allocated, or split into two halves called buddies. The rest of
+the block is never used. An allocation takes a whole node of the smallest size it fits in,
+so every node is aligned to its size and the rounded up part stays unused until the
+allocation is freed. Free nodes of each level are kept in a separate list, so both Alloc and
+Free take time proportional to the number of levels, and a freed node is merged back with
+its buddy as long as both are free.
+
+Allocation handle is offset + 1, so the node is found by descending the tree from the root.
+*/
+class BlockMetadata_Buddy : public BlockMetadata
 {
 public:
-    BlockMetadata_TLSF(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual);
-    virtual ~BlockMetadata_TLSF();
+    BlockMetadata_Buddy(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual);
+    virtual ~BlockMetadata_Buddy() = default;
 
-    size_t GetAllocationCount() const override { return m_AllocCount; }
-    size_t GetFreeRegionsCount() const override { return m_BlocksFreeCount + 1; }
-    UINT64 GetSumFreeSize() const override { return m_BlocksFreeSize + m_NullBlock->size; }
-    bool IsEmpty() const override { return m_NullBlock->offset == 0; }
-    UINT64 GetAllocationOffset(AllocHandle allocHandle) const override { return ((Block*)allocHandle)->offset; };
+    size_t GetAllocationCount() const override { return m_AllocationCount; }
+    size_t GetFreeRegionsCount() const override { return m_FreeCount + (GetUnusableSize() > 0 ? 1 : 0); }
+    UINT64 GetSumFreeSize() const override { return GetSize() - m_AllocationBytes; }
+    UINT64 GetLargestFreeRegionSizeBound() const override;
+    bool IsEmpty() const override { return m_AllocationCount == 0; }
+    UINT64 GetAllocationOffset(AllocHandle allocHandle) const override { return (UINT64)allocHandle - 1; }
 
     void Init(UINT64 size) override;
     bool Validate() const override;
@@ -4608,820 +6954,1043 @@ public:
 
     void AddStatistics(Statistics& inoutStats) const override;
     void AddDetailedStatistics(DetailedStatistics& inoutStats) const override;
-    void WriteAllocationInfoToJson(JsonWriter& json) const override;
+    void SetStatisticsSnapshot(StatisticsSnapshot* snapshot) override;
+    void WriteDetailedMap(DetailedMapWriter& writer) const override;
     void DebugLogAllAllocations() const override;
 
 private:
-    // According to original paper it should be preferable 4 or 5:
-    // M. Masmano, I. Ripoll, A. Crespo, and J. Real "TLSF: a New Dynamic Memory Allocator for Real-Time Systems"
-    // http://www.gii.upv.es/tlsf/files/ecrts04_tlsf.pdf
-    static const UINT8 SECOND_LEVEL_INDEX = 5;
-    static const UINT16 SMALL_BUFFER_SIZE = 256;
-    static const UINT INITIAL_BLOCK_ALLOC_COUNT = 16;
-    static const UINT8 MEMORY_CLASS_SHIFT = 7;
-    static const UINT8 MAX_MEMORY_CLASSES = 65 - MEMORY_CLASS_SHIFT;
+    static const UINT MAX_LEVELS = 48;
+    // Smallest node in a heap, equal to D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT.
+    static const UINT64 MIN_NODE_SIZE = 256;
+    static const UINT INITIAL_NODE_PAIR_ALLOC_COUNT = 16;
 
-    class Block
+    struct NodePair;
+    struct Node
     {
-    public:
-        UINT64 offset;
-        UINT64 size;
-        Block* prevPhysical;
-        Block* nextPhysical;
-
-        void MarkFree() { prevFree = NULL; }
-        void MarkTaken() { prevFree = this; }
-        bool IsFree() const { return prevFree != this; }
-        void*& PrivateData() { D3D12MA_HEAVY_ASSERT(!IsFree()); return privateData; }
-        Block*& PrevFree() { return prevFree; }
-        Block*& NextFree() { D3D12MA_HEAVY_ASSERT(IsFree()); return nextFree; }
+        enum TYPE : UINT8
+        {
+            TYPE_FREE,
+            TYPE_ALLOCATION,
+            TYPE_SPLIT,
+        };
 
-    private:
-        Block* prevFree; // Address of the same block here indicates that block is taken
+        UINT64 offset;
+        Node* parent;
+        TYPE type;
         union
         {
-            Block* nextFree;
-            void* privateData;
+            struct
+            {
+                Node* prev;
+                Node* next;
+            } free;
+            struct
+            {
+                void* privateData;
+                UINT64 size;
+            } allocation;
+            struct
+            {
+                NodePair* children;
+            } split;
         };
     };
-    
-    size_t m_AllocCount = 0;
-    // Total number of free blocks besides null block
-    size_t m_BlocksFreeCount = 0;
-    // Total size of free blocks excluding null block
-    UINT64 m_BlocksFreeSize = 0;
-    UINT32 m_IsFreeBitmap = 0;
-    UINT8 m_MemoryClasses = 0;
-    UINT32 m_InnerIsFreeBitmap[MAX_MEMORY_CLASSES];
-    UINT32 m_ListsCount = 0;
-    /*
-    * 0: 0-3 lists for small buffers
-    * 1+: 0-(2^SLI-1) lists for normal buffers
-    */
-    Block** m_FreeList = NULL;
-    PoolAllocator<Block> m_BlockAllocator;
-    Block* m_NullBlock = NULL;
-
-    UINT8 SizeToMemoryClass(UINT64 size) const;
-    UINT16 SizeToSecondIndex(UINT64 size, UINT8 memoryClass) const;
-    UINT32 GetListIndex(UINT8 memoryClass, UINT16 secondIndex) const;
-    UINT32 GetListIndex(UINT64 size) const;
-
-    void RemoveFreeBlock(Block* block);
-    void InsertFreeBlock(Block* block);
-    void MergeBlock(Block* block, Block* prev);
-
-    Block* FindFreeBlock(UINT64 size, UINT32& listIndex) const;
-    bool CheckBlock(
-        Block& block,
-        UINT32 listIndex,
-        UINT64 allocSize,
-        UINT64 allocAlignment,
-        AllocationRequest* pAllocationRequest);
+    // Both halves of a split node are allocated together, so the buddy of a node is found through its parent.
+    struct NodePair
+    {
+        Node nodes[2];
+    };
 
-    D3D12MA_CLASS_NO_COPY(BlockMetadata_TLSF)
+    UINT64 m_UsableSize = 0;
+    UINT m_LevelCount = 0;
+    size_t m_AllocationCount = 0;
+    // Number of free nodes.
+    size_t m_FreeCount = 0;
+    // Sum of sizes of allocations, excluding debug margins and the unused rest of their nodes.
+    UINT64 m_AllocationBytes = 0;
+    // Bit i is set when m_FreeList[i] is not empty.
+    UINT64 m_FreeLevelBitmap = 0;
+    Node* m_FreeList[MAX_LEVELS] = {};
+    Node m_Root = {};
+    PoolAllocator<NodePair> m_NodePairAllocator;
+    StatisticsSnapshot* m_pStatisticsSnapshot = NULL;
+
+    UINT64 GetUnusableSize() const { return GetSize() - m_UsableSize; }
+    UINT64 LevelToNodeSize(UINT level) const { return m_UsableSize >> level; }
+    // Returns the deepest level with nodes not smaller than size.
+    UINT SizeToLevel(UINT64 size) const;
+
+    void AddToFreeList(Node* node, UINT level);
+    void RemoveFromFreeList(Node* node, UINT level);
+    // Returns the free or allocated node containing the offset.
+    Node* FindLeaf(UINT64 offset, UINT& outLevel) const;
+    // Returns the allocation with the lowest offset not less than minOffset, or null.
+    const Node* FindAllocation(const Node& node, UINT64 nodeSize, UINT64 minOffset) const;
+    // Calls func(node, nodeSize) for every free or allocated node, in the order of offsets.
+    template<typename FuncT>
+    void ForEachLeaf(const Node& node, UINT64 nodeSize, FuncT& func) const;
+    bool ValidateNode(const Node& node, const Node* parent, UINT level,
+        size_t& inoutFreeCount, size_t& inoutAllocationCount, UINT64& inoutAllocationBytes) const;
+
+    D3D12MA_CLASS_NO_COPY(BlockMetadata_Buddy)
 };
 
-#ifndef _D3D12MA_BLOCK_METADATA_TLSF_FUNCTIONS
-BlockMetadata_TLSF::BlockMetadata_TLSF(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual)
+#ifndef _D3D12MA_BLOCK_METADATA_BUDDY_FUNCTIONS
+BlockMetadata_Buddy::BlockMetadata_Buddy(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual)
     : BlockMetadata(allocationCallbacks, isVirtual),
-    m_BlockAllocator(*allocationCallbacks, INITIAL_BLOCK_ALLOC_COUNT)
+    m_NodePairAllocator(*allocationCallbacks, INITIAL_NODE_PAIR_ALLOC_COUNT)
 {
     D3D12MA_ASSERT(allocationCallbacks);
 }
 
-BlockMetadata_TLSF::~BlockMetadata_TLSF()
+UINT64 BlockMetadata_Buddy::GetLargestFreeRegionSizeBound() const
 {
-    D3D12MA_DELETE_ARRAY(*GetAllocs(), m_FreeList, m_ListsCount);
+    if (m_FreeLevelBitmap == 0)
+        return 0;
+    return LevelToNodeSize(BitScanLSB(m_FreeLevelBitmap));
 }
 
-void BlockMetadata_TLSF::Init(UINT64 size)
+void BlockMetadata_Buddy::Init(UINT64 size)
 {
     BlockMetadata::Init(size);
 
-    m_NullBlock = m_BlockAllocator.Alloc();
-    m_NullBlock->size = size;
-    m_NullBlock->offset = 0;
-    m_NullBlock->prevPhysical = NULL;
-    m_NullBlock->nextPhysical = NULL;
-    m_NullBlock->MarkFree();
-    m_NullBlock->NextFree() = NULL;
-    m_NullBlock->PrevFree() = NULL;
-    UINT8 memoryClass = SizeToMemoryClass(size);
-    UINT16 sli = SizeToSecondIndex(size, memoryClass);
-    m_ListsCount = (memoryClass == 0 ? 0 : (memoryClass - 1) * (1UL << SECOND_LEVEL_INDEX) + sli) + 1;
-    if (IsVirtual())
-        m_ListsCount += 1UL << SECOND_LEVEL_INDEX;
-    else
-        m_ListsCount += 4;
-
-    m_MemoryClasses = memoryClass + 2;
-    memset(m_InnerIsFreeBitmap, 0, MAX_MEMORY_CLASSES * sizeof(UINT32));
+    m_UsableSize = 1ULL << BitScanMSB(size);
+    const UINT64 minNodeSize = IsVirtual() ? 1 : MIN_NODE_SIZE;
+    m_LevelCount = 1;
+    while (m_LevelCount < MAX_LEVELS && LevelToNodeSize(m_LevelCount) >= minNodeSize)
+        ++m_LevelCount;
 
-    m_FreeList = D3D12MA_NEW_ARRAY(*GetAllocs(), Block*, m_ListsCount);
-    memset(m_FreeList, 0, m_ListsCount * sizeof(Block*));
+    m_Root.offset = 0;
+    m_Root.parent = NULL;
+    m_Root.type = Node::TYPE_FREE;
+    AddToFreeList(&m_Root, 0);
 }
 
-bool BlockMetadata_TLSF::Validate() const
+bool BlockMetadata_Buddy::Validate() const
 {
-    D3D12MA_VALIDATE(GetSumFreeSize() <= GetSize());
+    D3D12MA_VALIDATE(m_UsableSize > 0 && m_UsableSize <= GetSize() && IsPow2(m_UsableSize));
+    D3D12MA_VALIDATE(m_UsableSize > GetUnusableSize());
 
-    UINT64 calculatedSize = m_NullBlock->size;
-    UINT64 calculatedFreeSize = m_NullBlock->size;
-    size_t allocCount = 0;
     size_t freeCount = 0;
+    size_t allocationCount = 0;
+    UINT64 allocationBytes = 0;
+    D3D12MA_VALIDATE(ValidateNode(m_Root, NULL, 0, freeCount, allocationCount, allocationBytes));
+    D3D12MA_VALIDATE(freeCount == m_FreeCount);
+    D3D12MA_VALIDATE(allocationCount == m_AllocationCount);
+    D3D12MA_VALIDATE(allocationBytes == m_AllocationBytes);
 
-    // Check integrity of free lists
-    for (UINT32 list = 0; list < m_ListsCount; ++list)
+    size_t listedCount = 0;
+    for (UINT level = 0; level < MAX_LEVELS; ++level)
     {
-        Block* block = m_FreeList[list];
-        if (block != NULL)
+        const Node* node = m_FreeList[level];
+        D3D12MA_VALIDATE((node != NULL) == (((m_FreeLevelBitmap >> level) & 1) != 0));
+        D3D12MA_VALIDATE(node == NULL || (level < m_LevelCount && node->free.prev == NULL));
+        for (; node != NULL; node = node->free.next)
         {
-            D3D12MA_VALIDATE(block->IsFree());
-            D3D12MA_VALIDATE(block->PrevFree() == NULL);
-            while (block->NextFree())
-            {
-                D3D12MA_VALIDATE(block->NextFree()->IsFree());
-                D3D12MA_VALIDATE(block->NextFree()->PrevFree() == block);
-                block = block->NextFree();
-            }
+            D3D12MA_VALIDATE(node->type == Node::TYPE_FREE);
+            D3D12MA_VALIDATE((node->offset & (LevelToNodeSize(level) - 1)) == 0);
+            D3D12MA_VALIDATE(node->free.next == NULL || node->free.next->free.prev == node);
+            ++listedCount;
         }
     }
+    D3D12MA_VALIDATE(listedCount == m_FreeCount);
+    return true;
+}
 
-    D3D12MA_VALIDATE(m_NullBlock->nextPhysical == NULL);
-    if (m_NullBlock->prevPhysical)
-    {
-        D3D12MA_VALIDATE(m_NullBlock->prevPhysical->nextPhysical == m_NullBlock);
-    }
+void BlockMetadata_Buddy::GetAllocationInfo(AllocHandle allocHandle, VIRTUAL_ALLOCATION_INFO& outInfo) const
+{
+    UINT level;
+    const Node* node = FindLeaf((UINT64)allocHandle - 1, level);
+    D3D12MA_ASSERT(node->type == Node::TYPE_ALLOCATION && node->offset == (UINT64)allocHandle - 1);
 
-    // Check all blocks
-    UINT64 nextOffset = m_NullBlock->offset;
-    for (Block* prev = m_NullBlock->prevPhysical; prev != NULL; prev = prev->prevPhysical)
-    {
-        D3D12MA_VALIDATE(prev->offset + prev->size == nextOffset);
-        nextOffset = prev->offset;
-        calculatedSize += prev->size;
+    outInfo.Offset = node->offset;
+    outInfo.Size = node->allocation.size;
+    outInfo.pPrivateData = node->allocation.privateData;
+}
 
-        UINT32 listIndex = GetListIndex(prev->size);
-        if (prev->IsFree())
-        {
-            ++freeCount;
-            // Check if free block belongs to free list
-            Block* freeBlock = m_FreeList[listIndex];
-            D3D12MA_VALIDATE(freeBlock != NULL);
+bool BlockMetadata_Buddy::CreateAllocationRequest(
+    UINT64 allocSize,
+    UINT64 allocAlignment,
+    bool upperAddress,
+    UINT32 strategy,
+    AllocationRequest* pAllocationRequest)
+{
+    D3D12MA_ASSERT(allocSize > 0 && "Cannot allocate empty block!");
+    D3D12MA_ASSERT(!upperAddress && "ALLOCATION_FLAG_UPPER_ADDRESS can be used only with linear algorithm.");
+    D3D12MA_ASSERT(pAllocationRequest != NULL);
+    D3D12MA_HEAVY_ASSERT(Validate());
 
-            bool found = false;
-            do
-            {
-                if (freeBlock == prev)
-                    found = true;
+    allocSize += GetDebugMargin();
+    if (allocSize > GetLargestFreeRegionSizeBound())
+        return false;
 
-                freeBlock = freeBlock->NextFree();
-            } while (!found && freeBlock != NULL);
+    const UINT targetLevel = SizeToLevel(allocSize);
+    const bool minOffset = (strategy & ALLOCATION_FLAG_STRATEGY_MIN_OFFSET) != 0;
 
-            D3D12MA_VALIDATE(found);
-            calculatedFreeSize += prev->size;
+    // Levels with free nodes large enough, starting from the smallest nodes to limit splitting.
+    UINT64 levelMask = m_FreeLevelBitmap & ((2ULL << targetLevel) - 1);
+    const Node* found = NULL;
+    while (levelMask != 0 && (found == NULL || minOffset))
+    {
+        const UINT level = BitScanMSB(levelMask);
+        levelMask &= ~(1ULL << level);
+
+        // Nodes are aligned to their size, so only smaller ones need to be checked.
+        if (!minOffset && allocAlignment <= LevelToNodeSize(level))
+        {
+            found = m_FreeList[level];
+            break;
         }
-        else
+        for (const Node* node = m_FreeList[level]; node != NULL; node = node->free.next)
         {
-            ++allocCount;
-            // Check if taken block is not on a free list
-            Block* freeBlock = m_FreeList[listIndex];
-            while (freeBlock)
+            if ((node->offset & (allocAlignment - 1)) == 0 &&
+                (found == NULL || node->offset < found->offset))
             {
-                D3D12MA_VALIDATE(freeBlock != prev);
-                freeBlock = freeBlock->NextFree();
+                found = node;
+                if (!minOffset)
+                    break;
             }
         }
+    }
+    if (found == NULL)
+        return false;
 
-        if (prev->prevPhysical)
+    pAllocationRequest->allocHandle = (AllocHandle)(found->offset + 1);
+    pAllocationRequest->size = allocSize - GetDebugMargin();
+    pAllocationRequest->algorithmData = targetLevel;
+    return true;
+}
+
+void BlockMetadata_Buddy::Alloc(
+    const AllocationRequest& request,
+    UINT64 allocSize,
+    void* privateData)
+{
+    const UINT targetLevel = static_cast<UINT>(request.algorithmData);
+    UINT level;
+    Node* node = FindLeaf((UINT64)request.allocHandle - 1, level);
+    D3D12MA_ASSERT(node->type == Node::TYPE_FREE && node->offset == (UINT64)request.allocHandle - 1);
+    D3D12MA_ASSERT(level <= targetLevel);
+
+    StatisticsSnapshotUpdate snapshotUpdate(m_pStatisticsSnapshot);
+    if (m_pStatisticsSnapshot)
+        m_pStatisticsSnapshot->RemoveUnusedRange(LevelToNodeSize(level));
+    RemoveFromFreeList(node, level);
+
+    // Split down to the target level, going to the left half and leaving the right one free.
+    for (; level < targetLevel; ++level)
+    {
+        const UINT64 childSize = LevelToNodeSize(level + 1);
+        NodePair* const children = m_NodePairAllocator.Alloc();
+        for (UINT i = 0; i < 2; ++i)
         {
-            D3D12MA_VALIDATE(prev->prevPhysical->nextPhysical == prev);
+            children->nodes[i].offset = node->offset + childSize * i;
+            children->nodes[i].parent = node;
+            children->nodes[i].type = Node::TYPE_FREE;
         }
+        node->type = Node::TYPE_SPLIT;
+        node->split.children = children;
+
+        AddToFreeList(&children->nodes[1], level + 1);
+        if (m_pStatisticsSnapshot)
+            m_pStatisticsSnapshot->AddUnusedRange(childSize);
+        node = &children->nodes[0];
     }
 
-    D3D12MA_VALIDATE(nextOffset == 0);
-    D3D12MA_VALIDATE(calculatedSize == GetSize());
-    D3D12MA_VALIDATE(calculatedFreeSize == GetSumFreeSize());
-    D3D12MA_VALIDATE(allocCount == m_AllocCount);
-    D3D12MA_VALIDATE(freeCount == m_BlocksFreeCount);
+    node->type = Node::TYPE_ALLOCATION;
+    node->allocation.privateData = privateData;
+    node->allocation.size = request.size;
+    ++m_AllocationCount;
+    m_AllocationBytes += request.size;
 
-    return true;
+    if (m_pStatisticsSnapshot)
+    {
+        m_pStatisticsSnapshot->AddAllocation(request.size);
+        const UINT64 tailSize = LevelToNodeSize(level) - request.size;
+        if (tailSize > 0)
+            m_pStatisticsSnapshot->AddUnusedRange(tailSize);
+    }
 }
 
-void BlockMetadata_TLSF::GetAllocationInfo(AllocHandle allocHandle, VIRTUAL_ALLOCATION_INFO& outInfo) const
+void BlockMetadata_Buddy::Free(AllocHandle allocHandle)
+{
+    UINT level;
+    Node* node = FindLeaf((UINT64)allocHandle - 1, level);
+    D3D12MA_ASSERT(node->type == Node::TYPE_ALLOCATION && node->offset == (UINT64)allocHandle - 1 &&
+        "Invalid allocation handle!");
+
+    StatisticsSnapshotUpdate snapshotUpdate(m_pStatisticsSnapshot);
+    if (m_pStatisticsSnapshot)
+    {
+        m_pStatisticsSnapshot->RemoveAllocation(node->allocation.size);
+        const UINT64 tailSize = LevelToNodeSize(level) - node->allocation.size;
+        if (tailSize > 0)
+            m_pStatisticsSnapshot->RemoveUnusedRange(tailSize);
+    }
+    --m_AllocationCount;
+    m_AllocationBytes -= node->allocation.size;
+    node->type = Node::TYPE_FREE;
+
+    // Merge with the buddy as long as it is free as well.
+    for (; level > 0; --level)
+    {
+        Node* const parent = node->parent;
+        NodePair* const children = parent->split.children;
+        Node* const buddy = &children->nodes[node == &children->nodes[0] ? 1 : 0];
+        if (buddy->type != Node::TYPE_FREE)
+            break;
+
+        RemoveFromFreeList(buddy, level);
+        if (m_pStatisticsSnapshot)
+            m_pStatisticsSnapshot->RemoveUnusedRange(LevelToNodeSize(level));
+        m_NodePairAllocator.Free(children);
+        parent->type = Node::TYPE_FREE;
+        node = parent;
+    }
+
+    AddToFreeList(node, level);
+    if (m_pStatisticsSnapshot)
+        m_pStatisticsSnapshot->AddUnusedRange(LevelToNodeSize(level));
+}
+
+void BlockMetadata_Buddy::Clear()
+{
+    D3D12MA_ASSERT(m_pStatisticsSnapshot == NULL);
+
+    m_NodePairAllocator.Clear();
+    m_AllocationCount = 0;
+    m_FreeCount = 0;
+    m_AllocationBytes = 0;
+    m_FreeLevelBitmap = 0;
+    memset(m_FreeList, 0, sizeof(m_FreeList));
+
+    m_Root.type = Node::TYPE_FREE;
+    AddToFreeList(&m_Root, 0);
+}
+
+AllocHandle BlockMetadata_Buddy::GetAllocationListBegin() const
+{
+    const Node* node = FindAllocation(m_Root, m_UsableSize, 0);
+    return node != NULL ? (AllocHandle)(node->offset + 1) : (AllocHandle)0;
+}
+
+AllocHandle BlockMetadata_Buddy::GetNextAllocation(AllocHandle prevAlloc) const
 {
-    Block* block = (Block*)allocHandle;
-    D3D12MA_ASSERT(!block->IsFree() && "Cannot get allocation info for free block!");
-    outInfo.Offset = block->offset;
-    outInfo.Size = block->size;
-    outInfo.pPrivateData = block->PrivateData();
+    // Searched by offset rather than from the previous node, so it remains valid when
+    // new allocations are made during the iteration, like in defragmentation.
+    const Node* node = FindAllocation(m_Root, m_UsableSize, (UINT64)prevAlloc);
+    return node != NULL ? (AllocHandle)(node->offset + 1) : (AllocHandle)0;
 }
 
-bool BlockMetadata_TLSF::CreateAllocationRequest(
-    UINT64 allocSize,
-    UINT64 allocAlignment,
-    bool upperAddress,
-    UINT32 strategy,
-    AllocationRequest* pAllocationRequest)
+UINT64 BlockMetadata_Buddy::GetNextFreeRegionSize(AllocHandle alloc) const
 {
-    D3D12MA_ASSERT(allocSize > 0 && "Cannot allocate empty block!");
-    D3D12MA_ASSERT(!upperAddress && "ALLOCATION_FLAG_UPPER_ADDRESS can be used only with linear algorithm.");
-    D3D12MA_ASSERT(pAllocationRequest != NULL);
-    D3D12MA_HEAVY_ASSERT(Validate());
+    UINT level;
+    const Node* node = FindLeaf((UINT64)alloc - 1, level);
+    D3D12MA_ASSERT(node->type == Node::TYPE_ALLOCATION && "Incorrect allocation!");
 
-    allocSize += GetDebugMargin();
-    // Quick check for too small pool
-    if (allocSize > GetSumFreeSize())
-        return false;
+    UINT64 result = LevelToNodeSize(level) - node->allocation.size;
+    const UINT64 nextOffset = node->offset + LevelToNodeSize(level);
+    if (nextOffset == m_UsableSize)
+        return result + GetUnusableSize();
 
-    // If no free blocks in pool then check only null block
-    if (m_BlocksFreeCount == 0)
-        return CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest);
+    UINT nextLevel;
+    const Node* next = FindLeaf(nextOffset, nextLevel);
+    if (next->type == Node::TYPE_FREE)
+        result += LevelToNodeSize(nextLevel);
+    return result;
+}
 
-    // Round up to the next block
-    UINT64 sizeForNextList = allocSize;
-    UINT16 smallSizeStep = SMALL_BUFFER_SIZE / (IsVirtual() ? 1 << SECOND_LEVEL_INDEX : 4);
-    if (allocSize > SMALL_BUFFER_SIZE)
-    {
-        sizeForNextList += (1ULL << (BitScanMSB(allocSize) - SECOND_LEVEL_INDEX));
-    }
-    else if (allocSize > SMALL_BUFFER_SIZE - smallSizeStep)
-        sizeForNextList = SMALL_BUFFER_SIZE + 1;
-    else
-        sizeForNextList += smallSizeStep;
+void* BlockMetadata_Buddy::GetAllocationPrivateData(AllocHandle allocHandle) const
+{
+    UINT level;
+    const Node* node = FindLeaf((UINT64)allocHandle - 1, level);
+    D3D12MA_ASSERT(node->type == Node::TYPE_ALLOCATION && "Cannot get user data for free block!");
+    return node->allocation.privateData;
+}
 
-    UINT32 nextListIndex = 0;
-    UINT32 prevListIndex = 0;
-    Block* nextListBlock = NULL;
-    Block* prevListBlock = NULL;
+void BlockMetadata_Buddy::SetAllocationPrivateData(AllocHandle allocHandle, void* privateData)
+{
+    UINT level;
+    Node* node = FindLeaf((UINT64)allocHandle - 1, level);
+    D3D12MA_ASSERT(node->type == Node::TYPE_ALLOCATION && "Trying to set user data for not allocated block!");
+    node->allocation.privateData = privateData;
+}
 
-    // Check blocks according to strategies
-    if (strategy & ALLOCATION_FLAG_STRATEGY_MIN_TIME)
-    {
-        // Quick check for larger block first
-        nextListBlock = FindFreeBlock(sizeForNextList, nextListIndex);
-        if (nextListBlock != NULL && CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
-            return true;
+void BlockMetadata_Buddy::AddStatistics(Statistics& inoutStats) const
+{
+    inoutStats.BlockCount++;
+    inoutStats.AllocationCount += static_cast<UINT>(m_AllocationCount);
+    inoutStats.BlockBytes += GetSize();
+    inoutStats.AllocationBytes += m_AllocationBytes;
+}
 
-        // If not fitted then null block
-        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
-            return true;
+void BlockMetadata_Buddy::AddDetailedStatistics(DetailedStatistics& inoutStats) const
+{
+    inoutStats.Stats.BlockCount++;
+    inoutStats.Stats.BlockBytes += GetSize();
 
-        // Null block failed, search larger bucket
-        while (nextListBlock)
+    auto addNode = [&inoutStats](const Node& node, UINT64 nodeSize)
+    {
+        if (node.type == Node::TYPE_FREE)
+            AddDetailedStatisticsUnusedRange(inoutStats, nodeSize);
+        else
         {
-            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
-                return true;
-            nextListBlock = nextListBlock->NextFree();
+            AddDetailedStatisticsAllocation(inoutStats, node.allocation.size);
+            if (nodeSize > node.allocation.size)
+                AddDetailedStatisticsUnusedRange(inoutStats, nodeSize - node.allocation.size);
         }
+    };
+    ForEachLeaf(m_Root, m_UsableSize, addNode);
 
-        // Failed again, check best fit bucket
-        prevListBlock = FindFreeBlock(allocSize, prevListIndex);
-        while (prevListBlock)
-        {
-            if (CheckBlock(*prevListBlock, prevListIndex, allocSize, allocAlignment, pAllocationRequest))
-                return true;
-            prevListBlock = prevListBlock->NextFree();
-        }
-    }
-    else if (strategy & ALLOCATION_FLAG_STRATEGY_MIN_MEMORY)
+    if (GetUnusableSize() > 0)
+        AddDetailedStatisticsUnusedRange(inoutStats, GetUnusableSize());
+}
+
+void BlockMetadata_Buddy::SetStatisticsSnapshot(StatisticsSnapshot* snapshot)
+{
+    StatisticsSnapshot* const reported = snapshot ? snapshot : m_pStatisticsSnapshot;
+    D3D12MA_ASSERT((snapshot == NULL) != (m_pStatisticsSnapshot == NULL));
+
+    auto reportUnusedRange = [snapshot, reported](UINT64 size)
     {
-        // Check best fit bucket
-        prevListBlock = FindFreeBlock(allocSize, prevListIndex);
-        while (prevListBlock)
+        if (snapshot)
+            reported->AddUnusedRange(size);
+        else
+            reported->RemoveUnusedRange(size);
+    };
+    auto reportNode = [snapshot, reported, &reportUnusedRange](const Node& node, UINT64 nodeSize)
+    {
+        if (node.type == Node::TYPE_FREE)
+            reportUnusedRange(nodeSize);
+        else
         {
-            if (CheckBlock(*prevListBlock, prevListIndex, allocSize, allocAlignment, pAllocationRequest))
-                return true;
-            prevListBlock = prevListBlock->NextFree();
+            if (snapshot)
+                reported->AddAllocation(node.allocation.size);
+            else
+                reported->RemoveAllocation(node.allocation.size);
+            if (nodeSize > node.allocation.size)
+                reportUnusedRange(nodeSize - node.allocation.size);
         }
+    };
+    ForEachLeaf(m_Root, m_UsableSize, reportNode);
+    if (GetUnusableSize() > 0)
+        reportUnusedRange(GetUnusableSize());
+    m_pStatisticsSnapshot = snapshot;
+}
 
-        // If failed check null block
-        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
-            return true;
+void BlockMetadata_Buddy::WriteDetailedMap(DetailedMapWriter& writer) const
+{
+    // Unused rest of an allocated node is written as a separate unused range.
+    size_t unusedRangeCount = m_FreeCount + (GetUnusableSize() > 0 ? 1 : 0);
+    auto countTail = [&unusedRangeCount](const Node& node, UINT64 nodeSize)
+    {
+        if (node.type == Node::TYPE_ALLOCATION && nodeSize > node.allocation.size)
+            ++unusedRangeCount;
+    };
+    ForEachLeaf(m_Root, m_UsableSize, countTail);
 
-        // Check larger bucket
-        nextListBlock = FindFreeBlock(sizeForNextList, nextListIndex);
-        while (nextListBlock)
+    writer.Begin(GetSize(), GetSumFreeSize(), GetAllocationCount(), unusedRangeCount);
+    auto writeNode = [&writer](const Node& node, UINT64 nodeSize)
+    {
+        if (node.type == Node::TYPE_FREE)
+            writer.AddUnusedRange(node.offset, nodeSize);
+        else
         {
-            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
-                return true;
-            nextListBlock = nextListBlock->NextFree();
+            writer.AddAllocation(node.offset, node.allocation.size, node.allocation.privateData);
+            if (nodeSize > node.allocation.size)
+                writer.AddUnusedRange(node.offset + node.allocation.size, nodeSize - node.allocation.size);
         }
-    }
-    else if (strategy & ALLOCATION_FLAG_STRATEGY_MIN_OFFSET)
+    };
+    ForEachLeaf(m_Root, m_UsableSize, writeNode);
+    if (GetUnusableSize() > 0)
+        writer.AddUnusedRange(m_UsableSize, GetUnusableSize());
+    writer.End();
+}
+
+void BlockMetadata_Buddy::DebugLogAllAllocations() const
+{
+    auto logNode = [this](const Node& node, UINT64 nodeSize)
     {
-        // Perform search from the start
-        Vector<Block*> blockList(m_BlocksFreeCount, *GetAllocs());
+        if (node.type == Node::TYPE_ALLOCATION)
+            DebugLogAllocation(node.offset, node.allocation.size, node.allocation.privateData);
+    };
+    ForEachLeaf(m_Root, m_UsableSize, logNode);
+}
 
-        size_t i = m_BlocksFreeCount;
-        for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
-        {
-            if (block->IsFree() && block->size >= allocSize)
-                blockList[--i] = block;
-        }
+UINT BlockMetadata_Buddy::SizeToLevel(UINT64 size) const
+{
+    const UINT sizeLog2 = size > 1 ? BitScanMSB(size - 1) + 1U : 0U;
+    const UINT usableLog2 = BitScanMSB(m_UsableSize);
+    D3D12MA_ASSERT(sizeLog2 <= usableLog2);
+    return D3D12MA_MIN(usableLog2 - sizeLog2, m_LevelCount - 1);
+}
 
-        for (; i < m_BlocksFreeCount; ++i)
-        {
-            Block& block = *blockList[i];
-            if (CheckBlock(block, GetListIndex(block.size), allocSize, allocAlignment, pAllocationRequest))
-                return true;
-        }
+void BlockMetadata_Buddy::AddToFreeList(Node* node, UINT level)
+{
+    D3D12MA_ASSERT(node->type == Node::TYPE_FREE && level < m_LevelCount);
 
-        // If failed check null block
-        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
-            return true;
+    node->free.prev = NULL;
+    node->free.next = m_FreeList[level];
+    if (node->free.next != NULL)
+        node->free.next->free.prev = node;
+    m_FreeList[level] = node;
+    m_FreeLevelBitmap |= 1ULL << level;
+    ++m_FreeCount;
+}
 
-        // Whole range searched, no more memory
-        return false;
-    }
+void BlockMetadata_Buddy::RemoveFromFreeList(Node* node, UINT level)
+{
+    D3D12MA_ASSERT(node->type == Node::TYPE_FREE && m_FreeCount > 0);
+
+    if (node->free.prev != NULL)
+        node->free.prev->free.next = node->free.next;
     else
     {
-        // Check larger bucket
-        nextListBlock = FindFreeBlock(sizeForNextList, nextListIndex);
-        while (nextListBlock)
-        {
-            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
-                return true;
-            nextListBlock = nextListBlock->NextFree();
-        }
+        D3D12MA_ASSERT(m_FreeList[level] == node);
+        m_FreeList[level] = node->free.next;
+        if (m_FreeList[level] == NULL)
+            m_FreeLevelBitmap &= ~(1ULL << level);
+    }
+    if (node->free.next != NULL)
+        node->free.next->free.prev = node->free.prev;
+    --m_FreeCount;
+}
 
-        // If failed check null block
-        if (CheckBlock(*m_NullBlock, m_ListsCount, allocSize, allocAlignment, pAllocationRequest))
-            return true;
+BlockMetadata_Buddy::Node* BlockMetadata_Buddy::FindLeaf(UINT64 offset, UINT& outLevel) const
+{
+    D3D12MA_ASSERT(offset < m_UsableSize);
 
-        // Check best fit bucket
-        prevListBlock = FindFreeBlock(allocSize, prevListIndex);
-        while (prevListBlock)
-        {
-            if (CheckBlock(*prevListBlock, prevListIndex, allocSize, allocAlignment, pAllocationRequest))
-                return true;
-            prevListBlock = prevListBlock->NextFree();
-        }
+    Node* node = const_cast<Node*>(&m_Root);
+    UINT level = 0;
+    while (node->type == Node::TYPE_SPLIT)
+    {
+        ++level;
+        const bool right = offset >= node->offset + LevelToNodeSize(level);
+        node = &node->split.children->nodes[right ? 1 : 0];
     }
+    outLevel = level;
+    return node;
+}
 
-    // Worst case, full search has to be done
-    while (++nextListIndex < m_ListsCount)
+const BlockMetadata_Buddy::Node* BlockMetadata_Buddy::FindAllocation(const Node& node, UINT64 nodeSize, UINT64 minOffset) const
+{
+    if (node.offset + nodeSize <= minOffset)
+        return NULL;
+
+    switch (node.type)
     {
-        nextListBlock = m_FreeList[nextListIndex];
-        while (nextListBlock)
-        {
-            if (CheckBlock(*nextListBlock, nextListIndex, allocSize, allocAlignment, pAllocationRequest))
-                return true;
-            nextListBlock = nextListBlock->NextFree();
-        }
+    case Node::TYPE_ALLOCATION:
+        return node.offset >= minOffset ? &node : NULL;
+    case Node::TYPE_SPLIT:
+    {
+        const Node* result = FindAllocation(node.split.children->nodes[0], nodeSize / 2, minOffset);
+        if (result == NULL)
+            result = FindAllocation(node.split.children->nodes[1], nodeSize / 2, minOffset);
+        return result;
+    }
+    default:
+        return NULL;
     }
-
-    // No more memory sadly
-    return false;
 }
 
-void BlockMetadata_TLSF::Alloc(
-    const AllocationRequest& request,
-    UINT64 allocSize,
-    void* privateData)
+template<typename FuncT>
+void BlockMetadata_Buddy::ForEachLeaf(const Node& node, UINT64 nodeSize, FuncT& func) const
 {
-    // Get block and pop it from the free list
-    Block* currentBlock = (Block*)request.allocHandle;
-    UINT64 offset = request.algorithmData;
-    D3D12MA_ASSERT(currentBlock != NULL);
-    D3D12MA_ASSERT(currentBlock->offset <= offset);
+    if (node.type == Node::TYPE_SPLIT)
+    {
+        ForEachLeaf(node.split.children->nodes[0], nodeSize / 2, func);
+        ForEachLeaf(node.split.children->nodes[1], nodeSize / 2, func);
+    }
+    else
+        func(node, nodeSize);
+}
 
-    if (currentBlock != m_NullBlock)
-        RemoveFreeBlock(currentBlock);
+bool BlockMetadata_Buddy::ValidateNode(const Node& node, const Node* parent, UINT level,
+    size_t& inoutFreeCount, size_t& inoutAllocationCount, UINT64& inoutAllocationBytes) const
+{
+    const UINT64 nodeSize = LevelToNodeSize(level);
+    D3D12MA_VALIDATE(node.parent == parent);
+    D3D12MA_VALIDATE(level < m_LevelCount);
+    D3D12MA_VALIDATE((node.offset & (nodeSize - 1)) == 0);
 
-    // Append missing alignment to prev block or create new one
-    UINT64 misssingAlignment = offset - currentBlock->offset;
-    if (misssingAlignment)
+    switch (node.type)
     {
-        Block* prevBlock = currentBlock->prevPhysical;
-        D3D12MA_ASSERT(prevBlock != NULL && "There should be no missing alignment at offset 0!");
-
-        if (prevBlock->IsFree() && prevBlock->size != GetDebugMargin())
+    case Node::TYPE_FREE:
+        ++inoutFreeCount;
+        break;
+    case Node::TYPE_ALLOCATION:
+        D3D12MA_VALIDATE(node.allocation.size > 0);
+        D3D12MA_VALIDATE(node.allocation.size + GetDebugMargin() <= nodeSize);
+        ++inoutAllocationCount;
+        inoutAllocationBytes += node.allocation.size;
+        break;
+    case Node::TYPE_SPLIT:
+    {
+        const Node* const children = node.split.children->nodes;
+        D3D12MA_VALIDATE(children[0].offset == node.offset);
+        D3D12MA_VALIDATE(children[1].offset == node.offset + nodeSize / 2);
+        D3D12MA_VALIDATE(children[0].type != Node::TYPE_FREE || children[1].type != Node::TYPE_FREE);
+        for (UINT i = 0; i < 2; ++i)
         {
-            UINT32 oldList = GetListIndex(prevBlock->size);
-            prevBlock->size += misssingAlignment;
-            // Check if new size crosses list bucket
-            if (oldList != GetListIndex(prevBlock->size))
-            {
-                prevBlock->size -= misssingAlignment;
-                RemoveFreeBlock(prevBlock);
-                prevBlock->size += misssingAlignment;
-                InsertFreeBlock(prevBlock);
-            }
-            else
-                m_BlocksFreeSize += misssingAlignment;
+            D3D12MA_VALIDATE(ValidateNode(children[i], &node, level + 1,
+                inoutFreeCount, inoutAllocationCount, inoutAllocationBytes));
         }
-        else
-        {
-            Block* newBlock = m_BlockAllocator.Alloc();
-            currentBlock->prevPhysical = newBlock;
-            prevBlock->nextPhysical = newBlock;
-            newBlock->prevPhysical = prevBlock;
-            newBlock->nextPhysical = currentBlock;
-            newBlock->size = misssingAlignment;
-            newBlock->offset = currentBlock->offset;
-            newBlock->MarkTaken();
+        break;
+    }
+    default:
+        D3D12MA_VALIDATE(false);
+    }
+    return true;
+}
+#endif // _D3D12MA_BLOCK_METADATA_BUDDY_FUNCTIONS
+#endif // _D3D12MA_BLOCK_METADATA_BUDDY
 
-            InsertFreeBlock(newBlock);
-        }
+#ifndef _D3D12MA_BLOCK_METADATA_SLAB
+/*
+Slab allocation algorithm, used with POOL_FLAG_ALGORITHM_SLAB.
+
+The block is divided into slots of equal size, declared when the pool is created, and the
+rest of the block after the last whole slot is never used. Each allocation takes one slot.
+Free slots are marked with bits set in m_FreeBitmap, and nonzero words of m_FreeBitmap with
+bits set in m_FreeWordBitmap, so the lowest free slot is found with two bit scans,
+starting from the first word of m_FreeWordBitmap that may be nonzero. Allocation that needs larger alignment than
+the offsets of all slots have falls back to checking free slots one by one.
+
+Allocation handle is index of the slot + 1.
+*/
+class BlockMetadata_Slab : public BlockMetadata
+{
+public:
+    BlockMetadata_Slab(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual, UINT64 slotSize);
+    virtual ~BlockMetadata_Slab() = default;
+
+    size_t GetAllocationCount() const override { return m_AllocationCount; }
+    size_t GetFreeRegionsCount() const override { return m_FreeCount + (GetUnusableSize() > 0 ? 1 : 0); }
+    UINT64 GetSumFreeSize() const override { return GetSize() - m_AllocationBytes; }
+    UINT64 GetLargestFreeRegionSizeBound() const override { return m_FreeCount > 0 ? m_SlotSize : 0; }
+    bool IsEmpty() const override { return m_AllocationCount == 0; }
+    UINT64 GetAllocationOffset(AllocHandle allocHandle) const override { return ((UINT64)allocHandle - 1) * m_SlotSize; }
+
+    void Init(UINT64 size) override;
+    bool Validate() const override;
+    void GetAllocationInfo(AllocHandle allocHandle, VIRTUAL_ALLOCATION_INFO& outInfo) const override;
+
+    bool CreateAllocationRequest(
+        UINT64 allocSize,
+        UINT64 allocAlignment,
+        bool upperAddress,
+        UINT32 strategy,
+        AllocationRequest* pAllocationRequest) override;
+
+    void Alloc(
+        const AllocationRequest& request,
+        UINT64 allocSize,
+        void* privateData) override;
+
+    void Free(AllocHandle allocHandle) override;
+    void Clear() override;
+
+    AllocHandle GetAllocationListBegin() const override;
+    AllocHandle GetNextAllocation(AllocHandle prevAlloc) const override;
+    UINT64 GetNextFreeRegionSize(AllocHandle alloc) const override;
+    void* GetAllocationPrivateData(AllocHandle allocHandle) const override;
+    void SetAllocationPrivateData(AllocHandle allocHandle, void* privateData) override;
 
-        currentBlock->size -= misssingAlignment;
-        currentBlock->offset += misssingAlignment;
-    }
+    void AddStatistics(Statistics& inoutStats) const override;
+    void AddDetailedStatistics(DetailedStatistics& inoutStats) const override;
+    void SetStatisticsSnapshot(StatisticsSnapshot* snapshot) override;
+    void WriteDetailedMap(DetailedMapWriter& writer) const override;
+    void DebugLogAllAllocations() const override;
 
-    UINT64 size = request.size + GetDebugMargin();
-    if (currentBlock->size == size)
-    {
-        if (currentBlock == m_NullBlock)
-        {
-            // Setup new null block
-            m_NullBlock = m_BlockAllocator.Alloc();
-            m_NullBlock->size = 0;
-            m_NullBlock->offset = currentBlock->offset + size;
-            m_NullBlock->prevPhysical = currentBlock;
-            m_NullBlock->nextPhysical = NULL;
-            m_NullBlock->MarkFree();
-            m_NullBlock->PrevFree() = NULL;
-            m_NullBlock->NextFree() = NULL;
-            currentBlock->nextPhysical = m_NullBlock;
-            currentBlock->MarkTaken();
-        }
-    }
-    else
+private:
+    struct Slot
     {
-        D3D12MA_ASSERT(currentBlock->size > size && "Proper block already found, shouldn't find smaller one!");
+        void* privateData;
+        // 0 if the slot is free.
+        UINT64 size;
+    };
 
-        // Create new free block
-        Block* newBlock = m_BlockAllocator.Alloc();
-        newBlock->size = currentBlock->size - size;
-        newBlock->offset = currentBlock->offset + size;
-        newBlock->prevPhysical = currentBlock;
-        newBlock->nextPhysical = currentBlock->nextPhysical;
-        currentBlock->nextPhysical = newBlock;
-        currentBlock->size = size;
+    const UINT64 m_SlotSize;
+    size_t m_SlotCount = 0;
+    size_t m_AllocationCount = 0;
+    size_t m_FreeCount = 0;
+    // Sum of sizes of allocations, excluding debug margins and the unused rest of their slots.
+    UINT64 m_AllocationBytes = 0;
+    // Bit i % 64 of word i / 64 is set when slot i is free.
+    Vector<UINT64> m_FreeBitmap;
+    // Bit i % 64 of word i / 64 is set when word i of m_FreeBitmap is not 0.
+    Vector<UINT64> m_FreeWordBitmap;
+    // No word of m_FreeWordBitmap before this one has any bit set.
+    size_t m_FirstFreeSummaryWord = 0;
+    Vector<Slot> m_Slots;
+    StatisticsSnapshot* m_pStatisticsSnapshot = NULL;
+
+    UINT64 GetUnusableSize() const { return GetSize() - m_SlotCount * m_SlotSize; }
+    bool IsSlotFree(size_t index) const { return (m_FreeBitmap[index / 64] >> (index % 64)) & 1; }
+    // Returns index of a free slot with offset aligned to alignment, or SIZE_MAX.
+    size_t FindFreeSlot(UINT64 alignment) const;
+    // Returns index of the first allocated slot not less than first, or m_SlotCount.
+    size_t FindAllocatedSlot(size_t first) const;
+    void MarkFree(size_t index);
+    void MarkAllocated(size_t index);
+    // Calls func(offset, size, allocationSize, privateData) for every slot, with allocationSize 0 for a free one.
+    template<typename FuncT>
+    void ForEachSlot(FuncT& func) const;
+
+    D3D12MA_CLASS_NO_COPY(BlockMetadata_Slab)
+};
 
-        if (currentBlock == m_NullBlock)
+#ifndef _D3D12MA_BLOCK_METADATA_SLAB_FUNCTIONS
+BlockMetadata_Slab::BlockMetadata_Slab(const ALLOCATION_CALLBACKS* allocationCallbacks, bool isVirtual, UINT64 slotSize)
+    : BlockMetadata(allocationCallbacks, isVirtual),
+    m_SlotSize(slotSize),
+    m_FreeBitmap(*allocationCallbacks),
+    m_FreeWordBitmap(*allocationCallbacks),
+    m_Slots(*allocationCallbacks)
+{
+    D3D12MA_ASSERT(allocationCallbacks);
+    D3D12MA_ASSERT(slotSize > 0);
+}
+
+void BlockMetadata_Slab::Init(UINT64 size)
+{
+    BlockMetadata::Init(size);
+
+    m_SlotCount = static_cast<size_t>(size / m_SlotSize);
+    D3D12MA_ASSERT(m_SlotCount > 0 && "Block must be able to hold at least one slot!");
+    m_FreeBitmap.resize(DivideRoundingUp(m_SlotCount, (size_t)64));
+    m_FreeWordBitmap.resize(DivideRoundingUp(m_FreeBitmap.size(), (size_t)64));
+    m_Slots.resize(m_SlotCount);
+    Clear();
+}
+
+bool BlockMetadata_Slab::Validate() const
+{
+    D3D12MA_VALIDATE(m_SlotCount > 0 && m_SlotCount * m_SlotSize <= GetSize());
+    D3D12MA_VALIDATE(m_AllocationCount + m_FreeCount == m_SlotCount);
+
+    size_t freeCount = 0;
+    UINT64 allocationBytes = 0;
+    for (size_t i = 0; i < m_SlotCount; ++i)
+    {
+        if (IsSlotFree(i))
         {
-            m_NullBlock = newBlock;
-            m_NullBlock->MarkFree();
-            m_NullBlock->NextFree() = NULL;
-            m_NullBlock->PrevFree() = NULL;
-            currentBlock->MarkTaken();
+            D3D12MA_VALIDATE(m_Slots[i].size == 0);
+            ++freeCount;
         }
         else
         {
-            newBlock->nextPhysical->prevPhysical = newBlock;
-            newBlock->MarkTaken();
-            InsertFreeBlock(newBlock);
+            D3D12MA_VALIDATE(m_Slots[i].size > 0 && m_Slots[i].size + GetDebugMargin() <= m_SlotSize);
+            allocationBytes += m_Slots[i].size;
         }
     }
-    currentBlock->PrivateData() = privateData;
+    D3D12MA_VALIDATE(freeCount == m_FreeCount);
+    D3D12MA_VALIDATE(allocationBytes == m_AllocationBytes);
 
-    if (GetDebugMargin() > 0)
-    {
-        currentBlock->size -= GetDebugMargin();
-        Block* newBlock = m_BlockAllocator.Alloc();
-        newBlock->size = GetDebugMargin();
-        newBlock->offset = currentBlock->offset + currentBlock->size;
-        newBlock->prevPhysical = currentBlock;
-        newBlock->nextPhysical = currentBlock->nextPhysical;
-        newBlock->MarkTaken();
-        currentBlock->nextPhysical->prevPhysical = newBlock;
-        currentBlock->nextPhysical = newBlock;
-        InsertFreeBlock(newBlock);
-    }
-    ++m_AllocCount;
+    // Bits past the last slot are never set.
+    if (m_SlotCount % 64 != 0)
+        D3D12MA_VALIDATE((m_FreeBitmap[m_FreeBitmap.size() - 1] >> (m_SlotCount % 64)) == 0);
+    for (size_t word = 0; word < m_FreeBitmap.size(); ++word)
+        D3D12MA_VALIDATE((m_FreeBitmap[word] != 0) == (((m_FreeWordBitmap[word / 64] >> (word % 64)) & 1) != 0));
+    for (size_t word = 0; word < m_FirstFreeSummaryWord; ++word)
+        D3D12MA_VALIDATE(m_FreeWordBitmap[word] == 0);
+    return true;
 }
 
-void BlockMetadata_TLSF::Free(AllocHandle allocHandle)
+void BlockMetadata_Slab::GetAllocationInfo(AllocHandle allocHandle, VIRTUAL_ALLOCATION_INFO& outInfo) const
 {
-    Block* block = (Block*)allocHandle;
-    Block* next = block->nextPhysical;
-    D3D12MA_ASSERT(!block->IsFree() && "Block is already free!");
+    const size_t index = (size_t)allocHandle - 1;
+    D3D12MA_ASSERT(index < m_SlotCount && !IsSlotFree(index));
 
-    --m_AllocCount;
-    if (GetDebugMargin() > 0)
-    {
-        RemoveFreeBlock(next);
-        MergeBlock(next, block);
-        block = next;
-        next = next->nextPhysical;
-    }
+    outInfo.Offset = index * m_SlotSize;
+    outInfo.Size = m_Slots[index].size;
+    outInfo.pPrivateData = m_Slots[index].privateData;
+}
 
-    // Try merging
-    Block* prev = block->prevPhysical;
-    if (prev != NULL && prev->IsFree() && prev->size != GetDebugMargin())
-    {
-        RemoveFreeBlock(prev);
-        MergeBlock(block, prev);
-    }
+bool BlockMetadata_Slab::CreateAllocationRequest(
+    UINT64 allocSize,
+    UINT64 allocAlignment,
+    bool upperAddress,
+    UINT32 strategy,
+    AllocationRequest* pAllocationRequest)
+{
+    D3D12MA_ASSERT(allocSize > 0 && "Cannot allocate empty block!");
+    D3D12MA_ASSERT(!upperAddress && "ALLOCATION_FLAG_UPPER_ADDRESS can be used only with linear algorithm.");
+    D3D12MA_ASSERT(pAllocationRequest != NULL);
+    D3D12MA_HEAVY_ASSERT(Validate());
 
-    if (!next->IsFree())
-        InsertFreeBlock(block);
-    else if (next == m_NullBlock)
-        MergeBlock(m_NullBlock, block);
-    else
-    {
-        RemoveFreeBlock(next);
-        MergeBlock(next, block);
-        InsertFreeBlock(next);
-    }
+    // The lowest free slot is always taken, so all strategies behave like STRATEGY_MIN_OFFSET.
+    (void)strategy;
+    if (m_FreeCount == 0 || allocSize + GetDebugMargin() > m_SlotSize)
+        return false;
+
+    const size_t index = FindFreeSlot(allocAlignment);
+    if (index == SIZE_MAX)
+        return false;
+
+    pAllocationRequest->allocHandle = (AllocHandle)(index + 1);
+    pAllocationRequest->size = allocSize;
+    pAllocationRequest->algorithmData = 0;
+    return true;
 }
 
-void BlockMetadata_TLSF::Clear()
+void BlockMetadata_Slab::Alloc(
+    const AllocationRequest& request,
+    UINT64 allocSize,
+    void* privateData)
 {
-    m_AllocCount = 0;
-    m_BlocksFreeCount = 0;
-    m_BlocksFreeSize = 0;
-    m_IsFreeBitmap = 0;
-    m_NullBlock->offset = 0;
-    m_NullBlock->size = GetSize();
-    Block* block = m_NullBlock->prevPhysical;
-    m_NullBlock->prevPhysical = NULL;
-    while (block)
+    const size_t index = (size_t)request.allocHandle - 1;
+    D3D12MA_ASSERT(index < m_SlotCount && IsSlotFree(index));
+
+    StatisticsSnapshotUpdate snapshotUpdate(m_pStatisticsSnapshot);
+    MarkAllocated(index);
+    m_Slots[index].privateData = privateData;
+    m_Slots[index].size = request.size;
+    ++m_AllocationCount;
+    m_AllocationBytes += request.size;
+
+    if (m_pStatisticsSnapshot)
     {
-        Block* prev = block->prevPhysical;
-        m_BlockAllocator.Free(block);
-        block = prev;
+        m_pStatisticsSnapshot->RemoveUnusedRange(m_SlotSize);
+        m_pStatisticsSnapshot->AddAllocation(request.size);
+        if (m_SlotSize > request.size)
+            m_pStatisticsSnapshot->AddUnusedRange(m_SlotSize - request.size);
     }
-    memset(m_FreeList, 0, m_ListsCount * sizeof(Block*));
-    memset(m_InnerIsFreeBitmap, 0, m_MemoryClasses * sizeof(UINT32));
 }
 
-AllocHandle BlockMetadata_TLSF::GetAllocationListBegin() const
+void BlockMetadata_Slab::Free(AllocHandle allocHandle)
 {
-    if (m_AllocCount == 0)
-        return (AllocHandle)0;
+    const size_t index = (size_t)allocHandle - 1;
+    D3D12MA_ASSERT(index < m_SlotCount && !IsSlotFree(index) && "Invalid allocation handle!");
 
-    for (Block* block = m_NullBlock->prevPhysical; block; block = block->prevPhysical)
+    StatisticsSnapshotUpdate snapshotUpdate(m_pStatisticsSnapshot);
+    const UINT64 size = m_Slots[index].size;
+    if (m_pStatisticsSnapshot)
     {
-        if (!block->IsFree())
-            return (AllocHandle)block;
+        m_pStatisticsSnapshot->RemoveAllocation(size);
+        if (m_SlotSize > size)
+            m_pStatisticsSnapshot->RemoveUnusedRange(m_SlotSize - size);
+        m_pStatisticsSnapshot->AddUnusedRange(m_SlotSize);
     }
-    D3D12MA_ASSERT(false && "If m_AllocCount > 0 then should find any allocation!");
-    return (AllocHandle)0;
+    --m_AllocationCount;
+    m_AllocationBytes -= size;
+    m_Slots[index].size = 0;
+    m_Slots[index].privateData = NULL;
+    MarkFree(index);
 }
 
-AllocHandle BlockMetadata_TLSF::GetNextAllocation(AllocHandle prevAlloc) const
+void BlockMetadata_Slab::Clear()
 {
-    Block* startBlock = (Block*)prevAlloc;
-    D3D12MA_ASSERT(!startBlock->IsFree() && "Incorrect block!");
+    D3D12MA_ASSERT(m_pStatisticsSnapshot == NULL);
 
-    for (Block* block = startBlock->prevPhysical; block; block = block->prevPhysical)
+    m_AllocationCount = 0;
+    m_FreeCount = m_SlotCount;
+    m_AllocationBytes = 0;
+    memset(m_Slots.data(), 0, m_SlotCount * sizeof(Slot));
+
+    for (size_t word = 0; word < m_FreeBitmap.size(); ++word)
     {
-        if (!block->IsFree())
-            return (AllocHandle)block;
+        const size_t slotsInWord = D3D12MA_MIN(m_SlotCount - word * 64, (size_t)64);
+        m_FreeBitmap[word] = slotsInWord < 64 ? (1ULL << slotsInWord) - 1 : UINT64_MAX;
+    }
+    m_FirstFreeSummaryWord = 0;
+    for (size_t word = 0; word < m_FreeWordBitmap.size(); ++word)
+    {
+        const size_t wordsInWord = D3D12MA_MIN(m_FreeBitmap.size() - word * 64, (size_t)64);
+        m_FreeWordBitmap[word] = wordsInWord < 64 ? (1ULL << wordsInWord) - 1 : UINT64_MAX;
     }
-    return (AllocHandle)0;
 }
 
-UINT64 BlockMetadata_TLSF::GetNextFreeRegionSize(AllocHandle alloc) const
+AllocHandle BlockMetadata_Slab::GetAllocationListBegin() const
 {
-    Block* block = (Block*)alloc;
-    D3D12MA_ASSERT(!block->IsFree() && "Incorrect block!");
+    const size_t index = FindAllocatedSlot(0);
+    return index < m_SlotCount ? (AllocHandle)(index + 1) : (AllocHandle)0;
+}
 
-    if (block->prevPhysical)
-        return block->prevPhysical->IsFree() ? block->prevPhysical->size : 0;
-    return 0;
+AllocHandle BlockMetadata_Slab::GetNextAllocation(AllocHandle prevAlloc) const
+{
+    const size_t index = FindAllocatedSlot((size_t)prevAlloc);
+    return index < m_SlotCount ? (AllocHandle)(index + 1) : (AllocHandle)0;
 }
 
-void* BlockMetadata_TLSF::GetAllocationPrivateData(AllocHandle allocHandle) const
+UINT64 BlockMetadata_Slab::GetNextFreeRegionSize(AllocHandle alloc) const
 {
-    Block* block = (Block*)allocHandle;
-    D3D12MA_ASSERT(!block->IsFree() && "Cannot get user data for free block!");
-    return block->PrivateData();
+    const size_t index = (size_t)alloc - 1;
+    D3D12MA_ASSERT(index < m_SlotCount && !IsSlotFree(index) && "Incorrect allocation!");
+
+    UINT64 result = m_SlotSize - m_Slots[index].size;
+    if (index + 1 == m_SlotCount)
+        result += GetUnusableSize();
+    else if (IsSlotFree(index + 1))
+        result += m_SlotSize;
+    return result;
 }
 
-void BlockMetadata_TLSF::SetAllocationPrivateData(AllocHandle allocHandle, void* privateData)
+void* BlockMetadata_Slab::GetAllocationPrivateData(AllocHandle allocHandle) const
 {
-    Block* block = (Block*)allocHandle;
-    D3D12MA_ASSERT(!block->IsFree() && "Trying to set user data for not allocated block!");
-    block->PrivateData() = privateData;
+    const size_t index = (size_t)allocHandle - 1;
+    D3D12MA_ASSERT(index < m_SlotCount && !IsSlotFree(index) && "Cannot get user data for free block!");
+    return m_Slots[index].privateData;
 }
 
-void BlockMetadata_TLSF::AddStatistics(Statistics& inoutStats) const
+void BlockMetadata_Slab::SetAllocationPrivateData(AllocHandle allocHandle, void* privateData)
+{
+    const size_t index = (size_t)allocHandle - 1;
+    D3D12MA_ASSERT(index < m_SlotCount && !IsSlotFree(index) && "Trying to set user data for not allocated block!");
+    m_Slots[index].privateData = privateData;
+}
+
+void BlockMetadata_Slab::AddStatistics(Statistics& inoutStats) const
 {
     inoutStats.BlockCount++;
-    inoutStats.AllocationCount += static_cast<UINT>(m_AllocCount);
+    inoutStats.AllocationCount += static_cast<UINT>(m_AllocationCount);
     inoutStats.BlockBytes += GetSize();
-    inoutStats.AllocationBytes += GetSize() - GetSumFreeSize();
+    inoutStats.AllocationBytes += m_AllocationBytes;
 }
 
-void BlockMetadata_TLSF::AddDetailedStatistics(DetailedStatistics& inoutStats) const
+void BlockMetadata_Slab::AddDetailedStatistics(DetailedStatistics& inoutStats) const
 {
     inoutStats.Stats.BlockCount++;
     inoutStats.Stats.BlockBytes += GetSize();
 
-    for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
+    auto addSlot = [&inoutStats](UINT64 offset, UINT64 size, UINT64 allocationSize, void* privateData)
     {
-        if (block->IsFree())
-            AddDetailedStatisticsUnusedRange(inoutStats, block->size);
-        else
-            AddDetailedStatisticsAllocation(inoutStats, block->size);
-    }
-
-    if (m_NullBlock->size > 0)
-        AddDetailedStatisticsUnusedRange(inoutStats, m_NullBlock->size);
+        if (allocationSize > 0)
+            AddDetailedStatisticsAllocation(inoutStats, allocationSize);
+        if (size > allocationSize)
+            AddDetailedStatisticsUnusedRange(inoutStats, size - allocationSize);
+    };
+    ForEachSlot(addSlot);
 }
 
-void BlockMetadata_TLSF::WriteAllocationInfoToJson(JsonWriter& json) const
+void BlockMetadata_Slab::SetStatisticsSnapshot(StatisticsSnapshot* snapshot)
 {
-    size_t blockCount = m_AllocCount + m_BlocksFreeCount;
-    Vector<Block*> blockList(blockCount, *GetAllocs());
-
-    size_t i = blockCount;
-    if (m_NullBlock->size > 0)
-    {
-        ++blockCount;
-        blockList.push_back(m_NullBlock);
-    }
-    for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
-    {
-        blockList[--i] = block;
-    }
-    D3D12MA_ASSERT(i == 0);
-
-    PrintDetailedMap_Begin(json, GetSumFreeSize(), GetAllocationCount(), m_BlocksFreeCount +
-        (m_NullBlock->size > 0 ? 1 : 0));
-    for (; i < blockCount; ++i)
-    {
-        Block* block = blockList[i];
-        if (block->IsFree())
-            PrintDetailedMap_UnusedRange(json, block->offset, block->size);
-        else
-            PrintDetailedMap_Allocation(json, block->offset, block->size, block->PrivateData());
-    }
-    PrintDetailedMap_End(json);
-}
+    StatisticsSnapshot* const reported = snapshot ? snapshot : m_pStatisticsSnapshot;
+    D3D12MA_ASSERT((snapshot == NULL) != (m_pStatisticsSnapshot == NULL));
 
-void BlockMetadata_TLSF::DebugLogAllAllocations() const
-{
-    for (Block* block = m_NullBlock->prevPhysical; block != NULL; block = block->prevPhysical)
+    auto reportSlot = [snapshot, reported](UINT64 offset, UINT64 size, UINT64 allocationSize, void* privateData)
     {
-        if (!block->IsFree())
+        if (allocationSize > 0)
         {
-            DebugLogAllocation(block->offset, block->size, block->PrivateData());
+            if (snapshot)
+                reported->AddAllocation(allocationSize);
+            else
+                reported->RemoveAllocation(allocationSize);
         }
-    }
-}
-
-UINT8 BlockMetadata_TLSF::SizeToMemoryClass(UINT64 size) const
-{
-    if (size > SMALL_BUFFER_SIZE)
-        return BitScanMSB(size) - MEMORY_CLASS_SHIFT;
-    return 0;
+        if (size > allocationSize)
+        {
+            if (snapshot)
+                reported->AddUnusedRange(size - allocationSize);
+            else
+                reported->RemoveUnusedRange(size - allocationSize);
+        }
+    };
+    ForEachSlot(reportSlot);
+    m_pStatisticsSnapshot = snapshot;
 }
 
-UINT16 BlockMetadata_TLSF::SizeToSecondIndex(UINT64 size, UINT8 memoryClass) const
+void BlockMetadata_Slab::WriteDetailedMap(DetailedMapWriter& writer) const
 {
-    if (memoryClass == 0)
+    // Unused rest of an allocated slot is written as a separate unused range.
+    size_t unusedRangeCount = 0;
+    auto countUnused = [&unusedRangeCount](UINT64 offset, UINT64 size, UINT64 allocationSize, void* privateData)
     {
-        if (IsVirtual())
-            return static_cast<UINT16>((size - 1) / 8);
-        else
-            return static_cast<UINT16>((size - 1) / 64);
-    }
-    return static_cast<UINT16>((size >> (memoryClass + MEMORY_CLASS_SHIFT - SECOND_LEVEL_INDEX)) ^ (1U << SECOND_LEVEL_INDEX));
-}
-
-UINT32 BlockMetadata_TLSF::GetListIndex(UINT8 memoryClass, UINT16 secondIndex) const
-{
-    if (memoryClass == 0)
-        return secondIndex;
-
-    const UINT32 index = static_cast<UINT32>(memoryClass - 1) * (1 << SECOND_LEVEL_INDEX) + secondIndex;
-    if (IsVirtual())
-        return index + (1 << SECOND_LEVEL_INDEX);
-    else
-        return index + 4;
+        if (size > allocationSize)
+            ++unusedRangeCount;
+    };
+    ForEachSlot(countUnused);
+
+    writer.Begin(GetSize(), GetSumFreeSize(), GetAllocationCount(), unusedRangeCount);
+    auto writeSlot = [&writer](UINT64 offset, UINT64 size, UINT64 allocationSize, void* privateData)
+    {
+        if (allocationSize > 0)
+            writer.AddAllocation(offset, allocationSize, privateData);
+        if (size > allocationSize)
+            writer.AddUnusedRange(offset + allocationSize, size - allocationSize);
+    };
+    ForEachSlot(writeSlot);
+    writer.End();
 }
 
-UINT32 BlockMetadata_TLSF::GetListIndex(UINT64 size) const
+void BlockMetadata_Slab::DebugLogAllAllocations() const
 {
-    UINT8 memoryClass = SizeToMemoryClass(size);
-    return GetListIndex(memoryClass, SizeToSecondIndex(size, memoryClass));
+    for (size_t index = FindAllocatedSlot(0); index < m_SlotCount; index = FindAllocatedSlot(index + 1))
+        DebugLogAllocation(index * m_SlotSize, m_Slots[index].size, m_Slots[index].privateData);
 }
 
-void BlockMetadata_TLSF::RemoveFreeBlock(Block* block)
+size_t BlockMetadata_Slab::FindFreeSlot(UINT64 alignment) const
 {
-    D3D12MA_ASSERT(block != m_NullBlock);
-    D3D12MA_ASSERT(block->IsFree());
+    if ((m_SlotSize & (alignment - 1)) == 0)
+    {
+        for (size_t summaryIndex = m_FirstFreeSummaryWord; summaryIndex < m_FreeWordBitmap.size(); ++summaryIndex)
+        {
+            const UINT64 summary = m_FreeWordBitmap[summaryIndex];
+            if (summary != 0)
+            {
+                const size_t word = summaryIndex * 64 + BitScanLSB(summary);
+                return word * 64 + BitScanLSB(m_FreeBitmap[word]);
+            }
+        }
+        return SIZE_MAX;
+    }
 
-    if (block->NextFree() != NULL)
-        block->NextFree()->PrevFree() = block->PrevFree();
-    if (block->PrevFree() != NULL)
-        block->PrevFree()->NextFree() = block->NextFree();
-    else
+    for (size_t word = 0; word < m_FreeBitmap.size(); ++word)
     {
-        UINT8 memClass = SizeToMemoryClass(block->size);
-        UINT16 secondIndex = SizeToSecondIndex(block->size, memClass);
-        UINT32 index = GetListIndex(memClass, secondIndex);
-        m_FreeList[index] = block->NextFree();
-        if (block->NextFree() == NULL)
+        for (UINT64 bits = m_FreeBitmap[word]; bits != 0; bits &= bits - 1)
         {
-            m_InnerIsFreeBitmap[memClass] &= ~(1U << secondIndex);
-            if (m_InnerIsFreeBitmap[memClass] == 0)
-                m_IsFreeBitmap &= ~(1UL << memClass);
+            const size_t index = word * 64 + BitScanLSB(bits);
+            if (((index * m_SlotSize) & (alignment - 1)) == 0)
+                return index;
         }
     }
-    block->MarkTaken();
-    block->PrivateData() = NULL;
-    --m_BlocksFreeCount;
-    m_BlocksFreeSize -= block->size;
+    return SIZE_MAX;
 }
 
-void BlockMetadata_TLSF::InsertFreeBlock(Block* block)
+size_t BlockMetadata_Slab::FindAllocatedSlot(size_t first) const
 {
-    D3D12MA_ASSERT(block != m_NullBlock);
-    D3D12MA_ASSERT(!block->IsFree() && "Cannot insert block twice!");
-
-    UINT8 memClass = SizeToMemoryClass(block->size);
-    UINT16 secondIndex = SizeToSecondIndex(block->size, memClass);
-    UINT32 index = GetListIndex(memClass, secondIndex);
-    block->PrevFree() = NULL;
-    block->NextFree() = m_FreeList[index];
-    m_FreeList[index] = block;
-    if (block->NextFree() != NULL)
-        block->NextFree()->PrevFree() = block;
-    else
+    for (size_t word = first / 64; word < m_FreeBitmap.size(); ++word)
     {
-        m_InnerIsFreeBitmap[memClass] |= 1U << secondIndex;
-        m_IsFreeBitmap |= 1UL << memClass;
+        UINT64 allocated = ~m_FreeBitmap[word];
+        if (word == first / 64)
+            allocated &= UINT64_MAX << (first % 64);
+        if (allocated != 0)
+            return D3D12MA_MIN(word * 64 + BitScanLSB(allocated), m_SlotCount);
     }
-    ++m_BlocksFreeCount;
-    m_BlocksFreeSize += block->size;
+    return m_SlotCount;
 }
 
-void BlockMetadata_TLSF::MergeBlock(Block* block, Block* prev)
+void BlockMetadata_Slab::MarkFree(size_t index)
 {
-    D3D12MA_ASSERT(block->prevPhysical == prev && "Cannot merge seperate physical regions!");
-    D3D12MA_ASSERT(!prev->IsFree() && "Cannot merge block that belongs to free list!");
-
-    block->offset = prev->offset;
-    block->size += prev->size;
-    block->prevPhysical = prev->prevPhysical;
-    if (block->prevPhysical)
-        block->prevPhysical->nextPhysical = block;
-    m_BlockAllocator.Free(prev);
+    const size_t word = index / 64;
+    m_FreeBitmap[word] |= 1ULL << (index % 64);
+    m_FreeWordBitmap[word / 64] |= 1ULL << (word % 64);
+    m_FirstFreeSummaryWord = D3D12MA_MIN(m_FirstFreeSummaryWord, word / 64);
+    ++m_FreeCount;
 }
 
-BlockMetadata_TLSF::Block* BlockMetadata_TLSF::FindFreeBlock(UINT64 size, UINT32& listIndex) const
+void BlockMetadata_Slab::MarkAllocated(size_t index)
 {
-    UINT8 memoryClass = SizeToMemoryClass(size);
-    UINT32 innerFreeMap = m_InnerIsFreeBitmap[memoryClass] & (~0U << SizeToSecondIndex(size, memoryClass));
-    if (!innerFreeMap)
+    const size_t word = index / 64;
+    m_FreeBitmap[word] &= ~(1ULL << (index % 64));
+    if (m_FreeBitmap[word] == 0)
     {
-        // Check higher levels for avaiable blocks
-        UINT32 freeMap = m_IsFreeBitmap & (~0UL << (memoryClass + 1));
-        if (!freeMap)
-            return NULL; // No more memory avaible
-
-        // Find lowest free region
-        memoryClass = BitScanLSB(freeMap);
-        innerFreeMap = m_InnerIsFreeBitmap[memoryClass];
-        D3D12MA_ASSERT(innerFreeMap != 0);
+        m_FreeWordBitmap[word / 64] &= ~(1ULL << (word % 64));
+        while (m_FirstFreeSummaryWord < m_FreeWordBitmap.size() && m_FreeWordBitmap[m_FirstFreeSummaryWord] == 0)
+            ++m_FirstFreeSummaryWord;
     }
-    // Find lowest free subregion
-    listIndex = GetListIndex(memoryClass, BitScanLSB(innerFreeMap));
-    return m_FreeList[listIndex];
+    --m_FreeCount;
 }
 
-bool BlockMetadata_TLSF::CheckBlock(
-    Block& block,
-    UINT32 listIndex,
-    UINT64 allocSize,
-    UINT64 allocAlignment,
-    AllocationRequest* pAllocationRequest)
+template<typename FuncT>
+void BlockMetadata_Slab::ForEachSlot(FuncT& func) const
 {
-    D3D12MA_ASSERT(block.IsFree() && "Block is already taken!");
-
-    UINT64 alignedOffset = AlignUp(block.offset, allocAlignment);
-    if (block.size < allocSize + alignedOffset - block.offset)
-        return false;
-
-    // Alloc successful
-    pAllocationRequest->allocHandle = (AllocHandle)&block;
-    pAllocationRequest->size = allocSize - GetDebugMargin();
-    pAllocationRequest->algorithmData = alignedOffset;
-
-    // Place block at the start of list if it's normal block
-    if (listIndex != m_ListsCount && block.PrevFree())
-    {
-        block.PrevFree()->NextFree() = block.NextFree();
-        if (block.NextFree())
-            block.NextFree()->PrevFree() = block.PrevFree();
-        block.PrevFree() = NULL;
-        block.NextFree() = m_FreeList[listIndex];
-        m_FreeList[listIndex] = &block;
-        if (block.NextFree())
-            block.NextFree()->PrevFree() = &block;
-    }
-
-    return true;
+    for (size_t index = 0; index < m_SlotCount; ++index)
+        func(index * m_SlotSize, m_SlotSize, m_Slots[index].size, m_Slots[index].privateData);
+    if (GetUnusableSize() > 0)
+        func(m_SlotCount * m_SlotSize, GetUnusableSize(), 0, NULL);
 }
-#endif // _D3D12MA_BLOCK_METADATA_TLSF_FUNCTIONS
-#endif // _D3D12MA_BLOCK_METADATA_TLSF
+#endif // _D3D12MA_BLOCK_METADATA_SLAB_FUNCTIONS
+#endif // _D3D12MA_BLOCK_METADATA_SLAB
 
 #ifndef _D3D12MA_MEMORY_BLOCK
 /*
@@ -5473,6 +8042,8 @@ class NormalBlock : public MemoryBlock
 {
 public:
     BlockMetadata* m_pMetadata;
+    // Index of this block in BlockVector::m_Blocks, maintained by the BlockVector.
+    size_t m_IndexInBlockVector = SIZE_MAX;
 
     NormalBlock(
         AllocatorPimpl* allocator,
@@ -5486,7 +8057,8 @@ public:
     BlockVector* GetBlockVector() const { return m_BlockVector; }
 
     // 'algorithm' should be one of the *_ALGORITHM_* flags in enums POOL_FLAGS or VIRTUAL_BLOCK_FLAGS
-    HRESULT Init(UINT32 algorithm, ID3D12ProtectedResourceSession* pProtectedSession, bool denyMsaaTextures);
+    // 'slotSize' is used only with POOL_FLAG_ALGORITHM_SLAB.
+    HRESULT Init(UINT32 algorithm, UINT64 slotSize, ID3D12ProtectedResourceSession* pProtectedSession, bool denyMsaaTextures);
 
     // Validates all data structures inside this object. If not valid, returns false.
     bool Validate() const;
@@ -5535,7 +8107,7 @@ class CommittedAllocationList
 {
 public:
     CommittedAllocationList() = default;
-    void Init(bool useMutex, D3D12_HEAP_TYPE heapType, PoolPimpl* pool);
+    void Init(bool useMutex, bool useStatisticsSnapshot, D3D12_HEAP_TYPE heapType, PoolPimpl* pool);
     ~CommittedAllocationList();
 
     D3D12_HEAP_TYPE GetHeapType() const { return m_HeapType; }
@@ -5546,19 +8118,26 @@ public:
     void AddDetailedStatistics(DetailedStatistics& inoutStats);
     // Writes JSON array with the list of allocations.
     void BuildStatsString(JsonWriter& json);
+    // Writes the number of allocations followed by their entries.
+    void WriteStatsBinary(BinaryStatsWriter& writer);
+    void AddToSnapshot(SnapshotPimpl& snapshot, UINT poolId);
 
     void Register(Allocation* alloc);
     void Unregister(Allocation* alloc);
+    void SetLockProfile(LockProfile* profile) { BindLockProfile(m_Mutex, profile); }
 
 private:
     using CommittedAllocationLinkedList = IntrusiveLinkedList<CommittedAllocationListItemTraits>;
 
     bool m_UseMutex = true;
+    bool m_UseStatisticsSnapshot = false;
     D3D12_HEAP_TYPE m_HeapType = D3D12_HEAP_TYPE_CUSTOM;
     PoolPimpl* m_Pool = NULL;
 
     D3D12MA_RW_MUTEX m_Mutex;
     CommittedAllocationLinkedList m_AllocationList;
+    // Used instead of walking m_AllocationList when m_UseStatisticsSnapshot.
+    StatisticsSnapshot m_StatisticsSnapshot;
 };
 #endif // _D3D12MA_COMMITTED_ALLOCATION_LIST
 
@@ -5707,6 +8286,24 @@ private:
 #endif
 };
 
+#ifndef _D3D12MA_BATCH_ALLOCATION_REQUEST
+/*
+Single entry of a batch passed to Allocator::AllocateMemoryBatch or
+Allocator::CreateResourceBatch, with allocation parameters already calculated.
+pAllocation is null until the request is satisfied.
+*/
+struct BatchAllocationRequest
+{
+    UINT64 Size = 0;
+    UINT64 Alignment = 0;
+    const ALLOCATION_DESC* pAllocDesc = NULL;
+    BlockVector* pBlockVector = NULL;
+    CommittedAllocationParameters CommittedParams;
+    bool PreferCommitted = false;
+    Allocation* pAllocation = NULL;
+};
+#endif // _D3D12MA_BATCH_ALLOCATION_REQUEST
+
 #ifndef _D3D12MA_BLOCK_VECTOR
 /*
 Sequence of NormalBlock. Represents memory blocks allocated for a specific
@@ -5729,16 +8326,21 @@ public:
         bool explicitBlockSize,
         UINT64 minAllocationAlignment,
         UINT32 algorithm,
+        UINT64 slotSize,
         bool denyMsaaTextures,
         ID3D12ProtectedResourceSession* pProtectedSession,
         D3D12_RESIDENCY_PRIORITY residencyPriority);
     ~BlockVector();
+    // Unique among all block vectors of the allocator, used as SNAPSHOT_CHANGE::PoolId.
+    UINT GetId() const { return m_Id; }
     D3D12_RESIDENCY_PRIORITY GetResidencyPriority() const { return m_ResidencyPriority; }
 
     const D3D12_HEAP_PROPERTIES& GetHeapProperties() const { return m_HeapProps; }
     D3D12_HEAP_FLAGS GetHeapFlags() const { return m_HeapFlags; }
     UINT64 GetPreferredBlockSize() const { return m_PreferredBlockSize; }
     UINT32 GetAlgorithm() const { return m_Algorithm; }
+    // Size of slots of POOL_FLAG_ALGORITHM_SLAB, 0 with other algorithms.
+    UINT64 GetSlotSize() const { return m_SlotSize; }
     bool DeniesMsaaTextures() const { return m_DenyMsaaTextures; }
     // To be used only while the m_Mutex is locked. Used during defragmentation.
     size_t GetBlockCount() const { return m_Blocks.size(); }
@@ -5757,7 +8359,27 @@ public:
         size_t allocationCount,
         Allocation** pAllocations);
 
+    /*
+    Allocates memory for all given requests under a single lock of m_Mutex.
+    inoutFreeMemory is the remaining budget, queried once by the caller and
+    decreased here by the size of every new block created.
+    Requests that allow a committed allocation and cannot be satisfied are left
+    with null pAllocation. Any other failure stops the loop and returns an error,
+    leaving the allocations already made for the caller to free.
+    */
+    HRESULT AllocateBatch(
+        size_t requestCount,
+        BatchAllocationRequest* const* ppRequests,
+        UINT64& inoutFreeMemory);
+
     void Free(Allocation* hAllocation);
+    /*
+    Frees multiple allocations from this block vector under a single lock of m_Mutex.
+    Empty blocks are released following the same rules as in Free, then the blocks
+    are fully sorted once instead of incrementally after every allocation.
+    Allocation objects are not freed.
+    */
+    void FreeBatch(size_t allocationCount, Allocation* const* pAllocations);
 
     HRESULT CreateResource(
         UINT64 size,
@@ -5769,88 +8391,484 @@ public:
         REFIID riidResource,
         void** ppvResource);
 
-    void AddStatistics(Statistics& inoutStats);
-    void AddDetailedStatistics(DetailedStatistics& inoutStats);
+    void AddStatistics(Statistics& inoutStats);
+    void AddDetailedStatistics(DetailedStatistics& inoutStats);
+
+    void WriteBlockInfoToJson(JsonWriter& json);
+    void WriteBlockInfoToBinary(BinaryStatsWriter& writer);
+    void AddToSnapshot(SnapshotPimpl& snapshot);
+
+private:
+    AllocatorPimpl* const m_hAllocator;
+    const UINT m_Id;
+    const D3D12_HEAP_PROPERTIES m_HeapProps;
+    const D3D12_HEAP_FLAGS m_HeapFlags;
+    const UINT64 m_PreferredBlockSize;
+    const size_t m_MinBlockCount;
+    const size_t m_MaxBlockCount;
+    const bool m_ExplicitBlockSize;
+    const UINT64 m_MinAllocationAlignment;
+    const UINT32 m_Algorithm;
+    const UINT64 m_SlotSize;
+    const bool m_DenyMsaaTextures;
+    ID3D12ProtectedResourceSession* const m_ProtectedSession;
+    const D3D12_RESIDENCY_PRIORITY m_ResidencyPriority;
+    /* There can be at most one allocation that is completely empty - a
+    hysteresis to avoid pessimistic case of alternating creation and destruction
+    of a ID3D12Heap. */
+    bool m_HasEmptyBlock;
+    D3D12MA_RW_MUTEX m_Mutex;
+    // Metadata of all blocks reports to m_StatisticsSnapshot, read by AddStatistics
+    // and AddDetailedStatistics without locking m_Mutex.
+    const bool m_UseStatisticsSnapshot;
+    StatisticsSnapshot m_StatisticsSnapshot;
+    // Incrementally sorted by sumFreeSize, ascending.
+    Vector<NormalBlock*> m_Blocks;
+    /*
+    Max segment tree indexed like m_Blocks: leaf i holds the bound of the largest free region
+    of m_Blocks[i], every inner node the maximum of its children, node 1 being the root. It lets
+    AllocatePage skip blocks that cannot fit the allocation in O(log n) instead of trying them one by one.
+    */
+    Vector<UINT64> m_FreeSizeTree;
+    size_t m_FreeSizeTreeLeafCount;
+    UINT m_NextBlockId;
+    bool m_IncrementalSort = true;
+
+    // Disable incremental sorting when freeing allocations
+    void SetIncrementalSort(bool val) { m_IncrementalSort = val; }
+
+    UINT64 CalcSumBlockSize() const;
+    UINT64 CalcMaxBlockSize() const;
+
+    // Finds and removes given block from vector.
+    void Remove(NormalBlock* pBlock);
+    // To be called when ALLOCATOR_FLAG_TRACE_EVENTS is used.
+    void RecordBlockEvent(TRACE_EVENT_TYPE type, const NormalBlock& block) const;
+    void RecordAllocationEvent(TRACE_EVENT_TYPE type, const Allocation& alloc) const;
+    // To be called when a block is added to or removed from m_Blocks.
+    void AttachStatisticsSnapshot(NormalBlock* pBlock);
+    void DetachStatisticsSnapshot(NormalBlock* pBlock);
+
+    // Performs single step in sorting m_Blocks. They may not be fully sorted
+    // after this call.
+    void IncrementallySortBlocks();
+    void SortByFreeSize();
+    void SwapBlocks(size_t blockIndex1, size_t blockIndex2);
+
+    // To be called when free size of the block changed or it was moved to a different index.
+    void UpdateFreeSizeIndex(size_t blockIndex);
+    // Same for all blocks in range [firstBlockIndex, endBlockIndex), e.g. ones shifted by a removal.
+    // Leaves past the last block are cleared.
+    void UpdateFreeSizeIndexRange(size_t firstBlockIndex, size_t endBlockIndex);
+    // To be called after blocks were reordered or the tree has to grow.
+    void RebuildFreeSizeIndex();
+    // Returns index of the first block at or after firstBlockIndex whose largest free region
+    // may fit minFreeSize, or SIZE_MAX if there is none.
+    size_t FindBlockByFreeSize(size_t firstBlockIndex, UINT64 minFreeSize) const;
+
+    // Returns number of bytes that can still be allocated within the budget
+    // of the heap type of this block vector, or UINT64_MAX for custom heaps.
+    UINT64 CalcFreeMemoryInBudget();
+
+    HRESULT AllocatePage(
+        UINT64 size,
+        UINT64 alignment,
+        const ALLOCATION_DESC& allocDesc,
+        bool committedAllowed,
+        UINT64& inoutFreeMemory,
+        Allocation** pAllocation);
+
+    HRESULT AllocateFromBlock(
+        NormalBlock* pBlock,
+        UINT64 size,
+        UINT64 alignment,
+        ALLOCATION_FLAGS allocFlags,
+        void* pPrivateData,
+        UINT32 strategy,
+        Allocation** pAllocation);
+
+    HRESULT CommitAllocationRequest(
+        AllocationRequest& allocRequest,
+        NormalBlock* pBlock,
+        UINT64 size,
+        UINT64 alignment,
+        void* pPrivateData,
+        Allocation** pAllocation);
+
+    HRESULT CreateBlock(
+        UINT64 blockSize,
+        size_t* pNewBlockIndex);
+};
+#endif // _D3D12MA_BLOCK_VECTOR
+
+#ifndef _D3D12MA_TRACE_RING
+/*
+Ring of the most recent events recorded with ALLOCATOR_FLAG_TRACE_EVENTS.
+
+A writer takes the next sequence number with a single atomic increment and fills
+the slot at that index modulo capacity. Every slot is guarded by its own version,
+odd while being written and 2 * (sequence number + 1) once complete, so readers
+copy events without taking a lock and skip the ones overwritten in the meantime.
+A writer takes the slot only if the event of the previous lap is complete. If its
+writer is still in the middle of it, the new event is dropped and counted instead.
+Its slot then keeps the old version, so readers stop there until the slot is reused.
+Payload words are atomic only to make the race with readers well-defined,
+relaxed accesses compile to plain loads and stores.
+*/
+class TraceRing
+{
+public:
+    TraceRing(const ALLOCATION_CALLBACKS& allocationCallbacks, UINT capacity);
+    ~TraceRing();
+
+    void Record(TRACE_EVENT_TYPE type, D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId,
+        UINT64 allocationId, UINT64 offset, UINT64 size, UINT64 extra);
+    void RecordAllocation(TRACE_EVENT_TYPE type, const Allocation& alloc,
+        D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId, UINT64 offset);
+    void RecordBudget(UINT group, UINT64 usageBytes, UINT64 budgetBytes);
+
+    UINT64 GetDroppedEventCount() const { return m_DroppedEventCount.load(std::memory_order_relaxed); }
+
+    UINT Read(UINT64& inoutNextSequenceNumber, TRACE_EVENT* pEvents, UINT maxEventCount) const;
+    void Write(UINT64& inoutNextSequenceNumber, WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData) const;
+
+private:
+    static const UINT WORD_COUNT = 7;
+    // 64 bytes, so that threads recording at the same time don't share cache lines.
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        D3D12MA_ATOMIC_UINT64 Version;
+        D3D12MA_ATOMIC_UINT64 Words[WORD_COUNT];
+    };
+
+    const ALLOCATION_CALLBACKS& m_AllocationCallbacks;
+    const UINT64 m_Capacity;
+    Slot* const m_Slots;
+    const std::chrono::steady_clock::time_point m_StartTime;
+    alignas(CACHE_LINE_SIZE) D3D12MA_ATOMIC_UINT64 m_NextSequenceNumber = {0};
+    D3D12MA_ATOMIC_UINT64 m_DroppedEventCount = {0};
+
+    D3D12MA_CLASS_NO_COPY(TraceRing)
+};
+
+#ifndef _D3D12MA_TRACE_RING_FUNCTIONS
+TraceRing::TraceRing(const ALLOCATION_CALLBACKS& allocationCallbacks, UINT capacity)
+    : m_AllocationCallbacks(allocationCallbacks),
+    m_Capacity(NextPow2((UINT64)D3D12MA_MAX(capacity, 1u))),
+    m_Slots(D3D12MA_NEW_ARRAY(allocationCallbacks, Slot, (size_t)m_Capacity)),
+    m_StartTime(std::chrono::steady_clock::now())
+{
+    for (UINT64 i = 0; i < m_Capacity; ++i)
+    {
+        m_Slots[i].Version.store(0, std::memory_order_relaxed);
+        for (UINT w = 0; w < WORD_COUNT; ++w)
+            m_Slots[i].Words[w].store(0, std::memory_order_relaxed);
+    }
+}
+
+TraceRing::~TraceRing()
+{
+    D3D12MA_DELETE_ARRAY(m_AllocationCallbacks, m_Slots, (size_t)m_Capacity);
+}
+
+void TraceRing::Record(TRACE_EVENT_TYPE type, D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId,
+    UINT64 allocationId, UINT64 offset, UINT64 size, UINT64 extra)
+{
+    const UINT64 timestamp = (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_StartTime).count();
+    const UINT64 sequenceNumber = m_NextSequenceNumber.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = m_Slots[sequenceNumber & (m_Capacity - 1)];
+
+    // Expect the complete event of the previous lap. An older even version means that event
+    // was dropped, so the slot is free as well. Odd means its writer is still there, not smaller
+    // means a newer event already took the slot - this thread was lapped by the whole ring.
+    const UINT64 writingVersion = sequenceNumber * 2 + 1;
+    UINT64 version = sequenceNumber >= m_Capacity ? (sequenceNumber - m_Capacity) * 2 + 2 : 0;
+    while (!slot.Version.compare_exchange_weak(version, writingVersion, std::memory_order_relaxed))
+    {
+        if ((version & 1) != 0 || version >= writingVersion)
+        {
+            m_DroppedEventCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.Words[0].store(timestamp, std::memory_order_relaxed);
+    slot.Words[1].store(allocationId, std::memory_order_relaxed);
+    slot.Words[2].store(offset, std::memory_order_relaxed);
+    slot.Words[3].store(size, std::memory_order_relaxed);
+    slot.Words[4].store(extra, std::memory_order_relaxed);
+    slot.Words[5].store((UINT64)type | ((UINT64)heapType << 8) | ((UINT64)poolId << 32), std::memory_order_relaxed);
+    slot.Words[6].store((UINT64)blockId | ((UINT64)GetCurrentThreadIndex() << 32), std::memory_order_relaxed);
+    slot.Version.store(sequenceNumber * 2 + 2, std::memory_order_release);
+}
+
+void TraceRing::RecordAllocation(TRACE_EVENT_TYPE type, const Allocation& alloc,
+    D3D12_HEAP_TYPE heapType, UINT poolId, UINT blockId, UINT64 offset)
+{
+    Record(type, heapType, poolId, blockId, SnapshotPimpl::GetAllocationId(alloc), offset, alloc.GetSize(),
+        type == TRACE_EVENT_TYPE_ALLOCATE ? alloc.GetAlignment() : 0);
+}
+
+void TraceRing::RecordBudget(UINT group, UINT64 usageBytes, UINT64 budgetBytes)
+{
+    // Memory segment group takes the place of the block ID.
+    Record(TRACE_EVENT_TYPE_BUDGET_UPDATE, (D3D12_HEAP_TYPE)0, 0, group, 0, usageBytes, budgetBytes, 0);
+}
+
+UINT TraceRing::Read(UINT64& inoutNextSequenceNumber, TRACE_EVENT* pEvents, UINT maxEventCount) const
+{
+    const UINT64 end = m_NextSequenceNumber.load(std::memory_order_acquire);
+    UINT64 sequenceNumber = inoutNextSequenceNumber;
+    // Skip events that were already overwritten.
+    if (end > m_Capacity && sequenceNumber < end - m_Capacity)
+        sequenceNumber = end - m_Capacity;
+
+    UINT eventCount = 0;
+    for (; sequenceNumber < end && eventCount < maxEventCount; ++sequenceNumber)
+    {
+        const Slot& slot = m_Slots[sequenceNumber & (m_Capacity - 1)];
+        const UINT64 completeVersion = sequenceNumber * 2 + 2;
+        const UINT64 version = slot.Version.load(std::memory_order_acquire);
+        // Still being written - leave it and all the following events for the next call.
+        if (version < completeVersion)
+            break;
+        // Overwritten by a newer event.
+        if (version > completeVersion)
+            continue;
+
+        UINT64 words[WORD_COUNT];
+        for (UINT w = 0; w < WORD_COUNT; ++w)
+            words[w] = slot.Words[w].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.Version.load(std::memory_order_relaxed) != completeVersion)
+            continue;
+
+        TRACE_EVENT& event = pEvents[eventCount++];
+        event = {};
+        event.Type = (TRACE_EVENT_TYPE)(words[5] & 0xFF);
+        event.SequenceNumber = sequenceNumber;
+        event.Timestamp = words[0];
+        event.ThreadId = (UINT)(words[6] >> 32);
+        if (event.Type == TRACE_EVENT_TYPE_BUDGET_UPDATE)
+        {
+            event.MemorySegmentGroup = (UINT)words[6];
+            event.UsageBytes = words[2];
+            event.BudgetBytes = words[3];
+            continue;
+        }
+        event.HeapType = (D3D12_HEAP_TYPE)((words[5] >> 8) & 0xFF);
+        event.PoolId = (UINT)(words[5] >> 32);
+        event.BlockId = (UINT)words[6];
+        event.AllocationId = words[1];
+        event.Offset = words[2];
+        event.Size = words[3];
+        if (event.Type == TRACE_EVENT_TYPE_ALLOCATE)
+            event.Alignment = words[4];
+        else if (event.Type == TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE)
+            event.TemporaryAllocationId = words[4];
+    }
+    inoutNextSequenceNumber = sequenceNumber;
+    return eventCount;
+}
+
+void TraceRing::Write(UINT64& inoutNextSequenceNumber, WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData) const
+{
+    BinaryStatsWriter writer(m_AllocationCallbacks, writeFunc, pPrivateData);
+    writer.WriteHeader(BinaryStatsWriter::FORMAT_TRACE);
+
+    // Sequence numbers and timestamps are written as differences from the previous event.
+    UINT64 prevSequenceNumber = 0, prevTimestamp = 0;
+    TRACE_EVENT events[64];
+    for (;;)
+    {
+        const UINT eventCount = Read(inoutNextSequenceNumber, events, (UINT)(sizeof(events) / sizeof(events[0])));
+        if (eventCount == 0)
+            break;
+        for (UINT i = 0; i < eventCount; ++i)
+        {
+            const TRACE_EVENT& event = events[i];
+            // 0 is reserved for the end of the list.
+            writer.WriteNumber((UINT)event.Type + 1);
+            writer.WriteNumber(event.SequenceNumber - prevSequenceNumber);
+            writer.WriteSignedNumber((int64_t)(event.Timestamp - prevTimestamp));
+            writer.WriteNumber(event.ThreadId);
+            prevSequenceNumber = event.SequenceNumber;
+            prevTimestamp = event.Timestamp;
+
+            if (event.Type == TRACE_EVENT_TYPE_BUDGET_UPDATE)
+            {
+                writer.WriteNumber(event.MemorySegmentGroup);
+                writer.WriteNumber(event.UsageBytes);
+                writer.WriteNumber(event.BudgetBytes);
+                continue;
+            }
+            writer.WriteNumber((UINT)event.HeapType);
+            writer.WriteNumber(event.PoolId);
+            if (event.Type == TRACE_EVENT_TYPE_CREATE_BLOCK || event.Type == TRACE_EVENT_TYPE_DESTROY_BLOCK)
+            {
+                writer.WriteNumber(event.BlockId);
+                writer.WriteNumber(event.Size);
+                continue;
+            }
+            // UINT_MAX of committed allocations becomes 0.
+            writer.WriteNumber((UINT)(event.BlockId + 1));
+            writer.WriteNumber(event.AllocationId);
+            writer.WriteNumber(event.Offset);
+            writer.WriteNumber(event.Size);
+            if (event.Type == TRACE_EVENT_TYPE_ALLOCATE)
+                writer.WriteNumber(event.Alignment);
+            else if (event.Type == TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE)
+                writer.WriteNumber(event.TemporaryAllocationId);
+        }
+    }
+    writer.WriteNumber(0);
+}
+#endif // _D3D12MA_TRACE_RING_FUNCTIONS
+#endif // _D3D12MA_TRACE_RING
+
+#ifndef _D3D12MA_PERFORMANCE_COUNTERS
+/*
+Counters of ALLOCATOR_FLAG_PERFORMANCE_COUNTERS, striped by thread index the same way
+as the budget counters (see D3D12MA_BUDGET_COUNTER_STRIPE_COUNT) and summed when read.
+The number of measurements in a histogram is not stored, it's the sum of its buckets.
+*/
+class PerformanceCounterSet
+{
+public:
+    static UINT64 Now()
+    {
+        return (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    // Index in TotalStatistics::HeapType.
+    static UINT HeapTypeToIndex(D3D12_HEAP_TYPE heapType)
+    {
+        return heapType >= D3D12_HEAP_TYPE_DEFAULT && (UINT)heapType <= HEAP_TYPE_COUNT ? (UINT)heapType - 1 : 0;
+    }
 
-    void WriteBlockInfoToJson(JsonWriter& json);
+    void RecordLatency(PERFORMANCE_COUNTER_OPERATION operation, D3D12_HEAP_TYPE heapType, UINT64 nanoseconds);
+    void RecordPlacementDecision(PLACEMENT_DECISION decision, D3D12_HEAP_TYPE heapType);
+    void Get(PerformanceCounters& outCounters) const;
 
 private:
-    AllocatorPimpl* const m_hAllocator;
-    const D3D12_HEAP_PROPERTIES m_HeapProps;
-    const D3D12_HEAP_FLAGS m_HeapFlags;
-    const UINT64 m_PreferredBlockSize;
-    const size_t m_MinBlockCount;
-    const size_t m_MaxBlockCount;
-    const bool m_ExplicitBlockSize;
-    const UINT64 m_MinAllocationAlignment;
-    const UINT32 m_Algorithm;
-    const bool m_DenyMsaaTextures;
-    ID3D12ProtectedResourceSession* const m_ProtectedSession;
-    const D3D12_RESIDENCY_PRIORITY m_ResidencyPriority;
-    /* There can be at most one allocation that is completely empty - a
-    hysteresis to avoid pessimistic case of alternating creation and destruction
-    of a ID3D12Heap. */
-    bool m_HasEmptyBlock;
-    D3D12MA_RW_MUTEX m_Mutex;
-    // Incrementally sorted by sumFreeSize, ascending.
-    Vector<NormalBlock*> m_Blocks;
-    UINT m_NextBlockId;
-    bool m_IncrementalSort = true;
+    struct Histogram
+    {
+        D3D12MA_ATOMIC_UINT64 TotalNanoseconds = {0};
+        D3D12MA_ATOMIC_UINT64 MaxNanoseconds = {0};
+        D3D12MA_ATOMIC_UINT64 Buckets[LATENCY_HISTOGRAM_BUCKET_COUNT] = {};
+    };
+    struct alignas(CACHE_LINE_SIZE) Stripe
+    {
+        Histogram Operations[PERFORMANCE_COUNTER_OPERATION_COUNT][HEAP_TYPE_COUNT];
+        D3D12MA_ATOMIC_UINT64 PlacementDecisions[PLACEMENT_DECISION_COUNT][HEAP_TYPE_COUNT] = {};
+    };
 
-    // Disable incremental sorting when freeing allocations
-    void SetIncrementalSort(bool val) { m_IncrementalSort = val; }
+    Stripe m_Stripes[D3D12MA_BUDGET_COUNTER_STRIPE_COUNT];
 
-    UINT64 CalcSumBlockSize() const;
-    UINT64 CalcMaxBlockSize() const;
+    Stripe& GetCurrentStripe() { return m_Stripes[GetCurrentThreadIndex() % D3D12MA_BUDGET_COUNTER_STRIPE_COUNT]; }
+};
 
-    // Finds and removes given block from vector.
-    void Remove(NormalBlock* pBlock);
+// Measures time until Stop() or the end of scope. Does nothing when counters are null.
+class PerformanceTimer
+{
+public:
+    PerformanceTimer(PerformanceCounterSet* counters, PERFORMANCE_COUNTER_OPERATION operation, D3D12_HEAP_TYPE heapType)
+        : m_Counters(counters), m_Operation(operation), m_HeapType(heapType),
+        m_Begin(counters != NULL ? PerformanceCounterSet::Now() : 0) {}
+    ~PerformanceTimer() { Stop(); }
 
-    // Performs single step in sorting m_Blocks. They may not be fully sorted
-    // after this call.
-    void IncrementallySortBlocks();
-    void SortByFreeSize();
+    void Stop()
+    {
+        if (m_Counters != NULL)
+        {
+            m_Counters->RecordLatency(m_Operation, m_HeapType, PerformanceCounterSet::Now() - m_Begin);
+            m_Counters = NULL;
+        }
+    }
 
-    HRESULT AllocatePage(
-        UINT64 size,
-        UINT64 alignment,
-        const ALLOCATION_DESC& allocDesc,
-        bool committedAllowed,
-        Allocation** pAllocation);
+private:
+    PerformanceCounterSet* m_Counters;
+    const PERFORMANCE_COUNTER_OPERATION m_Operation;
+    const D3D12_HEAP_TYPE m_HeapType;
+    const UINT64 m_Begin;
 
-    HRESULT AllocateFromBlock(
-        NormalBlock* pBlock,
-        UINT64 size,
-        UINT64 alignment,
-        ALLOCATION_FLAGS allocFlags,
-        void* pPrivateData,
-        UINT32 strategy,
-        Allocation** pAllocation);
+    D3D12MA_CLASS_NO_COPY(PerformanceTimer)
+};
 
-    HRESULT CommitAllocationRequest(
-        AllocationRequest& allocRequest,
-        NormalBlock* pBlock,
-        UINT64 size,
-        UINT64 alignment,
-        void* pPrivateData,
-        Allocation** pAllocation);
+#ifndef _D3D12MA_PERFORMANCE_COUNTERS_FUNCTIONS
+void PerformanceCounterSet::RecordLatency(PERFORMANCE_COUNTER_OPERATION operation, D3D12_HEAP_TYPE heapType, UINT64 nanoseconds)
+{
+    Histogram& histogram = GetCurrentStripe().Operations[operation][HeapTypeToIndex(heapType)];
+    const UINT bucket = nanoseconds != 0 ? D3D12MA_MIN((UINT)BitScanMSB(nanoseconds), LATENCY_HISTOGRAM_BUCKET_COUNT - 1) : 0;
+    histogram.Buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    histogram.TotalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    UINT64 prevMax = histogram.MaxNanoseconds.load(std::memory_order_relaxed);
+    while (nanoseconds > prevMax &&
+        !histogram.MaxNanoseconds.compare_exchange_weak(prevMax, nanoseconds, std::memory_order_relaxed)) {}
+}
 
-    HRESULT CreateBlock(
-        UINT64 blockSize,
-        size_t* pNewBlockIndex);
-};
-#endif // _D3D12MA_BLOCK_VECTOR
+void PerformanceCounterSet::RecordPlacementDecision(PLACEMENT_DECISION decision, D3D12_HEAP_TYPE heapType)
+{
+    GetCurrentStripe().PlacementDecisions[decision][HeapTypeToIndex(heapType)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformanceCounterSet::Get(PerformanceCounters& outCounters) const
+{
+    ZeroMemory(&outCounters, sizeof(outCounters));
+    for (UINT stripeIndex = 0; stripeIndex < D3D12MA_BUDGET_COUNTER_STRIPE_COUNT; ++stripeIndex)
+    {
+        const Stripe& stripe = m_Stripes[stripeIndex];
+        for (UINT heapTypeIndex = 0; heapTypeIndex < HEAP_TYPE_COUNT; ++heapTypeIndex)
+        {
+            for (UINT operation = 0; operation < PERFORMANCE_COUNTER_OPERATION_COUNT; ++operation)
+            {
+                const Histogram& src = stripe.Operations[operation][heapTypeIndex];
+                LatencyHistogram& dst = outCounters.Operations[operation][heapTypeIndex];
+                dst.TotalNanoseconds += src.TotalNanoseconds.load(std::memory_order_relaxed);
+                dst.MaxNanoseconds = D3D12MA_MAX(dst.MaxNanoseconds, src.MaxNanoseconds.load(std::memory_order_relaxed));
+                for (UINT bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKET_COUNT; ++bucket)
+                {
+                    const UINT64 count = src.Buckets[bucket].load(std::memory_order_relaxed);
+                    dst.Buckets[bucket] += count;
+                    dst.Count += count;
+                }
+            }
+            for (UINT decision = 0; decision < PLACEMENT_DECISION_COUNT; ++decision)
+            {
+                outCounters.PlacementDecisions[decision][heapTypeIndex] +=
+                    stripe.PlacementDecisions[decision][heapTypeIndex].load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+#endif // _D3D12MA_PERFORMANCE_COUNTERS_FUNCTIONS
+#endif // _D3D12MA_PERFORMANCE_COUNTERS
 
 #ifndef _D3D12MA_CURRENT_BUDGET_DATA
+/*
+Allocation counters are striped (see D3D12MA_BUDGET_COUNTER_STRIPE_COUNT). Each stripe
+counts additions and removals separately, both only growing, because an allocation may be
+added on one stripe and removed on another. Removals are summed before additions, so
+every removal seen is matched by its addition and the difference never goes below zero.
+
+Block counters change rarely and are read by the budget check of every allocation,
+so they are kept as a single copy.
+
+Values fetched from DXGI form a snapshot guarded by a sequence number, odd while it's
+being written, so GetBudget reads them without taking a lock and retries if a concurrent
+UpdateBudget changed them in the meantime. The mutex only serializes the writers.
+*/
 class CurrentBudgetData
 {
 public:
-    bool ShouldUpdateBudget() const { return m_OperationsSinceBudgetFetch >= 30; }
+    // Approximate: becomes true once any stripe counts enough operations since the last fetch.
+    bool ShouldUpdateBudget() const { return m_BudgetUpdateNeeded != 0; }
 
     void GetStatistics(Statistics& outStats, UINT group) const;
-    void GetBudget(bool useMutex,
+    void GetBudget(
         UINT64* outLocalUsage, UINT64* outLocalBudget,
-        UINT64* outNonLocalUsage, UINT64* outNonLocalBudget);
+        UINT64* outNonLocalUsage, UINT64* outNonLocalBudget) const;
 
 #if D3D12MA_DXGI_1_4
     HRESULT UpdateBudget(IDXGIAdapter3* adapter3, bool useMutex);
@@ -5862,55 +8880,93 @@ public:
     void AddBlock(UINT group, UINT64 blockBytes);
     void RemoveBlock(UINT group, UINT64 blockBytes);
 
+    // Budget fetched from DXGI is recorded there if not null.
+    void SetTrace(TraceRing* trace) { m_Trace = trace; }
+    void SetLockProfile(LockProfile* profile) { BindLockProfile(m_BudgetMutex, profile); }
+
 private:
-    D3D12MA_ATOMIC_UINT32 m_BlockCount[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
-    D3D12MA_ATOMIC_UINT32 m_AllocationCount[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
-    D3D12MA_ATOMIC_UINT64 m_BlockBytes[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
-    D3D12MA_ATOMIC_UINT64 m_AllocationBytes[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+    struct alignas(CACHE_LINE_SIZE) Stripe
+    {
+        D3D12MA_ATOMIC_UINT32 AddedAllocationCount[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+        D3D12MA_ATOMIC_UINT32 RemovedAllocationCount[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+        D3D12MA_ATOMIC_UINT64 AddedAllocationBytes[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+        D3D12MA_ATOMIC_UINT64 RemovedAllocationBytes[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+        D3D12MA_ATOMIC_UINT32 OperationsSinceBudgetFetch = {0};
+    };
+    static const UINT32 BUDGET_UPDATE_OPERATION_COUNT = 30;
 
-    D3D12MA_ATOMIC_UINT32 m_OperationsSinceBudgetFetch = {0};
-    D3D12MA_RW_MUTEX m_BudgetMutex;
-    UINT64 m_D3D12Usage[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
-    UINT64 m_D3D12Budget[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
-    UINT64 m_BlockBytesAtD3D12Fetch[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+    Stripe m_Stripes[D3D12MA_BUDGET_COUNTER_STRIPE_COUNT];
+    alignas(CACHE_LINE_SIZE) D3D12MA_ATOMIC_UINT32 m_BlockCount[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+    D3D12MA_ATOMIC_UINT64 m_BlockBytes[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+    // Written only when a stripe reaches BUDGET_UPDATE_OPERATION_COUNT or on fetch, so readers don't ping-pong it.
+    alignas(CACHE_LINE_SIZE) D3D12MA_ATOMIC_UINT32 m_BudgetUpdateNeeded = {0};
+
+    D3D12MA_MUTEX m_BudgetMutex;
+    D3D12MA_ATOMIC_UINT32 m_SnapshotSequence = {0};
+    D3D12MA_ATOMIC_UINT64 m_D3D12Usage[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+    D3D12MA_ATOMIC_UINT64 m_D3D12Budget[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+    D3D12MA_ATOMIC_UINT64 m_BlockBytesAtD3D12Fetch[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+    TraceRing* m_Trace = NULL;
+
+    Stripe& GetCurrentStripe() { return m_Stripes[GetCurrentThreadIndex() % D3D12MA_BUDGET_COUNTER_STRIPE_COUNT]; }
+    void CountOperation(Stripe& stripe);
+    UINT32 GetAllocationCount(UINT group) const;
+    UINT64 GetAllocationBytes(UINT group) const;
 };
 
 #ifndef _D3D12MA_CURRENT_BUDGET_DATA_FUNCTIONS
 void CurrentBudgetData::GetStatistics(Statistics& outStats, UINT group) const
 {
     outStats.BlockCount = m_BlockCount[group];
-    outStats.AllocationCount = m_AllocationCount[group];
     outStats.BlockBytes = m_BlockBytes[group];
-    outStats.AllocationBytes = m_AllocationBytes[group];
+    outStats.AllocationCount = GetAllocationCount(group);
+    outStats.AllocationBytes = GetAllocationBytes(group);
 }
 
-void CurrentBudgetData::GetBudget(bool useMutex,
+void CurrentBudgetData::GetBudget(
     UINT64* outLocalUsage, UINT64* outLocalBudget,
-    UINT64* outNonLocalUsage, UINT64* outNonLocalBudget)
+    UINT64* outNonLocalUsage, UINT64* outNonLocalBudget) const
 {
-    MutexLockRead lockRead(m_BudgetMutex, useMutex);
+    UINT64 D3D12Usage[DXGI_MEMORY_SEGMENT_GROUP_COUNT];
+    UINT64 D3D12Budget[DXGI_MEMORY_SEGMENT_GROUP_COUNT];
+    UINT64 blockBytesAtD3D12Fetch[DXGI_MEMORY_SEGMENT_GROUP_COUNT];
+    for (;;)
+    {
+        const UINT32 sequence = m_SnapshotSequence;
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (UINT i = 0; i < DXGI_MEMORY_SEGMENT_GROUP_COUNT; ++i)
+        {
+            D3D12Usage[i] = m_D3D12Usage[i];
+            D3D12Budget[i] = m_D3D12Budget[i];
+            blockBytesAtD3D12Fetch[i] = m_BlockBytesAtD3D12Fetch[i];
+        }
+        if (m_SnapshotSequence == sequence)
+            break;
+    }
 
     if (outLocalUsage)
     {
-        const UINT64 D3D12Usage = m_D3D12Usage[DXGI_MEMORY_SEGMENT_GROUP_LOCAL_COPY];
-        const UINT64 blockBytes = m_BlockBytes[DXGI_MEMORY_SEGMENT_GROUP_LOCAL_COPY];
-        const UINT64 blockBytesAtD3D12Fetch = m_BlockBytesAtD3D12Fetch[DXGI_MEMORY_SEGMENT_GROUP_LOCAL_COPY];
-        *outLocalUsage = D3D12Usage + blockBytes > blockBytesAtD3D12Fetch ?
-            D3D12Usage + blockBytes - blockBytesAtD3D12Fetch : 0;
+        const UINT group = DXGI_MEMORY_SEGMENT_GROUP_LOCAL_COPY;
+        const UINT64 blockBytes = m_BlockBytes[group];
+        *outLocalUsage = D3D12Usage[group] + blockBytes > blockBytesAtD3D12Fetch[group] ?
+            D3D12Usage[group] + blockBytes - blockBytesAtD3D12Fetch[group] : 0;
     }
     if (outLocalBudget)
-        *outLocalBudget = m_D3D12Budget[DXGI_MEMORY_SEGMENT_GROUP_LOCAL_COPY];
+        *outLocalBudget = D3D12Budget[DXGI_MEMORY_SEGMENT_GROUP_LOCAL_COPY];
 
     if (outNonLocalUsage)
     {
-        const UINT64 D3D12Usage = m_D3D12Usage[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL_COPY];
-        const UINT64 blockBytes = m_BlockBytes[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL_COPY];
-        const UINT64 blockBytesAtD3D12Fetch = m_BlockBytesAtD3D12Fetch[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL_COPY];
-        *outNonLocalUsage = D3D12Usage + blockBytes > blockBytesAtD3D12Fetch ?
-            D3D12Usage + blockBytes - blockBytesAtD3D12Fetch : 0;
+        const UINT group = DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL_COPY;
+        const UINT64 blockBytes = m_BlockBytes[group];
+        *outNonLocalUsage = D3D12Usage[group] + blockBytes > blockBytesAtD3D12Fetch[group] ?
+            D3D12Usage[group] + blockBytes - blockBytesAtD3D12Fetch[group] : 0;
     }
     if (outNonLocalBudget)
-        *outNonLocalBudget = m_D3D12Budget[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL_COPY];
+        *outNonLocalBudget = D3D12Budget[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL_COPY];
 }
 
 #if D3D12MA_DXGI_1_4
@@ -5932,7 +8988,8 @@ HRESULT CurrentBudgetData::UpdateBudget(IDXGIAdapter3* adapter3, bool useMutex)
     }
 
     {
-        MutexLockWrite lockWrite(m_BudgetMutex, useMutex);
+        MutexLock lock(m_BudgetMutex, useMutex);
+        ++m_SnapshotSequence;
 
         m_D3D12Usage[0] = infoLocal.CurrentUsage;
         m_D3D12Budget[0] = infoLocal.Budget;
@@ -5940,48 +8997,444 @@ HRESULT CurrentBudgetData::UpdateBudget(IDXGIAdapter3* adapter3, bool useMutex)
         m_D3D12Usage[1] = infoNonLocal.CurrentUsage;
         m_D3D12Budget[1] = infoNonLocal.Budget;
 
-        m_BlockBytesAtD3D12Fetch[0] = m_BlockBytes[0];
-        m_BlockBytesAtD3D12Fetch[1] = m_BlockBytes[1];
-        m_OperationsSinceBudgetFetch = 0;
+        m_BlockBytesAtD3D12Fetch[0] = m_BlockBytes[0].load();
+        m_BlockBytesAtD3D12Fetch[1] = m_BlockBytes[1].load();
+        for (UINT i = 0; i < D3D12MA_BUDGET_COUNTER_STRIPE_COUNT; ++i)
+            m_Stripes[i].OperationsSinceBudgetFetch = 0;
+        m_BudgetUpdateNeeded = 0;
+        ++m_SnapshotSequence;
     }
 
+    if (m_Trace != NULL)
+    {
+        m_Trace->RecordBudget(DXGI_MEMORY_SEGMENT_GROUP_LOCAL, infoLocal.CurrentUsage, infoLocal.Budget);
+        m_Trace->RecordBudget(DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, infoNonLocal.CurrentUsage, infoNonLocal.Budget);
+    }
     return S_OK;
 }
 #endif // #if D3D12MA_DXGI_1_4
 
 void CurrentBudgetData::AddAllocation(UINT group, UINT64 allocationBytes)
 {
-    ++m_AllocationCount[group];
-    m_AllocationBytes[group] += allocationBytes;
-    ++m_OperationsSinceBudgetFetch;
+    Stripe& stripe = GetCurrentStripe();
+    ++stripe.AddedAllocationCount[group];
+    stripe.AddedAllocationBytes[group] += allocationBytes;
+    CountOperation(stripe);
+}
+
+void CurrentBudgetData::RemoveAllocation(UINT group, UINT64 allocationBytes)
+{
+    D3D12MA_ASSERT(GetAllocationBytes(group) >= allocationBytes);
+    D3D12MA_ASSERT(GetAllocationCount(group) > 0);
+    Stripe& stripe = GetCurrentStripe();
+    stripe.RemovedAllocationBytes[group] += allocationBytes;
+    ++stripe.RemovedAllocationCount[group];
+    CountOperation(stripe);
+}
+
+void CurrentBudgetData::AddBlock(UINT group, UINT64 blockBytes)
+{
+    ++m_BlockCount[group];
+    m_BlockBytes[group] += blockBytes;
+    CountOperation(GetCurrentStripe());
+}
+
+void CurrentBudgetData::RemoveBlock(UINT group, UINT64 blockBytes)
+{
+    D3D12MA_ASSERT(m_BlockBytes[group] >= blockBytes);
+    D3D12MA_ASSERT(m_BlockCount[group] > 0);
+    m_BlockBytes[group] -= blockBytes;
+    --m_BlockCount[group];
+    CountOperation(GetCurrentStripe());
+}
+
+void CurrentBudgetData::CountOperation(Stripe& stripe)
+{
+    if (++stripe.OperationsSinceBudgetFetch == BUDGET_UPDATE_OPERATION_COUNT)
+        m_BudgetUpdateNeeded = 1;
+}
+
+UINT32 CurrentBudgetData::GetAllocationCount(UINT group) const
+{
+    // Counters may wrap, but the difference is exact.
+    UINT32 result = 0;
+    for (UINT i = 0; i < D3D12MA_BUDGET_COUNTER_STRIPE_COUNT; ++i)
+        result -= m_Stripes[i].RemovedAllocationCount[group];
+    for (UINT i = 0; i < D3D12MA_BUDGET_COUNTER_STRIPE_COUNT; ++i)
+        result += m_Stripes[i].AddedAllocationCount[group];
+    return result;
+}
+
+UINT64 CurrentBudgetData::GetAllocationBytes(UINT group) const
+{
+    UINT64 result = 0;
+    for (UINT i = 0; i < D3D12MA_BUDGET_COUNTER_STRIPE_COUNT; ++i)
+        result -= m_Stripes[i].RemovedAllocationBytes[group];
+    for (UINT i = 0; i < D3D12MA_BUDGET_COUNTER_STRIPE_COUNT; ++i)
+        result += m_Stripes[i].AddedAllocationBytes[group];
+    return result;
+}
+#endif // _D3D12MA_CURRENT_BUDGET_DATA_FUNCTIONS
+#endif // _D3D12MA_CURRENT_BUDGET_DATA
+
+#ifndef _D3D12MA_BUDGET_UPDATE_THREAD
+#if D3D12MA_DXGI_1_4
+/*
+Thread created by an allocator with ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE. It refreshes
+the budget every period, and on Windows also as soon as DXGI signals the budget change
+notification event, until it's stopped by the destructor.
+*/
+class BudgetUpdateThread
+{
+    D3D12MA_CLASS_NO_COPY(BudgetUpdateThread);
+public:
+    BudgetUpdateThread(CurrentBudgetData& budget, IDXGIAdapter3* adapter3, UINT periodMilliseconds);
+    ~BudgetUpdateThread();
+
+    HRESULT Start();
+
+private:
+    CurrentBudgetData& m_Budget;
+    IDXGIAdapter3* const m_Adapter3;
+    const UINT m_PeriodMilliseconds;
+    std::thread m_Thread;
+#ifdef _WIN32
+    HANDLE m_StopEvent = NULL;
+    HANDLE m_BudgetChangedEvent = NULL;
+    DWORD m_BudgetChangedCookie = 0;
+    bool m_BudgetChangedRegistered = false;
+#else
+    std::mutex m_StopMutex;
+    std::condition_variable m_StopCondition;
+    bool m_StopRequested = false;
+#endif
+
+    void Run();
+};
+
+#ifndef _D3D12MA_BUDGET_UPDATE_THREAD_FUNCTIONS
+BudgetUpdateThread::BudgetUpdateThread(CurrentBudgetData& budget, IDXGIAdapter3* adapter3, UINT periodMilliseconds)
+    : m_Budget(budget),
+    m_Adapter3(adapter3),
+    m_PeriodMilliseconds(periodMilliseconds) {}
+
+BudgetUpdateThread::~BudgetUpdateThread()
+{
+#ifdef _WIN32
+    if (m_StopEvent != NULL)
+        SetEvent(m_StopEvent);
+#else
+    {
+        std::lock_guard<std::mutex> lock(m_StopMutex);
+        m_StopRequested = true;
+    }
+    m_StopCondition.notify_one();
+#endif
+    if (m_Thread.joinable())
+        m_Thread.join();
+
+#ifdef _WIN32
+    if (m_BudgetChangedRegistered)
+        m_Adapter3->UnregisterVideoMemoryBudgetChangeNotification(m_BudgetChangedCookie);
+    if (m_BudgetChangedEvent != NULL)
+        CloseHandle(m_BudgetChangedEvent);
+    if (m_StopEvent != NULL)
+        CloseHandle(m_StopEvent);
+#endif
+}
+
+HRESULT BudgetUpdateThread::Start()
+{
+#ifdef _WIN32
+    m_StopEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (m_StopEvent == NULL)
+        return HRESULT_FROM_WIN32(GetLastError());
+    // Without the notification, the budget is still refreshed every period.
+    m_BudgetChangedEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (m_BudgetChangedEvent != NULL)
+    {
+        m_BudgetChangedRegistered = SUCCEEDED(m_Adapter3->RegisterVideoMemoryBudgetChangeNotificationEvent(
+            m_BudgetChangedEvent, &m_BudgetChangedCookie));
+    }
+#endif
+    m_Thread = std::thread(&BudgetUpdateThread::Run, this);
+    return S_OK;
+}
+
+void BudgetUpdateThread::Run()
+{
+    for (;;)
+    {
+#ifdef _WIN32
+        const HANDLE events[] = { m_StopEvent, m_BudgetChangedEvent };
+        const DWORD eventCount = m_BudgetChangedRegistered ? 2 : 1;
+        if (WaitForMultipleObjects(eventCount, events, FALSE, m_PeriodMilliseconds) == WAIT_OBJECT_0)
+            break;
+#else
+        {
+            std::unique_lock<std::mutex> lock(m_StopMutex);
+            if (m_StopCondition.wait_for(lock, std::chrono::milliseconds(m_PeriodMilliseconds),
+                [this]() { return m_StopRequested; }))
+            {
+                break;
+            }
+        }
+#endif
+        m_Budget.UpdateBudget(m_Adapter3, true);
+    }
+}
+#endif // _D3D12MA_BUDGET_UPDATE_THREAD_FUNCTIONS
+#endif // #if D3D12MA_DXGI_1_4
+#endif // _D3D12MA_BUDGET_UPDATE_THREAD
+
+#ifndef _D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE
+/*
+Bounded cache of results of GetResourceAllocationInfo, used with
+ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO. It is a 4-way set associative hash
+table - when all entries of a set are taken, a new one replaces them in round-robin order.
+Lookups take a read lock only.
+*/
+class ResourceAllocationInfoCache
+{
+public:
+    // Descriptions with more castable formats than this are not cached.
+    static constexpr UINT32 MAX_CASTABLE_FORMAT_COUNT = 8;
+
+    struct Key
+    {
+        UINT64 Hash;
+        D3D12_RESOURCE_DESC Desc;
+#ifdef __ID3D12Device8_INTERFACE_DEFINED__
+        bool IsDesc1;
+        D3D12_MIP_REGION SamplerFeedbackMipRegion;
+#endif
+        UINT32 CastableFormatCount;
+        DXGI_FORMAT CastableFormats[MAX_CASTABLE_FORMAT_COUNT];
+    };
+
+    ResourceAllocationInfoCache(const ALLOCATION_CALLBACKS& allocationCallbacks, bool useMutex, UINT capacity);
+    ~ResourceAllocationInfoCache();
+
+    // Returns false if the description cannot be cached.
+    static bool MakeKey(const D3D12_RESOURCE_DESC& resourceDesc,
+        UINT32 castableFormatCount, const DXGI_FORMAT* pCastableFormats, Key& outKey);
+#ifdef __ID3D12Device8_INTERFACE_DEFINED__
+    static bool MakeKey(const D3D12_RESOURCE_DESC1& resourceDesc,
+        UINT32 castableFormatCount, const DXGI_FORMAT* pCastableFormats, Key& outKey);
+#endif
+
+    // outResourceAlignment receives the alignment the description should be used with.
+    bool Find(const Key& key, UINT64& outResourceAlignment, D3D12_RESOURCE_ALLOCATION_INFO& outAllocInfo);
+    void Insert(const Key& key, UINT64 resourceAlignment, const D3D12_RESOURCE_ALLOCATION_INFO& allocInfo);
+    void GetStatistics(ResourceAllocationInfoCacheStatistics& outStats) const;
+    void SetLockProfile(LockProfile* profile) { BindLockProfile(m_Mutex, profile); }
+
+private:
+    static constexpr UINT WAY_COUNT = 4;
+
+    struct Entry
+    {
+        bool Valid;
+        Key EntryKey;
+        UINT64 ResourceAlignment;
+        D3D12_RESOURCE_ALLOCATION_INFO AllocInfo;
+    };
+
+    const ALLOCATION_CALLBACKS& m_AllocationCallbacks;
+    const bool m_UseMutex;
+    UINT m_SetCount;
+    Entry* m_Entries;
+    UINT* m_NextReplacedWay; // Per set.
+    UINT m_EntryCount = 0;
+    mutable D3D12MA_RW_MUTEX m_Mutex;
+    D3D12MA_ATOMIC_UINT64 m_HitCount = {0};
+    D3D12MA_ATOMIC_UINT64 m_MissCount = {0};
+
+    static UINT64 HashCombine(UINT64 hash, UINT64 value) { return (hash ^ value) * 0x100000001B3ull; }
+    static void FinishKey(UINT32 castableFormatCount, const DXGI_FORMAT* pCastableFormats, Key& inoutKey);
+    static bool KeysEqual(const Key& lhs, const Key& rhs);
+
+    Entry* GetSet(UINT64 hash) const { return m_Entries + (hash & (m_SetCount - 1)) * WAY_COUNT; }
+};
+
+#ifndef _D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE_FUNCTIONS
+ResourceAllocationInfoCache::ResourceAllocationInfoCache(const ALLOCATION_CALLBACKS& allocationCallbacks,
+    bool useMutex, UINT capacity)
+    : m_AllocationCallbacks(allocationCallbacks),
+    m_UseMutex(useMutex)
+{
+    m_SetCount = 1u << BitScanMSB(D3D12MA_MAX(capacity / WAY_COUNT, 1u));
+    m_Entries = AllocateArray<Entry>(m_AllocationCallbacks, m_SetCount * WAY_COUNT);
+    ZeroMemory(m_Entries, sizeof(Entry) * m_SetCount * WAY_COUNT);
+    m_NextReplacedWay = AllocateArray<UINT>(m_AllocationCallbacks, m_SetCount);
+    ZeroMemory(m_NextReplacedWay, sizeof(UINT) * m_SetCount);
+}
+
+ResourceAllocationInfoCache::~ResourceAllocationInfoCache()
+{
+    Free(m_AllocationCallbacks, m_NextReplacedWay);
+    Free(m_AllocationCallbacks, m_Entries);
+}
+
+bool ResourceAllocationInfoCache::MakeKey(const D3D12_RESOURCE_DESC& resourceDesc,
+    UINT32 castableFormatCount, const DXGI_FORMAT* pCastableFormats, Key& outKey)
+{
+    if (castableFormatCount > MAX_CASTABLE_FORMAT_COUNT)
+        return false;
+
+    ZeroMemory(&outKey, sizeof(outKey));
+    outKey.Desc = resourceDesc;
+    FinishKey(castableFormatCount, pCastableFormats, outKey);
+    return true;
+}
+
+#ifdef __ID3D12Device8_INTERFACE_DEFINED__
+bool ResourceAllocationInfoCache::MakeKey(const D3D12_RESOURCE_DESC1& resourceDesc,
+    UINT32 castableFormatCount, const DXGI_FORMAT* pCastableFormats, Key& outKey)
+{
+    if (castableFormatCount > MAX_CASTABLE_FORMAT_COUNT)
+        return false;
+
+    ZeroMemory(&outKey, sizeof(outKey));
+    outKey.Desc.Dimension = resourceDesc.Dimension;
+    outKey.Desc.Alignment = resourceDesc.Alignment;
+    outKey.Desc.Width = resourceDesc.Width;
+    outKey.Desc.Height = resourceDesc.Height;
+    outKey.Desc.DepthOrArraySize = resourceDesc.DepthOrArraySize;
+    outKey.Desc.MipLevels = resourceDesc.MipLevels;
+    outKey.Desc.Format = resourceDesc.Format;
+    outKey.Desc.SampleDesc = resourceDesc.SampleDesc;
+    outKey.Desc.Layout = resourceDesc.Layout;
+    outKey.Desc.Flags = resourceDesc.Flags;
+    outKey.IsDesc1 = true;
+    outKey.SamplerFeedbackMipRegion = resourceDesc.SamplerFeedbackMipRegion;
+    FinishKey(castableFormatCount, pCastableFormats, outKey);
+    return true;
+}
+#endif // #ifdef __ID3D12Device8_INTERFACE_DEFINED__
+
+bool ResourceAllocationInfoCache::Find(const Key& key,
+    UINT64& outResourceAlignment, D3D12_RESOURCE_ALLOCATION_INFO& outAllocInfo)
+{
+    {
+        MutexLockRead lock(m_Mutex, m_UseMutex);
+        const Entry* const set = GetSet(key.Hash);
+        for (UINT way = 0; way < WAY_COUNT; ++way)
+        {
+            if (set[way].Valid && KeysEqual(set[way].EntryKey, key))
+            {
+                outResourceAlignment = set[way].ResourceAlignment;
+                outAllocInfo = set[way].AllocInfo;
+                ++m_HitCount;
+                return true;
+            }
+        }
+    }
+    ++m_MissCount;
+    return false;
 }
 
-void CurrentBudgetData::RemoveAllocation(UINT group, UINT64 allocationBytes)
+void ResourceAllocationInfoCache::Insert(const Key& key,
+    UINT64 resourceAlignment, const D3D12_RESOURCE_ALLOCATION_INFO& allocInfo)
 {
-    D3D12MA_ASSERT(m_AllocationBytes[group] >= allocationBytes);
-    D3D12MA_ASSERT(m_AllocationCount[group] > 0);
-    m_AllocationBytes[group] -= allocationBytes;
-    --m_AllocationCount[group];
-    ++m_OperationsSinceBudgetFetch;
-}
+    MutexLockWrite lock(m_Mutex, m_UseMutex);
+    Entry* const set = GetSet(key.Hash);
+    Entry* entry = NULL;
+    for (UINT way = 0; way < WAY_COUNT; ++way)
+    {
+        // Another thread may have inserted the same key in the meantime.
+        if (set[way].Valid && KeysEqual(set[way].EntryKey, key))
+            return;
+        if (!set[way].Valid && entry == NULL)
+            entry = &set[way];
+    }
+    if (entry == NULL)
+    {
+        UINT& nextReplacedWay = m_NextReplacedWay[(set - m_Entries) / WAY_COUNT];
+        entry = &set[nextReplacedWay];
+        nextReplacedWay = (nextReplacedWay + 1) % WAY_COUNT;
+    }
+    else
+        ++m_EntryCount;
 
-void CurrentBudgetData::AddBlock(UINT group, UINT64 blockBytes)
-{
-    ++m_BlockCount[group];
-    m_BlockBytes[group] += blockBytes;
-    ++m_OperationsSinceBudgetFetch;
+    entry->Valid = true;
+    entry->EntryKey = key;
+    entry->ResourceAlignment = resourceAlignment;
+    entry->AllocInfo = allocInfo;
 }
 
-void CurrentBudgetData::RemoveBlock(UINT group, UINT64 blockBytes)
+void ResourceAllocationInfoCache::GetStatistics(ResourceAllocationInfoCacheStatistics& outStats) const
 {
-    D3D12MA_ASSERT(m_BlockBytes[group] >= blockBytes);
-    D3D12MA_ASSERT(m_BlockCount[group] > 0);
-    m_BlockBytes[group] -= blockBytes;
-    --m_BlockCount[group];
-    ++m_OperationsSinceBudgetFetch;
+    outStats.HitCount = m_HitCount;
+    outStats.MissCount = m_MissCount;
+    MutexLockRead lock(m_Mutex, m_UseMutex);
+    outStats.EntryCount = m_EntryCount;
+}
+
+void ResourceAllocationInfoCache::FinishKey(UINT32 castableFormatCount, const DXGI_FORMAT* pCastableFormats, Key& inoutKey)
+{
+    inoutKey.CastableFormatCount = castableFormatCount;
+    for (UINT32 i = 0; i < castableFormatCount; ++i)
+        inoutKey.CastableFormats[i] = pCastableFormats[i];
+
+    const D3D12_RESOURCE_DESC& desc = inoutKey.Desc;
+    UINT64 hash = 0xCBF29CE484222325ull; // FNV-1a offset basis.
+    hash = HashCombine(hash, desc.Dimension);
+    hash = HashCombine(hash, desc.Alignment);
+    hash = HashCombine(hash, desc.Width);
+    hash = HashCombine(hash, desc.Height);
+    hash = HashCombine(hash, ((UINT64)desc.DepthOrArraySize << 16) | desc.MipLevels);
+    hash = HashCombine(hash, desc.Format);
+    hash = HashCombine(hash, ((UINT64)desc.SampleDesc.Count << 32) | desc.SampleDesc.Quality);
+    hash = HashCombine(hash, desc.Layout);
+    hash = HashCombine(hash, desc.Flags);
+#ifdef __ID3D12Device8_INTERFACE_DEFINED__
+    hash = HashCombine(hash, inoutKey.IsDesc1);
+    hash = HashCombine(hash, ((UINT64)inoutKey.SamplerFeedbackMipRegion.Width << 32) | inoutKey.SamplerFeedbackMipRegion.Height);
+    hash = HashCombine(hash, inoutKey.SamplerFeedbackMipRegion.Depth);
+#endif
+    for (UINT32 i = 0; i < castableFormatCount; ++i)
+        hash = HashCombine(hash, pCastableFormats[i]);
+    // Mix high bits into the low ones, which select the set.
+    inoutKey.Hash = hash ^ (hash >> 32);
+}
+
+bool ResourceAllocationInfoCache::KeysEqual(const Key& lhs, const Key& rhs)
+{
+    if (lhs.Hash != rhs.Hash
+        || lhs.Desc.Dimension != rhs.Desc.Dimension
+        || lhs.Desc.Alignment != rhs.Desc.Alignment
+        || lhs.Desc.Width != rhs.Desc.Width
+        || lhs.Desc.Height != rhs.Desc.Height
+        || lhs.Desc.DepthOrArraySize != rhs.Desc.DepthOrArraySize
+        || lhs.Desc.MipLevels != rhs.Desc.MipLevels
+        || lhs.Desc.Format != rhs.Desc.Format
+        || lhs.Desc.SampleDesc.Count != rhs.Desc.SampleDesc.Count
+        || lhs.Desc.SampleDesc.Quality != rhs.Desc.SampleDesc.Quality
+        || lhs.Desc.Layout != rhs.Desc.Layout
+        || lhs.Desc.Flags != rhs.Desc.Flags
+        || lhs.CastableFormatCount != rhs.CastableFormatCount)
+    {
+        return false;
+    }
+#ifdef __ID3D12Device8_INTERFACE_DEFINED__
+    if (lhs.IsDesc1 != rhs.IsDesc1
+        || lhs.SamplerFeedbackMipRegion.Width != rhs.SamplerFeedbackMipRegion.Width
+        || lhs.SamplerFeedbackMipRegion.Height != rhs.SamplerFeedbackMipRegion.Height
+        || lhs.SamplerFeedbackMipRegion.Depth != rhs.SamplerFeedbackMipRegion.Depth)
+    {
+        return false;
+    }
+#endif
+    for (UINT32 i = 0; i < lhs.CastableFormatCount; ++i)
+    {
+        if (lhs.CastableFormats[i] != rhs.CastableFormats[i])
+            return false;
+    }
+    return true;
 }
-#endif // _D3D12MA_CURRENT_BUDGET_DATA_FUNCTIONS
-#endif // _D3D12MA_CURRENT_BUDGET_DATA
+#endif // _D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE_FUNCTIONS
+#endif // _D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE
 
 #ifndef _D3D12MA_DEFRAGMENTATION_CONTEXT_PIMPL
 class DefragmentationContextPimpl
@@ -6039,6 +9492,11 @@ private:
     void* m_AlgorithmState = NULL;
 
     static MoveAllocationData GetMoveData(AllocHandle handle, BlockMetadata* metadata);
+    // False for allocations created by this context and shared buffers of Allocator::CreateBufferSubAllocation.
+    bool IsMovable(const Allocation& allocation) const
+    {
+        return allocation.GetPrivateData() != this && !allocation.m_PackedData.IsImmovable();
+    }
     CounterStatus CheckCounters(UINT64 bytes);
     bool IncrementCounters(UINT64 bytes);
     bool ReallocWithinBlock(BlockVector& vector, NormalBlock* block);
@@ -6099,6 +9557,103 @@ struct PoolListItemTraits
 };
 #endif // _D3D12MA_POOL_PIMPL
 
+#ifndef _D3D12MA_BUFFER_SUBALLOCATOR
+class BufferSubAllocator;
+
+/*
+Buffer created in a default pool and shared by allocations of one size class of
+BufferSubAllocator. Its ranges are tracked by BlockMetadata_Slab with one slot per allocation,
+or BlockMetadata_TLSF for the general size class.
+*/
+class SharedBuffer
+{
+public:
+    BufferSubAllocator* const m_Owner;
+    const UINT m_SizeClass;
+    // Owned object, marked as immovable for defragmentation.
+    Allocation* const m_Allocation;
+    // Owned object.
+    BlockMetadata* const m_Metadata;
+    SharedBuffer* m_PrevAvailable = NULL;
+    SharedBuffer* m_NextAvailable = NULL;
+
+    SharedBuffer(BufferSubAllocator* owner, UINT sizeClass, Allocation* allocation, BlockMetadata* metadata);
+
+    D3D12MA_CLASS_NO_COPY(SharedBuffer)
+};
+
+struct SharedBufferAvailableListItemTraits
+{
+    using ItemType = SharedBuffer;
+    static ItemType* GetPrev(const ItemType* item) { return item->m_PrevAvailable; }
+    static ItemType* GetNext(const ItemType* item) { return item->m_NextAvailable; }
+    static ItemType*& AccessPrev(ItemType* item) { return item->m_PrevAvailable; }
+    static ItemType*& AccessNext(ItemType* item) { return item->m_NextAvailable; }
+};
+
+/*
+Allocates ranges of buffers shared by many allocations, for Allocator::CreateBufferSubAllocation.
+There is one object for each standard heap type. A range not larger than the largest slot size, together
+with its alignment, takes a slot of the smallest size class that fits. Larger ones go to the general
+size class, with buffers of at least GENERAL_BUFFER_SIZE managed by the TLSF algorithm.
+Each size class has its own lock and list of buffers with free space, and keeps at most one empty buffer.
+Thread-safe, synchronized internally.
+*/
+class BufferSubAllocator
+{
+public:
+    static constexpr UINT SIZE_CLASS_COUNT = 3;
+    static constexpr UINT GENERAL_SIZE_CLASS = SIZE_CLASS_COUNT;
+    static constexpr UINT64 GENERAL_BUFFER_SIZE = 8ull * 1024 * 1024;
+
+    // 256 B, 4 KB, 64 KB.
+    static UINT64 GetSlotSize(UINT sizeClass) { return 256ull << (sizeClass * 4); }
+    static UINT64 GetMaxSlotSize() { return GetSlotSize(SIZE_CLASS_COUNT - 1); }
+    // Shared buffers have at least 64 slots and at least the size of the placement alignment of buffers.
+    static UINT64 GetBufferSize(UINT sizeClass)
+    {
+        return D3D12MA_MAX(GetSlotSize(sizeClass) * 64, (UINT64)D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+    }
+
+    BufferSubAllocator(AllocatorPimpl* allocator, D3D12_HEAP_TYPE heapType);
+    ~BufferSubAllocator();
+
+    D3D12_HEAP_TYPE GetHeapType() const { return m_HeapType; }
+    void SetLockProfile(LockProfile* profile);
+
+    HRESULT Allocate(UINT64 size, UINT64 alignment, ALLOCATION_FLAGS flags, void* pPrivateData, Allocation** ppAllocation);
+    void Free(Allocation* allocation);
+
+private:
+    using SharedBufferList = IntrusiveLinkedList<SharedBufferAvailableListItemTraits>;
+
+    struct SizeClass
+    {
+        D3D12MA_MUTEX AccessMutex;
+        // Buffers with some free space.
+        SharedBufferList AvailableBuffers;
+        size_t BufferCount = 0;
+        size_t EmptyBufferCount = 0;
+    };
+
+    AllocatorPimpl* const m_Allocator;
+    const D3D12_HEAP_TYPE m_HeapType;
+    SizeClass m_SizeClasses[SIZE_CLASS_COUNT + 1];
+
+    // Finds a buffer with enough free space and fills outRequest. Returns null if there is none.
+    // To be called under the lock of the size class.
+    SharedBuffer* FindSharedBuffer(UINT sizeClass, UINT64 size, UINT64 alignment, AllocationRequest& outRequest);
+    // Makes the allocation described by request in the buffer. To be called under the lock of the size class.
+    Allocation* AllocateFromBuffer(SharedBuffer* buffer, const AllocationRequest& request,
+        UINT64 size, UINT64 alignment, void* pPrivateData);
+    // Creates a buffer not yet inserted into its size class, so it doesn't need its lock.
+    HRESULT CreateSharedBuffer(UINT sizeClass, UINT64 bufferSize, ALLOCATION_FLAGS flags, SharedBuffer*& outBuffer);
+    void DestroySharedBuffer(SharedBuffer* buffer);
+
+    D3D12MA_CLASS_NO_COPY(BufferSubAllocator)
+};
+#endif // _D3D12MA_BUFFER_SUBALLOCATOR
+
 
 #ifndef _D3D12MA_ALLOCATOR_PIMPL
 class AllocatorPimpl
@@ -6139,8 +9694,28 @@ public:
     bool IsTightAlignmentSupported() const { return m_TightAlignmentSupported != FALSE; }
     bool IsTightAlignmentEnabled() const { return IsTightAlignmentSupported() && m_UseTightAlignment; }
     bool UseMutex() const { return m_UseMutex; }
+    bool UseLockFreeStatistics() const { return m_UseLockFreeStatistics; }
     AllocationObjectAllocator& GetAllocationObjectAllocator() { return m_AllocationObjectAllocator; }
     UINT GetCurrentFrameIndex() const { return m_CurrentFrameIndex.load(); }
+    // Number of snapshots created so far, stored in every new Allocation to tell apart objects reusing the same address.
+    UINT GetSnapshotEpoch() const { return m_SnapshotEpoch.load(std::memory_order_relaxed); }
+    UINT GenerateBlockVectorId() { return m_NextBlockVectorId++; }
+    // Null unless ALLOCATOR_FLAG_TRACE_EVENTS is used.
+    TraceRing* GetTrace() const { return m_Trace; }
+    // Null unless ALLOCATOR_FLAG_PERFORMANCE_COUNTERS is used.
+    PerformanceCounterSet* GetPerformanceCounterSet() const { return m_PerformanceCounters; }
+    // Null unless D3D12MA_PROFILE_LOCKS is enabled.
+#if D3D12MA_PROFILE_LOCKS
+    LockProfile* GetLockProfile(LockName name) { return &m_LockProfiles[name]; }
+#else
+    LockProfile* GetLockProfile(LockName) { return NULL; }
+#endif
+    static D3D12_HEAP_TYPE GetAllocationHeapType(const Allocation& allocation);
+    void RecordPlacementDecision(PLACEMENT_DECISION decision, D3D12_HEAP_TYPE heapType)
+    {
+        if (m_PerformanceCounters != NULL)
+            m_PerformanceCounters->RecordPlacementDecision(decision, heapType);
+    }
     /*
     If SupportsResourceHeapTier2():
         0: D3D12_HEAP_TYPE_DEFAULT
@@ -6170,9 +9745,11 @@ public:
     UINT HeapPropertiesToMemorySegmentGroup(const D3D12_HEAP_PROPERTIES& heapProps) const;
     UINT64 GetMemoryCapacity(UINT memorySegmentGroup) const;
 
+    // heapType is only used by performance counters.
     HRESULT CreatePlacedResourceWrap(
         ID3D12Heap *pHeap,
         UINT64 HeapOffset,
+        D3D12_HEAP_TYPE heapType,
         const CREATE_RESOURCE_PARAMS& createParams,
         REFIID riidResource,
         void** ppvResource);
@@ -6196,6 +9773,28 @@ public:
         const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfo,
         Allocation** ppAllocation);
 
+    HRESULT AllocateMemoryBatch(
+        UINT allocationCount,
+        const ALLOCATION_DESC* pAllocDescs,
+        const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfos,
+        Allocation** ppAllocations);
+
+    HRESULT CreateResourceBatch(
+        UINT resourceCount,
+        const ALLOCATION_DESC* pAllocDescs,
+        const D3D12_RESOURCE_DESC* pResourceDescs,
+        const D3D12_RESOURCE_STATES* pInitialResourceStates,
+        const D3D12_CLEAR_VALUE* const* ppOptimizedClearValues,
+        Allocation** ppAllocations);
+
+    void FreeAllocations(UINT allocationCount, Allocation* const* ppAllocations);
+
+    HRESULT CreateBufferSubAllocation(
+        const ALLOCATION_DESC* pAllocDesc,
+        UINT64 size,
+        UINT64 alignment,
+        Allocation** ppAllocation);
+
     // Unregisters allocation from the collection of dedicated allocations.
     // Allocation object must be deleted externally afterwards.
     void FreeCommittedMemory(Allocation* allocation);
@@ -6205,27 +9804,47 @@ public:
     // Unregisters allocation from the collection of dedicated allocations and destroys associated heap.
     // Allocation object must be deleted externally afterwards.
     void FreeHeapMemory(Allocation* allocation);
+    // Returns the range of a shared buffer to its BufferSubAllocator.
+    // Allocation object must be deleted externally afterwards.
+    void FreeBufferRange(Allocation* allocation);
 
     void SetResidencyPriority(ID3D12Pageable* obj, D3D12_RESIDENCY_PRIORITY priority) const;
 
     void SetCurrentFrameIndex(UINT frameIndex);
+    void ReleaseDeferred(Allocation* allocation, UINT frameIndex);
+    void ReleaseAllDeferred();
     // For more deailed stats use outCustomHeaps to access statistics divided into L0 and L1 group
     void CalculateStatistics(TotalStatistics& outStats, DetailedStatistics outCustomHeaps[2] = NULL);
 
     void GetBudget(Budget* outLocalBudget, Budget* outNonLocalBudget);
+    HRESULT UpdateBudget();
+    void GetResourceAllocationInfoCacheStatistics(ResourceAllocationInfoCacheStatistics& outStats) const;
+    void GetPerformanceCounters(PerformanceCounters& outCounters) const;
     void GetBudgetForHeapType(Budget& outBudget, D3D12_HEAP_TYPE heapType);
 
     void BuildStatsString(WCHAR** ppStatsString, BOOL detailedMap);
     void FreeStatsString(WCHAR* pStatsString);
+    void WriteStatsString(WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData,
+        STATS_STRING_ENCODING encoding, BOOL detailedMap);
+    void WriteStatsBinary(WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData, BOOL detailedMap);
+    void AddToSnapshot(SnapshotPimpl& snapshot);
+    UINT GetTraceEvents(UINT64& inoutNextSequenceNumber, TRACE_EVENT* pEvents, UINT maxEventCount) const;
+    void WriteTraceEvents(UINT64& inoutNextSequenceNumber, WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData) const;
 
 private:
     using PoolList = IntrusiveLinkedList<PoolListItemTraits>;
 
+#if D3D12MA_PROFILE_LOCKS
+    // Declared first to outlive all the locks bound to it.
+    LockProfile m_LockProfiles[LOCK_NAME_COUNT];
+#endif
     const bool m_UseMutex;
     const bool m_AlwaysCommitted;
     const bool m_MsaaAlwaysCommitted;
     const bool m_PreferSmallBuffersCommitted;
     const bool m_UseTightAlignment;
+    const bool m_ManualBudgetUpdate;
+    const bool m_UseLockFreeStatistics;
     bool m_DefaultPoolsNotZeroed = false;
     ID3D12Device* m_Device; // AddRef
 #ifdef __ID3D12Device1_INTERFACE_DEFINED__
@@ -6250,6 +9869,9 @@ private:
     UINT64 m_PreferredBlockSize;
     ALLOCATION_CALLBACKS m_AllocationCallbacks;
     D3D12MA_ATOMIC_UINT32 m_CurrentFrameIndex;
+    D3D12MA_ATOMIC_UINT32 m_SnapshotEpoch = {0};
+    // 0 is used by SNAPSHOT_CHANGE::PoolId for committed allocations of default pools.
+    D3D12MA_ATOMIC_UINT32 m_NextBlockVectorId = {1};
     DXGI_ADAPTER_DESC m_AdapterDesc;
     D3D12_FEATURE_DATA_D3D12_OPTIONS m_D3D12Options;
     BOOL m_GPUUploadHeapSupported = FALSE;
@@ -6258,11 +9880,32 @@ private:
     D3D12_FEATURE_DATA_ARCHITECTURE m_D3D12Architecture;
     AllocationObjectAllocator m_AllocationObjectAllocator;
 
+    // Allocations passed to ReleaseDeferred, waiting for the frame index to pass their FrameIndex.
+    struct DeferredRelease
+    {
+        Allocation* pAllocation;
+        UINT FrameIndex;
+    };
+    D3D12MA_MUTEX m_DeferredReleasesMutex;
+    Vector<DeferredRelease> m_DeferredReleases;
+    // Owned object, NULL unless ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO is used.
+    ResourceAllocationInfoCache* m_ResourceAllocationInfoCache = NULL;
+    // Owned object, NULL unless ALLOCATOR_FLAG_TRACE_EVENTS is used.
+    TraceRing* m_Trace = NULL;
+    // Owned object, NULL unless ALLOCATOR_FLAG_PERFORMANCE_COUNTERS is used.
+    PerformanceCounterSet* m_PerformanceCounters = NULL;
+#if D3D12MA_DXGI_1_4
+    // Owned object, NULL unless ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE is used.
+    BudgetUpdateThread* m_BudgetUpdateThread = NULL;
+#endif
+
     D3D12MA_RW_MUTEX m_PoolsMutex[HEAP_TYPE_COUNT];
     PoolList m_Pools[HEAP_TYPE_COUNT];
     // Default pools.
     BlockVector* m_BlockVectors[DEFAULT_POOL_MAX_COUNT];
     CommittedAllocationList m_CommittedAllocations[STANDARD_HEAP_TYPE_COUNT];
+    // Owned objects, for CreateBufferSubAllocation.
+    BufferSubAllocator* m_BufferSubAllocators[STANDARD_HEAP_TYPE_COUNT];
 
     /*
     Heuristics that decides whether a resource should better be placed in its own,
@@ -6287,6 +9930,23 @@ private:
         const D3D12_RESOURCE_ALLOCATION_INFO& allocInfo, bool withinBudget,
         void* pPrivateData, Allocation** ppAllocation);
 
+    /*
+    Common implementation of AllocateMemoryBatch and CreateResourceBatch.
+    pResourceDescs are the descriptions passed by the user, used to choose where to allocate,
+    and pFinalResourceDescs the ones adjusted by GetResourceAllocationInfo, used to create the resources.
+    They, pInitialResourceStates and ppOptimizedClearValues are null when
+    only memory is allocated. Either all allocations succeed or none is returned.
+    */
+    HRESULT AllocateBatch(
+        UINT count,
+        const ALLOCATION_DESC* pAllocDescs,
+        const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfos,
+        const D3D12_RESOURCE_DESC* pResourceDescs,
+        const D3D12_RESOURCE_DESC* pFinalResourceDescs,
+        const D3D12_RESOURCE_STATES* pInitialResourceStates,
+        const D3D12_CLEAR_VALUE* const* ppOptimizedClearValues,
+        Allocation** ppAllocations);
+
     template<typename D3D12_RESOURCE_DESC_T>
     HRESULT CalcAllocationParams(const ALLOCATION_DESC& allocDesc, UINT64 allocSize,
         const D3D12_RESOURCE_DESC_T* resDesc, // Optional
@@ -6303,6 +9963,9 @@ private:
     void UnregisterPool(Pool* pool, D3D12_HEAP_TYPE heapType);
 
     HRESULT UpdateD3D12Budget();
+
+    // Writes the JSON document of BuildStatsString and WriteStatsString.
+    void WriteStatsJson(StringBuilder& sb, BOOL detailedMap);
     
     D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfoNative(const D3D12_RESOURCE_DESC& resourceDesc) const;
     HRESULT GetResourceAllocationInfoMiddle(D3D12_RESOURCE_DESC& inOutResourceDesc,
@@ -6326,6 +9989,11 @@ private:
         UINT32 NumCastableFormats, const DXGI_FORMAT* pCastableFormats,
         D3D12_RESOURCE_ALLOCATION_INFO& outAllocInfo,
         bool useTightAlignment) const;
+    // Part of GetResourceAllocationInfo that queries the driver, possibly trying small alignment first.
+    template<typename D3D12_RESOURCE_DESC_T>
+    HRESULT GetResourceAllocationInfoUncached(D3D12_RESOURCE_DESC_T& inOutResourceDesc,
+        UINT32 NumCastableFormats, const DXGI_FORMAT* pCastableFormats,
+        D3D12_RESOURCE_ALLOCATION_INFO& outAllocInfo) const;
 
     bool IsTightAlignmentEnabled(const ALLOCATION_DESC& allocDesc) const;
 
@@ -6333,6 +10001,10 @@ private:
 
     // Writes object { } with data of given budget.
     static void WriteBudgetToJson(JsonWriter& json, const Budget& budget);
+    static void WritePerformanceCountersToJson(JsonWriter& json, const PerformanceCounters& counters);
+#if D3D12MA_PROFILE_LOCKS
+    void WriteLockProfilesToJson(JsonWriter& json) const;
+#endif
 };
 
 #ifndef _D3D12MA_ALLOCATOR_PIMPL_FUNCTINOS
@@ -6342,15 +10014,37 @@ AllocatorPimpl::AllocatorPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks,
     m_MsaaAlwaysCommitted((desc.Flags & ALLOCATOR_FLAG_MSAA_TEXTURES_ALWAYS_COMMITTED) != 0),
     m_PreferSmallBuffersCommitted((desc.Flags& ALLOCATOR_FLAG_DONT_PREFER_SMALL_BUFFERS_COMMITTED) == 0),
     m_UseTightAlignment((desc.Flags & ALLOCATOR_FLAG_DONT_USE_TIGHT_ALIGNMENT) == 0),
+    m_ManualBudgetUpdate((desc.Flags & (ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE | ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE)) != 0),
+    m_UseLockFreeStatistics((desc.Flags & ALLOCATOR_FLAG_LOCK_FREE_STATISTICS) != 0),
     m_Device(desc.pDevice),
     m_Adapter(desc.pAdapter),
     m_PreferredBlockSize(desc.PreferredBlockSize != 0 ? desc.PreferredBlockSize : D3D12MA_DEFAULT_BLOCK_SIZE),
     m_AllocationCallbacks(allocationCallbacks),
     m_CurrentFrameIndex(0),
     // Below this line don't use allocationCallbacks but m_AllocationCallbacks!!!
-    m_AllocationObjectAllocator(m_AllocationCallbacks, m_UseMutex)
+    m_AllocationObjectAllocator(m_AllocationCallbacks, m_UseMutex),
+    m_DeferredReleases(m_AllocationCallbacks)
 {
     // desc.pAllocationCallbacks intentionally ignored here, preprocessed by CreateAllocator.
+    for (UINT i = 0; i < HEAP_TYPE_COUNT; ++i)
+        BindLockProfile(m_PoolsMutex[i], GetLockProfile(LOCK_NAME_POOLS));
+    BindLockProfile(m_DeferredReleasesMutex, GetLockProfile(LOCK_NAME_DEFERRED_RELEASES));
+    m_AllocationObjectAllocator.SetLockProfile(GetLockProfile(LOCK_NAME_ALLOCATION_OBJECT_ALLOCATOR));
+    m_Budget.SetLockProfile(GetLockProfile(LOCK_NAME_BUDGET));
+    if (desc.Flags & ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO)
+    {
+        m_ResourceAllocationInfoCache = D3D12MA_NEW(m_AllocationCallbacks, ResourceAllocationInfoCache)(
+            m_AllocationCallbacks, m_UseMutex, D3D12MA_RESOURCE_ALLOCATION_INFO_CACHE_CAPACITY);
+        m_ResourceAllocationInfoCache->SetLockProfile(GetLockProfile(LOCK_NAME_RESOURCE_ALLOCATION_INFO_CACHE));
+    }
+    if (desc.Flags & ALLOCATOR_FLAG_TRACE_EVENTS)
+    {
+        m_Trace = D3D12MA_NEW(m_AllocationCallbacks, TraceRing)(m_AllocationCallbacks,
+            desc.TraceEventCapacity != 0 ? desc.TraceEventCapacity : D3D12MA_DEFAULT_TRACE_EVENT_CAPACITY);
+        m_Budget.SetTrace(m_Trace);
+    }
+    if (desc.Flags & ALLOCATOR_FLAG_PERFORMANCE_COUNTERS)
+        m_PerformanceCounters = D3D12MA_NEW(m_AllocationCallbacks, PerformanceCounterSet)();
     ZeroMemory(&m_D3D12Options, sizeof(m_D3D12Options));
     ZeroMemory(&m_D3D12Architecture, sizeof(m_D3D12Architecture));
 
@@ -6360,8 +10054,13 @@ AllocatorPimpl::AllocatorPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks,
     {
         m_CommittedAllocations[i].Init(
             m_UseMutex,
+            m_UseLockFreeStatistics,
             IndexToStandardHeapType(i),
             NULL); // pool
+        m_CommittedAllocations[i].SetLockProfile(GetLockProfile(LOCK_NAME_COMMITTED_ALLOCATION_LIST));
+
+        m_BufferSubAllocators[i] = D3D12MA_NEW(m_AllocationCallbacks, BufferSubAllocator)(this, IndexToStandardHeapType(i));
+        m_BufferSubAllocators[i]->SetLockProfile(GetLockProfile(LOCK_NAME_BUFFER_SUBALLOCATOR));
     }
 
     m_Device->AddRef();
@@ -6484,6 +10183,7 @@ HRESULT AllocatorPimpl::Init(const ALLOCATOR_DESC& desc)
             false, // explicitBlockSize
             (UINT64)D3D12MA_DEFAULT_ALIGNMENT, // minAllocationAlignment
             0, // Default algorithm,
+            0, // slotSize
             m_MsaaAlwaysCommitted,
             NULL, // pProtectedSession
             D3D12_RESIDENCY_PRIORITY_NONE); // residencyPriority
@@ -6492,6 +10192,16 @@ HRESULT AllocatorPimpl::Init(const ALLOCATOR_DESC& desc)
 
 #if D3D12MA_DXGI_1_4
     UpdateD3D12Budget();
+
+    if ((desc.Flags & ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE) && m_Adapter3)
+    {
+        const UINT periodMilliseconds = desc.BudgetUpdatePeriodMilliseconds != 0 ?
+            desc.BudgetUpdatePeriodMilliseconds : D3D12MA_DEFAULT_BUDGET_UPDATE_PERIOD_MILLISECONDS;
+        m_BudgetUpdateThread = D3D12MA_NEW(GetAllocs(), BudgetUpdateThread)(m_Budget, m_Adapter3, periodMilliseconds);
+        const HRESULT hr = m_BudgetUpdateThread->Start();
+        if (FAILED(hr))
+            return hr;
+    }
 #endif
 
     return S_OK;
@@ -6499,6 +10209,15 @@ HRESULT AllocatorPimpl::Init(const ALLOCATOR_DESC& desc)
 
 AllocatorPimpl::~AllocatorPimpl()
 {
+#if D3D12MA_DXGI_1_4
+    // Stopped first, as it uses m_Adapter3.
+    D3D12MA_DELETE(GetAllocs(), m_BudgetUpdateThread);
+#endif
+    ReleaseAllDeferred();
+    // Shared buffers are allocations of the default pools.
+    for (UINT i = STANDARD_HEAP_TYPE_COUNT; i--; )
+        D3D12MA_DELETE(GetAllocs(), m_BufferSubAllocators[i]);
+
 #ifdef __ID3D12Device12_INTERFACE_DEFINED__
     SAFE_RELEASE(m_Device12);
 #endif
@@ -6524,6 +10243,10 @@ AllocatorPimpl::~AllocatorPimpl()
     {
         D3D12MA_DELETE(GetAllocs(), m_BlockVectors[i]);
     }
+    D3D12MA_DELETE(GetAllocs(), m_ResourceAllocationInfoCache);
+    // After everything that could record an event.
+    D3D12MA_DELETE(GetAllocs(), m_Trace);
+    D3D12MA_DELETE(GetAllocs(), m_PerformanceCounters);
 
     for (UINT i = HEAP_TYPE_COUNT; i--; )
     {
@@ -6587,10 +10310,13 @@ UINT64 AllocatorPimpl::GetMemoryCapacity(UINT memorySegmentGroup) const
 HRESULT AllocatorPimpl::CreatePlacedResourceWrap(
     ID3D12Heap *pHeap,
     UINT64 HeapOffset,
+    D3D12_HEAP_TYPE heapType,
     const CREATE_RESOURCE_PARAMS& createParams,
     REFIID riidResource,
     void** ppvResource)
 {
+    PerformanceTimer timer(m_PerformanceCounters, PERFORMANCE_COUNTER_OPERATION_CREATE_PLACED_RESOURCE, heapType);
+
 #ifdef __ID3D12Device10_INTERFACE_DEFINED__
     if (createParams.Variant == CREATE_RESOURCE_PARAMS::VARIANT_WITH_LAYOUT)
     {
@@ -6645,6 +10371,9 @@ HRESULT AllocatorPimpl::CreateResource(
     {
         *ppvResource = NULL;
     }
+    const D3D12_HEAP_TYPE heapType = pAllocDesc->CustomPool != NULL ?
+        pAllocDesc->CustomPool->m_Pimpl->GetDesc().HeapProperties.Type : pAllocDesc->HeapType;
+    PerformanceTimer timer(m_PerformanceCounters, PERFORMANCE_COUNTER_OPERATION_CREATE_RESOURCE, heapType);
 
     HRESULT hr = E_NOINTERFACE;
     const bool useTightAlignment = IsTightAlignmentEnabled(*pAllocDesc);
@@ -6726,7 +10455,11 @@ HRESULT AllocatorPimpl::CreateResource(
             resAllocInfo.SizeInBytes, withinBudget, pAllocDesc->pPrivateData,
             finalCreateParams, ppAllocation, riidResource, ppvResource);
         if (SUCCEEDED(hr))
+        {
+            RecordPlacementDecision(blockVector != NULL ?
+                PLACEMENT_DECISION_COMMITTED_PREFERRED : PLACEMENT_DECISION_COMMITTED_REQUIRED, heapType);
             return hr;
+        }
     }
     if (blockVector != NULL)
     {
@@ -6734,7 +10467,10 @@ HRESULT AllocatorPimpl::CreateResource(
             *pAllocDesc, finalCreateParams, committedAllocationParams.IsValid(),
             ppAllocation, riidResource, ppvResource);
         if (SUCCEEDED(hr))
+        {
+            RecordPlacementDecision(PLACEMENT_DECISION_PLACED, heapType);
             return hr;
+        }
     }
     if (committedAllocationParams.IsValid() && !preferCommitted)
     {
@@ -6742,7 +10478,11 @@ HRESULT AllocatorPimpl::CreateResource(
             resAllocInfo.SizeInBytes, withinBudget, pAllocDesc->pPrivateData,
             finalCreateParams, ppAllocation, riidResource, ppvResource);
         if (SUCCEEDED(hr))
+        {
+            RecordPlacementDecision(blockVector != NULL ?
+                PLACEMENT_DECISION_COMMITTED_FALLBACK : PLACEMENT_DECISION_COMMITTED_REQUIRED, heapType);
             return hr;
+        }
     }
     return hr;
 }
@@ -6753,6 +10493,9 @@ HRESULT AllocatorPimpl::AllocateMemory(
     Allocation** ppAllocation)
 {
     *ppAllocation = NULL;
+    const D3D12_HEAP_TYPE heapType = pAllocDesc->CustomPool != NULL ?
+        pAllocDesc->CustomPool->m_Pimpl->GetDesc().HeapProperties.Type : pAllocDesc->HeapType;
+    PerformanceTimer timer(m_PerformanceCounters, PERFORMANCE_COUNTER_OPERATION_ALLOCATE_MEMORY, heapType);
 
     BlockVector* blockVector = NULL;
     CommittedAllocationParameters committedAllocationParams = {};
@@ -6770,24 +10513,262 @@ HRESULT AllocatorPimpl::AllocateMemory(
     {
         hr = AllocateHeap(committedAllocationParams, *pAllocInfo, withinBudget, pAllocDesc->pPrivateData, ppAllocation);
         if (SUCCEEDED(hr))
+        {
+            RecordPlacementDecision(blockVector != NULL ?
+                PLACEMENT_DECISION_COMMITTED_PREFERRED : PLACEMENT_DECISION_COMMITTED_REQUIRED, heapType);
             return hr;
+        }
     }
     if (blockVector != NULL)
     {
         hr = blockVector->Allocate(pAllocInfo->SizeInBytes, pAllocInfo->Alignment,
             *pAllocDesc, committedAllocationParams.IsValid(), 1, (Allocation**)ppAllocation);
         if (SUCCEEDED(hr))
+        {
+            RecordPlacementDecision(PLACEMENT_DECISION_PLACED, heapType);
             return hr;
+        }
     }
     if (committedAllocationParams.IsValid() && !preferCommitted)
     {
         hr = AllocateHeap(committedAllocationParams, *pAllocInfo, withinBudget, pAllocDesc->pPrivateData, ppAllocation);
         if (SUCCEEDED(hr))
+        {
+            RecordPlacementDecision(blockVector != NULL ?
+                PLACEMENT_DECISION_COMMITTED_FALLBACK : PLACEMENT_DECISION_COMMITTED_REQUIRED, heapType);
             return hr;
+        }
     }
     return hr;
 }
 
+HRESULT AllocatorPimpl::AllocateMemoryBatch(
+    UINT allocationCount,
+    const ALLOCATION_DESC* pAllocDescs,
+    const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfos,
+    Allocation** ppAllocations)
+{
+    return AllocateBatch(allocationCount, pAllocDescs, pAllocInfos,
+        NULL, NULL, NULL, NULL, // pResourceDescs, pFinalResourceDescs, pInitialResourceStates, ppOptimizedClearValues
+        ppAllocations);
+}
+
+HRESULT AllocatorPimpl::CreateResourceBatch(
+    UINT resourceCount,
+    const ALLOCATION_DESC* pAllocDescs,
+    const D3D12_RESOURCE_DESC* pResourceDescs,
+    const D3D12_RESOURCE_STATES* pInitialResourceStates,
+    const D3D12_CLEAR_VALUE* const* ppOptimizedClearValues,
+    Allocation** ppAllocations)
+{
+    ZeroMemory(ppAllocations, sizeof(Allocation*) * resourceCount);
+
+    // GetResourceAllocationInfo may adjust the alignment in the description, so keep local copies.
+    // All of them are queried before anything is allocated, so an invalid element fails the whole batch early.
+    Vector<D3D12_RESOURCE_DESC> finalResourceDescs(resourceCount, GetAllocs());
+    Vector<D3D12_RESOURCE_ALLOCATION_INFO> resAllocInfos(resourceCount, GetAllocs());
+    for (UINT i = 0; i < resourceCount; ++i)
+    {
+        finalResourceDescs[i] = pResourceDescs[i];
+        const HRESULT hr = GetResourceAllocationInfo(finalResourceDescs[i], 0, NULL, resAllocInfos[i],
+            IsTightAlignmentEnabled(pAllocDescs[i]));
+        if (FAILED(hr))
+            return hr;
+
+        // We've seen UINT64_MAX returned when the call to GetResourceAllocationInfo was invalid.
+        if (!IsPow2(resAllocInfos[i].Alignment) ||
+            resAllocInfos[i].SizeInBytes == UINT64_MAX ||
+            resAllocInfos[i].SizeInBytes == 0)
+        {
+            D3D12MA_ASSERT(0 && "Invalid resource description passed to Allocator::CreateResourceBatch.");
+            return E_INVALIDARG;
+        }
+    }
+
+    return AllocateBatch(resourceCount, pAllocDescs, resAllocInfos.data(),
+        pResourceDescs, finalResourceDescs.data(), pInitialResourceStates, ppOptimizedClearValues,
+        ppAllocations);
+}
+
+HRESULT AllocatorPimpl::AllocateBatch(
+    UINT count,
+    const ALLOCATION_DESC* pAllocDescs,
+    const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfos,
+    const D3D12_RESOURCE_DESC* pResourceDescs,
+    const D3D12_RESOURCE_DESC* pFinalResourceDescs,
+    const D3D12_RESOURCE_STATES* pInitialResourceStates,
+    const D3D12_CLEAR_VALUE* const* ppOptimizedClearValues,
+    Allocation** ppAllocations)
+{
+    ZeroMemory(ppAllocations, sizeof(Allocation*) * count);
+    if (count == 0)
+        return S_OK;
+
+    Vector<BatchAllocationRequest> requests(count, GetAllocs());
+    // Vector doesn't construct its elements.
+    for (BatchAllocationRequest& request : requests)
+        request = {};
+    HRESULT hr = S_OK;
+    for (UINT i = 0; i < count && SUCCEEDED(hr); ++i)
+    {
+        BatchAllocationRequest& request = requests[i];
+        request.Size = pAllocInfos[i].SizeInBytes;
+        request.Alignment = pAllocInfos[i].Alignment;
+        request.pAllocDesc = &pAllocDescs[i];
+        hr = CalcAllocationParams<D3D12_RESOURCE_DESC>(pAllocDescs[i], request.Size,
+            pResourceDescs ? &pResourceDescs[i] : NULL,
+            pResourceDescs ? IsTightAlignmentEnabled(pAllocDescs[i]) : false,
+            request.pBlockVector, request.CommittedParams, request.PreferCommitted);
+    }
+
+    // 1. Requests that prefer committed allocations, one heap or resource each.
+    for (UINT i = 0; i < count && SUCCEEDED(hr); ++i)
+    {
+        BatchAllocationRequest& request = requests[i];
+        if (!request.CommittedParams.IsValid() || !request.PreferCommitted)
+            continue;
+
+        const bool withinBudget = (request.pAllocDesc->Flags & ALLOCATION_FLAG_WITHIN_BUDGET) != 0;
+        if (pFinalResourceDescs != NULL)
+        {
+            hr = AllocateCommittedResource(request.CommittedParams, request.Size, withinBudget,
+                request.pAllocDesc->pPrivateData,
+                CREATE_RESOURCE_PARAMS(&pFinalResourceDescs[i], pInitialResourceStates[i],
+                    ppOptimizedClearValues ? ppOptimizedClearValues[i] : NULL),
+                &request.pAllocation, IID_NULL, NULL);
+        }
+        else
+        {
+            hr = AllocateHeap(request.CommittedParams, pAllocInfos[i], withinBudget,
+                request.pAllocDesc->pPrivateData, &request.pAllocation);
+        }
+        if (FAILED(hr))
+        {
+            request.pAllocation = NULL;
+            // Fall back to the block vector like AllocateMemory and CreateResource do.
+            if (request.pBlockVector != NULL)
+                hr = S_OK;
+        }
+    }
+
+    // 2. Placed allocations, grouped by block vector so that each is locked only once.
+    if (SUCCEEDED(hr))
+    {
+        Vector<BatchAllocationRequest*> placedRequests(GetAllocs());
+        placedRequests.reserve(count);
+        for (UINT i = 0; i < count; ++i)
+        {
+            if (requests[i].pAllocation == NULL && requests[i].pBlockVector != NULL)
+                placedRequests.push_back(&requests[i]);
+        }
+
+        // Budget is queried once for the whole batch.
+        Budget budgets[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+        UINT64 freeMemory[DXGI_MEMORY_SEGMENT_GROUP_COUNT] = {};
+        if (!placedRequests.empty())
+        {
+            GetBudget(&budgets[DXGI_MEMORY_SEGMENT_GROUP_LOCAL_COPY], &budgets[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL_COPY]);
+            for (UINT group = 0; group < DXGI_MEMORY_SEGMENT_GROUP_COUNT; ++group)
+            {
+                freeMemory[group] = (budgets[group].UsageBytes < budgets[group].BudgetBytes) ?
+                    (budgets[group].BudgetBytes - budgets[group].UsageBytes) : 0;
+            }
+        }
+
+        // A batch usually targets only a few block vectors, so partitioning the requests
+        // one block vector at a time is cheaper than sorting them.
+        for (size_t groupBegin = 0; groupBegin < placedRequests.size() && SUCCEEDED(hr); )
+        {
+            BlockVector* const blockVector = placedRequests[groupBegin]->pBlockVector;
+            size_t groupEnd = groupBegin + 1;
+            for (size_t i = groupEnd; i < placedRequests.size(); ++i)
+            {
+                if (placedRequests[i]->pBlockVector == blockVector)
+                    D3D12MA_SWAP(placedRequests[i], placedRequests[groupEnd++]);
+            }
+
+            UINT64 customHeapFreeMemory = UINT64_MAX;
+            UINT64& groupFreeMemory = IsHeapTypeStandard(blockVector->GetHeapProperties().Type) ?
+                freeMemory[HeapPropertiesToMemorySegmentGroup(blockVector->GetHeapProperties())] :
+                customHeapFreeMemory;
+            hr = blockVector->AllocateBatch(groupEnd - groupBegin, placedRequests.data() + groupBegin, groupFreeMemory);
+            groupBegin = groupEnd;
+        }
+    }
+
+    // 3. Committed fallback for requests that didn't fit into their block vectors.
+    for (UINT i = 0; i < count && SUCCEEDED(hr); ++i)
+    {
+        BatchAllocationRequest& request = requests[i];
+        if (request.pAllocation != NULL)
+            continue;
+        if (!request.CommittedParams.IsValid() || (request.PreferCommitted && request.pBlockVector != NULL))
+        {
+            // Nothing left to try.
+            hr = E_OUTOFMEMORY;
+            break;
+        }
+
+        const bool withinBudget = (request.pAllocDesc->Flags & ALLOCATION_FLAG_WITHIN_BUDGET) != 0;
+        if (pFinalResourceDescs != NULL)
+        {
+            hr = AllocateCommittedResource(request.CommittedParams, request.Size, withinBudget,
+                request.pAllocDesc->pPrivateData,
+                CREATE_RESOURCE_PARAMS(&pFinalResourceDescs[i], pInitialResourceStates[i],
+                    ppOptimizedClearValues ? ppOptimizedClearValues[i] : NULL),
+                &request.pAllocation, IID_NULL, NULL);
+        }
+        else
+        {
+            hr = AllocateHeap(request.CommittedParams, pAllocInfos[i], withinBudget,
+                request.pAllocDesc->pPrivateData, &request.pAllocation);
+        }
+        if (FAILED(hr))
+            request.pAllocation = NULL;
+    }
+
+    // 4. Resources placed in the memory allocated from block vectors, created outside of any lock.
+    if (pFinalResourceDescs != NULL)
+    {
+        for (UINT i = 0; i < count && SUCCEEDED(hr); ++i)
+        {
+            Allocation* const alloc = requests[i].pAllocation;
+            if (alloc->GetResource() != NULL)
+                continue;
+
+            const CREATE_RESOURCE_PARAMS createParams(&pFinalResourceDescs[i], pInitialResourceStates[i],
+                ppOptimizedClearValues ? ppOptimizedClearValues[i] : NULL);
+            ID3D12Resource* res = NULL;
+            hr = CreatePlacedResourceWrap(alloc->m_Placed.block->GetHeap(), alloc->GetOffset(),
+                alloc->m_Placed.block->GetHeapProperties().Type, createParams, D3D12MA_IID_PPV_ARGS(&res));
+            if (SUCCEEDED(hr))
+                alloc->SetResourcePointer(res, createParams.GetBaseResourceDesc());
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        // Free all already created allocations.
+        // Not calling public Release(), as the debug global mutex is already locked by the caller.
+        Vector<Allocation*> createdAllocs(GetAllocs());
+        createdAllocs.reserve(count);
+        for (UINT i = 0; i < count; ++i)
+        {
+            if (requests[i].pAllocation != NULL)
+                createdAllocs.push_back(requests[i].pAllocation);
+        }
+        if (!createdAllocs.empty())
+            FreeAllocations((UINT)createdAllocs.size(), createdAllocs.data());
+        return hr;
+    }
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        ppAllocations[i] = requests[i].pAllocation;
+    }
+    return S_OK;
+}
+
 HRESULT AllocatorPimpl::CreateAliasingResource(
     Allocation* pAllocation,
     UINT64 AllocationLocalOffset,
@@ -6857,7 +10838,90 @@ HRESULT AllocatorPimpl::CreateAliasingResource(
         return E_INVALIDARG;
     }
 
-    return CreatePlacedResourceWrap(existingHeap, newOffset, finalCreateParams, riidResource, ppvResource);
+    return CreatePlacedResourceWrap(existingHeap, newOffset, GetAllocationHeapType(*pAllocation),
+        finalCreateParams, riidResource, ppvResource);
+}
+
+void AllocatorPimpl::FreeAllocations(UINT allocationCount, Allocation* const* ppAllocations)
+{
+    Vector<Allocation*> allocsToFree(GetAllocs());
+    allocsToFree.reserve(allocationCount);
+    for (UINT i = 0; i < allocationCount; ++i)
+    {
+        Allocation* const alloc = ppAllocations[i];
+        if (alloc != NULL && alloc->ReleaseRef() == 0)
+            allocsToFree.push_back(alloc);
+    }
+    if (allocsToFree.empty())
+        return;
+
+    // Same as Allocation::ReleaseThis, except that placed allocations are only collected here.
+    Vector<Allocation*> placedAllocs(GetAllocs());
+    for (size_t i = 0; i < allocsToFree.size(); ++i)
+    {
+        Allocation* const alloc = allocsToFree[i];
+        SAFE_RELEASE(alloc->m_Resource);
+        switch (alloc->m_PackedData.GetType())
+        {
+        case Allocation::TYPE_COMMITTED:
+            FreeCommittedMemory(alloc);
+            break;
+        case Allocation::TYPE_PLACED:
+            m_Budget.RemoveAllocation(HeapPropertiesToMemorySegmentGroup(
+                alloc->m_Placed.block->GetHeapProperties()), alloc->GetSize());
+            placedAllocs.push_back(alloc);
+            break;
+        case Allocation::TYPE_HEAP:
+            FreeHeapMemory(alloc);
+            break;
+        case Allocation::TYPE_BUFFER_RANGE:
+            FreeBufferRange(alloc);
+            break;
+        default:
+            D3D12MA_ASSERT(0);
+        }
+        alloc->FreeName();
+    }
+
+    // Sorting by block vector and then by block gives one group per block vector
+    // and frees neighbouring allocations one after another.
+    D3D12MA_SORT(placedAllocs.begin(), placedAllocs.end(),
+        [](const Allocation* lhs, const Allocation* rhs)
+        {
+            const BlockVector* const lhsVector = lhs->m_Placed.block->GetBlockVector();
+            const BlockVector* const rhsVector = rhs->m_Placed.block->GetBlockVector();
+            if (lhsVector != rhsVector)
+                return lhsVector < rhsVector;
+            return lhs->m_Placed.block < rhs->m_Placed.block;
+        });
+    for (size_t groupBegin = 0; groupBegin < placedAllocs.size(); )
+    {
+        BlockVector* const blockVector = placedAllocs[groupBegin]->m_Placed.block->GetBlockVector();
+        size_t groupEnd = groupBegin + 1;
+        while (groupEnd < placedAllocs.size() &&
+            placedAllocs[groupEnd]->m_Placed.block->GetBlockVector() == blockVector)
+        {
+            ++groupEnd;
+        }
+        blockVector->FreeBatch(groupEnd - groupBegin, placedAllocs.data() + groupBegin);
+        groupBegin = groupEnd;
+    }
+
+    m_AllocationObjectAllocator.FreeBatch(allocsToFree.size(), allocsToFree.data());
+}
+
+HRESULT AllocatorPimpl::CreateBufferSubAllocation(
+    const ALLOCATION_DESC* pAllocDesc,
+    UINT64 size,
+    UINT64 alignment,
+    Allocation** ppAllocation)
+{
+    D3D12MA_ASSERT(pAllocDesc && ppAllocation);
+
+    *ppAllocation = NULL;
+    BufferSubAllocator* const subAllocator = m_BufferSubAllocators[StandardHeapTypeToIndex(pAllocDesc->HeapType)];
+    return subAllocator->Allocate(size, alignment != 0 ? alignment : 1, pAllocDesc->Flags,
+        pAllocDesc->pPrivateData, ppAllocation);
 }
 
 void AllocatorPimpl::FreeCommittedMemory(Allocation* allocation)
@@ -6899,6 +10963,12 @@ void AllocatorPimpl::FreeHeapMemory(Allocation* allocation)
     m_Budget.RemoveBlock(memSegmentGroup, allocSize);
 }
 
+void AllocatorPimpl::FreeBufferRange(Allocation* allocation)
+{
+    D3D12MA_ASSERT(allocation && allocation->m_PackedData.GetType() == Allocation::TYPE_BUFFER_RANGE);
+    allocation->m_BufferRange.buffer->m_Owner->Free(allocation);
+}
+
 void AllocatorPimpl::SetResidencyPriority(ID3D12Pageable* obj, D3D12_RESIDENCY_PRIORITY priority) const
 {
 #ifdef __ID3D12Device1_INTERFACE_DEFINED__
@@ -6914,11 +10984,50 @@ void AllocatorPimpl::SetCurrentFrameIndex(UINT frameIndex)
 {
     m_CurrentFrameIndex.store(frameIndex);
 
+    // Collect allocations whose frame has passed, then release them in one batch outside of the lock.
+    Vector<Allocation*> allocsToRelease(GetAllocs());
+    {
+        MutexLock lock(m_DeferredReleasesMutex, m_UseMutex);
+        size_t dstIndex = 0;
+        for (size_t srcIndex = 0; srcIndex < m_DeferredReleases.size(); ++srcIndex)
+        {
+            const DeferredRelease& item = m_DeferredReleases[srcIndex];
+            // Signed difference so that wrap-around of the frame index is handled.
+            if ((INT)(frameIndex - item.FrameIndex) > 0)
+                allocsToRelease.push_back(item.pAllocation);
+            else
+                m_DeferredReleases[dstIndex++] = item;
+        }
+        m_DeferredReleases.resize(dstIndex);
+    }
+    if (!allocsToRelease.empty())
+        FreeAllocations((UINT)allocsToRelease.size(), allocsToRelease.data());
+
 #if D3D12MA_DXGI_1_4
     UpdateD3D12Budget();
 #endif
 }
 
+void AllocatorPimpl::ReleaseDeferred(Allocation* allocation, UINT frameIndex)
+{
+    MutexLock lock(m_DeferredReleasesMutex, m_UseMutex);
+    m_DeferredReleases.push_back({ allocation, frameIndex });
+}
+
+void AllocatorPimpl::ReleaseAllDeferred()
+{
+    Vector<Allocation*> allocsToRelease(GetAllocs());
+    {
+        MutexLock lock(m_DeferredReleasesMutex, m_UseMutex);
+        allocsToRelease.resize(m_DeferredReleases.size());
+        for (size_t i = 0; i < m_DeferredReleases.size(); ++i)
+            allocsToRelease[i] = m_DeferredReleases[i].pAllocation;
+        m_DeferredReleases.clear(true);
+    }
+    if (!allocsToRelease.empty())
+        FreeAllocations((UINT)allocsToRelease.size(), allocsToRelease.data());
+}
+
 void AllocatorPimpl::CalculateStatistics(TotalStatistics& outStats, DetailedStatistics outCustomHeaps[2])
 {
     // Init stats
@@ -7057,9 +11166,9 @@ void AllocatorPimpl::GetBudget(Budget* outLocalBudget, Budget* outNonLocalBudget
 #if D3D12MA_DXGI_1_4
     if (m_Adapter3)
     {
-        if (!m_Budget.ShouldUpdateBudget())
+        if (m_ManualBudgetUpdate || !m_Budget.ShouldUpdateBudget())
         {
-            m_Budget.GetBudget(m_UseMutex,
+            m_Budget.GetBudget(
                 outLocalBudget ? &outLocalBudget->UsageBytes : NULL,
                 outLocalBudget ? &outLocalBudget->BudgetBytes : NULL,
                 outNonLocalBudget ? &outNonLocalBudget->UsageBytes : NULL,
@@ -7105,6 +11214,29 @@ void AllocatorPimpl::GetBudgetForHeapType(Budget& outBudget, D3D12_HEAP_TYPE hea
 void AllocatorPimpl::BuildStatsString(WCHAR** ppStatsString, BOOL detailedMap)
 {
     StringBuilder sb(GetAllocs());
+    WriteStatsJson(sb, detailedMap);
+
+    const size_t length = sb.GetLength();
+    WCHAR* result = AllocateArray<WCHAR>(GetAllocs(), length + 2);
+    result[0] = 0xFEFF;
+    memcpy(result + 1, sb.GetData(), length * sizeof(WCHAR));
+    result[length + 1] = L'\0';
+    *ppStatsString = result;
+}
+
+void AllocatorPimpl::WriteStatsString(WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData,
+    STATS_STRING_ENCODING encoding, BOOL detailedMap)
+{
+    StringBuilder sb(GetAllocs(), writeFunc, pPrivateData, encoding);
+    // Byte order mark, same as in the string returned by BuildStatsString.
+    if (encoding == STATS_STRING_ENCODING_UTF16)
+        sb.Add((WCHAR)0xFEFF);
+    WriteStatsJson(sb, detailedMap);
+    sb.Flush();
+}
+
+void AllocatorPimpl::WriteStatsJson(StringBuilder& sb, BOOL detailedMap)
+{
     {
         Budget localBudget = {}, nonLocalBudget = {};
         GetBudget(&localBudget, &nonLocalBudget);
@@ -7273,6 +11405,25 @@ void AllocatorPimpl::BuildStatsString(WCHAR** ppStatsString, BOOL detailedMap)
             }
             json.EndObject();
         }
+        if (m_PerformanceCounters != NULL)
+        {
+            PerformanceCounters counters;
+            m_PerformanceCounters->Get(counters);
+            json.WriteString(L"PerformanceCounters");
+            WritePerformanceCountersToJson(json, counters);
+        }
+        if (m_Trace != NULL)
+        {
+            json.WriteString(L"Trace");
+            json.BeginObject();
+            json.WriteString(L"DroppedEventCount");
+            json.WriteNumber(m_Trace->GetDroppedEventCount());
+            json.EndObject();
+        }
+#if D3D12MA_PROFILE_LOCKS
+        json.WriteString(L"LockProfiles");
+        WriteLockProfilesToJson(json);
+#endif
 
         if (detailedMap)
         {
@@ -7367,6 +11518,14 @@ void AllocatorPimpl::BuildStatsString(WCHAR** ppStatsString, BOOL detailedMap)
                 json.WriteString(L"PreferredBlockSize");
                 json.WriteNumber(blockVector->GetPreferredBlockSize());
 
+                json.WriteString(L"Algorithm");
+                json.WriteString(AlgorithmNames[GetAlgorithmIndex(blockVector->GetAlgorithm())]);
+                if (blockVector->GetAlgorithm() == POOL_FLAG_ALGORITHM_SLAB)
+                {
+                    json.WriteString(L"SlotSize");
+                    json.WriteNumber(blockVector->GetSlotSize());
+                }
+
                 json.WriteString(L"Blocks");
                 blockVector->WriteBlockInfoToJson(json);
 
@@ -7447,13 +11606,6 @@ void AllocatorPimpl::BuildStatsString(WCHAR** ppStatsString, BOOL detailedMap)
         }
         json.EndObject();
     }
-
-    const size_t length = sb.GetLength();
-    WCHAR* result = AllocateArray<WCHAR>(GetAllocs(), length + 2);
-    result[0] = 0xFEFF;
-    memcpy(result + 1, sb.GetData(), length * sizeof(WCHAR));
-    result[length + 1] = L'\0';
-    *ppStatsString = result;
 }
 
 void AllocatorPimpl::FreeStatsString(WCHAR* pStatsString)
@@ -7462,6 +11614,154 @@ void AllocatorPimpl::FreeStatsString(WCHAR* pStatsString)
     Free(GetAllocs(), pStatsString);
 }
 
+void AllocatorPimpl::WriteStatsBinary(WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData,
+    BOOL detailedMap)
+{
+    Budget localBudget = {}, nonLocalBudget = {};
+    GetBudget(&localBudget, &nonLocalBudget);
+
+    TotalStatistics stats;
+    DetailedStatistics customHeaps[2];
+    CalculateStatistics(stats, customHeaps);
+
+    BinaryStatsWriter writer(GetAllocs(), writeFunc, pPrivateData);
+    writer.WriteHeader(BinaryStatsWriter::FORMAT_DUMP);
+    {
+        writer.WriteString(m_AdapterDesc.Description);
+        writer.WriteNumber(m_AdapterDesc.DedicatedVideoMemory);
+        writer.WriteNumber(m_AdapterDesc.DedicatedSystemMemory);
+        writer.WriteNumber(m_AdapterDesc.SharedSystemMemory);
+        writer.WriteNumber(static_cast<UINT>(m_D3D12Options.ResourceHeapTier));
+        writer.WriteNumber(static_cast<UINT>(m_D3D12Options.ResourceBindingTier));
+        writer.WriteNumber(static_cast<UINT>(m_D3D12Options.TiledResourcesTier));
+
+        UINT flags = 0;
+        if (m_D3D12Architecture.TileBasedRenderer)
+            flags |= BinaryStatsWriter::GENERAL_FLAG_TILE_BASED_RENDERER;
+        if (m_D3D12Architecture.UMA)
+            flags |= BinaryStatsWriter::GENERAL_FLAG_UMA;
+        if (m_D3D12Architecture.CacheCoherentUMA)
+            flags |= BinaryStatsWriter::GENERAL_FLAG_CACHE_COHERENT_UMA;
+        if (m_GPUUploadHeapSupported)
+            flags |= BinaryStatsWriter::GENERAL_FLAG_GPU_UPLOAD_HEAP_SUPPORTED;
+        if (m_TightAlignmentSupported)
+            flags |= BinaryStatsWriter::GENERAL_FLAG_TIGHT_ALIGNMENT_SUPPORTED;
+        if (detailedMap)
+            flags |= BinaryStatsWriter::GENERAL_FLAG_DETAILED_MAP;
+#ifdef __ID3D12Device8_INTERFACE_DEFINED__
+        flags |= BinaryStatsWriter::GENERAL_FLAG_DEVICE8_HEAP_FLAGS;
+#endif
+        writer.WriteNumber(flags);
+    }
+    {
+        writer.WriteNumber(localBudget.BudgetBytes);
+        writer.WriteNumber(localBudget.UsageBytes);
+        writer.WriteNumber(nonLocalBudget.BudgetBytes);
+        writer.WriteNumber(nonLocalBudget.UsageBytes);
+    }
+    {
+        writer.WriteDetailedStatistics(stats.Total);
+        for (UINT i = 0; i < HEAP_TYPE_COUNT; ++i)
+            writer.WriteDetailedStatistics(stats.HeapType[i]);
+        for (UINT i = 0; i < DXGI_MEMORY_SEGMENT_GROUP_COUNT; ++i)
+            writer.WriteDetailedStatistics(stats.MemorySegmentGroup[i]);
+        for (UINT i = 0; i < 2; ++i)
+            writer.WriteDetailedStatistics(customHeaps[i]);
+    }
+
+    if (detailedMap)
+    {
+        const auto writeHeapInfo = [&](BlockVector* blockVector, CommittedAllocationList* committedAllocs, bool customHeap)
+        {
+            D3D12MA_ASSERT(blockVector);
+
+            writer.WriteNumber((UINT)blockVector->GetHeapFlags());
+            if (customHeap)
+            {
+                const D3D12_HEAP_PROPERTIES& properties = blockVector->GetHeapProperties();
+                writer.WriteNumber((UINT)properties.MemoryPoolPreference);
+                writer.WriteNumber((UINT)properties.CPUPageProperty);
+            }
+            writer.WriteNumber(blockVector->GetPreferredBlockSize());
+            writer.WriteNumber(GetAlgorithmIndex(blockVector->GetAlgorithm()));
+            if (blockVector->GetAlgorithm() == POOL_FLAG_ALGORITHM_SLAB)
+                writer.WriteNumber(blockVector->GetSlotSize());
+            blockVector->WriteBlockInfoToBinary(writer);
+            if (committedAllocs)
+                committedAllocs->WriteStatsBinary(writer);
+            else
+                writer.WriteNumber(0);
+        };
+
+        // Default pools in the same order as in JSON.
+        if (SupportsResourceHeapTier2())
+        {
+            for (uint8_t heapType = 0; heapType < STANDARD_HEAP_TYPE_COUNT; ++heapType)
+                writeHeapInfo(m_BlockVectors[heapType], m_CommittedAllocations + heapType, false);
+        }
+        else
+        {
+            for (uint8_t heapType = 0; heapType < STANDARD_HEAP_TYPE_COUNT; ++heapType)
+            {
+                for (uint8_t heapSubType = 0; heapSubType < 3; ++heapSubType)
+                {
+                    // Committed allocations of the heap type are shared by all its sub-types,
+                    // so they are written only once, with the first one.
+                    writeHeapInfo(m_BlockVectors[heapType * 3 + heapSubType],
+                        heapSubType == 0 ? m_CommittedAllocations + heapType : NULL, false);
+                }
+            }
+        }
+
+        for (uint8_t heapTypeIndex = 0; heapTypeIndex < HEAP_TYPE_COUNT; ++heapTypeIndex)
+        {
+            MutexLockRead mutex(m_PoolsMutex[heapTypeIndex], m_UseMutex);
+            writer.WriteNumber(m_Pools[heapTypeIndex].GetCount());
+            for (auto* item = m_Pools[heapTypeIndex].Front(); item != NULL; item = PoolList::GetNext(item))
+            {
+                writer.WriteString(item->GetName());
+                writeHeapInfo(item->GetBlockVector(), item->GetCommittedAllocationList(), heapTypeIndex == 3);
+            }
+        }
+    }
+}
+
+void AllocatorPimpl::AddToSnapshot(SnapshotPimpl& snapshot)
+{
+    // Allocations created from now on are distinguishable from the ones recorded here.
+    ++m_SnapshotEpoch;
+
+    for (UINT i = 0, count = GetDefaultPoolCount(); i < count; ++i)
+        m_BlockVectors[i]->AddToSnapshot(snapshot);
+    for (UINT i = 0; i < STANDARD_HEAP_TYPE_COUNT; ++i)
+        m_CommittedAllocations[i].AddToSnapshot(snapshot, 0);
+
+    for (uint8_t heapTypeIndex = 0; heapTypeIndex < HEAP_TYPE_COUNT; ++heapTypeIndex)
+    {
+        MutexLockRead mutex(m_PoolsMutex[heapTypeIndex], m_UseMutex);
+        for (auto* item = m_Pools[heapTypeIndex].Front(); item != NULL; item = PoolList::GetNext(item))
+        {
+            BlockVector* const blockVector = item->GetBlockVector();
+            blockVector->AddToSnapshot(snapshot);
+            if (CommittedAllocationList* const committedAllocs = item->GetCommittedAllocationList())
+                committedAllocs->AddToSnapshot(snapshot, blockVector->GetId());
+        }
+    }
+    snapshot.Finish();
+}
+
+UINT AllocatorPimpl::GetTraceEvents(UINT64& inoutNextSequenceNumber, TRACE_EVENT* pEvents, UINT maxEventCount) const
+{
+    return m_Trace != NULL ? m_Trace->Read(inoutNextSequenceNumber, pEvents, maxEventCount) : 0;
+}
+
+void AllocatorPimpl::WriteTraceEvents(UINT64& inoutNextSequenceNumber,
+    WRITE_STATS_STRING_FUNC_PTR writeFunc, void* pPrivateData) const
+{
+    if (m_Trace != NULL)
+        m_Trace->Write(inoutNextSequenceNumber, writeFunc, pPrivateData);
+}
+
 template<typename D3D12_RESOURCE_DESC_T>
 bool AllocatorPimpl::PrefersCommittedAllocation(const D3D12_RESOURCE_DESC_T& resourceDesc,
     ALLOCATION_FLAGS strategy, bool useTightAlignment) const
@@ -7500,8 +11800,8 @@ HRESULT AllocatorPimpl::AllocateCommittedResource(
         hr = AllocateHeap(committedAllocParams, heapAllocInfo, withinBudget, pPrivateData, ppAllocation);
         if (SUCCEEDED(hr))
         {
-            hr = CreatePlacedResourceWrap((*ppAllocation)->GetHeap(), 0, 
-                    createParams, D3D12MA_IID_PPV_ARGS(&res));
+            hr = CreatePlacedResourceWrap((*ppAllocation)->GetHeap(), 0,
+                    committedAllocParams.m_HeapProperties.Type, createParams, D3D12MA_IID_PPV_ARGS(&res));
             if (SUCCEEDED(hr))
             {
                 if (ppvResource != NULL)
@@ -7535,6 +11835,8 @@ HRESULT AllocatorPimpl::AllocateCommittedResource(
      * [ STATE_CREATION ERROR #640: CREATERESOURCEANDHEAP_INVALIDHEAPMISCFLAGS]
     */
 
+    PerformanceTimer createCommittedTimer(m_PerformanceCounters,
+        PERFORMANCE_COUNTER_OPERATION_CREATE_COMMITTED_RESOURCE, committedAllocParams.m_HeapProperties.Type);
 #ifdef __ID3D12Device10_INTERFACE_DEFINED__
     if (createParams.Variant == CREATE_RESOURCE_PARAMS::VARIANT_WITH_LAYOUT)
     {
@@ -7601,6 +11903,7 @@ HRESULT AllocatorPimpl::AllocateCommittedResource(
         D3D12MA_ASSERT(0);
         return E_INVALIDARG;
     }
+    createCommittedTimer.Stop();
 
     if (SUCCEEDED(hr))
     {
@@ -7657,6 +11960,7 @@ HRESULT AllocatorPimpl::AllocateHeap(
 
     HRESULT hr;
     ID3D12Heap* heap = nullptr;
+    PerformanceTimer createHeapTimer(m_PerformanceCounters, PERFORMANCE_COUNTER_OPERATION_CREATE_HEAP, heapDesc.Properties.Type);
 #ifdef __ID3D12Device4_INTERFACE_DEFINED__
     if (m_Device4)
         hr = m_Device4->CreateHeap1(&heapDesc, committedAllocParams.m_ProtectedSession, D3D12MA_IID_PPV_ARGS(&heap));
@@ -7668,6 +11972,7 @@ HRESULT AllocatorPimpl::AllocateHeap(
         else
             hr = E_NOINTERFACE;
     }
+    createHeapTimer.Stop();
 
     if (SUCCEEDED(hr))
     {
@@ -7877,6 +12182,40 @@ HRESULT AllocatorPimpl::UpdateD3D12Budget()
 #endif
 }
 
+HRESULT AllocatorPimpl::UpdateBudget()
+{
+#if D3D12MA_DXGI_1_4
+    if (m_Adapter3)
+        return UpdateD3D12Budget();
+#endif
+    return S_OK;
+}
+
+void AllocatorPimpl::GetPerformanceCounters(PerformanceCounters& outCounters) const
+{
+    if (m_PerformanceCounters != NULL)
+        m_PerformanceCounters->Get(outCounters);
+    else
+        ZeroMemory(&outCounters, sizeof(outCounters));
+}
+
+D3D12_HEAP_TYPE AllocatorPimpl::GetAllocationHeapType(const Allocation& allocation)
+{
+    if (allocation.m_PackedData.GetType() == Allocation::TYPE_PLACED)
+        return allocation.m_Placed.block->GetHeapProperties().Type;
+    if (allocation.m_PackedData.GetType() == Allocation::TYPE_BUFFER_RANGE)
+        return allocation.m_BufferRange.buffer->m_Owner->GetHeapType();
+    return allocation.m_Committed.list->GetHeapType();
+}
+
+void AllocatorPimpl::GetResourceAllocationInfoCacheStatistics(ResourceAllocationInfoCacheStatistics& outStats) const
+{
+    if (m_ResourceAllocationInfoCache != NULL)
+        m_ResourceAllocationInfoCache->GetStatistics(outStats);
+    else
+        ZeroMemory(&outStats, sizeof(outStats));
+}
+
 D3D12_RESOURCE_ALLOCATION_INFO AllocatorPimpl::GetResourceAllocationInfoNative(const D3D12_RESOURCE_DESC& resourceDesc) const
 {
     // This is how new D3D12 headers define GetResourceAllocationInfo function -
@@ -8010,6 +12349,33 @@ HRESULT AllocatorPimpl::GetResourceAllocationInfo(
 
 #endif // #ifdef __ID3D12Device1_INTERFACE_DEFINED__
 
+    ResourceAllocationInfoCache::Key cacheKey;
+    if (m_ResourceAllocationInfoCache != NULL &&
+        ResourceAllocationInfoCache::MakeKey(inOutResourceDesc, NumCastableFormats, pCastableFormats, cacheKey))
+    {
+        UINT64 resourceAlignment = 0;
+        if (m_ResourceAllocationInfoCache->Find(cacheKey, resourceAlignment, outAllocInfo))
+        {
+            inOutResourceDesc.Alignment = resourceAlignment;
+            return S_OK;
+        }
+        const HRESULT hr = GetResourceAllocationInfoUncached(
+            inOutResourceDesc, NumCastableFormats, pCastableFormats, outAllocInfo);
+        if (SUCCEEDED(hr))
+            m_ResourceAllocationInfoCache->Insert(cacheKey, inOutResourceDesc.Alignment, outAllocInfo);
+        return hr;
+    }
+
+    return GetResourceAllocationInfoUncached(
+        inOutResourceDesc, NumCastableFormats, pCastableFormats, outAllocInfo);
+}
+
+template<typename D3D12_RESOURCE_DESC_T>
+HRESULT AllocatorPimpl::GetResourceAllocationInfoUncached(
+    D3D12_RESOURCE_DESC_T& inOutResourceDesc,
+    UINT32 NumCastableFormats, const DXGI_FORMAT* pCastableFormats,
+    D3D12_RESOURCE_ALLOCATION_INFO& outAllocInfo) const
+{
     HRESULT hr = S_OK;
 
 #if D3D12MA_USE_SMALL_RESOURCE_PLACEMENT_ALIGNMENT
@@ -8058,81 +12424,381 @@ HRESULT AllocatorPimpl::GetResourceAllocationInfo(
         }
         inOutResourceDesc.Alignment = 0; // Restore original
     }
-#endif // #if D3D12MA_USE_SMALL_RESOURCE_PLACEMENT_ALIGNMENT
-
-    return GetResourceAllocationInfoMiddle(
-        inOutResourceDesc, NumCastableFormats, pCastableFormats, outAllocInfo);
+#endif // #if D3D12MA_USE_SMALL_RESOURCE_PLACEMENT_ALIGNMENT
+
+    return GetResourceAllocationInfoMiddle(
+        inOutResourceDesc, NumCastableFormats, pCastableFormats, outAllocInfo);
+}
+
+bool AllocatorPimpl::IsTightAlignmentEnabled(const ALLOCATION_DESC& allocDesc) const
+{
+    if (!IsTightAlignmentEnabled())
+        return false;
+
+    if (allocDesc.CustomPool != NULL &&
+        (allocDesc.CustomPool->m_Pimpl->GetDesc().Flags & POOL_FLAG_DONT_USE_TIGHT_ALIGNMENT) != 0)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool AllocatorPimpl::NewAllocationWithinBudget(D3D12_HEAP_TYPE heapType, UINT64 size)
+{
+    Budget budget = {};
+    GetBudgetForHeapType(budget, heapType);
+    return budget.UsageBytes + size <= budget.BudgetBytes;
+}
+
+void AllocatorPimpl::WriteBudgetToJson(JsonWriter& json, const Budget& budget)
+{
+    json.BeginObject();
+    {
+        json.WriteString(L"BudgetBytes");
+        json.WriteNumber(budget.BudgetBytes);
+        json.WriteString(L"UsageBytes");
+        json.WriteNumber(budget.UsageBytes);
+    }
+    json.EndObject();
+}
+
+void AllocatorPimpl::WritePerformanceCountersToJson(JsonWriter& json, const PerformanceCounters& counters)
+{
+    static const LPCWSTR OPERATION_NAMES[] =
+    {
+        L"CreateResource",
+        L"AllocateMemory",
+        L"Free",
+        L"CreateHeap",
+        L"CreatePlacedResource",
+        L"CreateCommittedResource",
+        L"BlockVectorLockWait",
+    };
+    static const LPCWSTR DECISION_NAMES[] =
+    {
+        L"Placed",
+        L"CommittedRequired",
+        L"CommittedPreferred",
+        L"CommittedFallback",
+    };
+    static const LPCWSTR HEAP_TYPE_NAMES[] =
+    {
+        L"DEFAULT",
+        L"UPLOAD",
+        L"READBACK",
+        L"CUSTOM",
+        L"GPU_UPLOAD",
+    };
+    static_assert(sizeof(OPERATION_NAMES) / sizeof(OPERATION_NAMES[0]) == PERFORMANCE_COUNTER_OPERATION_COUNT,
+        "OPERATION_NAMES out of sync with PERFORMANCE_COUNTER_OPERATION.");
+    static_assert(sizeof(DECISION_NAMES) / sizeof(DECISION_NAMES[0]) == PLACEMENT_DECISION_COUNT,
+        "DECISION_NAMES out of sync with PLACEMENT_DECISION.");
+    static_assert(sizeof(HEAP_TYPE_NAMES) / sizeof(HEAP_TYPE_NAMES[0]) == HEAP_TYPE_COUNT,
+        "HEAP_TYPE_NAMES out of sync with HEAP_TYPE_COUNT.");
+
+    json.BeginObject();
+    {
+        json.WriteString(L"Operations");
+        json.BeginObject();
+        for (UINT op = 0; op < PERFORMANCE_COUNTER_OPERATION_COUNT; ++op)
+        {
+            json.WriteString(OPERATION_NAMES[op]);
+            json.BeginObject();
+            for (UINT heapTypeIndex = 0; heapTypeIndex < HEAP_TYPE_COUNT; ++heapTypeIndex)
+            {
+                const LatencyHistogram& histogram = counters.Operations[op][heapTypeIndex];
+                if (histogram.Count == 0)
+                    continue;
+
+                json.WriteString(HEAP_TYPE_NAMES[heapTypeIndex]);
+                json.BeginObject(true);
+                {
+                    json.WriteString(L"Count");
+                    json.WriteNumber(histogram.Count);
+                    json.WriteString(L"TotalNanoseconds");
+                    json.WriteNumber(histogram.TotalNanoseconds);
+                    json.WriteString(L"MaxNanoseconds");
+                    json.WriteNumber(histogram.MaxNanoseconds);
+
+                    UINT bucketCount = LATENCY_HISTOGRAM_BUCKET_COUNT;
+                    while (bucketCount > 0 && histogram.Buckets[bucketCount - 1] == 0)
+                        --bucketCount;
+                    json.WriteString(L"Buckets");
+                    json.BeginArray(true);
+                    for (UINT bucket = 0; bucket < bucketCount; ++bucket)
+                        json.WriteNumber(histogram.Buckets[bucket]);
+                    json.EndArray();
+                }
+                json.EndObject();
+            }
+            json.EndObject();
+        }
+        json.EndObject();
+
+        json.WriteString(L"PlacementDecisions");
+        json.BeginObject();
+        for (UINT heapTypeIndex = 0; heapTypeIndex < HEAP_TYPE_COUNT; ++heapTypeIndex)
+        {
+            json.WriteString(HEAP_TYPE_NAMES[heapTypeIndex]);
+            json.BeginObject(true);
+            for (UINT decision = 0; decision < PLACEMENT_DECISION_COUNT; ++decision)
+            {
+                json.WriteString(DECISION_NAMES[decision]);
+                json.WriteNumber(counters.PlacementDecisions[decision][heapTypeIndex]);
+            }
+            json.EndObject();
+        }
+        json.EndObject();
+    }
+    json.EndObject();
+}
+
+#if D3D12MA_PROFILE_LOCKS
+void AllocatorPimpl::WriteLockProfilesToJson(JsonWriter& json) const
+{
+    static const LPCWSTR LOCK_NAMES[] =
+    {
+        L"Pools",
+        L"BlockVector",
+        L"CommittedAllocationList",
+        L"AllocationObjectAllocator",
+        L"Budget",
+        L"ResourceAllocationInfoCache",
+        L"DeferredReleases",
+        L"BufferSubAllocator",
+    };
+    static_assert(sizeof(LOCK_NAMES) / sizeof(LOCK_NAMES[0]) == LOCK_NAME_COUNT,
+        "LOCK_NAMES out of sync with LockName.");
+
+    json.BeginObject();
+    for (UINT name = 0; name < LOCK_NAME_COUNT; ++name)
+    {
+        LockProfile::Stats stats;
+        m_LockProfiles[name].GetStats(stats);
+
+        json.WriteString(LOCK_NAMES[name]);
+        json.BeginObject(true);
+        {
+            json.WriteString(L"Acquisitions");
+            json.WriteNumber(stats.Acquisitions);
+            json.WriteString(L"ContendedAcquisitions");
+            json.WriteNumber(stats.ContendedAcquisitions);
+            json.WriteString(L"TotalWaitNanoseconds");
+            json.WriteNumber(stats.TotalWaitNanoseconds);
+            json.WriteString(L"MaxWaitNanoseconds");
+            json.WriteNumber(stats.MaxWaitNanoseconds);
+
+            UINT bucketCount = LockProfile::WAIT_HISTOGRAM_BUCKET_COUNT;
+            while (bucketCount > 0 && stats.WaitBuckets[bucketCount - 1] == 0)
+                --bucketCount;
+            json.WriteString(L"WaitBuckets");
+            json.BeginArray(true);
+            for (UINT bucket = 0; bucket < bucketCount; ++bucket)
+                json.WriteNumber(stats.WaitBuckets[bucket]);
+            json.EndArray();
+        }
+        json.EndObject();
+    }
+    json.EndObject();
+}
+#endif // #if D3D12MA_PROFILE_LOCKS
+
+#endif // _D3D12MA_ALLOCATOR_PIMPL
+#endif // _D3D12MA_ALLOCATOR_PIMPL
+
+#ifndef _D3D12MA_VIRTUAL_BLOCK_PIMPL
+/*
+A virtual block is made of one or more shards - independent address ranges, each
+with its own metadata. There is more than one only with VIRTUAL_BLOCK_FLAG_THREAD_SAFE
+and TLSF algorithm. In that case, the index of the shard is stored in the low bits
+of AllocHandle, which is a pointer to a TLSF block node aligned to at least 8 bytes.
+*/
+class VirtualBlockPimpl
+{
+public:
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        D3D12MA_MUTEX AllocMutex;
+        BlockMetadata* Metadata = NULL;
+        // Offset of this shard within the whole virtual block.
+        UINT64 Offset = 0;
+    };
+
+    const ALLOCATION_CALLBACKS m_AllocationCallbacks;
+    const UINT64 m_Size;
+    const bool m_UseMutex;
+    UINT m_ShardCount;
+    Shard* m_Shards;
+
+    VirtualBlockPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks, const VIRTUAL_BLOCK_DESC& desc);
+    ~VirtualBlockPimpl();
+
+    Shard& GetShard(AllocHandle allocHandle) const
+    {
+        return m_ShardCount > 1 ? m_Shards[(UINT64)allocHandle & SHARD_INDEX_MASK] : m_Shards[0];
+    }
+    // Returns the handle as known to the metadata of its shard.
+    AllocHandle GetMetadataHandle(AllocHandle allocHandle) const
+    {
+        return m_ShardCount > 1 ? (AllocHandle)((UINT64)allocHandle & ~SHARD_INDEX_MASK) : allocHandle;
+    }
+    HRESULT Allocate(const VIRTUAL_ALLOCATION_DESC& desc, AllocHandle& outAllocHandle, UINT64& outOffset);
+    bool IsEmpty() const;
+    // Writes the JSON document of BuildStatsString and WriteStatsString.
+    void WriteStatsJson(StringBuilder& sb);
+
+private:
+    static constexpr UINT MAX_SHARD_COUNT = 8;
+    static constexpr UINT64 SHARD_INDEX_MASK = MAX_SHARD_COUNT - 1;
+
+    HRESULT AllocateFromShard(UINT shardIndex, const VIRTUAL_ALLOCATION_DESC& desc, UINT64 alignment,
+        AllocHandle& outAllocHandle, UINT64& outOffset);
+};
+
+#ifndef _D3D12MA_VIRTUAL_BLOCK_PIMPL_FUNCTIONS
+VirtualBlockPimpl::VirtualBlockPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks, const VIRTUAL_BLOCK_DESC& desc)
+    : m_AllocationCallbacks(allocationCallbacks),
+    m_Size(desc.Size),
+    m_UseMutex((desc.Flags & VIRTUAL_BLOCK_FLAG_THREAD_SAFE) != 0),
+    m_ShardCount(1)
+{
+    static_assert(D3D12MA_VIRTUAL_BLOCK_SHARD_COUNT >= 1 && D3D12MA_VIRTUAL_BLOCK_SHARD_COUNT <= MAX_SHARD_COUNT,
+        "D3D12MA_VIRTUAL_BLOCK_SHARD_COUNT must be between 1 and 8.");
+
+    const UINT32 algorithm = desc.Flags & VIRTUAL_BLOCK_FLAG_ALGORITHM_MASK;
+    if (m_UseMutex && algorithm == 0)
+        m_ShardCount = (UINT)D3D12MA_MAX(D3D12MA_MIN((UINT64)D3D12MA_VIRTUAL_BLOCK_SHARD_COUNT, m_Size), (UINT64)1);
+
+    // Shard sizes are rounded down to a multiple of 1/8 of the largest power of 2 not
+    // exceeding them, so that shard offsets are well aligned. The last one takes the rest.
+    UINT64 shardSize = m_Size / m_ShardCount;
+    if (m_ShardCount > 1)
+    {
+        const UINT64 largestPow2 = 1ull << BitScanMSB(shardSize);
+        shardSize = AlignDown(shardSize, D3D12MA_MAX(largestPow2 / 8, (UINT64)1));
+    }
+
+    m_Shards = AllocateArray<Shard>(m_AllocationCallbacks, m_ShardCount);
+    for (UINT i = 0; i < m_ShardCount; ++i)
+    {
+        Shard* const shard = new(&m_Shards[i]) Shard();
+        switch (algorithm)
+        {
+        case VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR:
+            shard->Metadata = D3D12MA_NEW(allocationCallbacks, BlockMetadata_Linear)(&m_AllocationCallbacks, true);
+            break;
+        case VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY:
+            shard->Metadata = D3D12MA_NEW(allocationCallbacks, BlockMetadata_Buddy)(&m_AllocationCallbacks, true);
+            break;
+        case VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB:
+            shard->Metadata = D3D12MA_NEW(allocationCallbacks, BlockMetadata_Slab)(&m_AllocationCallbacks, true, desc.SlotSize);
+            break;
+        default:
+            D3D12MA_ASSERT(0);
+        case 0:
+            shard->Metadata = D3D12MA_NEW(allocationCallbacks, BlockMetadata_TLSF)(&m_AllocationCallbacks, true);
+            break;
+        }
+        shard->Offset = shardSize * i;
+        shard->Metadata->Init(i + 1 < m_ShardCount ? shardSize : m_Size - shard->Offset);
+    }
 }
 
-bool AllocatorPimpl::IsTightAlignmentEnabled(const ALLOCATION_DESC& allocDesc) const
+VirtualBlockPimpl::~VirtualBlockPimpl()
 {
-    if (!IsTightAlignmentEnabled())
-        return false;
+    for (UINT i = 0; i < m_ShardCount; ++i)
+        D3D12MA_DELETE(m_AllocationCallbacks, m_Shards[i].Metadata);
+    D3D12MA_DELETE_ARRAY(m_AllocationCallbacks, m_Shards, m_ShardCount);
+}
 
-    if (allocDesc.CustomPool != NULL &&
-        (allocDesc.CustomPool->m_Pimpl->GetDesc().Flags & POOL_FLAG_DONT_USE_TIGHT_ALIGNMENT) != 0)
+bool VirtualBlockPimpl::IsEmpty() const
+{
+    for (UINT i = 0; i < m_ShardCount; ++i)
     {
-        return false;
+        Shard& shard = m_Shards[i];
+        MutexLock lock(shard.AllocMutex, m_UseMutex);
+        if (!shard.Metadata->IsEmpty())
+            return false;
     }
-
     return true;
 }
 
-bool AllocatorPimpl::NewAllocationWithinBudget(D3D12_HEAP_TYPE heapType, UINT64 size)
+HRESULT VirtualBlockPimpl::Allocate(const VIRTUAL_ALLOCATION_DESC& desc, AllocHandle& outAllocHandle, UINT64& outOffset)
 {
-    Budget budget = {};
-    GetBudgetForHeapType(budget, heapType);
-    return budget.UsageBytes + size <= budget.BudgetBytes;
-}
+    const UINT64 alignment = desc.Alignment != 0 ? desc.Alignment : 1;
+    if (m_ShardCount == 1)
+        return AllocateFromShard(0, desc, alignment, outAllocHandle, outOffset);
 
-void AllocatorPimpl::WriteBudgetToJson(JsonWriter& json, const Budget& budget)
-{
-    json.BeginObject();
+    // Start from the shard of the current thread, take from the other ones only when it's full.
+    const UINT firstShardIndex = GetCurrentThreadIndex() % m_ShardCount;
+    for (UINT i = 0; i < m_ShardCount; ++i)
     {
-        json.WriteString(L"BudgetBytes");
-        json.WriteNumber(budget.BudgetBytes);
-        json.WriteString(L"UsageBytes");
-        json.WriteNumber(budget.UsageBytes);
+        const UINT shardIndex = (firstShardIndex + i) % m_ShardCount;
+        if (m_Shards[shardIndex].Offset % alignment != 0)
+            continue;
+        if (SUCCEEDED(AllocateFromShard(shardIndex, desc, alignment, outAllocHandle, outOffset)))
+            return S_OK;
     }
-    json.EndObject();
+    return E_OUTOFMEMORY;
 }
 
-#endif // _D3D12MA_ALLOCATOR_PIMPL
-#endif // _D3D12MA_ALLOCATOR_PIMPL
-
-#ifndef _D3D12MA_VIRTUAL_BLOCK_PIMPL
-class VirtualBlockPimpl
+HRESULT VirtualBlockPimpl::AllocateFromShard(UINT shardIndex, const VIRTUAL_ALLOCATION_DESC& desc, UINT64 alignment,
+    AllocHandle& outAllocHandle, UINT64& outOffset)
 {
-public:
-    const ALLOCATION_CALLBACKS m_AllocationCallbacks;
-    const UINT64 m_Size;
-    BlockMetadata* m_Metadata;
-
-    VirtualBlockPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks, const VIRTUAL_BLOCK_DESC& desc);
-    ~VirtualBlockPimpl();
-};
+    Shard& shard = m_Shards[shardIndex];
+    MutexLock lock(shard.AllocMutex, m_UseMutex);
 
-#ifndef _D3D12MA_VIRTUAL_BLOCK_PIMPL_FUNCTIONS
-VirtualBlockPimpl::VirtualBlockPimpl(const ALLOCATION_CALLBACKS& allocationCallbacks, const VIRTUAL_BLOCK_DESC& desc)
-    : m_AllocationCallbacks(allocationCallbacks), m_Size(desc.Size)
-{
-    switch (desc.Flags & VIRTUAL_BLOCK_FLAG_ALGORITHM_MASK)
+    AllocationRequest allocRequest = {};
+    if (!shard.Metadata->CreateAllocationRequest(
+        desc.Size,
+        alignment,
+        desc.Flags & VIRTUAL_ALLOCATION_FLAG_UPPER_ADDRESS,
+        desc.Flags & VIRTUAL_ALLOCATION_FLAG_STRATEGY_MASK,
+        &allocRequest))
     {
-    case VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR:
-        m_Metadata = D3D12MA_NEW(allocationCallbacks, BlockMetadata_Linear)(&m_AllocationCallbacks, true);
-        break;
-    default:
-        D3D12MA_ASSERT(0);
-    case 0:
-        m_Metadata = D3D12MA_NEW(allocationCallbacks, BlockMetadata_TLSF)(&m_AllocationCallbacks, true);
-        break;
+        return E_OUTOFMEMORY;
     }
-    m_Metadata->Init(m_Size);
+
+    shard.Metadata->Alloc(allocRequest, desc.Size, desc.pPrivateData);
+    D3D12MA_HEAVY_ASSERT(shard.Metadata->Validate());
+    D3D12MA_ASSERT(((UINT64)allocRequest.allocHandle & SHARD_INDEX_MASK) == 0 || m_ShardCount == 1);
+    outAllocHandle = m_ShardCount > 1 ?
+        (AllocHandle)((UINT64)allocRequest.allocHandle | shardIndex) : allocRequest.allocHandle;
+    outOffset = shard.Offset + shard.Metadata->GetAllocationOffset(allocRequest.allocHandle);
+    return S_OK;
 }
 
-VirtualBlockPimpl::~VirtualBlockPimpl()
+void VirtualBlockPimpl::WriteStatsJson(StringBuilder& sb)
 {
-    D3D12MA_DELETE(m_AllocationCallbacks, m_Metadata);
+    JsonWriter json(m_AllocationCallbacks, sb);
+    json.BeginObject();
+    if (m_ShardCount == 1)
+    {
+        Shard& shard = m_Shards[0];
+        MutexLock lock(shard.AllocMutex, m_UseMutex);
+        D3D12MA_HEAVY_ASSERT(shard.Metadata->Validate());
+        shard.Metadata->WriteAllocationInfoToJson(json);
+    }
+    else
+    {
+        // Offsets inside each shard are relative to its beginning.
+        json.WriteString(L"Shards");
+        json.BeginArray();
+        for (UINT i = 0; i < m_ShardCount; ++i)
+        {
+            Shard& shard = m_Shards[i];
+            MutexLock lock(shard.AllocMutex, m_UseMutex);
+            D3D12MA_HEAVY_ASSERT(shard.Metadata->Validate());
+            json.BeginObject();
+            json.WriteString(L"Offset");
+            json.WriteNumber(shard.Offset);
+            shard.Metadata->WriteAllocationInfoToJson(json);
+            json.EndObject();
+        }
+        json.EndArray();
+    }
+    json.EndObject();
 }
 #endif // _D3D12MA_VIRTUAL_BLOCK_PIMPL_FUNCTIONS
 #endif // _D3D12MA_VIRTUAL_BLOCK_PIMPL
@@ -8172,6 +12838,8 @@ HRESULT MemoryBlock::Init(ID3D12ProtectedResourceSession* pProtectedSession, boo
     heapDesc.Flags = m_HeapFlags;
 
     HRESULT hr;
+    PerformanceTimer createHeapTimer(m_Allocator->GetPerformanceCounterSet(),
+        PERFORMANCE_COUNTER_OPERATION_CREATE_HEAP, heapDesc.Properties.Type);
 #ifdef __ID3D12Device4_INTERFACE_DEFINED__
     ID3D12Device4* const device4 = m_Allocator->GetDevice4();
     if (device4)
@@ -8184,6 +12852,7 @@ HRESULT MemoryBlock::Init(ID3D12ProtectedResourceSession* pProtectedSession, boo
         else
             hr = E_NOINTERFACE;
     }
+    createHeapTimer.Stop();
 
     if (SUCCEEDED(hr))
     {
@@ -8222,7 +12891,7 @@ NormalBlock::~NormalBlock()
     }
 }
 
-HRESULT NormalBlock::Init(UINT32 algorithm, ID3D12ProtectedResourceSession* pProtectedSession, bool denyMsaaTextures)
+HRESULT NormalBlock::Init(UINT32 algorithm, UINT64 slotSize, ID3D12ProtectedResourceSession* pProtectedSession, bool denyMsaaTextures)
 {
     HRESULT hr = MemoryBlock::Init(pProtectedSession, denyMsaaTextures);
     if (FAILED(hr))
@@ -8235,6 +12904,12 @@ HRESULT NormalBlock::Init(UINT32 algorithm, ID3D12ProtectedResourceSession* pPro
     case POOL_FLAG_ALGORITHM_LINEAR:
         m_pMetadata = D3D12MA_NEW(m_Allocator->GetAllocs(), BlockMetadata_Linear)(&m_Allocator->GetAllocs(), false);
         break;
+    case POOL_FLAG_ALGORITHM_BUDDY:
+        m_pMetadata = D3D12MA_NEW(m_Allocator->GetAllocs(), BlockMetadata_Buddy)(&m_Allocator->GetAllocs(), false);
+        break;
+    case POOL_FLAG_ALGORITHM_SLAB:
+        m_pMetadata = D3D12MA_NEW(m_Allocator->GetAllocs(), BlockMetadata_Slab)(&m_Allocator->GetAllocs(), false, slotSize);
+        break;
     default:
         D3D12MA_ASSERT(0);
     case 0:
@@ -8257,9 +12932,10 @@ bool NormalBlock::Validate() const
 #endif // _D3D12MA_NORMAL_BLOCK_FUNCTIONS
 
 #ifndef _D3D12MA_COMMITTED_ALLOCATION_LIST_FUNCTIONS
-void CommittedAllocationList::Init(bool useMutex, D3D12_HEAP_TYPE heapType, PoolPimpl* pool)
+void CommittedAllocationList::Init(bool useMutex, bool useStatisticsSnapshot, D3D12_HEAP_TYPE heapType, PoolPimpl* pool)
 {
     m_UseMutex = useMutex;
+    m_UseStatisticsSnapshot = useStatisticsSnapshot;
     m_HeapType = heapType;
     m_Pool = pool;
 }
@@ -8282,6 +12958,15 @@ UINT CommittedAllocationList::GetMemorySegmentGroup(AllocatorPimpl* allocator) c
 
 void CommittedAllocationList::AddStatistics(Statistics& inoutStats)
 {
+    if (m_UseStatisticsSnapshot)
+    {
+        DetailedStatistics snapshotStats;
+        ClearDetailedStatistics(snapshotStats);
+        m_StatisticsSnapshot.Read(snapshotStats);
+        D3D12MA::AddStatistics(inoutStats, snapshotStats.Stats);
+        return;
+    }
+
     MutexLockRead lock(m_Mutex, m_UseMutex);
 
     for (Allocation* alloc = m_AllocationList.Front();
@@ -8297,6 +12982,12 @@ void CommittedAllocationList::AddStatistics(Statistics& inoutStats)
 
 void CommittedAllocationList::AddDetailedStatistics(DetailedStatistics& inoutStats)
 {
+    if (m_UseStatisticsSnapshot)
+    {
+        m_StatisticsSnapshot.Read(inoutStats);
+        return;
+    }
+
     MutexLockRead lock(m_Mutex, m_UseMutex);
 
     for (Allocation* alloc = m_AllocationList.Front();
@@ -8322,16 +13013,64 @@ void CommittedAllocationList::BuildStatsString(JsonWriter& json)
     }
 }
 
+void CommittedAllocationList::WriteStatsBinary(BinaryStatsWriter& writer)
+{
+    MutexLockRead lock(m_Mutex, m_UseMutex);
+
+    writer.WriteNumber(m_AllocationList.GetCount());
+    writer.BeginEntryList();
+    for (Allocation* alloc = m_AllocationList.Front();
+        alloc != NULL; alloc = m_AllocationList.GetNext(alloc))
+    {
+        writer.WriteAllocation(*alloc, 0);
+    }
+}
+
+void CommittedAllocationList::AddToSnapshot(SnapshotPimpl& snapshot, UINT poolId)
+{
+    MutexLockRead lock(m_Mutex, m_UseMutex);
+
+    for (Allocation* alloc = m_AllocationList.Front();
+        alloc != NULL; alloc = m_AllocationList.GetNext(alloc))
+    {
+        snapshot.AddAllocation(*alloc, m_HeapType, poolId, UINT_MAX, 0);
+    }
+}
+
 void CommittedAllocationList::Register(Allocation* alloc)
 {
+    if (TraceRing* const trace = alloc->m_Allocator->GetTrace())
+    {
+        trace->RecordAllocation(TRACE_EVENT_TYPE_ALLOCATE, *alloc, m_HeapType,
+            m_Pool != NULL ? m_Pool->GetBlockVector()->GetId() : 0, UINT_MAX, 0);
+    }
+
     MutexLockWrite lock(m_Mutex, m_UseMutex);
     m_AllocationList.PushBack(alloc);
+    if (m_UseStatisticsSnapshot)
+    {
+        StatisticsSnapshotUpdate snapshotUpdate(&m_StatisticsSnapshot);
+        m_StatisticsSnapshot.AddBlock(alloc->GetSize());
+        m_StatisticsSnapshot.AddAllocation(alloc->GetSize());
+    }
 }
 
 void CommittedAllocationList::Unregister(Allocation* alloc)
 {
+    if (TraceRing* const trace = alloc->m_Allocator->GetTrace())
+    {
+        trace->RecordAllocation(TRACE_EVENT_TYPE_FREE, *alloc, m_HeapType,
+            m_Pool != NULL ? m_Pool->GetBlockVector()->GetId() : 0, UINT_MAX, 0);
+    }
+
     MutexLockWrite lock(m_Mutex, m_UseMutex);
     m_AllocationList.Remove(alloc);
+    if (m_UseStatisticsSnapshot)
+    {
+        StatisticsSnapshotUpdate snapshotUpdate(&m_StatisticsSnapshot);
+        m_StatisticsSnapshot.RemoveAllocation(alloc->GetSize());
+        m_StatisticsSnapshot.RemoveBlock(alloc->GetSize());
+    }
 }
 #endif // _D3D12MA_COMMITTED_ALLOCATION_LIST_FUNCTIONS
 
@@ -8346,10 +13085,12 @@ BlockVector::BlockVector(
     bool explicitBlockSize,
     UINT64 minAllocationAlignment,
     UINT32 algorithm,
+    UINT64 slotSize,
     bool denyMsaaTextures,
     ID3D12ProtectedResourceSession* pProtectedSession,
     D3D12_RESIDENCY_PRIORITY residencyPriority)
     : m_hAllocator(hAllocator),
+    m_Id(hAllocator->GenerateBlockVectorId()),
     m_HeapProps(heapProps),
     m_HeapFlags(heapFlags),
     m_PreferredBlockSize(preferredBlockSize),
@@ -8358,17 +13099,25 @@ BlockVector::BlockVector(
     m_ExplicitBlockSize(explicitBlockSize),
     m_MinAllocationAlignment(D3D12MA_MAX(minAllocationAlignment, (UINT64)D3D12MA_DEBUG_ALIGNMENT)),
     m_Algorithm(algorithm),
+    m_SlotSize(algorithm == POOL_FLAG_ALGORITHM_SLAB ? slotSize : 0),
     m_DenyMsaaTextures(denyMsaaTextures),
     m_ProtectedSession(pProtectedSession),
     m_ResidencyPriority(residencyPriority),
     m_HasEmptyBlock(false),
+    m_UseStatisticsSnapshot(hAllocator->UseLockFreeStatistics() && algorithm != POOL_FLAG_ALGORITHM_LINEAR),
     m_Blocks(hAllocator->GetAllocs()),
-    m_NextBlockId(0) {}
+    m_FreeSizeTree(hAllocator->GetAllocs()),
+    m_FreeSizeTreeLeafCount(0),
+    m_NextBlockId(0)
+{
+    BindLockProfile(m_Mutex, hAllocator->GetLockProfile(LOCK_NAME_BLOCK_VECTOR));
+}
 
 BlockVector::~BlockVector()
 {
     for (size_t i = m_Blocks.size(); i--; )
     {
+        RecordBlockEvent(TRACE_EVENT_TYPE_DESTROY_BLOCK, *m_Blocks[i]);
         D3D12MA_DELETE(m_hAllocator->GetAllocs(), m_Blocks[i]);
     }
 }
@@ -8402,9 +13151,13 @@ HRESULT BlockVector::Allocate(
 {
     size_t allocIndex;
     HRESULT hr = S_OK;
+    UINT64 freeMemory = CalcFreeMemoryInBudget();
 
     {
+        PerformanceTimer lockWaitTimer(m_hAllocator->GetPerformanceCounterSet(),
+            PERFORMANCE_COUNTER_OPERATION_BLOCK_VECTOR_LOCK_WAIT, m_HeapProps.Type);
         MutexLockWrite lock(m_Mutex, m_hAllocator->UseMutex());
+        lockWaitTimer.Stop();
         for (allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
         {
             hr = AllocatePage(
@@ -8412,6 +13165,7 @@ HRESULT BlockVector::Allocate(
                 alignment,
                 allocDesc,
                 committedAllowed,
+                freeMemory,
                 pAllocations + allocIndex);
             if (FAILED(hr))
             {
@@ -8433,6 +13187,38 @@ HRESULT BlockVector::Allocate(
     return hr;
 }
 
+HRESULT BlockVector::AllocateBatch(
+    size_t requestCount,
+    BatchAllocationRequest* const* ppRequests,
+    UINT64& inoutFreeMemory)
+{
+    PerformanceTimer lockWaitTimer(m_hAllocator->GetPerformanceCounterSet(),
+        PERFORMANCE_COUNTER_OPERATION_BLOCK_VECTOR_LOCK_WAIT, m_HeapProps.Type);
+    MutexLockWrite lock(m_Mutex, m_hAllocator->UseMutex());
+    lockWaitTimer.Stop();
+    for (size_t i = 0; i < requestCount; ++i)
+    {
+        BatchAllocationRequest& request = *ppRequests[i];
+        D3D12MA_ASSERT(request.pBlockVector == this && request.pAllocation == NULL);
+
+        const bool committedAllowed = request.CommittedParams.IsValid();
+        const HRESULT hr = AllocatePage(
+            request.Size,
+            request.Alignment,
+            *request.pAllocDesc,
+            committedAllowed,
+            inoutFreeMemory,
+            &request.pAllocation);
+        if (FAILED(hr))
+        {
+            request.pAllocation = NULL;
+            if (!committedAllowed)
+                return hr;
+        }
+    }
+    return S_OK;
+}
+
 void BlockVector::Free(Allocation* hAllocation)
 {
     NormalBlock* pBlockToDelete = NULL;
@@ -8447,12 +13233,17 @@ void BlockVector::Free(Allocation* hAllocation)
 
     // Scope for lock.
     {
+        PerformanceTimer lockWaitTimer(m_hAllocator->GetPerformanceCounterSet(),
+            PERFORMANCE_COUNTER_OPERATION_BLOCK_VECTOR_LOCK_WAIT, m_HeapProps.Type);
         MutexLockWrite lock(m_Mutex, m_hAllocator->UseMutex());
+        lockWaitTimer.Stop();
 
         NormalBlock* pBlock = hAllocation->m_Placed.block;
 
+        RecordAllocationEvent(TRACE_EVENT_TYPE_FREE, *hAllocation);
         pBlock->m_pMetadata->Free(hAllocation->GetAllocHandle());
         D3D12MA_HEAVY_ASSERT(pBlock->Validate());
+        UpdateFreeSizeIndex(pBlock->m_IndexInBlockVector);
 
         const size_t blockCount = m_Blocks.size();
         // pBlock became empty after this deallocation.
@@ -8479,7 +13270,9 @@ void BlockVector::Free(Allocation* hAllocation)
             if (pLastBlock->m_pMetadata->IsEmpty())
             {
                 pBlockToDelete = pLastBlock;
+                DetachStatisticsSnapshot(pLastBlock);
                 m_Blocks.pop_back();
+                UpdateFreeSizeIndexRange(m_Blocks.size(), m_Blocks.size() + 1);
                 m_HasEmptyBlock = false;
             }
         }
@@ -8491,10 +13284,79 @@ void BlockVector::Free(Allocation* hAllocation)
     // lock, for performance reason.
     if (pBlockToDelete != NULL)
     {
+        RecordBlockEvent(TRACE_EVENT_TYPE_DESTROY_BLOCK, *pBlockToDelete);
         D3D12MA_DELETE(m_hAllocator->GetAllocs(), pBlockToDelete);
     }
 }
 
+void BlockVector::FreeBatch(size_t allocationCount, Allocation* const* pAllocations)
+{
+    bool budgetExceeded = false;
+    if (IsHeapTypeStandard(m_HeapProps.Type))
+    {
+        Budget budget = {};
+        m_hAllocator->GetBudgetForHeapType(budget, m_HeapProps.Type);
+        budgetExceeded = budget.UsageBytes >= budget.BudgetBytes;
+    }
+
+    Vector<NormalBlock*> blocksToDelete(m_hAllocator->GetAllocs());
+
+    // Scope for lock.
+    {
+        PerformanceTimer lockWaitTimer(m_hAllocator->GetPerformanceCounterSet(),
+            PERFORMANCE_COUNTER_OPERATION_BLOCK_VECTOR_LOCK_WAIT, m_HeapProps.Type);
+        MutexLockWrite lock(m_Mutex, m_hAllocator->UseMutex());
+        lockWaitTimer.Stop();
+
+        for (size_t i = 0; i < allocationCount; ++i)
+        {
+            Allocation* const hAllocation = pAllocations[i];
+            NormalBlock* const pBlock = hAllocation->m_Placed.block;
+            D3D12MA_ASSERT(pBlock->GetBlockVector() == this);
+            RecordAllocationEvent(TRACE_EVENT_TYPE_FREE, *hAllocation);
+            pBlock->m_pMetadata->Free(hAllocation->GetAllocHandle());
+            D3D12MA_HEAVY_ASSERT(pBlock->Validate());
+            UpdateFreeSizeIndex(pBlock->m_IndexInBlockVector);
+        }
+
+        // Keep at most one empty block, same as Free would after each deallocation.
+        const size_t oldBlockCount = m_Blocks.size();
+        size_t firstRemovedBlockIndex = oldBlockCount;
+        m_HasEmptyBlock = false;
+        for (size_t blockIndex = m_Blocks.size(); blockIndex--; )
+        {
+            NormalBlock* const pBlock = m_Blocks[blockIndex];
+            if (!pBlock->m_pMetadata->IsEmpty())
+                continue;
+            if ((m_HasEmptyBlock || budgetExceeded) &&
+                m_Blocks.size() > m_MinBlockCount)
+            {
+                blocksToDelete.push_back(pBlock);
+                DetachStatisticsSnapshot(pBlock);
+                m_Blocks.remove(blockIndex);
+                firstRemovedBlockIndex = blockIndex;
+            }
+            else
+            {
+                m_HasEmptyBlock = true;
+            }
+        }
+
+        if (m_IncrementalSort)
+            SortByFreeSize();
+        else
+            UpdateFreeSizeIndexRange(firstRemovedBlockIndex, oldBlockCount);
+    }
+
+    // Destruction of empty blocks. Deferred until this point, outside of mutex
+    // lock, for performance reason.
+    for (size_t i = 0; i < blocksToDelete.size(); ++i)
+    {
+        RecordBlockEvent(TRACE_EVENT_TYPE_DESTROY_BLOCK, *blocksToDelete[i]);
+        D3D12MA_DELETE(m_hAllocator->GetAllocs(), blocksToDelete[i]);
+    }
+}
+
 HRESULT BlockVector::CreateResource(
     UINT64 size,
     UINT64 alignment,
@@ -8515,6 +13377,7 @@ HRESULT BlockVector::CreateResource(
     hr = m_hAllocator->CreatePlacedResourceWrap(
         (*ppAllocation)->m_Placed.block->GetHeap(),
         (*ppAllocation)->GetOffset(),
+        m_HeapProps.Type,
         createParams,
         D3D12MA_IID_PPV_ARGS(&res));
     if (SUCCEEDED(hr))
@@ -8542,6 +13405,15 @@ HRESULT BlockVector::CreateResource(
 
 void BlockVector::AddStatistics(Statistics& inoutStats)
 {
+    if (m_UseStatisticsSnapshot)
+    {
+        DetailedStatistics snapshotStats;
+        ClearDetailedStatistics(snapshotStats);
+        m_StatisticsSnapshot.Read(snapshotStats);
+        D3D12MA::AddStatistics(inoutStats, snapshotStats.Stats);
+        return;
+    }
+
     MutexLockRead lock(m_Mutex, m_hAllocator->UseMutex());
 
     for (size_t i = 0; i < m_Blocks.size(); ++i)
@@ -8555,6 +13427,12 @@ void BlockVector::AddStatistics(Statistics& inoutStats)
 
 void BlockVector::AddDetailedStatistics(DetailedStatistics& inoutStats)
 {
+    if (m_UseStatisticsSnapshot)
+    {
+        m_StatisticsSnapshot.Read(inoutStats);
+        return;
+    }
+
     MutexLockRead lock(m_Mutex, m_hAllocator->UseMutex());
 
     for (size_t i = 0; i < m_Blocks.size(); ++i)
@@ -8589,6 +13467,49 @@ void BlockVector::WriteBlockInfoToJson(JsonWriter& json)
     json.EndObject();
 }
 
+void BlockVector::WriteBlockInfoToBinary(BinaryStatsWriter& writer)
+{
+    MutexLockRead lock(m_Mutex, m_hAllocator->UseMutex());
+
+    writer.WriteNumber(m_Blocks.size());
+    for (size_t i = 0, count = m_Blocks.size(); i < count; ++i)
+    {
+        const NormalBlock* const pBlock = m_Blocks[i];
+        D3D12MA_ASSERT(pBlock);
+        D3D12MA_HEAVY_ASSERT(pBlock->Validate());
+        writer.WriteNumber(pBlock->GetId());
+        pBlock->m_pMetadata->WriteAllocationInfoToBinary(writer);
+    }
+}
+
+void BlockVector::AddToSnapshot(SnapshotPimpl& snapshot)
+{
+    MutexLockRead lock(m_Mutex, m_hAllocator->UseMutex());
+
+    for (size_t i = 0, count = m_Blocks.size(); i < count; ++i)
+    {
+        const NormalBlock* const pBlock = m_Blocks[i];
+        D3D12MA_ASSERT(pBlock);
+        SnapshotDetailedMapWriter writer(snapshot, m_HeapProps.Type, m_Id, pBlock->GetId());
+        pBlock->m_pMetadata->WriteDetailedMap(writer);
+    }
+}
+
+void BlockVector::RecordBlockEvent(TRACE_EVENT_TYPE type, const NormalBlock& block) const
+{
+    if (TraceRing* const trace = m_hAllocator->GetTrace())
+        trace->Record(type, m_HeapProps.Type, m_Id, block.GetId(), 0, 0, block.m_pMetadata->GetSize(), 0);
+}
+
+void BlockVector::RecordAllocationEvent(TRACE_EVENT_TYPE type, const Allocation& alloc) const
+{
+    if (TraceRing* const trace = m_hAllocator->GetTrace())
+    {
+        trace->RecordAllocation(type, alloc, m_HeapProps.Type, m_Id,
+            alloc.m_Placed.block->GetId(), alloc.GetOffset());
+    }
+}
+
 UINT64 BlockVector::CalcSumBlockSize() const
 {
     UINT64 result = 0;
@@ -8619,35 +13540,168 @@ void BlockVector::Remove(NormalBlock* pBlock)
     {
         if (m_Blocks[blockIndex] == pBlock)
         {
-            m_Blocks.remove(blockIndex);
-            return;
+            DetachStatisticsSnapshot(pBlock);
+            m_Blocks.remove(blockIndex);
+            UpdateFreeSizeIndexRange(blockIndex, m_Blocks.size() + 1);
+            return;
+        }
+    }
+    D3D12MA_ASSERT(0);
+}
+
+void BlockVector::AttachStatisticsSnapshot(NormalBlock* pBlock)
+{
+    if (m_UseStatisticsSnapshot)
+    {
+        StatisticsSnapshotUpdate snapshotUpdate(&m_StatisticsSnapshot);
+        m_StatisticsSnapshot.AddBlock(pBlock->m_pMetadata->GetSize());
+        pBlock->m_pMetadata->SetStatisticsSnapshot(&m_StatisticsSnapshot);
+    }
+}
+
+void BlockVector::DetachStatisticsSnapshot(NormalBlock* pBlock)
+{
+    if (m_UseStatisticsSnapshot)
+    {
+        StatisticsSnapshotUpdate snapshotUpdate(&m_StatisticsSnapshot);
+        pBlock->m_pMetadata->SetStatisticsSnapshot(NULL);
+        m_StatisticsSnapshot.RemoveBlock(pBlock->m_pMetadata->GetSize());
+    }
+}
+
+void BlockVector::IncrementallySortBlocks()
+{
+    if (!m_IncrementalSort)
+        return;
+    // Bubble sort only until first swap.
+    for (size_t i = 1; i < m_Blocks.size(); ++i)
+    {
+        if (m_Blocks[i - 1]->m_pMetadata->GetSumFreeSize() > m_Blocks[i]->m_pMetadata->GetSumFreeSize())
+        {
+            SwapBlocks(i - 1, i);
+            return;
+        }
+    }
+}
+
+void BlockVector::SortByFreeSize()
+{
+    D3D12MA_SORT(m_Blocks.begin(), m_Blocks.end(),
+        [](auto* b1, auto* b2)
+        {
+            return b1->m_pMetadata->GetSumFreeSize() < b2->m_pMetadata->GetSumFreeSize();
+        });
+    RebuildFreeSizeIndex();
+}
+
+void BlockVector::SwapBlocks(size_t blockIndex1, size_t blockIndex2)
+{
+    D3D12MA_SWAP(m_Blocks[blockIndex1], m_Blocks[blockIndex2]);
+    UpdateFreeSizeIndex(blockIndex1);
+    UpdateFreeSizeIndex(blockIndex2);
+}
+
+void BlockVector::UpdateFreeSizeIndex(size_t blockIndex)
+{
+    D3D12MA_ASSERT(blockIndex < m_Blocks.size() && blockIndex < m_FreeSizeTreeLeafCount);
+    NormalBlock* const pBlock = m_Blocks[blockIndex];
+    pBlock->m_IndexInBlockVector = blockIndex;
+
+    size_t node = m_FreeSizeTreeLeafCount + blockIndex;
+    m_FreeSizeTree[node] = pBlock->m_pMetadata->GetLargestFreeRegionSizeBound();
+    for (node /= 2; node > 0; node /= 2)
+    {
+        const UINT64 maxFreeSize = D3D12MA_MAX(m_FreeSizeTree[node * 2], m_FreeSizeTree[node * 2 + 1]);
+        if (m_FreeSizeTree[node] == maxFreeSize)
+            break;
+        m_FreeSizeTree[node] = maxFreeSize;
+    }
+}
+
+void BlockVector::UpdateFreeSizeIndexRange(size_t firstBlockIndex, size_t endBlockIndex)
+{
+    D3D12MA_ASSERT(firstBlockIndex <= endBlockIndex && endBlockIndex <= m_FreeSizeTreeLeafCount);
+    if (firstBlockIndex == endBlockIndex)
+        return;
+
+    for (size_t i = firstBlockIndex; i < endBlockIndex; ++i)
+    {
+        UINT64 freeSize = 0;
+        if (i < m_Blocks.size())
+        {
+            m_Blocks[i]->m_IndexInBlockVector = i;
+            freeSize = m_Blocks[i]->m_pMetadata->GetLargestFreeRegionSizeBound();
+        }
+        m_FreeSizeTree[m_FreeSizeTreeLeafCount + i] = freeSize;
+    }
+    // Recalculate only the parents of the changed nodes, level by level.
+    size_t firstNode = (m_FreeSizeTreeLeafCount + firstBlockIndex) / 2;
+    size_t lastNode = (m_FreeSizeTreeLeafCount + endBlockIndex - 1) / 2;
+    for (; firstNode > 0; firstNode /= 2, lastNode /= 2)
+    {
+        for (size_t node = firstNode; node <= lastNode; ++node)
+            m_FreeSizeTree[node] = D3D12MA_MAX(m_FreeSizeTree[node * 2], m_FreeSizeTree[node * 2 + 1]);
+    }
+}
+
+void BlockVector::RebuildFreeSizeIndex()
+{
+    const size_t blockCount = m_Blocks.size();
+    size_t leafCount = 1;
+    while (leafCount < blockCount)
+        leafCount *= 2;
+
+    m_FreeSizeTreeLeafCount = leafCount;
+    m_FreeSizeTree.resize(leafCount * 2);
+    for (size_t i = 0; i < leafCount; ++i)
+    {
+        UINT64 freeSize = 0;
+        if (i < blockCount)
+        {
+            m_Blocks[i]->m_IndexInBlockVector = i;
+            freeSize = m_Blocks[i]->m_pMetadata->GetLargestFreeRegionSizeBound();
         }
+        m_FreeSizeTree[leafCount + i] = freeSize;
     }
-    D3D12MA_ASSERT(0);
+    for (size_t node = leafCount; --node > 0; )
+        m_FreeSizeTree[node] = D3D12MA_MAX(m_FreeSizeTree[node * 2], m_FreeSizeTree[node * 2 + 1]);
 }
 
-void BlockVector::IncrementallySortBlocks()
+size_t BlockVector::FindBlockByFreeSize(size_t firstBlockIndex, UINT64 minFreeSize) const
 {
-    if (!m_IncrementalSort)
-        return;
-    // Bubble sort only until first swap.
-    for (size_t i = 1; i < m_Blocks.size(); ++i)
+    D3D12MA_ASSERT(minFreeSize > 0);
+    if (firstBlockIndex >= m_Blocks.size())
+        return SIZE_MAX;
+
+    // Go up until reaching a subtree that contains a matching leaf, moving right
+    // to the next subtree whenever the current one doesn't.
+    size_t node = m_FreeSizeTreeLeafCount + firstBlockIndex;
+    while (m_FreeSizeTree[node] < minFreeSize)
     {
-        if (m_Blocks[i - 1]->m_pMetadata->GetSumFreeSize() > m_Blocks[i]->m_pMetadata->GetSumFreeSize())
-        {
-            D3D12MA_SWAP(m_Blocks[i - 1], m_Blocks[i]);
-            return;
-        }
+        while (node & 1)
+            node /= 2;
+        if (node == 0)
+            return SIZE_MAX;
+        ++node;
+    }
+    // Go down to the leftmost matching leaf.
+    while (node < m_FreeSizeTreeLeafCount)
+    {
+        node *= 2;
+        if (m_FreeSizeTree[node] < minFreeSize)
+            ++node;
     }
+    return node - m_FreeSizeTreeLeafCount;
 }
 
-void BlockVector::SortByFreeSize()
+UINT64 BlockVector::CalcFreeMemoryInBudget()
 {
-    D3D12MA_SORT(m_Blocks.begin(), m_Blocks.end(),
-        [](auto* b1, auto* b2)
-        {
-            return b1->m_pMetadata->GetSumFreeSize() < b2->m_pMetadata->GetSumFreeSize();
-        });
+    if (!IsHeapTypeStandard(m_HeapProps.Type))
+        return UINT64_MAX;
+
+    Budget budget = {};
+    m_hAllocator->GetBudgetForHeapType(budget, m_HeapProps.Type);
+    return (budget.UsageBytes < budget.BudgetBytes) ? (budget.BudgetBytes - budget.UsageBytes) : 0;
 }
 
 HRESULT BlockVector::AllocatePage(
@@ -8655,21 +13709,17 @@ HRESULT BlockVector::AllocatePage(
     UINT64 alignment,
     const ALLOCATION_DESC& allocDesc,
     bool committedAllowed,
+    UINT64& inoutFreeMemory,
     Allocation** pAllocation)
 {
-    // Early reject: requested allocation size is larger that maximum block size for this block vector.
-    if (size + D3D12MA_DEBUG_MARGIN > m_PreferredBlockSize)
+    // Early reject: requested allocation size is larger that maximum block size or slot size for this block vector.
+    if (size + D3D12MA_DEBUG_MARGIN > m_PreferredBlockSize ||
+        (m_SlotSize > 0 && size + D3D12MA_DEBUG_MARGIN > m_SlotSize))
     {
         return E_OUTOFMEMORY;
     }
 
-    UINT64 freeMemory = UINT64_MAX;
-    if (IsHeapTypeStandard(m_HeapProps.Type))
-    {
-        Budget budget = {};
-        m_hAllocator->GetBudgetForHeapType(budget, m_HeapProps.Type);
-        freeMemory = (budget.UsageBytes < budget.BudgetBytes) ? (budget.BudgetBytes - budget.UsageBytes) : 0;
-    }
+    const UINT64 freeMemory = inoutFreeMemory;
 
     const bool canExceedFreeMemory = !committedAllowed;
 
@@ -8688,7 +13738,10 @@ HRESULT BlockVector::AllocatePage(
     // 1. Search existing allocations
     {
         // Forward order in m_Blocks - prefer blocks with smallest amount of free space.
-        for (size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+        // Blocks whose largest free region is smaller than the requested size are skipped.
+        for (size_t blockIndex = FindBlockByFreeSize(0, size);
+            blockIndex != SIZE_MAX;
+            blockIndex = FindBlockByFreeSize(blockIndex + 1, size))
         {
             NormalBlock* const pCurrBlock = m_Blocks[blockIndex];
             D3D12MA_ASSERT(pCurrBlock);
@@ -8721,7 +13774,7 @@ HRESULT BlockVector::AllocatePage(
             for (UINT i = 0; i < NEW_BLOCK_SIZE_SHIFT_MAX; ++i)
             {
                 const UINT64 smallerNewBlockSize = newBlockSize / 2;
-                if (smallerNewBlockSize > maxExistingBlockSize && smallerNewBlockSize >= size * 2)
+                if (smallerNewBlockSize > maxExistingBlockSize && smallerNewBlockSize >= D3D12MA_MAX(size, m_SlotSize) * 2)
                 {
                     newBlockSize = smallerNewBlockSize;
                     ++newBlockSizeShift;
@@ -8745,7 +13798,7 @@ HRESULT BlockVector::AllocatePage(
             while (FAILED(hr) && newBlockSizeShift < NEW_BLOCK_SIZE_SHIFT_MAX)
             {
                 const UINT64 smallerNewBlockSize = newBlockSize / 2;
-                if (smallerNewBlockSize < size)
+                if (smallerNewBlockSize < D3D12MA_MAX(size, m_SlotSize))
                 {
                     break;
                 }
@@ -8763,6 +13816,7 @@ HRESULT BlockVector::AllocatePage(
         {
             NormalBlock* const pBlock = m_Blocks[newBlockIndex];
             D3D12MA_ASSERT(pBlock->m_pMetadata->GetSize() >= size);
+            inoutFreeMemory = (freeMemory > newBlockSize) ? (freeMemory - newBlockSize) : 0;
 
             hr = AllocateFromBlock(
                 pBlock,
@@ -8825,9 +13879,11 @@ HRESULT BlockVector::CommitAllocationRequest(
 
     *pAllocation = m_hAllocator->GetAllocationObjectAllocator().Allocate(m_hAllocator, size, alignment);
     pBlock->m_pMetadata->Alloc(allocRequest, size, *pAllocation);
+    UpdateFreeSizeIndex(pBlock->m_IndexInBlockVector);
 
     (*pAllocation)->InitPlaced(allocRequest.allocHandle, pBlock);
     (*pAllocation)->SetPrivateData(pPrivateData);
+    RecordAllocationEvent(TRACE_EVENT_TYPE_ALLOCATE, **pAllocation);
 
     D3D12MA_HEAVY_ASSERT(pBlock->Validate());
     m_hAllocator->m_Budget.AddAllocation(m_hAllocator->HeapPropertiesToMemorySegmentGroup(m_HeapProps), size);
@@ -8846,7 +13902,7 @@ HRESULT BlockVector::CreateBlock(
         m_HeapFlags,
         blockSize,
         m_NextBlockId++);
-    HRESULT hr = pBlock->Init(m_Algorithm, m_ProtectedSession, m_DenyMsaaTextures);
+    HRESULT hr = pBlock->Init(m_Algorithm, m_SlotSize, m_ProtectedSession, m_DenyMsaaTextures);
     if (FAILED(hr))
     {
         D3D12MA_DELETE(m_hAllocator->GetAllocs(), pBlock);
@@ -8854,8 +13910,14 @@ HRESULT BlockVector::CreateBlock(
     }
 
     m_hAllocator->SetResidencyPriority(pBlock->GetHeap(), m_ResidencyPriority);
+    RecordBlockEvent(TRACE_EVENT_TYPE_CREATE_BLOCK, *pBlock);
 
     m_Blocks.push_back(pBlock);
+    AttachStatisticsSnapshot(pBlock);
+    if (m_Blocks.size() > m_FreeSizeTreeLeafCount)
+        RebuildFreeSizeIndex();
+    else
+        UpdateFreeSizeIndex(m_Blocks.size() - 1);
     if (pNewBlockIndex != NULL)
     {
         *pNewBlockIndex = m_Blocks.size() - 1;
@@ -9026,6 +14088,13 @@ HRESULT DefragmentationContextPimpl::DefragmentPassEnd(DEFRAGMENTATION_PASS_MOVE
         case DEFRAGMENTATION_MOVE_OPERATION_COPY:
         {
             move.pSrcAllocation->SwapBlockAllocation(move.pDstTmpAllocation);
+            if (TraceRing* const trace = vector->m_hAllocator->GetTrace())
+            {
+                trace->Record(TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE, vector->GetHeapProperties().Type, vector->GetId(),
+                    move.pSrcAllocation->GetBlock()->GetId(), SnapshotPimpl::GetAllocationId(*move.pSrcAllocation),
+                    move.pSrcAllocation->GetOffset(), move.pSrcAllocation->GetSize(),
+                    SnapshotPimpl::GetAllocationId(*move.pDstTmpAllocation));
+            }
 
             // Scope for locks, Free have it's own lock
             {
@@ -9129,7 +14198,7 @@ HRESULT DefragmentationContextPimpl::DefragmentPassEnd(DEFRAGMENTATION_PASS_MOVE
             {
                 if (vector->GetBlock(i) == block.block)
                 {
-                    D3D12MA_SWAP(vector->m_Blocks[i], vector->m_Blocks[m_ImmovableBlockCount++]);
+                    vector->SwapBlocks(i, m_ImmovableBlockCount++);
                     break;
                 }
             }
@@ -9201,7 +14270,7 @@ bool DefragmentationContextPimpl::ReallocWithinBlock(BlockVector& vector, Normal
     {
         MoveAllocationData moveData = GetMoveData(handle, metadata);
         // Ignore newly created allocations by defragmentation algorithm
-        if (moveData.move.pSrcAllocation->GetPrivateData() == this)
+        if (!IsMovable(*moveData.move.pSrcAllocation))
             continue;
         switch (CheckCounters(moveData.move.pSrcAllocation->GetSize()))
         {
@@ -9216,7 +14285,7 @@ bool DefragmentationContextPimpl::ReallocWithinBlock(BlockVector& vector, Normal
         }
         
         UINT64 offset = moveData.move.pSrcAllocation->GetOffset();
-        if (offset != 0 && metadata->GetSumFreeSize() >= moveData.size)
+        if (offset != 0 && metadata->GetLargestFreeRegionSizeBound() >= moveData.size)
         {
             AllocationRequest request = {};
             if (metadata->CreateAllocationRequest(
@@ -9252,7 +14321,7 @@ bool DefragmentationContextPimpl::AllocInOtherBlock(size_t start, size_t end, Mo
     for (; start < end; ++start)
     {
         NormalBlock* dstBlock = vector.GetBlock(start);
-        if (dstBlock->m_pMetadata->GetSumFreeSize() >= data.size)
+        if (dstBlock->m_pMetadata->GetLargestFreeRegionSizeBound() >= data.size)
         {
             if (SUCCEEDED(vector.AllocateFromBlock(dstBlock,
                 data.size,
@@ -9287,7 +14356,7 @@ bool DefragmentationContextPimpl::ComputeDefragmentation_Fast(BlockVector& vecto
         {
             MoveAllocationData moveData = GetMoveData(handle, metadata);
             // Ignore newly created allocations by defragmentation algorithm
-            if (moveData.move.pSrcAllocation->GetPrivateData() == this)
+            if (!IsMovable(*moveData.move.pSrcAllocation))
                 continue;
             switch (CheckCounters(moveData.move.pSrcAllocation->GetSize()))
             {
@@ -9334,7 +14403,7 @@ bool DefragmentationContextPimpl::ComputeDefragmentation_Balanced(BlockVector& v
         {
             MoveAllocationData moveData = GetMoveData(handle, metadata);
             // Ignore newly created allocations by defragmentation algorithm
-            if (moveData.move.pSrcAllocation->GetPrivateData() == this)
+            if (!IsMovable(*moveData.move.pSrcAllocation))
                 continue;
             switch (CheckCounters(moveData.move.pSrcAllocation->GetSize()))
             {
@@ -9356,7 +14425,7 @@ bool DefragmentationContextPimpl::ComputeDefragmentation_Balanced(BlockVector& v
             UINT64 nextFreeRegionSize = metadata->GetNextFreeRegionSize(handle);
             // If no room found then realloc within block for lower offset
             UINT64 offset = moveData.move.pSrcAllocation->GetOffset();
-            if (prevMoveCount == m_Moves.size() && offset != 0 && metadata->GetSumFreeSize() >= moveData.size)
+            if (prevMoveCount == m_Moves.size() && offset != 0 && metadata->GetLargestFreeRegionSizeBound() >= moveData.size)
             {
                 // Check if realloc will make sense
                 if (prevFreeRegionSize >= minimalFreeRegion ||
@@ -9419,7 +14488,7 @@ bool DefragmentationContextPimpl::ComputeDefragmentation_Full(BlockVector& vecto
         {
             MoveAllocationData moveData = GetMoveData(handle, metadata);
             // Ignore newly created allocations by defragmentation algorithm
-            if (moveData.move.pSrcAllocation->GetPrivateData() == this)
+            if (!IsMovable(*moveData.move.pSrcAllocation))
                 continue;
             switch (CheckCounters(moveData.move.pSrcAllocation->GetSize()))
             {
@@ -9440,7 +14509,7 @@ bool DefragmentationContextPimpl::ComputeDefragmentation_Full(BlockVector& vecto
 
             // If no room found then realloc within block for lower offset
             UINT64 offset = moveData.move.pSrcAllocation->GetOffset();
-            if (prevMoveCount == m_Moves.size() && offset != 0 && metadata->GetSumFreeSize() >= moveData.size)
+            if (prevMoveCount == m_Moves.size() && offset != 0 && metadata->GetLargestFreeRegionSizeBound() >= moveData.size)
             {
                 AllocationRequest request = {};
                 if (metadata->CreateAllocationRequest(
@@ -9517,7 +14586,8 @@ PoolPimpl::PoolPimpl(AllocatorPimpl* allocator, const POOL_DESC& desc)
         desc.MinBlockCount, maxBlockCount,
         explicitBlockSize,
         minAlignment,
-        (desc.Flags & POOL_FLAG_ALGORITHM_MASK) != 0,
+        desc.Flags & POOL_FLAG_ALGORITHM_MASK,
+        desc.SlotSize,
         (desc.Flags & POOL_FLAG_MSAA_TEXTURES_ALWAYS_COMMITTED) != 0,
         desc.pProtectedSession,
         desc.ResidencyPriority);
@@ -9532,7 +14602,12 @@ PoolPimpl::~PoolPimpl()
 
 HRESULT PoolPimpl::Init()
 {
-    m_CommittedAllocations.Init(m_Allocator->UseMutex(), m_Desc.HeapProperties.Type, this);
+    m_CommittedAllocations.Init(
+        m_Allocator->UseMutex(),
+        m_Allocator->UseLockFreeStatistics(),
+        m_Desc.HeapProperties.Type,
+        this);
+    m_CommittedAllocations.SetLockProfile(m_Allocator->GetLockProfile(LOCK_NAME_COMMITTED_ALLOCATION_LIST));
     return m_BlockVector->CreateMinBlocks();
 }
 
@@ -9578,6 +14653,220 @@ void PoolPimpl::FreeName()
 }
 #endif // _D3D12MA_POOL_PIMPL_FUNCTIONS
 
+#ifndef _D3D12MA_BUFFER_SUBALLOCATOR_FUNCTIONS
+SharedBuffer::SharedBuffer(BufferSubAllocator* owner, UINT sizeClass, Allocation* allocation, BlockMetadata* metadata)
+    : m_Owner(owner),
+    m_SizeClass(sizeClass),
+    m_Allocation(allocation),
+    m_Metadata(metadata) {}
+
+BufferSubAllocator::BufferSubAllocator(AllocatorPimpl* allocator, D3D12_HEAP_TYPE heapType)
+    : m_Allocator(allocator),
+    m_HeapType(heapType) {}
+
+BufferSubAllocator::~BufferSubAllocator()
+{
+    for (UINT sizeClass = 0; sizeClass <= GENERAL_SIZE_CLASS; ++sizeClass)
+    {
+        SizeClass& currSizeClass = m_SizeClasses[sizeClass];
+        if (currSizeClass.EmptyBufferCount != currSizeClass.BufferCount)
+        {
+            D3D12MA_ASSERT(0 && "Unfreed buffer suballocations found!");
+        }
+        while (!currSizeClass.AvailableBuffers.IsEmpty())
+            DestroySharedBuffer(currSizeClass.AvailableBuffers.PopBack());
+    }
+}
+
+void BufferSubAllocator::SetLockProfile(LockProfile* profile)
+{
+    for (UINT sizeClass = 0; sizeClass <= GENERAL_SIZE_CLASS; ++sizeClass)
+        BindLockProfile(m_SizeClasses[sizeClass].AccessMutex, profile);
+}
+
+HRESULT BufferSubAllocator::Allocate(UINT64 size, UINT64 alignment, ALLOCATION_FLAGS flags,
+    void* pPrivateData, Allocation** ppAllocation)
+{
+    D3D12MA_ASSERT(size > 0 && IsPow2(alignment) && alignment <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    UINT sizeClass = 0;
+    while (sizeClass < SIZE_CLASS_COUNT && GetSlotSize(sizeClass) < D3D12MA_MAX(size, alignment))
+        ++sizeClass;
+    SizeClass& currSizeClass = m_SizeClasses[sizeClass];
+
+    {
+        MutexLock lock(currSizeClass.AccessMutex, m_Allocator->UseMutex());
+        AllocationRequest request = {};
+        if (SharedBuffer* const buffer = FindSharedBuffer(sizeClass, size, alignment, request))
+        {
+            *ppAllocation = AllocateFromBuffer(buffer, request, size, alignment, pPrivateData);
+            return S_OK;
+        }
+    }
+
+    // Created outside of the lock, as it takes the lock of the default pool and creates a resource,
+    // which would block all other allocations and frees in this size class meanwhile.
+    const UINT64 bufferSize = sizeClass < GENERAL_SIZE_CLASS ? GetBufferSize(sizeClass) :
+        D3D12MA_MAX((UINT64)GENERAL_BUFFER_SIZE, AlignUp(size, (UINT64)D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+    SharedBuffer* newBuffer = NULL;
+    const HRESULT hr = CreateSharedBuffer(sizeClass, bufferSize, flags, newBuffer);
+    if (FAILED(hr))
+        return hr;
+    AllocationRequest request = {};
+    if (!newBuffer->m_Metadata->CreateAllocationRequest(size, alignment, false,
+        ALLOCATION_FLAG_STRATEGY_MIN_TIME, &request))
+    {
+        D3D12MA_ASSERT(0 && "New shared buffer too small for the range.");
+        DestroySharedBuffer(newBuffer);
+        return E_OUTOFMEMORY;
+    }
+
+    MutexLock lock(currSizeClass.AccessMutex, m_Allocator->UseMutex());
+    currSizeClass.AvailableBuffers.PushBack(newBuffer);
+    ++currSizeClass.BufferCount;
+    ++currSizeClass.EmptyBufferCount;
+    *ppAllocation = AllocateFromBuffer(newBuffer, request, size, alignment, pPrivateData);
+    return S_OK;
+}
+
+void BufferSubAllocator::Free(Allocation* allocation)
+{
+    D3D12MA_ASSERT(allocation && allocation->m_PackedData.GetType() == Allocation::TYPE_BUFFER_RANGE);
+
+    SharedBuffer* const buffer = allocation->m_BufferRange.buffer;
+    SizeClass& currSizeClass = m_SizeClasses[buffer->m_SizeClass];
+    SharedBuffer* bufferToDestroy = NULL;
+    {
+        MutexLock lock(currSizeClass.AccessMutex, m_Allocator->UseMutex());
+
+        if (buffer->m_Metadata->GetLargestFreeRegionSizeBound() == 0)
+            currSizeClass.AvailableBuffers.PushBack(buffer);
+        buffer->m_Metadata->Free(allocation->m_BufferRange.allocHandle);
+
+        if (buffer->m_Metadata->IsEmpty())
+        {
+            // Keep one empty buffer to avoid creating and destroying it over and over,
+            // unless it was created bigger than usual for a single large range.
+            const bool oversized = buffer->m_SizeClass == GENERAL_SIZE_CLASS &&
+                buffer->m_Metadata->GetSize() > GENERAL_BUFFER_SIZE;
+            if (currSizeClass.EmptyBufferCount > 0 || oversized)
+            {
+                currSizeClass.AvailableBuffers.Remove(buffer);
+                --currSizeClass.BufferCount;
+                bufferToDestroy = buffer;
+            }
+            else
+                ++currSizeClass.EmptyBufferCount;
+        }
+    }
+    // Destroyed outside of the lock, as it takes the lock of the default pool.
+    if (bufferToDestroy != NULL)
+        DestroySharedBuffer(bufferToDestroy);
+}
+
+SharedBuffer* BufferSubAllocator::FindSharedBuffer(UINT sizeClass, UINT64 size, UINT64 alignment,
+    AllocationRequest& outRequest)
+{
+    SizeClass& currSizeClass = m_SizeClasses[sizeClass];
+    if (sizeClass < GENERAL_SIZE_CLASS)
+    {
+        // Slot sizes are powers of 2 not smaller than the alignment, so every free slot fits.
+        SharedBuffer* const buffer = currSizeClass.AvailableBuffers.Back();
+        if (buffer != NULL && buffer->m_Metadata->CreateAllocationRequest(size, alignment, false,
+            ALLOCATION_FLAG_STRATEGY_MIN_TIME, &outRequest))
+        {
+            return buffer;
+        }
+        return NULL;
+    }
+
+    for (SharedBuffer* buffer = currSizeClass.AvailableBuffers.Back();
+        buffer != NULL;
+        buffer = SharedBufferList::GetPrev(buffer))
+    {
+        if (buffer->m_Metadata->CreateAllocationRequest(size, alignment, false,
+            ALLOCATION_FLAG_STRATEGY_MIN_TIME, &outRequest))
+        {
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+Allocation* BufferSubAllocator::AllocateFromBuffer(SharedBuffer* buffer, const AllocationRequest& request,
+    UINT64 size, UINT64 alignment, void* pPrivateData)
+{
+    SizeClass& currSizeClass = m_SizeClasses[buffer->m_SizeClass];
+    if (buffer->m_Metadata->IsEmpty())
+        --currSizeClass.EmptyBufferCount;
+
+    Allocation* const allocation = m_Allocator->GetAllocationObjectAllocator().Allocate(m_Allocator, size, alignment);
+    buffer->m_Metadata->Alloc(request, size, allocation);
+    if (buffer->m_Metadata->GetLargestFreeRegionSizeBound() == 0)
+        currSizeClass.AvailableBuffers.Remove(buffer);
+
+    allocation->InitBufferRange(request.allocHandle, buffer);
+    allocation->SetPrivateData(pPrivateData);
+    allocation->m_PackedData.SetResourceDimension(D3D12_RESOURCE_DIMENSION_BUFFER);
+    allocation->m_Resource = buffer->m_Allocation->GetResource();
+    allocation->m_Resource->AddRef();
+    return allocation;
+}
+
+HRESULT BufferSubAllocator::CreateSharedBuffer(UINT sizeClass, UINT64 bufferSize, ALLOCATION_FLAGS flags,
+    SharedBuffer*& outBuffer)
+{
+    D3D12_RESOURCE_DESC resourceDesc = {};
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    resourceDesc.Width = bufferSize;
+    resourceDesc.Height = 1;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON;
+    if (m_HeapType == D3D12_HEAP_TYPE_UPLOAD || m_HeapType == D3D12_HEAP_TYPE_GPU_UPLOAD_COPY)
+        initialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+    else if (m_HeapType == D3D12_HEAP_TYPE_READBACK)
+        initialState = D3D12_RESOURCE_STATE_COPY_DEST;
+
+    ALLOCATION_DESC allocDesc = {};
+    allocDesc.Flags = (ALLOCATION_FLAGS)(flags & (ALLOCATION_FLAG_WITHIN_BUDGET | ALLOCATION_FLAG_NEVER_ALLOCATE));
+    allocDesc.HeapType = m_HeapType;
+
+    Allocation* allocation = NULL;
+    const HRESULT hr = m_Allocator->CreateResource(&allocDesc,
+        CREATE_RESOURCE_PARAMS(&resourceDesc, initialState, NULL), &allocation, IID_NULL, NULL);
+    if (FAILED(hr))
+        return hr;
+    // Ranges of it refer to its resource.
+    allocation->m_PackedData.SetImmovable();
+
+    const ALLOCATION_CALLBACKS& allocs = m_Allocator->GetAllocs();
+    BlockMetadata* metadata = NULL;
+    if (sizeClass < GENERAL_SIZE_CLASS)
+        metadata = D3D12MA_NEW(allocs, BlockMetadata_Slab)(&allocs, true, GetSlotSize(sizeClass));
+    else
+        metadata = D3D12MA_NEW(allocs, BlockMetadata_TLSF)(&allocs, true);
+    metadata->Init(bufferSize);
+
+    outBuffer = D3D12MA_NEW(allocs, SharedBuffer)(this, sizeClass, allocation, metadata);
+    return S_OK;
+}
+
+void BufferSubAllocator::DestroySharedBuffer(SharedBuffer* buffer)
+{
+    Allocation* const allocation = buffer->m_Allocation;
+    D3D12MA_DELETE(m_Allocator->GetAllocs(), buffer->m_Metadata);
+    D3D12MA_DELETE(m_Allocator->GetAllocs(), buffer);
+    // Not calling public Release(), as callers already hold the debug global mutex.
+    if (allocation->ReleaseRef() == 0)
+        allocation->ReleaseThis();
+}
+#endif // _D3D12MA_BUFFER_SUBALLOCATOR_FUNCTIONS
+
 
 #ifndef _D3D12MA_PUBLIC_INTERFACE
 HRESULT CreateAllocator(const ALLOCATOR_DESC* pDesc, Allocator** ppAllocator)
@@ -9606,11 +14895,18 @@ HRESULT CreateAllocator(const ALLOCATOR_DESC* pDesc, Allocator** ppAllocator)
 
 HRESULT CreateVirtualBlock(const VIRTUAL_BLOCK_DESC* pDesc, VirtualBlock** ppVirtualBlock)
 {
-    if (!pDesc || !ppVirtualBlock)
+    if (!pDesc || !ppVirtualBlock ||
+        !IsPow2(pDesc->Flags & VIRTUAL_BLOCK_FLAG_ALGORITHM_MASK))
     {
         D3D12MA_ASSERT(0 && "Invalid arguments passed to CreateVirtualBlock.");
         return E_INVALIDARG;
     }
+    if ((pDesc->Flags & VIRTUAL_BLOCK_FLAG_ALGORITHM_MASK) == VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB &&
+        (pDesc->SlotSize == 0 || pDesc->SlotSize > pDesc->Size))
+    {
+        D3D12MA_ASSERT(0 && "Invalid SlotSize passed to CreateVirtualBlock while VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB is specified.");
+        return E_INVALIDARG;
+    }
 
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
 
@@ -9656,7 +14952,7 @@ ULONG STDMETHODCALLTYPE IUnknownImpl::Release()
 void Allocation::PackedData::SetType(Type type)
 {
     const UINT u = (UINT)type;
-    D3D12MA_ASSERT(u < (1u << 2));
+    D3D12MA_ASSERT(u < (1u << 3));
     m_Type = u;
 }
 
@@ -9690,12 +14986,26 @@ UINT64 Allocation::GetOffset() const
         return 0;
     case TYPE_PLACED:
         return m_Placed.block->m_pMetadata->GetAllocationOffset(m_Placed.allocHandle);
+    case TYPE_BUFFER_RANGE:
+        return m_BufferRange.buffer->m_Allocation->GetOffset() + GetBufferOffset();
     default:
         D3D12MA_ASSERT(0);
         return 0;
     }
 }
 
+UINT64 Allocation::GetBufferOffset() const
+{
+    if (m_PackedData.GetType() == TYPE_BUFFER_RANGE)
+        return m_BufferRange.buffer->m_Metadata->GetAllocationOffset(m_BufferRange.allocHandle);
+    return 0;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS Allocation::GetGPUVirtualAddress() const
+{
+    return m_Resource != NULL ? m_Resource->GetGPUVirtualAddress() + GetBufferOffset() : 0;
+}
+
 void Allocation::SetResource(ID3D12Resource* pResource)
 {
     if (pResource != m_Resource)
@@ -9718,6 +15028,8 @@ ID3D12Heap* Allocation::GetHeap() const
         return m_Placed.block->GetHeap();
     case TYPE_HEAP:
         return m_Heap.heap;
+    case TYPE_BUFFER_RANGE:
+        return m_BufferRange.buffer->m_Allocation->GetHeap();
     default:
         D3D12MA_ASSERT(0);
         return 0;
@@ -9738,6 +15050,9 @@ void Allocation::SetName(LPCWSTR Name)
 
 void Allocation::ReleaseThis()
 {
+    PerformanceCounterSet* const counters = m_Allocator->GetPerformanceCounterSet();
+    PerformanceTimer timer(counters, PERFORMANCE_COUNTER_OPERATION_FREE,
+        counters != NULL ? AllocatorPimpl::GetAllocationHeapType(*this) : D3D12_HEAP_TYPE_DEFAULT);
     SAFE_RELEASE(m_Resource);
 
     switch (m_PackedData.GetType())
@@ -9751,6 +15066,11 @@ void Allocation::ReleaseThis()
     case TYPE_HEAP:
         m_Allocator->FreeHeapMemory(this);
         break;
+    case TYPE_BUFFER_RANGE:
+        m_Allocator->FreeBufferRange(this);
+        break;
+    default:
+        D3D12MA_ASSERT(0);
     }
 
     FreeName();
@@ -9772,6 +15092,7 @@ Allocation::Allocation(AllocatorPimpl* allocator, UINT64 size, UINT64 alignment)
     m_PackedData.SetResourceDimension(D3D12_RESOURCE_DIMENSION_UNKNOWN);
     m_PackedData.SetResourceFlags(D3D12_RESOURCE_FLAG_NONE);
     m_PackedData.SetTextureLayout(D3D12_TEXTURE_LAYOUT_UNKNOWN);
+    m_PackedData.SetCreationEpoch(allocator->GetSnapshotEpoch());
 }
 
 void Allocation::InitCommitted(CommittedAllocationList* list)
@@ -9798,6 +15119,13 @@ void Allocation::InitHeap(CommittedAllocationList* list, ID3D12Heap* heap)
     m_Heap.heap = heap;
 }
 
+void Allocation::InitBufferRange(AllocHandle allocHandle, SharedBuffer* buffer)
+{
+    m_PackedData.SetType(TYPE_BUFFER_RANGE);
+    m_BufferRange.allocHandle = allocHandle;
+    m_BufferRange.buffer = buffer;
+}
+
 void Allocation::SwapBlockAllocation(Allocation* allocation)
 {
     D3D12MA_ASSERT(allocation != NULL);
@@ -9816,6 +15144,7 @@ AllocHandle Allocation::GetAllocHandle() const
     {
     case TYPE_COMMITTED:
     case TYPE_HEAP:
+    case TYPE_BUFFER_RANGE:
         return (AllocHandle)0;
     case TYPE_PLACED:
         return m_Placed.allocHandle;
@@ -9831,6 +15160,7 @@ NormalBlock* Allocation::GetBlock()
     {
     case TYPE_COMMITTED:
     case TYPE_HEAP:
+    case TYPE_BUFFER_RANGE:
         return NULL;
     case TYPE_PLACED:
         return m_Placed.block;
@@ -9927,6 +15257,11 @@ LPCWSTR Pool::GetName() const
     return m_Pimpl->GetName();
 }
 
+UINT Pool::GetId() const
+{
+    return m_Pimpl->GetBlockVector()->GetId();
+}
+
 HRESULT Pool::BeginDefragmentation(const DEFRAGMENTATION_DESC* pDesc, DefragmentationContext** ppContext)
 {
     D3D12MA_ASSERT(pDesc && ppContext);
@@ -10078,6 +15413,81 @@ HRESULT Allocator::AllocateMemory(
     return m_Pimpl->AllocateMemory(pAllocDesc, pAllocInfo, ppAllocation);
 }
 
+HRESULT Allocator::AllocateMemoryBatch(
+    UINT AllocationCount,
+    const ALLOCATION_DESC* pAllocDescs,
+    const D3D12_RESOURCE_ALLOCATION_INFO* pAllocInfos,
+    Allocation** ppAllocations)
+{
+    bool valid = AllocationCount == 0 || (pAllocDescs && pAllocInfos && ppAllocations);
+    for (UINT i = 0; valid && i < AllocationCount; ++i)
+    {
+        valid = ValidateAllocateMemoryParameters(&pAllocDescs[i], &pAllocInfos[i], &ppAllocations[i]);
+    }
+    if (!valid)
+    {
+        D3D12MA_ASSERT(0 && "Invalid arguments passed to Allocator::AllocateMemoryBatch.");
+        return E_INVALIDARG;
+    }
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    return m_Pimpl->AllocateMemoryBatch(AllocationCount, pAllocDescs, pAllocInfos, ppAllocations);
+}
+
+void Allocator::FreeAllocations(
+    UINT AllocationCount,
+    Allocation* const* ppAllocations)
+{
+    if (AllocationCount > 0 && !ppAllocations)
+    {
+        D3D12MA_ASSERT(0 && "Invalid arguments passed to Allocator::FreeAllocations.");
+        return;
+    }
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    m_Pimpl->FreeAllocations(AllocationCount, ppAllocations);
+}
+
+HRESULT Allocator::CreateBufferSubAllocation(
+    const ALLOCATION_DESC* pAllocDesc,
+    UINT64 Size,
+    UINT64 Alignment,
+    Allocation** ppAllocation)
+{
+    if (!pAllocDesc || !ppAllocation || pAllocDesc->CustomPool != NULL ||
+        !IsHeapTypeStandard(pAllocDesc->HeapType) ||
+        Size == 0 || Size > UINT64_MAX - (D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) ||
+        (Alignment != 0 && !IsPow2(Alignment)) ||
+        Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        D3D12MA_ASSERT(0 && "Invalid arguments passed to Allocator::CreateBufferSubAllocation.");
+        return E_INVALIDARG;
+    }
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    return m_Pimpl->CreateBufferSubAllocation(pAllocDesc, Size, Alignment, ppAllocation);
+}
+
+HRESULT Allocator::CreateResourceBatch(
+    UINT ResourceCount,
+    const ALLOCATION_DESC* pAllocDescs,
+    const D3D12_RESOURCE_DESC* pResourceDescs,
+    const D3D12_RESOURCE_STATES* pInitialResourceStates,
+    const D3D12_CLEAR_VALUE* const* ppOptimizedClearValues,
+    Allocation** ppAllocations)
+{
+    bool valid = ResourceCount == 0 || (pAllocDescs && pResourceDescs && pInitialResourceStates && ppAllocations);
+    for (UINT i = 0; valid && i < ResourceCount; ++i)
+    {
+        valid = ValidateCreateResourceParameters(&pAllocDescs[i], &pResourceDescs[i], &ppAllocations[i]);
+    }
+    if (!valid)
+    {
+        D3D12MA_ASSERT(0 && "Invalid arguments passed to Allocator::CreateResourceBatch.");
+        return E_INVALIDARG;
+    }
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    return m_Pimpl->CreateResourceBatch(ResourceCount, pAllocDescs, pResourceDescs,
+        pInitialResourceStates, ppOptimizedClearValues, ppAllocations);
+}
+
 HRESULT Allocator::CreateAliasingResource(
     Allocation* pAllocation,
     UINT64 AllocationLocalOffset,
@@ -10159,11 +15569,20 @@ HRESULT Allocator::CreatePool(
 {
     if (!pPoolDesc || !ppPool ||
         (pPoolDesc->MaxBlockCount > 0 && pPoolDesc->MaxBlockCount < pPoolDesc->MinBlockCount) ||
-        (pPoolDesc->MinAllocationAlignment > 0 && !IsPow2(pPoolDesc->MinAllocationAlignment)))
+        (pPoolDesc->MinAllocationAlignment > 0 && !IsPow2(pPoolDesc->MinAllocationAlignment)) ||
+        !IsPow2(pPoolDesc->Flags & POOL_FLAG_ALGORITHM_MASK))
     {
         D3D12MA_ASSERT(0 && "Invalid arguments passed to Allocator::CreatePool.");
         return E_INVALIDARG;
     }
+    // Same block size as chosen by PoolPimpl when BlockSize is not specified.
+    const UINT64 poolBlockSize = pPoolDesc->BlockSize != 0 ? pPoolDesc->BlockSize : D3D12MA_DEFAULT_BLOCK_SIZE;
+    if ((pPoolDesc->Flags & POOL_FLAG_ALGORITHM_MASK) == POOL_FLAG_ALGORITHM_SLAB &&
+        (pPoolDesc->SlotSize == 0 || pPoolDesc->SlotSize > poolBlockSize))
+    {
+        D3D12MA_ASSERT(0 && "Invalid SlotSize passed to Allocator::CreatePool while POOL_FLAG_ALGORITHM_SLAB is specified.");
+        return E_INVALIDARG;
+    }
     if ((pPoolDesc->Flags & POOL_FLAG_ALWAYS_COMMITTED) != 0 &&
         (pPoolDesc->BlockSize != 0 || pPoolDesc->MinBlockCount > 0))
     {
@@ -10196,6 +15615,20 @@ void Allocator::SetCurrentFrameIndex(UINT frameIndex)
     m_Pimpl->SetCurrentFrameIndex(frameIndex);
 }
 
+void Allocator::ReleaseDeferred(Allocation* pAllocation, UINT FrameIndex)
+{
+    if (pAllocation == NULL)
+        return;
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    m_Pimpl->ReleaseDeferred(pAllocation, FrameIndex);
+}
+
+void Allocator::ReleaseAllDeferred()
+{
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    m_Pimpl->ReleaseAllDeferred();
+}
+
 void Allocator::GetBudget(Budget* pLocalBudget, Budget* pNonLocalBudget)
 {
     if (pLocalBudget == NULL && pNonLocalBudget == NULL)
@@ -10206,6 +15639,26 @@ void Allocator::GetBudget(Budget* pLocalBudget, Budget* pNonLocalBudget)
     m_Pimpl->GetBudget(pLocalBudget, pNonLocalBudget);
 }
 
+HRESULT Allocator::UpdateBudget()
+{
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    return m_Pimpl->UpdateBudget();
+}
+
+void Allocator::GetPerformanceCounters(PerformanceCounters* pCounters) const
+{
+    D3D12MA_ASSERT(pCounters);
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    m_Pimpl->GetPerformanceCounters(*pCounters);
+}
+
+void Allocator::GetResourceAllocationInfoCacheStatistics(ResourceAllocationInfoCacheStatistics* pStats) const
+{
+    D3D12MA_ASSERT(pStats);
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    m_Pimpl->GetResourceAllocationInfoCacheStatistics(*pStats);
+}
+
 void Allocator::CalculateStatistics(TotalStatistics* pStats)
 {
     D3D12MA_ASSERT(pStats);
@@ -10220,6 +15673,55 @@ void Allocator::BuildStatsString(WCHAR** ppStatsString, BOOL DetailedMap) const
     m_Pimpl->BuildStatsString(ppStatsString, DetailedMap);
 }
 
+void Allocator::WriteStatsString(
+    WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+    void* pPrivateData,
+    STATS_STRING_ENCODING Encoding,
+    BOOL DetailedMap) const
+{
+    D3D12MA_ASSERT(pWriteFunc);
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    m_Pimpl->WriteStatsString(pWriteFunc, pPrivateData, Encoding, DetailedMap);
+}
+
+void Allocator::WriteStatsBinary(
+    WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+    void* pPrivateData,
+    BOOL DetailedMap) const
+{
+    D3D12MA_ASSERT(pWriteFunc);
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    m_Pimpl->WriteStatsBinary(pWriteFunc, pPrivateData, DetailedMap);
+}
+
+HRESULT Allocator::CreateSnapshot(Snapshot** ppSnapshot)
+{
+    if (!ppSnapshot)
+    {
+        D3D12MA_ASSERT(0 && "Invalid arguments passed to Allocator::CreateSnapshot.");
+        return E_INVALIDARG;
+    }
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+    *ppSnapshot = D3D12MA_NEW(m_Pimpl->GetAllocs(), Snapshot)(m_Pimpl->GetAllocs());
+    m_Pimpl->AddToSnapshot(*(*ppSnapshot)->m_Pimpl);
+    return S_OK;
+}
+
+UINT Allocator::GetTraceEvents(UINT64* pNextSequenceNumber, TRACE_EVENT* pEvents, UINT MaxEventCount) const
+{
+    D3D12MA_ASSERT(pNextSequenceNumber && (pEvents || MaxEventCount == 0));
+    return m_Pimpl->GetTraceEvents(*pNextSequenceNumber, pEvents, MaxEventCount);
+}
+
+void Allocator::WriteTraceEvents(
+    UINT64* pNextSequenceNumber,
+    WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+    void* pPrivateData) const
+{
+    D3D12MA_ASSERT(pNextSequenceNumber && pWriteFunc);
+    m_Pimpl->WriteTraceEvents(*pNextSequenceNumber, pWriteFunc, pPrivateData);
+}
+
 void Allocator::FreeStatsString(WCHAR* pStatsString) const
 {
     if (pStatsString != NULL)
@@ -10256,7 +15758,7 @@ Allocator::~Allocator()
 BOOL VirtualBlock::IsEmpty() const
 {
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
-    return m_Pimpl->m_Metadata->IsEmpty() ? TRUE : FALSE;
+    return m_Pimpl->IsEmpty() ? TRUE : FALSE;
 }
 
 void VirtualBlock::GetAllocationInfo(VirtualAllocation allocation, VIRTUAL_ALLOCATION_INFO* pInfo) const
@@ -10264,7 +15766,10 @@ void VirtualBlock::GetAllocationInfo(VirtualAllocation allocation, VIRTUAL_ALLOC
     D3D12MA_ASSERT(allocation.AllocHandle != (AllocHandle)0 && pInfo);
 
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
-    m_Pimpl->m_Metadata->GetAllocationInfo(allocation.AllocHandle, *pInfo);
+    VirtualBlockPimpl::Shard& shard = m_Pimpl->GetShard(allocation.AllocHandle);
+    MutexLock lock(shard.AllocMutex, m_Pimpl->m_UseMutex);
+    shard.Metadata->GetAllocationInfo(m_Pimpl->GetMetadataHandle(allocation.AllocHandle), *pInfo);
+    pInfo->Offset += shard.Offset;
 }
 
 HRESULT VirtualBlock::Allocate(const VIRTUAL_ALLOCATION_DESC* pDesc, VirtualAllocation* pAllocation, UINT64* pOffset)
@@ -10277,21 +15782,11 @@ HRESULT VirtualBlock::Allocate(const VIRTUAL_ALLOCATION_DESC* pDesc, VirtualAllo
 
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
 
-    const UINT64 alignment = pDesc->Alignment != 0 ? pDesc->Alignment : 1;
-    AllocationRequest allocRequest = {};
-    if (m_Pimpl->m_Metadata->CreateAllocationRequest(
-        pDesc->Size,
-        alignment,
-        pDesc->Flags & VIRTUAL_ALLOCATION_FLAG_UPPER_ADDRESS,
-        pDesc->Flags & VIRTUAL_ALLOCATION_FLAG_STRATEGY_MASK,
-        &allocRequest))
+    UINT64 offset = UINT64_MAX;
+    if (SUCCEEDED(m_Pimpl->Allocate(*pDesc, pAllocation->AllocHandle, offset)))
     {
-        m_Pimpl->m_Metadata->Alloc(allocRequest, pDesc->Size, pDesc->pPrivateData);
-        D3D12MA_HEAVY_ASSERT(m_Pimpl->m_Metadata->Validate());
-        pAllocation->AllocHandle = allocRequest.allocHandle;
-
         if (pOffset)
-            *pOffset = m_Pimpl->m_Metadata->GetAllocationOffset(allocRequest.allocHandle);
+            *pOffset = offset;
         return S_OK;
     }
 
@@ -10309,16 +15804,23 @@ void VirtualBlock::FreeAllocation(VirtualAllocation allocation)
 
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
 
-    m_Pimpl->m_Metadata->Free(allocation.AllocHandle);
-    D3D12MA_HEAVY_ASSERT(m_Pimpl->m_Metadata->Validate());
+    VirtualBlockPimpl::Shard& shard = m_Pimpl->GetShard(allocation.AllocHandle);
+    MutexLock lock(shard.AllocMutex, m_Pimpl->m_UseMutex);
+    shard.Metadata->Free(m_Pimpl->GetMetadataHandle(allocation.AllocHandle));
+    D3D12MA_HEAVY_ASSERT(shard.Metadata->Validate());
 }
 
 void VirtualBlock::Clear()
 {
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
 
-    m_Pimpl->m_Metadata->Clear();
-    D3D12MA_HEAVY_ASSERT(m_Pimpl->m_Metadata->Validate());
+    for (UINT i = 0; i < m_Pimpl->m_ShardCount; ++i)
+    {
+        VirtualBlockPimpl::Shard& shard = m_Pimpl->m_Shards[i];
+        MutexLock lock(shard.AllocMutex, m_Pimpl->m_UseMutex);
+        shard.Metadata->Clear();
+        D3D12MA_HEAVY_ASSERT(shard.Metadata->Validate());
+    }
 }
 
 void VirtualBlock::SetAllocationPrivateData(VirtualAllocation allocation, void* pPrivateData)
@@ -10326,25 +15828,37 @@ void VirtualBlock::SetAllocationPrivateData(VirtualAllocation allocation, void*
     D3D12MA_ASSERT(allocation.AllocHandle != (AllocHandle)0);
 
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
-    m_Pimpl->m_Metadata->SetAllocationPrivateData(allocation.AllocHandle, pPrivateData);
+    VirtualBlockPimpl::Shard& shard = m_Pimpl->GetShard(allocation.AllocHandle);
+    MutexLock lock(shard.AllocMutex, m_Pimpl->m_UseMutex);
+    shard.Metadata->SetAllocationPrivateData(m_Pimpl->GetMetadataHandle(allocation.AllocHandle), pPrivateData);
 }
 
 void VirtualBlock::GetStatistics(Statistics* pStats) const
 {
     D3D12MA_ASSERT(pStats);
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
-    D3D12MA_HEAVY_ASSERT(m_Pimpl->m_Metadata->Validate());
     ClearStatistics(*pStats);
-    m_Pimpl->m_Metadata->AddStatistics(*pStats);
+    for (UINT i = 0; i < m_Pimpl->m_ShardCount; ++i)
+    {
+        VirtualBlockPimpl::Shard& shard = m_Pimpl->m_Shards[i];
+        MutexLock lock(shard.AllocMutex, m_Pimpl->m_UseMutex);
+        D3D12MA_HEAVY_ASSERT(shard.Metadata->Validate());
+        shard.Metadata->AddStatistics(*pStats);
+    }
 }
 
 void VirtualBlock::CalculateStatistics(DetailedStatistics* pStats) const
 {
     D3D12MA_ASSERT(pStats);
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
-    D3D12MA_HEAVY_ASSERT(m_Pimpl->m_Metadata->Validate());
     ClearDetailedStatistics(*pStats);
-    m_Pimpl->m_Metadata->AddDetailedStatistics(*pStats);
+    for (UINT i = 0; i < m_Pimpl->m_ShardCount; ++i)
+    {
+        VirtualBlockPimpl::Shard& shard = m_Pimpl->m_Shards[i];
+        MutexLock lock(shard.AllocMutex, m_Pimpl->m_UseMutex);
+        D3D12MA_HEAVY_ASSERT(shard.Metadata->Validate());
+        shard.Metadata->AddDetailedStatistics(*pStats);
+    }
 }
 
 void VirtualBlock::BuildStatsString(WCHAR** ppStatsString) const
@@ -10354,13 +15868,7 @@ void VirtualBlock::BuildStatsString(WCHAR** ppStatsString) const
     D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
 
     StringBuilder sb(m_Pimpl->m_AllocationCallbacks);
-    {
-        JsonWriter json(m_Pimpl->m_AllocationCallbacks, sb);
-        D3D12MA_HEAVY_ASSERT(m_Pimpl->m_Metadata->Validate());
-        json.BeginObject();
-        m_Pimpl->m_Metadata->WriteAllocationInfoToJson(json);
-        json.EndObject();
-    } // Scope for JsonWriter
+    m_Pimpl->WriteStatsJson(sb);
 
     const size_t length = sb.GetLength();
     WCHAR* result = AllocateArray<WCHAR>(m_Pimpl->m_AllocationCallbacks, length + 1);
@@ -10369,6 +15877,20 @@ void VirtualBlock::BuildStatsString(WCHAR** ppStatsString) const
     *ppStatsString = result;
 }
 
+void VirtualBlock::WriteStatsString(
+    WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+    void* pPrivateData,
+    STATS_STRING_ENCODING Encoding) const
+{
+    D3D12MA_ASSERT(pWriteFunc);
+
+    D3D12MA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    StringBuilder sb(m_Pimpl->m_AllocationCallbacks, pWriteFunc, pPrivateData, Encoding);
+    m_Pimpl->WriteStatsJson(sb);
+    sb.Flush();
+}
+
 void VirtualBlock::FreeStatsString(WCHAR* pStatsString) const
 {
     if (pStatsString != NULL)
@@ -10392,10 +15914,56 @@ VirtualBlock::~VirtualBlock()
 {
     // THIS IS AN IMPORTANT ASSERT!
     // Hitting it means you have some memory leak - unreleased allocations in this virtual block.
-    D3D12MA_ASSERT(m_Pimpl->m_Metadata->IsEmpty() && "Some allocations were not freed before destruction of this virtual block!");
+    // Not calling public IsEmpty(), as the debug global mutex is already locked by Release().
+    D3D12MA_ASSERT(m_Pimpl->IsEmpty() && "Some allocations were not freed before destruction of this virtual block!");
 
     D3D12MA_DELETE(m_Pimpl->m_AllocationCallbacks, m_Pimpl);
 }
 #endif // _D3D12MA_VIRTUAL_BLOCK_FUNCTIONS
+
+#ifndef _D3D12MA_SNAPSHOT_FUNCTIONS
+UINT64 Snapshot::GetBlockCount() const
+{
+    return m_Pimpl->GetBlockCount();
+}
+
+UINT64 Snapshot::GetAllocationCount() const
+{
+    return m_Pimpl->GetAllocationCount();
+}
+
+void Snapshot::EnumerateChanges(
+    const Snapshot* pPrevious,
+    SNAPSHOT_CHANGE_FUNC_PTR pChangeFunc,
+    void* pPrivateData) const
+{
+    D3D12MA_ASSERT(pChangeFunc);
+    m_Pimpl->EnumerateChanges(pPrevious ? pPrevious->m_Pimpl : NULL, pChangeFunc, pPrivateData);
+}
+
+void Snapshot::WriteChanges(
+    const Snapshot* pPrevious,
+    WRITE_STATS_STRING_FUNC_PTR pWriteFunc,
+    void* pPrivateData) const
+{
+    D3D12MA_ASSERT(pWriteFunc);
+    m_Pimpl->WriteChanges(pPrevious ? pPrevious->m_Pimpl : NULL, pWriteFunc, pPrivateData);
+}
+
+void Snapshot::ReleaseThis()
+{
+    // Copy is needed because otherwise we would call destructor and invalidate the structure with callbacks before using it to free memory.
+    const ALLOCATION_CALLBACKS allocationCallbacksCopy = m_Pimpl->m_AllocationCallbacks;
+    D3D12MA_DELETE(allocationCallbacksCopy, this);
+}
+
+Snapshot::Snapshot(const ALLOCATION_CALLBACKS& allocationCallbacks)
+    : m_Pimpl(D3D12MA_NEW(allocationCallbacks, SnapshotPimpl)(allocationCallbacks)) {}
+
+Snapshot::~Snapshot()
+{
+    D3D12MA_DELETE(m_Pimpl->m_AllocationCallbacks, m_Pimpl);
+}
+#endif // _D3D12MA_SNAPSHOT_FUNCTIONS
 #endif // _D3D12MA_PUBLIC_INTERFACE
 } // namespace D3D12MA
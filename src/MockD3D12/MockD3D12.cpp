@@ -0,0 +1,797 @@
+//
+// Copyright (c) 2019-2026 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "MockD3D12.h"
+
+#include <chrono>
+#include <new>
+
+namespace
+{
+
+const UINT64 MOCK_GPU_VIRTUAL_ADDRESS_BASE = 0x100000000ull;
+const UINT64 MOCK_GPU_VIRTUAL_ADDRESS_ALIGNMENT = 65536;
+const UINT64 MOCK_TEXTURE_SUBRESOURCE_ALIGNMENT = 512;
+
+template<typename T>
+T AlignUp(T val, T alignment)
+{
+    return (val + alignment - 1) / alignment * alignment;
+}
+
+void BusyWait(UINT64 nanoseconds)
+{
+    if (nanoseconds == 0)
+        return;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(nanoseconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+// Returns bits per pixel, or bits per 4x4 block for block-compressed formats.
+UINT GetFormatBits(DXGI_FORMAT format, bool& outBlockCompressed)
+{
+    outBlockCompressed = false;
+    if (format >= DXGI_FORMAT_R32G32B32A32_TYPELESS && format <= DXGI_FORMAT_R32G32B32A32_SINT)
+        return 128;
+    if (format >= DXGI_FORMAT_R32G32B32_TYPELESS && format <= DXGI_FORMAT_R32G32B32_SINT)
+        return 96;
+    if (format >= DXGI_FORMAT_R16G16B16A16_TYPELESS && format <= DXGI_FORMAT_X32_TYPELESS_G8X24_UINT)
+        return 64;
+    if (format >= DXGI_FORMAT_R10G10B10A2_TYPELESS && format <= DXGI_FORMAT_X24_TYPELESS_G8_UINT)
+        return 32;
+    if (format >= DXGI_FORMAT_R8G8_TYPELESS && format <= DXGI_FORMAT_R16_SINT)
+        return 16;
+    if (format >= DXGI_FORMAT_R8_TYPELESS && format <= DXGI_FORMAT_A8_UNORM)
+        return 8;
+    if (format == DXGI_FORMAT_R1_UNORM)
+        return 1;
+    if (format == DXGI_FORMAT_R9G9B9E5_SHAREDEXP)
+        return 32;
+    if (format == DXGI_FORMAT_R8G8_B8G8_UNORM || format == DXGI_FORMAT_G8R8_G8B8_UNORM)
+        return 16;
+    if ((format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC1_UNORM_SRGB) ||
+        (format >= DXGI_FORMAT_BC4_TYPELESS && format <= DXGI_FORMAT_BC4_SNORM))
+    {
+        outBlockCompressed = true;
+        return 64;
+    }
+    if ((format >= DXGI_FORMAT_BC2_TYPELESS && format <= DXGI_FORMAT_BC3_UNORM_SRGB) ||
+        (format >= DXGI_FORMAT_BC5_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+        (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB))
+    {
+        outBlockCompressed = true;
+        return 128;
+    }
+    if (format == DXGI_FORMAT_B5G6R5_UNORM || format == DXGI_FORMAT_B5G5R5A1_UNORM)
+        return 16;
+    if (format >= DXGI_FORMAT_B8G8R8A8_UNORM && format <= DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+        return 32;
+    return 0;
+}
+
+// Mock heap. Holds a reference to its device.
+class MockHeap final : public ID3D12Heap
+{
+public:
+    MockHeap(MockDevice* device, const D3D12_HEAP_DESC& desc, DXGI_MEMORY_SEGMENT_GROUP group)
+        : m_RefCount(1), m_Device(device), m_Desc(desc), m_Group(group)
+    {
+        m_Device->AddRef();
+        m_GpuVirtualAddress = m_Device->ReserveGpuVirtualAddress(desc.SizeInBytes);
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (ppvObject == NULL)
+            return E_POINTER;
+        if (riid == IID_IUnknown || riid == __uuidof(ID3D12Object) || riid == __uuidof(ID3D12DeviceChild) ||
+            riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12Heap))
+        {
+            AddRef();
+            *ppvObject = static_cast<ID3D12Heap*>(this);
+            return S_OK;
+        }
+        *ppvObject = NULL;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_RefCount; }
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG newRefCount = --m_RefCount;
+        if (newRefCount == 0)
+            delete this;
+        return newRefCount;
+    }
+    HRESULT STDMETHODCALLTYPE SetName(LPCWSTR) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice) override { return m_Device->QueryInterface(riid, ppvDevice); }
+    D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc() override { return m_Desc; }
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGpuVirtualAddress() const { return m_GpuVirtualAddress; }
+
+private:
+    std::atomic<ULONG> m_RefCount;
+    MockDevice* const m_Device;
+    const D3D12_HEAP_DESC m_Desc;
+    const DXGI_MEMORY_SEGMENT_GROUP m_Group;
+    D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress;
+
+    ~MockHeap()
+    {
+        m_Device->OnMemoryFreed(m_Group, m_Desc.SizeInBytes);
+        m_Device->OnHeapDestroyed();
+        m_Device->Release();
+    }
+};
+
+/*
+Mock resource. A placed resource holds a reference to its heap, a committed one owns
+`m_CommittedSize` bytes of its segment group. Both hold a reference to the device.
+*/
+class MockResource final : public ID3D12Resource
+{
+public:
+    MockResource(MockDevice* device, const D3D12_RESOURCE_DESC& desc, D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress,
+        MockHeap* heap, DXGI_MEMORY_SEGMENT_GROUP committedGroup, UINT64 committedSize)
+        : m_RefCount(1), m_Device(device), m_Desc(desc), m_GpuVirtualAddress(gpuVirtualAddress),
+        m_Heap(heap), m_CommittedGroup(committedGroup), m_CommittedSize(committedSize)
+    {
+        m_Device->AddRef();
+        if (m_Heap)
+            m_Heap->AddRef();
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (ppvObject == NULL)
+            return E_POINTER;
+        if (riid == IID_IUnknown || riid == __uuidof(ID3D12Object) || riid == __uuidof(ID3D12DeviceChild) ||
+            riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12Resource))
+        {
+            AddRef();
+            *ppvObject = static_cast<ID3D12Resource*>(this);
+            return S_OK;
+        }
+        *ppvObject = NULL;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_RefCount; }
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG newRefCount = --m_RefCount;
+        if (newRefCount == 0)
+            delete this;
+        return newRefCount;
+    }
+    HRESULT STDMETHODCALLTYPE SetName(LPCWSTR) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice) override { return m_Device->QueryInterface(riid, ppvDevice); }
+    // There is no backing CPU memory.
+    HRESULT STDMETHODCALLTYPE Map(UINT, const D3D12_RANGE*, void**) override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE Unmap(UINT, const D3D12_RANGE*) override {}
+    D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc() override { return m_Desc; }
+    D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress() override
+    {
+        return m_Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? m_GpuVirtualAddress : 0;
+    }
+
+private:
+    std::atomic<ULONG> m_RefCount;
+    MockDevice* const m_Device;
+    const D3D12_RESOURCE_DESC m_Desc;
+    const D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress;
+    MockHeap* const m_Heap;
+    const DXGI_MEMORY_SEGMENT_GROUP m_CommittedGroup;
+    const UINT64 m_CommittedSize;
+
+    ~MockResource()
+    {
+        if (m_Heap)
+            m_Heap->Release();
+        else
+            m_Device->OnMemoryFreed(m_CommittedGroup, m_CommittedSize);
+        m_Device->OnResourceDestroyed();
+        m_Device->Release();
+    }
+};
+
+// Finishes creation of an object returned through riid/ppv, following D3D12 rules:
+// null ppv means the call only validates parameters and returns S_FALSE.
+template<typename T>
+HRESULT ReturnObject(T* obj, REFIID riid, void** ppv)
+{
+    HRESULT hr = S_FALSE;
+    if (ppv != NULL)
+        hr = obj->QueryInterface(riid, ppv);
+    obj->Release();
+    return hr;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// MockDevice
+
+MockDevice::MockDevice(const MOCK_DEVICE_DESC& desc, MockAdapter* adapter)
+    : m_RefCount(1),
+    m_Desc(desc),
+    m_Adapter(adapter),
+    m_LiveHeapCount(0),
+    m_LiveResourceCount(0),
+    m_NextGpuVirtualAddress(MOCK_GPU_VIRTUAL_ADDRESS_BASE)
+{
+    m_Adapter->AddRef();
+}
+
+MockDevice::~MockDevice()
+{
+    m_Adapter->Release();
+}
+
+HRESULT STDMETHODCALLTYPE MockDevice::QueryInterface(REFIID riid, void** ppvObject)
+{
+    if (ppvObject == NULL)
+        return E_POINTER;
+    if (riid == IID_IUnknown || riid == __uuidof(ID3D12Object) || riid == __uuidof(ID3D12Device))
+    {
+        AddRef();
+        *ppvObject = static_cast<ID3D12Device*>(this);
+        return S_OK;
+    }
+    // Newer device interfaces are not implemented.
+    *ppvObject = NULL;
+    return E_NOINTERFACE;
+}
+
+ULONG STDMETHODCALLTYPE MockDevice::AddRef()
+{
+    return ++m_RefCount;
+}
+
+ULONG STDMETHODCALLTYPE MockDevice::Release()
+{
+    const ULONG newRefCount = --m_RefCount;
+    if (newRefCount == 0)
+        delete this;
+    return newRefCount;
+}
+
+HRESULT STDMETHODCALLTYPE MockDevice::SetName(LPCWSTR)
+{
+    return S_OK;
+}
+
+UINT STDMETHODCALLTYPE MockDevice::GetNodeCount()
+{
+    return 1;
+}
+
+HRESULT STDMETHODCALLTYPE MockDevice::CheckFeatureSupport(
+    D3D12_FEATURE Feature,
+    void* pFeatureSupportData,
+    UINT FeatureSupportDataSize)
+{
+    HRESULT hr = m_Adapter->BeginOperation(MOCK_OPERATION_CHECK_FEATURE_SUPPORT);
+    if (FAILED(hr))
+        return hr;
+    if (pFeatureSupportData == NULL)
+        return E_INVALIDARG;
+
+    switch (Feature)
+    {
+    case D3D12_FEATURE_D3D12_OPTIONS:
+    {
+        if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+            return E_INVALIDARG;
+        D3D12_FEATURE_DATA_D3D12_OPTIONS& options = *(D3D12_FEATURE_DATA_D3D12_OPTIONS*)pFeatureSupportData;
+        ZeroMemory(&options, sizeof(options));
+        options.TiledResourcesTier = D3D12_TILED_RESOURCES_TIER_3;
+        options.ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+        options.MaxGPUVirtualAddressBitsPerResource = 40;
+        options.ResourceHeapTier = m_Desc.ResourceHeapTier;
+        return S_OK;
+    }
+    case D3D12_FEATURE_ARCHITECTURE:
+    {
+        if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_ARCHITECTURE))
+            return E_INVALIDARG;
+        D3D12_FEATURE_DATA_ARCHITECTURE& arch = *(D3D12_FEATURE_DATA_ARCHITECTURE*)pFeatureSupportData;
+        if (arch.NodeIndex != 0)
+            return E_INVALIDARG;
+        arch.TileBasedRenderer = FALSE;
+        arch.UMA = m_Desc.UMA;
+        arch.CacheCoherentUMA = m_Desc.CacheCoherentUMA;
+        return S_OK;
+    }
+    case D3D12_FEATURE_ARCHITECTURE1:
+    {
+        if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_ARCHITECTURE1))
+            return E_INVALIDARG;
+        D3D12_FEATURE_DATA_ARCHITECTURE1& arch = *(D3D12_FEATURE_DATA_ARCHITECTURE1*)pFeatureSupportData;
+        if (arch.NodeIndex != 0)
+            return E_INVALIDARG;
+        arch.TileBasedRenderer = FALSE;
+        arch.UMA = m_Desc.UMA;
+        arch.CacheCoherentUMA = m_Desc.CacheCoherentUMA;
+        arch.IsolatedMMU = FALSE;
+        return S_OK;
+    }
+    default:
+        return E_INVALIDARG;
+    }
+}
+
+HRESULT STDMETHODCALLTYPE MockDevice::CreateCommittedResource(
+    const D3D12_HEAP_PROPERTIES* pHeapProperties,
+    D3D12_HEAP_FLAGS HeapFlags,
+    const D3D12_RESOURCE_DESC* pDesc,
+    D3D12_RESOURCE_STATES InitialResourceState,
+    const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+    REFIID riidResource,
+    void** ppvResource)
+{
+    (void)HeapFlags;
+    (void)InitialResourceState;
+    (void)pOptimizedClearValue;
+
+    HRESULT hr = m_Adapter->BeginOperation(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE);
+    if (FAILED(hr))
+        return hr;
+    if (pHeapProperties == NULL || pDesc == NULL)
+        return E_INVALIDARG;
+
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = CalcResourceAllocationInfo(*pDesc);
+    if (allocInfo.SizeInBytes == UINT64_MAX)
+        return E_INVALIDARG;
+    if (ppvResource == NULL)
+        return S_FALSE;
+
+    const DXGI_MEMORY_SEGMENT_GROUP group = HeapPropertiesToSegmentGroup(*pHeapProperties);
+    hr = TryAllocateMemory(group, allocInfo.SizeInBytes);
+    if (FAILED(hr))
+        return hr;
+
+    MockResource* const res = new MockResource(this, *pDesc,
+        ReserveGpuVirtualAddress(allocInfo.SizeInBytes), NULL, group, allocInfo.SizeInBytes);
+    ++m_LiveResourceCount;
+    return ReturnObject(res, riidResource, ppvResource);
+}
+
+HRESULT STDMETHODCALLTYPE MockDevice::CreateHeap(
+    const D3D12_HEAP_DESC* pDesc,
+    REFIID riid,
+    void** ppvHeap)
+{
+    HRESULT hr = m_Adapter->BeginOperation(MOCK_OPERATION_CREATE_HEAP);
+    if (FAILED(hr))
+        return hr;
+    if (pDesc == NULL || pDesc->SizeInBytes == 0)
+        return E_INVALIDARG;
+    if (pDesc->Alignment != 0 &&
+        pDesc->Alignment != D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT &&
+        pDesc->Alignment != D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        return E_INVALIDARG;
+    }
+    if (m_Desc.ResourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1)
+    {
+        // Tier 1 requires every heap to be restricted to a single resource class.
+        const D3D12_HEAP_FLAGS denyFlags = pDesc->Flags &
+            (D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES | D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES);
+        if (denyFlags != D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS &&
+            denyFlags != D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES &&
+            denyFlags != D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES)
+        {
+            return E_INVALIDARG;
+        }
+    }
+    if (ppvHeap == NULL)
+        return S_FALSE;
+
+    const DXGI_MEMORY_SEGMENT_GROUP group = HeapPropertiesToSegmentGroup(pDesc->Properties);
+    hr = TryAllocateMemory(group, pDesc->SizeInBytes);
+    if (FAILED(hr))
+        return hr;
+
+    MockHeap* const heap = new MockHeap(this, *pDesc, group);
+    ++m_LiveHeapCount;
+    return ReturnObject(heap, riid, ppvHeap);
+}
+
+HRESULT STDMETHODCALLTYPE MockDevice::CreatePlacedResource(
+    ID3D12Heap* pHeap,
+    UINT64 HeapOffset,
+    const D3D12_RESOURCE_DESC* pDesc,
+    D3D12_RESOURCE_STATES InitialState,
+    const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+    REFIID riid,
+    void** ppvResource)
+{
+    (void)InitialState;
+    (void)pOptimizedClearValue;
+
+    HRESULT hr = m_Adapter->BeginOperation(MOCK_OPERATION_CREATE_PLACED_RESOURCE);
+    if (FAILED(hr))
+        return hr;
+    if (pHeap == NULL || pDesc == NULL)
+        return E_INVALIDARG;
+
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = CalcResourceAllocationInfo(*pDesc);
+    if (allocInfo.SizeInBytes == UINT64_MAX)
+        return E_INVALIDARG;
+    // All heaps passed here are created by this device.
+    MockHeap* const heap = static_cast<MockHeap*>(pHeap);
+    const D3D12_HEAP_DESC heapDesc = heap->GetDesc();
+    if (HeapOffset % allocInfo.Alignment != 0 ||
+        HeapOffset + allocInfo.SizeInBytes > heapDesc.SizeInBytes)
+    {
+        return E_INVALIDARG;
+    }
+    if (ppvResource == NULL)
+        return S_FALSE;
+
+    MockResource* const res = new MockResource(this, *pDesc,
+        heap->GetGpuVirtualAddress() + HeapOffset, heap, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, 0);
+    ++m_LiveResourceCount;
+    return ReturnObject(res, riid, ppvResource);
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE MockDevice::GetResourceAllocationInfo(
+    UINT visibleMask,
+    UINT numResourceDescs,
+    const D3D12_RESOURCE_DESC* pResourceDescs)
+{
+    (void)visibleMask;
+
+    D3D12_RESOURCE_ALLOCATION_INFO result = { UINT64_MAX, 0 };
+    if (FAILED(m_Adapter->BeginOperation(MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO)))
+        return result;
+    if (numResourceDescs == 0 || pResourceDescs == NULL)
+        return result;
+
+    result.SizeInBytes = 0;
+    for (UINT i = 0; i < numResourceDescs; ++i)
+    {
+        const D3D12_RESOURCE_ALLOCATION_INFO info = CalcResourceAllocationInfo(pResourceDescs[i]);
+        if (info.SizeInBytes == UINT64_MAX)
+            return { UINT64_MAX, 0 };
+        if (info.Alignment > result.Alignment)
+            result.Alignment = info.Alignment;
+        result.SizeInBytes = AlignUp(result.SizeInBytes, info.Alignment) + info.SizeInBytes;
+    }
+    result.SizeInBytes = AlignUp(result.SizeInBytes, result.Alignment);
+    return result;
+}
+
+void MockDevice::SetOperationDesc(MOCK_OPERATION op, const MOCK_OPERATION_DESC& desc)
+{
+    m_Adapter->SetOperationDesc(op, desc);
+}
+
+UINT64 MockDevice::GetCallCount(MOCK_OPERATION op) const
+{
+    return m_Adapter->GetCallCount(op);
+}
+
+void MockDevice::ResetCallCounts()
+{
+    m_Adapter->ResetCallCounts();
+}
+
+UINT64 MockDevice::GetUsage(DXGI_MEMORY_SEGMENT_GROUP group) const
+{
+    return m_Adapter->GetUsage(group);
+}
+
+DXGI_MEMORY_SEGMENT_GROUP MockDevice::HeapPropertiesToSegmentGroup(const D3D12_HEAP_PROPERTIES& props) const
+{
+    // Same mapping as AllocatorPimpl::HeapPropertiesToMemorySegmentGroup in D3D12MemAlloc.cpp.
+    if (m_Desc.UMA)
+        return DXGI_MEMORY_SEGMENT_GROUP_LOCAL;
+    if (props.Type == D3D12_HEAP_TYPE_CUSTOM)
+    {
+        return props.MemoryPoolPreference == D3D12_MEMORY_POOL_L1 ?
+            DXGI_MEMORY_SEGMENT_GROUP_LOCAL : DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL;
+    }
+    return props.Type == D3D12_HEAP_TYPE_DEFAULT || props.Type == D3D12_HEAP_TYPE_GPU_UPLOAD ?
+        DXGI_MEMORY_SEGMENT_GROUP_LOCAL : DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL;
+}
+
+void MockDevice::OnMemoryFreed(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size)
+{
+    m_Adapter->SubtractUsage(group, size);
+}
+
+UINT64 MockDevice::ReserveGpuVirtualAddress(UINT64 size)
+{
+    return m_NextGpuVirtualAddress.fetch_add(AlignUp(size, MOCK_GPU_VIRTUAL_ADDRESS_ALIGNMENT));
+}
+
+HRESULT MockDevice::TryAllocateMemory(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size)
+{
+    const UINT64 capacity = group == DXGI_MEMORY_SEGMENT_GROUP_LOCAL ?
+        m_Desc.LocalMemoryBytes : m_Desc.NonLocalMemoryBytes;
+    return m_Adapter->TryAddUsage(group, size, capacity) ? S_OK : E_OUTOFMEMORY;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO MockDevice::CalcResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc) const
+{
+    const D3D12_RESOURCE_ALLOCATION_INFO invalid = { UINT64_MAX, 0 };
+
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        if (desc.Width == 0 || desc.Format != DXGI_FORMAT_UNKNOWN ||
+            (desc.Alignment != 0 && desc.Alignment != D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT))
+        {
+            return invalid;
+        }
+        return { AlignUp<UINT64>(desc.Width, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT),
+            D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+    }
+    if (desc.Dimension < D3D12_RESOURCE_DIMENSION_TEXTURE1D || desc.Dimension > D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+        return invalid;
+
+    bool blockCompressed = false;
+    const UINT formatBits = GetFormatBits(desc.Format, blockCompressed);
+    if (formatBits == 0 || desc.Width == 0 || desc.Height == 0 || desc.DepthOrArraySize == 0)
+        return invalid;
+
+    const bool is3D = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+    const UINT sampleCount = desc.SampleDesc.Count > 0 ? desc.SampleDesc.Count : 1;
+    const bool msaa = sampleCount > 1;
+
+    UINT mipLevels = desc.MipLevels;
+    if (mipLevels == 0)
+    {
+        // Full mip chain.
+        UINT64 maxDim = desc.Width > desc.Height ? desc.Width : desc.Height;
+        if (is3D && desc.DepthOrArraySize > maxDim)
+            maxDim = desc.DepthOrArraySize;
+        while (maxDim > 0)
+        {
+            ++mipLevels;
+            maxDim >>= 1;
+        }
+    }
+
+    UINT64 sliceSize = 0;
+    for (UINT mip = 0; mip < mipLevels; ++mip)
+    {
+        UINT64 width = desc.Width >> mip;
+        UINT64 height = desc.Height >> mip;
+        UINT64 depth = is3D ? (UINT64)desc.DepthOrArraySize >> mip : 1;
+        width = width > 0 ? width : 1;
+        height = height > 0 ? height : 1;
+        depth = depth > 0 ? depth : 1;
+        if (blockCompressed)
+        {
+            width = (width + 3) / 4;
+            height = (height + 3) / 4;
+        }
+        // Tightly packed, like swizzled layouts of real hardware.
+        const UINT64 subresourceSize = (width * height * depth * formatBits + 7) / 8;
+        sliceSize += AlignUp<UINT64>(subresourceSize, MOCK_TEXTURE_SUBRESOURCE_ALIGNMENT);
+    }
+    const UINT64 arraySize = is3D ? 1 : desc.DepthOrArraySize;
+    const UINT64 totalSize = sliceSize * arraySize * sampleCount;
+
+    // Small alignment, when requested, is granted only for textures that are small enough
+    // and not render targets or depth-stencils. Otherwise the default alignment is returned,
+    // like the real API does.
+    const bool rtOrDs = (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+    UINT64 alignment = msaa ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    if (!msaa && desc.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT &&
+        !rtOrDs && totalSize <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+    }
+    else if (msaa && desc.Alignment == D3D12_SMALL_MSAA_RESOURCE_PLACEMENT_ALIGNMENT &&
+        totalSize <= D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        alignment = D3D12_SMALL_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+    }
+    return { AlignUp(totalSize, alignment), alignment };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// MockAdapter
+
+MockAdapter::MockAdapter(const MOCK_DEVICE_DESC& desc)
+    : m_RefCount(1)
+{
+    for (UINT i = 0; i < MOCK_OPERATION_COUNT; ++i)
+    {
+        m_Operations[i].LatencyNanoseconds = 0;
+        m_Operations[i].FailEveryNthCall = 0;
+        m_Operations[i].FailAfterCallCount = 0;
+        m_Operations[i].FailResult = 0;
+        m_Operations[i].CallCount = 0;
+    }
+    m_Usage[0] = 0;
+    m_Usage[1] = 0;
+    m_Budget[DXGI_MEMORY_SEGMENT_GROUP_LOCAL] = desc.LocalMemoryBytes;
+    m_Budget[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL] = desc.UMA ? 0 : desc.NonLocalMemoryBytes;
+}
+
+HRESULT STDMETHODCALLTYPE MockAdapter::QueryInterface(REFIID riid, void** ppvObject)
+{
+    if (ppvObject == NULL)
+        return E_POINTER;
+    if (riid == IID_IUnknown || riid == __uuidof(IDXGIObject) ||
+        riid == __uuidof(IDXGIAdapter) || riid == __uuidof(IDXGIAdapter3))
+    {
+        AddRef();
+        *ppvObject = static_cast<IDXGIAdapter3*>(this);
+        return S_OK;
+    }
+    *ppvObject = NULL;
+    return E_NOINTERFACE;
+}
+
+ULONG STDMETHODCALLTYPE MockAdapter::AddRef()
+{
+    return ++m_RefCount;
+}
+
+ULONG STDMETHODCALLTYPE MockAdapter::Release()
+{
+    const ULONG newRefCount = --m_RefCount;
+    if (newRefCount == 0)
+        delete this;
+    return newRefCount;
+}
+
+HRESULT STDMETHODCALLTYPE MockAdapter::GetDesc(DXGI_ADAPTER_DESC* pDesc)
+{
+    if (pDesc == NULL)
+        return E_INVALIDARG;
+    ZeroMemory(pDesc, sizeof(*pDesc));
+    const wchar_t name[] = L"D3D12MA Mock Adapter";
+    memcpy(pDesc->Description, name, sizeof(name));
+    pDesc->VendorId = 0xFFFF;
+    pDesc->DeviceId = 0x0001;
+    pDesc->DedicatedVideoMemory = (SIZE_T)m_Budget[DXGI_MEMORY_SEGMENT_GROUP_LOCAL].load();
+    pDesc->SharedSystemMemory = (SIZE_T)m_Budget[DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL].load();
+    return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE MockAdapter::QueryVideoMemoryInfo(
+    UINT NodeIndex,
+    DXGI_MEMORY_SEGMENT_GROUP MemorySegmentGroup,
+    DXGI_QUERY_VIDEO_MEMORY_INFO* pVideoMemoryInfo)
+{
+    HRESULT hr = BeginOperation(MOCK_OPERATION_QUERY_VIDEO_MEMORY_INFO);
+    if (FAILED(hr))
+        return hr;
+    if (NodeIndex != 0 || pVideoMemoryInfo == NULL ||
+        (MemorySegmentGroup != DXGI_MEMORY_SEGMENT_GROUP_LOCAL && MemorySegmentGroup != DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL))
+    {
+        return E_INVALIDARG;
+    }
+    pVideoMemoryInfo->Budget = m_Budget[MemorySegmentGroup].load();
+    pVideoMemoryInfo->CurrentUsage = m_Usage[MemorySegmentGroup].load();
+    pVideoMemoryInfo->AvailableForReservation = pVideoMemoryInfo->Budget / 2;
+    pVideoMemoryInfo->CurrentReservation = 0;
+    return S_OK;
+}
+
+void MockAdapter::SetBudget(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 bytes)
+{
+    m_Budget[group] = bytes;
+}
+
+void MockAdapter::SetOperationDesc(MOCK_OPERATION op, const MOCK_OPERATION_DESC& desc)
+{
+    Operation& operation = m_Operations[op];
+    operation.LatencyNanoseconds = desc.LatencyNanoseconds;
+    operation.FailEveryNthCall = desc.FailEveryNthCall;
+    operation.FailAfterCallCount = desc.FailAfterCallCount;
+    operation.FailResult = desc.FailResult;
+}
+
+UINT64 MockAdapter::GetCallCount(MOCK_OPERATION op) const
+{
+    return m_Operations[op].CallCount.load();
+}
+
+void MockAdapter::ResetCallCounts()
+{
+    for (UINT i = 0; i < MOCK_OPERATION_COUNT; ++i)
+        m_Operations[i].CallCount = 0;
+}
+
+HRESULT MockAdapter::BeginOperation(MOCK_OPERATION op)
+{
+    Operation& operation = m_Operations[op];
+    const UINT64 callIndex = ++operation.CallCount;
+    BusyWait(operation.LatencyNanoseconds.load(std::memory_order_relaxed));
+
+    const UINT failEveryNth = operation.FailEveryNthCall.load(std::memory_order_relaxed);
+    const UINT64 failAfter = operation.FailAfterCallCount.load(std::memory_order_relaxed);
+    if ((failEveryNth != 0 && callIndex % failEveryNth == 0) ||
+        (failAfter != 0 && callIndex > failAfter))
+    {
+        const HRESULT failResult = operation.FailResult.load(std::memory_order_relaxed);
+        return failResult != 0 ? failResult : E_OUTOFMEMORY;
+    }
+    return S_OK;
+}
+
+UINT64 MockAdapter::GetUsage(DXGI_MEMORY_SEGMENT_GROUP group) const
+{
+    return m_Usage[group].load();
+}
+
+bool MockAdapter::TryAddUsage(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size, UINT64 capacity)
+{
+    UINT64 usage = m_Usage[group].load();
+    do
+    {
+        if (size > capacity || usage > capacity - size)
+            return false;
+    } while (!m_Usage[group].compare_exchange_weak(usage, usage + size));
+    return true;
+}
+
+void MockAdapter::SubtractUsage(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size)
+{
+    m_Usage[group] -= size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions
+
+void GetDefaultMockDeviceDesc(MOCK_DEVICE_DESC& outDesc)
+{
+    outDesc.ResourceHeapTier = D3D12_RESOURCE_HEAP_TIER_2;
+    outDesc.UMA = FALSE;
+    outDesc.CacheCoherentUMA = FALSE;
+    outDesc.LocalMemoryBytes = 8ull * 1024 * 1024 * 1024;
+    outDesc.NonLocalMemoryBytes = 16ull * 1024 * 1024 * 1024;
+}
+
+HRESULT CreateMockDevice(const MOCK_DEVICE_DESC* pDesc, MockDevice** ppDevice, MockAdapter** ppAdapter)
+{
+    if (ppDevice == NULL || ppAdapter == NULL)
+        return E_POINTER;
+
+    MOCK_DEVICE_DESC desc;
+    if (pDesc != NULL)
+        desc = *pDesc;
+    else
+        GetDefaultMockDeviceDesc(desc);
+    if (desc.UMA)
+        desc.NonLocalMemoryBytes = 0;
+
+    MockAdapter* const adapter = new(std::nothrow) MockAdapter(desc);
+    if (adapter == NULL)
+        return E_OUTOFMEMORY;
+    MockDevice* const device = new(std::nothrow) MockDevice(desc, adapter);
+    if (device == NULL)
+    {
+        adapter->Release();
+        return E_OUTOFMEMORY;
+    }
+    *ppDevice = device;
+    *ppAdapter = adapter;
+    return S_OK;
+}
@@ -0,0 +1,254 @@
+//
+// Copyright (c) 2019-2026 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/*
+Headless mock of ID3D12Device and IDXGIAdapter3 that lets D3D12MemAlloc.cpp be
+built, tested and benchmarked on machines without a GPU or the Windows SDK.
+
+The mock implements the small part of the D3D12 API used by the library:
+CreateHeap, CreatePlacedResource, CreateCommittedResource,
+GetResourceAllocationInfo, CheckFeatureSupport and QueryVideoMemoryInfo.
+No GPU memory is ever allocated - heaps and resources are only accounted for,
+and resources receive fake, non-overlapping GPU virtual addresses.
+
+Every operation counts its calls and can be configured with artificial latency
+and failure injection, see MOCK_OPERATION_DESC.
+*/
+
+#pragma once
+
+#include "d3d12.h"
+#include "dxgi1_4.h"
+
+#include <atomic>
+
+/// Operations of the mock device and adapter that can be counted, delayed, and made to fail.
+enum MOCK_OPERATION
+{
+    MOCK_OPERATION_CREATE_HEAP,
+    MOCK_OPERATION_CREATE_PLACED_RESOURCE,
+    MOCK_OPERATION_CREATE_COMMITTED_RESOURCE,
+    MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO,
+    MOCK_OPERATION_CHECK_FEATURE_SUPPORT,
+    MOCK_OPERATION_QUERY_VIDEO_MEMORY_INFO,
+    MOCK_OPERATION_COUNT
+};
+
+/// Behavior of a single MOCK_OPERATION.
+struct MOCK_OPERATION_DESC
+{
+    /** \brief Time spent inside every call of the operation, simulating driver cost.
+
+    Implemented as a busy wait so that sub-microsecond values are meaningful.
+    */
+    UINT64 LatencyNanoseconds;
+    /** \brief When not 0, every N-th call of the operation fails (calls are numbered from 1).
+    */
+    UINT FailEveryNthCall;
+    /** \brief When not 0, all calls made after this many calls of the operation fail.
+    */
+    UINT64 FailAfterCallCount;
+    /** \brief Error returned by an injected failure. 0 means `E_OUTOFMEMORY`.
+
+    For `GetResourceAllocationInfo`, which cannot return an error, failure is signaled
+    by `SizeInBytes == UINT64_MAX`, like in the real API.
+    */
+    HRESULT FailResult;
+};
+
+/// Parameters of a mock device created with CreateMockDevice().
+struct MOCK_DEVICE_DESC
+{
+    /// Value reported as `D3D12_FEATURE_DATA_D3D12_OPTIONS::ResourceHeapTier`.
+    D3D12_RESOURCE_HEAP_TIER ResourceHeapTier;
+    /// Value reported as `D3D12_FEATURE_DATA_ARCHITECTURE::UMA`. When true, all memory is local.
+    BOOL UMA;
+    /// Value reported as `D3D12_FEATURE_DATA_ARCHITECTURE::CacheCoherentUMA`.
+    BOOL CacheCoherentUMA;
+    /** \brief Capacity of `DXGI_MEMORY_SEGMENT_GROUP_LOCAL`.
+
+    Creating a heap or committed resource that would exceed it fails with `E_OUTOFMEMORY`.
+    It is also the initial budget of the segment.
+    */
+    UINT64 LocalMemoryBytes;
+    /// Capacity of `DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL`. Ignored when `UMA` is true.
+    UINT64 NonLocalMemoryBytes;
+};
+
+/// Fills `outDesc` with defaults: resource heap tier 2, discrete GPU, 8 GiB local and 16 GiB non-local memory.
+void GetDefaultMockDeviceDesc(MOCK_DEVICE_DESC& outDesc);
+
+class MockAdapter;
+
+/** \brief Mock implementation of `ID3D12Device`.
+
+All methods are thread-safe. Call counters and injected behavior are shared with the
+MockAdapter the device was created with, so they can be controlled from either object.
+*/
+class MockDevice final : public ID3D12Device
+{
+public:
+    // IUnknown
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override;
+    ULONG STDMETHODCALLTYPE AddRef() override;
+    ULONG STDMETHODCALLTYPE Release() override;
+    // ID3D12Object
+    HRESULT STDMETHODCALLTYPE SetName(LPCWSTR Name) override;
+    // ID3D12Device
+    UINT STDMETHODCALLTYPE GetNodeCount() override;
+    HRESULT STDMETHODCALLTYPE CheckFeatureSupport(
+        D3D12_FEATURE Feature,
+        void* pFeatureSupportData,
+        UINT FeatureSupportDataSize) override;
+    HRESULT STDMETHODCALLTYPE CreateCommittedResource(
+        const D3D12_HEAP_PROPERTIES* pHeapProperties,
+        D3D12_HEAP_FLAGS HeapFlags,
+        const D3D12_RESOURCE_DESC* pDesc,
+        D3D12_RESOURCE_STATES InitialResourceState,
+        const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+        REFIID riidResource,
+        void** ppvResource) override;
+    HRESULT STDMETHODCALLTYPE CreateHeap(
+        const D3D12_HEAP_DESC* pDesc,
+        REFIID riid,
+        void** ppvHeap) override;
+    HRESULT STDMETHODCALLTYPE CreatePlacedResource(
+        ID3D12Heap* pHeap,
+        UINT64 HeapOffset,
+        const D3D12_RESOURCE_DESC* pDesc,
+        D3D12_RESOURCE_STATES InitialState,
+        const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+        REFIID riid,
+        void** ppvResource) override;
+    D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(
+        UINT visibleMask,
+        UINT numResourceDescs,
+        const D3D12_RESOURCE_DESC* pResourceDescs) override;
+
+    const MOCK_DEVICE_DESC& GetMockDesc() const { return m_Desc; }
+    MockAdapter* GetAdapter() const { return m_Adapter; }
+
+    void SetOperationDesc(MOCK_OPERATION op, const MOCK_OPERATION_DESC& desc);
+    UINT64 GetCallCount(MOCK_OPERATION op) const;
+    void ResetCallCounts();
+
+    /// Number of `ID3D12Heap` objects currently alive.
+    UINT64 GetLiveHeapCount() const { return m_LiveHeapCount.load(); }
+    /// Number of `ID3D12Resource` objects currently alive, both placed and committed.
+    UINT64 GetLiveResourceCount() const { return m_LiveResourceCount.load(); }
+    /// Bytes of heaps and committed resources currently allocated in given segment.
+    UINT64 GetUsage(DXGI_MEMORY_SEGMENT_GROUP group) const;
+
+    // Internal, used by the mock heap and resource objects.
+    DXGI_MEMORY_SEGMENT_GROUP HeapPropertiesToSegmentGroup(const D3D12_HEAP_PROPERTIES& props) const;
+    void OnMemoryFreed(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size);
+    void OnHeapDestroyed() { --m_LiveHeapCount; }
+    void OnResourceDestroyed() { --m_LiveResourceCount; }
+    UINT64 ReserveGpuVirtualAddress(UINT64 size);
+
+private:
+    friend HRESULT CreateMockDevice(const MOCK_DEVICE_DESC*, MockDevice**, MockAdapter**);
+
+    std::atomic<ULONG> m_RefCount;
+    MOCK_DEVICE_DESC m_Desc;
+    MockAdapter* m_Adapter;
+    std::atomic<UINT64> m_LiveHeapCount;
+    std::atomic<UINT64> m_LiveResourceCount;
+    std::atomic<UINT64> m_NextGpuVirtualAddress;
+
+    MockDevice(const MOCK_DEVICE_DESC& desc, MockAdapter* adapter);
+    ~MockDevice();
+
+    HRESULT TryAllocateMemory(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size);
+    D3D12_RESOURCE_ALLOCATION_INFO CalcResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc) const;
+
+    MockDevice(const MockDevice&) = delete;
+    MockDevice& operator=(const MockDevice&) = delete;
+};
+
+/** \brief Mock implementation of `IDXGIAdapter3`.
+
+Owns the state shared with the MockDevice: per-operation call counters and injected
+behavior, and memory usage of both segment groups, which is reported as
+`DXGI_QUERY_VIDEO_MEMORY_INFO::CurrentUsage`.
+*/
+class MockAdapter final : public IDXGIAdapter3
+{
+public:
+    // IUnknown
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override;
+    ULONG STDMETHODCALLTYPE AddRef() override;
+    ULONG STDMETHODCALLTYPE Release() override;
+    // IDXGIAdapter
+    HRESULT STDMETHODCALLTYPE GetDesc(DXGI_ADAPTER_DESC* pDesc) override;
+    // IDXGIAdapter3
+    HRESULT STDMETHODCALLTYPE QueryVideoMemoryInfo(
+        UINT NodeIndex,
+        DXGI_MEMORY_SEGMENT_GROUP MemorySegmentGroup,
+        DXGI_QUERY_VIDEO_MEMORY_INFO* pVideoMemoryInfo) override;
+
+    /// Sets value reported as `DXGI_QUERY_VIDEO_MEMORY_INFO::Budget`. Doesn't change the capacity.
+    void SetBudget(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 bytes);
+
+    void SetOperationDesc(MOCK_OPERATION op, const MOCK_OPERATION_DESC& desc);
+    UINT64 GetCallCount(MOCK_OPERATION op) const;
+    void ResetCallCounts();
+
+    // Internal, used by MockDevice.
+    /** Counts the call of `op`, waits for the configured latency and returns error to
+    inject, or `S_OK` when the call should succeed.
+    */
+    HRESULT BeginOperation(MOCK_OPERATION op);
+    UINT64 GetUsage(DXGI_MEMORY_SEGMENT_GROUP group) const;
+    bool TryAddUsage(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size, UINT64 capacity);
+    void SubtractUsage(DXGI_MEMORY_SEGMENT_GROUP group, UINT64 size);
+
+private:
+    friend HRESULT CreateMockDevice(const MOCK_DEVICE_DESC*, MockDevice**, MockAdapter**);
+
+    struct Operation
+    {
+        std::atomic<UINT64> LatencyNanoseconds;
+        std::atomic<UINT> FailEveryNthCall;
+        std::atomic<UINT64> FailAfterCallCount;
+        std::atomic<HRESULT> FailResult;
+        std::atomic<UINT64> CallCount;
+    };
+
+    std::atomic<ULONG> m_RefCount;
+    Operation m_Operations[MOCK_OPERATION_COUNT];
+    std::atomic<UINT64> m_Usage[2];
+    std::atomic<UINT64> m_Budget[2];
+
+    MockAdapter(const MOCK_DEVICE_DESC& desc);
+    ~MockAdapter() = default;
+
+    MockAdapter(const MockAdapter&) = delete;
+    MockAdapter& operator=(const MockAdapter&) = delete;
+};
+
+/** \brief Creates a mock device together with the adapter it belongs to.
+
+Both objects are returned with reference count 1. The device holds a reference to the
+adapter. `pDesc` can be null to use defaults from GetDefaultMockDeviceDesc().
+*/
+HRESULT CreateMockDevice(const MOCK_DEVICE_DESC* pDesc, MockDevice** ppDevice, MockAdapter** ppAdapter);
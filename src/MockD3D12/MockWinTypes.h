@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2019-2026 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/*
+Minimal subset of Win32 base types and COM declarations, used by the headless
+mock build (D3D12MA_BUILD_MOCK_DEVICE) to compile D3D12MemAlloc.cpp on platforms
+without the Windows SDK. Only what the library and the mock device need is declared.
+*/
+
+#pragma once
+
+#ifdef _WIN32
+    #error The mock D3D12 headers are meant for non-Windows platforms. Use the Windows SDK on Windows.
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <climits>
+#include <type_traits>
+
+typedef int32_t HRESULT;
+typedef int32_t INT;
+typedef int32_t LONG;
+typedef uint32_t UINT;
+typedef uint32_t ULONG;
+typedef uint32_t DWORD;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef uint16_t USHORT;
+typedef uint8_t BYTE;
+typedef int BOOL;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef wchar_t WCHAR;
+typedef const WCHAR* LPCWSTR;
+typedef void* HANDLE;
+
+#ifndef TRUE
+    #define TRUE 1
+#endif
+#ifndef FALSE
+    #define FALSE 0
+#endif
+
+#define STDMETHODCALLTYPE
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define MAKE_HRESULT(sev, fac, code) \
+    ((HRESULT)(((uint32_t)(sev) << 31) | ((uint32_t)(fac) << 16) | ((uint32_t)(code))))
+
+#define S_OK ((HRESULT)0x00000000L)
+#define S_FALSE ((HRESULT)0x00000001L)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+
+#define ZeroMemory(dst, size) memset((dst), 0, (size))
+
+struct LUID
+{
+    DWORD LowPart;
+    LONG HighPart;
+};
+
+struct GUID
+{
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t Data4[8];
+};
+typedef GUID IID;
+typedef const IID& REFIID;
+
+inline bool operator==(const GUID& lhs, const GUID& rhs) { return memcmp(&lhs, &rhs, sizeof(GUID)) == 0; }
+inline bool operator!=(const GUID& lhs, const GUID& rhs) { return !(lhs == rhs); }
+
+/*
+Replacement for the MSVC __uuidof operator. Every mock interface registers its IID
+with MOCK_DECLARE_UUID. Works for both types and expressions, like the original.
+*/
+template<typename T> struct MockUuidOf;
+
+#define MOCK_DECLARE_UUID(type, d1, d2, d3, ...) \
+    template<> struct MockUuidOf<type> \
+    { \
+        static const GUID& Get() { static const GUID guid = { d1, d2, d3, { __VA_ARGS__ } }; return guid; } \
+    };
+
+#define __uuidof(x) (MockUuidOf<__typeof__(x)>::Get())
+
+struct IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+
+protected:
+    ~IUnknown() = default;
+};
+MOCK_DECLARE_UUID(IUnknown, 0x00000000, 0x0000, 0x0000, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46)
+
+#define IID_IUnknown (__uuidof(IUnknown))
+
+inline const GUID& MockGetNullGuid() { static const GUID guid = {}; return guid; }
+#define IID_NULL (MockGetNullGuid())
+
+#define MOCK_ENUM_INT(ENUMTYPE) std::underlying_type<ENUMTYPE>::type
+
+#define DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE) \
+    inline constexpr ENUMTYPE operator|(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((MOCK_ENUM_INT(ENUMTYPE))a) | ((MOCK_ENUM_INT(ENUMTYPE))b)); } \
+    inline ENUMTYPE& operator|=(ENUMTYPE& a, ENUMTYPE b) { return a = a | b; } \
+    inline constexpr ENUMTYPE operator&(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((MOCK_ENUM_INT(ENUMTYPE))a) & ((MOCK_ENUM_INT(ENUMTYPE))b)); } \
+    inline ENUMTYPE& operator&=(ENUMTYPE& a, ENUMTYPE b) { return a = a & b; } \
+    inline constexpr ENUMTYPE operator~(ENUMTYPE a) { return ENUMTYPE(~((MOCK_ENUM_INT(ENUMTYPE))a)); } \
+    inline constexpr ENUMTYPE operator^(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((MOCK_ENUM_INT(ENUMTYPE))a) ^ ((MOCK_ENUM_INT(ENUMTYPE))b)); } \
+    inline ENUMTYPE& operator^=(ENUMTYPE& a, ENUMTYPE b) { return a = a ^ b; }
@@ -0,0 +1,2772 @@
+//
+// Copyright (c) 2019-2026 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/*
+Tests of the library running on top of the headless mock D3D12 device
+(D3D12MA_BUILD_MOCK_DEVICE). They cover what can be verified without a GPU:
+which D3D12 calls the library makes, how it reacts to failures, and accounting.
+*/
+
+#include "D3D12MemAlloc.h"
+#include "MockD3D12.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STRINGIZE(x) STRINGIZE2(x)
+#define STRINGIZE2(x) #x
+#define LINE_STRING STRINGIZE(__LINE__)
+#define CHECK_BOOL(expr)  do { if(!(expr)) { \
+        throw std::runtime_error(__FILE__ "(" LINE_STRING "): ( " #expr " ) == false"); \
+    } } while(false)
+#define CHECK_HR(expr)  do { if(FAILED(expr)) { \
+        throw std::runtime_error(__FILE__ "(" LINE_STRING "): FAILED( " #expr " )"); \
+    } } while(false)
+
+struct MockTestContext
+{
+    MockDevice* device;
+    MockAdapter* adapter;
+    D3D12MA::Allocator* allocator;
+};
+
+static void CreateContext(MockTestContext& outCtx, const MOCK_DEVICE_DESC* mockDesc = NULL,
+    D3D12MA::ALLOCATOR_FLAGS allocatorFlags = D3D12MA::ALLOCATOR_FLAG_NONE)
+{
+    CHECK_HR( CreateMockDevice(mockDesc, &outCtx.device, &outCtx.adapter) );
+
+    D3D12MA::ALLOCATOR_DESC allocatorDesc = {};
+    allocatorDesc.Flags = allocatorFlags;
+    allocatorDesc.pDevice = outCtx.device;
+    allocatorDesc.pAdapter = outCtx.adapter;
+    CHECK_HR( D3D12MA::CreateAllocator(&allocatorDesc, &outCtx.allocator) );
+
+    outCtx.device->ResetCallCounts();
+}
+
+static void DestroyContext(MockTestContext& ctx)
+{
+    ctx.allocator->Release();
+    // Everything created through the device must be gone together with the allocator.
+    CHECK_BOOL( ctx.device->GetLiveHeapCount() == 0 );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 0 );
+    CHECK_BOOL( ctx.device->GetUsage(DXGI_MEMORY_SEGMENT_GROUP_LOCAL) == 0 );
+    CHECK_BOOL( ctx.device->GetUsage(DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL) == 0 );
+    ctx.device->Release();
+    ctx.adapter->Release();
+}
+
+static void FillResourceDescForBuffer(D3D12_RESOURCE_DESC& outResourceDesc, UINT64 size)
+{
+    outResourceDesc = {};
+    outResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    outResourceDesc.Alignment = 0;
+    outResourceDesc.Width = size;
+    outResourceDesc.Height = 1;
+    outResourceDesc.DepthOrArraySize = 1;
+    outResourceDesc.MipLevels = 1;
+    outResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    outResourceDesc.SampleDesc.Count = 1;
+    outResourceDesc.SampleDesc.Quality = 0;
+    outResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    outResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+}
+
+static void FillResourceDescForTexture(D3D12_RESOURCE_DESC& outResourceDesc, UINT width, UINT height, DXGI_FORMAT format)
+{
+    outResourceDesc = {};
+    outResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    outResourceDesc.Alignment = 0;
+    outResourceDesc.Width = width;
+    outResourceDesc.Height = height;
+    outResourceDesc.DepthOrArraySize = 1;
+    outResourceDesc.MipLevels = 1;
+    outResourceDesc.Format = format;
+    outResourceDesc.SampleDesc.Count = 1;
+    outResourceDesc.SampleDesc.Quality = 0;
+    outResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    outResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+}
+
+static void TestPlacedResources()
+{
+    wprintf(L"Test placed resources\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC resDesc;
+    FillResourceDescForBuffer(resDesc, 1024 * 1024);
+
+    const UINT count = 8;
+    D3D12MA::Allocation* allocs[count] = {};
+    for(UINT i = 0; i < count; ++i)
+    {
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+            NULL, &allocs[i], IID_NULL, NULL) );
+        CHECK_BOOL( allocs[i]->GetHeap() != NULL );
+        CHECK_BOOL( allocs[i]->GetResource() != NULL );
+    }
+
+    // All buffers fit into a single heap.
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_HEAP) == 1 );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_PLACED_RESOURCE) == count );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE) == 0 );
+    CHECK_BOOL( ctx.device->GetLiveHeapCount() == 1 );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == count );
+
+    // GPU addresses follow offsets within the heap.
+    for(UINT i = 1; i < count; ++i)
+    {
+        CHECK_BOOL( allocs[i]->GetHeap() == allocs[0]->GetHeap() );
+        const UINT64 addressDiff = allocs[i]->GetResource()->GetGPUVirtualAddress() -
+            allocs[0]->GetResource()->GetGPUVirtualAddress();
+        CHECK_BOOL( addressDiff == allocs[i]->GetOffset() - allocs[0]->GetOffset() );
+    }
+
+    for(UINT i = 0; i < count; ++i)
+        allocs[i]->Release();
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 0 );
+
+    DestroyContext(ctx);
+}
+
+static void TestCommittedResources()
+{
+    wprintf(L"Test committed resources\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+    allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+
+    D3D12_RESOURCE_DESC resDesc;
+    FillResourceDescForBuffer(resDesc, 100 * 1024);
+
+    D3D12MA::Allocation* alloc = NULL;
+    ID3D12Resource* res = NULL;
+    CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_GENERIC_READ,
+        NULL, &alloc, __uuidof(ID3D12Resource), (void**)&res) );
+    CHECK_BOOL( res != NULL && res == alloc->GetResource() );
+    CHECK_BOOL( alloc->GetHeap() == NULL );
+
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE) == 1 );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_HEAP) == 0 );
+    // Upload heap lives in system memory and the size is rounded up to 64 KB.
+    CHECK_BOOL( ctx.device->GetUsage(DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL) == 128 * 1024 );
+    CHECK_BOOL( ctx.device->GetUsage(DXGI_MEMORY_SEGMENT_GROUP_LOCAL) == 0 );
+
+    res->Release();
+    alloc->Release();
+    CHECK_BOOL( ctx.device->GetUsage(DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL) == 0 );
+
+    DestroyContext(ctx);
+}
+
+static void TestCreateHeapFailure()
+{
+    wprintf(L"Test CreateHeap failure\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    MOCK_OPERATION_DESC opDesc = {};
+    opDesc.FailEveryNthCall = 1;
+    ctx.device->SetOperationDesc(MOCK_OPERATION_CREATE_HEAP, opDesc);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC resDesc;
+    FillResourceDescForBuffer(resDesc, 64 * 1024);
+
+    // When no heap can be created, the library falls back to a committed resource.
+    D3D12MA::Allocation* alloc = NULL;
+    CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+        NULL, &alloc, IID_NULL, NULL) );
+    CHECK_BOOL( alloc->GetHeap() == NULL );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_HEAP) > 0 );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE) == 1 );
+    alloc->Release();
+
+    // Allocating memory without a resource has nothing to fall back to.
+    D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+    CHECK_BOOL( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) == E_OUTOFMEMORY );
+
+    // Failure of committed resource creation is reported to the caller.
+    opDesc = {};
+    opDesc.FailEveryNthCall = 1;
+    opDesc.FailResult = E_FAIL;
+    ctx.device->SetOperationDesc(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE, opDesc);
+    alloc = NULL;
+    CHECK_BOOL( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+        NULL, &alloc, IID_NULL, NULL) == E_FAIL );
+    CHECK_BOOL( alloc == NULL );
+
+    // Every 2nd heap fails, every other succeeds.
+    opDesc = {};
+    ctx.device->SetOperationDesc(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE, opDesc);
+    opDesc.FailEveryNthCall = 2;
+    ctx.device->SetOperationDesc(MOCK_OPERATION_CREATE_HEAP, opDesc);
+    ctx.device->ResetCallCounts();
+    D3D12MA::Allocation* allocs[2] = {};
+    for(UINT i = 0; i < 2; ++i)
+    {
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]) );
+        CHECK_BOOL( allocs[i]->GetHeap() != NULL );
+    }
+    allocs[0]->Release();
+    allocs[1]->Release();
+
+    DestroyContext(ctx);
+}
+
+static void TestBudget()
+{
+    wprintf(L"Test budget\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 16ull * 1024 * 1024, 64 * 1024 };
+    D3D12MA::Allocation* alloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+
+    D3D12MA::Budget localBudget = {}, nonLocalBudget = {};
+    ctx.allocator->SetCurrentFrameIndex(1); // Refreshes the budget.
+    ctx.allocator->GetBudget(&localBudget, &nonLocalBudget);
+    CHECK_BOOL( localBudget.Stats.AllocationBytes == allocInfo.SizeInBytes );
+    CHECK_BOOL( localBudget.Stats.BlockBytes >= allocInfo.SizeInBytes );
+    CHECK_BOOL( localBudget.UsageBytes == ctx.device->GetUsage(DXGI_MEMORY_SEGMENT_GROUP_LOCAL) );
+    CHECK_BOOL( localBudget.BudgetBytes == 8ull * 1024 * 1024 * 1024 );
+    CHECK_BOOL( nonLocalBudget.UsageBytes == 0 );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_QUERY_VIDEO_MEMORY_INFO) > 0 );
+
+    // Exceeding the budget with ALLOCATION_FLAG_WITHIN_BUDGET fails before any D3D12 call.
+    ctx.adapter->SetBudget(DXGI_MEMORY_SEGMENT_GROUP_LOCAL, localBudget.UsageBytes + 1024 * 1024);
+    ctx.allocator->SetCurrentFrameIndex(2);
+    ctx.device->ResetCallCounts();
+    allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_WITHIN_BUDGET | D3D12MA::ALLOCATION_FLAG_COMMITTED;
+    allocInfo.SizeInBytes = 64ull * 1024 * 1024;
+    D3D12MA::Allocation* alloc2 = NULL;
+    CHECK_BOOL( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc2) == E_OUTOFMEMORY );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_HEAP) == 0 );
+
+    alloc->Release();
+    DestroyContext(ctx);
+}
+
+static void TestBudgetMultithreaded()
+{
+    wprintf(L"Test budget multithreaded\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    // Allocations made on each thread are released on another one, so budget
+    // counters are incremented and decremented from different threads.
+    const UINT threadCount = 8;
+    const UINT allocsPerThread = 256;
+    const UINT64 allocSize = 64 * 1024;
+    std::vector<D3D12MA::Allocation*> allocs((size_t)threadCount * allocsPerThread);
+    std::vector<std::thread> threads;
+    for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            D3D12MA::ALLOCATION_DESC allocDesc = {};
+            allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { allocSize, allocSize };
+            for(UINT i = 0; i < allocsPerThread; ++i)
+                CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[threadIndex * allocsPerThread + i]) );
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+    threads.clear();
+
+    D3D12MA::Budget localBudget = {};
+    ctx.allocator->GetBudget(&localBudget, NULL);
+    CHECK_BOOL( localBudget.Stats.AllocationCount == threadCount * allocsPerThread );
+    CHECK_BOOL( localBudget.Stats.AllocationBytes == threadCount * allocsPerThread * allocSize );
+
+    for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            const UINT srcThreadIndex = (threadIndex + 1) % threadCount;
+            // Leave half of the allocations of every thread alive.
+            for(UINT i = 0; i < allocsPerThread; i += 2)
+                allocs[srcThreadIndex * allocsPerThread + i]->Release();
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    ctx.allocator->GetBudget(&localBudget, NULL);
+    CHECK_BOOL( localBudget.Stats.AllocationCount == threadCount * allocsPerThread / 2 );
+    CHECK_BOOL( localBudget.Stats.AllocationBytes == threadCount * allocsPerThread / 2 * allocSize );
+
+    D3D12MA::TotalStatistics stats = {};
+    ctx.allocator->CalculateStatistics(&stats);
+    CHECK_BOOL( localBudget.Stats.BlockCount == stats.Total.Stats.BlockCount );
+    CHECK_BOOL( localBudget.Stats.BlockBytes == stats.Total.Stats.BlockBytes );
+
+    for(size_t i = 1; i < allocs.size(); i += 2)
+        allocs[i]->Release();
+    ctx.allocator->GetBudget(&localBudget, NULL);
+    CHECK_BOOL( localBudget.Stats.AllocationCount == 0 );
+    CHECK_BOOL( localBudget.Stats.AllocationBytes == 0 );
+
+    DestroyContext(ctx);
+}
+
+static void TestBudgetUpdateModes()
+{
+    wprintf(L"Test budget update modes\n");
+
+    // Manual: allocations never query DXGI, only explicit UpdateBudget does.
+    {
+        MockTestContext ctx;
+        CreateContext(ctx, NULL, D3D12MA::ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE);
+
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+        for(UINT i = 0; i < 200; ++i)
+        {
+            D3D12MA::Allocation* alloc = NULL;
+            CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+            alloc->Release();
+        }
+        CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_QUERY_VIDEO_MEMORY_INFO) == 0 );
+
+        const UINT64 newBudget = 1024ull * 1024 * 1024;
+        ctx.adapter->SetBudget(DXGI_MEMORY_SEGMENT_GROUP_LOCAL, newBudget);
+        D3D12MA::Budget localBudget = {};
+        ctx.allocator->GetBudget(&localBudget, NULL);
+        CHECK_BOOL( localBudget.BudgetBytes != newBudget );
+
+        CHECK_HR( ctx.allocator->UpdateBudget() );
+        CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_QUERY_VIDEO_MEMORY_INFO) > 0 );
+        ctx.allocator->GetBudget(&localBudget, NULL);
+        CHECK_BOOL( localBudget.BudgetBytes == newBudget );
+
+        DestroyContext(ctx);
+    }
+
+    // Background: the library thread picks up the change on its own.
+    {
+        MockTestContext ctx;
+        CHECK_HR( CreateMockDevice(NULL, &ctx.device, &ctx.adapter) );
+        D3D12MA::ALLOCATOR_DESC allocatorDesc = {};
+        allocatorDesc.Flags = D3D12MA::ALLOCATOR_FLAG_BACKGROUND_BUDGET_UPDATE;
+        allocatorDesc.pDevice = ctx.device;
+        allocatorDesc.pAdapter = ctx.adapter;
+        allocatorDesc.BudgetUpdatePeriodMilliseconds = 1;
+        CHECK_HR( D3D12MA::CreateAllocator(&allocatorDesc, &ctx.allocator) );
+
+        const UINT64 newBudget = 2048ull * 1024 * 1024;
+        ctx.adapter->SetBudget(DXGI_MEMORY_SEGMENT_GROUP_LOCAL, newBudget);
+        D3D12MA::Budget localBudget = {};
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        do
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ctx.allocator->GetBudget(&localBudget, NULL);
+        } while(localBudget.BudgetBytes != newBudget && std::chrono::steady_clock::now() < deadline);
+        CHECK_BOOL( localBudget.BudgetBytes == newBudget );
+
+        DestroyContext(ctx);
+    }
+}
+
+static void TestCapacity()
+{
+    wprintf(L"Test device memory capacity\n");
+
+    MOCK_DEVICE_DESC mockDesc;
+    GetDefaultMockDeviceDesc(mockDesc);
+    mockDesc.LocalMemoryBytes = 256ull * 1024 * 1024;
+
+    MockTestContext ctx;
+    CreateContext(ctx, &mockDesc);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+
+    D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 200ull * 1024 * 1024, 64 * 1024 };
+    D3D12MA::Allocation* alloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+    D3D12MA::Allocation* alloc2 = NULL;
+    CHECK_BOOL( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc2) == E_OUTOFMEMORY );
+    alloc->Release();
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc2) );
+    alloc2->Release();
+
+    DestroyContext(ctx);
+}
+
+static void TestResourceHeapTier1()
+{
+    wprintf(L"Test resource heap tier 1\n");
+
+    MOCK_DEVICE_DESC mockDesc;
+    GetDefaultMockDeviceDesc(mockDesc);
+    mockDesc.ResourceHeapTier = D3D12_RESOURCE_HEAP_TIER_1;
+
+    MockTestContext ctx;
+    CreateContext(ctx, &mockDesc);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC bufDesc;
+    FillResourceDescForBuffer(bufDesc, 64 * 1024);
+    D3D12_RESOURCE_DESC texDesc;
+    FillResourceDescForTexture(texDesc, 256, 256, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+    // The mock rejects heaps that mix resource classes on tier 1, so success
+    // means the library created separate heaps for buffers and textures.
+    D3D12MA::Allocation* bufAlloc = NULL;
+    D3D12MA::Allocation* texAlloc = NULL;
+    CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &bufDesc, D3D12_RESOURCE_STATE_COMMON,
+        NULL, &bufAlloc, IID_NULL, NULL) );
+    CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &texDesc, D3D12_RESOURCE_STATE_COMMON,
+        NULL, &texAlloc, IID_NULL, NULL) );
+    CHECK_BOOL( bufAlloc->GetHeap() != NULL && texAlloc->GetHeap() != NULL );
+    CHECK_BOOL( bufAlloc->GetHeap() != texAlloc->GetHeap() );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_HEAP) == 2 );
+
+    bufAlloc->Release();
+    texAlloc->Release();
+    DestroyContext(ctx);
+}
+
+static void TestSmallTextureAlignment()
+{
+    wprintf(L"Test small texture alignment\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC texDesc;
+    FillResourceDescForTexture(texDesc, 32, 32, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+    D3D12MA::Allocation* allocs[2] = {};
+    for(UINT i = 0; i < 2; ++i)
+    {
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &texDesc, D3D12_RESOURCE_STATE_COMMON,
+            NULL, &allocs[i], IID_NULL, NULL) );
+    }
+    CHECK_BOOL( allocs[0]->GetSize() == 4096 );
+    CHECK_BOOL( allocs[0]->GetHeap() == allocs[1]->GetHeap() );
+    const UINT64 offsetDiff = allocs[1]->GetOffset() > allocs[0]->GetOffset() ?
+        allocs[1]->GetOffset() - allocs[0]->GetOffset() : allocs[0]->GetOffset() - allocs[1]->GetOffset();
+    CHECK_BOOL( offsetDiff == 4096 );
+
+    allocs[0]->Release();
+    allocs[1]->Release();
+    DestroyContext(ctx);
+}
+
+static void TestLatency()
+{
+    wprintf(L"Test latency injection\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT64 latencyNs = 2000000; // 2 ms
+    MOCK_OPERATION_DESC opDesc = {};
+    opDesc.LatencyNanoseconds = latencyNs;
+    ctx.device->SetOperationDesc(MOCK_OPERATION_CREATE_HEAP, opDesc);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+
+    const auto begin = std::chrono::steady_clock::now();
+    D3D12MA::Allocation* alloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    CHECK_BOOL( std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() >= (long long)latencyNs );
+    alloc->Release();
+
+    DestroyContext(ctx);
+}
+
+static void TestMultithreading()
+{
+    wprintf(L"Test multithreading\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT threadCount = 8;
+    const UINT iterationCount = 200;
+    const UINT batchSize = 100; // More than fits in a single cache of Allocation objects.
+
+    std::vector<std::thread> threads;
+    std::vector<D3D12MA::Allocation*> crossThreadAllocs(threadCount * batchSize);
+    for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            D3D12MA::ALLOCATION_DESC allocDesc = {};
+            allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 256, 256 };
+            D3D12MA::Allocation* allocs[batchSize];
+            for(UINT iter = 0; iter < iterationCount; ++iter)
+            {
+                for(UINT i = 0; i < batchSize; ++i)
+                {
+                    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]) );
+                    CHECK_BOOL( allocs[i]->GetSize() == 256 );
+                }
+                for(UINT i = 0; i < batchSize; ++i)
+                    allocs[i]->Release();
+            }
+            // Left for another thread to free.
+            for(UINT i = 0; i < batchSize; ++i)
+            {
+                CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo,
+                    &crossThreadAllocs[threadIndex * batchSize + i]) );
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    D3D12MA::TotalStatistics stats;
+    ctx.allocator->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Total.Stats.AllocationCount == threadCount * batchSize );
+
+    threads.clear();
+    for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            const UINT srcThreadIndex = (threadIndex + 1) % threadCount;
+            for(UINT i = 0; i < batchSize; ++i)
+                crossThreadAllocs[srcThreadIndex * batchSize + i]->Release();
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    ctx.allocator->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Total.Stats.AllocationCount == 0 );
+
+    DestroyContext(ctx);
+}
+
+static void TestBatch()
+{
+    wprintf(L"Test batch allocation\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT count = 64;
+    std::vector<D3D12MA::ALLOCATION_DESC> allocDescs(count);
+    std::vector<D3D12_RESOURCE_ALLOCATION_INFO> allocInfos(count);
+    std::vector<D3D12MA::Allocation*> allocs(count);
+    for(UINT i = 0; i < count; ++i)
+    {
+        allocDescs[i] = {};
+        allocDescs[i].HeapType = (i % 2) ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+        allocInfos[i] = { 64 * 1024, 64 * 1024 };
+    }
+
+    // Memory only: one heap per heap type.
+    CHECK_HR( ctx.allocator->AllocateMemoryBatch(count, allocDescs.data(), allocInfos.data(), allocs.data()) );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_HEAP) == 2 );
+    for(UINT i = 0; i < count; ++i)
+    {
+        CHECK_BOOL( allocs[i] != NULL && allocs[i]->GetHeap() != NULL && allocs[i]->GetResource() == NULL );
+        CHECK_BOOL( allocs[i]->GetHeap()->GetDesc().Properties.Type == allocDescs[i].HeapType );
+    }
+    for(UINT i = 0; i < count; ++i)
+        allocs[i]->Release();
+
+    // Resources: placed ones plus one big buffer that prefers a committed resource.
+    std::vector<D3D12_RESOURCE_DESC> resDescs(count);
+    std::vector<D3D12_RESOURCE_STATES> states(count, D3D12_RESOURCE_STATE_COMMON);
+    for(UINT i = 0; i < count; ++i)
+        FillResourceDescForBuffer(resDescs[i], 64 * 1024);
+    FillResourceDescForBuffer(resDescs[count - 1], 48ull * 1024 * 1024);
+    allocDescs[count - 1].HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    states[count - 1] = D3D12_RESOURCE_STATE_COMMON;
+
+    ctx.device->ResetCallCounts();
+    CHECK_HR( ctx.allocator->CreateResourceBatch(count, allocDescs.data(), resDescs.data(),
+        states.data(), NULL, allocs.data()) );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE) == 1 );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_PLACED_RESOURCE) == count - 1 );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == count );
+    for(UINT i = 0; i < count; ++i)
+    {
+        CHECK_BOOL( allocs[i] != NULL && allocs[i]->GetResource() != NULL );
+        CHECK_BOOL( allocs[i]->GetResource()->GetDesc().Width == resDescs[i].Width );
+    }
+    CHECK_BOOL( allocs[count - 1]->GetHeap() == NULL );
+    for(UINT i = 0; i < count; ++i)
+        allocs[i]->Release();
+
+    // All or nothing: a failure in the middle of the batch releases everything created so far.
+    MOCK_OPERATION_DESC opDesc = {};
+    opDesc.FailAfterCallCount = count / 2;
+    ctx.device->SetOperationDesc(MOCK_OPERATION_CREATE_PLACED_RESOURCE, opDesc);
+    ctx.device->ResetCallCounts();
+    CHECK_BOOL( ctx.allocator->CreateResourceBatch(count, allocDescs.data(), resDescs.data(),
+        states.data(), NULL, allocs.data()) == E_OUTOFMEMORY );
+    for(UINT i = 0; i < count; ++i)
+        CHECK_BOOL( allocs[i] == NULL );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 0 );
+
+    // Requests that cannot be satisfied fail the whole batch too.
+    ctx.device->SetOperationDesc(MOCK_OPERATION_CREATE_PLACED_RESOURCE, MOCK_OPERATION_DESC{});
+    allocDescs[count / 2].Flags = D3D12MA::ALLOCATION_FLAG_NEVER_ALLOCATE;
+    allocInfos[count / 2].SizeInBytes = 128ull * 1024 * 1024;
+    CHECK_BOOL( FAILED(ctx.allocator->AllocateMemoryBatch(count, allocDescs.data(), allocInfos.data(), allocs.data())) );
+    for(UINT i = 0; i < count; ++i)
+        CHECK_BOOL( allocs[i] == NULL );
+
+    D3D12MA::TotalStatistics stats;
+    ctx.allocator->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Total.Stats.AllocationCount == 0 );
+
+    DestroyContext(ctx);
+}
+
+static void TestFreeAllocations()
+{
+    wprintf(L"Test FreeAllocations\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT count = 300;
+    std::vector<D3D12MA::Allocation*> allocs(count);
+    for(UINT i = 0; i < count; ++i)
+    {
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = (i % 3 == 2) ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+        if(i % 50 == 0)
+            allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+        if(i % 2)
+        {
+            D3D12_RESOURCE_DESC resDesc;
+            FillResourceDescForBuffer(resDesc, 64 * 1024);
+            CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+                NULL, &allocs[i], IID_NULL, NULL) );
+        }
+        else
+        {
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+            CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]) );
+        }
+    }
+    // Null entries are skipped and references held elsewhere are respected.
+    allocs[10]->AddRef();
+    D3D12MA::Allocation* const survivor = allocs[10];
+    D3D12MA::Allocation* const skipped = allocs[20];
+    allocs[20] = NULL;
+
+    ctx.allocator->FreeAllocations(count, allocs.data());
+
+    D3D12MA::TotalStatistics stats;
+    ctx.allocator->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Total.Stats.AllocationCount == 2 );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 0 );
+    // At most one empty block is kept per heap type, next to the ones still in use.
+    CHECK_BOOL( stats.Total.Stats.BlockCount <= 3 );
+
+    survivor->Release();
+    ctx.allocator->FreeAllocations(1, &skipped);
+    ctx.allocator->FreeAllocations(0, NULL);
+    ctx.allocator->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Total.Stats.AllocationCount == 0 );
+
+    DestroyContext(ctx);
+}
+
+static void TestReleaseDeferred()
+{
+    wprintf(L"Test ReleaseDeferred\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    D3D12_RESOURCE_DESC resDesc;
+    FillResourceDescForBuffer(resDesc, 64 * 1024);
+
+    auto getAllocationCount = [&]() -> UINT
+    {
+        D3D12MA::TotalStatistics stats;
+        ctx.allocator->CalculateStatistics(&stats);
+        return stats.Total.Stats.AllocationCount;
+    };
+
+    // Frame indices close to wrap-around of UINT.
+    const UINT firstFrame = UINT_MAX - 1;
+    ctx.allocator->SetCurrentFrameIndex(firstFrame);
+    for(UINT frame = 0; frame < 4; ++frame)
+    {
+        for(UINT i = 0; i < 10; ++i)
+        {
+            D3D12MA::Allocation* alloc = NULL;
+            CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+                NULL, &alloc, IID_NULL, NULL) );
+            ctx.allocator->ReleaseDeferred(alloc, firstFrame + frame);
+        }
+    }
+    ctx.allocator->ReleaseDeferred(NULL, firstFrame);
+    CHECK_BOOL( getAllocationCount() == 40 );
+
+    // Still the same frame - nothing is released.
+    ctx.allocator->SetCurrentFrameIndex(firstFrame);
+    CHECK_BOOL( getAllocationCount() == 40 );
+    ctx.allocator->SetCurrentFrameIndex(firstFrame + 1);
+    CHECK_BOOL( getAllocationCount() == 30 );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 30 );
+    // Skipping frames releases everything that became safe.
+    ctx.allocator->SetCurrentFrameIndex(firstFrame + 3);
+    CHECK_BOOL( getAllocationCount() == 10 );
+
+    ctx.allocator->ReleaseAllDeferred();
+    CHECK_BOOL( getAllocationCount() == 0 );
+
+    // Allocations still queued are released together with the allocator.
+    D3D12MA::Allocation* alloc = NULL;
+    CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+        NULL, &alloc, IID_NULL, NULL) );
+    ctx.allocator->ReleaseDeferred(alloc, firstFrame + 100);
+
+    DestroyContext(ctx);
+}
+
+static void TestManyBlocks()
+{
+    wprintf(L"Test many blocks\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 allocSize = 64 * 1024;
+    const UINT allocsPerBlock = (UINT)(blockSize / allocSize);
+    const UINT blockCount = 64;
+
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    poolDesc.BlockSize = blockSize;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( ctx.allocator->CreatePool(&poolDesc, &pool) );
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.CustomPool = pool;
+    const D3D12_RESOURCE_ALLOCATION_INFO smallInfo = { allocSize, allocSize };
+    std::vector<D3D12MA::Allocation*> allocs(blockCount * allocsPerBlock);
+    for(D3D12MA::Allocation*& alloc : allocs)
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &smallInfo, &alloc) );
+
+    D3D12MA::Statistics stats = {};
+    pool->GetStatistics(&stats);
+    CHECK_BOOL( stats.BlockCount == blockCount );
+
+    // Every block gets half free, but in pieces too small for a larger allocation.
+    for(size_t i = 0; i < allocs.size(); i += 2)
+    {
+        allocs[i]->Release();
+        allocs[i] = NULL;
+    }
+    // Make a single block entirely empty.
+    ID3D12Heap* const emptiedHeap = allocs[10 * allocsPerBlock + 1]->GetHeap();
+    for(size_t i = 10 * allocsPerBlock + 1; i < 11 * allocsPerBlock; i += 2)
+    {
+        allocs[i]->Release();
+        allocs[i] = NULL;
+    }
+
+    // Fits only in the empty block.
+    const D3D12_RESOURCE_ALLOCATION_INFO largeInfo = { blockSize * 3 / 4, allocSize };
+    D3D12MA::Allocation* largeAlloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &largeInfo, &largeAlloc) );
+    CHECK_BOOL( largeAlloc->GetHeap() == emptiedHeap );
+
+    // Fits nowhere, needs a new block.
+    D3D12MA::Allocation* largeAlloc2 = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &largeInfo, &largeAlloc2) );
+    pool->GetStatistics(&stats);
+    CHECK_BOOL( stats.BlockCount == blockCount + 1 );
+
+    // Small allocations still fill the gaps instead of new blocks.
+    for(size_t i = 0; i < allocs.size(); i += 2)
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &smallInfo, &allocs[i]) );
+    pool->GetStatistics(&stats);
+    CHECK_BOOL( stats.BlockCount == blockCount + 1 );
+
+    // Defragmentation reorders blocks of the pool.
+    for(size_t i = 0; i < allocs.size(); ++i)
+    {
+        if(allocs[i] != NULL && i % 3 != 0)
+        {
+            allocs[i]->Release();
+            allocs[i] = NULL;
+        }
+    }
+    D3D12MA::DEFRAGMENTATION_DESC defragDesc = {};
+    defragDesc.Flags = D3D12MA::DEFRAGMENTATION_FLAG_ALGORITHM_FULL;
+    D3D12MA::DefragmentationContext* defragCtx = NULL;
+    CHECK_HR( pool->BeginDefragmentation(&defragDesc, &defragCtx) );
+    for(;;)
+    {
+        D3D12MA::DEFRAGMENTATION_PASS_MOVE_INFO passInfo = {};
+        if(defragCtx->BeginPass(&passInfo) == S_OK)
+            break;
+        if(defragCtx->EndPass(&passInfo) == S_OK)
+            break;
+    }
+    defragCtx->Release();
+    pool->GetStatistics(&stats);
+    CHECK_BOOL( stats.BlockCount < blockCount );
+
+    D3D12MA::Allocation* largeAlloc3 = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &largeInfo, &largeAlloc3) );
+
+    largeAlloc->Release();
+    largeAlloc2->Release();
+    largeAlloc3->Release();
+    for(D3D12MA::Allocation* alloc : allocs)
+    {
+        if(alloc != NULL)
+            alloc->Release();
+    }
+    pool->Release();
+    DestroyContext(ctx);
+}
+
+static void TestLargestFreeRegion()
+{
+    wprintf(L"Test largest free region\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 allocSize = 64 * 1024;
+    const UINT allocsPerBlock = (UINT)(blockSize / allocSize);
+
+    for(UINT linear = 0; linear < 2; ++linear)
+    {
+        D3D12MA::POOL_DESC poolDesc = {};
+        poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        poolDesc.BlockSize = blockSize;
+        if(linear)
+            poolDesc.Flags = D3D12MA::POOL_FLAG_ALGORITHM_LINEAR;
+        D3D12MA::Pool* pool = NULL;
+        CHECK_HR( ctx.allocator->CreatePool(&poolDesc, &pool) );
+
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.CustomPool = pool;
+        const D3D12_RESOURCE_ALLOCATION_INFO smallInfo = { allocSize, allocSize };
+        std::vector<D3D12MA::Allocation*> allocs(allocsPerBlock);
+        for(D3D12MA::Allocation*& alloc : allocs)
+            CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &smallInfo, &alloc) );
+        ID3D12Heap* const firstHeap = allocs[0]->GetHeap();
+
+        // Free space of 6 * allocSize in total, largest contiguous region being 3 * allocSize
+        // at the beginning of the block.
+        const UINT freedIndices[] = { 0, 1, 2, 5, 9, 10 };
+        for(UINT i : freedIndices)
+        {
+            allocs[i]->Release();
+            allocs[i] = NULL;
+        }
+
+        // Less than the sum of free space, but more than any region: needs a new block.
+        const D3D12_RESOURCE_ALLOCATION_INFO tooLargeInfo = { allocSize * 4, allocSize };
+        D3D12MA::Allocation* tooLargeAlloc = NULL;
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &tooLargeInfo, &tooLargeAlloc) );
+        CHECK_BOOL( tooLargeAlloc->GetHeap() != firstHeap );
+
+        // Exactly the largest region still fits in the first block.
+        const D3D12_RESOURCE_ALLOCATION_INFO largestInfo = { allocSize * 3, allocSize };
+        D3D12MA::Allocation* largestAlloc = NULL;
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &largestInfo, &largestAlloc) );
+        CHECK_BOOL( largestAlloc->GetHeap() == firstHeap );
+        CHECK_BOOL( largestAlloc->GetOffset() == 0 );
+
+        D3D12MA::Statistics stats = {};
+        pool->GetStatistics(&stats);
+        CHECK_BOOL( stats.BlockCount == 2 );
+
+        largestAlloc->Release();
+        tooLargeAlloc->Release();
+        for(D3D12MA::Allocation* alloc : allocs)
+        {
+            if(alloc != NULL)
+                alloc->Release();
+        }
+        pool->Release();
+    }
+
+    DestroyContext(ctx);
+}
+
+static UINT64 RoundDownToPowerOf2(UINT64 v)
+{
+    UINT64 result = 1;
+    while(result <= v / 2)
+        result *= 2;
+    return result;
+}
+
+// Checks statistics read from the incremental snapshot against the exact ones.
+static void CheckLockFreeStatistics(const D3D12MA::DetailedStatistics& lockFree, const D3D12MA::DetailedStatistics& exact)
+{
+    CHECK_BOOL( lockFree.Stats.BlockCount == exact.Stats.BlockCount );
+    CHECK_BOOL( lockFree.Stats.AllocationCount == exact.Stats.AllocationCount );
+    CHECK_BOOL( lockFree.Stats.BlockBytes == exact.Stats.BlockBytes );
+    CHECK_BOOL( lockFree.Stats.AllocationBytes == exact.Stats.AllocationBytes );
+    CHECK_BOOL( lockFree.UnusedRangeCount == exact.UnusedRangeCount );
+    if(exact.Stats.AllocationCount > 0)
+    {
+        CHECK_BOOL( lockFree.AllocationSizeMin == RoundDownToPowerOf2(exact.AllocationSizeMin) );
+        CHECK_BOOL( lockFree.AllocationSizeMax == RoundDownToPowerOf2(exact.AllocationSizeMax) );
+    }
+    if(exact.UnusedRangeCount > 0)
+    {
+        CHECK_BOOL( lockFree.UnusedRangeSizeMin == RoundDownToPowerOf2(exact.UnusedRangeSizeMin) );
+        CHECK_BOOL( lockFree.UnusedRangeSizeMax == RoundDownToPowerOf2(exact.UnusedRangeSizeMax) );
+    }
+}
+
+static void TestLockFreeStatistics()
+{
+    wprintf(L"Test lock-free statistics\n");
+
+    // The same sequence of operations is made on an allocator with and without the flag.
+    MockTestContext ctx[2];
+    CreateContext(ctx[0]);
+    CreateContext(ctx[1], NULL, D3D12MA::ALLOCATOR_FLAG_LOCK_FREE_STATISTICS);
+
+    D3D12MA::Pool* pools[2][2] = {};
+    for(UINT ctxIndex = 0; ctxIndex < 2; ++ctxIndex)
+    {
+        for(UINT linear = 0; linear < 2; ++linear)
+        {
+            D3D12MA::POOL_DESC poolDesc = {};
+            poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+            poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            poolDesc.BlockSize = 4 * 1024 * 1024;
+            if(linear)
+                poolDesc.Flags = D3D12MA::POOL_FLAG_ALGORITHM_LINEAR;
+            CHECK_HR( ctx[ctxIndex].allocator->CreatePool(&poolDesc, &pools[ctxIndex][linear]) );
+        }
+    }
+
+    // Telemetry thread reading statistics while the allocations are made.
+    std::atomic<bool> stop(false);
+    std::thread reader([&]()
+    {
+        while(!stop)
+        {
+            D3D12MA::TotalStatistics stats = {};
+            ctx[1].allocator->CalculateStatistics(&stats);
+            CHECK_BOOL( stats.Total.Stats.AllocationBytes <= stats.Total.Stats.BlockBytes );
+            CHECK_BOOL( stats.Total.Stats.AllocationCount == 0 ||
+                stats.Total.AllocationSizeMin <= stats.Total.AllocationSizeMax );
+        }
+    });
+
+    std::vector<D3D12MA::Allocation*> allocs[2];
+    UINT32 seed = 1;
+    for(UINT i = 0; i < 4000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        const UINT32 rand = seed >> 8;
+        if(rand % 3 == 0 && !allocs[0].empty())
+        {
+            const size_t allocIndex = (rand / 3) % allocs[0].size();
+            for(UINT ctxIndex = 0; ctxIndex < 2; ++ctxIndex)
+            {
+                allocs[ctxIndex][allocIndex]->Release();
+                allocs[ctxIndex][allocIndex] = allocs[ctxIndex].back();
+                allocs[ctxIndex].pop_back();
+            }
+            continue;
+        }
+
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { (rand % 256 + 1) * 4096, 64 * 1024 };
+        for(UINT ctxIndex = 0; ctxIndex < 2; ++ctxIndex)
+        {
+            D3D12MA::ALLOCATION_DESC allocDesc = {};
+            allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+            switch(rand % 5)
+            {
+            case 0: allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED; break;
+            case 1: allocDesc.CustomPool = pools[ctxIndex][0]; break;
+            case 2: allocDesc.CustomPool = pools[ctxIndex][1]; break;
+            }
+            D3D12MA::Allocation* alloc = NULL;
+            CHECK_HR( ctx[ctxIndex].allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+            allocs[ctxIndex].push_back(alloc);
+        }
+    }
+    stop = true;
+    reader.join();
+
+    D3D12MA::TotalStatistics totalStats[2] = {};
+    for(UINT ctxIndex = 0; ctxIndex < 2; ++ctxIndex)
+        ctx[ctxIndex].allocator->CalculateStatistics(&totalStats[ctxIndex]);
+    CHECK_BOOL( totalStats[0].Total.Stats.AllocationCount > 0 );
+    CheckLockFreeStatistics(totalStats[1].Total, totalStats[0].Total);
+    for(size_t i = 0; i < sizeof(totalStats[0].HeapType) / sizeof(totalStats[0].HeapType[0]); ++i)
+        CheckLockFreeStatistics(totalStats[1].HeapType[i], totalStats[0].HeapType[i]);
+    for(size_t i = 0; i < sizeof(totalStats[0].MemorySegmentGroup) / sizeof(totalStats[0].MemorySegmentGroup[0]); ++i)
+        CheckLockFreeStatistics(totalStats[1].MemorySegmentGroup[i], totalStats[0].MemorySegmentGroup[i]);
+
+    // The linear pool is not covered by the snapshot, so its statistics are exact.
+    D3D12MA::DetailedStatistics poolStats[2] = {};
+    pools[0][1]->CalculateStatistics(&poolStats[0]);
+    pools[1][1]->CalculateStatistics(&poolStats[1]);
+    CHECK_BOOL( poolStats[1].Stats.AllocationCount == poolStats[0].Stats.AllocationCount );
+    CHECK_BOOL( poolStats[1].Stats.AllocationBytes == poolStats[0].Stats.AllocationBytes );
+    CHECK_BOOL( poolStats[1].UnusedRangeCount == poolStats[0].UnusedRangeCount );
+    CHECK_BOOL( poolStats[1].AllocationSizeMin == poolStats[0].AllocationSizeMin );
+    CHECK_BOOL( poolStats[1].AllocationSizeMax == poolStats[0].AllocationSizeMax );
+    CHECK_BOOL( poolStats[1].UnusedRangeSizeMin == poolStats[0].UnusedRangeSizeMin );
+    CHECK_BOOL( poolStats[1].UnusedRangeSizeMax == poolStats[0].UnusedRangeSizeMax );
+
+    pools[0][0]->CalculateStatistics(&poolStats[0]);
+    pools[1][0]->CalculateStatistics(&poolStats[1]);
+    CheckLockFreeStatistics(poolStats[1], poolStats[0]);
+    D3D12MA::Statistics poolBriefStats = {};
+    pools[1][0]->GetStatistics(&poolBriefStats);
+    CHECK_BOOL( poolBriefStats.AllocationCount == poolStats[0].Stats.AllocationCount );
+    CHECK_BOOL( poolBriefStats.AllocationBytes == poolStats[0].Stats.AllocationBytes );
+    CHECK_BOOL( poolBriefStats.BlockBytes == poolStats[0].Stats.BlockBytes );
+
+    for(UINT ctxIndex = 0; ctxIndex < 2; ++ctxIndex)
+    {
+        for(D3D12MA::Allocation* alloc : allocs[ctxIndex])
+            alloc->Release();
+        pools[ctxIndex][0]->Release();
+        pools[ctxIndex][1]->Release();
+    }
+
+    // Blocks released together with the pools are removed from the snapshot.
+    ctx[1].allocator->CalculateStatistics(&totalStats[1]);
+    ctx[0].allocator->CalculateStatistics(&totalStats[0]);
+    CheckLockFreeStatistics(totalStats[1].Total, totalStats[0].Total);
+    CHECK_BOOL( totalStats[1].Total.Stats.AllocationCount == 0 );
+
+    DestroyContext(ctx[1]);
+    DestroyContext(ctx[0]);
+}
+
+static void TestResourceAllocationInfoCache()
+{
+    wprintf(L"Test resource allocation info cache\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx, NULL, D3D12MA::ALLOCATOR_FLAG_CACHE_RESOURCE_ALLOCATION_INFO);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    // Small texture: the cached result must keep the small alignment granted by the driver.
+    D3D12_RESOURCE_DESC texDesc;
+    FillResourceDescForTexture(texDesc, 32, 32, DXGI_FORMAT_R8G8B8A8_UNORM);
+    D3D12MA::Allocation* allocs[2] = {};
+    for(UINT i = 0; i < 2; ++i)
+    {
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &texDesc, D3D12_RESOURCE_STATE_COMMON,
+            NULL, &allocs[i], IID_NULL, NULL) );
+        CHECK_BOOL( allocs[i]->GetSize() == 4096 );
+        if(i == 0)
+            CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO) == 1 );
+    }
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO) == 1 );
+    const UINT64 offsetDiff = allocs[1]->GetOffset() > allocs[0]->GetOffset() ?
+        allocs[1]->GetOffset() - allocs[0]->GetOffset() : allocs[0]->GetOffset() - allocs[1]->GetOffset();
+    CHECK_BOOL( offsetDiff == 4096 );
+    allocs[0]->Release();
+    allocs[1]->Release();
+
+    // Render target: small alignment is not tried.
+    FillResourceDescForTexture(texDesc, 1024, 1024, DXGI_FORMAT_R8G8B8A8_UNORM);
+    texDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    D3D12_RESOURCE_ALLOCATION_INFO allocInfos[2] = {};
+    for(UINT i = 0; i < 2; ++i)
+    {
+        D3D12MA::Allocation* alloc = NULL;
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &texDesc, D3D12_RESOURCE_STATE_RENDER_TARGET,
+            NULL, &alloc, IID_NULL, NULL) );
+        allocInfos[i] = { alloc->GetSize(), alloc->GetAlignment() };
+        alloc->Release();
+    }
+    CHECK_BOOL( allocInfos[0].SizeInBytes == allocInfos[1].SizeInBytes );
+    CHECK_BOOL( allocInfos[0].Alignment == allocInfos[1].Alignment );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO) == 2 );
+
+    D3D12MA::ResourceAllocationInfoCacheStatistics stats = {};
+    ctx.allocator->GetResourceAllocationInfoCacheStatistics(&stats);
+    CHECK_BOOL( stats.HitCount == 2 && stats.MissCount == 2 && stats.EntryCount == 2 );
+
+    // The cache is bounded.
+    for(UINT i = 0; i < 1000; ++i)
+    {
+        FillResourceDescForTexture(texDesc, 64 + i, 64, DXGI_FORMAT_R8G8B8A8_UNORM);
+        D3D12MA::Allocation* alloc = NULL;
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &texDesc, D3D12_RESOURCE_STATE_COMMON,
+            NULL, &alloc, IID_NULL, NULL) );
+        alloc->Release();
+    }
+    ctx.allocator->GetResourceAllocationInfoCacheStatistics(&stats);
+    CHECK_BOOL( stats.MissCount == 1002 && stats.EntryCount <= 256 );
+
+    DestroyContext(ctx);
+
+    // Without the flag, nothing is cached.
+    CreateContext(ctx);
+    for(UINT i = 0; i < 2; ++i)
+    {
+        D3D12MA::Allocation* alloc = NULL;
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &texDesc, D3D12_RESOURCE_STATE_COMMON,
+            NULL, &alloc, IID_NULL, NULL) );
+        alloc->Release();
+    }
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_GET_RESOURCE_ALLOCATION_INFO) == 2 );
+    ctx.allocator->GetResourceAllocationInfoCacheStatistics(&stats);
+    CHECK_BOOL( stats.HitCount == 0 && stats.MissCount == 0 && stats.EntryCount == 0 );
+    DestroyContext(ctx);
+}
+
+static void AppendStatsStringPart(const void* pData, size_t byteCount, void* pPrivateData)
+{
+    std::vector<std::vector<unsigned char>>& parts = *(std::vector<std::vector<unsigned char>>*)pPrivateData;
+    const unsigned char* const bytes = (const unsigned char*)pData;
+    parts.emplace_back(bytes, bytes + byteCount);
+}
+
+// Encodes a string returned by BuildStatsString the way WriteStatsString should.
+static std::vector<unsigned char> EncodeStatsString(const WCHAR* str, D3D12MA::STATS_STRING_ENCODING encoding)
+{
+    std::vector<unsigned char> result;
+    for(const WCHAR* p = str; *p; ++p)
+    {
+        const UINT ch = (UINT)*p;
+        CHECK_BOOL( ch < 0xD800 || (ch > 0xDFFF && ch < 0x10000) );
+        if(encoding == D3D12MA::STATS_STRING_ENCODING_UTF16)
+        {
+            result.push_back((unsigned char)(ch & 0xFF));
+            result.push_back((unsigned char)(ch >> 8));
+        }
+        else if(ch < 0x80)
+            result.push_back((unsigned char)ch);
+        else if(ch < 0x800)
+        {
+            result.push_back((unsigned char)(0xC0 | (ch >> 6)));
+            result.push_back((unsigned char)(0x80 | (ch & 0x3F)));
+        }
+        else
+        {
+            result.push_back((unsigned char)(0xE0 | (ch >> 12)));
+            result.push_back((unsigned char)(0x80 | ((ch >> 6) & 0x3F)));
+            result.push_back((unsigned char)(0x80 | (ch & 0x3F)));
+        }
+    }
+    return result;
+}
+
+#if D3D12MA_PROFILE_LOCKS
+// Removes the "LockProfiles" object from an encoded stats string. Lock profiles count
+// the locks taken by previous dumps, so they differ between two dumps of the same state.
+static void StripLockProfiles(std::vector<unsigned char>& bytes, D3D12MA::STATS_STRING_ENCODING encoding)
+{
+    const std::vector<unsigned char> key = EncodeStatsString(L"\"LockProfiles\"", encoding);
+    const auto keyBegin = std::search(bytes.begin(), bytes.end(), key.begin(), key.end());
+    CHECK_BOOL( keyBegin != bytes.end() );
+    // The object contains only ASCII characters, so braces can be matched one code unit at a time.
+    const size_t unitSize = encoding == D3D12MA::STATS_STRING_ENCODING_UTF16 ? 2 : 1;
+    size_t end = (size_t)(keyBegin - bytes.begin()) + key.size();
+    UINT depth = 0;
+    for(; end < bytes.size(); end += unitSize)
+    {
+        if(bytes[end] == '{')
+            ++depth;
+        else if(bytes[end] == '}' && --depth == 0)
+            break;
+    }
+    CHECK_BOOL( end < bytes.size() );
+    bytes.erase(keyBegin, bytes.begin() + end + unitSize);
+}
+#endif
+
+static void TestWriteStatsString()
+{
+    wprintf(L"Test write stats string\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    // Enough allocations for the detailed map to be written in many parts.
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+    std::vector<D3D12MA::Allocation*> allocs(2000);
+    for(size_t i = 0; i < allocs.size(); ++i)
+    {
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]) );
+        allocs[i]->SetName(i % 2 ? L"Texture \u00E9\u4E2D" : L"Buffer");
+    }
+
+    for(BOOL detailedMap = FALSE; detailedMap <= TRUE; ++detailedMap)
+    {
+        WCHAR* str = NULL;
+        ctx.allocator->BuildStatsString(&str, detailedMap);
+        // BuildStatsString starts with a byte order mark that is kept only in UTF-16.
+        CHECK_BOOL( str[0] == 0xFEFF );
+
+        const D3D12MA::STATS_STRING_ENCODING encodings[] = {
+            D3D12MA::STATS_STRING_ENCODING_UTF16,
+            D3D12MA::STATS_STRING_ENCODING_UTF8 };
+        for(D3D12MA::STATS_STRING_ENCODING encoding : encodings)
+        {
+            std::vector<std::vector<unsigned char>> parts;
+            ctx.allocator->WriteStatsString(AppendStatsStringPart, &parts, encoding, detailedMap);
+            std::vector<unsigned char> written;
+            for(const std::vector<unsigned char>& part : parts)
+            {
+                CHECK_BOOL( !part.empty() );
+                written.insert(written.end(), part.begin(), part.end());
+            }
+            const WCHAR* const expectedStr = encoding == D3D12MA::STATS_STRING_ENCODING_UTF16 ? str : str + 1;
+            std::vector<unsigned char> expected = EncodeStatsString(expectedStr, encoding);
+#if D3D12MA_PROFILE_LOCKS
+            StripLockProfiles(written, encoding);
+            StripLockProfiles(expected, encoding);
+#endif
+            CHECK_BOOL( written == expected );
+            CHECK_BOOL( detailedMap == FALSE || parts.size() > 1 );
+        }
+        ctx.allocator->FreeStatsString(str);
+    }
+
+    for(D3D12MA::Allocation* alloc : allocs)
+        alloc->Release();
+    DestroyContext(ctx);
+
+    D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+    blockDesc.Size = 1024 * 1024;
+    D3D12MA::VirtualBlock* block = NULL;
+    CHECK_HR( D3D12MA::CreateVirtualBlock(&blockDesc, &block) );
+    D3D12MA::VIRTUAL_ALLOCATION_DESC virtualAllocDesc = {};
+    virtualAllocDesc.Size = 1000;
+    D3D12MA::VirtualAllocation virtualAlloc;
+    CHECK_HR( block->Allocate(&virtualAllocDesc, &virtualAlloc, NULL) );
+
+    WCHAR* str = NULL;
+    block->BuildStatsString(&str);
+    std::vector<std::vector<unsigned char>> parts;
+    block->WriteStatsString(AppendStatsStringPart, &parts, D3D12MA::STATS_STRING_ENCODING_UTF8);
+    CHECK_BOOL( parts.size() == 1 );
+    CHECK_BOOL( parts[0] == EncodeStatsString(str, D3D12MA::STATS_STRING_ENCODING_UTF8) );
+    block->FreeStatsString(str);
+
+    block->FreeAllocation(virtualAlloc);
+    block->Release();
+}
+
+// Minimal reader of the dump written by WriteStatsBinary, see tools/GpuMemDumpBin2Json/README.md.
+struct BinaryStatsReader
+{
+    const std::vector<unsigned char>& data;
+    size_t pos;
+
+    unsigned char Byte() { CHECK_BOOL( pos < data.size() ); return data[pos++]; }
+    UINT64 Number()
+    {
+        UINT64 result = 0;
+        for(UINT shift = 0; ; shift += 7)
+        {
+            const unsigned char b = Byte();
+            result |= (UINT64)(b & 0x7F) << shift;
+            if(b < 0x80)
+                return result;
+        }
+    }
+    // Returns UTF-8 bytes of the string, empty for null.
+    std::string String()
+    {
+        const UINT64 length = Number();
+        if(length == 0)
+            return std::string();
+        CHECK_BOOL( pos + length - 1 <= data.size() );
+        const std::string result(data.begin() + pos, data.begin() + pos + (size_t)length - 1);
+        pos += (size_t)length - 1;
+        return result;
+    }
+    void CheckDetailedStatistics(const D3D12MA::DetailedStatistics& expected)
+    {
+        CHECK_BOOL( Number() == expected.Stats.BlockCount );
+        CHECK_BOOL( Number() == expected.Stats.BlockBytes );
+        CHECK_BOOL( Number() == expected.Stats.AllocationCount );
+        CHECK_BOOL( Number() == expected.Stats.AllocationBytes );
+        CHECK_BOOL( Number() == expected.UnusedRangeCount );
+        if(expected.Stats.AllocationCount > 1)
+        {
+            CHECK_BOOL( Number() == expected.AllocationSizeMin );
+            CHECK_BOOL( Number() == expected.AllocationSizeMax );
+        }
+        if(expected.UnusedRangeCount > 1)
+        {
+            CHECK_BOOL( Number() == expected.UnusedRangeSizeMin );
+            CHECK_BOOL( Number() == expected.UnusedRangeSizeMax );
+        }
+    }
+    void SkipDetailedStatistics()
+    {
+        Number();
+        Number();
+        const UINT64 allocationCount = Number();
+        Number();
+        const UINT64 unusedRangeCount = Number();
+        for(UINT i = 0; i < (allocationCount > 1 ? 2u : 0u) + (unusedRangeCount > 1 ? 2u : 0u); ++i)
+            Number();
+    }
+};
+
+static void TestWriteStatsBinary()
+{
+    wprintf(L"Test write stats binary\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( ctx.allocator->CreatePool(&poolDesc, &pool) );
+    pool->SetName(L"Pool é");
+
+    const char* const textureName = "Texture \xC3\xA9\xE4\xB8\xAD";
+    // Enough allocations for the dump to be written in many parts.
+    std::vector<D3D12MA::Allocation*> allocs(12000);
+    for(size_t i = 0; i < allocs.size(); ++i)
+    {
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        if(i % 100 == 0)
+            allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+        else if(i % 3 == 0)
+            allocDesc.CustomPool = pool;
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { (i % 4 + 1) * 64 * 1024, 64 * 1024 };
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]) );
+        // Runs of equal names are written only once.
+        if(i % 10 != 0)
+            allocs[i]->SetName(i % 20 < 10 ? L"Texture é中" : L"Buffer");
+        if(i % 7 == 0)
+            allocs[i]->SetPrivateData(&allocs[i]);
+    }
+    // Leave unused ranges between allocations.
+    for(size_t i = 1; i < allocs.size(); i += 5)
+    {
+        allocs[i]->Release();
+        allocs[i] = NULL;
+    }
+
+    D3D12MA::TotalStatistics stats;
+    ctx.allocator->CalculateStatistics(&stats);
+    UINT64 namedCount = 0, textureNameCount = 0;
+    for(D3D12MA::Allocation* alloc : allocs)
+    {
+        if(alloc && alloc->GetName())
+        {
+            ++namedCount;
+            textureNameCount += wcscmp(alloc->GetName(), L"Buffer") != 0 ? 1 : 0;
+        }
+    }
+
+    std::vector<std::vector<unsigned char>> parts;
+    ctx.allocator->WriteStatsBinary(AppendStatsStringPart, &parts, TRUE);
+    CHECK_BOOL( parts.size() > 1 );
+    std::vector<unsigned char> data;
+    for(const std::vector<unsigned char>& part : parts)
+    {
+        CHECK_BOOL( !part.empty() );
+        data.insert(data.end(), part.begin(), part.end());
+    }
+
+    std::vector<std::vector<unsigned char>> jsonParts;
+    ctx.allocator->WriteStatsString(AppendStatsStringPart, &jsonParts, D3D12MA::STATS_STRING_ENCODING_UTF8, TRUE);
+    size_t jsonSize = 0;
+    for(const std::vector<unsigned char>& part : jsonParts)
+        jsonSize += part.size();
+    CHECK_BOOL( data.size() * 8 < jsonSize );
+
+    BinaryStatsReader reader = { data, 0 };
+    CHECK_BOOL( reader.Byte() == 'D' && reader.Byte() == 'M' && reader.Byte() == 'A' && reader.Byte() == 'B' );
+    CHECK_BOOL( reader.Number() == 3 );
+    reader.String();
+    for(UINT i = 0; i < 6; ++i)
+        reader.Number();
+    const UINT64 generalFlags = reader.Number();
+    CHECK_BOOL( (generalFlags & 0x20) != 0 ); // Detailed map.
+    CHECK_BOOL( (generalFlags & 0x2) == 0 ); // Not UMA.
+    for(UINT i = 0; i < 4; ++i)
+        reader.Number();
+    reader.CheckDetailedStatistics(stats.Total);
+    for(UINT i = 0; i < 5; ++i)
+        reader.CheckDetailedStatistics(stats.HeapType[i]);
+    for(UINT i = 0; i < 2; ++i)
+        reader.CheckDetailedStatistics(stats.MemorySegmentGroup[i]);
+    // Statistics of custom pools, grouped by memory segment.
+    for(UINT i = 0; i < 2; ++i)
+        reader.SkipDetailedStatistics();
+
+    UINT64 allocationCount = 0, readNamedCount = 0, readTextureNameCount = 0;
+    std::string prevName;
+    const auto readEntry = [&](UINT64& inoutOffset) -> bool
+    {
+        const unsigned char header = reader.Byte();
+        if(header & 0x08)
+        {
+            const UINT64 delta = reader.Number();
+            inoutOffset += (delta >> 1) ^ (0 - (delta & 1));
+        }
+        inoutOffset += reader.Number();
+        if((header & 0x07) == 0)
+            return false;
+        CHECK_BOOL( (header & 0x07) <= 5 );
+        reader.Number(); // Usage
+        if(header & 0x10)
+            CHECK_BOOL( reader.Number() != 0 );
+        if(header & 0x20)
+            prevName = reader.String();
+        if(header & (0x20 | 0x40))
+        {
+            CHECK_BOOL( prevName == textureName || prevName == "Buffer" );
+            ++readNamedCount;
+            readTextureNameCount += prevName == textureName ? 1 : 0;
+        }
+        if(header & 0x80)
+            reader.Number();
+        ++allocationCount;
+        return true;
+    };
+    const auto readHeapInfo = [&](bool customHeap)
+    {
+        reader.Number(); // Heap flags
+        if(customHeap)
+        {
+            reader.Number();
+            reader.Number();
+        }
+        reader.Number(); // Preferred block size
+        if(reader.Number() == 3) // Algorithm
+            reader.Number(); // Slot size
+        for(UINT64 blockCount = reader.Number(); blockCount--; )
+        {
+            reader.Number(); // Id
+            const UINT64 totalBytes = reader.Number();
+            reader.Number(); // Unused bytes
+            const UINT64 blockAllocationCount = reader.Number();
+            const UINT64 entryCount = blockAllocationCount + reader.Number();
+            UINT64 offset = 0, readAllocationCount = 0;
+            prevName.clear();
+            for(UINT64 i = 0; i < entryCount; ++i)
+                readAllocationCount += readEntry(offset) ? 1 : 0;
+            CHECK_BOOL( readAllocationCount == blockAllocationCount );
+            CHECK_BOOL( offset <= totalBytes );
+        }
+        prevName.clear();
+        for(UINT64 committedCount = reader.Number(); committedCount--; )
+        {
+            UINT64 offset = 0;
+            CHECK_BOOL( readEntry(offset) );
+        }
+    };
+    for(UINT i = 0; i < 4; ++i)
+        readHeapInfo(false);
+    for(UINT heapTypeIndex = 0; heapTypeIndex < 5; ++heapTypeIndex)
+    {
+        const UINT64 poolCount = reader.Number();
+        CHECK_BOOL( poolCount == (heapTypeIndex == 0 ? 1 : 0) );
+        for(UINT64 i = 0; i < poolCount; ++i)
+        {
+            CHECK_BOOL( reader.String() == "Pool \xC3\xA9" );
+            readHeapInfo(heapTypeIndex == 3);
+        }
+    }
+    CHECK_BOOL( reader.pos == data.size() );
+    CHECK_BOOL( allocationCount == stats.Total.Stats.AllocationCount );
+    CHECK_BOOL( readNamedCount == namedCount && readTextureNameCount == textureNameCount );
+
+    // Without the detailed map, only the statistics are written.
+    parts.clear();
+    ctx.allocator->WriteStatsBinary(AppendStatsStringPart, &parts, FALSE);
+    CHECK_BOOL( parts.size() == 1 && parts[0].size() < 512 );
+
+    for(D3D12MA::Allocation* alloc : allocs)
+    {
+        if(alloc)
+            alloc->Release();
+    }
+    pool->Release();
+    DestroyContext(ctx);
+}
+
+static void AppendSnapshotChange(const D3D12MA::SNAPSHOT_CHANGE* pChange, void* pPrivateData)
+{
+    ((std::vector<D3D12MA::SNAPSHOT_CHANGE>*)pPrivateData)->push_back(*pChange);
+}
+
+static size_t CountSnapshotChanges(const std::vector<D3D12MA::SNAPSHOT_CHANGE>& changes, D3D12MA::SNAPSHOT_CHANGE_TYPE type)
+{
+    size_t count = 0;
+    for(const D3D12MA::SNAPSHOT_CHANGE& change : changes)
+        count += change.Type == type ? 1 : 0;
+    return count;
+}
+
+static void TestSnapshotChanges()
+{
+    wprintf(L"Test snapshot changes\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 allocSize = 64 * 1024;
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    poolDesc.BlockSize = blockSize;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( ctx.allocator->CreatePool(&poolDesc, &pool) );
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.CustomPool = pool;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { allocSize, allocSize };
+    // Two blocks, the second one filled by a quarter.
+    std::vector<D3D12MA::Allocation*> allocs(20);
+    for(D3D12MA::Allocation*& alloc : allocs)
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+
+    D3D12MA::ALLOCATION_DESC committedDesc = {};
+    committedDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+    committedDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+    D3D12MA::Allocation* committedAlloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&committedDesc, &allocInfo, &committedAlloc) );
+
+    // Without a previous snapshot, everything is created.
+    D3D12MA::Snapshot* snapshot0 = NULL;
+    CHECK_HR( ctx.allocator->CreateSnapshot(&snapshot0) );
+    CHECK_BOOL( snapshot0->GetBlockCount() == 2 );
+    CHECK_BOOL( snapshot0->GetAllocationCount() == allocs.size() + 1 );
+    std::vector<D3D12MA::SNAPSHOT_CHANGE> changes;
+    snapshot0->EnumerateChanges(NULL, AppendSnapshotChange, &changes);
+    CHECK_BOOL( changes.size() == 2 + allocs.size() + 1 );
+    CHECK_BOOL( CountSnapshotChanges(changes, D3D12MA::SNAPSHOT_CHANGE_TYPE_BLOCK_CREATED) == 2 );
+    // Blocks are reported before allocations.
+    CHECK_BOOL( changes[0].Type == D3D12MA::SNAPSHOT_CHANGE_TYPE_BLOCK_CREATED &&
+        changes[1].Type == D3D12MA::SNAPSHOT_CHANGE_TYPE_BLOCK_CREATED );
+    for(const D3D12MA::SNAPSHOT_CHANGE& change : changes)
+    {
+        if(change.Type == D3D12MA::SNAPSHOT_CHANGE_TYPE_BLOCK_CREATED)
+        {
+            CHECK_BOOL( change.PoolId == pool->GetId() && change.Size == blockSize && change.AllocationId == 0 );
+            continue;
+        }
+        CHECK_BOOL( change.Type == D3D12MA::SNAPSHOT_CHANGE_TYPE_ALLOCATION_CREATED );
+        CHECK_BOOL( change.Size == allocSize );
+        if(change.HeapType == D3D12_HEAP_TYPE_UPLOAD)
+        {
+            CHECK_BOOL( change.PoolId == 0 && change.BlockId == UINT_MAX );
+            CHECK_BOOL( (change.AllocationId & 0xFFFFFFFFFFFFull) == (UINT64)(uintptr_t)committedAlloc );
+        }
+        else
+            CHECK_BOOL( change.PoolId == pool->GetId() && change.BlockId != UINT_MAX );
+    }
+    changes.clear();
+    snapshot0->EnumerateChanges(snapshot0, AppendSnapshotChange, &changes);
+    CHECK_BOOL( changes.empty() );
+
+    // A new allocation at the address of a freed one is reported as freed and created.
+    D3D12MA::Allocation* const freedAlloc = allocs[3];
+    const UINT64 freedOffset = freedAlloc->GetOffset();
+    freedAlloc->Release();
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[3]) );
+    D3D12MA::Snapshot* snapshot1 = NULL;
+    CHECK_HR( ctx.allocator->CreateSnapshot(&snapshot1) );
+    changes.clear();
+    snapshot1->EnumerateChanges(snapshot0, AppendSnapshotChange, &changes);
+    CHECK_BOOL( changes.size() == 2 );
+    CHECK_BOOL( CountSnapshotChanges(changes, D3D12MA::SNAPSHOT_CHANGE_TYPE_ALLOCATION_FREED) == 1 );
+    CHECK_BOOL( CountSnapshotChanges(changes, D3D12MA::SNAPSHOT_CHANGE_TYPE_ALLOCATION_CREATED) == 1 );
+    CHECK_BOOL( changes[0].AllocationId != changes[1].AllocationId );
+    for(const D3D12MA::SNAPSHOT_CHANGE& change : changes)
+    {
+        CHECK_BOOL( change.Offset == freedOffset );
+        const D3D12MA::Allocation* const expectedAlloc =
+            change.Type == D3D12MA::SNAPSHOT_CHANGE_TYPE_ALLOCATION_FREED ? freedAlloc : allocs[3];
+        CHECK_BOOL( (change.AllocationId & 0xFFFFFFFFFFFFull) == (UINT64)(uintptr_t)expectedAlloc );
+    }
+
+    // Defragmentation moves the allocations of the second block to the holes in the first one.
+    for(size_t i = 0; i < 16; i += 4)
+    {
+        allocs[i]->Release();
+        allocs[i] = NULL;
+    }
+    committedAlloc->Release();
+    D3D12MA::Snapshot* snapshot2 = NULL;
+    CHECK_HR( ctx.allocator->CreateSnapshot(&snapshot2) );
+
+    D3D12MA::DEFRAGMENTATION_DESC defragDesc = {};
+    defragDesc.Flags = D3D12MA::DEFRAGMENTATION_FLAG_ALGORITHM_FULL;
+    D3D12MA::DefragmentationContext* defragCtx = NULL;
+    CHECK_HR( pool->BeginDefragmentation(&defragDesc, &defragCtx) );
+    for(;;)
+    {
+        D3D12MA::DEFRAGMENTATION_PASS_MOVE_INFO passInfo = {};
+        if(defragCtx->BeginPass(&passInfo) == S_OK)
+            break;
+        if(defragCtx->EndPass(&passInfo) == S_OK)
+            break;
+    }
+    D3D12MA::DEFRAGMENTATION_STATS defragStats = {};
+    defragCtx->GetStats(&defragStats);
+    defragCtx->Release();
+    CHECK_BOOL( defragStats.AllocationsMoved > 0 );
+
+    D3D12MA::Snapshot* snapshot3 = NULL;
+    CHECK_HR( ctx.allocator->CreateSnapshot(&snapshot3) );
+    changes.clear();
+    snapshot3->EnumerateChanges(snapshot2, AppendSnapshotChange, &changes);
+    CHECK_BOOL( CountSnapshotChanges(changes, D3D12MA::SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED) == defragStats.AllocationsMoved );
+    CHECK_BOOL( CountSnapshotChanges(changes, D3D12MA::SNAPSHOT_CHANGE_TYPE_BLOCK_FREED) == defragStats.HeapsFreed );
+    CHECK_BOOL( changes.size() == defragStats.AllocationsMoved + defragStats.HeapsFreed );
+    for(const D3D12MA::SNAPSHOT_CHANGE& change : changes)
+    {
+        if(change.Type == D3D12MA::SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED)
+            CHECK_BOOL( change.BlockId != change.PreviousBlockId || change.Offset != change.PreviousOffset );
+    }
+
+    // The binary form contains the same changes.
+    std::vector<std::vector<unsigned char>> parts;
+    snapshot3->WriteChanges(snapshot2, AppendStatsStringPart, &parts);
+    std::vector<unsigned char> data;
+    for(const std::vector<unsigned char>& part : parts)
+        data.insert(data.end(), part.begin(), part.end());
+    BinaryStatsReader reader = { data, 0 };
+    CHECK_BOOL( reader.Byte() == 'D' && reader.Byte() == 'M' && reader.Byte() == 'A' && reader.Byte() == 'D' );
+    CHECK_BOOL( reader.Number() == 3 );
+    for(const D3D12MA::SNAPSHOT_CHANGE& change : changes)
+    {
+        CHECK_BOOL( reader.Number() == (UINT64)change.Type + 1 );
+        CHECK_BOOL( reader.Number() == (UINT64)change.HeapType );
+        CHECK_BOOL( reader.Number() == change.PoolId );
+        CHECK_BOOL( reader.Number() == (UINT64)change.BlockId + 1 );
+        CHECK_BOOL( reader.Number() == change.Size );
+        if(change.Type == D3D12MA::SNAPSHOT_CHANGE_TYPE_ALLOCATION_MOVED)
+        {
+            CHECK_BOOL( reader.Number() == change.AllocationId );
+            CHECK_BOOL( reader.Number() == change.Offset );
+            CHECK_BOOL( reader.Number() == (UINT64)change.PreviousBlockId + 1 );
+            CHECK_BOOL( reader.Number() == change.PreviousOffset );
+        }
+    }
+    CHECK_BOOL( reader.Number() == 0 && reader.pos == data.size() );
+
+    // Snapshots outlive the allocator.
+    for(D3D12MA::Allocation* alloc : allocs)
+    {
+        if(alloc)
+            alloc->Release();
+    }
+    pool->Release();
+    DestroyContext(ctx);
+    changes.clear();
+    snapshot3->EnumerateChanges(snapshot0, AppendSnapshotChange, &changes);
+    CHECK_BOOL( !changes.empty() );
+    snapshot0->Release();
+    snapshot1->Release();
+    snapshot2->Release();
+    snapshot3->Release();
+}
+
+static UINT CountTraceEvents(const std::vector<D3D12MA::TRACE_EVENT>& events, D3D12MA::TRACE_EVENT_TYPE type)
+{
+    UINT count = 0;
+    for(const D3D12MA::TRACE_EVENT& event : events)
+    {
+        if(event.Type == type)
+            ++count;
+    }
+    return count;
+}
+
+static void ReadTraceEvents(D3D12MA::Allocator* allocator, UINT64& nextSequenceNumber, std::vector<D3D12MA::TRACE_EVENT>& outEvents)
+{
+    outEvents.clear();
+    D3D12MA::TRACE_EVENT events[16];
+    while(const UINT eventCount = allocator->GetTraceEvents(&nextSequenceNumber, events, (UINT)(sizeof(events) / sizeof(events[0]))))
+        outEvents.insert(outEvents.end(), events, events + eventCount);
+}
+
+static void TestTraceEvents()
+{
+    wprintf(L"Test trace events\n");
+
+    MockDevice* device = NULL;
+    MockAdapter* adapter = NULL;
+    CHECK_HR( CreateMockDevice(NULL, &device, &adapter) );
+    D3D12MA::ALLOCATOR_DESC allocatorDesc = {};
+    // Budget is fetched only when asked, so that it doesn't interleave with allocations.
+    allocatorDesc.Flags = D3D12MA::ALLOCATOR_FLAG_TRACE_EVENTS | D3D12MA::ALLOCATOR_FLAG_MANUAL_BUDGET_UPDATE;
+    // Rounded up to 128.
+    allocatorDesc.TraceEventCapacity = 100;
+    allocatorDesc.pDevice = device;
+    allocatorDesc.pAdapter = adapter;
+    D3D12MA::Allocator* allocator = NULL;
+    CHECK_HR( D3D12MA::CreateAllocator(&allocatorDesc, &allocator) );
+
+    // Budget fetched when the allocator is created.
+    UINT64 nextSequenceNumber = 0;
+    std::vector<D3D12MA::TRACE_EVENT> events;
+    ReadTraceEvents(allocator, nextSequenceNumber, events);
+    CHECK_BOOL( events.size() == 2 && nextSequenceNumber == 2 );
+    for(size_t i = 0; i < events.size(); ++i)
+    {
+        CHECK_BOOL( events[i].Type == D3D12MA::TRACE_EVENT_TYPE_BUDGET_UPDATE );
+        CHECK_BOOL( events[i].SequenceNumber == i && events[i].MemorySegmentGroup == i );
+    }
+    CHECK_BOOL( events[1].Timestamp >= events[0].Timestamp );
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 allocSize = 64 * 1024;
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    poolDesc.BlockSize = blockSize;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( allocator->CreatePool(&poolDesc, &pool) );
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.CustomPool = pool;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { allocSize, allocSize };
+    std::vector<D3D12MA::Allocation*> allocs(20);
+    for(D3D12MA::Allocation*& alloc : allocs)
+        CHECK_HR( allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+    D3D12MA::ALLOCATION_DESC committedDesc = {};
+    committedDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+    committedDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+    D3D12MA::Allocation* committedAlloc = NULL;
+    CHECK_HR( allocator->AllocateMemory(&committedDesc, &allocInfo, &committedAlloc) );
+
+    ReadTraceEvents(allocator, nextSequenceNumber, events);
+    CHECK_BOOL( events.size() == 2 + allocs.size() + 1 );
+    CHECK_BOOL( events[0].Type == D3D12MA::TRACE_EVENT_TYPE_CREATE_BLOCK && events[0].Size == blockSize );
+    CHECK_BOOL( CountTraceEvents(events, D3D12MA::TRACE_EVENT_TYPE_CREATE_BLOCK) == 2 );
+    CHECK_BOOL( CountTraceEvents(events, D3D12MA::TRACE_EVENT_TYPE_ALLOCATE) == allocs.size() + 1 );
+    size_t allocIndex = 0;
+    for(size_t i = 0; i < events.size(); ++i)
+    {
+        const D3D12MA::TRACE_EVENT& event = events[i];
+        CHECK_BOOL( event.SequenceNumber == 2 + i );
+        CHECK_BOOL( event.ThreadId == events[0].ThreadId );
+        if(event.Type != D3D12MA::TRACE_EVENT_TYPE_ALLOCATE)
+            continue;
+        CHECK_BOOL( event.Size == allocSize && event.Alignment == allocSize );
+        if(event.HeapType == D3D12_HEAP_TYPE_UPLOAD)
+        {
+            CHECK_BOOL( event.PoolId == 0 && event.BlockId == UINT_MAX );
+            CHECK_BOOL( (event.AllocationId & 0xFFFFFFFFFFFFull) == (UINT64)(uintptr_t)committedAlloc );
+        }
+        else
+        {
+            const D3D12MA::Allocation* const alloc = allocs[allocIndex++];
+            CHECK_BOOL( event.PoolId == pool->GetId() && event.BlockId != UINT_MAX );
+            CHECK_BOOL( (event.AllocationId & 0xFFFFFFFFFFFFull) == (UINT64)(uintptr_t)alloc );
+            CHECK_BOOL( event.Offset == alloc->GetOffset() );
+        }
+    }
+
+    // Defragmentation moves the allocations of the second block to the holes in the first one.
+    for(size_t i = 0; i < 16; i += 4)
+    {
+        allocs[i]->Release();
+        allocs[i] = NULL;
+    }
+    committedAlloc->Release();
+    CHECK_HR( allocator->UpdateBudget() );
+    D3D12MA::DEFRAGMENTATION_DESC defragDesc = {};
+    defragDesc.Flags = D3D12MA::DEFRAGMENTATION_FLAG_ALGORITHM_FULL;
+    D3D12MA::DefragmentationContext* defragCtx = NULL;
+    CHECK_HR( pool->BeginDefragmentation(&defragDesc, &defragCtx) );
+    for(;;)
+    {
+        D3D12MA::DEFRAGMENTATION_PASS_MOVE_INFO passInfo = {};
+        if(defragCtx->BeginPass(&passInfo) == S_OK)
+            break;
+        if(defragCtx->EndPass(&passInfo) == S_OK)
+            break;
+    }
+    D3D12MA::DEFRAGMENTATION_STATS defragStats = {};
+    defragCtx->GetStats(&defragStats);
+    defragCtx->Release();
+    CHECK_BOOL( defragStats.AllocationsMoved > 0 );
+
+    ReadTraceEvents(allocator, nextSequenceNumber, events);
+    CHECK_BOOL( CountTraceEvents(events, D3D12MA::TRACE_EVENT_TYPE_BUDGET_UPDATE) == 2 );
+    CHECK_BOOL( CountTraceEvents(events, D3D12MA::TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE) == defragStats.AllocationsMoved );
+    CHECK_BOOL( CountTraceEvents(events, D3D12MA::TRACE_EVENT_TYPE_DESTROY_BLOCK) == defragStats.HeapsFreed );
+    // Every temporary allocation is created at the destination and freed at the source.
+    CHECK_BOOL( CountTraceEvents(events, D3D12MA::TRACE_EVENT_TYPE_ALLOCATE) == defragStats.AllocationsMoved );
+    CHECK_BOOL( CountTraceEvents(events, D3D12MA::TRACE_EVENT_TYPE_FREE) == 5 + defragStats.AllocationsMoved );
+    for(size_t i = 0; i < events.size(); ++i)
+    {
+        const D3D12MA::TRACE_EVENT& move = events[i];
+        if(move.Type != D3D12MA::TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE)
+            continue;
+        CHECK_BOOL( move.TemporaryAllocationId != move.AllocationId && move.Size == allocSize );
+        bool tmpAllocated = false, tmpFreed = false;
+        for(const D3D12MA::TRACE_EVENT& event : events)
+        {
+            if(event.AllocationId != move.TemporaryAllocationId)
+                continue;
+            if(event.Type == D3D12MA::TRACE_EVENT_TYPE_ALLOCATE)
+            {
+                CHECK_BOOL( event.SequenceNumber < move.SequenceNumber );
+                CHECK_BOOL( event.BlockId == move.BlockId && event.Offset == move.Offset );
+                tmpAllocated = true;
+            }
+            else if(event.Type == D3D12MA::TRACE_EVENT_TYPE_FREE && event.SequenceNumber > move.SequenceNumber)
+                tmpFreed = true;
+        }
+        CHECK_BOOL( tmpAllocated && tmpFreed );
+    }
+
+    // Older events are overwritten and skipped.
+    for(UINT i = 0; i < 100; ++i)
+    {
+        allocs[1]->Release();
+        CHECK_HR( allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[1]) );
+    }
+    const UINT64 prevNextSequenceNumber = nextSequenceNumber;
+    ReadTraceEvents(allocator, nextSequenceNumber, events);
+    // Emptying a block may destroy another empty one.
+    CHECK_BOOL( events.size() == 128 && nextSequenceNumber >= prevNextSequenceNumber + 200 );
+    CHECK_BOOL( events[0].SequenceNumber == nextSequenceNumber - 128 );
+    for(size_t i = 0; i < events.size(); ++i)
+        CHECK_BOOL( events[i].Type == (i % 2 ? D3D12MA::TRACE_EVENT_TYPE_ALLOCATE : D3D12MA::TRACE_EVENT_TYPE_FREE) );
+    // Only events whose thread was overtaken by the whole ring are dropped, never with a single thread.
+    WCHAR* statsString = NULL;
+    allocator->BuildStatsString(&statsString, FALSE);
+    CHECK_BOOL( wcsstr(statsString, L"\"DroppedEventCount\": 0") != NULL );
+    allocator->FreeStatsString(statsString);
+
+    // The binary form contains the same events.
+    UINT64 writeSequenceNumber = 0;
+    std::vector<std::vector<unsigned char>> parts;
+    allocator->WriteTraceEvents(&writeSequenceNumber, AppendStatsStringPart, &parts);
+    CHECK_BOOL( writeSequenceNumber == nextSequenceNumber );
+    std::vector<unsigned char> data;
+    for(const std::vector<unsigned char>& part : parts)
+        data.insert(data.end(), part.begin(), part.end());
+    BinaryStatsReader reader = { data, 0 };
+    CHECK_BOOL( reader.Byte() == 'D' && reader.Byte() == 'M' && reader.Byte() == 'A' && reader.Byte() == 'T' );
+    CHECK_BOOL( reader.Number() == 3 );
+    UINT64 sequenceNumber = 0;
+    for(const D3D12MA::TRACE_EVENT& event : events)
+    {
+        CHECK_BOOL( reader.Number() == (UINT64)event.Type + 1 );
+        sequenceNumber += reader.Number();
+        CHECK_BOOL( sequenceNumber == event.SequenceNumber );
+        reader.Number(); // Timestamp delta.
+        CHECK_BOOL( reader.Number() == event.ThreadId );
+        CHECK_BOOL( reader.Number() == (UINT64)event.HeapType );
+        CHECK_BOOL( reader.Number() == event.PoolId );
+        CHECK_BOOL( reader.Number() == (UINT64)event.BlockId + 1 );
+        CHECK_BOOL( reader.Number() == event.AllocationId );
+        CHECK_BOOL( reader.Number() == event.Offset );
+        CHECK_BOOL( reader.Number() == event.Size );
+        if(event.Type == D3D12MA::TRACE_EVENT_TYPE_ALLOCATE)
+            CHECK_BOOL( reader.Number() == event.Alignment );
+    }
+    CHECK_BOOL( reader.Number() == 0 && reader.pos == data.size() );
+
+    for(D3D12MA::Allocation* alloc : allocs)
+    {
+        if(alloc)
+            alloc->Release();
+    }
+    pool->Release();
+    // Without the flag nothing is recorded.
+    allocator->Release();
+    allocatorDesc.Flags = D3D12MA::ALLOCATOR_FLAG_NONE;
+    CHECK_HR( D3D12MA::CreateAllocator(&allocatorDesc, &allocator) );
+    nextSequenceNumber = 0;
+    ReadTraceEvents(allocator, nextSequenceNumber, events);
+    CHECK_BOOL( events.empty() && nextSequenceNumber == 0 );
+    allocator->Release();
+    device->Release();
+    adapter->Release();
+}
+
+static void TestPerformanceCounters()
+{
+    wprintf(L"Test performance counters\n");
+
+    const UINT DEFAULT_INDEX = D3D12_HEAP_TYPE_DEFAULT - 1;
+    const UINT UPLOAD_INDEX = D3D12_HEAP_TYPE_UPLOAD - 1;
+
+    // Without the flag, everything stays zero.
+    {
+        MockTestContext ctx;
+        CreateContext(ctx);
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 64 * 1024, 64 * 1024 };
+        D3D12MA::Allocation* alloc = NULL;
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+        alloc->Release();
+
+        D3D12MA::PerformanceCounters counters;
+        memset(&counters, 0xFF, sizeof(counters));
+        ctx.allocator->GetPerformanceCounters(&counters);
+        const unsigned char* const bytes = (const unsigned char*)&counters;
+        for(size_t i = 0; i < sizeof(counters); ++i)
+            CHECK_BOOL( bytes[i] == 0 );
+        DestroyContext(ctx);
+    }
+
+    MockTestContext ctx;
+    CreateContext(ctx, NULL, D3D12MA::ALLOCATOR_FLAG_PERFORMANCE_COUNTERS);
+
+    // Small buffers are placed in a single heap.
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    D3D12_RESOURCE_DESC resDesc;
+    FillResourceDescForBuffer(resDesc, 1024 * 1024);
+    const UINT count = 8;
+    D3D12MA::Allocation* allocs[count] = {};
+    for(UINT i = 0; i < count; ++i)
+    {
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+            NULL, &allocs[i], IID_NULL, NULL) );
+    }
+
+    // Committed because it is requested explicitly.
+    D3D12MA::ALLOCATION_DESC committedDesc = {};
+    committedDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+    committedDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+    const D3D12_RESOURCE_ALLOCATION_INFO smallInfo = { 64 * 1024, 64 * 1024 };
+    D3D12MA::Allocation* committedAlloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&committedDesc, &smallInfo, &committedAlloc) );
+
+    // Committed because it is larger than half of the default block size.
+    const D3D12_RESOURCE_ALLOCATION_INFO largeInfo = { 48ull * 1024 * 1024, 64 * 1024 };
+    D3D12MA::Allocation* largeAlloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &largeInfo, &largeAlloc) );
+
+    D3D12MA::PerformanceCounters counters;
+    ctx.allocator->GetPerformanceCounters(&counters);
+    const D3D12MA::LatencyHistogram& createResource =
+        counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_CREATE_RESOURCE][DEFAULT_INDEX];
+    CHECK_BOOL( createResource.Count == count );
+    CHECK_BOOL( createResource.MaxNanoseconds <= createResource.TotalNanoseconds );
+    UINT64 bucketSum = 0;
+    for(UINT i = 0; i < D3D12MA::LATENCY_HISTOGRAM_BUCKET_COUNT; ++i)
+        bucketSum += createResource.Buckets[i];
+    CHECK_BOOL( bucketSum == count );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_CREATE_PLACED_RESOURCE][DEFAULT_INDEX].Count == count );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_CREATE_HEAP][DEFAULT_INDEX].Count ==
+        ctx.device->GetCallCount(MOCK_OPERATION_CREATE_HEAP) - 1 );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_CREATE_HEAP][UPLOAD_INDEX].Count == 1 );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_ALLOCATE_MEMORY][DEFAULT_INDEX].Count == 1 );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_ALLOCATE_MEMORY][UPLOAD_INDEX].Count == 1 );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_CREATE_COMMITTED_RESOURCE][DEFAULT_INDEX].Count == 0 );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_BLOCK_VECTOR_LOCK_WAIT][DEFAULT_INDEX].Count == count );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_FREE][DEFAULT_INDEX].Count == 0 );
+    CHECK_BOOL( counters.PlacementDecisions[D3D12MA::PLACEMENT_DECISION_PLACED][DEFAULT_INDEX] == count );
+    CHECK_BOOL( counters.PlacementDecisions[D3D12MA::PLACEMENT_DECISION_COMMITTED_PREFERRED][DEFAULT_INDEX] == 1 );
+    CHECK_BOOL( counters.PlacementDecisions[D3D12MA::PLACEMENT_DECISION_COMMITTED_REQUIRED][UPLOAD_INDEX] == 1 );
+    CHECK_BOOL( counters.PlacementDecisions[D3D12MA::PLACEMENT_DECISION_COMMITTED_FALLBACK][DEFAULT_INDEX] == 0 );
+
+    WCHAR* statsString = NULL;
+    ctx.allocator->BuildStatsString(&statsString, FALSE);
+    CHECK_BOOL( wcsstr(statsString, L"\"PerformanceCounters\"") != NULL );
+    CHECK_BOOL( wcsstr(statsString, L"\"CreatePlacedResource\"") != NULL );
+    ctx.allocator->FreeStatsString(statsString);
+
+    for(UINT i = 0; i < count; ++i)
+        allocs[i]->Release();
+    committedAlloc->Release();
+    largeAlloc->Release();
+    ctx.allocator->GetPerformanceCounters(&counters);
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_FREE][DEFAULT_INDEX].Count == count + 1 );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_FREE][UPLOAD_INDEX].Count == 1 );
+    CHECK_BOOL( counters.Operations[D3D12MA::PERFORMANCE_COUNTER_OPERATION_BLOCK_VECTOR_LOCK_WAIT][DEFAULT_INDEX].Count == 2 * count );
+
+    DestroyContext(ctx);
+}
+
+#if D3D12MA_PROFILE_LOCKS
+// Returns the value of a member of the lock profile with given name in the JSON dump.
+static UINT64 GetLockProfileValue(const WCHAR* statsString, const WCHAR* lockName, const WCHAR* member)
+{
+    const WCHAR* const profiles = wcsstr(statsString, L"\"LockProfiles\"");
+    CHECK_BOOL( profiles != NULL );
+    const std::wstring lockKey = std::wstring(L"\"") + lockName + L"\"";
+    const WCHAR* const lock = wcsstr(profiles, lockKey.c_str());
+    CHECK_BOOL( lock != NULL );
+    const std::wstring memberKey = std::wstring(L"\"") + member + L"\": ";
+    const WCHAR* const value = wcsstr(lock, memberKey.c_str());
+    CHECK_BOOL( value != NULL );
+    return wcstoull(value + memberKey.length(), NULL, 10);
+}
+
+static void TestLockProfiles()
+{
+    wprintf(L"Test lock profiles\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    poolDesc.BlockSize = 16ull * 1024 * 1024;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( ctx.allocator->CreatePool(&poolDesc, &pool) );
+
+    // All threads allocate from the same pool, so they contend for its lock.
+    const UINT threadCount = 4;
+    const UINT iterationCount = 2000;
+    std::vector<std::thread> threads;
+    for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        threads.emplace_back([&]()
+        {
+            D3D12MA::ALLOCATION_DESC allocDesc = {};
+            allocDesc.CustomPool = pool;
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { 256, 256 };
+            for(UINT i = 0; i < iterationCount; ++i)
+            {
+                D3D12MA::Allocation* alloc = NULL;
+                CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+                alloc->Release();
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    WCHAR* statsString = NULL;
+    ctx.allocator->BuildStatsString(&statsString, FALSE);
+    // Every allocation and free locks the block vector at least once.
+    const UINT64 acquisitions = GetLockProfileValue(statsString, L"BlockVector", L"Acquisitions");
+    const UINT64 contended = GetLockProfileValue(statsString, L"BlockVector", L"ContendedAcquisitions");
+    CHECK_BOOL( acquisitions >= 2ull * threadCount * iterationCount );
+    CHECK_BOOL( contended <= acquisitions );
+    if(contended > 0)
+        CHECK_BOOL( GetLockProfileValue(statsString, L"BlockVector", L"TotalWaitNanoseconds") > 0 );
+    // Creating the pool took the lock of the list of pools.
+    CHECK_BOOL( GetLockProfileValue(statsString, L"Pools", L"Acquisitions") > 0 );
+    ctx.allocator->FreeStatsString(statsString);
+
+    pool->Release();
+    DestroyContext(ctx);
+}
+#endif // #if D3D12MA_PROFILE_LOCKS
+
+static void TestVirtualBlock()
+{
+    wprintf(L"Test virtual block\n");
+
+    D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+    blockDesc.Size = 1024 * 1024;
+    D3D12MA::VirtualBlock* block = NULL;
+    CHECK_HR( D3D12MA::CreateVirtualBlock(&blockDesc, &block) );
+
+    D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+    allocDesc.Size = 1000;
+    allocDesc.Alignment = 256;
+    D3D12MA::VirtualAllocation alloc0, alloc1;
+    UINT64 offset0 = 0, offset1 = 0;
+    CHECK_HR( block->Allocate(&allocDesc, &alloc0, &offset0) );
+    CHECK_HR( block->Allocate(&allocDesc, &alloc1, &offset1) );
+    CHECK_BOOL( offset0 % 256 == 0 && offset1 % 256 == 0 && offset0 != offset1 );
+    block->FreeAllocation(alloc0);
+    block->FreeAllocation(alloc1);
+    CHECK_BOOL( block->IsEmpty() );
+
+    block->Release();
+}
+
+static void TestVirtualBlockMixedAlignment()
+{
+    wprintf(L"Test virtual block mixed alignment\n");
+
+    // Pages of 4 KB, each with a free range of 320 B at offset 64, then 2 pages free at the end
+    // followed by one taken page, so nothing is left at the end of the block.
+    const UINT64 pageSize = 4096;
+    const UINT64 pageCount = 100;
+    D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+    blockDesc.Size = (pageCount + 3) * pageSize;
+    D3D12MA::VirtualBlock* block = NULL;
+    CHECK_HR( D3D12MA::CreateVirtualBlock(&blockDesc, &block) );
+
+    D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+    D3D12MA::VirtualAllocation alloc;
+    std::vector<D3D12MA::VirtualAllocation> ranges;
+    for(UINT64 i = 0; i < pageCount; ++i)
+    {
+        for(UINT64 size : { (UINT64)64, (UINT64)320, pageSize - 384 })
+        {
+            allocDesc.Size = size;
+            CHECK_HR( block->Allocate(&allocDesc, &alloc, NULL) );
+            if(size == 320)
+                ranges.push_back(alloc);
+        }
+    }
+    allocDesc.Size = 2 * pageSize;
+    CHECK_HR( block->Allocate(&allocDesc, &alloc, NULL) );
+    ranges.push_back(alloc);
+    allocDesc.Size = pageSize;
+    CHECK_HR( block->Allocate(&allocDesc, &alloc, NULL) );
+    for(D3D12MA::VirtualAllocation range : ranges)
+        block->FreeAllocation(range);
+
+    const D3D12MA::VIRTUAL_ALLOCATION_FLAGS strategies[] = { D3D12MA::VIRTUAL_ALLOCATION_FLAG_NONE,
+        D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_MEMORY, D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_TIME,
+        D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_OFFSET };
+    for(D3D12MA::VIRTUAL_ALLOCATION_FLAGS strategy : strategies)
+    {
+        allocDesc.Flags = strategy;
+
+        // Small alignment fits in the free range of any page, the first one with MIN_OFFSET.
+        allocDesc.Size = 200;
+        allocDesc.Alignment = 64;
+        UINT64 offset = UINT64_MAX;
+        CHECK_HR( block->Allocate(&allocDesc, &alloc, &offset) );
+        CHECK_BOOL( offset % pageSize == 64 && offset < pageCount * pageSize );
+        if(strategy == D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_OFFSET)
+            CHECK_BOOL( offset == 64 );
+        block->FreeAllocation(alloc);
+
+        // Page alignment fits only in the free pages at the end.
+        allocDesc.Alignment = pageSize;
+        CHECK_HR( block->Allocate(&allocDesc, &alloc, &offset) );
+        CHECK_BOOL( offset == pageCount * pageSize || offset == (pageCount + 1) * pageSize );
+        if(strategy == D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_OFFSET)
+            CHECK_BOOL( offset == pageCount * pageSize );
+        block->FreeAllocation(alloc);
+
+        allocDesc.Alignment = 16 * pageSize;
+        CHECK_BOOL( FAILED(block->Allocate(&allocDesc, &alloc, &offset)) );
+    }
+
+    block->Clear();
+    block->Release();
+}
+
+static void TestVirtualBlockThreadSafe()
+{
+    wprintf(L"Test virtual block thread-safe\n");
+
+    const UINT64 blockSize = 1024 * 1024;
+    D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+    blockDesc.Size = blockSize;
+    blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_THREAD_SAFE;
+    D3D12MA::VirtualBlock* block = NULL;
+    CHECK_HR( D3D12MA::CreateVirtualBlock(&blockDesc, &block) );
+
+    struct Range { UINT64 offset, size; };
+    const UINT threadCount = 8;
+    const UINT allocCount = 100;
+    std::vector<std::vector<Range>> threadRanges(threadCount);
+    std::vector<std::thread> threads;
+    for(UINT threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            D3D12MA::VirtualAllocation allocs[allocCount];
+            for(UINT iter = 0; iter < 20; ++iter)
+            {
+                for(UINT i = 0; i < allocCount; ++i)
+                {
+                    D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+                    allocDesc.Size = 64 + (threadIndex * 37 + i * 11) % 512;
+                    allocDesc.Alignment = 1ull << (i % 9);
+                    UINT64 offset = 0;
+                    CHECK_HR( block->Allocate(&allocDesc, &allocs[i], &offset) );
+                    CHECK_BOOL( offset % allocDesc.Alignment == 0 );
+                    D3D12MA::VIRTUAL_ALLOCATION_INFO info = {};
+                    block->GetAllocationInfo(allocs[i], &info);
+                    CHECK_BOOL( info.Offset == offset && info.Size == allocDesc.Size );
+                    if(iter == 19)
+                        threadRanges[threadIndex].push_back({ offset, allocDesc.Size });
+                }
+                if(iter < 19)
+                {
+                    for(UINT i = 0; i < allocCount; ++i)
+                        block->FreeAllocation(allocs[i]);
+                }
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    D3D12MA::Statistics stats = {};
+    block->GetStatistics(&stats);
+    CHECK_BOOL( stats.AllocationCount == threadCount * allocCount );
+    CHECK_BOOL( stats.BlockBytes == blockSize );
+
+    std::vector<Range> ranges;
+    for(const std::vector<Range>& r : threadRanges)
+        ranges.insert(ranges.end(), r.begin(), r.end());
+    std::sort(ranges.begin(), ranges.end(),
+        [](const Range& lhs, const Range& rhs) { return lhs.offset < rhs.offset; });
+    for(size_t i = 1; i < ranges.size(); ++i)
+        CHECK_BOOL( ranges[i - 1].offset + ranges[i - 1].size <= ranges[i].offset );
+    CHECK_BOOL( ranges.back().offset + ranges.back().size <= blockSize );
+
+    block->Clear();
+    CHECK_BOOL( block->IsEmpty() );
+
+    // A single thread can still use the whole block, taking space from other shards.
+    D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+    allocDesc.Size = blockSize / 16;
+    std::vector<D3D12MA::VirtualAllocation> allocs(16);
+    for(D3D12MA::VirtualAllocation& alloc : allocs)
+        CHECK_HR( block->Allocate(&allocDesc, &alloc, NULL) );
+    D3D12MA::VirtualAllocation extraAlloc;
+    CHECK_BOOL( FAILED(block->Allocate(&allocDesc, &extraAlloc, NULL)) );
+    CHECK_BOOL( extraAlloc.AllocHandle == 0 );
+    for(D3D12MA::VirtualAllocation& alloc : allocs)
+        block->FreeAllocation(alloc);
+    CHECK_BOOL( block->IsEmpty() );
+
+    block->Release();
+}
+
+static void TestBuddyAlgorithm()
+{
+    wprintf(L"Test buddy algorithm\n");
+
+    // Only 512 units of the virtual block are usable.
+    D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+    blockDesc.Size = 1000;
+    blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY;
+    D3D12MA::VirtualBlock* block = NULL;
+    CHECK_HR( D3D12MA::CreateVirtualBlock(&blockDesc, &block) );
+
+    struct Range { UINT64 offset, size; };
+    std::vector<Range> ranges;
+    std::vector<D3D12MA::VirtualAllocation> virtualAllocs;
+    const UINT64 sizes[] = { 1, 7, 64, 33, 100, 2, 16, 5 };
+    for(UINT64 size : sizes)
+    {
+        D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+        allocDesc.Size = size;
+        D3D12MA::VirtualAllocation alloc;
+        UINT64 offset = 0;
+        CHECK_HR( block->Allocate(&allocDesc, &alloc, &offset) );
+        // Every allocation is aligned to the size of its node.
+        UINT64 nodeSize = 1;
+        while(nodeSize < size)
+            nodeSize *= 2;
+        CHECK_BOOL( offset % nodeSize == 0 && offset + size <= 512 );
+        D3D12MA::VIRTUAL_ALLOCATION_INFO info = {};
+        block->GetAllocationInfo(alloc, &info);
+        CHECK_BOOL( info.Offset == offset && info.Size == size );
+        ranges.push_back({ offset, size });
+        virtualAllocs.push_back(alloc);
+    }
+    std::sort(ranges.begin(), ranges.end(),
+        [](const Range& lhs, const Range& rhs) { return lhs.offset < rhs.offset; });
+    for(size_t i = 1; i < ranges.size(); ++i)
+        CHECK_BOOL( ranges[i - 1].offset + ranges[i - 1].size <= ranges[i].offset );
+
+    D3D12MA::DetailedStatistics stats = {};
+    block->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Stats.AllocationCount == sizeof(sizes) / sizeof(sizes[0]) );
+    CHECK_BOOL( stats.Stats.BlockBytes == 1000 );
+
+    D3D12MA::VIRTUAL_ALLOCATION_DESC wholeDesc = {};
+    wholeDesc.Size = 512;
+    D3D12MA::VirtualAllocation wholeAlloc;
+    CHECK_BOOL( FAILED(block->Allocate(&wholeDesc, &wholeAlloc, NULL)) );
+
+    // Freed nodes are merged back, so the whole usable range is available again.
+    for(D3D12MA::VirtualAllocation& alloc : virtualAllocs)
+        block->FreeAllocation(alloc);
+    CHECK_BOOL( block->IsEmpty() );
+    UINT64 wholeOffset = UINT64_MAX;
+    CHECK_HR( block->Allocate(&wholeDesc, &wholeAlloc, &wholeOffset) );
+    CHECK_BOOL( wholeOffset == 0 );
+    block->FreeAllocation(wholeAlloc);
+    block->Release();
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 allocSize = 64 * 1024;
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    poolDesc.BlockSize = blockSize;
+    poolDesc.Flags = D3D12MA::POOL_FLAG_ALGORITHM_BUDDY;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( ctx.allocator->CreatePool(&poolDesc, &pool) );
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.CustomPool = pool;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { allocSize, allocSize };
+    std::vector<D3D12MA::Allocation*> allocs(blockSize / allocSize * 2);
+    for(D3D12MA::Allocation*& alloc : allocs)
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+    D3D12MA::Statistics poolStats = {};
+    pool->GetStatistics(&poolStats);
+    CHECK_BOOL( poolStats.BlockCount == 2 );
+
+    // Allocation not of a power-of-2 size takes a whole node of the next one.
+    const D3D12_RESOURCE_ALLOCATION_INFO largeInfo = { allocSize * 3, allocSize };
+    D3D12MA::Allocation* largeAlloc = NULL;
+    CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &largeInfo, &largeAlloc) );
+    CHECK_BOOL( largeAlloc->GetOffset() % (allocSize * 4) == 0 );
+
+    std::vector<std::vector<unsigned char>> parts;
+    ctx.allocator->WriteStatsString(AppendStatsStringPart, &parts, D3D12MA::STATS_STRING_ENCODING_UTF8, TRUE);
+    std::string json;
+    for(const std::vector<unsigned char>& part : parts)
+        json.append(part.begin(), part.end());
+    CHECK_BOOL( json.find("\"Algorithm\": \"Buddy\"") != std::string::npos );
+
+    // Defragmentation fills the holes left by every other freed allocation.
+    largeAlloc->Release();
+    for(size_t i = 0; i < allocs.size(); i += 2)
+    {
+        allocs[i]->Release();
+        allocs[i] = NULL;
+    }
+    D3D12MA::DEFRAGMENTATION_DESC defragDesc = {};
+    defragDesc.Flags = D3D12MA::DEFRAGMENTATION_FLAG_ALGORITHM_FULL;
+    D3D12MA::DefragmentationContext* defragCtx = NULL;
+    CHECK_HR( pool->BeginDefragmentation(&defragDesc, &defragCtx) );
+    for(;;)
+    {
+        D3D12MA::DEFRAGMENTATION_PASS_MOVE_INFO passInfo = {};
+        if(defragCtx->BeginPass(&passInfo) == S_OK)
+            break;
+        if(defragCtx->EndPass(&passInfo) == S_OK)
+            break;
+    }
+    D3D12MA::DEFRAGMENTATION_STATS defragStats = {};
+    defragCtx->GetStats(&defragStats);
+    defragCtx->Release();
+    CHECK_BOOL( defragStats.AllocationsMoved == allocs.size() / 4 );
+    // The emptied block may be kept for future allocations.
+    ID3D12Heap* const heap = allocs[1]->GetHeap();
+    for(size_t i = 1; i < allocs.size(); i += 2)
+        CHECK_BOOL( allocs[i]->GetHeap() == heap );
+
+    for(D3D12MA::Allocation* alloc : allocs)
+    {
+        if(alloc != NULL)
+            alloc->Release();
+    }
+    pool->Release();
+    DestroyContext(ctx);
+}
+
+static void TestSlabAlgorithm()
+{
+    wprintf(L"Test slab algorithm\n");
+
+    // 10 slots fit in the virtual block, the last 40 units are never used.
+    D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+    blockDesc.Size = 1000;
+    blockDesc.SlotSize = 96;
+    blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB;
+    D3D12MA::VirtualBlock* block = NULL;
+    CHECK_HR( D3D12MA::CreateVirtualBlock(&blockDesc, &block) );
+
+    D3D12MA::VIRTUAL_ALLOCATION_DESC tooLargeDesc = {};
+    tooLargeDesc.Size = 97;
+    D3D12MA::VirtualAllocation tooLargeAlloc;
+    CHECK_BOOL( FAILED(block->Allocate(&tooLargeDesc, &tooLargeAlloc, NULL)) );
+
+    std::vector<D3D12MA::VirtualAllocation> virtualAllocs;
+    UINT64 allocationBytes = 0;
+    for(UINT64 i = 0; i < 10; ++i)
+    {
+        D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+        allocDesc.Size = 1 + i * 10;
+        D3D12MA::VirtualAllocation alloc;
+        UINT64 offset = UINT64_MAX;
+        CHECK_HR( block->Allocate(&allocDesc, &alloc, &offset) );
+        // The lowest free slot is always taken.
+        CHECK_BOOL( offset == i * 96 );
+        D3D12MA::VIRTUAL_ALLOCATION_INFO info = {};
+        block->GetAllocationInfo(alloc, &info);
+        CHECK_BOOL( info.Offset == offset && info.Size == allocDesc.Size );
+        virtualAllocs.push_back(alloc);
+        allocationBytes += allocDesc.Size;
+    }
+    D3D12MA::VIRTUAL_ALLOCATION_DESC smallDesc = {};
+    smallDesc.Size = 1;
+    D3D12MA::VirtualAllocation smallAlloc;
+    CHECK_BOOL( FAILED(block->Allocate(&smallDesc, &smallAlloc, NULL)) );
+
+    D3D12MA::DetailedStatistics stats = {};
+    block->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Stats.BlockBytes == 1000 );
+    CHECK_BOOL( stats.Stats.AllocationCount == 10 );
+    CHECK_BOOL( stats.Stats.AllocationBytes == allocationBytes );
+    // Unused rest of every slot and the unused end of the block.
+    CHECK_BOOL( stats.UnusedRangeCount == 11 );
+
+    // Allocation with larger alignment skips slots with misaligned offsets.
+    for(size_t i = 0; i < 3; ++i)
+        block->FreeAllocation(virtualAllocs[i]);
+    D3D12MA::VIRTUAL_ALLOCATION_DESC alignedDesc = {};
+    alignedDesc.Size = 32;
+    alignedDesc.Alignment = 64;
+    UINT64 alignedOffset = UINT64_MAX;
+    CHECK_HR( block->Allocate(&alignedDesc, &virtualAllocs[2], &alignedOffset) );
+    CHECK_BOOL( alignedOffset == 0 );
+    CHECK_HR( block->Allocate(&alignedDesc, &virtualAllocs[0], &alignedOffset) );
+    CHECK_BOOL( alignedOffset == 192 );
+    alignedDesc.Alignment = 128;
+    CHECK_BOOL( FAILED(block->Allocate(&alignedDesc, &virtualAllocs[1], NULL)) );
+    CHECK_HR( block->Allocate(&smallDesc, &virtualAllocs[1], &alignedOffset) );
+    CHECK_BOOL( alignedOffset == 96 );
+
+    block->Clear();
+    CHECK_BOOL( block->IsEmpty() );
+    block->Release();
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    const UINT64 blockSize = 1024 * 1024;
+    const UINT64 slotSize = 64 * 1024;
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    poolDesc.BlockSize = blockSize;
+    poolDesc.SlotSize = slotSize;
+    poolDesc.Flags = D3D12MA::POOL_FLAG_ALGORITHM_SLAB;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( ctx.allocator->CreatePool(&poolDesc, &pool) );
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.CustomPool = pool;
+    std::vector<D3D12MA::Allocation*> allocs(blockSize / slotSize * 2);
+    for(size_t i = 0; i < allocs.size(); ++i)
+    {
+        // Allocations smaller than the slot still take a whole one.
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { i % 2 ? slotSize : slotSize / 16, 4096 };
+        CHECK_HR( ctx.allocator->AllocateMemory(&allocDesc, &allocInfo, &allocs[i]) );
+        CHECK_BOOL( allocs[i]->GetOffset() % slotSize == 0 );
+    }
+    D3D12MA::Statistics poolStats = {};
+    pool->GetStatistics(&poolStats);
+    CHECK_BOOL( poolStats.BlockCount == 2 );
+    CHECK_BOOL( poolStats.AllocationBytes == allocs.size() / 2 * (slotSize + slotSize / 16) );
+
+    std::vector<std::vector<unsigned char>> parts;
+    ctx.allocator->WriteStatsString(AppendStatsStringPart, &parts, D3D12MA::STATS_STRING_ENCODING_UTF8, TRUE);
+    std::string json;
+    for(const std::vector<unsigned char>& part : parts)
+        json.append(part.begin(), part.end());
+    CHECK_BOOL( json.find("\"Algorithm\": \"Slab\"") != std::string::npos );
+    CHECK_BOOL( json.find("\"SlotSize\": 65536") != std::string::npos );
+
+    // Defragmentation fills the slots left by every other freed allocation.
+    for(size_t i = 0; i < allocs.size(); i += 2)
+    {
+        allocs[i]->Release();
+        allocs[i] = NULL;
+    }
+    D3D12MA::DEFRAGMENTATION_DESC defragDesc = {};
+    defragDesc.Flags = D3D12MA::DEFRAGMENTATION_FLAG_ALGORITHM_FULL;
+    D3D12MA::DefragmentationContext* defragCtx = NULL;
+    CHECK_HR( pool->BeginDefragmentation(&defragDesc, &defragCtx) );
+    for(;;)
+    {
+        D3D12MA::DEFRAGMENTATION_PASS_MOVE_INFO passInfo = {};
+        if(defragCtx->BeginPass(&passInfo) == S_OK)
+            break;
+        if(defragCtx->EndPass(&passInfo) == S_OK)
+            break;
+    }
+    D3D12MA::DEFRAGMENTATION_STATS defragStats = {};
+    defragCtx->GetStats(&defragStats);
+    defragCtx->Release();
+    CHECK_BOOL( defragStats.AllocationsMoved == allocs.size() / 4 );
+    ID3D12Heap* const heap = allocs[1]->GetHeap();
+    for(size_t i = 1; i < allocs.size(); i += 2)
+        CHECK_BOOL( allocs[i]->GetHeap() == heap );
+
+    for(D3D12MA::Allocation* alloc : allocs)
+    {
+        if(alloc != NULL)
+            alloc->Release();
+    }
+    pool->Release();
+    DestroyContext(ctx);
+}
+
+static void TestBufferSubAllocation()
+{
+    wprintf(L"Test buffer suballocation\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    // Small ranges share one buffer, each in its own 256 B slot.
+    std::vector<D3D12MA::Allocation*> allocs(100);
+    for(size_t i = 0; i < allocs.size(); ++i)
+    {
+        CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&allocDesc, 200, 0, &allocs[i]) );
+        CHECK_BOOL( allocs[i]->GetResource() == allocs[0]->GetResource() );
+        CHECK_BOOL( allocs[i]->GetHeap() == allocs[0]->GetHeap() );
+        CHECK_BOOL( allocs[i]->GetSize() == 200 );
+        CHECK_BOOL( allocs[i]->GetBufferOffset() % 256 == 0 );
+        CHECK_BOOL( allocs[i]->GetGPUVirtualAddress() - allocs[i]->GetBufferOffset() ==
+            allocs[0]->GetGPUVirtualAddress() - allocs[0]->GetBufferOffset() );
+        CHECK_BOOL( allocs[i]->GetOffset() - allocs[i]->GetBufferOffset() ==
+            allocs[0]->GetOffset() - allocs[0]->GetBufferOffset() );
+        for(size_t j = 0; j < i; ++j)
+            CHECK_BOOL( allocs[i]->GetBufferOffset() != allocs[j]->GetBufferOffset() );
+    }
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 1 );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_PLACED_RESOURCE) +
+        ctx.device->GetCallCount(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE) == 1 );
+
+    // Larger size or alignment goes to the next size class, with its own buffer.
+    D3D12MA::Allocation* alignedAlloc = NULL;
+    CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&allocDesc, 16, 512, &alignedAlloc) );
+    CHECK_BOOL( alignedAlloc->GetBufferOffset() % 4096 == 0 );
+    CHECK_BOOL( alignedAlloc->GetResource() != allocs[0]->GetResource() );
+    D3D12MA::Allocation* largeAlloc = NULL;
+    CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&allocDesc, 64 * 1024, 0, &largeAlloc) );
+    CHECK_BOOL( largeAlloc->GetResource() != allocs[0]->GetResource() &&
+        largeAlloc->GetResource() != alignedAlloc->GetResource() );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 3 );
+
+    // Only shared buffers are visible in statistics.
+    D3D12MA::TotalStatistics stats = {};
+    ctx.allocator->CalculateStatistics(&stats);
+    CHECK_BOOL( stats.Total.Stats.AllocationCount == 3 );
+
+    // Freeing the ranges keeps one empty buffer per size class.
+    ctx.allocator->FreeAllocations((UINT)allocs.size(), allocs.data());
+    alignedAlloc->Release();
+    largeAlloc->Release();
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 3 );
+
+    D3D12MA::ALLOCATION_DESC uploadDesc = {};
+    uploadDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+    D3D12MA::Allocation* uploadAlloc = NULL;
+    CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&uploadDesc, 100, 0, &uploadAlloc) );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 4 );
+    uploadAlloc->Release();
+
+    DestroyContext(ctx);
+
+    // Shared buffers are never moved by defragmentation.
+    CreateContext(ctx);
+    std::vector<D3D12MA::Allocation*> buffers(4);
+    for(D3D12MA::Allocation*& buffer : buffers)
+    {
+        D3D12_RESOURCE_DESC resDesc;
+        FillResourceDescForBuffer(resDesc, 64 * 1024);
+        CHECK_HR( ctx.allocator->CreateResource(&allocDesc, &resDesc, D3D12_RESOURCE_STATE_COMMON,
+            NULL, &buffer, IID_NULL, NULL) );
+    }
+    D3D12MA::Allocation* rangeAlloc = NULL;
+    CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&allocDesc, 256, 0, &rangeAlloc) );
+    const UINT64 rangeOffset = rangeAlloc->GetOffset();
+    ctx.allocator->FreeAllocations((UINT)buffers.size(), buffers.data());
+
+    D3D12MA::DEFRAGMENTATION_DESC defragDesc = {};
+    defragDesc.Flags = D3D12MA::DEFRAGMENTATION_FLAG_ALGORITHM_FULL;
+    D3D12MA::DefragmentationContext* defragCtx = NULL;
+    ctx.allocator->BeginDefragmentation(&defragDesc, &defragCtx);
+    for(;;)
+    {
+        D3D12MA::DEFRAGMENTATION_PASS_MOVE_INFO passInfo = {};
+        if(defragCtx->BeginPass(&passInfo) == S_OK)
+            break;
+        for(UINT i = 0; i < passInfo.MoveCount; ++i)
+            CHECK_BOOL( passInfo.pMoves[i].pSrcAllocation->GetResource() != rangeAlloc->GetResource() );
+        if(defragCtx->EndPass(&passInfo) == S_OK)
+            break;
+    }
+    D3D12MA::DEFRAGMENTATION_STATS defragStats = {};
+    defragCtx->GetStats(&defragStats);
+    defragCtx->Release();
+    CHECK_BOOL( defragStats.AllocationsMoved == 0 );
+    CHECK_BOOL( rangeAlloc->GetOffset() == rangeOffset );
+
+    rangeAlloc->Release();
+    DestroyContext(ctx);
+}
+
+static void TestBufferSubAllocationLarge()
+{
+    wprintf(L"Test buffer suballocation of large ranges\n");
+
+    MockTestContext ctx;
+    CreateContext(ctx);
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+
+    // Ranges larger than the largest slot share a bigger buffer with no rounding of their sizes.
+    std::vector<D3D12MA::Allocation*> allocs(50);
+    for(size_t i = 0; i < allocs.size(); ++i)
+    {
+        const UINT64 size = 65 * 1024 + i * 1000;
+        CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&allocDesc, size, 256, &allocs[i]) );
+        CHECK_BOOL( allocs[i]->GetResource() == allocs[0]->GetResource() );
+        CHECK_BOOL( allocs[i]->GetBufferOffset() % 256 == 0 );
+        CHECK_BOOL( allocs[i]->GetGPUVirtualAddress() ==
+            allocs[i]->GetResource()->GetGPUVirtualAddress() + allocs[i]->GetBufferOffset() );
+    }
+    std::vector<D3D12MA::Allocation*> sorted = allocs;
+    std::sort(sorted.begin(), sorted.end(), [](D3D12MA::Allocation* lhs, D3D12MA::Allocation* rhs)
+        { return lhs->GetBufferOffset() < rhs->GetBufferOffset(); });
+    for(size_t i = 1; i < sorted.size(); ++i)
+        CHECK_BOOL( sorted[i - 1]->GetBufferOffset() + sorted[i - 1]->GetSize() <= sorted[i]->GetBufferOffset() );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 1 );
+
+    // A range larger than the shared buffers gets a buffer of its own, released together with it.
+    D3D12MA::Allocation* hugeAlloc = NULL;
+    CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&allocDesc, 20 * 1024 * 1024, 0, &hugeAlloc) );
+    CHECK_BOOL( hugeAlloc->GetResource() != allocs[0]->GetResource() );
+    CHECK_BOOL( hugeAlloc->GetBufferOffset() == 0 );
+    CHECK_BOOL( hugeAlloc->GetResource()->GetDesc().Width >= 20 * 1024 * 1024 );
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 2 );
+    hugeAlloc->Release();
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 1 );
+
+    // The empty shared buffer is kept for next ranges.
+    ctx.allocator->FreeAllocations((UINT)allocs.size(), allocs.data());
+    CHECK_BOOL( ctx.device->GetLiveResourceCount() == 1 );
+    ctx.device->ResetCallCounts();
+    D3D12MA::Allocation* alloc = NULL;
+    CHECK_HR( ctx.allocator->CreateBufferSubAllocation(&allocDesc, 1024 * 1024, 0, &alloc) );
+    CHECK_BOOL( ctx.device->GetCallCount(MOCK_OPERATION_CREATE_PLACED_RESOURCE) +
+        ctx.device->GetCallCount(MOCK_OPERATION_CREATE_COMMITTED_RESOURCE) == 0 );
+    alloc->Release();
+
+    DestroyContext(ctx);
+}
+
+int main()
+{
+    wprintf(L"MOCK TESTS BEGIN\n");
+    try
+    {
+        TestPlacedResources();
+        TestCommittedResources();
+        TestCreateHeapFailure();
+        TestBudget();
+        TestBudgetMultithreaded();
+        TestBudgetUpdateModes();
+        TestCapacity();
+        TestResourceHeapTier1();
+        TestSmallTextureAlignment();
+        TestLatency();
+        TestMultithreading();
+        TestBatch();
+        TestFreeAllocations();
+        TestReleaseDeferred();
+        TestManyBlocks();
+        TestLargestFreeRegion();
+        TestLockFreeStatistics();
+        TestResourceAllocationInfoCache();
+        TestWriteStatsString();
+        TestWriteStatsBinary();
+        TestSnapshotChanges();
+        TestTraceEvents();
+        TestPerformanceCounters();
+#if D3D12MA_PROFILE_LOCKS
+        TestLockProfiles();
+#endif
+        TestVirtualBlock();
+        TestVirtualBlockMixedAlignment();
+        TestVirtualBlockThreadSafe();
+        TestBuddyAlgorithm();
+        TestSlabAlgorithm();
+        TestBufferSubAllocation();
+        TestBufferSubAllocationLarge();
+    }
+    catch(const std::exception& ex)
+    {
+        wprintf(L"ERROR: %hs\n", ex.what());
+        return 1;
+    }
+    wprintf(L"MOCK TESTS END\n");
+    return 0;
+}
@@ -92,6 +92,10 @@ static const char* AlgorithmToStr(D3D12MA::POOL_FLAGS algorithm)
     {
     case D3D12MA::POOL_FLAG_ALGORITHM_LINEAR:
         return "Linear";
+    case D3D12MA::POOL_FLAG_ALGORITHM_BUDDY:
+        return "Buddy";
+    case D3D12MA::POOL_FLAG_ALGORITHM_SLAB:
+        return "Slab";
     case 0:
         return "TLSF";
     default:
@@ -106,6 +110,10 @@ static const char* VirtualAlgorithmToStr(D3D12MA::VIRTUAL_BLOCK_FLAGS algorithm)
     {
     case D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR:
         return "Linear";
+    case D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY:
+        return "Buddy";
+    case D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB:
+        return "Slab";
     case 0:
         return "TLSF";
     default:
@@ -419,12 +427,17 @@ static void TestDebugMargin(const TestContext& ctx)
 
     CPOOL_DESC poolDesc = CPOOL_DESC{ D3D12_HEAP_TYPE_UPLOAD, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS };
 
-    for(size_t algorithmIndex = 0; algorithmIndex < 2; ++algorithmIndex)
+    for(size_t algorithmIndex = 0; algorithmIndex < 4; ++algorithmIndex)
     {
         switch(algorithmIndex)
         {
         case 0: poolDesc.Flags = POOL_FLAG_NONE; break;
         case 1: poolDesc.Flags = POOL_FLAG_ALGORITHM_LINEAR; break;
+        case 2: poolDesc.Flags = POOL_FLAG_ALGORITHM_BUDDY; break;
+        case 3:
+            poolDesc.Flags = POOL_FLAG_ALGORITHM_SLAB;
+            poolDesc.SlotSize = 0x100000; // Largest buffer + margin must fit in a slot.
+            break;
         default: assert(0);
         }
         ComPtr<Pool> pool;
@@ -3021,6 +3034,7 @@ static void BenchmarkAlgorithmsCase(const TestContext& ctx,
         bufSize * maxBufCapacity, // blockSize
         1, // minBlockCount
         1 }; // maxBlockCount
+    poolDesc.SlotSize = bufSize; // Used only by POOL_FLAG_ALGORITHM_SLAB.
     ComPtr<D3D12MA::Pool> pool;
     CHECK_HR(ctx.allocator->CreatePool(&poolDesc, &pool));
 
@@ -3149,7 +3163,7 @@ static void BenchmarkAlgorithms(const TestContext& ctx, FILE* file)
 
         for (UINT32 emptyIndex = 0; emptyIndex < emptyCount; ++emptyIndex)
         {
-            for (UINT32 algorithmIndex = 0; algorithmIndex < 2; ++algorithmIndex)
+            for (UINT32 algorithmIndex = 0; algorithmIndex < 4; ++algorithmIndex)
             {
                 D3D12MA::POOL_FLAGS algorithm;
                 switch (algorithmIndex)
@@ -3160,6 +3174,12 @@ static void BenchmarkAlgorithms(const TestContext& ctx, FILE* file)
                 case 1:
                     algorithm = D3D12MA::POOL_FLAG_ALGORITHM_LINEAR;
                     break;
+                case 2:
+                    algorithm = D3D12MA::POOL_FLAG_ALGORITHM_BUDDY;
+                    break;
+                case 3:
+                    algorithm = D3D12MA::POOL_FLAG_ALGORITHM_SLAB;
+                    break;
                 default:
                     assert(0);
                 }
@@ -3765,7 +3785,7 @@ static void TestVirtualBlocksAlgorithms(const TestContext& ctx)
     RandomNumberGenerator rand{ 3454335 };
     auto calcRandomAllocSize = [&rand]() -> UINT64 { return rand.Generate() % 20 + 5; };
 
-    for (size_t algorithmIndex = 0; algorithmIndex < 2; ++algorithmIndex)
+    for (size_t algorithmIndex = 0; algorithmIndex < 4; ++algorithmIndex)
     {
         // Create the block
         D3D12MA::CVIRTUAL_BLOCK_DESC blockDesc = D3D12MA::CVIRTUAL_BLOCK_DESC{
@@ -3776,6 +3796,11 @@ static void TestVirtualBlocksAlgorithms(const TestContext& ctx)
         {
         case 0: blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_NONE; break;
         case 1: blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR; break;
+        case 2: blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY; break;
+        case 3:
+            blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB;
+            blockDesc.SlotSize = 32; // Fits the largest allocation and keeps the 16-byte alignment.
+            break;
         }
         ComPtr<D3D12MA::VirtualBlock> block;
         CHECK_HR(D3D12MA::CreateVirtualBlock(&blockDesc, &block));
@@ -3940,6 +3965,7 @@ static void TestVirtualBlocksAlgorithmsBenchmark(const TestContext& ctx)
         blockDesc.Size += allocSizes[i];
     }
     blockDesc.Size = static_cast<UINT64>(blockDesc.Size * 1.5); // 50% size margin in case of alignment
+    const UINT64 blockSize = blockDesc.Size;
 
     for (UINT8 alignmentIndex = 0; alignmentIndex < 4; ++alignmentIndex)
     {
@@ -3954,8 +3980,9 @@ static void TestVirtualBlocksAlgorithmsBenchmark(const TestContext& ctx)
         }
         printf("    Alignment=%llu\n", alignment);
 
-        for (UINT8 algorithmIndex = 0; algorithmIndex < 2; ++algorithmIndex)
+        for (UINT8 algorithmIndex = 0; algorithmIndex < 4; ++algorithmIndex)
         {
+            blockDesc.Size = blockSize;
             switch (algorithmIndex)
             {
             case 0:
@@ -3964,6 +3991,17 @@ static void TestVirtualBlocksAlgorithmsBenchmark(const TestContext& ctx)
             case 1:
                 blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR;
                 break;
+            case 2:
+                blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY;
+                // Buddy rounds allocations up to a power of 2 and uses only the largest power-of-2 part of the block.
+                blockDesc.Size = blockSize * 4;
+                break;
+            case 3:
+                blockDesc.Flags = D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_SLAB;
+                // One slot per allocation, aligned to the largest alignment tested.
+                blockDesc.SlotSize = (MAX_ALLOC_SIZE + 255) / 256 * 256;
+                blockDesc.Size = ALLOCATION_COUNT * blockDesc.SlotSize;
+                break;
             default:
                 assert(0);
             }
@@ -0,0 +1,712 @@
+//
+// Copyright (c) 2019-2026 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/*
+Replays a trace written by D3D12MA::Allocator::WriteTraceEvents() to reproduce
+fragmentation seen in an application and compare algorithms offline.
+
+Every pool of the trace is replayed in a list of virtual blocks of the same size as
+its blocks in the trace, once per algorithm and strategy. With the mock device, the
+trace is also replayed through a real allocator. Run with --help to see options.
+*/
+
+#include "D3D12MemAlloc.h"
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+    #include "MockD3D12.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define STRINGIZE(x) STRINGIZE2(x)
+#define STRINGIZE2(x) #x
+#define LINE_STRING STRINGIZE(__LINE__)
+#define CHECK_BOOL(expr)  do { if(!(expr)) { \
+        fprintf(stderr, "%s\n", __FILE__ "(" LINE_STRING "): ( " #expr " ) == false"); \
+        exit(1); \
+    } } while(false)
+#define CHECK_HR(expr)  do { if(FAILED(expr)) { \
+        fprintf(stderr, "%s\n", __FILE__ "(" LINE_STRING "): FAILED( " #expr " )"); \
+        exit(1); \
+    } } while(false)
+
+typedef std::chrono::steady_clock::time_point time_point;
+
+static inline time_point Now() { return std::chrono::steady_clock::now(); }
+static inline UINT64 ElapsedNs(time_point beg, time_point end)
+{
+    return (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count();
+}
+
+static const UINT64 DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+struct ReplayConfig
+{
+    const char* TracePath = NULL;
+    const char* SyntheticPath = NULL;
+    // 0 means the size of blocks created in the trace.
+    UINT64 BlockSize = 0;
+    bool Csv = false;
+};
+
+static ReplayConfig g_Config;
+
+////////////////////////////////////////////////////////////////////////////////
+// Reading the trace
+
+struct TraceReader
+{
+    const std::vector<unsigned char>& data;
+    size_t pos;
+
+    bool AtEnd() const { return pos >= data.size(); }
+    unsigned char Byte() { CHECK_BOOL( pos < data.size() ); return data[pos++]; }
+    UINT64 Number()
+    {
+        UINT64 result = 0;
+        for(UINT shift = 0; ; shift += 7)
+        {
+            const unsigned char b = Byte();
+            result |= (UINT64)(b & 0x7F) << shift;
+            if(b < 0x80)
+                return result;
+        }
+    }
+    int64_t SignedNumber()
+    {
+        const UINT64 n = Number();
+        return (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+    }
+};
+
+static bool LoadFile(const char* path, std::vector<unsigned char>& outData)
+{
+    FILE* file = fopen(path, "rb");
+    if(file == NULL)
+        return false;
+    unsigned char buf[65536];
+    size_t byteCount;
+    while((byteCount = fread(buf, 1, sizeof(buf), file)) > 0)
+        outData.insert(outData.end(), buf, buf + byteCount);
+    fclose(file);
+    return true;
+}
+
+// The file may contain many traces written one after another, each continuing the previous one.
+static void ParseTrace(const std::vector<unsigned char>& data, std::vector<D3D12MA::TRACE_EVENT>& outEvents)
+{
+    TraceReader reader = { data, 0 };
+    while(!reader.AtEnd())
+    {
+        CHECK_BOOL( reader.Byte() == 'D' && reader.Byte() == 'M' && reader.Byte() == 'A' && reader.Byte() == 'T' );
+        CHECK_BOOL( reader.Number() == 3 );
+        UINT64 sequenceNumber = 0, timestamp = 0;
+        for(;;)
+        {
+            const UINT64 type = reader.Number();
+            if(type == 0)
+                break;
+            D3D12MA::TRACE_EVENT event = {};
+            event.Type = (D3D12MA::TRACE_EVENT_TYPE)(type - 1);
+            event.SequenceNumber = sequenceNumber += reader.Number();
+            event.Timestamp = timestamp += (UINT64)reader.SignedNumber();
+            event.ThreadId = (UINT)reader.Number();
+            if(event.Type == D3D12MA::TRACE_EVENT_TYPE_BUDGET_UPDATE)
+            {
+                event.MemorySegmentGroup = (UINT)reader.Number();
+                event.UsageBytes = reader.Number();
+                event.BudgetBytes = reader.Number();
+            }
+            else
+            {
+                event.HeapType = (D3D12_HEAP_TYPE)reader.Number();
+                event.PoolId = (UINT)reader.Number();
+                if(event.Type == D3D12MA::TRACE_EVENT_TYPE_CREATE_BLOCK || event.Type == D3D12MA::TRACE_EVENT_TYPE_DESTROY_BLOCK)
+                {
+                    event.BlockId = (UINT)reader.Number();
+                    event.Size = reader.Number();
+                }
+                else
+                {
+                    event.BlockId = (UINT)reader.Number() - 1;
+                    event.AllocationId = reader.Number();
+                    event.Offset = reader.Number();
+                    event.Size = reader.Number();
+                    if(event.Type == D3D12MA::TRACE_EVENT_TYPE_ALLOCATE)
+                        event.Alignment = reader.Number();
+                    else if(event.Type == D3D12MA::TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE)
+                        event.TemporaryAllocationId = reader.Number();
+                }
+            }
+            outEvents.push_back(event);
+        }
+    }
+}
+
+static inline UINT64 PoolKey(const D3D12MA::TRACE_EVENT& event)
+{
+    return ((UINT64)event.HeapType << 32) | event.PoolId;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Results
+
+struct ReplayResult
+{
+    std::string Name;
+    UINT64 AllocationCount = 0;
+    UINT64 FailedAllocationCount = 0;
+    // Frees of allocations made before the trace begins.
+    UINT64 UnknownFreeCount = 0;
+    UINT64 PeakBlockBytes = 0;
+    UINT64 PeakAllocationBytes = 0;
+    UINT64 FinalBlockBytes = 0;
+    UINT64 FinalAllocationBytes = 0;
+    UINT64 TimeNs = 0;
+    UINT64 OperationCount = 0;
+};
+
+static void PrintResults(const std::vector<ReplayResult>& results)
+{
+    if(g_Config.Csv)
+    {
+        printf("Replay,Allocations,Failed,UnknownFrees,PeakBlockBytes,PeakAllocationBytes,FinalBlockBytes,FinalAllocationBytes,TimePerOperation_ns\n");
+        for(const ReplayResult& r : results)
+        {
+            printf("%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.1f\n", r.Name.c_str(),
+                (unsigned long long)r.AllocationCount, (unsigned long long)r.FailedAllocationCount,
+                (unsigned long long)r.UnknownFreeCount, (unsigned long long)r.PeakBlockBytes,
+                (unsigned long long)r.PeakAllocationBytes, (unsigned long long)r.FinalBlockBytes,
+                (unsigned long long)r.FinalAllocationBytes,
+                r.OperationCount ? (double)r.TimeNs / r.OperationCount : 0.0);
+        }
+        return;
+    }
+    printf("%-24s %12s %8s %14s %10s %14s %10s %10s\n",
+        "Replay", "Allocations", "Failed", "PeakBlocks", "PeakUsed", "FinalBlocks", "FinalUsed", "ns/op");
+    for(const ReplayResult& r : results)
+    {
+        printf("%-24s %12llu %8llu %11.1f MB %8.1f %% %11.1f MB %8.1f %% %10.1f\n", r.Name.c_str(),
+            (unsigned long long)r.AllocationCount, (unsigned long long)r.FailedAllocationCount,
+            r.PeakBlockBytes / (1024.0 * 1024.0),
+            r.PeakBlockBytes ? 100.0 * r.PeakAllocationBytes / r.PeakBlockBytes : 0.0,
+            r.FinalBlockBytes / (1024.0 * 1024.0),
+            r.FinalBlockBytes ? 100.0 * r.FinalAllocationBytes / r.FinalBlockBytes : 0.0,
+            r.OperationCount ? (double)r.TimeNs / r.OperationCount : 0.0);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Replay in virtual blocks
+
+struct VirtualAlgorithm
+{
+    const char* Name;
+    D3D12MA::VIRTUAL_BLOCK_FLAGS BlockFlags;
+    D3D12MA::VIRTUAL_ALLOCATION_FLAGS AllocationFlags;
+};
+
+static const VirtualAlgorithm VIRTUAL_ALGORITHMS[] = {
+    { "TLSF MinMemory", D3D12MA::VIRTUAL_BLOCK_FLAG_NONE, D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_MEMORY },
+    { "TLSF MinTime", D3D12MA::VIRTUAL_BLOCK_FLAG_NONE, D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_TIME },
+    { "TLSF MinOffset", D3D12MA::VIRTUAL_BLOCK_FLAG_NONE, D3D12MA::VIRTUAL_ALLOCATION_FLAG_STRATEGY_MIN_OFFSET },
+    { "Linear", D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_LINEAR, D3D12MA::VIRTUAL_ALLOCATION_FLAG_NONE },
+    { "Buddy", D3D12MA::VIRTUAL_BLOCK_FLAG_ALGORITHM_BUDDY, D3D12MA::VIRTUAL_ALLOCATION_FLAG_NONE },
+};
+
+// Size of blocks of every pool, as created in the trace.
+static std::map<UINT64, UINT64> GetBlockSizes(const std::vector<D3D12MA::TRACE_EVENT>& events)
+{
+    std::map<UINT64, UINT64> blockSizes;
+    for(const D3D12MA::TRACE_EVENT& event : events)
+    {
+        if(event.Type == D3D12MA::TRACE_EVENT_TYPE_CREATE_BLOCK || event.Type == D3D12MA::TRACE_EVENT_TYPE_DESTROY_BLOCK)
+        {
+            UINT64& blockSize = blockSizes[PoolKey(event)];
+            blockSize = std::max(blockSize, event.Size);
+        }
+    }
+    return blockSizes;
+}
+
+/*
+Allocations are placed in the first block with enough space, and a new block is
+created when none has it, like the library does. Empty blocks are destroyed, except
+one per pool kept for the next allocation. Committed allocations are not replayed,
+as they don't depend on the algorithm.
+*/
+static ReplayResult ReplayVirtual(const std::vector<D3D12MA::TRACE_EVENT>& events, const VirtualAlgorithm& algorithm)
+{
+    struct Pool
+    {
+        UINT64 BlockSize = 0;
+        std::vector<D3D12MA::VirtualBlock*> Blocks;
+    };
+    struct Placement
+    {
+        Pool* pool;
+        D3D12MA::VirtualBlock* block;
+        D3D12MA::VirtualAllocation allocation;
+        UINT64 size;
+    };
+
+    ReplayResult result;
+    result.Name = algorithm.Name;
+    const std::map<UINT64, UINT64> blockSizes = GetBlockSizes(events);
+    std::map<UINT64, Pool> pools;
+    std::unordered_map<UINT64, Placement> placements;
+    UINT64 blockBytes = 0, allocationBytes = 0;
+
+    for(const D3D12MA::TRACE_EVENT& event : events)
+    {
+        if(event.Type == D3D12MA::TRACE_EVENT_TYPE_ALLOCATE && event.BlockId != UINT_MAX)
+        {
+            ++result.AllocationCount;
+            Pool& pool = pools[PoolKey(event)];
+            if(pool.BlockSize == 0)
+            {
+                const auto it = blockSizes.find(PoolKey(event));
+                pool.BlockSize = g_Config.BlockSize ? g_Config.BlockSize :
+                    it != blockSizes.end() ? it->second : DEFAULT_BLOCK_SIZE;
+            }
+
+            D3D12MA::VIRTUAL_ALLOCATION_DESC allocDesc = {};
+            allocDesc.Flags = algorithm.AllocationFlags;
+            allocDesc.Size = event.Size;
+            allocDesc.Alignment = event.Alignment;
+            Placement placement = { &pool, NULL, {}, event.Size };
+            const time_point beg = Now();
+            for(D3D12MA::VirtualBlock* block : pool.Blocks)
+            {
+                if(SUCCEEDED(block->Allocate(&allocDesc, &placement.allocation, NULL)))
+                {
+                    placement.block = block;
+                    break;
+                }
+            }
+            if(placement.block == NULL && event.Size <= pool.BlockSize)
+            {
+                D3D12MA::VIRTUAL_BLOCK_DESC blockDesc = {};
+                blockDesc.Flags = algorithm.BlockFlags;
+                blockDesc.Size = pool.BlockSize;
+                D3D12MA::VirtualBlock* block = NULL;
+                CHECK_HR( D3D12MA::CreateVirtualBlock(&blockDesc, &block) );
+                if(SUCCEEDED(block->Allocate(&allocDesc, &placement.allocation, NULL)))
+                {
+                    pool.Blocks.push_back(block);
+                    placement.block = block;
+                    blockBytes += pool.BlockSize;
+                }
+                else
+                    block->Release();
+            }
+            result.TimeNs += ElapsedNs(beg, Now());
+            ++result.OperationCount;
+
+            if(placement.block == NULL)
+            {
+                ++result.FailedAllocationCount;
+                continue;
+            }
+            placements[event.AllocationId] = placement;
+            allocationBytes += event.Size;
+            result.PeakBlockBytes = std::max(result.PeakBlockBytes, blockBytes);
+            result.PeakAllocationBytes = std::max(result.PeakAllocationBytes, allocationBytes);
+        }
+        else if(event.Type == D3D12MA::TRACE_EVENT_TYPE_FREE && event.BlockId != UINT_MAX)
+        {
+            const auto it = placements.find(event.AllocationId);
+            if(it == placements.end())
+            {
+                ++result.UnknownFreeCount;
+                continue;
+            }
+            const Placement placement = it->second;
+            placements.erase(it);
+            allocationBytes -= placement.size;
+
+            const time_point beg = Now();
+            placement.block->FreeAllocation(placement.allocation);
+            if(placement.block->IsEmpty())
+            {
+                std::vector<D3D12MA::VirtualBlock*>& blocks = placement.pool->Blocks;
+                const size_t emptyBlockCount = std::count_if(blocks.begin(), blocks.end(),
+                    [](D3D12MA::VirtualBlock* block) { return block->IsEmpty() != FALSE; });
+                if(emptyBlockCount > 1)
+                {
+                    blocks.erase(std::find(blocks.begin(), blocks.end(), placement.block));
+                    placement.block->Release();
+                    blockBytes -= placement.pool->BlockSize;
+                }
+            }
+            result.TimeNs += ElapsedNs(beg, Now());
+            ++result.OperationCount;
+        }
+        else if(event.Type == D3D12MA::TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE)
+        {
+            // The allocation takes the place reserved by the temporary one, which is then freed at the old place.
+            const auto src = placements.find(event.AllocationId);
+            const auto tmp = placements.find(event.TemporaryAllocationId);
+            if(src != placements.end() && tmp != placements.end())
+                std::swap(src->second, tmp->second);
+        }
+    }
+
+    result.FinalBlockBytes = blockBytes;
+    result.FinalAllocationBytes = allocationBytes;
+    for(auto& placement : placements)
+        placement.second.block->FreeAllocation(placement.second.allocation);
+    for(auto& pool : pools)
+    {
+        for(D3D12MA::VirtualBlock* block : pool.second.Blocks)
+            block->Release();
+    }
+    return result;
+}
+
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+
+////////////////////////////////////////////////////////////////////////////////
+// Replay through the allocator on the mock device
+
+static D3D12MA::Allocator* CreateMockAllocator(MockDevice** outDevice, MockAdapter** outAdapter,
+    D3D12MA::ALLOCATOR_FLAGS flags, UINT traceEventCapacity)
+{
+    CHECK_HR( CreateMockDevice(NULL, outDevice, outAdapter) );
+    D3D12MA::ALLOCATOR_DESC allocatorDesc = {};
+    allocatorDesc.Flags = flags;
+    allocatorDesc.TraceEventCapacity = traceEventCapacity;
+    allocatorDesc.pDevice = *outDevice;
+    allocatorDesc.pAdapter = *outAdapter;
+    D3D12MA::Allocator* allocator = NULL;
+    CHECK_HR( D3D12MA::CreateAllocator(&allocatorDesc, &allocator) );
+    return allocator;
+}
+
+static D3D12_HEAP_TYPE GetMockHeapType(D3D12_HEAP_TYPE heapType)
+{
+    // Custom and GPU upload heaps are replayed in the default one.
+    return heapType == D3D12_HEAP_TYPE_UPLOAD || heapType == D3D12_HEAP_TYPE_READBACK ?
+        heapType : D3D12_HEAP_TYPE_DEFAULT;
+}
+
+/*
+Custom pools of the trace become custom pools with the same block size, other
+allocations go to default pools or are committed, as in the trace. Defragmentation
+moves are applied to the bookkeeping only.
+*/
+static ReplayResult ReplayMock(const std::vector<D3D12MA::TRACE_EVENT>& events)
+{
+    ReplayResult result;
+    result.Name = "Allocator (mock)";
+    MockDevice* device = NULL;
+    MockAdapter* adapter = NULL;
+    D3D12MA::Allocator* const allocator = CreateMockAllocator(&device, &adapter, D3D12MA::ALLOCATOR_FLAG_NONE, 0);
+
+    const std::map<UINT64, UINT64> blockSizes = GetBlockSizes(events);
+    std::map<UINT64, D3D12MA::Pool*> pools;
+    struct Placement
+    {
+        D3D12MA::Allocation* allocation;
+        UINT64 size;
+    };
+    std::unordered_map<UINT64, Placement> placements;
+    UINT64 allocationBytes = 0;
+
+    for(const D3D12MA::TRACE_EVENT& event : events)
+    {
+        if(event.Type == D3D12MA::TRACE_EVENT_TYPE_ALLOCATE)
+        {
+            ++result.AllocationCount;
+            D3D12MA::ALLOCATION_DESC allocDesc = {};
+            allocDesc.HeapType = GetMockHeapType(event.HeapType);
+            if(event.BlockId == UINT_MAX)
+                allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED;
+            else if(event.PoolId != 0)
+            {
+                D3D12MA::Pool*& pool = pools[PoolKey(event)];
+                if(pool == NULL)
+                {
+                    const auto it = blockSizes.find(PoolKey(event));
+                    D3D12MA::POOL_DESC poolDesc = {};
+                    poolDesc.HeapProperties.Type = allocDesc.HeapType;
+                    poolDesc.BlockSize = g_Config.BlockSize ? g_Config.BlockSize :
+                        it != blockSizes.end() ? it->second : DEFAULT_BLOCK_SIZE;
+                    CHECK_HR( allocator->CreatePool(&poolDesc, &pool) );
+                }
+                allocDesc.CustomPool = pool;
+            }
+
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { event.Size, event.Alignment };
+            Placement placement = { NULL, event.Size };
+            const time_point beg = Now();
+            const HRESULT hr = allocator->AllocateMemory(&allocDesc, &allocInfo, &placement.allocation);
+            result.TimeNs += ElapsedNs(beg, Now());
+            ++result.OperationCount;
+            if(FAILED(hr))
+            {
+                ++result.FailedAllocationCount;
+                continue;
+            }
+            placements[event.AllocationId] = placement;
+            allocationBytes += event.Size;
+
+            D3D12MA::Budget localBudget = {}, nonLocalBudget = {};
+            allocator->GetBudget(&localBudget, &nonLocalBudget);
+            result.PeakBlockBytes = std::max(result.PeakBlockBytes,
+                localBudget.Stats.BlockBytes + nonLocalBudget.Stats.BlockBytes);
+            result.PeakAllocationBytes = std::max(result.PeakAllocationBytes, allocationBytes);
+        }
+        else if(event.Type == D3D12MA::TRACE_EVENT_TYPE_FREE)
+        {
+            const auto it = placements.find(event.AllocationId);
+            if(it == placements.end())
+            {
+                ++result.UnknownFreeCount;
+                continue;
+            }
+            allocationBytes -= it->second.size;
+            const time_point beg = Now();
+            it->second.allocation->Release();
+            result.TimeNs += ElapsedNs(beg, Now());
+            ++result.OperationCount;
+            placements.erase(it);
+        }
+        else if(event.Type == D3D12MA::TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE)
+        {
+            const auto src = placements.find(event.AllocationId);
+            const auto tmp = placements.find(event.TemporaryAllocationId);
+            if(src != placements.end() && tmp != placements.end())
+                std::swap(src->second, tmp->second);
+        }
+    }
+
+    D3D12MA::TotalStatistics stats = {};
+    allocator->CalculateStatistics(&stats);
+    result.FinalBlockBytes = stats.Total.Stats.BlockBytes;
+    result.FinalAllocationBytes = allocationBytes;
+
+    for(auto& placement : placements)
+        placement.second.allocation->Release();
+    for(auto& pool : pools)
+        pool.second->Release();
+    allocator->Release();
+    device->Release();
+    adapter->Release();
+    return result;
+}
+
+static void WriteToFile(const void* pData, size_t byteCount, void* pPrivateData)
+{
+    fwrite(pData, 1, byteCount, (FILE*)pPrivateData);
+}
+
+/*
+Records a trace of a random workload on the mock device: resources of many sizes
+in default pools, some of them large enough to be committed, and a custom pool that
+gets fragmented and then defragmented. The trace is written in two parts to show
+that they can be appended to the same file.
+*/
+static void WriteSyntheticTrace(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    CHECK_BOOL( file != NULL );
+
+    MockDevice* device = NULL;
+    MockAdapter* adapter = NULL;
+    D3D12MA::Allocator* const allocator = CreateMockAllocator(&device, &adapter,
+        D3D12MA::ALLOCATOR_FLAG_TRACE_EVENTS, 1024 * 1024);
+    UINT64 nextSequenceNumber = 0;
+
+    std::mt19937 rand(0x1234);
+    std::vector<D3D12MA::Allocation*> allocs;
+    const D3D12_HEAP_TYPE heapTypes[] = { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_TYPE_UPLOAD };
+    for(UINT i = 0; i < 20000; ++i)
+    {
+        // Keep about 1000 allocations alive.
+        if(!allocs.empty() && rand() % 2000 < allocs.size())
+        {
+            const size_t index = rand() % allocs.size();
+            allocs[index]->Release();
+            allocs[index] = allocs.back();
+            allocs.pop_back();
+            continue;
+        }
+        D3D12MA::ALLOCATION_DESC allocDesc = {};
+        allocDesc.HeapType = heapTypes[rand() % 3];
+        // Mostly small buffers, sometimes textures up to 64 MB.
+        const UINT64 size = rand() % 50 ? 256ull << (rand() % 12) : 64ull * 1024 << (rand() % 11);
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { size, size < 64 * 1024 ? 256ull : 64ull * 1024 };
+        D3D12MA::Allocation* alloc = NULL;
+        CHECK_HR( allocator->AllocateMemory(&allocDesc, &allocInfo, &alloc) );
+        allocs.push_back(alloc);
+    }
+    allocator->WriteTraceEvents(&nextSequenceNumber, WriteToFile, file);
+
+    D3D12MA::POOL_DESC poolDesc = {};
+    poolDesc.HeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    poolDesc.HeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    poolDesc.BlockSize = 16ull * 1024 * 1024;
+    D3D12MA::Pool* pool = NULL;
+    CHECK_HR( allocator->CreatePool(&poolDesc, &pool) );
+    std::vector<D3D12MA::Allocation*> poolAllocs;
+    D3D12MA::ALLOCATION_DESC poolAllocDesc = {};
+    poolAllocDesc.CustomPool = pool;
+    for(UINT i = 0; i < 2000; ++i)
+    {
+        const UINT64 size = 4096ull << (rand() % 6);
+        const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = { size, 4096 };
+        D3D12MA::Allocation* alloc = NULL;
+        CHECK_HR( allocator->AllocateMemory(&poolAllocDesc, &allocInfo, &alloc) );
+        poolAllocs.push_back(alloc);
+    }
+    for(size_t i = 0; i < poolAllocs.size(); ++i)
+    {
+        if(rand() % 3 != 0)
+        {
+            poolAllocs[i]->Release();
+            poolAllocs[i] = NULL;
+        }
+    }
+    D3D12MA::DEFRAGMENTATION_DESC defragDesc = {};
+    defragDesc.Flags = D3D12MA::DEFRAGMENTATION_FLAG_ALGORITHM_FULL;
+    D3D12MA::DefragmentationContext* defragCtx = NULL;
+    CHECK_HR( pool->BeginDefragmentation(&defragDesc, &defragCtx) );
+    for(;;)
+    {
+        D3D12MA::DEFRAGMENTATION_PASS_MOVE_INFO passInfo = {};
+        if(defragCtx->BeginPass(&passInfo) == S_OK)
+            break;
+        if(defragCtx->EndPass(&passInfo) == S_OK)
+            break;
+    }
+    defragCtx->Release();
+    allocator->WriteTraceEvents(&nextSequenceNumber, WriteToFile, file);
+    fclose(file);
+
+    for(D3D12MA::Allocation* alloc : poolAllocs)
+    {
+        if(alloc)
+            alloc->Release();
+    }
+    for(D3D12MA::Allocation* alloc : allocs)
+        alloc->Release();
+    pool->Release();
+    allocator->Release();
+    device->Release();
+    adapter->Release();
+}
+
+#endif // #if D3D12MA_BENCHMARK_MOCK_DEVICE
+
+////////////////////////////////////////////////////////////////////////////////
+// Main
+
+static void PrintHelp()
+{
+    printf(
+        "Usage: D3D12MA_TraceReplay [options] <trace file>\n"
+        "  --block-size <bytes>    Size of virtual blocks. Default: size of blocks created in the trace.\n"
+        "  --format text|csv       Output format. Default: text.\n"
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+        "  --synthetic <path>      Record a trace of a random workload on the mock device to the file and replay it.\n"
+#endif
+        );
+}
+
+static bool ParseCommandLine(int argc, char** argv)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(arg, "--block-size") == 0 && hasValue)
+        {
+            g_Config.BlockSize = strtoull(argv[++i], NULL, 10);
+            if(g_Config.BlockSize == 0)
+                return false;
+        }
+        else if(strcmp(arg, "--format") == 0 && hasValue)
+        {
+            const char* const value = argv[++i];
+            if(strcmp(value, "text") == 0)
+                g_Config.Csv = false;
+            else if(strcmp(value, "csv") == 0)
+                g_Config.Csv = true;
+            else
+                return false;
+        }
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+        else if(strcmp(arg, "--synthetic") == 0 && hasValue)
+            g_Config.SyntheticPath = argv[++i];
+#endif
+        else if(arg[0] != '-' && g_Config.TracePath == NULL)
+            g_Config.TracePath = arg;
+        else
+            return false;
+    }
+    return (g_Config.TracePath != NULL) != (g_Config.SyntheticPath != NULL);
+}
+
+int main(int argc, char** argv)
+{
+    if(!ParseCommandLine(argc, argv))
+    {
+        PrintHelp();
+        return 1;
+    }
+
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+    if(g_Config.SyntheticPath != NULL)
+    {
+        WriteSyntheticTrace(g_Config.SyntheticPath);
+        g_Config.TracePath = g_Config.SyntheticPath;
+    }
+#endif
+
+    std::vector<unsigned char> data;
+    if(!LoadFile(g_Config.TracePath, data))
+    {
+        fprintf(stderr, "Cannot open trace file \"%s\".\n", g_Config.TracePath);
+        return 1;
+    }
+    std::vector<D3D12MA::TRACE_EVENT> events;
+    ParseTrace(data, events);
+    fprintf(stderr, "Replaying %zu events\n", events.size());
+
+    std::vector<ReplayResult> results;
+    for(const VirtualAlgorithm& algorithm : VIRTUAL_ALGORITHMS)
+        results.push_back(ReplayVirtual(events, algorithm));
+#if D3D12MA_BENCHMARK_MOCK_DEVICE
+    results.push_back(ReplayMock(events));
+#endif
+    PrintResults(results);
+    return 0;
+}
@@ -0,0 +1,431 @@
+#
+# Copyright (c) 2018-2026 Advanced Micro Devices, Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+import argparse
+import json
+import sys
+
+
+PROGRAM_VERSION = 'D3D12 Memory Allocator Binary Dump Converter 1.0.0'
+MAGIC = b'DMAB'
+DELTA_MAGIC = b'DMAD'
+TRACE_MAGIC = b'DMAT'
+SUPPORTED_VERSION = 3
+
+HEAP_TYPE_NAMES = ['DEFAULT', 'UPLOAD', 'READBACK', 'CUSTOM', 'GPU_UPLOAD']
+STANDARD_HEAP_TYPE_NAMES = ['DEFAULT', 'UPLOAD', 'READBACK', 'GPU_UPLOAD']
+HEAP_SUB_TYPE_NAMES = [' - Buffers', ' - Textures', ' - Textures RT/DS']
+RESOURCE_DIMENSION_NAMES = ['UNKNOWN', 'BUFFER', 'TEXTURE1D', 'TEXTURE2D', 'TEXTURE3D']
+ALGORITHM_NAMES = ['TLSF', 'Linear', 'Buddy', 'Slab']
+MEMORY_POOL_NAMES = ['MEMORY_POOL_UNKNOWN', 'MEMORY_POOL_L0', 'MEMORY_POOL_L1']
+CPU_PAGE_PROPERTY_NAMES = ['CPU_PAGE_PROPERTY_UNKNOWN', 'CPU_PAGE_PROPERTY_NOT_AVAILABLE',
+    'CPU_PAGE_PROPERTY_WRITE_COMBINE', 'CPU_PAGE_PROPERTY_WRITE_BACK']
+
+# D3D12_HEAP_FLAGS in the order they are written in JSON.
+HEAP_FLAGS = [
+    (0x1, 'HEAP_FLAG_SHARED'),
+    (0x8, 'HEAP_FLAG_ALLOW_DISPLAY'),
+    (0x20, 'HEAP_FLAG_CROSS_ADAPTER'),
+    (0x100, 'HEAP_FLAG_HARDWARE_PROTECTED'),
+    (0x200, 'HEAP_FLAG_ALLOW_WRITE_WATCH'),
+    (0x400, 'HEAP_FLAG_ALLOW_SHADER_ATOMICS'),
+    (0x800, 'HEAP_FLAG_CREATE_NOT_RESIDENT'),
+    (0x1000, 'HEAP_FLAG_CREATE_NOT_ZEROED'),
+    (0x4, 'HEAP_FLAG_DENY_BUFFERS'),
+    (0x40, 'HEAP_FLAG_DENY_RT_DS_TEXTURES'),
+    (0x80, 'HEAP_FLAG_DENY_NON_RT_DS_TEXTURES'),
+]
+DEVICE8_HEAP_FLAGS = 0x800 | 0x1000
+
+GENERAL_FLAG_TILE_BASED_RENDERER = 0x1
+GENERAL_FLAG_UMA = 0x2
+GENERAL_FLAG_CACHE_COHERENT_UMA = 0x4
+GENERAL_FLAG_GPU_UPLOAD_HEAP_SUPPORTED = 0x8
+GENERAL_FLAG_TIGHT_ALIGNMENT_SUPPORTED = 0x10
+GENERAL_FLAG_DETAILED_MAP = 0x20
+GENERAL_FLAG_DEVICE8_HEAP_FLAGS = 0x40
+
+ENTRY_TYPE_MASK = 0x07
+ENTRY_FLAG_OFFSET_DELTA = 0x08
+ENTRY_FLAG_CUSTOM_DATA = 0x10
+ENTRY_FLAG_NAME = 0x20
+ENTRY_FLAG_SAME_NAME = 0x40
+ENTRY_FLAG_LAYOUT = 0x80
+
+# Values of D3D12_HEAP_TYPE.
+HEAP_TYPE_VALUE_NAMES = {1: 'DEFAULT', 2: 'UPLOAD', 3: 'READBACK', 4: 'CUSTOM', 5: 'GPU_UPLOAD'}
+# Values of D3D12MA::SNAPSHOT_CHANGE_TYPE.
+CHANGE_TYPE_NAMES = ['BLOCK_CREATED', 'BLOCK_FREED', 'ALLOCATION_CREATED', 'ALLOCATION_FREED', 'ALLOCATION_MOVED']
+CHANGE_TYPE_ALLOCATION_CREATED = 2
+CHANGE_TYPE_ALLOCATION_MOVED = 4
+# Values of D3D12MA::TRACE_EVENT_TYPE.
+TRACE_EVENT_TYPE_NAMES = ['ALLOCATE', 'FREE', 'CREATE_BLOCK', 'DESTROY_BLOCK', 'DEFRAGMENTATION_MOVE', 'BUDGET_UPDATE']
+TRACE_EVENT_TYPE_ALLOCATE = 0
+TRACE_EVENT_TYPE_CREATE_BLOCK = 2
+TRACE_EVENT_TYPE_DESTROY_BLOCK = 3
+TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE = 4
+TRACE_EVENT_TYPE_BUDGET_UPDATE = 5
+
+
+def ParseArgs():
+    argParser = argparse.ArgumentParser(description='Conversion of D3D12 Memory Allocator binary dump to JSON.')
+    argParser.add_argument('DumpFile', help='Path to source binary file with memory dump created by D3D12MA::Allocator::WriteStatsBinary() '
+        'or changes between snapshots written by D3D12MA::Snapshot::WriteChanges()')
+    argParser.add_argument('-v', '--version', action='version', version=PROGRAM_VERSION)
+    argParser.add_argument('-o', '--output', required=True, help='Path to destination JSON file, compatible with GpuMemDumpVis.py')
+    return argParser.parse_args()
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def Byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError('Unexpected end of file.')
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def Number(self):
+        result = 0
+        shift = 0
+        while True:
+            b = self.Byte()
+            result |= (b & 0x7F) << shift
+            shift += 7
+            if b < 0x80:
+                return result
+
+    def SignedNumber(self):
+        num = self.Number()
+        return (num >> 1) ^ -(num & 1)
+
+    def String(self):
+        length = self.Number()
+        if length == 0:
+            return None
+        length -= 1
+        if self.pos + length > len(self.data):
+            raise ValueError('Unexpected end of file.')
+        s = self.data[self.pos:self.pos + length].decode('utf-8')
+        self.pos += length
+        return s
+
+def ReadDetailedStatistics(reader):
+    stats = {}
+    stats['BlockCount'] = reader.Number()
+    stats['BlockBytes'] = reader.Number()
+    stats['AllocationCount'] = reader.Number()
+    stats['AllocationBytes'] = reader.Number()
+    stats['UnusedRangeCount'] = reader.Number()
+    if stats['AllocationCount'] > 1:
+        stats['AllocationSizeMin'] = reader.Number()
+        stats['AllocationSizeMax'] = reader.Number()
+    if stats['UnusedRangeCount'] > 1:
+        stats['UnusedRangeSizeMin'] = reader.Number()
+        stats['UnusedRangeSizeMax'] = reader.Number()
+    return stats
+
+class EntryListReader:
+    """Reads consecutive entries of a block or a list of committed allocations."""
+    def __init__(self, reader):
+        self.reader = reader
+        self.nextOffset = 0
+        self.prevName = None
+
+    # Returns tuple (offset, entry object).
+    def Entry(self):
+        reader = self.reader
+        header = reader.Byte()
+        entryType = header & ENTRY_TYPE_MASK
+        offset = self.nextOffset
+        if header & ENTRY_FLAG_OFFSET_DELTA:
+            offset += reader.SignedNumber()
+        size = reader.Number()
+        self.nextOffset = offset + size
+        if entryType == 0:
+            return offset, {'Type': 'FREE', 'Size': size}
+        if entryType - 1 >= len(RESOURCE_DIMENSION_NAMES):
+            raise ValueError('Invalid entry type %d.' % entryType)
+        entry = {'Type': RESOURCE_DIMENSION_NAMES[entryType - 1], 'Size': size, 'Usage': reader.Number()}
+        if header & ENTRY_FLAG_CUSTOM_DATA:
+            entry['CustomData'] = '%X' % reader.Number()
+        if header & ENTRY_FLAG_NAME:
+            self.prevName = reader.String()
+            entry['Name'] = self.prevName
+        elif header & ENTRY_FLAG_SAME_NAME:
+            entry['Name'] = self.prevName
+        if header & ENTRY_FLAG_LAYOUT:
+            entry['Layout'] = reader.Number()
+        return offset, entry
+
+def ReadBlock(reader):
+    block = {}
+    block['TotalBytes'] = reader.Number()
+    block['UnusedBytes'] = reader.Number()
+    block['Allocations'] = reader.Number()
+    block['UnusedRanges'] = reader.Number()
+    entries = EntryListReader(reader)
+    suballocations = []
+    for i in range(block['Allocations'] + block['UnusedRanges']):
+        offset, entry = entries.Entry()
+        suballocation = {'Offset': offset}
+        suballocation.update(entry)
+        suballocations.append(suballocation)
+    block['Suballocations'] = suballocations
+    return block
+
+def GetHeapFlagNames(heapFlags, device8HeapFlags):
+    names = []
+    knownFlags = 0
+    for flag, name in HEAP_FLAGS:
+        if (flag & DEVICE8_HEAP_FLAGS) and not device8HeapFlags:
+            continue
+        knownFlags |= flag
+        if heapFlags & flag:
+            names.append(name)
+    if heapFlags & ~knownFlags:
+        names.append(heapFlags & ~knownFlags)
+    return names
+
+def ReadHeapInfo(reader, customHeap, device8HeapFlags):
+    heapInfo = {}
+    flags = GetHeapFlagNames(reader.Number(), device8HeapFlags)
+    if customHeap:
+        flags.append(MEMORY_POOL_NAMES[reader.Number()])
+        flags.append(CPU_PAGE_PROPERTY_NAMES[reader.Number()])
+    heapInfo['Flags'] = flags
+    heapInfo['PreferredBlockSize'] = reader.Number()
+    heapInfo['Algorithm'] = ALGORITHM_NAMES[reader.Number()]
+    if heapInfo['Algorithm'] == 'Slab':
+        heapInfo['SlotSize'] = reader.Number()
+    blocks = {}
+    for i in range(reader.Number()):
+        blockId = reader.Number()
+        blocks[str(blockId)] = ReadBlock(reader)
+    heapInfo['Blocks'] = blocks
+    entries = EntryListReader(reader)
+    heapInfo['DedicatedAllocations'] = [entries.Entry()[1] for i in range(reader.Number())]
+    return heapInfo
+
+def ConvertDelta(data):
+    reader = Reader(data)
+    reader.pos = len(DELTA_MAGIC)
+    version = reader.Number()
+    if version != SUPPORTED_VERSION:
+        raise ValueError('Unsupported binary dump version %d.' % version)
+
+    changes = []
+    while True:
+        changeType = reader.Number()
+        # 0 terminates the list.
+        if changeType == 0:
+            break
+        changeType -= 1
+        if changeType >= len(CHANGE_TYPE_NAMES):
+            raise ValueError('Unknown change type %d.' % changeType)
+        change = {'Type': CHANGE_TYPE_NAMES[changeType]}
+        heapType = reader.Number()
+        change['HeapType'] = HEAP_TYPE_VALUE_NAMES.get(heapType, str(heapType))
+        change['PoolId'] = reader.Number()
+        # Block ID is stored + 1, with 0 meaning a committed allocation.
+        blockId = reader.Number()
+        if blockId != 0:
+            change['BlockId'] = blockId - 1
+        change['Size'] = reader.Number()
+        if changeType >= CHANGE_TYPE_ALLOCATION_CREATED:
+            change['AllocationId'] = reader.Number()
+            change['Offset'] = reader.Number()
+            if changeType == CHANGE_TYPE_ALLOCATION_MOVED:
+                prevBlockId = reader.Number()
+                if prevBlockId != 0:
+                    change['PreviousBlockId'] = prevBlockId - 1
+                change['PreviousOffset'] = reader.Number()
+        changes.append(change)
+
+    if reader.pos != len(data):
+        raise ValueError('Unexpected data at the end of file.')
+    return {'Changes': changes}
+
+def ConvertTrace(data):
+    reader = Reader(data)
+    events = []
+    # Traces written one after another are merged.
+    while reader.pos < len(data):
+        if data[reader.pos:reader.pos + len(TRACE_MAGIC)] != TRACE_MAGIC:
+            raise ValueError('Not a D3D12 Memory Allocator trace.')
+        reader.pos += len(TRACE_MAGIC)
+        version = reader.Number()
+        if version != SUPPORTED_VERSION:
+            raise ValueError('Unsupported binary dump version %d.' % version)
+        sequenceNumber = 0
+        timestamp = 0
+        while True:
+            eventType = reader.Number()
+            # 0 terminates the list.
+            if eventType == 0:
+                break
+            eventType -= 1
+            if eventType >= len(TRACE_EVENT_TYPE_NAMES):
+                raise ValueError('Unknown event type %d.' % eventType)
+            sequenceNumber += reader.Number()
+            timestamp += reader.SignedNumber()
+            event = {'Type': TRACE_EVENT_TYPE_NAMES[eventType], 'SequenceNumber': sequenceNumber,
+                'Timestamp': timestamp, 'ThreadId': reader.Number()}
+            if eventType == TRACE_EVENT_TYPE_BUDGET_UPDATE:
+                event['MemorySegmentGroup'] = reader.Number()
+                event['UsageBytes'] = reader.Number()
+                event['BudgetBytes'] = reader.Number()
+                events.append(event)
+                continue
+            heapType = reader.Number()
+            event['HeapType'] = HEAP_TYPE_VALUE_NAMES.get(heapType, str(heapType))
+            event['PoolId'] = reader.Number()
+            if eventType in (TRACE_EVENT_TYPE_CREATE_BLOCK, TRACE_EVENT_TYPE_DESTROY_BLOCK):
+                event['BlockId'] = reader.Number()
+                event['Size'] = reader.Number()
+                events.append(event)
+                continue
+            # Block ID is stored + 1, with 0 meaning a committed allocation.
+            blockId = reader.Number()
+            if blockId != 0:
+                event['BlockId'] = blockId - 1
+            event['AllocationId'] = reader.Number()
+            event['Offset'] = reader.Number()
+            event['Size'] = reader.Number()
+            if eventType == TRACE_EVENT_TYPE_ALLOCATE:
+                event['Alignment'] = reader.Number()
+            elif eventType == TRACE_EVENT_TYPE_DEFRAGMENTATION_MOVE:
+                event['TemporaryAllocationId'] = reader.Number()
+            events.append(event)
+    return {'Events': events}
+
+def Convert(data):
+    if data[:len(DELTA_MAGIC)] == DELTA_MAGIC:
+        return ConvertDelta(data)
+    if data[:len(TRACE_MAGIC)] == TRACE_MAGIC:
+        return ConvertTrace(data)
+    reader = Reader(data)
+    if data[:len(MAGIC)] != MAGIC:
+        raise ValueError('Not a D3D12 Memory Allocator binary dump.')
+    reader.pos = len(MAGIC)
+    version = reader.Number()
+    if version != SUPPORTED_VERSION:
+        raise ValueError('Unsupported binary dump version %d.' % version)
+
+    general = {'API': 'Direct3D 12'}
+    general['GPU'] = reader.String()
+    general['DedicatedVideoMemory'] = reader.Number()
+    general['DedicatedSystemMemory'] = reader.Number()
+    general['SharedSystemMemory'] = reader.Number()
+    general['ResourceHeapTier'] = reader.Number()
+    general['ResourceBindingTier'] = reader.Number()
+    general['TiledResourcesTier'] = reader.Number()
+    flags = reader.Number()
+    general['TileBasedRenderer'] = (flags & GENERAL_FLAG_TILE_BASED_RENDERER) != 0
+    general['UMA'] = (flags & GENERAL_FLAG_UMA) != 0
+    general['CacheCoherentUMA'] = (flags & GENERAL_FLAG_CACHE_COHERENT_UMA) != 0
+    general['GPUUploadHeapSupported'] = (flags & GENERAL_FLAG_GPU_UPLOAD_HEAP_SUPPORTED) != 0
+    general['TightAlignmentSupported'] = (flags & GENERAL_FLAG_TIGHT_ALIGNMENT_SUPPORTED) != 0
+    uma = general['UMA']
+    gpuUploadHeapSupported = general['GPUUploadHeapSupported']
+
+    localBudget = {'BudgetBytes': reader.Number(), 'UsageBytes': reader.Number()}
+    nonLocalBudget = {'BudgetBytes': reader.Number(), 'UsageBytes': reader.Number()}
+
+    total = ReadDetailedStatistics(reader)
+    heapTypeStats = [ReadDetailedStatistics(reader) for i in range(len(HEAP_TYPE_NAMES))]
+    segmentGroupStats = [ReadDetailedStatistics(reader) for i in range(2)]
+    customHeapStats = [ReadDetailedStatistics(reader) for i in range(2)]
+
+    # Same layout as written by D3D12MA::Allocator::BuildStatsString().
+    l0Pools = {}
+    if uma:
+        l0Pools['DEFAULT'] = {'Stats': heapTypeStats[0]}
+        if gpuUploadHeapSupported:
+            l0Pools['GPU_UPLOAD'] = {'Stats': heapTypeStats[4]}
+    l0Pools['UPLOAD'] = {'Stats': heapTypeStats[1]}
+    l0Pools['READBACK'] = {'Stats': heapTypeStats[2]}
+    l0Pools['CUSTOM'] = {'Stats': customHeapStats[0 if uma else 1]}
+    memoryInfo = {'L0': {
+        'Budget': localBudget if uma else nonLocalBudget,
+        'Stats': segmentGroupStats[0 if uma else 1],
+        'MemoryPools': l0Pools}}
+    if not uma:
+        l1Pools = {'DEFAULT': {'Stats': heapTypeStats[0]}}
+        if gpuUploadHeapSupported:
+            l1Pools['GPU_UPLOAD'] = {'Stats': heapTypeStats[4]}
+        l1Pools['CUSTOM'] = {'Stats': customHeapStats[0]}
+        memoryInfo['L1'] = {
+            'Budget': localBudget,
+            'Stats': segmentGroupStats[0],
+            'MemoryPools': l1Pools}
+
+    result = {'General': general, 'Total': total, 'MemoryInfo': memoryInfo}
+
+    if flags & GENERAL_FLAG_DETAILED_MAP:
+        device8HeapFlags = (flags & GENERAL_FLAG_DEVICE8_HEAP_FLAGS) != 0
+        defaultPools = {}
+        if general['ResourceHeapTier'] >= 2:
+            for name in STANDARD_HEAP_TYPE_NAMES:
+                defaultPools[name] = ReadHeapInfo(reader, False, device8HeapFlags)
+        else:
+            for name in STANDARD_HEAP_TYPE_NAMES:
+                for subTypeIndex, subTypeName in enumerate(HEAP_SUB_TYPE_NAMES):
+                    heapInfo = ReadHeapInfo(reader, False, device8HeapFlags)
+                    # Committed allocations are written only with the first sub-type, but listed in all of them.
+                    if subTypeIndex == 0:
+                        dedicatedAllocations = heapInfo['DedicatedAllocations']
+                    else:
+                        heapInfo['DedicatedAllocations'] = list(dedicatedAllocations)
+                    defaultPools[name + subTypeName] = heapInfo
+        result['DefaultPools'] = defaultPools
+
+        customPools = {}
+        for heapTypeIndex, heapTypeName in enumerate(HEAP_TYPE_NAMES):
+            pools = []
+            for index in range(reader.Number()):
+                poolName = reader.String()
+                pool = {'Name': str(index) if poolName is None else '%d - %s' % (index, poolName)}
+                pool.update(ReadHeapInfo(reader, heapTypeIndex == 3, device8HeapFlags))
+                pools.append(pool)
+            if pools:
+                customPools[heapTypeName] = pools
+        result['CustomPools'] = customPools
+
+    if reader.pos != len(data):
+        raise ValueError('Unexpected data at the end of file.')
+    return result
+
+
+if __name__ == '__main__':
+    args = ParseArgs()
+    with open(args.DumpFile, 'rb') as file:
+        data = file.read()
+    try:
+        result = Convert(data)
+    except ValueError as e:
+        print('Error: %s' % e, file=sys.stderr)
+        sys.exit(1)
+    with open(args.output, 'w', encoding='utf-8') as file:
+        json.dump(result, file, indent=2, ensure_ascii=False)